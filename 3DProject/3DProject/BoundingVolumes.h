@@ -0,0 +1,87 @@
+#ifndef BOUNDING_VOLUMES_H
+#define BOUNDING_VOLUMES_H
+
+#include <D3DX10.h>
+#include <cfloat>
+#include <cmath>
+
+struct AABB
+{
+	D3DXVECTOR3			Min;
+	D3DXVECTOR3			Max;
+
+	AABB()
+		: Min(FLT_MAX, FLT_MAX, FLT_MAX), Max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+	AABB(const D3DXVECTOR3& min, const D3DXVECTOR3& max)
+		: Min(min), Max(max) {}
+
+	bool IsEmpty() const
+	{
+		return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z;
+	}
+
+	void Expand(const D3DXVECTOR3& point)
+	{
+		D3DXVec3Minimize(&Min, &Min, &point);
+		D3DXVec3Maximize(&Max, &Max, &point);
+	}
+
+	void Expand(const AABB& box)
+	{
+		D3DXVec3Minimize(&Min, &Min, &box.Min);
+		D3DXVec3Maximize(&Max, &Max, &box.Max);
+	}
+
+	D3DXVECTOR3 GetCenter() const
+	{
+		return (Min + Max) * 0.5f;
+	}
+
+	D3DXVECTOR3 GetExtents() const
+	{
+		return (Max - Min) * 0.5f;
+	}
+
+	float GetSurfaceArea() const
+	{
+		D3DXVECTOR3 size = Max - Min;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// Bounding box of this box transformed by the matrix (Arvo's method)
+	AABB Transform(const D3DXMATRIX& matrix) const
+	{
+		AABB result(D3DXVECTOR3(matrix._41, matrix._42, matrix._43), D3DXVECTOR3(matrix._41, matrix._42, matrix._43));
+		for(int col = 0; col < 3; ++col)
+		{
+			for(int row = 0; row < 3; ++row)
+			{
+				float a = matrix.m[row][col] * Min[row];
+				float b = matrix.m[row][col] * Max[row];
+				result.Min[col] += a < b ? a : b;
+				result.Max[col] += a < b ? b : a;
+			}
+		}
+
+		return result;
+	}
+};
+
+struct BoundingSphere
+{
+	D3DXVECTOR3			Center;
+	float				Radius;
+
+	BoundingSphere()
+		: Center(0.0f, 0.0f, 0.0f), Radius(0.0f) {}
+	BoundingSphere(const D3DXVECTOR3& center, float radius)
+		: Center(center), Radius(radius) {}
+
+	// Sphere around the box, not the tightest possible but cheap and good enough for culling
+	static BoundingSphere FromAABB(const AABB& box)
+	{
+		D3DXVECTOR3 extents = box.GetExtents();
+		return BoundingSphere(box.GetCenter(), D3DXVec3Length(&extents));
+	}
+};
+#endif
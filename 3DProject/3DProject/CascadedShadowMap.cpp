@@ -0,0 +1,397 @@
+#include "CascadedShadowMap.h"
+#include <cmath>
+
+const float CascadedShadowMap::C_SPLIT_LAMBDA = 0.75f;		// 0 is even splits, 1 is logarithmic
+const float CascadedShadowMap::C_RADIUS_STEP = 1.0f / 16.0f;	// Radii are rounded up to this
+
+namespace
+{
+	// Indexed by ShadowFilter
+	const char* C_FILTER_TECHNIQUES[] = { "DrawTechnique", "DrawPCF3x3Technique", "DrawPCF5x5Technique", "DrawPoissonTechnique",
+										  "DrawVSMTechnique", "DrawEVSMTechnique" };
+	const char* C_FILTER_NAMES[] = { "2x2", "3x3", "5x5", "Poisson", "VSM", "EVSM" };
+	const int C_FILTER_TAPS[] = { 1, 4, 9, 12, 1, 1 };
+}
+
+CascadedShadowMap::CascadedShadowMap()
+	: mDevice(NULL), mPool(NULL), mTexture(NULL), mMomentTexture(NULL), mScreenMask(NULL), mSize(0), mCascadeCount(0), mFilter(ShadowFilter3x3), mSplitDistances(0.0f, 0.0f, 0.0f, 0.0f),
+	  mCameraViewZ(0.0f, 0.0f, 1.0f, 0.0f), mStaticTexture(NULL), mStaticRenderCount(0)
+{
+	for(int i = 0; i < C_MAX_CASCADES; ++i)
+	{
+		mStaticVersion[i] = 0;
+		mStaticValid[i] = false;
+		D3DXMatrixIdentity(&mViewProjection[i]);
+		D3DXMatrixIdentity(&mStaticViewProjection[i]);
+	}
+
+	ZeroMemory(&mViewport, sizeof(RenderViewport));
+	mViewport.MaxDepth = 1.0f;
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+	ReleaseTextures();
+}
+
+void CascadedShadowMap::Initialize(RenderDevice* device, RenderTargetPool* pool, int size, int numCascades)
+{
+	mDevice = device;
+	mPool = pool;
+	Resize(size, numCascades);
+}
+
+// Change the size of every cascade or the number of cascades. The old arrays go back to the pool,
+// where they wait a while in case the size is changed back.
+void CascadedShadowMap::Resize(int size, int numCascades)
+{
+	if(numCascades < 1)
+		numCascades = 1;
+	else if(numCascades > C_MAX_CASCADES)
+		numCascades = C_MAX_CASCADES;
+
+	if(size == mSize && numCascades == mCascadeCount && mStaticTexture != NULL)
+		return;
+
+	mSize = size;
+	mCascadeCount = numCascades;
+	mViewport.Width = size;
+	mViewport.Height = size;
+
+	ReleaseTextures();
+	mStaticTexture = mPool->Acquire(GetDepthArrayDesc());
+
+	for(int i = 0; i < C_MAX_CASCADES; ++i)
+		mStaticValid[i] = false;
+}
+
+// Split the camera's view up to the shadow distance and fit a cascade to each slice
+void CascadedShadowMap::Update(const Camera& camera, const Light& light, float shadowDistance)
+{
+	const Frustrum& frustrum = camera.GetFrustrum();
+	float nearDistance = frustrum.nearDistance;
+	float farDistance = frustrum.farDistance < shadowDistance ? frustrum.farDistance : shadowDistance;
+
+	// The camera looks down the third column of its view matrix
+	const D3DXMATRIX& view = camera.GetViewMatrix();
+	D3DXVECTOR3 forward(view._13, view._23, view._33);
+	mCameraViewZ = D3DXVECTOR4(view._13, view._23, view._33, view._43);
+
+	// Squared distance from the view axis to a corner of the frustum, at depth 1
+	float tanY = std::tan(frustrum.fovY * 0.5f);
+	float tanX = tanY * frustrum.aspectRatio;
+	float cornerSq = tanX * tanX + tanY * tanY;
+
+	const D3DXMATRIX& lightView = light.GetViewMatrix();
+	float sliceNear = nearDistance;
+	for(int i = 0; i < mCascadeCount; ++i)
+	{
+		float fraction = (float)(i + 1) / mCascadeCount;
+		float logSplit = nearDistance * std::pow(farDistance / nearDistance, fraction);
+		float evenSplit = nearDistance + (farDistance - nearDistance) * fraction;
+		float sliceFar = C_SPLIT_LAMBDA * logSplit + (1.0f - C_SPLIT_LAMBDA) * evenSplit;
+
+		// The sphere through the near and the far corners has its center on the view axis. For a
+		// deep slice that point lies beyond the far plane, then the far corners alone decide it.
+		float center = (sliceNear + sliceFar) * (1.0f + cornerSq) * 0.5f;
+		if(center > sliceFar)
+			center = sliceFar;
+		float toFar = sliceFar - center;
+		float radius = std::sqrt(toFar * toFar + sliceFar * sliceFar * cornerSq);
+		radius = std::ceil(radius / C_RADIUS_STEP) * C_RADIUS_STEP;
+
+		// Move the center in whole texels of the light's view, so the texels stay where they are. The
+		// depth is snapped as well, so the matrix only changes when the cascade has moved a texel and
+		// the static casters can be kept until then. The depth range grows by a texel to make up for it.
+		D3DXVECTOR3 centerW = camera.GetPos() + forward * center;
+		D3DXVECTOR3 centerL;
+		D3DXVec3TransformCoord(&centerL, &centerW, &lightView);
+		float texelSize = 2.0f * radius / mSize;
+		centerL.x = std::floor(centerL.x / texelSize) * texelSize;
+		centerL.y = std::floor(centerL.y / texelSize) * texelSize;
+		centerL.z = std::floor(centerL.z / texelSize) * texelSize;
+		float depthRadius = radius + texelSize;
+
+		D3DXMATRIX projection;
+		D3DXMatrixOrthoOffCenterLH(&projection, centerL.x - radius, centerL.x + radius, centerL.y - radius,
+								   centerL.y + radius, centerL.z - depthRadius, centerL.z + depthRadius);
+		mViewProjection[i] = lightView * projection;
+		mFrustumPlanes[i].Extract(mViewProjection[i]);
+
+		mSplitDistances[i] = sliceFar;
+		sliceNear = sliceFar;
+	}
+
+	// Unused cascades get the last distance, so the shaders can count the splits a position is beyond
+	for(int i = mCascadeCount; i < C_MAX_CASCADES; ++i)
+		mSplitDistances[i] = sliceNear;
+}
+
+// Take this frame's shadow map from the pool, before any cascade is drawn
+void CascadedShadowMap::BeginFrame()
+{
+	if(mTexture == NULL)
+		mTexture = mPool->Acquire(GetDepthArrayDesc());
+	if(mMomentTexture == NULL && UsesMoments())
+		mMomentTexture = mPool->Acquire(GetMomentArrayDesc());
+}
+
+// Give the shadow map back once nothing more is drawn with it this frame
+void CascadedShadowMap::EndFrame()
+{
+	mPool->Release(mTexture);
+	mPool->Release(mMomentTexture);
+	mTexture = NULL;
+	mMomentTexture = NULL;
+	mScreenMask = NULL;
+}
+
+// The filter is chosen by the receivers' technique, so changing it costs nothing
+void CascadedShadowMap::SetFilter(ShadowFilter filter)
+{
+	mFilter = filter;
+}
+
+// Set by the ShadowMask that filtered this frame's cascades, receivers drawn after it read the mask
+void CascadedShadowMap::SetScreenMask(RenderShaderView screenMask)
+{
+	mScreenMask = screenMask;
+}
+
+// If the cascade's static slice is out of date, set it as the depth target, clear it and return true.
+// The static casters must then be drawn with the cascade's matrix.
+bool CascadedShadowMap::BeginStaticCascade(int cascade, unsigned int staticVersion)
+{
+	if(mStaticTexture == NULL || (mStaticValid[cascade] && mStaticVersion[cascade] == staticVersion &&
+	   mStaticViewProjection[cascade] == mViewProjection[cascade]))
+		return false;
+
+	RenderDepthView dsv = mStaticTexture->DSV[cascade];
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, dsv);
+
+	mDevice->SetViewport(mViewport);
+	mDevice->ClearDepthStencil(dsv);
+
+	mStaticViewProjection[cascade] = mViewProjection[cascade];
+	mStaticVersion[cascade] = staticVersion;
+	mStaticValid[cascade] = true;
+	++mStaticRenderCount;
+	return true;
+}
+
+// Start this frame's shadow map from the static casters. Depth textures can only be copied whole,
+// so all cascades are copied at once.
+void CascadedShadowMap::CopyStaticCascades()
+{
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, NULL);
+
+	if(mTexture != NULL && mStaticTexture != NULL)
+		mDevice->CopyTexture(mTexture->Texture, mStaticTexture->Texture);
+}
+
+// Set one cascade as the depth target for the moving casters, on top of the static ones
+void CascadedShadowMap::BeginCascade(int cascade)
+{
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, mTexture != NULL ? mTexture->DSV[cascade] : NULL);
+
+	mDevice->SetViewport(mViewport);
+}
+
+int CascadedShadowMap::GetSize() const
+{
+	return mSize;
+}
+
+int CascadedShadowMap::GetCascadeCount() const
+{
+	return mCascadeCount;
+}
+
+// Distance from the camera where the cascade ends
+float CascadedShadowMap::GetSplitDistance(int cascade) const
+{
+	return mSplitDistances[cascade];
+}
+
+const D3DXMATRIX& CascadedShadowMap::GetViewProjectionMatrix(int cascade) const
+{
+	return mViewProjection[cascade];
+}
+
+const FrustumPlanes& CascadedShadowMap::GetFrustumPlanes(int cascade) const
+{
+	return mFrustumPlanes[cascade];
+}
+
+const D3DXVECTOR4& CascadedShadowMap::GetSplitDistances() const
+{
+	return mSplitDistances;
+}
+
+// Dot product with a world position and 1 gives the camera's view space z
+const D3DXVECTOR4& CascadedShadowMap::GetCameraViewZ() const
+{
+	return mCameraViewZ;
+}
+
+// NULL outside of BeginFrame and EndFrame
+RenderShaderView CascadedShadowMap::GetSRV() const
+{
+	return mTexture != NULL ? mTexture->SRV : NULL;
+}
+
+// Bytes used by the depth textures, the static copy included
+int CascadedShadowMap::GetMemorySize() const
+{
+	return 2 * mSize * mSize * mCascadeCount * (int)sizeof(float);
+}
+
+// Times a static slice has been drawn since the start
+int CascadedShadowMap::GetStaticRenderCount() const
+{
+	return mStaticRenderCount;
+}
+
+ShadowFilter CascadedShadowMap::GetFilter() const
+{
+	return mFilter;
+}
+
+bool CascadedShadowMap::UsesMoments() const
+{
+	return mFilter == ShadowFilterVSM || mFilter == ShadowFilterEVSM;
+}
+
+int CascadedShadowMap::GetMomentSize() const
+{
+	return mSize > 1 ? mSize / 2 : 1;
+}
+
+// NULL outside of BeginFrame and EndFrame, or when the filter does not use moments
+PooledTexture* CascadedShadowMap::GetMomentTexture() const
+{
+	return mMomentTexture;
+}
+
+RenderShaderView CascadedShadowMap::GetMomentSRV() const
+{
+	return mMomentTexture != NULL ? mMomentTexture->SRV : NULL;
+}
+
+RenderShaderView CascadedShadowMap::GetScreenMask() const
+{
+	return mScreenMask;
+}
+
+// A depth texture array with a slice per cascade, read as a whole by the shaders
+RenderTargetDesc CascadedShadowMap::GetDepthArrayDesc() const
+{
+	return RenderTargetDesc(mSize, mSize, mCascadeCount, RenderFormatR32Typeless,
+							RenderBindDepthStencil | RenderBindShaderResource);
+}
+
+// Two moments per texel, with a full mip chain
+RenderTargetDesc CascadedShadowMap::GetMomentArrayDesc() const
+{
+	return RenderTargetDesc(GetMomentSize(), GetMomentSize(), mCascadeCount, RenderFormatR32G32Float,
+							RenderBindRenderTarget | RenderBindShaderResource, 0);
+}
+
+void CascadedShadowMap::ReleaseTextures()
+{
+	if(mPool == NULL)
+		return;
+
+	mPool->Release(mTexture);
+	mPool->Release(mMomentTexture);
+	mPool->Release(mStaticTexture);
+	mTexture = NULL;
+	mMomentTexture = NULL;
+	mStaticTexture = NULL;
+}
+
+ShadowEffectVariables::ShadowEffectVariables()
+	: mDevice(NULL), mMaskTechnique(NULL), mfxCascadeViewProj(NULL), mfxCascadeSplits(NULL), mfxCameraViewZ(NULL),
+	  mfxCascadeCount(NULL), mfxSMWidth(NULL), mfxSMWidthInv(NULL), mfxShadowMap(NULL), mfxMomentMap(NULL),
+	  mfxShadowMask(NULL)
+{
+	for(int i = 0; i < ShadowFilterCount; ++i)
+		mTechniques[i] = NULL;
+}
+
+void ShadowEffectVariables::Initialize(RenderDevice* device, RenderEffect effect)
+{
+	mDevice = device;
+	mfxCascadeViewProj = mDevice->GetVariable(effect, "gCascadeViewProj");
+	mfxCascadeSplits = mDevice->GetVariable(effect, "gCascadeSplits");
+	mfxCameraViewZ = mDevice->GetVariable(effect, "gCameraViewZ");
+	mfxCascadeCount = mDevice->GetVariable(effect, "gCascadeCount");
+	mfxSMWidth = mDevice->GetVariable(effect, "gSMWidth");
+	mfxSMWidthInv = mDevice->GetVariable(effect, "gSMWidthInv");
+	mfxShadowMap = mDevice->GetVariable(effect, "gShadowMap");
+	mfxMomentMap = mDevice->GetVariable(effect, "gMomentMap");
+	mfxShadowMask = mDevice->GetVariable(effect, "gShadowMask");
+
+	for(int i = 0; i < ShadowFilterCount; ++i)
+		mTechniques[i] = mDevice->GetTechnique(effect, C_FILTER_TECHNIQUES[i]);
+	mMaskTechnique = mDevice->GetTechnique(effect, "DrawShadowMaskTechnique");
+}
+
+// Set the cascades for the next draw, without a shadow map nothing is in shadow
+void ShadowEffectVariables::Set(const CascadedShadowMap* shadowMap)
+{
+	if(shadowMap == NULL)
+	{
+		mDevice->SetInt(mfxCascadeCount, 0);
+		mDevice->SetShaderView(mfxShadowMap, NULL);
+		mDevice->SetShaderView(mfxMomentMap, NULL);
+		mDevice->SetShaderView(mfxShadowMask, NULL);
+		return;
+	}
+
+	int numCascades = shadowMap->GetCascadeCount();
+	for(int i = 0; i < numCascades; ++i)
+		mDevice->SetMatrixArray(mfxCascadeViewProj, (const float*)&shadowMap->GetViewProjectionMatrix(i), i, 1);
+	mDevice->SetFloatVector(mfxCascadeSplits, (const float*)&shadowMap->GetSplitDistances());
+	mDevice->SetFloatVector(mfxCameraViewZ, (const float*)&shadowMap->GetCameraViewZ());
+	mDevice->SetInt(mfxCascadeCount, numCascades);
+	mDevice->SetFloat(mfxSMWidth, (float)shadowMap->GetSize());
+	mDevice->SetFloat(mfxSMWidthInv, 1.0f / shadowMap->GetSize());
+	mDevice->SetShaderView(mfxShadowMap, shadowMap->GetSRV());
+	mDevice->SetShaderView(mfxMomentMap, shadowMap->GetMomentSRV());
+	mDevice->SetShaderView(mfxShadowMask, shadowMap->GetScreenMask());
+}
+
+// Unbind the shadow map, so it can be drawn to again
+void ShadowEffectVariables::Clear()
+{
+	mDevice->SetShaderView(mfxShadowMap, NULL);
+	mDevice->SetShaderView(mfxMomentMap, NULL);
+	mDevice->SetShaderView(mfxShadowMask, NULL);
+}
+
+// The technique that filters with the shadow map's filter, or reads its screen mask when it has one.
+// Without a shadow map the cheapest one.
+RenderTechnique ShadowEffectVariables::GetTechnique(const CascadedShadowMap* shadowMap) const
+{
+	if(shadowMap == NULL)
+		return mTechniques[ShadowFilter2x2];
+	if(shadowMap->GetScreenMask() != NULL)
+		return mMaskTechnique;
+
+	return mTechniques[shadowMap->GetFilter()];
+}
+
+const char* ShadowEffectVariables::GetFilterName(ShadowFilter filter)
+{
+	return C_FILTER_NAMES[filter];
+}
+
+// Comparison samples per shaded pixel, each of them reads 2x2 texels
+int ShadowEffectVariables::GetFilterTaps(ShadowFilter filter)
+{
+	return C_FILTER_TAPS[filter];
+}
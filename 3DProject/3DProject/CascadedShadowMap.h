@@ -0,0 +1,141 @@
+#ifndef CASCADED_SHADOW_MAP_H
+#define CASCADED_SHADOW_MAP_H
+
+#include <D3DX10.h>
+#include "Globals.h"
+#include "RenderDevice.h"
+#include "Camera.h"
+#include "Light.h"
+#include "FrustumPlanes.h"
+#include "RenderTargetPool.h"
+
+// How receivers filter the shadow map, in the order of the techniques of Ground.fx and Effect.fx
+enum ShadowFilter
+{
+	ShadowFilter2x2,				// 1 tap
+	ShadowFilter3x3,				// 4 taps
+	ShadowFilter5x5,				// 9 taps
+	ShadowFilterPoisson,			// 12 taps
+	ShadowFilterVSM,				// 1 tap of the blurred moments
+	ShadowFilterEVSM,				// 1 tap of the blurred exponential moments
+	ShadowFilterCount
+};
+
+// Shadow maps for slices of the camera's view, all of the same size in one texture array.
+//
+// The slices are split between the camera's near distance and the shadow distance with the practical
+// split scheme, a blend of logarithmic and even splits. Every cascade covers the bounding sphere of
+// its slice, which only depends on the distances and the field of view, so the projection does not
+// change size when the camera turns. The sphere's center is snapped to whole texels in the light's
+// view, which keeps the shadow edges from crawling when the camera moves.
+//
+// Casters that never move are drawn into a second array that is kept between frames. A slice of it
+// is only drawn again when its cascade's matrix, the static casters or the size changed, which for
+// a still camera is never. Every frame the static array is copied into the shadow map before the
+// moving casters are drawn on top.
+//
+// Both arrays come from a render target pool. The static array is held until the size changes, the
+// shadow map itself only from BeginFrame until the frame's last draw that reads it has ended. So is
+// the moment array of the VSM and EVSM filters, half the size with a mip chain, which is filled
+// by a ShadowMomentFilter.
+//
+// When a ShadowMask has filtered the cascades in screen space, its mask is set for the rest of the
+// frame and the receivers read it instead of filtering the cascades themselves.
+class CascadedShadowMap
+{
+public:
+	CascadedShadowMap();
+	~CascadedShadowMap();
+	void Initialize(RenderDevice* device, RenderTargetPool* pool, int size, int numCascades);
+	void Resize(int size, int numCascades);
+	void Update(const Camera& camera, const Light& light, float shadowDistance);
+	void BeginFrame();
+	void EndFrame();
+	void SetFilter(ShadowFilter filter);
+	void SetScreenMask(RenderShaderView screenMask);
+	bool BeginStaticCascade(int cascade, unsigned int staticVersion);
+	void CopyStaticCascades();
+	void BeginCascade(int cascade);
+
+	int GetSize() const;
+	int GetCascadeCount() const;
+	float GetSplitDistance(int cascade) const;
+	const D3DXMATRIX& GetViewProjectionMatrix(int cascade) const;
+	const FrustumPlanes& GetFrustumPlanes(int cascade) const;
+	const D3DXVECTOR4& GetSplitDistances() const;
+	const D3DXVECTOR4& GetCameraViewZ() const;
+	RenderShaderView GetSRV() const;
+	int GetMemorySize() const;
+	int GetStaticRenderCount() const;
+	ShadowFilter GetFilter() const;
+	bool UsesMoments() const;
+	int GetMomentSize() const;
+	PooledTexture* GetMomentTexture() const;
+	RenderShaderView GetMomentSRV() const;
+	RenderShaderView GetScreenMask() const;
+
+	static const int				C_MAX_CASCADES = 4;
+
+private:
+	RenderDevice*					mDevice;
+	RenderTargetPool*				mPool;
+	PooledTexture*					mTexture;						// Only held during a frame
+	PooledTexture*					mMomentTexture;					// As well, when the filter uses it
+	RenderShaderView				mScreenMask;					// Owned by a ShadowMask, until EndFrame
+	RenderViewport					mViewport;
+	int								mSize;
+	int								mCascadeCount;
+	ShadowFilter					mFilter;
+
+	D3DXMATRIX						mViewProjection[C_MAX_CASCADES];
+	FrustumPlanes					mFrustumPlanes[C_MAX_CASCADES];
+	D3DXVECTOR4						mSplitDistances;				// Far distance of each cascade
+	D3DXVECTOR4						mCameraViewZ;					// Gives the view space z of a world position
+
+	// The static casters, drawn again when the cascade's matrix or the version changes
+	PooledTexture*					mStaticTexture;
+	D3DXMATRIX						mStaticViewProjection[C_MAX_CASCADES];
+	unsigned int					mStaticVersion[C_MAX_CASCADES];
+	bool							mStaticValid[C_MAX_CASCADES];
+	int								mStaticRenderCount;
+
+	static const float				C_SPLIT_LAMBDA;
+	static const float				C_RADIUS_STEP;
+
+	CascadedShadowMap(const CascadedShadowMap&);
+	CascadedShadowMap& operator=(const CascadedShadowMap&);
+
+	RenderTargetDesc GetDepthArrayDesc() const;
+	RenderTargetDesc GetMomentArrayDesc() const;
+	void ReleaseTextures();
+};
+
+// The cascade variables of an effect that receives shadows and its technique for every filter and for
+// the screen-space mask, Ground.fx, Effect.fx and ShadowMask.fx use the same names
+class ShadowEffectVariables
+{
+public:
+	ShadowEffectVariables();
+	void Initialize(RenderDevice* device, RenderEffect effect);
+	void Set(const CascadedShadowMap* shadowMap);
+	void Clear();
+	RenderTechnique GetTechnique(const CascadedShadowMap* shadowMap) const;
+
+	static const char* GetFilterName(ShadowFilter filter);
+	static int GetFilterTaps(ShadowFilter filter);
+
+private:
+	RenderDevice*							mDevice;
+	RenderTechnique							mTechniques[ShadowFilterCount];
+	RenderTechnique							mMaskTechnique;
+	RenderVariable							mfxCascadeViewProj;
+	RenderVariable							mfxCascadeSplits;
+	RenderVariable							mfxCameraViewZ;
+	RenderVariable							mfxCascadeCount;
+	RenderVariable							mfxSMWidth;
+	RenderVariable							mfxSMWidthInv;
+	RenderVariable							mfxShadowMap;
+	RenderVariable							mfxMomentMap;
+	RenderVariable							mfxShadowMask;
+};
+#endif
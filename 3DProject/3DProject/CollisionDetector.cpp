@@ -0,0 +1,651 @@
+#include "CollisionDetector.h"
+#include "GameTime.h"
+#include <algorithm>
+
+#ifdef COLLISION_DETECTOR_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const int C_CHUNK_SIZE = 8192;			// Fixed job ranges, so the results do not depend on the worker count
+	const int C_RADIX_BITS = 8;
+	const int C_RADIX_BUCKETS = 1 << C_RADIX_BITS;
+	const int C_RADIX_PASSES = 4;			// 32 bits, for the large object key
+	const int C_CELL_BITS = 10;
+	const unsigned int C_CELL_MASK = (1 << C_CELL_BITS) - 1;
+	const int C_NEIGHBOUR_COUNT = 13;
+	const unsigned int C_LARGE_OBJECT_KEY = 0xFFFFFFFF;	// Sorts after every cell key
+	const float C_LARGE_RADIUS_FACTOR = 2.0f;
+
+	const int C_NEIGHBOUR_ROWS = 5;
+	const int C_CURSOR_STEPS = 8;			// Cells stepped over before falling back to a binary search
+
+	// Half of the 26 neighbours, the other half finds the same pairs from the other side. Given as rows
+	// of (y offset, z offset, first x offset), every row ends at x offset 1.
+	const int C_NEIGHBOUR_ROW[C_NEIGHBOUR_ROWS][3] =
+	{
+		{ 0, 0, 1 },
+		{ 1, 0, -1 },
+		{ -1, 1, -1 },
+		{ 0, 1, -1 },
+		{ 1, 1, -1 }
+	};
+
+	int GetChunkCount(int count)
+	{
+		return (count + C_CHUNK_SIZE - 1) / C_CHUNK_SIZE;
+	}
+}
+
+CollisionDetector::CollisionDetector()
+	: mX(NULL), mY(NULL), mZ(NULL), mRadius(NULL), mCount(0), mNumGridObjects(0), mInvCellSize(1.0f),
+	  mMaxGridRadius(0.0f), mRadixShift(0), mCellTableMask(0)
+{
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+// Add a box that does not move, spheres overlapping it get static contacts. Returns the box index.
+int CollisionDetector::AddStaticBox(const AABB& box)
+{
+	mStaticBoxes.push_back(box);
+	return (int)mStaticBoxes.size() - 1;
+}
+
+void CollisionDetector::ClearStaticBoxes()
+{
+	mStaticBoxes.clear();
+}
+
+// Find all overlapping pairs of spheres and all spheres overlapping the static boxes
+void CollisionDetector::Detect(const float* x, const float* y, const float* z, const float* radius, int count,
+							   JobSystem* jobSystem)
+{
+	Stopwatch timer;
+	timer.Start();
+
+	mX = x;
+	mY = y;
+	mZ = z;
+	mRadius = radius;
+	mCount = count;
+
+	mContacts.clear();
+	mStaticContacts.clear();
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+	mStatistics.Objects = count;
+
+	if(count == 0)
+		return;
+
+	double radiusSum = 0.0;
+	for(int i = 0; i < count; ++i)
+		radiusSum += radius[i];
+
+	float largeRadius = C_LARGE_RADIUS_FACTOR * (float)(radiusSum / count);
+	mMaxGridRadius = 0.0f;
+	mNumGridObjects = 0;
+	for(int i = 0; i < count; ++i)
+	{
+		if(radius[i] <= largeRadius)
+		{
+			mMaxGridRadius = std::max(mMaxGridRadius, radius[i]);
+			++mNumGridObjects;
+		}
+	}
+	mInvCellSize = mMaxGridRadius > 0.0f ? 1.0f / (2.0f * mMaxGridRadius) : 1.0f;
+
+	int numChunks = GetChunkCount(count);
+	for(int i = 0; i < 2; ++i)
+	{
+		mKeys[i].resize(count);
+		mIndices[i].resize(count);
+	}
+	mSortedX.resize(count);
+	mSortedY.resize(count);
+	mSortedZ.resize(count);
+	mSortedRadius.resize(count);
+
+	// Broad phase
+	RunJobs(jobSystem, ComputeKeysJob, numChunks);
+	SortKeys(jobSystem);
+	RunJobs(jobSystem, GatherJob, numChunks);
+	BuildCells();
+
+	mStatistics.BroadPhaseMilliseconds = timer.Stop().Milliseconds;
+	timer.Start();
+
+	// Narrow phase
+	mChunkContacts.resize(numChunks);
+	mChunkStaticContacts.resize(numChunks);
+	mChunkCandidates.resize(numChunks);
+	RunJobs(jobSystem, NarrowPhaseJob, numChunks);
+	if(!mStaticBoxes.empty())
+		RunJobs(jobSystem, StaticContactsJob, numChunks);
+
+	unsigned int checksum = 2166136261u;
+	for(int chunk = 0; chunk < numChunks; ++chunk)
+	{
+		mContacts.insert(mContacts.end(), mChunkContacts[chunk].begin(), mChunkContacts[chunk].end());
+		mStatistics.CandidatePairs += mChunkCandidates[chunk];
+
+		if(!mStaticBoxes.empty())
+			mStaticContacts.insert(mStaticContacts.end(), mChunkStaticContacts[chunk].begin(),
+								   mChunkStaticContacts[chunk].end());
+	}
+
+	for(size_t i = 0; i < mContacts.size(); ++i)
+		checksum = (checksum ^ (unsigned int)(mContacts[i].A * 31 + mContacts[i].B)) * 16777619u;
+	for(size_t i = 0; i < mStaticContacts.size(); ++i)
+		checksum = (checksum ^ (unsigned int)(mStaticContacts[i].Object * 31 + mStaticContacts[i].Box)) * 16777619u;
+
+	mStatistics.LargeObjects = count - mNumGridObjects;
+	mStatistics.Cells = (int)mCells.size();
+	mStatistics.Pairs = (int)mContacts.size();
+	mStatistics.StaticContacts = (int)mStaticContacts.size();
+	mStatistics.Checksum = checksum;
+	mStatistics.NarrowPhaseMilliseconds = timer.Stop().Milliseconds;
+}
+
+const std::vector<ContactPair>& CollisionDetector::GetContacts() const
+{
+	return mContacts;
+}
+
+const std::vector<StaticContact>& CollisionDetector::GetStaticContacts() const
+{
+	return mStaticContacts;
+}
+
+const CollisionStatistics& CollisionDetector::GetStatistics() const
+{
+	return mStatistics;
+}
+
+void CollisionDetector::ComputeKeysJob(void* data, int first, int count)
+{
+	CollisionDetector* detector = static_cast<CollisionDetector*>(data);
+	for(int chunk = first; chunk < first + count; ++chunk)
+	{
+		int end = std::min((chunk + 1) * C_CHUNK_SIZE, detector->mCount);
+		for(int i = chunk * C_CHUNK_SIZE; i < end; ++i)
+		{
+			detector->mIndices[0][i] = i;
+			if(detector->mRadius[i] > detector->mMaxGridRadius)
+			{
+				detector->mKeys[0][i] = C_LARGE_OBJECT_KEY;
+				continue;
+			}
+
+			int cellX = (int)floor(detector->mX[i] * detector->mInvCellSize);
+			int cellY = (int)floor(detector->mY[i] * detector->mInvCellSize);
+			int cellZ = (int)floor(detector->mZ[i] * detector->mInvCellSize);
+			detector->mKeys[0][i] = MakeKey(cellX, cellY, cellZ);
+		}
+	}
+}
+
+// Count the radix digits of the current pass in every chunk
+void CollisionDetector::HistogramJob(void* data, int first, int count)
+{
+	CollisionDetector* detector = static_cast<CollisionDetector*>(data);
+	const std::vector<unsigned int>& keys = detector->mKeys[(detector->mRadixShift / C_RADIX_BITS) & 1];
+
+	for(int chunk = first; chunk < first + count; ++chunk)
+	{
+		int* histogram = &detector->mHistograms[chunk * C_RADIX_BUCKETS];
+		std::fill(histogram, histogram + C_RADIX_BUCKETS, 0);
+
+		int end = std::min((chunk + 1) * C_CHUNK_SIZE, detector->mCount);
+		for(int i = chunk * C_CHUNK_SIZE; i < end; ++i)
+			++histogram[(keys[i] >> detector->mRadixShift) & (C_RADIX_BUCKETS - 1)];
+	}
+}
+
+// Move every key of the chunk to its place, the histograms hold each chunk's first position per digit
+void CollisionDetector::ScatterJob(void* data, int first, int count)
+{
+	CollisionDetector* detector = static_cast<CollisionDetector*>(data);
+	int source = (detector->mRadixShift / C_RADIX_BITS) & 1;
+	const std::vector<unsigned int>& keys = detector->mKeys[source];
+	const std::vector<int>& indices = detector->mIndices[source];
+	std::vector<unsigned int>& sortedKeys = detector->mKeys[1 - source];
+	std::vector<int>& sortedIndices = detector->mIndices[1 - source];
+
+	for(int chunk = first; chunk < first + count; ++chunk)
+	{
+		int* offsets = &detector->mHistograms[chunk * C_RADIX_BUCKETS];
+
+		int end = std::min((chunk + 1) * C_CHUNK_SIZE, detector->mCount);
+		for(int i = chunk * C_CHUNK_SIZE; i < end; ++i)
+		{
+			int position = offsets[(keys[i] >> detector->mRadixShift) & (C_RADIX_BUCKETS - 1)]++;
+			sortedKeys[position] = keys[i];
+			sortedIndices[position] = indices[i];
+		}
+	}
+}
+
+// Copy positions and radii in sorted order, so the objects of a cell lie next to each other
+void CollisionDetector::GatherJob(void* data, int first, int count)
+{
+	CollisionDetector* detector = static_cast<CollisionDetector*>(data);
+	const std::vector<int>& indices = detector->mIndices[0];
+
+	for(int chunk = first; chunk < first + count; ++chunk)
+	{
+		int end = std::min((chunk + 1) * C_CHUNK_SIZE, detector->mCount);
+		for(int i = chunk * C_CHUNK_SIZE; i < end; ++i)
+		{
+			int index = indices[i];
+			detector->mSortedX[i] = detector->mX[index];
+			detector->mSortedY[i] = detector->mY[index];
+			detector->mSortedZ[i] = detector->mZ[index];
+			detector->mSortedRadius[i] = detector->mRadius[index];
+		}
+	}
+}
+
+void CollisionDetector::NarrowPhaseJob(void* data, int first, int count)
+{
+	CollisionDetector* detector = static_cast<CollisionDetector*>(data);
+	for(int chunk = first; chunk < first + count; ++chunk)
+		detector->FindPairs(chunk);
+}
+
+void CollisionDetector::StaticContactsJob(void* data, int first, int count)
+{
+	CollisionDetector* detector = static_cast<CollisionDetector*>(data);
+	for(int chunk = first; chunk < first + count; ++chunk)
+		detector->FindStaticContacts(chunk);
+}
+
+// Run one job per chunk and wait for them, or run them here without a job system
+void CollisionDetector::RunJobs(JobSystem* jobSystem, JobFunction function, int count)
+{
+	if(jobSystem == NULL)
+	{
+		function(this, 0, count);
+		return;
+	}
+
+	JobCounter done;
+	jobSystem->ParallelFor(function, this, count, 1, &done);
+	jobSystem->Wait(&done);
+}
+
+// Least significant digit radix sort of (key, index), which is stable and so gives the same order
+// however the chunks are scheduled. The result ends up in mKeys[0] and mIndices[0].
+void CollisionDetector::SortKeys(JobSystem* jobSystem)
+{
+	int numChunks = GetChunkCount(mCount);
+	mHistograms.resize(numChunks * C_RADIX_BUCKETS);
+
+	for(int pass = 0; pass < C_RADIX_PASSES; ++pass)
+	{
+		mRadixShift = pass * C_RADIX_BITS;
+		RunJobs(jobSystem, HistogramJob, numChunks);
+
+		// Turn the counts into first positions, digit by digit and chunk by chunk within a digit
+		int position = 0;
+		for(int bucket = 0; bucket < C_RADIX_BUCKETS; ++bucket)
+		{
+			for(int chunk = 0; chunk < numChunks; ++chunk)
+			{
+				int& entry = mHistograms[chunk * C_RADIX_BUCKETS + bucket];
+				int bucketCount = entry;
+				entry = position;
+				position += bucketCount;
+			}
+		}
+
+		RunJobs(jobSystem, ScatterJob, numChunks);
+	}
+}
+
+// Find the ranges of equal keys and put them in the hash table
+void CollisionDetector::BuildCells()
+{
+	const std::vector<unsigned int>& keys = mKeys[0];
+
+	mCells.clear();
+	for(int i = 0; i < mNumGridObjects; ++i)
+	{
+		if(i == 0 || keys[i] != keys[i - 1])
+		{
+			Cell cell = { keys[i], i, 0 };
+			mCells.push_back(cell);
+		}
+
+		++mCells.back().Count;
+	}
+
+	unsigned int tableSize = 16;
+	while(tableSize < mCells.size() * 2)
+		tableSize *= 2;
+
+	CellSlot empty = { 0, -1 };
+	mCellTableMask = tableSize - 1;
+	mCellTable.assign(tableSize, empty);
+
+	for(int i = 0; i < (int)mCells.size(); ++i)
+	{
+		unsigned int slot = HashKey(mCells[i].Key) & mCellTableMask;
+		while(mCellTable[slot].Cell != -1)
+			slot = (slot + 1) & mCellTableMask;
+
+		mCellTable[slot].Key = mCells[i].Key;
+		mCellTable[slot].Cell = i;
+	}
+}
+
+// Get the index of the cell with the key, or -1 if it is empty
+int CollisionDetector::FindCell(unsigned int key) const
+{
+	unsigned int slot = HashKey(key) & mCellTableMask;
+	while(mCellTable[slot].Cell != -1)
+	{
+		if(mCellTable[slot].Key == key)
+			return mCellTable[slot].Cell;
+
+		slot = (slot + 1) & mCellTableMask;
+	}
+
+	return -1;
+}
+
+// Get the first cell at or after the cursor with a key not below the given key. The cells are sorted
+// and the searches of a row mostly move forward, so a few steps from the cursor are usually enough.
+int CollisionDetector::SeekCell(unsigned int key, int& cursor) const
+{
+	int numCells = (int)mCells.size();
+	if(cursor > 0 && mCells[cursor - 1].Key >= key)
+	{
+		// The row wrapped around, search from the start
+		cursor = LowerBoundCell(key, 0, cursor);
+		return cursor;
+	}
+
+	for(int step = 0; step < C_CURSOR_STEPS && cursor < numCells && mCells[cursor].Key < key; ++step)
+		++cursor;
+
+	if(cursor < numCells && mCells[cursor].Key < key)
+		cursor = LowerBoundCell(key, cursor, numCells);
+
+	return cursor;
+}
+
+// Binary search for the first cell in [first, end) with a key not below the given key
+int CollisionDetector::LowerBoundCell(unsigned int key, int first, int end) const
+{
+	while(first < end)
+	{
+		int middle = first + (end - first) / 2;
+		if(mCells[middle].Key < key)
+			first = middle + 1;
+		else
+			end = middle;
+	}
+
+	return first;
+}
+
+// Test the objects of the chunk, in sorted order, against the later objects of their own cell and
+// all objects of the forward neighbour cells. Large objects are tested against all grid objects and
+// the later large objects.
+void CollisionDetector::FindPairs(int chunk)
+{
+	std::vector<ContactPair>& contacts = mChunkContacts[chunk];
+	contacts.clear();
+	mChunkCandidates[chunk] = 0;
+
+	int first = chunk * C_CHUNK_SIZE;
+	int end = std::min(first + C_CHUNK_SIZE, mCount);
+
+	for(int i = std::max(first, mNumGridObjects); i < end; ++i)
+	{
+		TestCandidates(i, 0, mNumGridObjects, contacts);
+		TestCandidates(i, i + 1, mCount, contacts);
+		mChunkCandidates[chunk] += mNumGridObjects + mCount - (i + 1);
+	}
+
+	end = std::min(end, mNumGridObjects);
+	if(first >= end)
+		return;
+
+	int numCells = (int)mCells.size();
+	int cell = FindCell(mKeys[0][first]);
+	int cursors[C_NEIGHBOUR_ROWS] = { 0 };
+	int spanFirst[C_NEIGHBOUR_COUNT];
+	int spanEnd[C_NEIGHBOUR_COUNT];
+	int numSpans = 0;
+	bool neighboursFound = false;
+
+	for(int i = first; i < end; ++i)
+	{
+		if(i >= mCells[cell].First + mCells[cell].Count)
+		{
+			++cell;
+			neighboursFound = false;
+		}
+
+		// The neighbours are shared by every object in the cell. The cells of a row lie next to each other
+		// in the sorted order, unless the row wraps around, and their objects then form a single span.
+		if(!neighboursFound)
+		{
+			unsigned int key = mCells[cell].Key;
+			int cellX = key & C_CELL_MASK;
+			int cellY = (key >> C_CELL_BITS) & C_CELL_MASK;
+			int cellZ = (key >> (2 * C_CELL_BITS)) & C_CELL_MASK;
+
+			numSpans = 0;
+			for(int row = 0; row < C_NEIGHBOUR_ROWS; ++row)
+			{
+				int rowY = cellY + C_NEIGHBOUR_ROW[row][0];
+				int rowZ = cellZ + C_NEIGHBOUR_ROW[row][1];
+				int minX = cellX + C_NEIGHBOUR_ROW[row][2];
+				int maxX = cellX + 1;
+
+				if(minX >= 0 && maxX <= (int)C_CELL_MASK)
+				{
+					unsigned int maxKey = MakeKey(maxX, rowY, rowZ);
+					int rowFirst = SeekCell(MakeKey(minX, rowY, rowZ), cursors[row]);
+					int rowEnd = rowFirst;
+					while(rowEnd < numCells && mCells[rowEnd].Key <= maxKey)
+						++rowEnd;
+
+					if(rowEnd > rowFirst)
+					{
+						spanFirst[numSpans] = mCells[rowFirst].First;
+						spanEnd[numSpans] = mCells[rowEnd - 1].First + mCells[rowEnd - 1].Count;
+						++numSpans;
+					}
+				}
+				else
+				{
+					for(int x = minX; x <= maxX; ++x)
+					{
+						int neighbour = FindCell(MakeKey(x, rowY, rowZ));
+						if(neighbour >= 0)
+						{
+							spanFirst[numSpans] = mCells[neighbour].First;
+							spanEnd[numSpans] = mCells[neighbour].First + mCells[neighbour].Count;
+							++numSpans;
+						}
+					}
+				}
+			}
+
+			neighboursFound = true;
+		}
+
+		int candidates = mCells[cell].First + mCells[cell].Count - (i + 1);
+		TestCandidates(i, i + 1, mCells[cell].First + mCells[cell].Count, contacts);
+
+		for(int n = 0; n < numSpans; ++n)
+		{
+			candidates += spanEnd[n] - spanFirst[n];
+			TestCandidates(i, spanFirst[n], spanEnd[n], contacts);
+		}
+
+		mChunkCandidates[chunk] += candidates;
+	}
+}
+
+// Test the sphere of the sorted object against the sorted objects [first, end)
+void CollisionDetector::TestCandidates(int object, int first, int end, std::vector<ContactPair>& contacts)
+{
+	float x = mSortedX[object];
+	float y = mSortedY[object];
+	float z = mSortedZ[object];
+	float r = mSortedRadius[object];
+	int k = first;
+
+#ifdef COLLISION_DETECTOR_SSE
+	__m128 px = _mm_set1_ps(x);
+	__m128 py = _mm_set1_ps(y);
+	__m128 pz = _mm_set1_ps(z);
+	__m128 pr = _mm_set1_ps(r);
+
+	for(; k + 4 <= end; k += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&mSortedX[k]), px);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&mSortedY[k]), py);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(&mSortedZ[k]), pz);
+		__m128 radiusSum = _mm_add_ps(_mm_loadu_ps(&mSortedRadius[k]), pr);
+		__m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		int mask = _mm_movemask_ps(_mm_cmplt_ps(distanceSq, _mm_mul_ps(radiusSum, radiusSum)));
+		if(mask == 0)
+			continue;
+
+		int found[4];
+		int numFound = 0;
+		for(int lane = 0; lane < 4; ++lane)
+		{
+			if(mask & (1 << lane))
+				found[numFound++] = k + lane;
+		}
+
+		for(int f = 0; f < numFound; ++f)
+		{
+			int other = found[f];
+			D3DXVECTOR3 delta(mSortedX[other] - x, mSortedY[other] - y, mSortedZ[other] - z);
+			float distance = D3DXVec3Length(&delta);
+
+			ContactPair contact;
+			contact.A = mIndices[0][object];
+			contact.B = mIndices[0][other];
+			contact.Normal = distance > 0.0f ? delta / distance : D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+			contact.Depth = r + mSortedRadius[other] - distance;
+			if(contact.A > contact.B)
+			{
+				std::swap(contact.A, contact.B);
+				contact.Normal = -contact.Normal;
+			}
+
+			contacts.push_back(contact);
+		}
+	}
+#endif
+
+	for(; k < end; ++k)
+	{
+		D3DXVECTOR3 delta(mSortedX[k] - x, mSortedY[k] - y, mSortedZ[k] - z);
+		float radiusSum = r + mSortedRadius[k];
+		float distanceSq = D3DXVec3LengthSq(&delta);
+		if(distanceSq >= radiusSum * radiusSum)
+			continue;
+
+		float distance = sqrtf(distanceSq);
+
+		ContactPair contact;
+		contact.A = mIndices[0][object];
+		contact.B = mIndices[0][k];
+		contact.Normal = distance > 0.0f ? delta / distance : D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+		contact.Depth = radiusSum - distance;
+		if(contact.A > contact.B)
+		{
+			std::swap(contact.A, contact.B);
+			contact.Normal = -contact.Normal;
+		}
+
+		contacts.push_back(contact);
+	}
+}
+
+// Test the objects of the chunk, in their original order, against every static box
+void CollisionDetector::FindStaticContacts(int chunk)
+{
+	std::vector<StaticContact>& contacts = mChunkStaticContacts[chunk];
+	contacts.clear();
+
+	int first = chunk * C_CHUNK_SIZE;
+	int end = std::min(first + C_CHUNK_SIZE, mCount);
+
+	for(int i = first; i < end; ++i)
+	{
+		for(int b = 0; b < (int)mStaticBoxes.size(); ++b)
+		{
+			const AABB& box = mStaticBoxes[b];
+			D3DXVECTOR3 center(mX[i], mY[i], mZ[i]);
+			float r = mRadius[i];
+
+			// Closest point of the box to the sphere center
+			D3DXVECTOR3 closest(std::min(std::max(center.x, box.Min.x), box.Max.x),
+								std::min(std::max(center.y, box.Min.y), box.Max.y),
+								std::min(std::max(center.z, box.Min.z), box.Max.z));
+			D3DXVECTOR3 delta = center - closest;
+			float distanceSq = D3DXVec3LengthSq(&delta);
+			if(distanceSq >= r * r)
+				continue;
+
+			StaticContact contact;
+			contact.Object = i;
+			contact.Box = b;
+
+			if(distanceSq > 0.0f)
+			{
+				float distance = sqrtf(distanceSq);
+				contact.Normal = delta / distance;
+				contact.Depth = r - distance;
+			}
+			else
+			{
+				// The center is inside the box, push it out through the nearest face
+				float faceDistance[6] = { center.x - box.Min.x, box.Max.x - center.x, center.y - box.Min.y,
+										  box.Max.y - center.y, center.z - box.Min.z, box.Max.z - center.z };
+				int face = 0;
+				for(int f = 1; f < 6; ++f)
+				{
+					if(faceDistance[f] < faceDistance[face])
+						face = f;
+				}
+
+				contact.Normal = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+				contact.Normal[face / 2] = (face & 1) ? 1.0f : -1.0f;
+				contact.Depth = faceDistance[face] + r;
+			}
+
+			contacts.push_back(contact);
+		}
+	}
+}
+
+// Pack the cell coordinates, wrapped to 10 bits each, into a key
+unsigned int CollisionDetector::MakeKey(int cellX, int cellY, int cellZ)
+{
+	return ((unsigned int)cellX & C_CELL_MASK) | (((unsigned int)cellY & C_CELL_MASK) << C_CELL_BITS) |
+		   (((unsigned int)cellZ & C_CELL_MASK) << (2 * C_CELL_BITS));
+}
+
+// Mix all key bits into the low bits, which are the ones used by the table
+unsigned int CollisionDetector::HashKey(unsigned int key)
+{
+	key ^= key >> 16;
+	key *= 0x85ebca6bu;
+	key ^= key >> 13;
+	key *= 0xc2b2ae35u;
+	key ^= key >> 16;
+	return key;
+}
@@ -0,0 +1,142 @@
+#ifndef COLLISION_DETECTOR_H
+#define COLLISION_DETECTOR_H
+
+#include <vector>
+#include <D3DX10.h>
+
+#include "BoundingVolumes.h"
+#include "JobSystem.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define COLLISION_DETECTOR_SSE
+#endif
+
+// Two overlapping spheres. A < B, the normal points from A to B.
+struct ContactPair
+{
+	int					A;
+	int					B;
+	D3DXVECTOR3			Normal;
+	float				Depth;
+};
+
+// A sphere overlapping a static box, the normal points out of the box
+struct StaticContact
+{
+	int					Object;
+	int					Box;
+	D3DXVECTOR3			Normal;
+	float				Depth;
+};
+
+struct CollisionStatistics
+{
+	int					Objects;
+	int					LargeObjects;		// Too large for the grid, tested against every object
+	int					Cells;
+	int					CandidatePairs;		// Pairs tested by the narrow phase
+	int					Pairs;
+	int					StaticContacts;
+	double				BroadPhaseMilliseconds;
+	double				NarrowPhaseMilliseconds;
+	unsigned int		Checksum;			// Hash of the contact list, equal for equal input
+};
+
+// Collision detection for many spheres given as separate x, y, z and radius arrays.
+//
+// The broad phase is a uniform grid with cells at least as large as the largest sphere's diameter,
+// so overlapping spheres are always in the same or neighbouring cells. Spheres more than twice the
+// mean radius are kept out of the grid, so that a few large ones do not make the cells huge, and are
+// tested against every other sphere instead. Cell coordinates wrap around every 1024 cells and are
+// packed into 30 bit keys. Objects are bucketed by sorting (key, index) with a parallel radix sort,
+// and a hash table maps a key to its range in the sorted order.
+//
+// The narrow phase tests every object against the rest of its own cell and against 13 of its 26
+// neighbour cells, so every pair is visited once, four candidates at a time with SSE. Neighbours in
+// the same row are next to each other in the sorted order and are found by walking the sorted cells,
+// the hash table is only needed where a row wraps around. The work is
+// split into fixed ranges and the results joined in range order, which makes the contact list the
+// same whatever number of workers is used.
+class CollisionDetector
+{
+public:
+	CollisionDetector();
+
+	int AddStaticBox(const AABB& box);
+	void ClearStaticBoxes();
+
+	void Detect(const float* x, const float* y, const float* z, const float* radius, int count,
+				JobSystem* jobSystem);
+
+	const std::vector<ContactPair>& GetContacts() const;
+	const std::vector<StaticContact>& GetStaticContacts() const;
+	const CollisionStatistics& GetStatistics() const;
+
+private:
+	struct Cell
+	{
+		unsigned int		Key;
+		int					First;
+		int					Count;
+	};
+
+	struct CellSlot
+	{
+		unsigned int		Key;
+		int					Cell;				// -1 is empty
+	};
+
+	// Everything the jobs read and write
+	const float*							mX;
+	const float*							mY;
+	const float*							mZ;
+	const float*							mRadius;
+	int										mCount;
+	int										mNumGridObjects;	// Sorted before the large objects
+	float									mInvCellSize;
+	float									mMaxGridRadius;
+	int										mRadixShift;
+
+	std::vector<unsigned int>				mKeys[2];
+	std::vector<int>						mIndices[2];
+	std::vector<int>						mHistograms;		// 256 counts per sort chunk
+	std::vector<float>						mSortedX;
+	std::vector<float>						mSortedY;
+	std::vector<float>						mSortedZ;
+	std::vector<float>						mSortedRadius;
+
+	std::vector<Cell>						mCells;
+	std::vector<CellSlot>					mCellTable;			// Open addressing
+	unsigned int							mCellTableMask;
+
+	std::vector<AABB>						mStaticBoxes;
+
+	std::vector<std::vector<ContactPair> >	mChunkContacts;
+	std::vector<std::vector<StaticContact> >	mChunkStaticContacts;
+	std::vector<int>						mChunkCandidates;
+
+	std::vector<ContactPair>				mContacts;
+	std::vector<StaticContact>				mStaticContacts;
+	CollisionStatistics						mStatistics;
+
+	static void ComputeKeysJob(void* data, int first, int count);
+	static void HistogramJob(void* data, int first, int count);
+	static void ScatterJob(void* data, int first, int count);
+	static void GatherJob(void* data, int first, int count);
+	static void NarrowPhaseJob(void* data, int first, int count);
+	static void StaticContactsJob(void* data, int first, int count);
+
+	void RunJobs(JobSystem* jobSystem, JobFunction function, int count);
+	void SortKeys(JobSystem* jobSystem);
+	void BuildCells();
+	int FindCell(unsigned int key) const;
+	int SeekCell(unsigned int key, int& cursor) const;
+	int LowerBoundCell(unsigned int key, int first, int end) const;
+	void FindPairs(int chunk);
+	void FindStaticContacts(int chunk);
+	void TestCandidates(int object, int first, int end, std::vector<ContactPair>& contacts);
+
+	static unsigned int MakeKey(int cellX, int cellY, int cellZ);
+	static unsigned int HashKey(unsigned int key);
+};
+#endif
@@ -0,0 +1,698 @@
+#include "D3D10RenderDevice.h"
+#include <cstring>
+#include <string>
+#include <D3DX10.h>
+
+namespace
+{
+	ID3D10ShaderResourceView* const C_NULL_RESOURCES[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { NULL };
+
+	DXGI_FORMAT ToDXGI(RenderFormat format)
+	{
+		switch(format)
+		{
+		case RenderFormatR32Float:				return DXGI_FORMAT_R32_FLOAT;
+		case RenderFormatR32G32Float:			return DXGI_FORMAT_R32G32_FLOAT;
+		case RenderFormatR32G32B32Float:		return DXGI_FORMAT_R32G32B32_FLOAT;
+		case RenderFormatR32G32B32A32Float:		return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		case RenderFormatR16G16B16A16Float:		return DXGI_FORMAT_R16G16B16A16_FLOAT;
+		case RenderFormatR8Unorm:				return DXGI_FORMAT_R8_UNORM;
+		case RenderFormatR8G8Unorm:				return DXGI_FORMAT_R8G8_UNORM;
+		case RenderFormatR8G8B8A8Unorm:			return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case RenderFormatR16Uint:				return DXGI_FORMAT_R16_UINT;
+		case RenderFormatR32Uint:				return DXGI_FORMAT_R32_UINT;
+		case RenderFormatR32Typeless:			return DXGI_FORMAT_R32_TYPELESS;
+		case RenderFormatR24G8Typeless:			return DXGI_FORMAT_R24G8_TYPELESS;
+		case RenderFormatR16Typeless:			return DXGI_FORMAT_R16_TYPELESS;
+		default:								return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	// Formats of the views of a typeless texture, other formats are viewed as they are
+	DXGI_FORMAT GetDepthViewFormat(DXGI_FORMAT format)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_R32_TYPELESS:		return DXGI_FORMAT_D32_FLOAT;
+		case DXGI_FORMAT_R24G8_TYPELESS:	return DXGI_FORMAT_D24_UNORM_S8_UINT;
+		case DXGI_FORMAT_R16_TYPELESS:		return DXGI_FORMAT_D16_UNORM;
+		default:							return format;
+		}
+	}
+
+	DXGI_FORMAT GetShaderViewFormat(DXGI_FORMAT format)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_R32_TYPELESS:		return DXGI_FORMAT_R32_FLOAT;
+		case DXGI_FORMAT_R24G8_TYPELESS:	return DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+		case DXGI_FORMAT_R16_TYPELESS:		return DXGI_FORMAT_R16_UNORM;
+		default:							return format;
+		}
+	}
+
+	UINT ToD3D10BindFlags(UINT bindFlags)
+	{
+		UINT flags = 0;
+		if(bindFlags & RenderBindVertexBuffer)
+			flags |= D3D10_BIND_VERTEX_BUFFER;
+		if(bindFlags & RenderBindIndexBuffer)
+			flags |= D3D10_BIND_INDEX_BUFFER;
+		if(bindFlags & RenderBindShaderResource)
+			flags |= D3D10_BIND_SHADER_RESOURCE;
+		if(bindFlags & RenderBindRenderTarget)
+			flags |= D3D10_BIND_RENDER_TARGET;
+		if(bindFlags & RenderBindDepthStencil)
+			flags |= D3D10_BIND_DEPTH_STENCIL;
+		return flags;
+	}
+
+	// Readback resources are staging ones, nothing reads them on the GPU
+	void ToD3D10Usage(RenderUsage usage, UINT bindFlags, D3D10_USAGE& d3dUsage, UINT& cpuAccess, UINT& d3dBindFlags)
+	{
+		d3dBindFlags = ToD3D10BindFlags(bindFlags);
+		cpuAccess = 0;
+		switch(usage)
+		{
+		case RenderUsageImmutable:
+			d3dUsage = D3D10_USAGE_IMMUTABLE;
+			break;
+		case RenderUsageDynamic:
+			d3dUsage = D3D10_USAGE_DYNAMIC;
+			cpuAccess = D3D10_CPU_ACCESS_WRITE;
+			break;
+		case RenderUsageReadback:
+			d3dUsage = D3D10_USAGE_STAGING;
+			cpuAccess = D3D10_CPU_ACCESS_READ;
+			d3dBindFlags = 0;
+			break;
+		default:
+			d3dUsage = D3D10_USAGE_DEFAULT;
+			break;
+		}
+	}
+
+	D3D10_PRIMITIVE_TOPOLOGY ToD3D10(RenderTopology topology)
+	{
+		switch(topology)
+		{
+		case RenderTopologyPointList:		return D3D10_PRIMITIVE_TOPOLOGY_POINTLIST;
+		case RenderTopologyTriangleList:	return D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		case RenderTopologyTriangleStrip:	return D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+		default:							return D3D10_PRIMITIVE_TOPOLOGY_UNDEFINED;
+		}
+	}
+
+	ID3D10Texture2D* ToD3D10(RenderTexture texture)				{ return reinterpret_cast<ID3D10Texture2D*>(texture); }
+	ID3D10ShaderResourceView* ToD3D10(RenderShaderView view)	{ return reinterpret_cast<ID3D10ShaderResourceView*>(view); }
+	ID3D10RenderTargetView* ToD3D10(RenderTargetView view)		{ return reinterpret_cast<ID3D10RenderTargetView*>(view); }
+	ID3D10DepthStencilView* ToD3D10(RenderDepthView view)		{ return reinterpret_cast<ID3D10DepthStencilView*>(view); }
+	ID3D10Effect* ToD3D10(RenderEffect effect)					{ return reinterpret_cast<ID3D10Effect*>(effect); }
+	ID3D10EffectTechnique* ToD3D10(RenderTechnique technique)	{ return reinterpret_cast<ID3D10EffectTechnique*>(technique); }
+	ID3D10EffectPass* ToD3D10(RenderPass pass)					{ return reinterpret_cast<ID3D10EffectPass*>(pass); }
+	ID3D10EffectVariable* ToD3D10(RenderVariable variable)		{ return reinterpret_cast<ID3D10EffectVariable*>(variable); }
+	ID3D10InputLayout* ToD3D10(RenderInputLayout layout)		{ return reinterpret_cast<ID3D10InputLayout*>(layout); }
+	ID3D10Query* ToD3D10(RenderQuery query)						{ return reinterpret_cast<ID3D10Query*>(query); }
+}
+
+D3D10RenderDevice::D3D10RenderDevice()
+	: mDevice(NULL), mBackBuffer(NULL), mBackBufferDepth(NULL)
+{
+}
+
+D3D10RenderDevice::~D3D10RenderDevice()
+{
+	for(size_t i = 0; i < mBuffers.size(); ++i)
+		SafeRelease(mBuffers[i]);
+}
+
+void D3D10RenderDevice::Initialize(ID3D10Device* device)
+{
+	mDevice = device;
+}
+
+// The views the application draws the frame into, they change when the window is resized
+void D3D10RenderDevice::SetBackBuffer(ID3D10RenderTargetView* renderTarget, ID3D10DepthStencilView* depthStencil)
+{
+	mBackBuffer = renderTarget;
+	mBackBufferDepth = depthStencil;
+}
+
+void D3D10RenderDevice::BeginFrame()
+{
+}
+
+// Returns C_NO_BUFFER if the buffer could not be created
+RenderBuffer D3D10RenderDevice::CreateBuffer(const RenderBufferDesc& desc, const void* data)
+{
+	D3D10_BUFFER_DESC bufferDesc;
+	bufferDesc.ByteWidth = desc.Bytes;
+	bufferDesc.MiscFlags = 0;
+	ToD3D10Usage(desc.Usage, desc.BindFlags, bufferDesc.Usage, bufferDesc.CPUAccessFlags, bufferDesc.BindFlags);
+
+	D3D10_SUBRESOURCE_DATA subData;
+	subData.pSysMem = data;
+	subData.SysMemPitch = 0;
+	subData.SysMemSlicePitch = 0;
+
+	ID3D10Buffer* created = NULL;
+	if(FAILED(mDevice->CreateBuffer(&bufferDesc, data != NULL ? &subData : NULL, &created)))
+		return C_NO_BUFFER;
+
+	if(mFreeBuffers.empty())
+	{
+		mBuffers.push_back(created);
+		return (RenderBuffer)mBuffers.size() - 1;
+	}
+
+	RenderBuffer buffer = mFreeBuffers.back();
+	mFreeBuffers.pop_back();
+	mBuffers[buffer] = created;
+	return buffer;
+}
+
+void D3D10RenderDevice::ReleaseBuffer(RenderBuffer buffer)
+{
+	if(GetBuffer(buffer) == NULL)
+		return;
+
+	SafeRelease(mBuffers[buffer]);
+	mFreeBuffers.push_back(buffer);
+}
+
+// Fill the start of a dynamic buffer, the rest of its contents are discarded
+void D3D10RenderDevice::UpdateBuffer(RenderBuffer buffer, const void* data, int bytes)
+{
+	ID3D10Buffer* target = GetBuffer(buffer);
+	void* mapped = NULL;
+	if(target == NULL || FAILED(target->Map(D3D10_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+
+	memcpy(mapped, data, bytes);
+	target->Unmap();
+}
+
+// The data is the top mip of the first slice, rowBytes apart. Returns NULL if the texture could
+// not be created.
+RenderTexture D3D10RenderDevice::CreateTexture(const RenderTextureDesc& desc, const void* data, int rowBytes)
+{
+	D3D10_TEXTURE2D_DESC textureDesc;
+	textureDesc.Width = desc.Width;
+	textureDesc.Height = desc.Height;
+	textureDesc.MipLevels = desc.MipLevels;
+	textureDesc.ArraySize = desc.ArraySize;
+	textureDesc.Format = ToDXGI(desc.Format);
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	ToD3D10Usage(desc.Usage, desc.BindFlags, textureDesc.Usage, textureDesc.CPUAccessFlags, textureDesc.BindFlags);
+	textureDesc.MiscFlags = 0;
+	if(desc.MipLevels != 1 && (desc.BindFlags & RenderBindRenderTarget))
+		textureDesc.MiscFlags |= D3D10_RESOURCE_MISC_GENERATE_MIPS;
+	if(desc.Cube)
+		textureDesc.MiscFlags |= D3D10_RESOURCE_MISC_TEXTURECUBE;
+
+	D3D10_SUBRESOURCE_DATA subData;
+	subData.pSysMem = data;
+	subData.SysMemPitch = rowBytes;
+	subData.SysMemSlicePitch = 0;
+
+	ID3D10Texture2D* texture = NULL;
+	if(FAILED(mDevice->CreateTexture2D(&textureDesc, data != NULL ? &subData : NULL, &texture)))
+		return NULL;
+
+	return reinterpret_cast<RenderTexture>(texture);
+}
+
+void D3D10RenderDevice::ReleaseTexture(RenderTexture texture)
+{
+	ID3D10Texture2D* d3dTexture = ToD3D10(texture);
+	SafeRelease(d3dTexture);
+}
+
+// Write the rows of a dynamic texture's top mip, the rest of the texture is discarded
+void D3D10RenderDevice::UpdateTexture(RenderTexture texture, const void* data, int rowBytes, int rows)
+{
+	ID3D10Texture2D* d3dTexture = ToD3D10(texture);
+	D3D10_MAPPED_TEXTURE2D mapped;
+	if(d3dTexture == NULL || FAILED(d3dTexture->Map(0, D3D10_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+
+	for(int y = 0; y < rows; ++y)
+		memcpy(static_cast<unsigned char*>(mapped.pData) + y * mapped.RowPitch,
+			   static_cast<const unsigned char*>(data) + y * rowBytes, rowBytes);
+
+	d3dTexture->Unmap(0);
+}
+
+// Both textures have the same description
+void D3D10RenderDevice::CopyTexture(RenderTexture destination, RenderTexture source)
+{
+	if(destination != NULL && source != NULL)
+		mDevice->CopyResource(ToD3D10(destination), ToD3D10(source));
+}
+
+// A shader view of a texture file, NULL if it could not be loaded
+RenderShaderView D3D10RenderDevice::LoadTexture(const char* filename)
+{
+	ID3D10ShaderResourceView* view = NULL;
+	if(FAILED(D3DX10CreateShaderResourceViewFromFileA(mDevice, filename, NULL, NULL, &view, NULL)))
+		return NULL;
+
+	return reinterpret_cast<RenderShaderView>(view);
+}
+
+RenderShaderView D3D10RenderDevice::CreateShaderView(RenderTexture texture, RenderViewType type)
+{
+	if(texture == NULL)
+		return NULL;
+
+	D3D10_TEXTURE2D_DESC textureDesc;
+	ToD3D10(texture)->GetDesc(&textureDesc);
+
+	D3D10_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	srvDesc.Format = GetShaderViewFormat(textureDesc.Format);
+	if(type == RenderViewTextureCube)
+	{
+		srvDesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURECUBE;
+		srvDesc.TextureCube.MostDetailedMip = 0;
+		srvDesc.TextureCube.MipLevels = textureDesc.MipLevels;
+	}
+	else if(type == RenderViewTexture2DArray)
+	{
+		srvDesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MostDetailedMip = 0;
+		srvDesc.Texture2DArray.MipLevels = textureDesc.MipLevels;
+		srvDesc.Texture2DArray.FirstArraySlice = 0;
+		srvDesc.Texture2DArray.ArraySize = textureDesc.ArraySize;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = 0;
+		srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
+	}
+
+	ID3D10ShaderResourceView* view = NULL;
+	if(FAILED(mDevice->CreateShaderResourceView(ToD3D10(texture), &srvDesc, &view)))
+		return NULL;
+
+	return reinterpret_cast<RenderShaderView>(view);
+}
+
+// A view of the top mip of some of the texture's slices
+RenderTargetView D3D10RenderDevice::CreateRenderTargetView(RenderTexture texture, int firstSlice, int numSlices)
+{
+	if(texture == NULL)
+		return NULL;
+
+	D3D10_TEXTURE2D_DESC textureDesc;
+	ToD3D10(texture)->GetDesc(&textureDesc);
+
+	D3D10_RENDER_TARGET_VIEW_DESC rtvDesc;
+	rtvDesc.Format = textureDesc.Format;
+	rtvDesc.ViewDimension = D3D10_RTV_DIMENSION_TEXTURE2DARRAY;
+	rtvDesc.Texture2DArray.MipSlice = 0;
+	rtvDesc.Texture2DArray.FirstArraySlice = firstSlice;
+	rtvDesc.Texture2DArray.ArraySize = numSlices;
+
+	ID3D10RenderTargetView* view = NULL;
+	if(FAILED(mDevice->CreateRenderTargetView(ToD3D10(texture), &rtvDesc, &view)))
+		return NULL;
+
+	return reinterpret_cast<RenderTargetView>(view);
+}
+
+RenderDepthView D3D10RenderDevice::CreateDepthView(RenderTexture texture, int firstSlice, int numSlices)
+{
+	if(texture == NULL)
+		return NULL;
+
+	D3D10_TEXTURE2D_DESC textureDesc;
+	ToD3D10(texture)->GetDesc(&textureDesc);
+
+	D3D10_DEPTH_STENCIL_VIEW_DESC dsvDesc;
+	dsvDesc.Format = GetDepthViewFormat(textureDesc.Format);
+	dsvDesc.ViewDimension = D3D10_DSV_DIMENSION_TEXTURE2DARRAY;
+	dsvDesc.Texture2DArray.MipSlice = 0;
+	dsvDesc.Texture2DArray.FirstArraySlice = firstSlice;
+	dsvDesc.Texture2DArray.ArraySize = numSlices;
+
+	ID3D10DepthStencilView* view = NULL;
+	if(FAILED(mDevice->CreateDepthStencilView(ToD3D10(texture), &dsvDesc, &view)))
+		return NULL;
+
+	return reinterpret_cast<RenderDepthView>(view);
+}
+
+void D3D10RenderDevice::ReleaseShaderView(RenderShaderView view)
+{
+	ID3D10ShaderResourceView* d3dView = ToD3D10(view);
+	SafeRelease(d3dView);
+}
+
+void D3D10RenderDevice::ReleaseRenderTargetView(RenderTargetView view)
+{
+	ID3D10RenderTargetView* d3dView = ToD3D10(view);
+	SafeRelease(d3dView);
+}
+
+void D3D10RenderDevice::ReleaseDepthView(RenderDepthView view)
+{
+	ID3D10DepthStencilView* d3dView = ToD3D10(view);
+	SafeRelease(d3dView);
+}
+
+void D3D10RenderDevice::GenerateMips(RenderShaderView view)
+{
+	if(view != NULL)
+		mDevice->GenerateMips(ToD3D10(view));
+}
+
+RenderTargetView D3D10RenderDevice::GetBackBuffer()
+{
+	return reinterpret_cast<RenderTargetView>(mBackBuffer);
+}
+
+RenderDepthView D3D10RenderDevice::GetBackBufferDepth()
+{
+	return reinterpret_cast<RenderDepthView>(mBackBufferDepth);
+}
+
+// Compile and create an fx_4_0 effect, the compile errors are shown in a message box. Returns NULL
+// if the effect could not be created.
+RenderEffect D3D10RenderDevice::CreateEffect(const char* filename)
+{
+	UINT shaderFlags = D3D10_SHADER_ENABLE_STRICTNESS;	// Shader flags
+	ID3D10Blob* errors = NULL;							// Variable to store error messages from functions
+	ID3D10Blob* compiled = NULL;						// Variable to store compiled (but not created) effect
+
+	HRESULT result = D3DX10CompileFromFileA(filename, 0, 0, "", "fx_4_0", shaderFlags, 0, 0, &compiled, &errors, NULL);
+	if(FAILED(result))
+	{
+		if(errors)
+		{
+			MessageBox(0, (char*)errors->GetBufferPointer(), "ERROR", 0);
+			SafeRelease(errors);
+		}
+
+		return NULL;
+	}
+
+	ID3D10Effect* effect = NULL;
+	result = D3DX10CreateEffectFromMemory(compiled->GetBufferPointer(), compiled->GetBufferSize(), filename, NULL,
+										  NULL, "fx_4_0", 0, 0, mDevice, NULL, NULL, &effect, &errors, NULL);
+	SafeRelease(compiled);
+	if(FAILED(result))
+	{
+		std::string message = std::string("Shader creation failed: ") + filename;
+		MessageBox(0, message.c_str(), "ERROR", 0);
+		SafeRelease(errors);
+		return NULL;
+	}
+
+	return reinterpret_cast<RenderEffect>(effect);
+}
+
+void D3D10RenderDevice::ReleaseEffect(RenderEffect effect)
+{
+	ID3D10Effect* d3dEffect = ToD3D10(effect);
+	SafeRelease(d3dEffect);
+}
+
+// D3D10 gives out an invalid technique or variable for a name the effect does not have, here it is NULL
+RenderTechnique D3D10RenderDevice::GetTechnique(RenderEffect effect, const char* name)
+{
+	if(effect == NULL)
+		return NULL;
+
+	ID3D10EffectTechnique* technique = ToD3D10(effect)->GetTechniqueByName(name);
+	return technique->IsValid() ? reinterpret_cast<RenderTechnique>(technique) : NULL;
+}
+
+int D3D10RenderDevice::GetPassCount(RenderTechnique technique)
+{
+	if(technique == NULL)
+		return 0;
+
+	D3D10_TECHNIQUE_DESC techDesc;
+	ToD3D10(technique)->GetDesc(&techDesc);
+	return techDesc.Passes;
+}
+
+RenderPass D3D10RenderDevice::GetPass(RenderTechnique technique, int index)
+{
+	if(technique == NULL)
+		return NULL;
+
+	ID3D10EffectPass* pass = ToD3D10(technique)->GetPassByIndex(index);
+	return pass->IsValid() ? reinterpret_cast<RenderPass>(pass) : NULL;
+}
+
+RenderVariable D3D10RenderDevice::GetVariable(RenderEffect effect, const char* name)
+{
+	if(effect == NULL)
+		return NULL;
+
+	ID3D10EffectVariable* variable = ToD3D10(effect)->GetVariableByName(name);
+	return variable->IsValid() ? reinterpret_cast<RenderVariable>(variable) : NULL;
+}
+
+// The setters do nothing for a NULL variable. D3D10 takes the values as non-const, it only reads them.
+void D3D10RenderDevice::SetMatrix(RenderVariable variable, const float* matrix)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsMatrix()->SetMatrix(const_cast<float*>(matrix));
+}
+
+void D3D10RenderDevice::SetMatrixArray(RenderVariable variable, const float* matrices, int first, int count)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsMatrix()->SetMatrixArray(const_cast<float*>(matrices), first, count);
+}
+
+void D3D10RenderDevice::SetFloatVector(RenderVariable variable, const float* vector)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsVector()->SetFloatVector(const_cast<float*>(vector));
+}
+
+void D3D10RenderDevice::SetFloatVectorArray(RenderVariable variable, const float* vectors, int first, int count)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsVector()->SetFloatVectorArray(const_cast<float*>(vectors), first, count);
+}
+
+void D3D10RenderDevice::SetFloat(RenderVariable variable, float value)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsScalar()->SetFloat(value);
+}
+
+void D3D10RenderDevice::SetInt(RenderVariable variable, int value)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsScalar()->SetInt(value);
+}
+
+void D3D10RenderDevice::SetBool(RenderVariable variable, bool value)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsScalar()->SetBool(value);
+}
+
+void D3D10RenderDevice::SetShaderView(RenderVariable variable, RenderShaderView view)
+{
+	if(variable != NULL)
+		ToD3D10(variable)->AsShaderResource()->SetResource(ToD3D10(view));
+}
+
+// The layout of vertices read by the pass' vertex shader, NULL if it does not match the shader
+RenderInputLayout D3D10RenderDevice::CreateInputLayout(const RenderVertexElement* elements, int count, RenderPass pass)
+{
+	if(pass == NULL)
+		return NULL;
+
+	std::vector<D3D10_INPUT_ELEMENT_DESC> inputDesc(count);
+	for(int i = 0; i < count; ++i)
+	{
+		D3D10_INPUT_ELEMENT_DESC& element = inputDesc[i];
+		element.SemanticName = elements[i].Semantic;
+		element.SemanticIndex = elements[i].SemanticIndex;
+		element.Format = ToDXGI(elements[i].Format);
+		element.InputSlot = 0;
+		element.AlignedByteOffset = elements[i].Offset;
+		element.InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA;
+		element.InstanceDataStepRate = 0;
+	}
+
+	D3D10_PASS_DESC passDesc;
+	ToD3D10(pass)->GetDesc(&passDesc);
+
+	ID3D10InputLayout* layout = NULL;
+	if(FAILED(mDevice->CreateInputLayout(&inputDesc[0], count, passDesc.pIAInputSignature,
+										 passDesc.IAInputSignatureSize, &layout)))
+	{
+		MessageBox(0, "Input Layout creation failed!", "ERROR", 0);
+		return NULL;
+	}
+
+	return reinterpret_cast<RenderInputLayout>(layout);
+}
+
+void D3D10RenderDevice::ReleaseInputLayout(RenderInputLayout layout)
+{
+	ID3D10InputLayout* d3dLayout = ToD3D10(layout);
+	SafeRelease(d3dLayout);
+}
+
+RenderQuery D3D10RenderDevice::CreateQuery(RenderQueryType type)
+{
+	D3D10_QUERY_DESC queryDesc;
+	queryDesc.MiscFlags = 0;
+	if(type == RenderQueryTimestamp)
+		queryDesc.Query = D3D10_QUERY_TIMESTAMP;
+	else if(type == RenderQueryTimestampDisjoint)
+		queryDesc.Query = D3D10_QUERY_TIMESTAMP_DISJOINT;
+	else
+		queryDesc.Query = D3D10_QUERY_PIPELINE_STATISTICS;
+
+	ID3D10Query* query = NULL;
+	if(FAILED(mDevice->CreateQuery(&queryDesc, &query)))
+		return NULL;
+
+	return reinterpret_cast<RenderQuery>(query);
+}
+
+void D3D10RenderDevice::ReleaseQuery(RenderQuery query)
+{
+	ID3D10Query* d3dQuery = ToD3D10(query);
+	SafeRelease(d3dQuery);
+}
+
+void D3D10RenderDevice::BeginQuery(RenderQuery query)
+{
+	if(query != NULL)
+		ToD3D10(query)->Begin();
+}
+
+void D3D10RenderDevice::EndQuery(RenderQuery query)
+{
+	if(query != NULL)
+		ToD3D10(query)->End();
+}
+
+// The results are false until the GPU has them, reading them never flushes the device
+bool D3D10RenderDevice::GetTimestamp(RenderQuery query, UINT64& timestamp)
+{
+	return query != NULL && ToD3D10(query)->GetData(&timestamp, sizeof(timestamp), D3D10_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+}
+
+bool D3D10RenderDevice::GetTimestampFrequency(RenderQuery query, UINT64& frequency, bool& disjoint)
+{
+	D3D10_QUERY_DATA_TIMESTAMP_DISJOINT data;
+	if(query == NULL || ToD3D10(query)->GetData(&data, sizeof(data), D3D10_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	frequency = data.Frequency;
+	disjoint = data.Disjoint != FALSE;
+	return true;
+}
+
+bool D3D10RenderDevice::GetPipelineStatistics(RenderQuery query, RenderPipelineStatistics& statistics)
+{
+	D3D10_QUERY_DATA_PIPELINE_STATISTICS data;
+	if(query == NULL || ToD3D10(query)->GetData(&data, sizeof(data), D3D10_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	statistics.IAVertices = data.IAVertices;
+	statistics.IAPrimitives = data.IAPrimitives;
+	statistics.VSInvocations = data.VSInvocations;
+	statistics.GSInvocations = data.GSInvocations;
+	statistics.GSPrimitives = data.GSPrimitives;
+	statistics.CInvocations = data.CInvocations;
+	statistics.CPrimitives = data.CPrimitives;
+	statistics.PSInvocations = data.PSInvocations;
+	return true;
+}
+
+void D3D10RenderDevice::SetInputLayout(RenderInputLayout layout)
+{
+	mDevice->IASetInputLayout(ToD3D10(layout));
+}
+
+void D3D10RenderDevice::SetPrimitiveTopology(RenderTopology topology)
+{
+	mDevice->IASetPrimitiveTopology(ToD3D10(topology));
+}
+
+// Only the first slot is used, every vertex format in the program is a single stream
+void D3D10RenderDevice::SetVertexBuffer(RenderBuffer buffer, UINT stride)
+{
+	ID3D10Buffer* vertexBuffer = GetBuffer(buffer);
+	UINT offset = 0;
+	mDevice->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+}
+
+void D3D10RenderDevice::SetIndexBuffer(RenderBuffer buffer, RenderFormat format)
+{
+	mDevice->IASetIndexBuffer(GetBuffer(buffer), ToDXGI(format), 0);
+}
+
+void D3D10RenderDevice::ApplyPass(RenderPass pass)
+{
+	if(pass != NULL)
+		ToD3D10(pass)->Apply(0);
+}
+
+void D3D10RenderDevice::SetRenderTargets(int count, const RenderTargetView* renderTargets, RenderDepthView depthStencil)
+{
+	ID3D10RenderTargetView* views[C_MAX_RENDER_TARGETS] = { NULL };
+	for(int i = 0; i < count && i < C_MAX_RENDER_TARGETS; ++i)
+		views[i] = ToD3D10(renderTargets[i]);
+
+	mDevice->OMSetRenderTargets(count, views, ToD3D10(depthStencil));
+}
+
+void D3D10RenderDevice::SetViewport(const RenderViewport& viewport)
+{
+	D3D10_VIEWPORT d3dViewport = { viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height,
+								   viewport.MinDepth, viewport.MaxDepth };
+	mDevice->RSSetViewports(1, &d3dViewport);
+}
+
+// Unbind every shader resource slot of the vertex, geometry and pixel shaders
+void D3D10RenderDevice::UnbindShaderResources()
+{
+	mDevice->VSSetShaderResources(0, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, C_NULL_RESOURCES);
+	mDevice->GSSetShaderResources(0, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, C_NULL_RESOURCES);
+	mDevice->PSSetShaderResources(0, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, C_NULL_RESOURCES);
+}
+
+void D3D10RenderDevice::ClearRenderTarget(RenderTargetView renderTarget, const float color[4])
+{
+	mDevice->ClearRenderTargetView(ToD3D10(renderTarget), color);
+}
+
+void D3D10RenderDevice::ClearDepthStencil(RenderDepthView depthStencil)
+{
+	mDevice->ClearDepthStencilView(ToD3D10(depthStencil), D3D10_CLEAR_DEPTH | D3D10_CLEAR_STENCIL, 1.0f, 0);
+}
+
+void D3D10RenderDevice::Draw(UINT vertexCount, UINT startVertex)
+{
+	mDevice->Draw(vertexCount, startVertex);
+}
+
+void D3D10RenderDevice::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+{
+	mDevice->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+// NULL for C_NO_BUFFER and released buffers
+ID3D10Buffer* D3D10RenderDevice::GetBuffer(RenderBuffer buffer) const
+{
+	if(buffer < 0 || buffer >= (RenderBuffer)mBuffers.size())
+		return NULL;
+
+	return mBuffers[buffer];
+}
@@ -0,0 +1,92 @@
+#ifndef D3D10_RENDER_DEVICE_H
+#define D3D10_RENDER_DEVICE_H
+
+#include <vector>
+#include <D3D10.h>
+#include "RenderDevice.h"
+
+// Draws with the D3D10 device, every call is forwarded as it is. Buffers are kept in a table and
+// the slots of released buffers are given to the next ones created, every other handle is the D3D10
+// object itself.
+class D3D10RenderDevice : public RenderDevice
+{
+public:
+	D3D10RenderDevice();
+	virtual ~D3D10RenderDevice();
+	void Initialize(ID3D10Device* device);
+	void SetBackBuffer(ID3D10RenderTargetView* renderTarget, ID3D10DepthStencilView* depthStencil);
+
+	virtual void BeginFrame();
+
+	virtual RenderBuffer CreateBuffer(const RenderBufferDesc& desc, const void* data);
+	virtual void ReleaseBuffer(RenderBuffer buffer);
+	virtual void UpdateBuffer(RenderBuffer buffer, const void* data, int bytes);
+
+	virtual RenderTexture CreateTexture(const RenderTextureDesc& desc, const void* data, int rowBytes);
+	virtual void ReleaseTexture(RenderTexture texture);
+	virtual void UpdateTexture(RenderTexture texture, const void* data, int rowBytes, int rows);
+	virtual void CopyTexture(RenderTexture destination, RenderTexture source);
+	virtual RenderShaderView LoadTexture(const char* filename);
+	virtual RenderShaderView CreateShaderView(RenderTexture texture, RenderViewType type);
+	virtual RenderTargetView CreateRenderTargetView(RenderTexture texture, int firstSlice, int numSlices);
+	virtual RenderDepthView CreateDepthView(RenderTexture texture, int firstSlice, int numSlices);
+	virtual void ReleaseShaderView(RenderShaderView view);
+	virtual void ReleaseRenderTargetView(RenderTargetView view);
+	virtual void ReleaseDepthView(RenderDepthView view);
+	virtual void GenerateMips(RenderShaderView view);
+	virtual RenderTargetView GetBackBuffer();
+	virtual RenderDepthView GetBackBufferDepth();
+
+	virtual RenderEffect CreateEffect(const char* filename);
+	virtual void ReleaseEffect(RenderEffect effect);
+	virtual RenderTechnique GetTechnique(RenderEffect effect, const char* name);
+	virtual int GetPassCount(RenderTechnique technique);
+	virtual RenderPass GetPass(RenderTechnique technique, int index);
+	virtual RenderVariable GetVariable(RenderEffect effect, const char* name);
+	virtual void SetMatrix(RenderVariable variable, const float* matrix);
+	virtual void SetMatrixArray(RenderVariable variable, const float* matrices, int first, int count);
+	virtual void SetFloatVector(RenderVariable variable, const float* vector);
+	virtual void SetFloatVectorArray(RenderVariable variable, const float* vectors, int first, int count);
+	virtual void SetFloat(RenderVariable variable, float value);
+	virtual void SetInt(RenderVariable variable, int value);
+	virtual void SetBool(RenderVariable variable, bool value);
+	virtual void SetShaderView(RenderVariable variable, RenderShaderView view);
+	virtual RenderInputLayout CreateInputLayout(const RenderVertexElement* elements, int count, RenderPass pass);
+	virtual void ReleaseInputLayout(RenderInputLayout layout);
+
+	virtual RenderQuery CreateQuery(RenderQueryType type);
+	virtual void ReleaseQuery(RenderQuery query);
+	virtual void BeginQuery(RenderQuery query);
+	virtual void EndQuery(RenderQuery query);
+	virtual bool GetTimestamp(RenderQuery query, UINT64& timestamp);
+	virtual bool GetTimestampFrequency(RenderQuery query, UINT64& frequency, bool& disjoint);
+	virtual bool GetPipelineStatistics(RenderQuery query, RenderPipelineStatistics& statistics);
+
+	virtual void SetInputLayout(RenderInputLayout layout);
+	virtual void SetPrimitiveTopology(RenderTopology topology);
+	virtual void SetVertexBuffer(RenderBuffer buffer, UINT stride);
+	virtual void SetIndexBuffer(RenderBuffer buffer, RenderFormat format);
+	virtual void ApplyPass(RenderPass pass);
+
+	virtual void SetRenderTargets(int count, const RenderTargetView* renderTargets, RenderDepthView depthStencil);
+	virtual void SetViewport(const RenderViewport& viewport);
+	virtual void UnbindShaderResources();
+	virtual void ClearRenderTarget(RenderTargetView renderTarget, const float color[4]);
+	virtual void ClearDepthStencil(RenderDepthView depthStencil);
+
+	virtual void Draw(UINT vertexCount, UINT startVertex);
+	virtual void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex);
+
+private:
+	ID3D10Device*					mDevice;
+	std::vector<ID3D10Buffer*>		mBuffers;				// NULL in the free slots
+	std::vector<RenderBuffer>		mFreeBuffers;
+	ID3D10RenderTargetView*			mBackBuffer;			// Owned by the application
+	ID3D10DepthStencilView*			mBackBufferDepth;
+
+	D3D10RenderDevice(const D3D10RenderDevice&);
+	D3D10RenderDevice& operator=(const D3D10RenderDevice&);
+
+	ID3D10Buffer* GetBuffer(RenderBuffer buffer) const;
+};
+#endif
@@ -0,0 +1,80 @@
+#include "DepthUpload.h"
+
+const char* DepthUpload::C_FILENAME = "DepthUpload.fx";
+
+DepthUpload::DepthUpload()
+	: mDevice(0), mEffect(0), mTechnique(0), mfxDepthMap(0), mTexture(0), mSRV(0), mSize(0)
+{
+}
+
+DepthUpload::~DepthUpload()
+{
+	if(mDevice == NULL)
+		return;
+
+	ReleaseTexture();
+	mDevice->ReleaseEffect(mEffect);
+}
+
+void DepthUpload::Initialize(RenderDevice* device)
+{
+	mDevice = device;
+
+	mEffect = mDevice->CreateEffect(C_FILENAME);
+	if(mEffect == NULL)
+		return;
+
+	mTechnique = mDevice->GetTechnique(mEffect, "WriteDepthTechnique");
+	mfxDepthMap = mDevice->GetVariable(mEffect, "gDepthMap");
+}
+
+// Write a square of depth values, row 0 at the top, into the bound depth stencil view and viewport
+void DepthUpload::Upload(const float* depth, int size)
+{
+	if(mEffect == NULL || (size != mSize && !CreateTexture(size)))
+		return;
+
+	mDevice->UpdateTexture(mTexture, depth, size * sizeof(float), size);
+
+	mDevice->SetInputLayout(NULL);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+	mDevice->SetShaderView(mfxDepthMap, mSRV);
+	mDevice->ApplyPass(mDevice->GetPass(mTechnique, 0));
+	mDevice->Draw(3, 0);
+
+	mDevice->SetShaderView(mfxDepthMap, NULL);
+	mDevice->ApplyPass(mDevice->GetPass(mTechnique, 0));
+}
+
+// A float texture the CPU writes every upload, made again when the size changes
+bool DepthUpload::CreateTexture(int size)
+{
+	ReleaseTexture();
+
+	RenderTextureDesc textureDesc(size, size, 1, RenderFormatR32Float, RenderBindShaderResource, RenderUsageDynamic);
+	mTexture = mDevice->CreateTexture(textureDesc, NULL, 0);
+	if(mTexture == NULL)
+	{
+		MessageBox(0, "Texture creation failed: Depth upload!", "ERROR", 0);
+		return false;
+	}
+
+	mSRV = mDevice->CreateShaderView(mTexture, RenderViewTexture2D);
+	if(mSRV == NULL)
+	{
+		ReleaseTexture();
+		return false;
+	}
+
+	mSize = size;
+	return true;
+}
+
+void DepthUpload::ReleaseTexture()
+{
+	mDevice->ReleaseShaderView(mSRV);
+	mDevice->ReleaseTexture(mTexture);
+	mSRV = NULL;
+	mTexture = NULL;
+	mSize = 0;
+}
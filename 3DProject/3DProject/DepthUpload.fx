@@ -0,0 +1,49 @@
+// Writes a texture of depth values into the bound depth stencil view, one texel per pixel. The
+// triangle covers the viewport and the depth test always passes.
+
+Texture2D<float> gDepthMap;
+
+RasterizerState NoCulling
+{
+	CullMode = None;
+};
+
+DepthStencilState WriteDepthAlways
+{
+	DepthEnable = TRUE;
+	DepthWriteMask = ALL;
+	DepthFunc = ALWAYS;
+};
+
+// ************************************************************************
+// ** SHADER FUNCTIONS
+// ************************************************************************
+
+// Same as VS in ShadowAtlas.fx
+float4 VS(uint vertexID : SV_VertexID) : SV_POSITION
+{
+	float2 uv = float2((vertexID << 1) & 2, vertexID & 2);
+	return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 1.0f, 1.0f);
+}
+
+float PS(float4 position : SV_POSITION) : SV_Depth
+{
+	return gDepthMap.Load(int3(position.xy, 0));
+}
+
+// ************************************************************************
+// ** TECHNIQUES
+// ************************************************************************
+
+technique10 WriteDepthTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS()));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(WriteDepthAlways, 0);
+	}
+}
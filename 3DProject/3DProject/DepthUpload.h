@@ -0,0 +1,37 @@
+#ifndef DEPTH_UPLOAD_H
+#define DEPTH_UPLOAD_H
+
+#include <D3DX10.h>
+#include "Globals.h"
+#include "RenderDevice.h"
+
+// Writes depth from the CPU into the bound depth stencil view. A depth texture cannot be mapped or
+// updated, so the values go through a dynamic float texture and a triangle that covers the viewport
+// writes each texel as its pixel's depth.
+class DepthUpload
+{
+public:
+	DepthUpload();
+	~DepthUpload();
+	void Initialize(RenderDevice* device);
+	void Upload(const float* depth, int size);
+
+private:
+	RenderDevice*							mDevice;
+	RenderEffect							mEffect;
+	RenderTechnique							mTechnique;
+	RenderVariable							mfxDepthMap;
+
+	RenderTexture							mTexture;
+	RenderShaderView						mSRV;
+	int										mSize;
+
+	static const char*			C_FILENAME;
+
+	DepthUpload(const DepthUpload&);
+	DepthUpload& operator=(const DepthUpload&);
+
+	bool CreateTexture(int size);
+	void ReleaseTexture();
+};
+#endif
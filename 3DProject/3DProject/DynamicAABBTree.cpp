@@ -0,0 +1,763 @@
+#include "DynamicAABBTree.h"
+#include "TraversalStack.h"
+#include <algorithm>
+
+namespace
+{
+	const float C_REBUILD_RATIO = 1.5f;		// Rebuild when the cost has grown this much since the last build
+	const int C_SAH_BINS = 16;
+	const int C_MAX_SAH_DEPTH = 64;			// Below this depth ranges are split at the median
+
+	struct FrustumEntry
+	{
+		int					Node;
+		int					PlaneMask;			// Planes the node is not known to be inside of
+	};
+
+	// Orders build entries by their centroid along one axis
+	template<typename T>
+	struct CentroidLess
+	{
+		int					Axis;
+
+		explicit CentroidLess(int axis) : Axis(axis) {}
+
+		bool operator()(const T& a, const T& b) const
+		{
+			return a.Centroid[Axis] < b.Centroid[Axis];
+		}
+	};
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin)
+	: mRoot(C_NULL_NODE), mFreeNode(C_NULL_NODE), mFreeProxy(C_NULL_NODE), mProxyCount(0), mMargin(margin),
+	  mBuildCost(0.0f), mRebuildCount(0), mOrdered(true)
+{
+}
+
+// Add an object and insert its leaf where it increases the surface area of the tree the least
+int DynamicAABBTree::CreateProxy(const AABB& bounds, int userData)
+{
+	int proxy = AllocateProxy(userData);
+	int leaf = AllocateNode();
+
+	D3DXVECTOR3 margin(mMargin, mMargin, mMargin);
+	mNodes[leaf].Bounds = AABB(bounds.Min - margin, bounds.Max + margin);
+	mNodes[leaf].Proxy = proxy;
+	mProxies[proxy].Node = leaf;
+
+	InsertLeaf(leaf);
+	return proxy;
+}
+
+// Add many objects at once and build the tree from scratch, which is both faster and gives a better
+// tree than inserting them one by one
+void DynamicAABBTree::CreateProxies(const AABB* bounds, const int* userData, int count, int* proxies)
+{
+	D3DXVECTOR3 margin(mMargin, mMargin, mMargin);
+
+	for(int i = 0; i < count; ++i)
+	{
+		int proxy = AllocateProxy(userData[i]);
+		int leaf = AllocateNode();
+
+		mNodes[leaf].Bounds = AABB(bounds[i].Min - margin, bounds[i].Max + margin);
+		mNodes[leaf].Proxy = proxy;
+		mProxies[proxy].Node = leaf;
+
+		if(proxies != NULL)
+			proxies[i] = proxy;
+	}
+
+	Rebuild();
+}
+
+void DynamicAABBTree::DestroyProxy(int proxy)
+{
+	int leaf = mProxies[proxy].Node;
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+
+	mProxies[proxy].Node = C_NULL_NODE;
+	mProxies[proxy].NextFree = mFreeProxy;
+	mFreeProxy = proxy;
+	--mProxyCount;
+}
+
+// Give a proxy new bounds. Nothing happens while the bounds stay inside the fat box of the leaf,
+// otherwise the leaf gets a new fat box and true is returned. The boxes above the leaf are not
+// touched, so Refit must be called after moving proxies and before querying the tree. Different
+// proxies may be moved from different threads at the same time.
+bool DynamicAABBTree::MoveProxy(int proxy, const AABB& bounds)
+{
+	Node& leaf = mNodes[mProxies[proxy].Node];
+	if(Contains(leaf.Bounds, bounds))
+		return false;
+
+	D3DXVECTOR3 margin(mMargin, mMargin, mMargin);
+	leaf.Bounds = AABB(bounds.Min - margin, bounds.Max + margin);
+	return true;
+}
+
+void DynamicAABBTree::Clear()
+{
+	mNodes.clear();
+	mProxies.clear();
+	mRoot = C_NULL_NODE;
+	mFreeNode = C_NULL_NODE;
+	mFreeProxy = C_NULL_NODE;
+	mProxyCount = 0;
+	mBuildCost = 0.0f;
+	mOrdered = true;
+}
+
+// Recompute the boxes of all inner nodes from their children
+void DynamicAABBTree::Refit()
+{
+	if(mRoot == C_NULL_NODE)
+		return;
+
+	if(mOrdered)
+	{
+		// Children always come after their parent, so walking backwards visits them first
+		for(int i = (int)mNodes.size() - 1; i >= 0; --i)
+		{
+			Node& node = mNodes[i];
+			if(!node.IsLeaf())
+				node.Bounds = Union(mNodes[node.Left].Bounds, mNodes[node.Right].Bounds);
+		}
+
+		return;
+	}
+
+	// Collect the inner nodes top-down and refit them in the reverse order
+	std::vector<int> order;
+	order.reserve(mNodes.size() / 2 + 1);
+
+	TraversalStack<int> stack;
+	stack.Push(mRoot);
+	while(!stack.IsEmpty())
+	{
+		int index = stack.Pop();
+		const Node& node = mNodes[index];
+		if(node.IsLeaf())
+			continue;
+
+		order.push_back(index);
+		stack.Push(node.Left);
+		stack.Push(node.Right);
+	}
+
+	for(int i = (int)order.size() - 1; i >= 0; --i)
+	{
+		Node& node = mNodes[order[i]];
+		node.Bounds = Union(mNodes[node.Left].Bounds, mNodes[node.Right].Bounds);
+	}
+}
+
+// Rebuild the tree if its cost has grown too much since the last build, returns true if it was rebuilt.
+// The rebuild is of the whole tree, see the class comment for what that costs.
+bool DynamicAABBTree::Optimize()
+{
+	if(mProxyCount < 2 || GetCost() <= mBuildCost * C_REBUILD_RATIO)
+		return false;
+
+	Rebuild();
+	return true;
+}
+
+// Build the tree top-down from all proxies, splitting every range where the binned surface area
+// heuristic says it is cheapest
+void DynamicAABBTree::Rebuild()
+{
+	std::vector<BuildLeaf> leaves;
+	leaves.reserve(mProxyCount);
+
+	for(int i = 0; i < (int)mProxies.size(); ++i)
+	{
+		if(mProxies[i].Node == C_NULL_NODE)
+			continue;
+
+		BuildLeaf leaf;
+		leaf.Bounds = mNodes[mProxies[i].Node].Bounds;
+		leaf.Centroid = leaf.Bounds.GetCenter();
+		leaf.Proxy = i;
+		leaves.push_back(leaf);
+	}
+
+	mNodes.clear();
+	mFreeNode = C_NULL_NODE;
+	mRoot = C_NULL_NODE;
+	mOrdered = true;
+
+	if(!leaves.empty())
+	{
+		mNodes.reserve(leaves.size() * 2 - 1);
+		mRoot = BuildRange(leaves, 0, (int)leaves.size(), C_NULL_NODE, 0);
+	}
+
+	mBuildCost = GetCost();
+	++mRebuildCount;
+}
+
+// Find the proxies whose boxes intersect the frustum. Planes that a node is completely inside of are
+// not tested again for its children, and when no planes are left the whole subtree is taken as is.
+int DynamicAABBTree::QueryFrustum(const FrustumPlanes& frustum, std::vector<int>& results) const
+{
+	int numFound = (int)results.size();
+	if(mRoot == C_NULL_NODE)
+		return 0;
+
+	const int allPlanes = (1 << FrustumPlanes::PlaneCount) - 1;
+
+	TraversalStack<FrustumEntry> stack;
+	FrustumEntry entry = { mRoot, allPlanes };
+	stack.Push(entry);
+
+	while(!stack.IsEmpty())
+	{
+		entry = stack.Pop();
+		const Node& node = mNodes[entry.Node];
+
+		D3DXVECTOR3 center = node.Bounds.GetCenter();
+		D3DXVECTOR3 extents = node.Bounds.GetExtents();
+
+		bool outside = false;
+		for(int i = 0; i < FrustumPlanes::PlaneCount && !outside; ++i)
+		{
+			if((entry.PlaneMask & (1 << i)) == 0)
+				continue;
+
+			const D3DXPLANE& p = frustum.Planes[i];
+			float distance = p.a * center.x + p.b * center.y + p.c * center.z + p.d;
+			float radius = std::abs(p.a) * extents.x + std::abs(p.b) * extents.y + std::abs(p.c) * extents.z;
+
+			if(distance < -radius)
+				outside = true;
+			else if(distance >= radius)
+				entry.PlaneMask &= ~(1 << i);
+		}
+
+		if(outside)
+			continue;
+
+		if(node.IsLeaf())
+			results.push_back(mProxies[node.Proxy].UserData);
+		else if(entry.PlaneMask == 0)
+			CollectLeaves(entry.Node, results);
+		else
+		{
+			FrustumEntry child = { node.Right, entry.PlaneMask };
+			stack.Push(child);
+			child.Node = node.Left;
+			stack.Push(child);
+		}
+	}
+
+	return (int)results.size() - numFound;
+}
+
+int DynamicAABBTree::QuerySphere(const BoundingSphere& sphere, std::vector<int>& results) const
+{
+	int numFound = (int)results.size();
+	if(mRoot == C_NULL_NODE)
+		return 0;
+
+	float radiusSquared = sphere.Radius * sphere.Radius;
+
+	TraversalStack<int> stack;
+	stack.Push(mRoot);
+
+	while(!stack.IsEmpty())
+	{
+		const Node& node = mNodes[stack.Pop()];
+
+		// Squared distance from the sphere center to the closest point of the box
+		float distanceSquared = 0.0f;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			float value = sphere.Center[axis];
+			if(value < node.Bounds.Min[axis])
+				distanceSquared += (node.Bounds.Min[axis] - value) * (node.Bounds.Min[axis] - value);
+			else if(value > node.Bounds.Max[axis])
+				distanceSquared += (value - node.Bounds.Max[axis]) * (value - node.Bounds.Max[axis]);
+		}
+
+		if(distanceSquared > radiusSquared)
+			continue;
+
+		if(node.IsLeaf())
+			results.push_back(mProxies[node.Proxy].UserData);
+		else
+		{
+			stack.Push(node.Right);
+			stack.Push(node.Left);
+		}
+	}
+
+	return (int)results.size() - numFound;
+}
+
+int DynamicAABBTree::QueryBox(const AABB& box, std::vector<int>& results) const
+{
+	int numFound = (int)results.size();
+	if(mRoot == C_NULL_NODE)
+		return 0;
+
+	TraversalStack<int> stack;
+	stack.Push(mRoot);
+
+	while(!stack.IsEmpty())
+	{
+		const Node& node = mNodes[stack.Pop()];
+		if(!Overlaps(node.Bounds, box))
+			continue;
+
+		if(node.IsLeaf())
+			results.push_back(mProxies[node.Proxy].UserData);
+		else
+		{
+			stack.Push(node.Right);
+			stack.Push(node.Left);
+		}
+	}
+
+	return (int)results.size() - numFound;
+}
+
+// Find the proxies whose boxes are hit by the ray within maxDistance. The direction does not have to
+// be normalized, maxDistance is then measured in lengths of it.
+int DynamicAABBTree::QueryRay(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance,
+							  std::vector<int>& results) const
+{
+	int numFound = (int)results.size();
+	if(mRoot == C_NULL_NODE)
+		return 0;
+
+	// Divisions by zero give infinities, which the slab test handles
+	D3DXVECTOR3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	TraversalStack<int> stack;
+	stack.Push(mRoot);
+
+	while(!stack.IsEmpty())
+	{
+		const Node& node = mNodes[stack.Pop()];
+
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			float t0 = (node.Bounds.Min[axis] - origin[axis]) * inverse[axis];
+			float t1 = (node.Bounds.Max[axis] - origin[axis]) * inverse[axis];
+			if(t0 > t1)
+				std::swap(t0, t1);
+
+			tMin = t0 > tMin ? t0 : tMin;
+			tMax = t1 < tMax ? t1 : tMax;
+		}
+
+		if(tMin > tMax)
+			continue;
+
+		if(node.IsLeaf())
+			results.push_back(mProxies[node.Proxy].UserData);
+		else
+		{
+			stack.Push(node.Right);
+			stack.Push(node.Left);
+		}
+	}
+
+	return (int)results.size() - numFound;
+}
+
+int DynamicAABBTree::GetUserData(int proxy) const
+{
+	return mProxies[proxy].UserData;
+}
+
+const AABB& DynamicAABBTree::GetFatBounds(int proxy) const
+{
+	return mNodes[mProxies[proxy].Node].Bounds;
+}
+
+int DynamicAABBTree::GetProxyCount() const
+{
+	return mProxyCount;
+}
+
+int DynamicAABBTree::GetNodeCount() const
+{
+	return mProxyCount > 0 ? mProxyCount * 2 - 1 : 0;
+}
+
+int DynamicAABBTree::GetHeight() const
+{
+	return GetHeight(mRoot);
+}
+
+// Surface area heuristic cost: the summed area of all inner nodes relative to the root, which is
+// proportional to the expected number of inner nodes a random ray or small box has to visit
+float DynamicAABBTree::GetCost() const
+{
+	if(mRoot == C_NULL_NODE)
+		return 0.0f;
+
+	float rootArea = Area(mNodes[mRoot].Bounds);
+	if(rootArea <= 0.0f)
+		return 0.0f;
+
+	float area = 0.0f;
+	for(size_t i = 0; i < mNodes.size(); ++i)
+	{
+		const Node& node = mNodes[i];
+		if(!node.IsLeaf() && node.Left != node.Right)
+			area += Area(node.Bounds);
+	}
+
+	return area / rootArea;
+}
+
+int DynamicAABBTree::GetRebuildCount() const
+{
+	return mRebuildCount;
+}
+
+int DynamicAABBTree::AllocateNode()
+{
+	int index;
+	if(mFreeNode != C_NULL_NODE)
+	{
+		index = mFreeNode;
+		mFreeNode = mNodes[index].Parent;
+	}
+	else
+	{
+		index = (int)mNodes.size();
+		mNodes.push_back(Node());
+	}
+
+	Node& node = mNodes[index];
+	node.Parent = C_NULL_NODE;
+	node.Left = C_NULL_NODE;
+	node.Right = C_NULL_NODE;
+	node.Proxy = C_NULL_NODE;
+
+	return index;
+}
+
+// Free nodes are marked by having both children set to themselves, so GetCost can skip them
+void DynamicAABBTree::FreeNode(int node)
+{
+	mNodes[node].Parent = mFreeNode;
+	mNodes[node].Left = node;
+	mNodes[node].Right = node;
+	mFreeNode = node;
+	mOrdered = false;
+}
+
+int DynamicAABBTree::AllocateProxy(int userData)
+{
+	int index;
+	if(mFreeProxy != C_NULL_NODE)
+	{
+		index = mFreeProxy;
+		mFreeProxy = mProxies[index].NextFree;
+	}
+	else
+	{
+		index = (int)mProxies.size();
+		mProxies.push_back(Proxy());
+	}
+
+	mProxies[index].Node = C_NULL_NODE;
+	mProxies[index].UserData = userData;
+	mProxies[index].NextFree = C_NULL_NODE;
+	++mProxyCount;
+
+	return index;
+}
+
+// Walk down from the root towards the child whose box grows the least, and stop where pairing the
+// leaf with the current node is cheaper than going further down (Catto's heuristic from Box2D)
+void DynamicAABBTree::InsertLeaf(int leaf)
+{
+	mOrdered = false;
+
+	if(mRoot == C_NULL_NODE)
+	{
+		mRoot = leaf;
+		mNodes[leaf].Parent = C_NULL_NODE;
+		return;
+	}
+
+	AABB leafBounds = mNodes[leaf].Bounds;
+	int index = mRoot;
+	while(!mNodes[index].IsLeaf())
+	{
+		const Node& node = mNodes[index];
+		float area = Area(node.Bounds);
+		float combinedArea = Area(Union(node.Bounds, leafBounds));
+
+		// Cost of a new parent for this node and the leaf, and the growth pushed onto the ancestors
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.Left, node.Right };
+		for(int i = 0; i < 2; ++i)
+		{
+			const Node& child = mNodes[children[i]];
+			float newArea = Area(Union(leafBounds, child.Bounds));
+			if(child.IsLeaf())
+				childCost[i] = newArea + inheritanceCost;
+			else
+				childCost[i] = newArea - Area(child.Bounds) + inheritanceCost;
+		}
+
+		if(cost < childCost[0] && cost < childCost[1])
+			break;
+
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+	int oldParent = mNodes[sibling].Parent;
+	int newParent = AllocateNode();
+	mNodes[newParent].Parent = oldParent;
+	mNodes[newParent].Bounds = Union(leafBounds, mNodes[sibling].Bounds);
+	mNodes[newParent].Left = sibling;
+	mNodes[newParent].Right = leaf;
+	mNodes[sibling].Parent = newParent;
+	mNodes[leaf].Parent = newParent;
+
+	if(oldParent == C_NULL_NODE)
+		mRoot = newParent;
+	else if(mNodes[oldParent].Left == sibling)
+		mNodes[oldParent].Left = newParent;
+	else
+		mNodes[oldParent].Right = newParent;
+
+	RefitAncestors(oldParent);
+}
+
+// Unlink the leaf and replace its parent with its sibling
+void DynamicAABBTree::RemoveLeaf(int leaf)
+{
+	mOrdered = false;
+
+	if(leaf == mRoot)
+	{
+		mRoot = C_NULL_NODE;
+		return;
+	}
+
+	int parent = mNodes[leaf].Parent;
+	if(parent == C_NULL_NODE)
+		return;
+
+	int grandParent = mNodes[parent].Parent;
+	int sibling = mNodes[parent].Left == leaf ? mNodes[parent].Right : mNodes[parent].Left;
+
+	if(grandParent == C_NULL_NODE)
+	{
+		mRoot = sibling;
+		mNodes[sibling].Parent = C_NULL_NODE;
+	}
+	else
+	{
+		if(mNodes[grandParent].Left == parent)
+			mNodes[grandParent].Left = sibling;
+		else
+			mNodes[grandParent].Right = sibling;
+
+		mNodes[sibling].Parent = grandParent;
+		RefitAncestors(grandParent);
+	}
+
+	FreeNode(parent);
+	mNodes[leaf].Parent = C_NULL_NODE;
+}
+
+void DynamicAABBTree::RefitAncestors(int node)
+{
+	while(node != C_NULL_NODE)
+	{
+		Node& current = mNodes[node];
+		current.Bounds = Union(mNodes[current.Left].Bounds, mNodes[current.Right].Bounds);
+		node = current.Parent;
+	}
+}
+
+// Build the subtree for leaves [first, first + count) and return its root. The node is allocated
+// before its children, which gives the depth first layout.
+int DynamicAABBTree::BuildRange(std::vector<BuildLeaf>& leaves, int first, int count, int parent, int depth)
+{
+	int index = (int)mNodes.size();
+	mNodes.push_back(Node());
+	mNodes[index].Parent = parent;
+	mNodes[index].Proxy = C_NULL_NODE;
+
+	if(count == 1)
+	{
+		const BuildLeaf& leaf = leaves[first];
+		mNodes[index].Bounds = leaf.Bounds;
+		mNodes[index].Left = C_NULL_NODE;
+		mNodes[index].Right = C_NULL_NODE;
+		mNodes[index].Proxy = leaf.Proxy;
+		mProxies[leaf.Proxy].Node = index;
+		return index;
+	}
+
+	AABB bounds;
+	AABB centroidBounds;
+	for(int i = first; i < first + count; ++i)
+	{
+		bounds.Expand(leaves[i].Bounds);
+		centroidBounds.Expand(leaves[i].Centroid);
+	}
+
+	D3DXVECTOR3 size = centroidBounds.Max - centroidBounds.Min;
+	int axis = 0;
+	if(size.y > size[axis])
+		axis = 1;
+	if(size.z > size[axis])
+		axis = 2;
+
+	int middle = -1;
+
+	if(size[axis] > 0.0f && depth < C_MAX_SAH_DEPTH)
+	{
+		// Sort the centroids into bins and find the bin boundary with the lowest cost
+		int binCounts[C_SAH_BINS] = { 0 };
+		AABB binBounds[C_SAH_BINS];
+		float scale = C_SAH_BINS * 0.9999f / size[axis];
+
+		for(int i = first; i < first + count; ++i)
+		{
+			int bin = (int)((leaves[i].Centroid[axis] - centroidBounds.Min[axis]) * scale);
+			++binCounts[bin];
+			binBounds[bin].Expand(leaves[i].Bounds);
+		}
+
+		float rightArea[C_SAH_BINS];
+		int rightCount[C_SAH_BINS];
+		AABB accumulated;
+		int accumulatedCount = 0;
+		for(int i = C_SAH_BINS - 1; i > 0; --i)
+		{
+			accumulated.Expand(binBounds[i]);
+			accumulatedCount += binCounts[i];
+			rightArea[i] = accumulatedCount > 0 ? Area(accumulated) : 0.0f;
+			rightCount[i] = accumulatedCount;
+		}
+
+		int bestSplit = -1;
+		float bestCost = FLT_MAX;
+		accumulated = AABB();
+		accumulatedCount = 0;
+		for(int i = 1; i < C_SAH_BINS; ++i)
+		{
+			accumulated.Expand(binBounds[i - 1]);
+			accumulatedCount += binCounts[i - 1];
+			if(accumulatedCount == 0 || rightCount[i] == 0)
+				continue;
+
+			float cost = Area(accumulated) * accumulatedCount + rightArea[i] * rightCount[i];
+			if(cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if(bestSplit > 0)
+		{
+			int left = first;
+			int right = first + count - 1;
+			while(left <= right)
+			{
+				int bin = (int)((leaves[left].Centroid[axis] - centroidBounds.Min[axis]) * scale);
+				if(bin < bestSplit)
+					++left;
+				else
+					std::swap(leaves[left], leaves[right--]);
+			}
+
+			middle = left;
+		}
+	}
+
+	// Below the SAH depth, or when no bin boundary splits the range, split at the median centroid
+	if(middle < 0)
+	{
+		middle = first + count / 2;
+		std::nth_element(leaves.begin() + first, leaves.begin() + middle, leaves.begin() + first + count,
+						 CentroidLess<BuildLeaf>(axis));
+	}
+
+	int leftChild = BuildRange(leaves, first, middle - first, index, depth + 1);
+	int rightChild = BuildRange(leaves, middle, first + count - middle, index, depth + 1);
+
+	mNodes[index].Bounds = bounds;
+	mNodes[index].Left = leftChild;
+	mNodes[index].Right = rightChild;
+
+	return index;
+}
+
+void DynamicAABBTree::CollectLeaves(int root, std::vector<int>& results) const
+{
+	TraversalStack<int> stack;
+	stack.Push(root);
+
+	while(!stack.IsEmpty())
+	{
+		const Node& node = mNodes[stack.Pop()];
+		if(node.IsLeaf())
+			results.push_back(mProxies[node.Proxy].UserData);
+		else
+		{
+			stack.Push(node.Right);
+			stack.Push(node.Left);
+		}
+	}
+}
+
+int DynamicAABBTree::GetHeight(int node) const
+{
+	if(node == C_NULL_NODE || mNodes[node].IsLeaf())
+		return 0;
+
+	int left = GetHeight(mNodes[node].Left);
+	int right = GetHeight(mNodes[node].Right);
+
+	return 1 + (left > right ? left : right);
+}
+
+// Half the surface area, which is all the cost comparisons need
+float DynamicAABBTree::Area(const AABB& box)
+{
+	D3DXVECTOR3 size = box.Max - box.Min;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+AABB DynamicAABBTree::Union(const AABB& a, const AABB& b)
+{
+	AABB result = a;
+	result.Expand(b);
+	return result;
+}
+
+bool DynamicAABBTree::Contains(const AABB& outer, const AABB& inner)
+{
+	return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y && outer.Min.z <= inner.Min.z &&
+		   outer.Max.x >= inner.Max.x && outer.Max.y >= inner.Max.y && outer.Max.z >= inner.Max.z;
+}
+
+bool DynamicAABBTree::Overlaps(const AABB& a, const AABB& b)
+{
+	return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x && a.Min.y <= b.Max.y && a.Max.y >= b.Min.y &&
+		   a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+}
@@ -0,0 +1,107 @@
+#ifndef DYNAMIC_AABB_TREE_H
+#define DYNAMIC_AABB_TREE_H
+
+#include <vector>
+#include <D3DX10.h>
+
+#include "BoundingVolumes.h"
+#include "FrustumPlanes.h"
+
+// Bounding volume hierarchy over objects that are added, removed and moved at runtime. Every object
+// gets a proxy, a leaf whose box is the object's box grown by a margin so that small movements do not
+// touch the tree at all. Moved proxies only refit the boxes above them; when the surface area cost of
+// the tree has grown too much compared to the last build it is rebuilt top-down with binned SAH.
+//
+// That rebuild is of the whole tree and O(n log n): about 800 ms for a million proxies on one core,
+// against 85 ms for moving and refitting them all. It is not done incrementally. Objects that move
+// independently spread the leaves of every subtree over the world, so local fixes such as tree
+// rotations do little: rotating before each rebuild only saved one rebuild in seven.
+//
+// After a rebuild the nodes are stored in depth first order, so a parent always comes before its
+// children and the first child directly after its parent. Refits can then be done with one backwards
+// sweep over the node array.
+class DynamicAABBTree
+{
+public:
+	DynamicAABBTree(float margin = 0.0f);
+
+	int CreateProxy(const AABB& bounds, int userData);
+	void CreateProxies(const AABB* bounds, const int* userData, int count, int* proxies);
+	void DestroyProxy(int proxy);
+	bool MoveProxy(int proxy, const AABB& bounds);
+	void Clear();
+
+	void Refit();
+	bool Optimize();
+	void Rebuild();
+
+	int QueryFrustum(const FrustumPlanes& frustum, std::vector<int>& results) const;
+	int QuerySphere(const BoundingSphere& sphere, std::vector<int>& results) const;
+	int QueryBox(const AABB& box, std::vector<int>& results) const;
+	int QueryRay(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance,
+				 std::vector<int>& results) const;
+
+	int GetUserData(int proxy) const;
+	const AABB& GetFatBounds(int proxy) const;
+	int GetProxyCount() const;
+	int GetNodeCount() const;
+	int GetHeight() const;
+	float GetCost() const;
+	int GetRebuildCount() const;
+
+	static const int C_NULL_NODE = -1;
+
+private:
+	// 40 bytes. Leaves have Left == C_NULL_NODE and use Proxy, free nodes chain through Parent.
+	struct Node
+	{
+		AABB				Bounds;
+		int					Parent;
+		int					Left;
+		int					Right;
+		int					Proxy;
+
+		bool IsLeaf() const { return Left == C_NULL_NODE; }
+	};
+
+	struct Proxy
+	{
+		int					Node;
+		int					UserData;
+		int					NextFree;			// Only used while the proxy is free
+	};
+
+	struct BuildLeaf
+	{
+		D3DXVECTOR3			Centroid;
+		AABB				Bounds;
+		int					Proxy;
+	};
+
+	std::vector<Node>		mNodes;
+	std::vector<Proxy>		mProxies;
+	int						mRoot;
+	int						mFreeNode;
+	int						mFreeProxy;
+	int						mProxyCount;
+	float					mMargin;
+	float					mBuildCost;			// Cost right after the last rebuild
+	int						mRebuildCount;
+	bool					mOrdered;			// Nodes are in depth first order, see above
+
+	int AllocateNode();
+	void FreeNode(int node);
+	int AllocateProxy(int userData);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	void RefitAncestors(int node);
+	int BuildRange(std::vector<BuildLeaf>& leaves, int first, int count, int parent, int depth);
+	void CollectLeaves(int node, std::vector<int>& results) const;
+	int GetHeight(int node) const;
+
+	static float Area(const AABB& box);
+	static AABB Union(const AABB& a, const AABB& b);
+	static bool Contains(const AABB& outer, const AABB& inner);
+	static bool Overlaps(const AABB& a, const AABB& b);
+};
+#endif
@@ -1,133 +1,279 @@
-struct VS_INPUT
-{
-	float3		position	: POSITION;
-	float3		normal		: NORMAL;
-	float2		uv			: TEXCOORD;
-};
-
-struct PS_INPUT
-{
-	float4		position	: SV_POSITION;
-	float3		positionW	: POSITION;
-	float3		normalW		: NORMAL;
-	float2		uv			: TEXCOORD;
-};
-
-RasterizerState NoCulling
-{
-	CullMode = None;
-	//FillMode = Wireframe;
-};
-
-DepthStencilState EnableDepth
-{
-	DepthEnable = TRUE;
-	DepthWriteMask = ALL;
-	DepthFunc = LESS_EQUAL;
-};
-
-SamplerState linearSampler {
-	Filter = MIN_MAG_MIP_LINEAR;
-	AddressU = Wrap;
-	AddressV = Wrap;
-};
-
-cbuffer cbEveryFrame
-{
-	matrix gWorld;
-	matrix gWVP;
-	float4 gEyePos;
-	float3 gLightPosition;
-};
-
-float3 gKd;
-float3 gKa;
-float3 gKs;
-float gSExp;
-
-Texture2D gTextureBTH;
-bool gDrawLight = true;
-
-// ************************************************************************
-// ** HELPER FUNCTIONS
-// ************************************************************************
-float4 GetColorBasicLight(PS_INPUT input)
-{
-	float3 lightVec = normalize(gLightPosition - input.positionW);
-	float dotProd = dot(lightVec, normalize(input.normalW));
-
-	float4 texColor = gTextureBTH.Sample(linearSampler, input.uv);
-	texColor = texColor * dotProd;
-	return texColor;
-}
-
-float4 GetColorLight(PS_INPUT input)
-{
-	float3 lightDiffuse = float3(0.8f, 0.8f, 0.8f);
-	float3 lightAmbient = float3(1.0f, 0.0f, 0.0f);
-	float3 lightSpecular = float3(1.0f, 1.0f, 1.0f);
-
-	float3 lightVec = normalize(gLightPosition - input.positionW);
-	float dotLN = dot(lightVec, normalize(input.normalW));
-	
-	float constD = max(dotLN, 0.0f);
-	float constS = 0.0f;
-	float3 toEye = normalize(gEyePos - input.positionW);
-
-	if(dotLN > 0.0f)
-	{
-		float3 reflectLight = reflect(-lightVec, input.normalW);
-		constS = pow(max(dot(reflectLight, toEye), 0.0f), gSExp);
-	}
-
-	float3 diffuseCol = lightDiffuse * gKd * constD;
-	float3 ambientCol = lightAmbient * gKa;
-	float3 specularCol = lightSpecular * gKs * constS;
-	
-	float3 lightCol = diffuseCol + ambientCol + specularCol;
-	float4 texColor = gTextureBTH.Sample(linearSampler, input.uv);
-
-	return texColor * float4(lightCol, 1.0f);
-}
-
-// ************************************************************************
-// ** SHADER FUNCTIONS
-// ************************************************************************
-
-PS_INPUT VS(VS_INPUT input)
-{
-	PS_INPUT output;
-
-	output.position = mul(float4(input.position, 1.0), gWVP);
-	output.positionW = mul(float4(input.position, 1.0), gWorld).xyz;
-	output.normalW = mul(float4(input.normal, 0.0), gWorld).xyz;
-	output.uv = input.uv;
-
-	return output;
-}
-
-float4 PS(PS_INPUT input) : SV_Target0
-{
-	if(gDrawLight)
-		return GetColorLight(input);
-	else
-		return GetColorBasicLight(input);
-}
-
-// ************************************************************************
-// ** TECHNIQUES
-// ************************************************************************
-
-technique10 DrawTechnique
-{
-	pass P0
-	{
-		SetVertexShader(CompileShader(vs_4_0, VS()));
-		SetGeometryShader(NULL);
-		SetPixelShader(CompileShader(ps_4_0, PS()));
-
-		SetRasterizerState(NoCulling);
-		SetDepthStencilState(EnableDepth, 0xff);
-	}
-}
-
+struct VS_INPUT
+{
+	float3		position	: POSITION;
+	float3		normal		: NORMAL;
+	float2		uv			: TEXCOORD;
+	float		ao			: AO;
+};
+
+struct PS_INPUT
+{
+	float4		position	: SV_POSITION;
+	float3		positionW	: POSITION;
+	float3		normalW		: NORMAL;
+	float2		uv			: TEXCOORD;
+	float		ao			: AO;
+};
+
+RasterizerState NoCulling
+{
+	CullMode = None;
+	//FillMode = Wireframe;
+};
+
+DepthStencilState EnableDepth
+{
+	DepthEnable = TRUE;
+	DepthWriteMask = ALL;
+	DepthFunc = LESS_EQUAL;
+};
+
+SamplerState linearSampler {
+	Filter = MIN_MAG_MIP_LINEAR;
+	AddressU = Wrap;
+	AddressV = Wrap;
+};
+
+cbuffer cbEveryFrame
+{
+	matrix gWorld;
+	matrix gWVP;
+	float4 gEyePos;
+	float3 gLightPosition;
+};
+
+float3 gKd;
+float3 gKa;
+float3 gKs;
+float gSExp;
+
+Texture2D gTextureBTH;
+Texture2D gShadowMask;					// Filtered in screen space by ShadowMask.fx
+
+// The point light's cube, set by PointShadowEffectVariables
+TextureCube gPointShadowMap;
+float3 gPointLightPosition;
+float2 gPointDepthParams;				// A face's depth is x + y / distance along the face's axis
+float gPointEpsilon = 0.0002f;
+bool gDrawLight = true;
+
+// ************************************************************************
+// ** SHADOW FILTERS
+// ************************************************************************
+
+#include "ShadowFilters.fxh"
+
+// Not a filter: the pixel's texel of the mask that ShadowMask.fx filtered with one of the above
+#define SHADOW_MASK				6
+
+// Not a filter either: one tap into the cube of PointShadowMap, lit from the light's position
+#define SHADOW_POINT			7
+
+SamplerComparisonState pointShadowSampler
+{
+	Filter = COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+	AddressU = Clamp;
+	AddressV = Clamp;
+	AddressW = Clamp;
+	ComparisonFunc = LESS_EQUAL;
+};
+
+// The cube face a direction falls on is the one of its largest component, the depth the face's
+// projection gave the pixel follows from that component alone
+float CalcPointShadowFactor(float3 positionW)
+{
+	float3 fromLight = positionW - gPointLightPosition;
+	float3 distances = abs(fromLight);
+	float faceDistance = max(distances.x, max(distances.y, distances.z));
+	float depth = gPointDepthParams.x + gPointDepthParams.y / faceDistance;
+
+	return gPointShadowMap.SampleCmpLevelZero(pointShadowSampler, fromLight, depth - gPointEpsilon);
+}
+
+// The pixel's shadow, read from the screen-space mask or the point light's cube or filtered here
+float CalcShadowFactor(float3 positionW, float2 screenPosition, uniform int shadowFilter)
+{
+	if(shadowFilter == SHADOW_MASK)
+		return gShadowMask.Load(int3((int2)screenPosition, 0)).r;
+	if(shadowFilter == SHADOW_POINT)
+		return CalcPointShadowFactor(positionW);
+
+	return CalcCascadeShadowFactor(positionW, screenPosition, shadowFilter);
+}
+
+// ************************************************************************
+// ** HELPER FUNCTIONS
+// ************************************************************************
+
+float4 GetColorBasicLight(PS_INPUT input)
+{
+	float3 lightVec = normalize(gLightPosition - input.positionW);
+	float dotProd = dot(lightVec, normalize(input.normalW));
+
+	float4 texColor = gTextureBTH.Sample(linearSampler, input.uv);
+	texColor = texColor * dotProd;
+	return texColor;
+}
+
+float4 GetColorLight(PS_INPUT input, uniform int shadowFilter)
+{
+	float3 lightDiffuse = float3(0.8f, 0.8f, 0.8f);
+	float3 lightAmbient = float3(1.0f, 0.0f, 0.0f);
+	float3 lightSpecular = float3(1.0f, 1.0f, 1.0f);
+
+	float3 lightVec = normalize(gLightPosition - input.positionW);
+	float dotLN = dot(lightVec, normalize(input.normalW));
+	
+	float constD = max(dotLN, 0.0f);
+	float constS = 0.0f;
+	float3 toEye = normalize(gEyePos - input.positionW);
+
+	if(dotLN > 0.0f)
+	{
+		float3 reflectLight = reflect(-lightVec, input.normalW);
+		constS = pow(max(dot(reflectLight, toEye), 0.0f), gSExp);
+	}
+
+	float3 diffuseCol = lightDiffuse * gKd * constD;
+	float3 ambientCol = lightAmbient * gKa * input.ao;
+	float3 specularCol = lightSpecular * gKs * constS;
+	
+	float shadowFactor = CalcShadowFactor(input.positionW, input.position.xy, shadowFilter);
+	float3 lightCol = (diffuseCol + specularCol) * shadowFactor + ambientCol;
+	float4 texColor = gTextureBTH.Sample(linearSampler, input.uv);
+
+	return texColor * float4(lightCol, 1.0f);
+}
+
+// ************************************************************************
+// ** SHADER FUNCTIONS
+// ************************************************************************
+
+PS_INPUT VS(VS_INPUT input)
+{
+	PS_INPUT output;
+
+	output.position = mul(float4(input.position, 1.0), gWVP);
+	output.positionW = mul(float4(input.position, 1.0), gWorld).xyz;
+	output.normalW = mul(float4(input.normal, 0.0), gWorld).xyz;
+	output.uv = input.uv;
+	output.ao = input.ao;
+
+	return output;
+}
+
+float4 PS(PS_INPUT input, uniform int shadowFilter) : SV_Target0
+{
+	if(gDrawLight)
+		return GetColorLight(input, shadowFilter);
+	else
+		return GetColorBasicLight(input);
+}
+
+// ************************************************************************
+// ** TECHNIQUES
+// ************************************************************************
+
+technique10 DrawTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_2X2)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPCF3x3Technique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_3X3)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPCF5x5Technique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_5X5)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPoissonTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_POISSON)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_VSM)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawEVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_EVSM)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawShadowMaskTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_MASK)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPointShadowTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_POINT)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
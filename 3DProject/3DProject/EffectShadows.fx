@@ -1,8 +1,7 @@
+// Only the position is read, so the casters can be drawn from their position streams
 struct VS_INPUT
 {
 	float3		position	: POSITION;
-	float3		normal		: NORMAL;
-	float2		uv			: TEXCOORD;
 };
 
 RasterizerState NoCulling
@@ -11,6 +10,17 @@ RasterizerState NoCulling
 	//FillMode = Wireframe;
 };
 
+// The faces toward the light are culled, so the depth written is that of the far side of a caster
+// and its lit side does not shadow itself. The bias pushes the far side further away where it is
+// seen at a grazing angle.
+RasterizerState CullFrontBiased
+{
+	CullMode = Front;
+	DepthBias = 8;
+	SlopeScaledDepthBias = 2.0f;
+	DepthBiasClamp = 0.01f;
+};
+
 DepthStencilState EnableDepth
 {
 	DepthEnable = TRUE;
@@ -26,18 +36,92 @@ cbuffer cbEveryFrame
 	float3 gLightPosition;
 };
 
+// The faces of a point light's cube, in the order of the cube's slices
+cbuffer cbCube
+{
+	matrix gCubeViewProj[6];
+	int gCubeFaceMask;			// Faces the group may touch, from the culling on the CPU
+};
+
+struct CUBE_GS_INPUT
+{
+	float4		positionW	: POSITION;
+};
+
+struct CUBE_PS_INPUT
+{
+	float4		position	: SV_POSITION;
+	uint		face		: SV_RenderTargetArrayIndex;
+};
+
 // ************************************************************************
 // ** SHADER FUNCTIONS
 // ************************************************************************
 float4 VS(VS_INPUT input) :  SV_POSITION
+{
+	float4 position = mul(float4(input.position, 1.0), gWVP);
+
+	// Casters between the light and the near plane are flattened onto it instead of being clipped,
+	// the light projection is orthographic so w is 1
+	position.z = max(position.z, 0.0);
+
+	return position;
+}
+
+// The camera's depth for the pre-pass of the shadow mask, nothing is flattened
+float4 SceneDepthVS(VS_INPUT input) : SV_POSITION
 {
 	return mul(float4(input.position, 1.0), gWVP);
 }
 
+// World space for the geometry shader, which projects onto each face
+CUBE_GS_INPUT CubeVS(VS_INPUT input)
+{
+	CUBE_GS_INPUT output;
+	output.positionW = mul(float4(input.position, 1.0), gWorld);
+
+	return output;
+}
+
+// Sends the triangle to every face in the mask whose frustum it is not entirely outside of. A
+// triangle is usually on one face, along the edges of the cube on two or three.
+[maxvertexcount(18)]
+void CubeGS(triangle CUBE_GS_INPUT input[3], inout TriangleStream<CUBE_PS_INPUT> stream)
+{
+	[unroll]
+	for(int face = 0; face < 6; ++face)
+	{
+		if((gCubeFaceMask & (1 << face)) == 0)
+			continue;
+
+		float4 p0 = mul(input[0].positionW, gCubeViewProj[face]);
+		float4 p1 = mul(input[1].positionW, gCubeViewProj[face]);
+		float4 p2 = mul(input[2].positionW, gCubeViewProj[face]);
+
+		float3 x = float3(p0.x, p1.x, p2.x);
+		float3 y = float3(p0.y, p1.y, p2.y);
+		float3 z = float3(p0.z, p1.z, p2.z);
+		float3 w = float3(p0.w, p1.w, p2.w);
+		if(all(x > w) || all(x < -w) || all(y > w) || all(y < -w) || all(z < 0.0f) || all(z > w))
+			continue;
+
+		CUBE_PS_INPUT output;
+		output.face = face;
+		output.position = p0;
+		stream.Append(output);
+		output.position = p1;
+		stream.Append(output);
+		output.position = p2;
+		stream.Append(output);
+		stream.RestartStrip();
+	}
+}
+
 // ************************************************************************
 // ** TECHNIQUES
 // ************************************************************************
 
+// Position streams with front faces culled
 technique10 DrawTechnique
 {
 	pass P0
@@ -46,7 +130,63 @@ technique10 DrawTechnique
 		SetGeometryShader(NULL);
 		SetPixelShader(NULL);
 
+		SetRasterizerState(CullFrontBiased);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+// The interleaved vertices with every face drawn, kept to compare against
+technique10 DrawInterleavedTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(NULL);
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+// Position streams with every face drawn, for the camera
+technique10 DrawSceneDepthTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, SceneDepthVS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(NULL);
+
 		SetRasterizerState(NoCulling);
 		SetDepthStencilState(EnableDepth, 0xff);
 	}
-}
\ No newline at end of file
+}
+
+// Every face of a point light's cube in one pass
+technique10 DrawCubeTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, CubeVS()));
+		SetGeometryShader(CompileShader(gs_4_0, CubeGS()));
+		SetPixelShader(NULL);
+
+		SetRasterizerState(CullFrontBiased);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+// One face of the cube per pass, kept to compare against. Perspective, so nothing is flattened.
+technique10 DrawCubeFaceTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, SceneDepthVS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(NULL);
+
+		SetRasterizerState(CullFrontBiased);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
@@ -1,49 +1,69 @@
-#ifndef FLOOR_H
-#define FLOOR_H
-
-#include <D3DX10.h>
-#include "Buffer.h"
-#include "DepthTexture.h"
-
-struct FloorVertex
-{
-	D3DXVECTOR3			position;
-	D3DXVECTOR2			uv;
-};
-
-class Floor
-{
-public:
-	Floor();
-	~Floor();
-	void Initialize(ID3D10Device* device, DepthTexture* depthTexture, D3DXVECTOR3 position, int width, int depth);
-	void Update();
-	void Draw(D3DXMATRIX* vpMatrix, D3DXMATRIX* lightWVP);
-	void SetDepthTexture(DepthTexture* newDepthTexture);
-	void SetPCF(bool newPCF);
-	const bool& GetPCF() const;
-
-private:
-	ID3D10Device*							mDevice;
-	Buffer*									mVertexBuffer;
-	ID3D10Effect*							mEffect;
-	ID3D10EffectTechnique*					mTechnique;
-	ID3D10InputLayout*						mVertexLayout;
-	D3DXVECTOR3								mPosition;
-	bool									mPCF;
-
-	DepthTexture*							mDepthTexture;
-	ID3D10EffectShaderResourceVariable*		mfxDepthTextureVar;
-	ID3D10EffectMatrixVariable*				mfxWVP;
-	ID3D10EffectMatrixVariable*				mfxLightWVP;
-	ID3D10EffectScalarVariable*				mfxPCF;
-	ID3D10EffectScalarVariable*				mfxSMWidth;
-	ID3D10EffectScalarVariable*				mfxSMWidthInv;
-
-	static const int			C_NUM_VERTICES;
-	static const char*			C_FILENAME;
-
-	HRESULT CreateEffect();
-	HRESULT CreateVertexLayout();
-};
+#ifndef FLOOR_H
+#define FLOOR_H
+
+#include <D3DX10.h>
+#include "Buffer.h"
+#include "CascadedShadowMap.h"
+#include "ShadowAtlas.h"
+#include "PointShadowMap.h"
+#include "BoundingVolumes.h"
+
+struct FloorVertex
+{
+	D3DXVECTOR3			position;
+	D3DXVECTOR2			uv;
+};
+
+class Floor
+{
+public:
+	Floor();
+	~Floor();
+	void Initialize(RenderDevice* device, const CascadedShadowMap* shadowMap, D3DXVECTOR3 position, int width, int depth);
+	void Update();
+	void Draw(const D3DXMATRIX* vpMatrix);
+	void DrawDepth(const D3DXMATRIX* vpMatrix);
+	const AABB& GetBounds() const;
+	void SetVisible(bool visible);
+	bool IsVisible() const;
+	void SetLightmap(const unsigned char* texels, int width, int height);
+	void SetBakedLighting(bool useBakedLighting);
+	bool GetBakedLighting() const;
+	void SetShadowAtlas(const ShadowAtlas* shadowAtlas);
+	void SetPointShadowMap(const PointShadowMap* pointShadowMap);
+
+private:
+	RenderDevice*							mDevice;
+	Buffer*									mVertexBuffer;
+	RenderEffect							mEffect;
+	RenderTechnique							mTechnique;
+	RenderTechnique							mDepthTechnique;
+	RenderInputLayout						mVertexLayout;
+	D3DXVECTOR3								mPosition;
+	AABB									mBounds;
+	bool									mVisible;
+	bool									mBakedLighting;
+
+	RenderTexture							mLightmap;				// Direct light and ambient occlusion
+	RenderShaderView						mLightmapSRV;
+	RenderShaderView						mGroundTexture;
+	int										mLightmapWidth;
+	int										mLightmapHeight;
+
+	const CascadedShadowMap*				mShadowMap;
+	ShadowEffectVariables					mShadowVariables;
+	const ShadowAtlas*						mShadowAtlas;			// Spot lights, may be NULL
+	SpotLightEffectVariables				mSpotLightVariables;
+	const PointShadowMap*					mPointShadowMap;		// Used instead of the cascades when set
+	PointShadowEffectVariables				mPointShadowVariables;
+	RenderVariable							mfxWVP;
+	RenderVariable							mfxLightmap;
+	RenderVariable							mfxUseLightmap;
+	RenderVariable							mfxLightmapRect;
+
+	static const int			C_NUM_VERTICES;
+	static const char*			C_FILENAME;
+
+	HRESULT CreateVertexLayout();
+};
 #endif
\ No newline at end of file
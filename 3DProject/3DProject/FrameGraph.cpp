@@ -0,0 +1,458 @@
+#include "FrameGraph.h"
+#include <sstream>
+#include <algorithm>
+
+FrameGraph::Resource::Resource(const char* name, const RenderTargetDesc& desc, const ImportedViews& views, bool imported)
+	: Name(name), Imported(imported), Desc(desc), Views(views), Output(false), RefCount(0), FirstPass(-1), LastPass(-1),
+	  Texture(NULL)
+{
+	ClearColor[0] = ClearColor[1] = ClearColor[2] = 0.0f;
+	ClearColor[3] = 1.0f;
+}
+
+FrameGraph::FrameGraph()
+	: mDevice(NULL), mPool(NULL), mCycle(false)
+{
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+void FrameGraph::Initialize(RenderDevice* device, RenderTargetPool* pool)
+{
+	mDevice = device;
+	mPool = pool;
+}
+
+// Forget the passes and resources of the last frame, the next frame is declared from scratch
+void FrameGraph::Reset()
+{
+	mResources.clear();
+	mPasses.clear();
+	mOrder.clear();
+	mCycle = false;
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+// A texture that only lives between its first and last pass, returns its handle
+int FrameGraph::CreateTexture(const char* name, const RenderTargetDesc& desc)
+{
+	mResources.push_back(Resource(name, desc, ImportedViews(), false));
+	return (int)mResources.size() - 1;
+}
+
+// A texture that lives outside the graph, returns its handle
+int FrameGraph::ImportTexture(const char* name, const ImportedViews& views)
+{
+	RenderTargetDesc desc(views.Width, views.Height, 1, RenderFormatUnknown, 0);
+	mResources.push_back(Resource(name, desc, views, true));
+	return (int)mResources.size() - 1;
+}
+
+// The function is called with the data when the pass runs, returns the pass's handle
+int FrameGraph::AddPass(const char* name, FramePassFunction function, void* data)
+{
+	Pass pass;
+	pass.Name = name;
+	pass.Function = function;
+	pass.Data = data;
+	pass.RefCount = 0;
+	pass.Culled = false;
+	pass.Unbind = false;
+
+	mPasses.push_back(pass);
+	return (int)mPasses.size() - 1;
+}
+
+void FrameGraph::Read(int pass, int resource)
+{
+	if(!ReadsResource(mPasses[pass], resource))
+		mPasses[pass].Reads.push_back(resource);
+}
+
+// A write with a clear clears the resource before the pass runs
+void FrameGraph::Write(int pass, int resource, bool clear)
+{
+	std::vector<PassWrite>& writes = mPasses[pass].Writes;
+	for(size_t i = 0; i < writes.size(); ++i)
+	{
+		if(writes[i].Resource == resource)
+		{
+			writes[i].Clear = writes[i].Clear || clear;
+			return;
+		}
+	}
+
+	PassWrite write;
+	write.Resource = resource;
+	write.Clear = clear;
+	writes.push_back(write);
+}
+
+void FrameGraph::SetClearColor(int resource, const float color[4])
+{
+	for(int i = 0; i < 4; ++i)
+		mResources[resource].ClearColor[i] = color[i];
+}
+
+// The resource is read after the frame, like the back buffer by Present
+void FrameGraph::SetOutput(int resource)
+{
+	mResources[resource].Output = true;
+}
+
+// Order and cull the passes and find when the transient textures are needed
+void FrameGraph::Compile()
+{
+	SortPasses();
+	CullPasses();
+	FindLifetimes();
+
+	mStatistics.Passes = (int)mPasses.size();
+	mStatistics.Culled = 0;
+	for(size_t i = 0; i < mPasses.size(); ++i)
+	{
+		if(mPasses[i].Culled)
+			++mStatistics.Culled;
+	}
+}
+
+// Run the passes that were not culled, in order
+void FrameGraph::Execute()
+{
+	mStatistics.Transients = 0;
+	mStatistics.Textures = 0;
+	mStatistics.Clears = 0;
+	mStatistics.Unbinds = 0;
+
+	std::vector<PooledTexture*> textures;
+	for(int position = 0; position < (int)mOrder.size(); ++position)
+	{
+		const Pass& pass = mPasses[mOrder[position]];
+		if(pass.Culled)
+			continue;
+
+		for(size_t i = 0; i < mResources.size(); ++i)
+		{
+			Resource& resource = mResources[i];
+			if(resource.Imported || resource.FirstPass != position)
+				continue;
+
+			resource.Texture = mPool->Acquire(resource.Desc);
+			++mStatistics.Transients;
+			if(resource.Texture != NULL && std::find(textures.begin(), textures.end(), resource.Texture) == textures.end())
+				textures.push_back(resource.Texture);
+		}
+
+		if(pass.Unbind)
+		{
+			mDevice->UnbindShaderResources();
+			++mStatistics.Unbinds;
+		}
+
+		BindTargets(pass);
+		pass.Function(pass.Data);
+
+		for(size_t i = 0; i < mResources.size(); ++i)
+		{
+			if(!mResources[i].Imported && mResources[i].LastPass == position)
+				mPool->Release(mResources[i].Texture);
+		}
+	}
+
+	mStatistics.Textures = (int)textures.size();
+}
+
+int FrameGraph::GetWidth(int resource) const
+{
+	return mResources[resource].Imported ? mResources[resource].Views.Width : mResources[resource].Desc.Width;
+}
+
+int FrameGraph::GetHeight(int resource) const
+{
+	return mResources[resource].Imported ? mResources[resource].Views.Height : mResources[resource].Desc.Height;
+}
+
+PooledTexture* FrameGraph::GetTexture(int resource) const
+{
+	return mResources[resource].Texture;
+}
+
+const FrameGraphStatistics& FrameGraph::GetStatistics() const
+{
+	return mStatistics;
+}
+
+// The passes in the order they ran with what the graph did around them, then the resources with
+// the passes they lived between. Transients given the same pooled texture share a texture number.
+std::string FrameGraph::Dump() const
+{
+	std::vector<PooledTexture*> textures;
+	std::stringstream stream;
+
+	stream << "Frame graph: " << mPasses.size() << " passes, " << mStatistics.Culled << " culled";
+	if(mCycle)
+		stream << ", cycle (passes left in the order they were added)";
+	stream << "\n";
+
+	for(size_t position = 0; position < mOrder.size(); ++position)
+	{
+		const Pass& pass = mPasses[mOrder[position]];
+		stream << "  " << position << ". " << pass.Name;
+		if(pass.Culled)
+			stream << " (culled)";
+		stream << "\n";
+
+		if(pass.Unbind)
+			stream << "       unbind shader resources\n";
+		for(size_t i = 0; i < pass.Writes.size(); ++i)
+		{
+			if(pass.Writes[i].Clear)
+				stream << "       clear " << mResources[pass.Writes[i].Resource].Name << "\n";
+		}
+		for(size_t i = 0; i < pass.Reads.size(); ++i)
+			stream << "       read " << mResources[pass.Reads[i]].Name << "\n";
+		for(size_t i = 0; i < pass.Writes.size(); ++i)
+			stream << "       write " << mResources[pass.Writes[i].Resource].Name << "\n";
+	}
+
+	stream << "Resources:\n";
+	for(size_t i = 0; i < mResources.size(); ++i)
+	{
+		const Resource& resource = mResources[i];
+		stream << "  " << resource.Name << ": ";
+		if(resource.Imported)
+			stream << "imported";
+		else
+		{
+			stream << "transient " << resource.Desc.Width << "x" << resource.Desc.Height << "x" << resource.Desc.ArraySize;
+			stream << ", format " << resource.Desc.Format;
+		}
+		if(resource.Output)
+			stream << ", output";
+
+		if(resource.FirstPass < 0)
+			stream << ", unused";
+		else
+			stream << ", passes " << resource.FirstPass << "-" << resource.LastPass;
+
+		if(!resource.Imported && resource.Texture != NULL)
+		{
+			std::vector<PooledTexture*>::iterator found = std::find(textures.begin(), textures.end(), resource.Texture);
+			if(found == textures.end())
+				found = textures.insert(textures.end(), resource.Texture);
+			stream << ", texture " << found - textures.begin();
+		}
+		stream << "\n";
+	}
+
+	return stream.str();
+}
+
+bool FrameGraph::ReadsResource(const Pass& pass, int resource) const
+{
+	return std::find(pass.Reads.begin(), pass.Reads.end(), resource) != pass.Reads.end();
+}
+
+bool FrameGraph::WritesResource(const Pass& pass, int resource) const
+{
+	for(size_t i = 0; i < pass.Writes.size(); ++i)
+	{
+		if(pass.Writes[i].Resource == resource)
+			return true;
+	}
+
+	return false;
+}
+
+// The pass must run after the other if the other writes what it reads, or both write a resource
+// and the other was added first
+bool FrameGraph::DependsOn(int pass, int other) const
+{
+	if(pass == other)
+		return false;
+
+	const Pass& otherPass = mPasses[other];
+	for(size_t i = 0; i < otherPass.Writes.size(); ++i)
+	{
+		int resource = otherPass.Writes[i].Resource;
+		if(ReadsResource(mPasses[pass], resource) && !WritesResource(mPasses[pass], resource))
+			return true;
+		if(other < pass && WritesResource(mPasses[pass], resource))
+			return true;
+	}
+
+	return false;
+}
+
+// Repeatedly take the first added pass whose dependencies have all been placed. When none is left
+// the rest depend on each other, the first of them is placed anyway.
+void FrameGraph::SortPasses()
+{
+	int numPasses = (int)mPasses.size();
+	std::vector<bool> placed(numPasses, false);
+	mOrder.clear();
+	mCycle = false;
+
+	while((int)mOrder.size() < numPasses)
+	{
+		int next = -1;
+		for(int i = 0; i < numPasses && next < 0; ++i)
+		{
+			if(placed[i])
+				continue;
+
+			bool ready = true;
+			for(int j = 0; j < numPasses && ready; ++j)
+				ready = placed[j] || !DependsOn(i, j);
+
+			if(ready)
+				next = i;
+		}
+
+		if(next < 0)
+		{
+			mCycle = true;
+			next = (int)(std::find(placed.begin(), placed.end(), false) - placed.begin());
+		}
+
+		placed[next] = true;
+		mOrder.push_back(next);
+	}
+}
+
+// A resource is needed while a pass that does not write it reads it, or it is an output. A pass is
+// needed while one of the resources it writes is. Unneeded resources are followed back to their
+// writers until nothing more can be culled.
+void FrameGraph::CullPasses()
+{
+	for(size_t i = 0; i < mResources.size(); ++i)
+		mResources[i].RefCount = mResources[i].Output ? 1 : 0;
+
+	for(size_t i = 0; i < mPasses.size(); ++i)
+	{
+		Pass& pass = mPasses[i];
+		pass.RefCount = (int)pass.Writes.size();
+		pass.Culled = pass.RefCount == 0;
+
+		for(size_t j = 0; j < pass.Reads.size(); ++j)
+		{
+			if(!WritesResource(pass, pass.Reads[j]))
+				++mResources[pass.Reads[j]].RefCount;
+		}
+	}
+
+	std::vector<int> unused;
+	for(size_t i = 0; i < mResources.size(); ++i)
+	{
+		if(mResources[i].RefCount == 0)
+			unused.push_back((int)i);
+	}
+
+	while(!unused.empty())
+	{
+		int resource = unused.back();
+		unused.pop_back();
+
+		for(size_t i = 0; i < mPasses.size(); ++i)
+		{
+			Pass& pass = mPasses[i];
+			if(pass.Culled || !WritesResource(pass, resource) || --pass.RefCount > 0)
+				continue;
+
+			pass.Culled = true;
+			for(size_t j = 0; j < pass.Reads.size(); ++j)
+			{
+				int read = pass.Reads[j];
+				if(!WritesResource(pass, read) && --mResources[read].RefCount == 0)
+					unused.push_back(read);
+			}
+		}
+	}
+}
+
+// The first and last position in the order a resource is used at, and the passes that write a
+// resource that is read, which may still be bound as an input
+void FrameGraph::FindLifetimes()
+{
+	for(int position = 0; position < (int)mOrder.size(); ++position)
+	{
+		const Pass& pass = mPasses[mOrder[position]];
+		if(pass.Culled)
+			continue;
+
+		std::vector<int> used(pass.Reads);
+		for(size_t i = 0; i < pass.Writes.size(); ++i)
+			used.push_back(pass.Writes[i].Resource);
+
+		for(size_t i = 0; i < used.size(); ++i)
+		{
+			Resource& resource = mResources[used[i]];
+			if(resource.FirstPass < 0)
+				resource.FirstPass = position;
+			resource.LastPass = position;
+		}
+	}
+
+	for(size_t i = 0; i < mPasses.size(); ++i)
+	{
+		Pass& pass = mPasses[i];
+		for(size_t j = 0; j < pass.Writes.size() && !pass.Culled && !pass.Unbind; ++j)
+		{
+			for(size_t k = 0; k < mPasses.size() && !pass.Unbind; ++k)
+				pass.Unbind = !mPasses[k].Culled && ReadsResource(mPasses[k], pass.Writes[j].Resource);
+		}
+	}
+}
+
+// Bind the targets the pass writes with a viewport of the first one's size and clear those written
+// with a clear. A pass that only writes resources without views binds them itself.
+void FrameGraph::BindTargets(const Pass& pass)
+{
+	RenderTargetView renderTargets[RenderDevice::C_MAX_RENDER_TARGETS] = { NULL };
+	RenderDepthView depthStencil = NULL;
+	int numRenderTargets = 0;
+	int width = 0;
+	int height = 0;
+
+	for(size_t i = 0; i < pass.Writes.size(); ++i)
+	{
+		const Resource& resource = mResources[pass.Writes[i].Resource];
+		RenderTargetView renderTarget = resource.Views.RTV;
+		RenderDepthView depthView = resource.Views.DSV;
+		if(!resource.Imported && resource.Texture != NULL)
+		{
+			renderTarget = resource.Texture->RTV.empty() ? NULL : resource.Texture->RTV[0];
+			depthView = resource.Texture->DSV.empty() ? NULL : resource.Texture->DSV[0];
+		}
+
+		if(renderTarget == NULL && depthView == NULL)
+			continue;
+
+		if(width == 0)
+		{
+			width = GetWidth(pass.Writes[i].Resource);
+			height = GetHeight(pass.Writes[i].Resource);
+		}
+
+		if(renderTarget != NULL && numRenderTargets < RenderDevice::C_MAX_RENDER_TARGETS)
+			renderTargets[numRenderTargets++] = renderTarget;
+		if(depthView != NULL)
+			depthStencil = depthView;
+
+		if(pass.Writes[i].Clear)
+		{
+			if(renderTarget != NULL)
+				mDevice->ClearRenderTarget(renderTarget, resource.ClearColor);
+			if(depthView != NULL)
+				mDevice->ClearDepthStencil(depthView);
+			++mStatistics.Clears;
+		}
+	}
+
+	if(width == 0)
+		return;
+
+	mDevice->SetRenderTargets(numRenderTargets > 0 ? numRenderTargets : 1, renderTargets, depthStencil);
+
+	RenderViewport viewport = { 0, 0, (UINT)width, (UINT)height, 0.0f, 1.0f };
+	mDevice->SetViewport(viewport);
+}
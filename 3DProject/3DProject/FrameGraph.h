@@ -0,0 +1,123 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <string>
+#include <vector>
+#include "RenderDevice.h"
+#include "RenderTargetPool.h"
+#include "Globals.h"
+
+typedef void (*FramePassFunction)(void* data);
+
+// Views of a texture made outside the graph, like the back buffer. A resource without views only
+// orders the passes, the passes that write it bind it themselves.
+struct ImportedViews
+{
+	RenderTargetView			RTV;
+	RenderDepthView				DSV;
+	int							Width;
+	int							Height;
+
+	ImportedViews(RenderTargetView rtv = NULL, RenderDepthView dsv = NULL, int width = 0, int height = 0)
+		: RTV(rtv), DSV(dsv), Width(width), Height(height) {}
+};
+
+struct FrameGraphStatistics
+{
+	int							Passes;
+	int							Culled;					// Passes whose results nothing read
+	int							Transients;				// Textures acquired from the pool this frame
+	int							Textures;				// Different pooled textures they were given
+	int							Clears;
+	int							Unbinds;
+};
+
+// The passes of a frame and the resources they read and write, declared again every frame.
+//
+// Compile orders the passes so every pass comes after the writers of what it reads, and writers of
+// the same resource keep the order they were added in. Passes whose writes nothing reads are culled,
+// a resource set as an output is always read. Before a pass the graph unbinds the shader inputs when
+// the pass writes a resource that is read somewhere, binds the targets the pass writes with a
+// viewport of their size and clears the ones written with a clear.
+//
+// Transient textures are acquired from the render target pool before their first pass and released
+// after their last, so textures of the same description whose passes do not overlap share memory.
+class FrameGraph
+{
+public:
+	FrameGraph();
+	void Initialize(RenderDevice* device, RenderTargetPool* pool);
+	void Reset();
+
+	int CreateTexture(const char* name, const RenderTargetDesc& desc);
+	int ImportTexture(const char* name, const ImportedViews& views);
+	int AddPass(const char* name, FramePassFunction function, void* data);
+	void Read(int pass, int resource);
+	void Write(int pass, int resource, bool clear = false);
+	void SetClearColor(int resource, const float color[4]);
+	void SetOutput(int resource);
+
+	void Compile();
+	void Execute();
+
+	int GetWidth(int resource) const;
+	int GetHeight(int resource) const;
+	PooledTexture* GetTexture(int resource) const;			// Transients, during their passes
+	const FrameGraphStatistics& GetStatistics() const;
+	std::string Dump() const;
+
+private:
+	struct Resource
+	{
+		std::string				Name;
+		bool					Imported;
+		RenderTargetDesc		Desc;
+		ImportedViews			Views;
+		float					ClearColor[4];
+		bool					Output;
+		int						RefCount;
+		int						FirstPass;				// Positions in the order, -1 when unused
+		int						LastPass;
+		PooledTexture*			Texture;
+
+		Resource(const char* name, const RenderTargetDesc& desc, const ImportedViews& views, bool imported);
+	};
+
+	struct PassWrite
+	{
+		int						Resource;
+		bool					Clear;
+	};
+
+	struct Pass
+	{
+		std::string				Name;
+		FramePassFunction		Function;
+		void*					Data;
+		std::vector<int>		Reads;
+		std::vector<PassWrite>	Writes;
+		int						RefCount;
+		bool					Culled;
+		bool					Unbind;
+	};
+
+	RenderDevice*				mDevice;
+	RenderTargetPool*			mPool;
+	std::vector<Resource>		mResources;
+	std::vector<Pass>			mPasses;
+	std::vector<int>			mOrder;					// Passes in the order they run, culled ones too
+	bool						mCycle;					// Some passes were left in the order they were added
+	FrameGraphStatistics		mStatistics;
+
+	FrameGraph(const FrameGraph&);
+	FrameGraph& operator=(const FrameGraph&);
+
+	bool ReadsResource(const Pass& pass, int resource) const;
+	bool WritesResource(const Pass& pass, int resource) const;
+	bool DependsOn(int pass, int other) const;
+	void SortPasses();
+	void CullPasses();
+	void FindLifetimes();
+	void BindTargets(const Pass& pass);
+};
+#endif
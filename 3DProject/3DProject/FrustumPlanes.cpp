@@ -0,0 +1,182 @@
+#include "FrustumPlanes.h"
+
+#ifdef FRUSTUM_PLANES_SSE
+#include <xmmintrin.h>
+#endif
+
+// Extract the planes from a view-projection matrix (Gribb and Hartmann). With row vectors the clip
+// coordinates are dot products with the matrix columns, and the D3D clip volume is -w <= x <= w,
+// -w <= y <= w and 0 <= z <= w.
+void FrustumPlanes::Extract(const D3DXMATRIX& viewProj)
+{
+	const D3DXMATRIX& m = viewProj;
+
+	Planes[Left]	= D3DXPLANE(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+	Planes[Right]	= D3DXPLANE(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+	Planes[Bottom]	= D3DXPLANE(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+	Planes[Top]		= D3DXPLANE(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+	Planes[Near]	= D3DXPLANE(m._13, m._23, m._33, m._43);
+	Planes[Far]		= D3DXPLANE(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+
+	for(int i = 0; i < PlaneCount; ++i)
+		D3DXPlaneNormalize(&Planes[i], &Planes[i]);
+}
+
+bool FrustumPlanes::TestSphere(const BoundingSphere& sphere) const
+{
+	for(int i = 0; i < PlaneCount; ++i)
+	{
+		if(D3DXPlaneDotCoord(&Planes[i], &sphere.Center) < -sphere.Radius)
+			return false;
+	}
+
+	return true;
+}
+
+bool FrustumPlanes::TestBox(const AABB& box) const
+{
+	D3DXVECTOR3 center = box.GetCenter();
+	D3DXVECTOR3 extents = box.GetExtents();
+
+	for(int i = 0; i < PlaneCount; ++i)
+	{
+		const D3DXPLANE& p = Planes[i];
+		float distance = p.a * center.x + p.b * center.y + p.c * center.z + p.d;
+		float radius = std::abs(p.a) * extents.x + std::abs(p.b) * extents.y + std::abs(p.c) * extents.z;
+		if(distance < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+// Test spheres with one radius each, returns the number of visible spheres
+int FrustumPlanes::CullSpheres(const float* x, const float* y, const float* z, const float* radius,
+							   int count, unsigned char* visible) const
+{
+	return CullSpheres(x, y, z, radius, 0.0f, count, visible);
+}
+
+// Test spheres that all have the same radius, returns the number of visible spheres
+int FrustumPlanes::CullSpheres(const float* x, const float* y, const float* z, float radius,
+							   int count, unsigned char* visible) const
+{
+	return CullSpheres(x, y, z, NULL, radius, count, visible);
+}
+
+int FrustumPlanes::CullSpheres(const float* x, const float* y, const float* z, const float* radius, float uniformRadius,
+							   int count, unsigned char* visible) const
+{
+	int numVisible = 0;
+	int i = 0;
+
+#ifdef FRUSTUM_PLANES_SSE
+	__m128 planeA[PlaneCount], planeB[PlaneCount], planeC[PlaneCount], planeD[PlaneCount];
+	for(int p = 0; p < PlaneCount; ++p)
+	{
+		planeA[p] = _mm_set1_ps(Planes[p].a);
+		planeB[p] = _mm_set1_ps(Planes[p].b);
+		planeC[p] = _mm_set1_ps(Planes[p].c);
+		planeD[p] = _mm_set1_ps(Planes[p].d);
+	}
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 negRadius = _mm_set1_ps(-uniformRadius);
+
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 sx = _mm_loadu_ps(x + i);
+		__m128 sy = _mm_loadu_ps(y + i);
+		__m128 sz = _mm_loadu_ps(z + i);
+		if(radius != NULL)
+			negRadius = _mm_xor_ps(_mm_loadu_ps(radius + i), signMask);
+
+		// A sphere is outside if it is behind any of the planes by more than its radius
+		__m128 outside = _mm_setzero_ps();
+		for(int p = 0; p < PlaneCount; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, planeA[p]), _mm_mul_ps(sy, planeB[p])),
+										 _mm_add_ps(_mm_mul_ps(sz, planeC[p]), planeD[p]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for(int k = 0; k < 4; ++k)
+		{
+			visible[i + k] = (outsideMask & (1 << k)) ? 0 : 1;
+			numVisible += visible[i + k];
+		}
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		BoundingSphere sphere(D3DXVECTOR3(x[i], y[i], z[i]), radius != NULL ? radius[i] : uniformRadius);
+		visible[i] = TestSphere(sphere) ? 1 : 0;
+		numVisible += visible[i];
+	}
+
+	return numVisible;
+}
+
+// Test boxes given by center and half extents, returns the number of visible boxes
+int FrustumPlanes::CullBoxes(const float* centerX, const float* centerY, const float* centerZ,
+							 const float* extentX, const float* extentY, const float* extentZ,
+							 int count, unsigned char* visible) const
+{
+	int numVisible = 0;
+	int i = 0;
+
+#ifdef FRUSTUM_PLANES_SSE
+	__m128 planeA[PlaneCount], planeB[PlaneCount], planeC[PlaneCount], planeD[PlaneCount];
+	__m128 absA[PlaneCount], absB[PlaneCount], absC[PlaneCount];
+	for(int p = 0; p < PlaneCount; ++p)
+	{
+		planeA[p] = _mm_set1_ps(Planes[p].a);
+		planeB[p] = _mm_set1_ps(Planes[p].b);
+		planeC[p] = _mm_set1_ps(Planes[p].c);
+		planeD[p] = _mm_set1_ps(Planes[p].d);
+		absA[p] = _mm_set1_ps(std::abs(Planes[p].a));
+		absB[p] = _mm_set1_ps(std::abs(Planes[p].b));
+		absC[p] = _mm_set1_ps(std::abs(Planes[p].c));
+	}
+
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(centerX + i);
+		__m128 cy = _mm_loadu_ps(centerY + i);
+		__m128 cz = _mm_loadu_ps(centerZ + i);
+		__m128 ex = _mm_loadu_ps(extentX + i);
+		__m128 ey = _mm_loadu_ps(extentY + i);
+		__m128 ez = _mm_loadu_ps(extentZ + i);
+
+		// A box is outside if its center is behind a plane by more than the box's projected radius
+		__m128 outside = _mm_setzero_ps();
+		for(int p = 0; p < PlaneCount; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, planeA[p]), _mm_mul_ps(cy, planeB[p])),
+										 _mm_add_ps(_mm_mul_ps(cz, planeC[p]), planeD[p]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, absA[p]), _mm_mul_ps(ey, absB[p])),
+									   _mm_mul_ps(ez, absC[p]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for(int k = 0; k < 4; ++k)
+		{
+			visible[i + k] = (outsideMask & (1 << k)) ? 0 : 1;
+			numVisible += visible[i + k];
+		}
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		D3DXVECTOR3 center(centerX[i], centerY[i], centerZ[i]);
+		D3DXVECTOR3 extents(extentX[i], extentY[i], extentZ[i]);
+		visible[i] = TestBox(AABB(center - extents, center + extents)) ? 1 : 0;
+		numVisible += visible[i];
+	}
+
+	return numVisible;
+}
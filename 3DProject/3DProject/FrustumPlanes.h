@@ -0,0 +1,39 @@
+#ifndef FRUSTUM_PLANES_H
+#define FRUSTUM_PLANES_H
+
+#include <D3DX10.h>
+#include "BoundingVolumes.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define FRUSTUM_PLANES_SSE
+#endif
+
+// The six planes of a view volume, pointing inwards. The batch tests take their bounds as separate
+// arrays of x, y, z (and radius or extents) and write one visibility flag per bound.
+struct FrustumPlanes
+{
+	enum Plane
+	{
+		Left, Right, Bottom, Top, Near, Far, PlaneCount
+	};
+
+	D3DXPLANE			Planes[PlaneCount];
+
+	void Extract(const D3DXMATRIX& viewProj);
+
+	bool TestSphere(const BoundingSphere& sphere) const;
+	bool TestBox(const AABB& box) const;
+
+	int CullSpheres(const float* x, const float* y, const float* z, const float* radius,
+					int count, unsigned char* visible) const;
+	int CullSpheres(const float* x, const float* y, const float* z, float radius,
+					int count, unsigned char* visible) const;
+	int CullBoxes(const float* centerX, const float* centerY, const float* centerZ,
+				  const float* extentX, const float* extentY, const float* extentZ,
+				  int count, unsigned char* visible) const;
+
+private:
+	int CullSpheres(const float* x, const float* y, const float* z, const float* radius, float uniformRadius,
+					int count, unsigned char* visible) const;
+};
+#endif
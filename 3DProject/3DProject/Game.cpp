@@ -1,85 +1,142 @@
-#include "Game.h"
-#include <sstream>
-
-Game::Game(HINSTANCE applicationInstance, LPCTSTR windowTitle, UINT windowWidth, UINT windowHeight)
-	: D3DApplication(applicationInstance, windowTitle, windowWidth, windowHeight), mGameTime(),
-	  mNoFrames(0), mFPSString(""), mLastFrameTime(0), mScene(NULL), mCamera(NULL)
-{
-	Frustrum camFrustrum;
-	camFrustrum.aspectRatio = (float)(mScreenWidth / mScreenHeight);
-	camFrustrum.farDistance = 1000.0f;
-	camFrustrum.nearDistance = 1.0f;
-	camFrustrum.fovY = (float)D3DX_PI * 0.3f;
-	mCamera = new Camera(D3DXVECTOR3(-100.0f, 50.0f, -100.0f), D3DXVECTOR3(3.0f, -1.0f, 3.0f), 
-						 D3DXVECTOR3(0.0f, 1.0f, 0.0f), camFrustrum);
-
-	mScene = new Scene(mDeviceD3D, mScreenWidth);
-	mDefaultFont = new GameFont(mDeviceD3D, "Times New Roman", 21);
-}
-
-Game::~Game()
-{
-}
-
-//  What happens every loop of the program (ie updating and drawing the game)
-void Game::ProgramLoop()
-{
-	Update();
-	Draw();
-}
-
-// Update the game
-void Game::Update()
-{
-	if(GetAsyncKeyState(VK_ESCAPE))
-		Quit();
-
-	mGameTime.Update();
-	mCamera->Update(mGameTime);
-	mScene->Update(mGameTime);
-
-	++mNoFrames;
-	mLastFrameTime += (float)mGameTime.GetTimeSinceLastTick().Milliseconds;
-
-	if(mLastFrameTime > 1000.0f)
-	{
-		std::stringstream stream;
-		stream << mScene->GetInfoString() << "\n";
-		stream << "FPS: " << mNoFrames;
-		mFPSString = stream.str();
-
-		mLastFrameTime -= 1000;
-		mNoFrames = 0;
-	}
-}
-
-// Draw the scene
-void Game::Draw()
-{
-	mScene->DrawShadows(mCamera->GetPos());
-
-	ResetTargetAndViewport();
-	ClearScene();
-
-	mScene->Draw(*mCamera);
-
-	RECT textPos = { 0, 0, 300, 300 };
-	mDefaultFont->WriteText(mFPSString, &textPos, D3DXCOLOR(1.0f, 0.0f, 0.0f, 1.0f), GameFont::Left, GameFont::Top);
-
-	RenderScene();
-}
-
-void Game::ResetTargetAndViewport()
-{
-	mDeviceD3D->OMSetRenderTargets(1, &mRenderTarget, mDepthStencilView);
-
-	D3D10_VIEWPORT vp;
-	vp.TopLeftX = 0;
-	vp.TopLeftY = 0;
-	vp.Width = mScreenWidth;
-	vp.Height = mScreenHeight;
-	vp.MinDepth = 0.0f;
-	vp.MaxDepth = 1.0f;
-
-	mDeviceD3D->RSSetViewports(1, &vp);
-}
\ No newline at end of file
+#include "Game.h"
+#include <sstream>
+#include <fstream>
+
+Game::Game(HINSTANCE applicationInstance, LPCTSTR windowTitle, UINT windowWidth, UINT windowHeight)
+	: D3DApplication(applicationInstance, windowTitle, windowWidth, windowHeight), mGameTime(),
+	  mNoFrames(0), mFPSString(""), mLastFrameTime(0), mScene(NULL), mCamera(NULL),
+	  mWasLeftPressed(false), mRecordFrame(false), mWasBackPressed(false)
+{
+	Frustrum camFrustrum;
+	camFrustrum.aspectRatio = (float)(mScreenWidth / mScreenHeight);
+	camFrustrum.farDistance = 1000.0f;
+	camFrustrum.nearDistance = 1.0f;
+	camFrustrum.fovY = (float)D3DX_PI * 0.3f;
+	mCamera = new Camera(D3DXVECTOR3(-100.0f, 50.0f, -100.0f), D3DXVECTOR3(3.0f, -1.0f, 3.0f), 
+						 D3DXVECTOR3(0.0f, 1.0f, 0.0f), camFrustrum);
+
+	mRenderDevice.Initialize(mDeviceD3D);
+	mDeviceRecorder.Initialize(&mRenderDevice);
+
+	mScene = new Scene(&mDeviceRecorder, mScreenWidth);
+	mFrameGraph.Initialize(&mDeviceRecorder, &mScene->GetRenderTargetPool());
+	mDefaultFont = new GameFont(mDeviceD3D, "Times New Roman", 21);
+}
+
+Game::~Game()
+{
+}
+
+//  What happens every loop of the program (ie updating and drawing the game)
+void Game::ProgramLoop()
+{
+	Update();
+	Draw();
+}
+
+// Update the game
+void Game::Update()
+{
+	if(GetAsyncKeyState(VK_ESCAPE))
+		Quit();
+
+	// Write out the frame graph of the last frame and record the calls of the next, once per press
+	bool backPressed = (GetAsyncKeyState(VK_BACK) & 0x8000) != 0;
+	if(backPressed && !mWasBackPressed)
+	{
+		std::ofstream file("framegraph.txt");
+		file << mFrameGraph.Dump();
+		mRecordFrame = true;
+	}
+	mWasBackPressed = backPressed;
+
+	mGameTime.Update();
+	mCamera->Update(mGameTime);
+	mSceneController.Update(*mScene);
+	mScene->Update(mGameTime);
+
+	// Pick what is under the cursor when the left button goes down
+	mMouse.Update();
+	if(mMouse.leftPressed && !mWasLeftPressed)
+	{
+		POINT cursor = { mMouse.x, mMouse.y };
+		ScreenToClient(GetWindowHandle(), &cursor);
+		mScene->Pick(*mCamera, cursor.x, cursor.y, mScreenWidth, mScreenHeight);
+	}
+	mWasLeftPressed = mMouse.leftPressed;
+
+	++mNoFrames;
+	mLastFrameTime += (float)mGameTime.GetTimeSinceLastTick().Milliseconds;
+
+	if(mLastFrameTime > 1000.0f)
+	{
+		std::stringstream stream;
+		stream << mScene->GetInfoString() << "\n";
+
+		const FrameGraphStatistics& graph = mFrameGraph.GetStatistics();
+		stream << "Frame graph (Backspace writes framegraph.txt): " << graph.Passes << " passes, " << graph.Culled;
+		stream << " culled, " << graph.Transients << " transients in " << graph.Textures << " textures, ";
+		stream << graph.Clears << " clears, " << graph.Unbinds << " unbinds\n";
+
+		const RenderDeviceStatistics& device = mDeviceRecorder.GetStatistics();
+		stream << "Device (Backspace writes commands.txt): " << device.Draws << " draws, " << device.Triangles;
+		stream << " triangles, " << device.StateChanges << " state changes (" << device.RedundantStateChanges;
+		stream << " redundant), " << device.BytesUploaded / 1024 << " KB uploaded, " << device.Buffers << " buffers (";
+		stream << device.BufferBytes / 1024 << " KB), " << device.Textures << " textures (" << device.TextureBytes / 1024;
+		stream << " KB), " << device.Errors << " errors\n";
+		if(!mDeviceRecorder.GetErrors().empty())
+			stream << "First device error: " << mDeviceRecorder.GetErrors()[0] << "\n";
+		stream << "FPS: " << mNoFrames;
+		mFPSString = stream.str();
+
+		mLastFrameTime -= 1000;
+		mNoFrames = 0;
+	}
+}
+
+// Declare the frame's passes and run them. The scene's passes draw into the back buffer and the text
+// is written on top. Every call goes through the recorder, which writes the frame's calls to
+// commands.txt after Backspace is pressed.
+void Game::Draw()
+{
+	bool recordFrame = mRecordFrame;
+	mRenderDevice.SetBackBuffer(mRenderTarget, mDepthStencilView);
+	mDeviceRecorder.SetRecording(recordFrame);
+	mDeviceRecorder.BeginFrame();
+
+	mScene->Cull(*mCamera);
+
+	mFrameGraph.Reset();
+	int backBuffer = mFrameGraph.ImportTexture("Back buffer", ImportedViews(mDeviceRecorder.GetBackBuffer(), NULL,
+																			mScreenWidth, mScreenHeight));
+	int depthStencil = mFrameGraph.ImportTexture("Depth stencil", ImportedViews(NULL, mDeviceRecorder.GetBackBufferDepth(),
+																				mScreenWidth, mScreenHeight));
+	mFrameGraph.SetClearColor(backBuffer, GetClearColor());
+	mFrameGraph.SetOutput(backBuffer);
+
+	mScene->AddPasses(mFrameGraph, *mCamera, backBuffer, depthStencil);
+
+	int textPass = mFrameGraph.AddPass("Text", TextPass, this);
+	mFrameGraph.Write(textPass, backBuffer);
+
+	mFrameGraph.Compile();
+	mFrameGraph.Execute();
+	mScene->EndFrame();
+
+	RenderScene();
+
+	if(recordFrame)
+	{
+		mDeviceRecorder.SetRecording(false);
+		std::ofstream file("commands.txt");
+		file << mDeviceRecorder.DumpCommands();
+		mRecordFrame = false;
+	}
+}
+
+void Game::TextPass(void* data)
+{
+	Game* game = static_cast<Game*>(data);
+	RECT textPos = { 0, 0, 300, 300 };
+	game->mDefaultFont->WriteText(game->mFPSString, &textPos, D3DXCOLOR(1.0f, 0.0f, 0.0f, 1.0f), GameFont::Left, GameFont::Top);
+}
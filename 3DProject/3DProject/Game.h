@@ -1,35 +1,47 @@
-#ifndef GAME_H
-#define GAME_H
-
-#include "Camera.h"
-#include "D3DApplication.h"
-#include "GameTime.h"
-#include "GameFont.h"
-#include "Scene.h"
-
-// 3D II - Lab 2
-class Game : public D3DApplication
-{
-public:
-	Game(HINSTANCE applicationInstance, LPCTSTR windowTitle = "GameWindow", 
-		UINT windowWidth = CW_USEDEFAULT, UINT windowHeight = CW_USEDEFAULT);
-	virtual ~Game();
-	virtual void Update();
-	virtual void Draw();
-
-private:
-	GameTime						mGameTime;
-	GameFont*						mDefaultFont;
-	Scene*							mScene;
-	Camera*							mCamera;
-
-	std::string						mFPSString;
-	int								mNoFrames;
-	float							mLastFrameTime;
-
-	void ResetTargetAndViewport();
-
-protected:
-	virtual void ProgramLoop();
-};
+#ifndef GAME_H
+#define GAME_H
+
+#include "Camera.h"
+#include "D3DApplication.h"
+#include "GameTime.h"
+#include "GameFont.h"
+#include "Scene.h"
+#include "SceneController.h"
+#include "FrameGraph.h"
+#include "D3D10RenderDevice.h"
+#include "HeadlessRenderDevice.h"
+
+// 3D II - Lab 2
+class Game : public D3DApplication
+{
+public:
+	Game(HINSTANCE applicationInstance, LPCTSTR windowTitle = "GameWindow", 
+		UINT windowWidth = CW_USEDEFAULT, UINT windowHeight = CW_USEDEFAULT);
+	virtual ~Game();
+	virtual void Update();
+	virtual void Draw();
+
+private:
+	GameTime						mGameTime;
+	GameFont*						mDefaultFont;
+	D3D10RenderDevice				mRenderDevice;
+	HeadlessRenderDevice			mDeviceRecorder;		// Checks and counts the calls on their way to mRenderDevice
+	bool							mRecordFrame;
+	bool							mWasBackPressed;
+	Scene*							mScene;
+	SceneController					mSceneController;
+	FrameGraph						mFrameGraph;
+	Camera*							mCamera;
+	MouseInput						mMouse;
+	bool							mWasLeftPressed;
+
+	std::string						mFPSString;
+	int								mNoFrames;
+	float							mLastFrameTime;
+
+	static void TextPass(void* data);
+
+protected:
+	virtual void ProgramLoop();
+};
 #endif
\ No newline at end of file
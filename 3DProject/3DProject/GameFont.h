@@ -1,41 +1,43 @@
-#ifndef GAMEFONT_H
-#define GAMEFONT_H
-
-#include <D3DX10.h>
-#include <string>
-#include "Globals.h"
-
-#pragma comment(lib, "d3dx10.lib")
-
-class GameFont
-{
-public:
-	enum AlignVertical
-	{
-		Top, Middle, Bottom
-	};
-
-	enum AlignHorizontal
-	{
-		Left, Center, Right
-	};
-
-	GameFont();
-	GameFont(ID3D10Device* graphicsDevice, TCHAR* name = "Times New Roman", int size = 18, 
-		bool italic = false, bool bold = false);
-	~GameFont();
-	void WriteText(std::string text, POINT position, D3DXCOLOR textColor);
-	void WriteText(std::string text, RECT* destinationRect, D3DXCOLOR textColor, 
-		AlignHorizontal alignHor, AlignVertical alignVert);
-	void ChangeFontName(TCHAR* newName);
-	void ChangeSize(int newSize);
-	void ChangeBoldItalic(bool italic, bool bold);
-	int GetSize();
-
-private:
-	ID3DX10Font* mFont;
-	D3DX10_FONT_DESC mFontDesc;
-	ID3D10Device* mGraphicsDevice;
-};
-
+#ifndef GAMEFONT_H
+#define GAMEFONT_H
+
+#include <D3DX10.h>
+#include <string>
+#include "Globals.h"
+
+#pragma comment(lib, "d3dx10.lib")
+
+// Draws through the D3D10 device and not the RenderDevice: ID3DX10Font sets its own state and cannot be
+// recorded, so the text is left out of the frame graph and its statistics
+class GameFont
+{
+public:
+	enum AlignVertical
+	{
+		Top, Middle, Bottom
+	};
+
+	enum AlignHorizontal
+	{
+		Left, Center, Right
+	};
+
+	GameFont();
+	GameFont(ID3D10Device* graphicsDevice, TCHAR* name = "Times New Roman", int size = 18, 
+		bool italic = false, bool bold = false);
+	~GameFont();
+	void WriteText(std::string text, POINT position, D3DXCOLOR textColor);
+	void WriteText(std::string text, RECT* destinationRect, D3DXCOLOR textColor, 
+		AlignHorizontal alignHor, AlignVertical alignVert);
+	void ChangeFontName(TCHAR* newName);
+	void ChangeSize(int newSize);
+	void ChangeBoldItalic(bool italic, bool bold);
+	int GetSize();
+
+private:
+	ID3DX10Font* mFont;
+	D3DX10_FONT_DESC mFontDesc;
+	ID3D10Device* mGraphicsDevice;
+};
+
 #endif
\ No newline at end of file
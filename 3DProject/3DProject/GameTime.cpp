@@ -1,44 +1,150 @@
-#include "GameTime.h"
-
-// Constructor - initialize the game time, set start values for teh time stamps and calculate the length of a tick
-GameTime::GameTime() 
-	:mPrevTimeStamp(0), mGameStartTime(0), mMilliSecondsPerTick(0.0)
-{
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mMilliSecondsPerTick = 1000.0 / (double)countsPerSec;
-
-	QueryPerformanceCounter((LARGE_INTEGER*)&mGameStartTime);
-	Update();
-}
-
-GameTime::~GameTime()
-{
-}
-
-// Update the game time by calculating new values for elapsed time and getting new time stamp values
-void GameTime::Update()
-{
-	__int64 currTimeStamp = 0;
-	QueryPerformanceCounter((LARGE_INTEGER*) & currTimeStamp);
-
-	mElapsedSinceLastTick.Milliseconds = (currTimeStamp - mPrevTimeStamp) * mMilliSecondsPerTick;
-	mElapsedSinceLastTick.Seconds = mElapsedSinceLastTick.Milliseconds / 1000;
-
-	mElapsedSinceStart.Milliseconds = (currTimeStamp - mGameStartTime) * mMilliSecondsPerTick;
-	mElapsedSinceStart.Seconds = mElapsedSinceStart.Milliseconds / 1000;
-
-	mPrevTimeStamp = currTimeStamp;
-}
-
-// Get the time elapsed since last update
-Time GameTime::GetTimeSinceLastTick()
-{
-	return mElapsedSinceLastTick;
-}
-
-// Get the time elapsed since the game started
-Time GameTime::GetTimeSinceGameStart()
-{
-	return mElapsedSinceStart;
-}
\ No newline at end of file
+#include "GameTime.h"
+
+long long Clock::GetTicks()
+{
+#ifdef _WIN32
+	LARGE_INTEGER ticks;
+	QueryPerformanceCounter(&ticks);
+	return ticks.QuadPart;
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+#endif
+}
+
+long long Clock::GetTicksPerSecond()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return frequency.QuadPart;
+#else
+	return 1000000000LL;
+#endif
+}
+
+// Constructor - initialize the game time, set start values for teh time stamps and calculate the length of a tick
+GameTime::GameTime() 
+	:mPrevTimeStamp(0), mGameStartTime(0), mMilliSecondsPerTick(0.0)
+{
+	mMilliSecondsPerTick = 1000.0 / (double)Clock::GetTicksPerSecond();
+
+	mGameStartTime = Clock::GetTicks();
+	Update();
+}
+
+GameTime::~GameTime()
+{
+}
+
+// Update the game time by calculating new values for elapsed time and getting new time stamp values
+void GameTime::Update()
+{
+	long long currTimeStamp = Clock::GetTicks();
+
+	mElapsedSinceLastTick.Milliseconds = (currTimeStamp - mPrevTimeStamp) * mMilliSecondsPerTick;
+	mElapsedSinceLastTick.Seconds = mElapsedSinceLastTick.Milliseconds / 1000;
+
+	mElapsedSinceStart.Milliseconds = (currTimeStamp - mGameStartTime) * mMilliSecondsPerTick;
+	mElapsedSinceStart.Seconds = mElapsedSinceStart.Milliseconds / 1000;
+
+	mPrevTimeStamp = currTimeStamp;
+}
+
+// Get the time elapsed since last update
+Time GameTime::GetTimeSinceLastTick() const
+{
+	return mElapsedSinceLastTick;
+}
+
+// Get the time elapsed since the game started
+Time GameTime::GetTimeSinceGameStart() const
+{
+	return mElapsedSinceStart;
+}
+
+// Constructor - calculate the length of a tick
+Stopwatch::Stopwatch()
+	: mStartTimeStamp(0), mMilliSecondsPerTick(0.0)
+{
+	mMilliSecondsPerTick = 1000.0 / (double)Clock::GetTicksPerSecond();
+}
+
+// Save the current time stamp as the start of the measurement
+void Stopwatch::Start()
+{
+	mStartTimeStamp = Clock::GetTicks();
+}
+
+// Get the time elapsed since Start was called
+Time Stopwatch::Stop() const
+{
+	long long currTimeStamp = Clock::GetTicks();
+
+	Time elapsed;
+	elapsed.Milliseconds = (currTimeStamp - mStartTimeStamp) * mMilliSecondsPerTick;
+	elapsed.Seconds = elapsed.Milliseconds / 1000;
+
+	return elapsed;
+}
+
+FixedTimestep::FixedTimestep(int stepsPerSecond, int maxSteps)
+	: mStepsPerSecond(stepsPerSecond), mMaxSteps(maxSteps), mAccumulator(0.0),
+	  mDroppedMilliseconds(0.0)
+{
+}
+
+// Add the time of a frame and return how many steps to simulate for it
+int FixedTimestep::Advance(const Time& elapsed)
+{
+	double stepSeconds = 1.0 / mStepsPerSecond;
+	mAccumulator += elapsed.Seconds;
+
+	int numSteps = (int)(mAccumulator / stepSeconds);
+	if(numSteps > mMaxSteps)
+	{
+		mDroppedMilliseconds += (mAccumulator - mMaxSteps * stepSeconds) * 1000.0;
+		mAccumulator = mMaxSteps * stepSeconds;
+		numSteps = mMaxSteps;
+	}
+
+	mAccumulator -= numSteps * stepSeconds;
+	return numSteps;
+}
+
+// Change the tick rate, the time already carried over is kept
+void FixedTimestep::SetStepsPerSecond(int stepsPerSecond)
+{
+	mStepsPerSecond = stepsPerSecond;
+}
+
+// Most steps that one frame may take to catch up
+void FixedTimestep::SetMaxSteps(int maxSteps)
+{
+	mMaxSteps = maxSteps;
+}
+
+int FixedTimestep::GetStepsPerSecond() const
+{
+	return mStepsPerSecond;
+}
+
+// The step every simulation update is given, the same every time
+float FixedTimestep::GetStepSeconds() const
+{
+	return 1.0f / mStepsPerSecond;
+}
+
+// How far between the previous and the last simulation state the drawing is, from 0 to 1
+float FixedTimestep::GetAlpha() const
+{
+	float alpha = (float)(mAccumulator * mStepsPerSecond);
+	return alpha < 1.0f ? alpha : 1.0f;
+}
+
+// Frame time that was thrown away because the simulation could not keep up
+double FixedTimestep::GetDroppedMilliseconds() const
+{
+	return mDroppedMilliseconds;
+}
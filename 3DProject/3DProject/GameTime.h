@@ -1,31 +1,80 @@
-#ifndef GAMETIME_H
-#define GAMETIME_H
-
-#include <Windows.h>
-
-struct Time
-{
-	double Milliseconds;
-	double Seconds;
-};
-
-class GameTime
-{
-public:
-	GameTime();
-	~GameTime();
-	void Update();
-	Time GetTimeSinceLastTick();
-	Time GetTimeSinceGameStart();
-
-private:
-	__int64 mPrevTimeStamp;
-	__int64 mGameStartTime;
-
-	double mMilliSecondsPerTick;
-
-	Time mElapsedSinceStart;
-	Time mElapsedSinceLastTick;
-};
-
-#endif
\ No newline at end of file
+#ifndef GAMETIME_H
+#define GAMETIME_H
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+struct Time
+{
+	double Milliseconds;
+	double Seconds;
+};
+
+// Monotonic high resolution clock, QueryPerformanceCounter on Windows and CLOCK_MONOTONIC elsewhere
+namespace Clock
+{
+	long long GetTicks();
+	long long GetTicksPerSecond();
+}
+
+class GameTime
+{
+public:
+	GameTime();
+	~GameTime();
+	void Update();
+	Time GetTimeSinceLastTick() const;
+	Time GetTimeSinceGameStart() const;
+
+private:
+	long long mPrevTimeStamp;
+	long long mGameStartTime;
+
+	double mMilliSecondsPerTick;
+
+	Time mElapsedSinceStart;
+	Time mElapsedSinceLastTick;
+};
+
+// Measures the time spent in a block of code, used to report the cost of the systems each frame
+class Stopwatch
+{
+public:
+	Stopwatch();
+	void Start();
+	Time Stop() const;
+
+private:
+	long long mStartTimeStamp;
+
+	double mMilliSecondsPerTick;
+};
+
+// Splits the variable frame time into a whole number of fixed simulation steps. What is left over
+// is carried to the next frame, and as a fraction of a step it is how far the drawing should blend
+// from the previous simulation state towards the last one. Time that cannot be caught up with the
+// maximum number of steps is dropped, so a slow frame does not make the next ones slower.
+class FixedTimestep
+{
+public:
+	FixedTimestep(int stepsPerSecond, int maxSteps);
+	int Advance(const Time& elapsed);
+	void SetStepsPerSecond(int stepsPerSecond);
+	void SetMaxSteps(int maxSteps);
+
+	int GetStepsPerSecond() const;
+	float GetStepSeconds() const;
+	float GetAlpha() const;
+	double GetDroppedMilliseconds() const;
+
+private:
+	int mStepsPerSecond;
+	int mMaxSteps;
+	double mAccumulator;				// Seconds not yet simulated
+	double mDroppedMilliseconds;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer()
+	: mDevice(NULL), mCurrent(0), mMeasuring(false), mMilliseconds(0.0)
+{
+	ZeroMemory(mFrames, sizeof(mFrames));
+}
+
+GpuTimer::~GpuTimer()
+{
+	if(mDevice == NULL)
+		return;
+
+	for(int i = 0; i < C_FRAMES; ++i)
+	{
+		mDevice->ReleaseQuery(mFrames[i].Disjoint);
+		mDevice->ReleaseQuery(mFrames[i].Start);
+		mDevice->ReleaseQuery(mFrames[i].End);
+	}
+}
+
+void GpuTimer::Initialize(RenderDevice* device)
+{
+	mDevice = device;
+
+	for(int i = 0; i < C_FRAMES; ++i)
+	{
+		mFrames[i].Disjoint = mDevice->CreateQuery(RenderQueryTimestampDisjoint);
+		mFrames[i].Start = mDevice->CreateQuery(RenderQueryTimestamp);
+		mFrames[i].End = mDevice->CreateQuery(RenderQueryTimestamp);
+		if(mFrames[i].Disjoint == NULL || mFrames[i].Start == NULL || mFrames[i].End == NULL)
+		{
+			MessageBox(0, "Error Creating Timer Queries", "", 0);
+			return;
+		}
+	}
+}
+
+// Start timing, unless the GPU has not yet finished the frame that last used these queries
+void GpuTimer::Begin()
+{
+	ReadResults();
+
+	Frame& frame = mFrames[mCurrent];
+	mMeasuring = frame.Disjoint != NULL && !frame.Pending;
+	if(!mMeasuring)
+		return;
+
+	mDevice->BeginQuery(frame.Disjoint);
+	mDevice->EndQuery(frame.Start);
+}
+
+void GpuTimer::End()
+{
+	if(!mMeasuring)
+		return;
+
+	Frame& frame = mFrames[mCurrent];
+	mDevice->EndQuery(frame.End);
+	mDevice->EndQuery(frame.Disjoint);
+	frame.Pending = true;
+
+	mCurrent = (mCurrent + 1) % C_FRAMES;
+	mMeasuring = false;
+}
+
+double GpuTimer::GetMilliseconds() const
+{
+	return mMilliseconds;
+}
+
+// Read the frames the GPU has finished, oldest first so the newest time is kept
+void GpuTimer::ReadResults()
+{
+	for(int i = 0; i < C_FRAMES; ++i)
+	{
+		Frame& frame = mFrames[(mCurrent + i) % C_FRAMES];
+		if(!frame.Pending)
+			continue;
+
+		UINT64 frequency = 0;
+		bool disjoint = false;
+		if(!mDevice->GetTimestampFrequency(frame.Disjoint, frequency, disjoint))
+			continue;
+
+		UINT64 start = 0;
+		UINT64 end = 0;
+		if(!mDevice->GetTimestamp(frame.Start, start) || !mDevice->GetTimestamp(frame.End, end))
+			continue;
+
+		// A disjoint frame had its clock changed, its timestamps cannot be compared
+		if(!disjoint && frequency > 0)
+			mMilliseconds = (double)(end - start) * 1000.0 / (double)frequency;
+		frame.Pending = false;
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "RenderDevice.h"
+
+// Time the GPU spends on the commands between Begin and End. The queries are read a few frames
+// later without waiting for them, so the time is that of the latest frame the GPU has finished.
+class GpuTimer
+{
+public:
+	GpuTimer();
+	~GpuTimer();
+	void Initialize(RenderDevice* device);
+	void Begin();
+	void End();
+
+	double GetMilliseconds() const;
+
+private:
+	struct Frame
+	{
+		RenderQuery				Disjoint;
+		RenderQuery				Start;
+		RenderQuery				End;
+		bool					Pending;			// Issued but not read back yet
+	};
+
+	static const int			C_FRAMES = 4;
+
+	RenderDevice*				mDevice;
+	Frame						mFrames[C_FRAMES];
+	int							mCurrent;
+	bool						mMeasuring;
+	double						mMilliseconds;
+
+	GpuTimer(const GpuTimer&);
+	GpuTimer& operator=(const GpuTimer&);
+
+	void ReadResults();
+};
+#endif
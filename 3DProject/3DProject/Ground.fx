@@ -1,140 +1,301 @@
-struct VS_INPUT
-{
-	float3		position	: POSITION;
-	float2		uv			: UV;
-};
-
-struct PS_INPUT
-{
-	float4		position	: SV_POSITION;
-	float3		positionW	: POSITION;
-	float2		uv			: UV;
-};
-
-RasterizerState NoCulling
-{
-	CullMode = None;
-	//FillMode = Wireframe;
-};
-
-DepthStencilState EnableDepth
-{
-	DepthEnable = TRUE;
-	DepthWriteMask = ALL;
-	DepthFunc = LESS_EQUAL;
-};
-
-SamplerState linearSampler {
-	Filter = MIN_MAG_MIP_LINEAR;
-	AddressU = Wrap;
-	AddressV = Wrap;
-};
-
-SamplerState pointSampler {
-	Filter = MIN_MAG_MIP_POINT;
-	AddressU = Clamp;
-	AddressV = Clamp;
-};
-
-cbuffer cbEveryFrame
-{
-	matrix gWVP;
-	matrix gLightWVP;
-	bool gPCF;
-	float gSMWidth;
-	float gSMWidthInv;
-};
-
-float gSMEpsilon = 0.001f;
-Texture2D gTextureGround;
-Texture2D gShadowMapTex;
-
-// ************************************************************************
-// ** HELPER FUNCTIONS
-// ************************************************************************
-
-float CalcShadowFactor(float2 uv, float depth)
-{
-	float shadowDepth = gShadowMapTex.Sample(pointSampler, uv).r;
-
-	float shadowFactor = 1.0f;
-
-	if (depth > shadowDepth)
-		shadowFactor = shadowDepth;
-
-	return shadowFactor;
-}
-
-float CalcShadowFactorPCF(float2 uv, float depth)
-{
-	//if(uv.x < -1.0f || uv.x > 1.0f)
-		//return 0.0f;
-	//if(uv.y < -1.0f || uv.y > 1.0f)
-		//return 0.0f;
-	//if(depth < 0.0f)
-		//return 0.0f;
-
-	float sample0 = gShadowMapTex.Sample(pointSampler, uv).r;
-	float sample1 = gShadowMapTex.Sample(pointSampler, uv + float2(gSMWidthInv, 0.0f)).r;
-	float sample2 = gShadowMapTex.Sample(pointSampler, uv + float2(0.0f, gSMWidthInv)).r;
-	float sample3 = gShadowMapTex.Sample(pointSampler, uv + float2(gSMWidthInv, gSMWidthInv)).r;
-
-	float depth0 = depth <= sample0 + gSMEpsilon;
-	float depth1 = depth <= sample1 + gSMEpsilon;
-	float depth2 = depth <= sample2 + gSMEpsilon;
-	float depth3 = depth <= sample3 + gSMEpsilon;
-
-	float2 texPos = uv * gSMWidth;
-
-	float2 t = frac(texPos);
-
-	return lerp(lerp(depth0, depth1, t.x), lerp(depth2, depth3, t.x), t.y);
-}
-
-// ************************************************************************
-// ** SHADER FUNCTIONS
-// ************************************************************************
-PS_INPUT VS(VS_INPUT input)
-{
-	PS_INPUT output;
-
-	output.position = mul(float4(input.position, 1.0f), gWVP);
-	output.positionW = input.position;
-	output.uv = input.uv;
-
-	return output;
-}
-
-float4 PS(PS_INPUT input) : SV_Target0
-{
-	float4 texColor = gTextureGround.Sample(linearSampler, input.uv);
-
-	// Calculate shadows
-	float4 posLightWVP = mul(float4(input.positionW, 1.0f), gLightWVP);
-	posLightWVP /= posLightWVP.w;
-
-	posLightWVP.x = posLightWVP.x * 0.5f + 0.5f;
-	posLightWVP.y = posLightWVP.y * -0.5f + 0.5f;
-
-	if(gPCF)
-		return texColor * CalcShadowFactorPCF(posLightWVP.xy, posLightWVP.z);
-	else
-		return texColor * CalcShadowFactor(posLightWVP.xy, posLightWVP.z);
-}
-
-// ************************************************************************
-// ** TECHNIQUES
-// ************************************************************************
-technique10 DrawTechnique
-{
-	pass P0
-	{
-		SetVertexShader(CompileShader(vs_4_0, VS()));
-		SetGeometryShader(NULL);
-		SetPixelShader(CompileShader(ps_4_0, PS()));
-
-		SetRasterizerState(NoCulling);
-		SetDepthStencilState(EnableDepth, 0xff);
-	}
-}
-
+struct VS_INPUT
+{
+	float3		position	: POSITION;
+	float2		uv			: UV;
+};
+
+struct PS_INPUT
+{
+	float4		position	: SV_POSITION;
+	float3		positionW	: POSITION;
+	float2		uv			: UV;
+};
+
+RasterizerState NoCulling
+{
+	CullMode = None;
+	//FillMode = Wireframe;
+};
+
+DepthStencilState EnableDepth
+{
+	DepthEnable = TRUE;
+	DepthWriteMask = ALL;
+	DepthFunc = LESS_EQUAL;
+};
+
+SamplerState linearSampler {
+	Filter = MIN_MAG_MIP_LINEAR;
+	AddressU = Wrap;
+	AddressV = Wrap;
+};
+
+SamplerState clampSampler {
+	Filter = MIN_MAG_MIP_LINEAR;
+	AddressU = Clamp;
+	AddressV = Clamp;
+};
+
+cbuffer cbEveryFrame
+{
+	matrix gWVP;
+};
+
+float gAmbient = 0.3f;
+Texture2D gTextureGround;
+Texture2D gShadowMask;					// Filtered in screen space by ShadowMask.fx
+
+// The point light's cube, set by PointShadowEffectVariables
+TextureCube gPointShadowMap;
+float3 gPointLightPosition;
+float2 gPointDepthParams;				// A face's depth is x + y / distance along the face's axis
+float gPointEpsilon = 0.0002f;
+
+// The spot lights, set by SpotLightEffectVariables. Each light's matrix takes a world position to
+// its tile of the atlas, color.a is 0 for a light without a tile.
+cbuffer cbSpotLights
+{
+	matrix gSpotShadowMatrix[64];
+	float4 gSpotPositionRange[64];		// Position, range
+	float4 gSpotDirectionCos[64];		// Direction, cosine of half the cone's angle
+	float4 gSpotColor[64];
+	int gSpotLightCount = 0;
+};
+
+float gSpotEpsilon = 0.0002f;
+Texture2D gShadowAtlas;
+
+// Baked on the CPU: r is the direct light shadowed by static geometry, g the ambient occlusion
+Texture2D gLightmap;
+bool gUseLightmap;
+float4 gLightmapRect;		// Min x, max z, 1 / width, 1 / depth
+
+// ************************************************************************
+// ** SHADOW FILTERS
+// ************************************************************************
+
+#include "ShadowFilters.fxh"
+
+// Not a filter: the pixel's texel of the mask that ShadowMask.fx filtered with one of the above
+#define SHADOW_MASK				6
+
+// Not a filter either: one tap into the cube of PointShadowMap, lit from the light's position
+#define SHADOW_POINT			7
+
+SamplerComparisonState pointShadowSampler
+{
+	Filter = COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+	AddressU = Clamp;
+	AddressV = Clamp;
+	AddressW = Clamp;
+	ComparisonFunc = LESS_EQUAL;
+};
+
+// The cube face a direction falls on is the one of its largest component, the depth the face's
+// projection gave the pixel follows from that component alone
+float CalcPointShadowFactor(float3 positionW)
+{
+	float3 fromLight = positionW - gPointLightPosition;
+	float3 distances = abs(fromLight);
+	float faceDistance = max(distances.x, max(distances.y, distances.z));
+	float depth = gPointDepthParams.x + gPointDepthParams.y / faceDistance;
+
+	return gPointShadowMap.SampleCmpLevelZero(pointShadowSampler, fromLight, depth - gPointEpsilon);
+}
+
+// The pixel's shadow, read from the screen-space mask or the point light's cube or filtered here
+float CalcShadowFactor(float3 positionW, float2 screenPosition, uniform int shadowFilter)
+{
+	if(shadowFilter == SHADOW_MASK)
+		return gShadowMask.Load(int3((int2)screenPosition, 0)).r;
+	if(shadowFilter == SHADOW_POINT)
+		return CalcPointShadowFactor(positionW);
+
+	return CalcCascadeShadowFactor(positionW, screenPosition, shadowFilter);
+}
+
+// ************************************************************************
+// ** SPOT LIGHTS
+// ************************************************************************
+
+// The light of every spot light on the floor, whose normal points up. One comparison tap into the
+// light's tile, the frustum around the cone keeps the tap inside it.
+float3 CalcSpotLights(float3 positionW)
+{
+	float3 light = 0.0f;
+	for(int i = 0; i < gSpotLightCount; ++i)
+	{
+		float3 toLight = gSpotPositionRange[i].xyz - positionW;
+		float lightDistance = length(toLight);
+		float3 direction = toLight / lightDistance;
+
+		float cosCone = gSpotDirectionCos[i].w;
+		float cone = saturate((dot(-direction, gSpotDirectionCos[i].xyz) - cosCone) / (1.0f - cosCone));
+		float falloff = saturate(1.0f - lightDistance / gSpotPositionRange[i].w);
+		float attenuation = cone * falloff * falloff * saturate(direction.y);
+
+		if(attenuation > 0.0f && gSpotColor[i].a > 0.0f)
+		{
+			float4 posAtlas = mul(float4(positionW, 1.0f), gSpotShadowMatrix[i]);
+			posAtlas.xyz /= posAtlas.w;
+			attenuation *= gShadowAtlas.SampleCmpLevelZero(shadowSampler, posAtlas.xy, posAtlas.z - gSpotEpsilon);
+		}
+
+		light += gSpotColor[i].rgb * attenuation;
+	}
+
+	return light;
+}
+
+// ************************************************************************
+// ** SHADER FUNCTIONS
+// ************************************************************************
+PS_INPUT VS(VS_INPUT input)
+{
+	PS_INPUT output;
+
+	output.position = mul(float4(input.position, 1.0f), gWVP);
+	output.positionW = input.position;
+	output.uv = input.uv;
+
+	return output;
+}
+
+float4 PS(PS_INPUT input, uniform int shadowFilter) : SV_Target0
+{
+	float4 texColor = gTextureGround.Sample(linearSampler, input.uv);
+
+	float shadowFactor = CalcShadowFactor(input.positionW, input.position.xy, shadowFilter);
+	float4 spotLight = float4(CalcSpotLights(input.positionW), 0.0f);
+
+	// The shadow map is only needed for the moving objects, the static light comes from the lightmap
+	if(gUseLightmap)
+	{
+		float2 lightmapUV = float2(input.positionW.x - gLightmapRect.x, gLightmapRect.y - input.positionW.z);
+		float2 baked = gLightmap.Sample(clampSampler, lightmapUV * gLightmapRect.zw).rg;
+		return texColor * (gAmbient * baked.g + (1.0f - gAmbient) * baked.r * shadowFactor + spotLight);
+	}
+
+	return texColor * (shadowFactor + spotLight);
+}
+
+// ************************************************************************
+// ** TECHNIQUES
+// ************************************************************************
+technique10 DrawTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_2X2)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPCF3x3Technique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_3X3)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPCF5x5Technique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_5X5)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPoissonTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_POISSON)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_VSM)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawEVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_FILTER_EVSM)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawShadowMaskTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_MASK)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+technique10 DrawPointShadowTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PS(SHADOW_POINT)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
+
+// Depth only, for the pre-pass of the shadow mask
+technique10 DrawDepthTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(NULL);
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
@@ -0,0 +1,1508 @@
+#include "HeadlessRenderDevice.h"
+#include <sstream>
+
+const int HeadlessRenderDevice::C_MAX_ERRORS = 64;
+
+namespace
+{
+	// Triangles drawn from a number of vertices or indices, none for points and lines
+	int CountTriangles(RenderTopology topology, UINT count)
+	{
+		if(topology == RenderTopologyTriangleList)
+			return count / 3;
+		if(topology == RenderTopologyTriangleStrip)
+			return count >= 3 ? count - 2 : 0;
+		return 0;
+	}
+
+	int IndexSize(RenderFormat format)
+	{
+		if(format == RenderFormatR16Uint)
+			return 2;
+		if(format == RenderFormatR32Uint)
+			return 4;
+		return 0;
+	}
+
+	template<typename T>
+	void DeleteRecords(std::vector<T*>& records)
+	{
+		for(size_t i = 0; i < records.size(); ++i)
+			delete records[i];
+		records.clear();
+	}
+}
+
+HeadlessRenderDevice::HeadlessRenderDevice()
+	: mTarget(NULL), mBackBuffer(NULL), mBackBufferDepth(NULL), mInputLayout(NULL), mTopology(RenderTopologyUndefined),
+	  mVertexBuffer(C_NO_BUFFER), mVertexStride(0), mIndexBuffer(C_NO_BUFFER), mIndexFormat(RenderFormatUnknown),
+	  mPass(NULL), mDepthStencil(NULL), mRecording(false)
+{
+	ZeroMemory(&mViewport, sizeof(mViewport));
+	ZeroMemory(&mFrameStatistics, sizeof(mFrameStatistics));
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+// Only the records are deleted, what the target device made is released by whoever made it
+HeadlessRenderDevice::~HeadlessRenderDevice()
+{
+	DeleteRecords(mTextures);
+	DeleteRecords(mViews);
+	DeleteRecords(mEffects);
+	DeleteRecords(mTechniques);
+	DeleteRecords(mPasses);
+	DeleteRecords(mVariables);
+	DeleteRecords(mLayouts);
+	DeleteRecords(mQueries);
+}
+
+// The device every call is passed on to, NULL to draw nothing
+void HeadlessRenderDevice::Initialize(RenderDevice* target)
+{
+	mTarget = target;
+}
+
+// Keep the statistics of the frame that ended and start counting the next. The state that is bound
+// carries over, as it does on the GPU.
+void HeadlessRenderDevice::BeginFrame()
+{
+	mStatistics = mFrameStatistics;
+
+	RenderDeviceStatistics alive = mFrameStatistics;
+	ZeroMemory(&mFrameStatistics, sizeof(mFrameStatistics));
+	mFrameStatistics.Buffers = alive.Buffers;
+	mFrameStatistics.BufferBytes = alive.BufferBytes;
+	mFrameStatistics.Textures = alive.Textures;
+	mFrameStatistics.TextureBytes = alive.TextureBytes;
+
+	Record("BeginFrame");
+
+	if(mTarget != NULL)
+		mTarget->BeginFrame();
+}
+
+// Handles are never given out twice, so a released buffer that is used again is caught
+RenderBuffer HeadlessRenderDevice::CreateBuffer(const RenderBufferDesc& desc, const void* data)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "CreateBuffer " << desc.Bytes << " bytes, bind flags " << desc.BindFlags << ", usage " << desc.Usage;
+		Record(command.str());
+	}
+
+	if(desc.Bytes <= 0)
+	{
+		Error("CreateBuffer: the buffer is empty");
+		return C_NO_BUFFER;
+	}
+	if(desc.Usage == RenderUsageImmutable && data == NULL)
+	{
+		Error("CreateBuffer: an immutable buffer needs its contents");
+		return C_NO_BUFFER;
+	}
+
+	BufferRecord record(desc);
+	if(mTarget != NULL)
+	{
+		record.Target = mTarget->CreateBuffer(desc, data);
+		if(record.Target == C_NO_BUFFER)
+		{
+			Error("CreateBuffer: the target device could not create the buffer");
+			return C_NO_BUFFER;
+		}
+	}
+
+	mBuffers.push_back(record);
+	++mFrameStatistics.Buffers;
+	mFrameStatistics.BufferBytes += desc.Bytes;
+	if(data != NULL)
+		mFrameStatistics.BytesUploaded += desc.Bytes;
+
+	return (RenderBuffer)mBuffers.size() - 1;
+}
+
+void HeadlessRenderDevice::ReleaseBuffer(RenderBuffer buffer)
+{
+	if(buffer == C_NO_BUFFER)
+		return;
+
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "ReleaseBuffer " << buffer;
+		Record(command.str());
+	}
+
+	if(!IsAlive(buffer))
+	{
+		Error("ReleaseBuffer: the buffer was never created or is already released");
+		return;
+	}
+
+	BufferRecord& record = mBuffers[buffer];
+	record.Alive = false;
+	--mFrameStatistics.Buffers;
+	mFrameStatistics.BufferBytes -= record.Desc.Bytes;
+
+	if(mVertexBuffer == buffer)
+		mVertexBuffer = C_NO_BUFFER;
+	if(mIndexBuffer == buffer)
+		mIndexBuffer = C_NO_BUFFER;
+
+	if(mTarget != NULL)
+		mTarget->ReleaseBuffer(record.Target);
+}
+
+void HeadlessRenderDevice::UpdateBuffer(RenderBuffer buffer, const void* data, int bytes)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "UpdateBuffer " << buffer << ", " << bytes << " bytes";
+		Record(command.str());
+	}
+
+	if(!IsAlive(buffer))
+	{
+		Error("UpdateBuffer: the buffer was never created or is already released");
+		return;
+	}
+
+	const BufferRecord& record = mBuffers[buffer];
+	if(record.Desc.Usage != RenderUsageDynamic)
+		Error("UpdateBuffer: the buffer is not dynamic");
+	if(bytes <= 0 || bytes > record.Desc.Bytes || data == NULL)
+	{
+		Error("UpdateBuffer: the data does not fit the buffer");
+		return;
+	}
+
+	mFrameStatistics.BytesUploaded += bytes;
+
+	if(mTarget != NULL)
+		mTarget->UpdateBuffer(record.Target, data, bytes);
+}
+
+RenderTexture HeadlessRenderDevice::CreateTexture(const RenderTextureDesc& desc, const void* data, int rowBytes)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "CreateTexture " << mTextures.size() << ": " << desc.Width << "x" << desc.Height << "x" << desc.ArraySize;
+		command << ", " << desc.MipLevels << " mips, format " << desc.Format << ", bind flags " << desc.BindFlags;
+		command << ", usage " << desc.Usage << (desc.Cube ? ", cube" : "");
+		Record(command.str());
+	}
+
+	if(desc.Width <= 0 || desc.Height <= 0 || desc.ArraySize <= 0)
+	{
+		Error("CreateTexture: the texture is empty");
+		return NULL;
+	}
+	if(desc.Usage == RenderUsageImmutable && data == NULL)
+	{
+		Error("CreateTexture: an immutable texture needs its contents");
+		return NULL;
+	}
+	if(data != NULL && rowBytes <= 0)
+	{
+		Error("CreateTexture: the contents have no rows");
+		return NULL;
+	}
+	if(desc.Usage != RenderUsageDefault && (desc.BindFlags & (RenderBindRenderTarget | RenderBindDepthStencil)) != 0)
+		Error("CreateTexture: only a texture written by the GPU can be drawn into");
+	if(desc.Cube && desc.ArraySize % 6 != 0)
+		Error("CreateTexture: a cube texture has six faces");
+
+	TextureRecord* record = new TextureRecord((int)mTextures.size(), desc);
+	if(mTarget != NULL)
+	{
+		record->Target = mTarget->CreateTexture(desc, data, rowBytes);
+		if(record->Target == NULL)
+		{
+			Error("CreateTexture: the target device could not create the texture");
+			delete record;
+			return NULL;
+		}
+	}
+
+	mTextures.push_back(record);
+	++mFrameStatistics.Textures;
+	mFrameStatistics.TextureBytes += GetTextureBytes(desc);
+	if(data != NULL)
+		mFrameStatistics.BytesUploaded += rowBytes * desc.Height * desc.ArraySize;
+
+	return reinterpret_cast<RenderTexture>(record);
+}
+
+void HeadlessRenderDevice::ReleaseTexture(RenderTexture texture)
+{
+	TextureRecord* record = ToRecord(texture);
+	if(record == NULL)
+		return;
+
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "ReleaseTexture " << record->Id;
+		Record(command.str());
+	}
+
+	if(!record->Alive)
+	{
+		Error("ReleaseTexture: the texture is already released");
+		return;
+	}
+
+	record->Alive = false;
+	--mFrameStatistics.Textures;
+	mFrameStatistics.TextureBytes -= GetTextureBytes(record->Desc);
+
+	if(mTarget != NULL)
+		mTarget->ReleaseTexture(record->Target);
+}
+
+void HeadlessRenderDevice::UpdateTexture(RenderTexture texture, const void* data, int rowBytes, int rows)
+{
+	TextureRecord* record = ToRecord(texture);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "UpdateTexture " << (record != NULL ? record->Id : -1) << ", " << rows << " rows of " << rowBytes << " bytes";
+		Record(command.str());
+	}
+
+	if(record == NULL || !record->Alive)
+	{
+		Error("UpdateTexture: no texture or it is released");
+		return;
+	}
+	if(record->Desc.Usage != RenderUsageDynamic)
+		Error("UpdateTexture: the texture is not dynamic");
+
+	// Only the top mip of the first slice is written
+	RenderTextureDesc top = record->Desc;
+	top.ArraySize = 1;
+	top.MipLevels = 1;
+	if(data == NULL || rowBytes <= 0 || rows <= 0 || rows > top.Height || rowBytes * rows > GetTextureBytes(top))
+	{
+		Error("UpdateTexture: the data does not fit the texture");
+		return;
+	}
+
+	mFrameStatistics.BytesUploaded += rowBytes * rows;
+
+	if(mTarget != NULL)
+		mTarget->UpdateTexture(record->Target, data, rowBytes, rows);
+}
+
+void HeadlessRenderDevice::CopyTexture(RenderTexture destination, RenderTexture source)
+{
+	TextureRecord* destinationRecord = ToRecord(destination);
+	TextureRecord* sourceRecord = ToRecord(source);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "CopyTexture " << (destinationRecord != NULL ? destinationRecord->Id : -1) << " from ";
+		command << (sourceRecord != NULL ? sourceRecord->Id : -1);
+		Record(command.str());
+	}
+
+	if(destinationRecord == NULL || sourceRecord == NULL || !destinationRecord->Alive || !sourceRecord->Alive)
+	{
+		Error("CopyTexture: no texture or it is released");
+		return;
+	}
+
+	const RenderTextureDesc& to = destinationRecord->Desc;
+	const RenderTextureDesc& from = sourceRecord->Desc;
+	if(to.Width != from.Width || to.Height != from.Height || to.ArraySize != from.ArraySize ||
+	   to.MipLevels != from.MipLevels || to.Format != from.Format)
+		Error("CopyTexture: the textures are not described the same");
+	if(to.Usage == RenderUsageImmutable)
+		Error("CopyTexture: the destination is immutable");
+
+	if(mTarget != NULL)
+		mTarget->CopyTexture(destinationRecord->Target, sourceRecord->Target);
+}
+
+// Without a target nothing is read, the view stands for whatever the file holds
+RenderShaderView HeadlessRenderDevice::LoadTexture(const char* filename)
+{
+	if(mRecording)
+		Record(std::string("LoadTexture ") + filename);
+
+	RenderShaderView target = NULL;
+	if(mTarget != NULL)
+	{
+		target = mTarget->LoadTexture(filename);
+		if(target == NULL)
+		{
+			Error(std::string("LoadTexture: the target device could not load ") + filename);
+			return NULL;
+		}
+	}
+
+	ViewRecord* record = new ViewRecord();
+	record->Id = (int)mViews.size();
+	record->Texture = NULL;
+	record->FirstSlice = 0;
+	record->NumSlices = 1;
+	record->ShaderTarget = target;
+	record->RenderTarget = NULL;
+	record->DepthTarget = NULL;
+	record->BackBuffer = false;
+	record->Alive = true;
+	mViews.push_back(record);
+
+	return reinterpret_cast<RenderShaderView>(record);
+}
+
+RenderShaderView HeadlessRenderDevice::CreateShaderView(RenderTexture texture, RenderViewType type)
+{
+	TextureRecord* textureRecord = ToRecord(texture);
+	int numSlices = textureRecord != NULL ? textureRecord->Desc.ArraySize : 0;
+	ViewRecord* record = CreateView("CreateShaderView", texture, RenderBindShaderResource, 0, numSlices);
+	if(record == NULL)
+		return NULL;
+
+	if(type == RenderViewTextureCube && !textureRecord->Desc.Cube)
+		Error("CreateShaderView: the texture is not a cube");
+	if(type == RenderViewTexture2D && numSlices != 1)
+		Error("CreateShaderView: a 2D view of an array only sees its first slice");
+
+	if(mTarget != NULL)
+	{
+		record->ShaderTarget = mTarget->CreateShaderView(textureRecord->Target, type);
+		if(record->ShaderTarget == NULL)
+		{
+			Error("CreateShaderView: the target device could not create the view");
+			record->Alive = false;
+			return NULL;
+		}
+	}
+
+	return reinterpret_cast<RenderShaderView>(record);
+}
+
+RenderTargetView HeadlessRenderDevice::CreateRenderTargetView(RenderTexture texture, int firstSlice, int numSlices)
+{
+	ViewRecord* record = CreateView("CreateRenderTargetView", texture, RenderBindRenderTarget, firstSlice, numSlices);
+	if(record == NULL)
+		return NULL;
+
+	if(mTarget != NULL)
+	{
+		record->RenderTarget = mTarget->CreateRenderTargetView(record->Texture->Target, firstSlice, numSlices);
+		if(record->RenderTarget == NULL)
+		{
+			Error("CreateRenderTargetView: the target device could not create the view");
+			record->Alive = false;
+			return NULL;
+		}
+	}
+
+	return reinterpret_cast<RenderTargetView>(record);
+}
+
+RenderDepthView HeadlessRenderDevice::CreateDepthView(RenderTexture texture, int firstSlice, int numSlices)
+{
+	ViewRecord* record = CreateView("CreateDepthView", texture, RenderBindDepthStencil, firstSlice, numSlices);
+	if(record == NULL)
+		return NULL;
+
+	if(mTarget != NULL)
+	{
+		record->DepthTarget = mTarget->CreateDepthView(record->Texture->Target, firstSlice, numSlices);
+		if(record->DepthTarget == NULL)
+		{
+			Error("CreateDepthView: the target device could not create the view");
+			record->Alive = false;
+			return NULL;
+		}
+	}
+
+	return reinterpret_cast<RenderDepthView>(record);
+}
+
+void HeadlessRenderDevice::ReleaseShaderView(RenderShaderView view)
+{
+	ViewRecord* record = ToRecord(view);
+	if(ReleaseView("ReleaseShaderView", record) && mTarget != NULL)
+		mTarget->ReleaseShaderView(record->ShaderTarget);
+}
+
+void HeadlessRenderDevice::ReleaseRenderTargetView(RenderTargetView view)
+{
+	ViewRecord* record = ToRecord(view);
+	if(ReleaseView("ReleaseRenderTargetView", record) && mTarget != NULL)
+		mTarget->ReleaseRenderTargetView(record->RenderTarget);
+}
+
+void HeadlessRenderDevice::ReleaseDepthView(RenderDepthView view)
+{
+	ViewRecord* record = ToRecord(view);
+	if(ReleaseView("ReleaseDepthView", record) && mTarget != NULL)
+		mTarget->ReleaseDepthView(record->DepthTarget);
+}
+
+void HeadlessRenderDevice::GenerateMips(RenderShaderView view)
+{
+	ViewRecord* record = ToRecord(view);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "GenerateMips " << (record != NULL ? record->Id : -1);
+		Record(command.str());
+	}
+
+	if(!CheckView("GenerateMips", record))
+		return;
+	if(record->Texture == NULL || record->Texture->Desc.MipLevels == 1 ||
+	   (record->Texture->Desc.BindFlags & RenderBindRenderTarget) == 0)
+	{
+		Error("GenerateMips: the texture is not a render target with mips");
+		return;
+	}
+
+	if(mTarget != NULL)
+		mTarget->GenerateMips(record->ShaderTarget);
+}
+
+// The same handle every frame, it is given the target's view of the frame each time it is asked for
+RenderTargetView HeadlessRenderDevice::GetBackBuffer()
+{
+	if(mBackBuffer == NULL)
+	{
+		mBackBuffer = new ViewRecord();
+		mBackBuffer->Id = (int)mViews.size();
+		mBackBuffer->Texture = NULL;
+		mBackBuffer->FirstSlice = 0;
+		mBackBuffer->NumSlices = 1;
+		mBackBuffer->ShaderTarget = NULL;
+		mBackBuffer->DepthTarget = NULL;
+		mBackBuffer->BackBuffer = true;
+		mBackBuffer->Alive = true;
+		mViews.push_back(mBackBuffer);
+	}
+
+	mBackBuffer->RenderTarget = mTarget != NULL ? mTarget->GetBackBuffer() : NULL;
+	return reinterpret_cast<RenderTargetView>(mBackBuffer);
+}
+
+RenderDepthView HeadlessRenderDevice::GetBackBufferDepth()
+{
+	if(mBackBufferDepth == NULL)
+	{
+		mBackBufferDepth = new ViewRecord();
+		mBackBufferDepth->Id = (int)mViews.size();
+		mBackBufferDepth->Texture = NULL;
+		mBackBufferDepth->FirstSlice = 0;
+		mBackBufferDepth->NumSlices = 1;
+		mBackBufferDepth->ShaderTarget = NULL;
+		mBackBufferDepth->RenderTarget = NULL;
+		mBackBufferDepth->BackBuffer = true;
+		mBackBufferDepth->Alive = true;
+		mViews.push_back(mBackBufferDepth);
+	}
+
+	mBackBufferDepth->DepthTarget = mTarget != NULL ? mTarget->GetBackBufferDepth() : NULL;
+	return reinterpret_cast<RenderDepthView>(mBackBufferDepth);
+}
+
+RenderEffect HeadlessRenderDevice::CreateEffect(const char* filename)
+{
+	if(mRecording)
+		Record(std::string("CreateEffect ") + filename);
+
+	RenderEffect target = NULL;
+	if(mTarget != NULL)
+	{
+		target = mTarget->CreateEffect(filename);
+		if(target == NULL)
+		{
+			Error(std::string("CreateEffect: the target device could not create ") + filename);
+			return NULL;
+		}
+	}
+
+	EffectRecord* record = new EffectRecord();
+	record->Name = filename;
+	record->Target = target;
+	record->Alive = true;
+	mEffects.push_back(record);
+
+	return reinterpret_cast<RenderEffect>(record);
+}
+
+void HeadlessRenderDevice::ReleaseEffect(RenderEffect effect)
+{
+	EffectRecord* record = ToRecord(effect);
+	if(record == NULL)
+		return;
+
+	if(mRecording)
+		Record("ReleaseEffect " + record->Name);
+
+	if(!record->Alive)
+	{
+		Error("ReleaseEffect: " + record->Name + " is already released");
+		return;
+	}
+
+	record->Alive = false;
+	if(mPass != NULL && mPass->Effect == record)
+		mPass = NULL;
+
+	if(mTarget != NULL)
+		mTarget->ReleaseEffect(record->Target);
+}
+
+// Asked for again, a name gives the same technique. One the target's effect does not have is NULL.
+RenderTechnique HeadlessRenderDevice::GetTechnique(RenderEffect effect, const char* name)
+{
+	EffectRecord* effectRecord = ToRecord(effect);
+	if(effectRecord == NULL || !effectRecord->Alive)
+	{
+		Error(std::string("GetTechnique: no effect for ") + name + " or it is released");
+		return NULL;
+	}
+
+	std::map<std::string, TechniqueRecord*>::iterator it = effectRecord->Techniques.find(name);
+	if(it != effectRecord->Techniques.end())
+		return reinterpret_cast<RenderTechnique>(it->second);
+
+	RenderTechnique target = NULL;
+	int numPasses = 1;
+	if(mTarget != NULL)
+	{
+		target = mTarget->GetTechnique(effectRecord->Target, name);
+		if(target == NULL)
+			return NULL;
+		numPasses = mTarget->GetPassCount(target);
+	}
+
+	TechniqueRecord* record = new TechniqueRecord();
+	record->Name = name;
+	record->Effect = effectRecord;
+	record->Target = target;
+	mTechniques.push_back(record);
+	effectRecord->Techniques[name] = record;
+
+	for(int i = 0; i < numPasses; ++i)
+	{
+		std::stringstream passName;
+		passName << effectRecord->Name << "/" << name << "/" << i;
+
+		PassRecord* pass = new PassRecord();
+		pass->Name = passName.str();
+		pass->Effect = effectRecord;
+		pass->Target = target != NULL ? mTarget->GetPass(target, i) : NULL;
+		mPasses.push_back(pass);
+		record->Passes.push_back(pass);
+	}
+
+	return reinterpret_cast<RenderTechnique>(record);
+}
+
+int HeadlessRenderDevice::GetPassCount(RenderTechnique technique)
+{
+	TechniqueRecord* record = ToRecord(technique);
+	if(record == NULL || !record->Effect->Alive)
+	{
+		Error("GetPassCount: no technique or its effect is released");
+		return 0;
+	}
+
+	return (int)record->Passes.size();
+}
+
+RenderPass HeadlessRenderDevice::GetPass(RenderTechnique technique, int index)
+{
+	TechniqueRecord* record = ToRecord(technique);
+	if(record == NULL || !record->Effect->Alive)
+	{
+		Error("GetPass: no technique or its effect is released");
+		return NULL;
+	}
+	if(index < 0 || index >= (int)record->Passes.size())
+	{
+		Error("GetPass: " + record->Name + " has no pass with that index");
+		return NULL;
+	}
+
+	return reinterpret_cast<RenderPass>(record->Passes[index]);
+}
+
+// Asked for again, a name gives the same variable. One the target's effect does not have is NULL.
+RenderVariable HeadlessRenderDevice::GetVariable(RenderEffect effect, const char* name)
+{
+	EffectRecord* effectRecord = ToRecord(effect);
+	if(effectRecord == NULL || !effectRecord->Alive)
+	{
+		Error(std::string("GetVariable: no effect for ") + name + " or it is released");
+		return NULL;
+	}
+
+	std::map<std::string, VariableRecord*>::iterator it = effectRecord->Variables.find(name);
+	if(it != effectRecord->Variables.end())
+		return reinterpret_cast<RenderVariable>(it->second);
+
+	RenderVariable target = NULL;
+	if(mTarget != NULL)
+	{
+		target = mTarget->GetVariable(effectRecord->Target, name);
+		if(target == NULL)
+			return NULL;
+	}
+
+	VariableRecord* record = new VariableRecord();
+	record->Name = name;
+	record->Effect = effectRecord;
+	record->Target = target;
+	mVariables.push_back(record);
+	effectRecord->Variables[name] = record;
+
+	return reinterpret_cast<RenderVariable>(record);
+}
+
+// The setters, like the D3D10 device's, do nothing for a NULL variable
+void HeadlessRenderDevice::SetMatrix(RenderVariable variable, const float* matrix)
+{
+	VariableRecord* record = ToRecord(variable);
+	if(SetVariable("SetMatrix", record) && mTarget != NULL)
+		mTarget->SetMatrix(record->Target, matrix);
+}
+
+void HeadlessRenderDevice::SetMatrixArray(RenderVariable variable, const float* matrices, int first, int count)
+{
+	VariableRecord* record = ToRecord(variable);
+	if(SetVariable("SetMatrixArray", record) && mTarget != NULL)
+		mTarget->SetMatrixArray(record->Target, matrices, first, count);
+}
+
+void HeadlessRenderDevice::SetFloatVector(RenderVariable variable, const float* vector)
+{
+	VariableRecord* record = ToRecord(variable);
+	if(SetVariable("SetFloatVector", record) && mTarget != NULL)
+		mTarget->SetFloatVector(record->Target, vector);
+}
+
+void HeadlessRenderDevice::SetFloatVectorArray(RenderVariable variable, const float* vectors, int first, int count)
+{
+	VariableRecord* record = ToRecord(variable);
+	if(SetVariable("SetFloatVectorArray", record) && mTarget != NULL)
+		mTarget->SetFloatVectorArray(record->Target, vectors, first, count);
+}
+
+void HeadlessRenderDevice::SetFloat(RenderVariable variable, float value)
+{
+	VariableRecord* record = ToRecord(variable);
+	if(SetVariable("SetFloat", record) && mTarget != NULL)
+		mTarget->SetFloat(record->Target, value);
+}
+
+void HeadlessRenderDevice::SetInt(RenderVariable variable, int value)
+{
+	VariableRecord* record = ToRecord(variable);
+	if(SetVariable("SetInt", record) && mTarget != NULL)
+		mTarget->SetInt(record->Target, value);
+}
+
+void HeadlessRenderDevice::SetBool(RenderVariable variable, bool value)
+{
+	VariableRecord* record = ToRecord(variable);
+	if(SetVariable("SetBool", record) && mTarget != NULL)
+		mTarget->SetBool(record->Target, value);
+}
+
+// NULL unbinds what the variable had
+void HeadlessRenderDevice::SetShaderView(RenderVariable variable, RenderShaderView view)
+{
+	VariableRecord* record = ToRecord(variable);
+	ViewRecord* viewRecord = ToRecord(view);
+	if(mRecording && record != NULL)
+	{
+		std::stringstream command;
+		command << "SetShaderView " << record->Name << ", view " << (viewRecord != NULL ? viewRecord->Id : -1);
+		Record(command.str());
+	}
+
+	if(!CheckVariable("SetShaderView", record))
+		return;
+	if(viewRecord != NULL && !CheckView("SetShaderView", viewRecord))
+		return;
+
+	if(mTarget != NULL)
+		mTarget->SetShaderView(record->Target, viewRecord != NULL ? viewRecord->ShaderTarget : NULL);
+}
+
+RenderInputLayout HeadlessRenderDevice::CreateInputLayout(const RenderVertexElement* elements, int count, RenderPass pass)
+{
+	PassRecord* passRecord = ToRecord(pass);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "CreateInputLayout " << mLayouts.size() << ":";
+		for(int i = 0; i < count; ++i)
+			command << " " << elements[i].Semantic << elements[i].SemanticIndex << " at " << elements[i].Offset;
+		command << ", for " << (passRecord != NULL ? passRecord->Name : "NULL");
+		Record(command.str());
+	}
+
+	if(passRecord == NULL || !passRecord->Effect->Alive)
+	{
+		Error("CreateInputLayout: no pass or its effect is released");
+		return NULL;
+	}
+	if(elements == NULL || count <= 0)
+	{
+		Error("CreateInputLayout: the vertex has no elements");
+		return NULL;
+	}
+
+	RenderInputLayout target = NULL;
+	if(mTarget != NULL)
+	{
+		target = mTarget->CreateInputLayout(elements, count, passRecord->Target);
+		if(target == NULL)
+		{
+			Error("CreateInputLayout: the target device could not create the layout for " + passRecord->Name);
+			return NULL;
+		}
+	}
+
+	LayoutRecord* record = new LayoutRecord();
+	record->Id = (int)mLayouts.size();
+	record->Target = target;
+	record->Alive = true;
+	mLayouts.push_back(record);
+
+	return reinterpret_cast<RenderInputLayout>(record);
+}
+
+void HeadlessRenderDevice::ReleaseInputLayout(RenderInputLayout layout)
+{
+	LayoutRecord* record = ToRecord(layout);
+	if(record == NULL)
+		return;
+
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "ReleaseInputLayout " << record->Id;
+		Record(command.str());
+	}
+
+	if(!record->Alive)
+	{
+		Error("ReleaseInputLayout: the layout is already released");
+		return;
+	}
+
+	record->Alive = false;
+	if(mInputLayout == record)
+		mInputLayout = NULL;
+
+	if(mTarget != NULL)
+		mTarget->ReleaseInputLayout(record->Target);
+}
+
+RenderQuery HeadlessRenderDevice::CreateQuery(RenderQueryType type)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "CreateQuery " << mQueries.size() << ", type " << type;
+		Record(command.str());
+	}
+
+	RenderQuery target = NULL;
+	if(mTarget != NULL)
+	{
+		target = mTarget->CreateQuery(type);
+		if(target == NULL)
+		{
+			Error("CreateQuery: the target device could not create the query");
+			return NULL;
+		}
+	}
+
+	QueryRecord* record = new QueryRecord();
+	record->Id = (int)mQueries.size();
+	record->Type = type;
+	record->Target = target;
+	record->Begun = false;
+	record->Alive = true;
+	mQueries.push_back(record);
+
+	return reinterpret_cast<RenderQuery>(record);
+}
+
+void HeadlessRenderDevice::ReleaseQuery(RenderQuery query)
+{
+	QueryRecord* record = ToRecord(query);
+	if(record == NULL)
+		return;
+
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "ReleaseQuery " << record->Id;
+		Record(command.str());
+	}
+
+	if(!record->Alive)
+	{
+		Error("ReleaseQuery: the query is already released");
+		return;
+	}
+
+	record->Alive = false;
+
+	if(mTarget != NULL)
+		mTarget->ReleaseQuery(record->Target);
+}
+
+// A timestamp is only ended, every other query is begun and ended around what it measures
+void HeadlessRenderDevice::BeginQuery(RenderQuery query)
+{
+	QueryRecord* record = ToRecord(query);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "BeginQuery " << (record != NULL ? record->Id : -1);
+		Record(command.str());
+	}
+
+	if(record == NULL || !record->Alive)
+	{
+		Error("BeginQuery: no query or it is released");
+		return;
+	}
+	if(record->Type == RenderQueryTimestamp)
+	{
+		Error("BeginQuery: a timestamp is only ended");
+		return;
+	}
+	if(record->Begun)
+		Error("BeginQuery: the query is already begun");
+
+	record->Begun = true;
+
+	if(mTarget != NULL)
+		mTarget->BeginQuery(record->Target);
+}
+
+void HeadlessRenderDevice::EndQuery(RenderQuery query)
+{
+	QueryRecord* record = ToRecord(query);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "EndQuery " << (record != NULL ? record->Id : -1);
+		Record(command.str());
+	}
+
+	if(record == NULL || !record->Alive)
+	{
+		Error("EndQuery: no query or it is released");
+		return;
+	}
+	if(record->Type != RenderQueryTimestamp && !record->Begun)
+	{
+		Error("EndQuery: the query was never begun");
+		return;
+	}
+
+	record->Begun = false;
+
+	if(mTarget != NULL)
+		mTarget->EndQuery(record->Target);
+}
+
+// Without a target there is never a result
+bool HeadlessRenderDevice::GetTimestamp(RenderQuery query, UINT64& timestamp)
+{
+	QueryRecord* record = ToRecord(query);
+	if(record == NULL || !record->Alive || record->Type != RenderQueryTimestamp)
+	{
+		Error("GetTimestamp: no timestamp query or it is released");
+		return false;
+	}
+
+	return mTarget != NULL && mTarget->GetTimestamp(record->Target, timestamp);
+}
+
+bool HeadlessRenderDevice::GetTimestampFrequency(RenderQuery query, UINT64& frequency, bool& disjoint)
+{
+	QueryRecord* record = ToRecord(query);
+	if(record == NULL || !record->Alive || record->Type != RenderQueryTimestampDisjoint)
+	{
+		Error("GetTimestampFrequency: no disjoint query or it is released");
+		return false;
+	}
+	if(record->Begun)
+	{
+		Error("GetTimestampFrequency: the query is not ended");
+		return false;
+	}
+
+	return mTarget != NULL && mTarget->GetTimestampFrequency(record->Target, frequency, disjoint);
+}
+
+bool HeadlessRenderDevice::GetPipelineStatistics(RenderQuery query, RenderPipelineStatistics& statistics)
+{
+	QueryRecord* record = ToRecord(query);
+	if(record == NULL || !record->Alive || record->Type != RenderQueryPipelineStatistics)
+	{
+		Error("GetPipelineStatistics: no pipeline statistics query or it is released");
+		return false;
+	}
+	if(record->Begun)
+	{
+		Error("GetPipelineStatistics: the query is not ended");
+		return false;
+	}
+
+	return mTarget != NULL && mTarget->GetPipelineStatistics(record->Target, statistics);
+}
+
+void HeadlessRenderDevice::SetInputLayout(RenderInputLayout layout)
+{
+	LayoutRecord* record = ToRecord(layout);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "SetInputLayout " << (record != NULL ? record->Id : -1);
+		Record(command.str());
+	}
+
+	if(record != NULL && !record->Alive)
+	{
+		Error("SetInputLayout: the layout is released");
+		record = NULL;
+	}
+
+	CountStateChange(record == mInputLayout);
+	mInputLayout = record;
+
+	if(mTarget != NULL)
+		mTarget->SetInputLayout(record != NULL ? record->Target : NULL);
+}
+
+void HeadlessRenderDevice::SetPrimitiveTopology(RenderTopology topology)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "SetPrimitiveTopology " << topology;
+		Record(command.str());
+	}
+
+	CountStateChange(topology == mTopology);
+	mTopology = topology;
+
+	if(mTarget != NULL)
+		mTarget->SetPrimitiveTopology(topology);
+}
+
+void HeadlessRenderDevice::SetVertexBuffer(RenderBuffer buffer, UINT stride)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "SetVertexBuffer " << buffer << ", stride " << stride;
+		Record(command.str());
+	}
+
+	RenderBuffer target = C_NO_BUFFER;
+	if(buffer != C_NO_BUFFER)
+	{
+		if(!IsAlive(buffer))
+		{
+			Error("SetVertexBuffer: the buffer was never created or is already released");
+			buffer = C_NO_BUFFER;
+		}
+		else
+		{
+			if((mBuffers[buffer].Desc.BindFlags & RenderBindVertexBuffer) == 0)
+				Error("SetVertexBuffer: the buffer is not made to be bound as vertices");
+			if(stride == 0)
+				Error("SetVertexBuffer: the stride is zero");
+			target = mBuffers[buffer].Target;
+		}
+	}
+
+	CountStateChange(buffer == mVertexBuffer && stride == mVertexStride);
+	mVertexBuffer = buffer;
+	mVertexStride = stride;
+
+	if(mTarget != NULL)
+		mTarget->SetVertexBuffer(target, stride);
+}
+
+void HeadlessRenderDevice::SetIndexBuffer(RenderBuffer buffer, RenderFormat format)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "SetIndexBuffer " << buffer << ", format " << format;
+		Record(command.str());
+	}
+
+	RenderBuffer target = C_NO_BUFFER;
+	if(buffer != C_NO_BUFFER)
+	{
+		if(!IsAlive(buffer))
+		{
+			Error("SetIndexBuffer: the buffer was never created or is already released");
+			buffer = C_NO_BUFFER;
+		}
+		else
+		{
+			if((mBuffers[buffer].Desc.BindFlags & RenderBindIndexBuffer) == 0)
+				Error("SetIndexBuffer: the buffer is not made to be bound as indices");
+			if(IndexSize(format) == 0)
+				Error("SetIndexBuffer: indices are 16 or 32 bit unsigned integers");
+			target = mBuffers[buffer].Target;
+		}
+	}
+
+	CountStateChange(buffer == mIndexBuffer && format == mIndexFormat);
+	mIndexBuffer = buffer;
+	mIndexFormat = format;
+
+	if(mTarget != NULL)
+		mTarget->SetIndexBuffer(target, format);
+}
+
+// A pass applied again is not redundant, applying it is how the changed effect variables are set
+void HeadlessRenderDevice::ApplyPass(RenderPass pass)
+{
+	PassRecord* record = ToRecord(pass);
+	if(record == NULL)
+	{
+		Record("ApplyPass NULL");
+		Error("ApplyPass: no pass");
+		return;
+	}
+
+	if(mRecording)
+		Record("ApplyPass " + record->Name);
+
+	if(!record->Effect->Alive)
+	{
+		Error("ApplyPass: the effect of " + record->Name + " is released");
+		return;
+	}
+
+	CountStateChange(false);
+	mPass = record;
+
+	if(mTarget != NULL)
+		mTarget->ApplyPass(record->Target);
+}
+
+void HeadlessRenderDevice::SetRenderTargets(int count, const RenderTargetView* renderTargets, RenderDepthView depthStencil)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "SetRenderTargets";
+		for(int i = 0; i < count; ++i)
+			command << " " << (renderTargets[i] != NULL ? ToRecord(renderTargets[i])->Id : -1);
+		command << ", depth " << (depthStencil != NULL ? ToRecord(depthStencil)->Id : -1);
+		Record(command.str());
+	}
+
+	if(count < 0 || count > C_MAX_RENDER_TARGETS)
+	{
+		Error("SetRenderTargets: more targets than the device can bind");
+		count = count < 0 ? 0 : C_MAX_RENDER_TARGETS;
+	}
+
+	std::vector<ViewRecord*> bound;
+	RenderTargetView targets[C_MAX_RENDER_TARGETS];
+	for(int i = 0; i < count; ++i)
+	{
+		ViewRecord* record = ToRecord(renderTargets[i]);
+		targets[i] = NULL;
+		if(record != NULL && CheckView("SetRenderTargets", record))
+		{
+			bound.push_back(record);
+			targets[i] = record->RenderTarget;
+		}
+	}
+
+	ViewRecord* depthRecord = ToRecord(depthStencil);
+	if(depthRecord != NULL && !CheckView("SetRenderTargets", depthRecord))
+		depthRecord = NULL;
+
+	CountStateChange(bound == mRenderTargets && depthRecord == mDepthStencil);
+	mRenderTargets = bound;
+	mDepthStencil = depthRecord;
+
+	if(mTarget != NULL)
+		mTarget->SetRenderTargets(count, targets, depthRecord != NULL ? depthRecord->DepthTarget : NULL);
+}
+
+void HeadlessRenderDevice::SetViewport(const RenderViewport& viewport)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "SetViewport " << viewport.TopLeftX << " " << viewport.TopLeftY << " " << viewport.Width << "x" << viewport.Height;
+		Record(command.str());
+	}
+
+	CountStateChange(viewport.TopLeftX == mViewport.TopLeftX && viewport.TopLeftY == mViewport.TopLeftY &&
+					 viewport.Width == mViewport.Width && viewport.Height == mViewport.Height &&
+					 viewport.MinDepth == mViewport.MinDepth && viewport.MaxDepth == mViewport.MaxDepth);
+	mViewport = viewport;
+
+	if(mTarget != NULL)
+		mTarget->SetViewport(viewport);
+}
+
+void HeadlessRenderDevice::UnbindShaderResources()
+{
+	Record("UnbindShaderResources");
+	CountStateChange(false);
+
+	if(mTarget != NULL)
+		mTarget->UnbindShaderResources();
+}
+
+void HeadlessRenderDevice::ClearRenderTarget(RenderTargetView renderTarget, const float color[4])
+{
+	ViewRecord* record = ToRecord(renderTarget);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "ClearRenderTarget " << (record != NULL ? record->Id : -1) << ", " << color[0] << " " << color[1];
+		command << " " << color[2] << " " << color[3];
+		Record(command.str());
+	}
+
+	if(!CheckView("ClearRenderTarget", record))
+		return;
+
+	++mFrameStatistics.Clears;
+
+	if(mTarget != NULL)
+		mTarget->ClearRenderTarget(record->RenderTarget, color);
+}
+
+void HeadlessRenderDevice::ClearDepthStencil(RenderDepthView depthStencil)
+{
+	ViewRecord* record = ToRecord(depthStencil);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "ClearDepthStencil " << (record != NULL ? record->Id : -1);
+		Record(command.str());
+	}
+
+	if(!CheckView("ClearDepthStencil", record))
+		return;
+
+	++mFrameStatistics.Clears;
+
+	if(mTarget != NULL)
+		mTarget->ClearDepthStencil(record->DepthTarget);
+}
+
+// Vertices are only read from a buffer when an input layout is set, the passes that make their
+// vertices from the vertex index draw without one
+void HeadlessRenderDevice::Draw(UINT vertexCount, UINT startVertex)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "Draw " << vertexCount << " from " << startVertex;
+		Record(command.str());
+	}
+
+	CheckDraw("Draw");
+	if(mInputLayout != NULL)
+	{
+		if(mVertexBuffer == C_NO_BUFFER)
+			Error("Draw: no vertex buffer for the input layout");
+		else if(mVertexStride > 0 && startVertex + vertexCount > (UINT)mBuffers[mVertexBuffer].Desc.Bytes / mVertexStride)
+			Error("Draw: the vertices are past the end of the vertex buffer");
+	}
+
+	++mFrameStatistics.Draws;
+	mFrameStatistics.Triangles += CountTriangles(mTopology, vertexCount);
+
+	if(mTarget != NULL)
+		mTarget->Draw(vertexCount, startVertex);
+}
+
+void HeadlessRenderDevice::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+{
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << "DrawIndexed " << indexCount << " from " << startIndex << ", base vertex " << baseVertex;
+		Record(command.str());
+	}
+
+	CheckDraw("DrawIndexed");
+	if(mInputLayout != NULL && mVertexBuffer == C_NO_BUFFER)
+		Error("DrawIndexed: no vertex buffer for the input layout");
+	if(mIndexBuffer == C_NO_BUFFER)
+		Error("DrawIndexed: no index buffer");
+	else if(IndexSize(mIndexFormat) > 0 &&
+			startIndex + indexCount > (UINT)(mBuffers[mIndexBuffer].Desc.Bytes / IndexSize(mIndexFormat)))
+		Error("DrawIndexed: the indices are past the end of the index buffer");
+
+	++mFrameStatistics.Draws;
+	mFrameStatistics.Triangles += CountTriangles(mTopology, indexCount);
+
+	if(mTarget != NULL)
+		mTarget->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+// Record the calls from the next one on, the calls recorded before are thrown away
+void HeadlessRenderDevice::SetRecording(bool recording)
+{
+	if(recording && !mRecording)
+		mCommands.clear();
+
+	mRecording = recording;
+}
+
+bool HeadlessRenderDevice::IsRecording() const
+{
+	return mRecording;
+}
+
+const RenderDeviceStatistics& HeadlessRenderDevice::GetStatistics() const
+{
+	return mStatistics;
+}
+
+// The first errors since the start, later ones are only counted
+const std::vector<std::string>& HeadlessRenderDevice::GetErrors() const
+{
+	return mErrors;
+}
+
+// The recorded calls, one per line, with the errors they caused after them
+std::string HeadlessRenderDevice::DumpCommands() const
+{
+	std::stringstream stream;
+	for(size_t i = 0; i < mCommands.size(); ++i)
+		stream << mCommands[i] << "\n";
+
+	return stream.str();
+}
+
+HeadlessRenderDevice::TextureRecord* HeadlessRenderDevice::ToRecord(RenderTexture texture)
+{
+	return reinterpret_cast<TextureRecord*>(texture);
+}
+
+HeadlessRenderDevice::ViewRecord* HeadlessRenderDevice::ToRecord(RenderShaderView view)
+{
+	return reinterpret_cast<ViewRecord*>(view);
+}
+
+HeadlessRenderDevice::ViewRecord* HeadlessRenderDevice::ToRecord(RenderTargetView view)
+{
+	return reinterpret_cast<ViewRecord*>(view);
+}
+
+HeadlessRenderDevice::ViewRecord* HeadlessRenderDevice::ToRecord(RenderDepthView view)
+{
+	return reinterpret_cast<ViewRecord*>(view);
+}
+
+HeadlessRenderDevice::EffectRecord* HeadlessRenderDevice::ToRecord(RenderEffect effect)
+{
+	return reinterpret_cast<EffectRecord*>(effect);
+}
+
+HeadlessRenderDevice::TechniqueRecord* HeadlessRenderDevice::ToRecord(RenderTechnique technique)
+{
+	return reinterpret_cast<TechniqueRecord*>(technique);
+}
+
+HeadlessRenderDevice::PassRecord* HeadlessRenderDevice::ToRecord(RenderPass pass)
+{
+	return reinterpret_cast<PassRecord*>(pass);
+}
+
+HeadlessRenderDevice::VariableRecord* HeadlessRenderDevice::ToRecord(RenderVariable variable)
+{
+	return reinterpret_cast<VariableRecord*>(variable);
+}
+
+HeadlessRenderDevice::LayoutRecord* HeadlessRenderDevice::ToRecord(RenderInputLayout layout)
+{
+	return reinterpret_cast<LayoutRecord*>(layout);
+}
+
+HeadlessRenderDevice::QueryRecord* HeadlessRenderDevice::ToRecord(RenderQuery query)
+{
+	return reinterpret_cast<QueryRecord*>(query);
+}
+
+bool HeadlessRenderDevice::IsAlive(RenderBuffer buffer) const
+{
+	return buffer >= 0 && buffer < (RenderBuffer)mBuffers.size() && mBuffers[buffer].Alive;
+}
+
+// A view of the slices of a live texture that is made to be bound that way, the caller sets the
+// target's view
+HeadlessRenderDevice::ViewRecord* HeadlessRenderDevice::CreateView(const char* call, RenderTexture texture, UINT bindFlag,
+																   int firstSlice, int numSlices)
+{
+	TextureRecord* textureRecord = ToRecord(texture);
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << call << " " << mViews.size() << ": texture " << (textureRecord != NULL ? textureRecord->Id : -1);
+		command << ", slices " << firstSlice << " to " << firstSlice + numSlices - 1;
+		Record(command.str());
+	}
+
+	if(textureRecord == NULL || !textureRecord->Alive)
+	{
+		Error(std::string(call) + ": no texture or it is released");
+		return NULL;
+	}
+	if((textureRecord->Desc.BindFlags & bindFlag) == 0)
+	{
+		Error(std::string(call) + ": the texture is not made to be bound that way");
+		return NULL;
+	}
+	if(firstSlice < 0 || numSlices <= 0 || firstSlice + numSlices > textureRecord->Desc.ArraySize)
+	{
+		Error(std::string(call) + ": the slices are not in the texture");
+		return NULL;
+	}
+
+	ViewRecord* record = new ViewRecord();
+	record->Id = (int)mViews.size();
+	record->Texture = textureRecord;
+	record->FirstSlice = firstSlice;
+	record->NumSlices = numSlices;
+	record->ShaderTarget = NULL;
+	record->RenderTarget = NULL;
+	record->DepthTarget = NULL;
+	record->BackBuffer = false;
+	record->Alive = true;
+	mViews.push_back(record);
+
+	return record;
+}
+
+// Released views are also unbound, so a draw into one is caught as a draw into nothing
+bool HeadlessRenderDevice::ReleaseView(const char* call, ViewRecord* view)
+{
+	if(view == NULL)
+		return false;
+
+	if(mRecording)
+	{
+		std::stringstream command;
+		command << call << " " << view->Id;
+		Record(command.str());
+	}
+
+	if(view->BackBuffer)
+	{
+		Error(std::string(call) + ": the back buffer belongs to the application");
+		return false;
+	}
+	if(!view->Alive)
+	{
+		Error(std::string(call) + ": the view is already released");
+		return false;
+	}
+
+	view->Alive = false;
+	for(size_t i = 0; i < mRenderTargets.size(); ++i)
+	{
+		if(mRenderTargets[i] == view)
+			mRenderTargets.erase(mRenderTargets.begin() + i--);
+	}
+	if(mDepthStencil == view)
+		mDepthStencil = NULL;
+
+	return true;
+}
+
+bool HeadlessRenderDevice::CheckView(const char* call, const ViewRecord* view)
+{
+	if(view == NULL || !view->Alive)
+	{
+		Error(std::string(call) + ": no view or it is released");
+		return false;
+	}
+
+	return true;
+}
+
+// A NULL variable is one the effect does not have, setting it does nothing as on the D3D10 device
+bool HeadlessRenderDevice::CheckVariable(const char* call, const VariableRecord* variable)
+{
+	if(variable == NULL)
+		return false;
+
+	if(!variable->Effect->Alive)
+	{
+		Error(std::string(call) + ": the effect of " + variable->Name + " is released");
+		return false;
+	}
+
+	return true;
+}
+
+// Record a setter and check its variable, false when there is nothing to pass on
+bool HeadlessRenderDevice::SetVariable(const char* call, const VariableRecord* variable)
+{
+	if(mRecording && variable != NULL)
+		Record(std::string(call) + " " + variable->Name);
+
+	return CheckVariable(call, variable);
+}
+
+void HeadlessRenderDevice::CountStateChange(bool redundant)
+{
+	++mFrameStatistics.StateChanges;
+	if(redundant)
+		++mFrameStatistics.RedundantStateChanges;
+}
+
+// What every draw needs, whatever it reads its vertices from
+void HeadlessRenderDevice::CheckDraw(const char* call)
+{
+	if(mPass == NULL)
+		Error(std::string(call) + ": no pass has been applied");
+	if(mTopology == RenderTopologyUndefined)
+		Error(std::string(call) + ": no primitive topology");
+	if(mRenderTargets.empty() && mDepthStencil == NULL)
+		Error(std::string(call) + ": nothing is bound to draw into");
+	if(mViewport.Width == 0 || mViewport.Height == 0)
+		Error(std::string(call) + ": the viewport is empty");
+}
+
+void HeadlessRenderDevice::Error(const std::string& message)
+{
+	++mFrameStatistics.Errors;
+	if((int)mErrors.size() < C_MAX_ERRORS)
+		mErrors.push_back(message);
+
+	Record("! " + message);
+}
+
+void HeadlessRenderDevice::Record(const std::string& command)
+{
+	if(mRecording)
+		mCommands.push_back(command);
+}
@@ -0,0 +1,247 @@
+#ifndef HEADLESS_RENDER_DEVICE_H
+#define HEADLESS_RENDER_DEVICE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "RenderDevice.h"
+
+struct RenderDeviceStatistics
+{
+	int						Draws;
+	int						Triangles;
+	int						StateChanges;			// Input assembly, targets, viewports and passes
+	int						RedundantStateChanges;	// Set to what was already set
+	int						BytesUploaded;			// Buffer and texture contents and updates
+	int						Clears;
+	int						Errors;					// Calls that failed validation
+	int						Buffers;				// Alive at the end of the frame
+	int						BufferBytes;
+	int						Textures;				// Alive at the end of the frame, loaded ones not counted
+	int						TextureBytes;
+};
+
+// A render device that draws nothing itself. It checks every call against the state it tracks,
+// keeps the descriptions of what it made, counts the frame's statistics and, while recording, writes
+// every call to a command list. With a target device every call is passed on after it is checked,
+// so it can sit on top of the D3D10 device. Without one it runs with no GPU at all: everything it
+// makes is only a record, every effect has the techniques and variables asked for with one pass
+// each, and queries never have results.
+class HeadlessRenderDevice : public RenderDevice
+{
+public:
+	HeadlessRenderDevice();
+	virtual ~HeadlessRenderDevice();
+	void Initialize(RenderDevice* target);
+
+	virtual void BeginFrame();
+
+	virtual RenderBuffer CreateBuffer(const RenderBufferDesc& desc, const void* data);
+	virtual void ReleaseBuffer(RenderBuffer buffer);
+	virtual void UpdateBuffer(RenderBuffer buffer, const void* data, int bytes);
+
+	virtual RenderTexture CreateTexture(const RenderTextureDesc& desc, const void* data, int rowBytes);
+	virtual void ReleaseTexture(RenderTexture texture);
+	virtual void UpdateTexture(RenderTexture texture, const void* data, int rowBytes, int rows);
+	virtual void CopyTexture(RenderTexture destination, RenderTexture source);
+	virtual RenderShaderView LoadTexture(const char* filename);
+	virtual RenderShaderView CreateShaderView(RenderTexture texture, RenderViewType type);
+	virtual RenderTargetView CreateRenderTargetView(RenderTexture texture, int firstSlice, int numSlices);
+	virtual RenderDepthView CreateDepthView(RenderTexture texture, int firstSlice, int numSlices);
+	virtual void ReleaseShaderView(RenderShaderView view);
+	virtual void ReleaseRenderTargetView(RenderTargetView view);
+	virtual void ReleaseDepthView(RenderDepthView view);
+	virtual void GenerateMips(RenderShaderView view);
+	virtual RenderTargetView GetBackBuffer();
+	virtual RenderDepthView GetBackBufferDepth();
+
+	virtual RenderEffect CreateEffect(const char* filename);
+	virtual void ReleaseEffect(RenderEffect effect);
+	virtual RenderTechnique GetTechnique(RenderEffect effect, const char* name);
+	virtual int GetPassCount(RenderTechnique technique);
+	virtual RenderPass GetPass(RenderTechnique technique, int index);
+	virtual RenderVariable GetVariable(RenderEffect effect, const char* name);
+	virtual void SetMatrix(RenderVariable variable, const float* matrix);
+	virtual void SetMatrixArray(RenderVariable variable, const float* matrices, int first, int count);
+	virtual void SetFloatVector(RenderVariable variable, const float* vector);
+	virtual void SetFloatVectorArray(RenderVariable variable, const float* vectors, int first, int count);
+	virtual void SetFloat(RenderVariable variable, float value);
+	virtual void SetInt(RenderVariable variable, int value);
+	virtual void SetBool(RenderVariable variable, bool value);
+	virtual void SetShaderView(RenderVariable variable, RenderShaderView view);
+	virtual RenderInputLayout CreateInputLayout(const RenderVertexElement* elements, int count, RenderPass pass);
+	virtual void ReleaseInputLayout(RenderInputLayout layout);
+
+	virtual RenderQuery CreateQuery(RenderQueryType type);
+	virtual void ReleaseQuery(RenderQuery query);
+	virtual void BeginQuery(RenderQuery query);
+	virtual void EndQuery(RenderQuery query);
+	virtual bool GetTimestamp(RenderQuery query, UINT64& timestamp);
+	virtual bool GetTimestampFrequency(RenderQuery query, UINT64& frequency, bool& disjoint);
+	virtual bool GetPipelineStatistics(RenderQuery query, RenderPipelineStatistics& statistics);
+
+	virtual void SetInputLayout(RenderInputLayout layout);
+	virtual void SetPrimitiveTopology(RenderTopology topology);
+	virtual void SetVertexBuffer(RenderBuffer buffer, UINT stride);
+	virtual void SetIndexBuffer(RenderBuffer buffer, RenderFormat format);
+	virtual void ApplyPass(RenderPass pass);
+
+	virtual void SetRenderTargets(int count, const RenderTargetView* renderTargets, RenderDepthView depthStencil);
+	virtual void SetViewport(const RenderViewport& viewport);
+	virtual void UnbindShaderResources();
+	virtual void ClearRenderTarget(RenderTargetView renderTarget, const float color[4]);
+	virtual void ClearDepthStencil(RenderDepthView depthStencil);
+
+	virtual void Draw(UINT vertexCount, UINT startVertex);
+	virtual void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex);
+
+	void SetRecording(bool recording);
+	bool IsRecording() const;
+	const RenderDeviceStatistics& GetStatistics() const;		// Of the last whole frame
+	const std::vector<std::string>& GetErrors() const;
+	std::string DumpCommands() const;
+
+private:
+	struct BufferRecord
+	{
+		RenderBufferDesc		Desc;
+		RenderBuffer			Target;					// The target device's buffer
+		bool					Alive;
+
+		BufferRecord(const RenderBufferDesc& desc) : Desc(desc), Target(C_NO_BUFFER), Alive(true) {}
+	};
+
+	// Every other record is what its handle points to. Records are only deleted with the device, so a
+	// handle that is used after it is released is caught rather than read from freed memory.
+	struct TextureRecord
+	{
+		int						Id;
+		RenderTextureDesc		Desc;
+		RenderTexture			Target;
+		bool					Alive;
+
+		TextureRecord(int id, const RenderTextureDesc& desc) : Id(id), Desc(desc), Target(NULL), Alive(true) {}
+	};
+
+	// Only the target of the view's own kind is set
+	struct ViewRecord
+	{
+		int						Id;
+		const TextureRecord*	Texture;				// NULL for loaded textures and the back buffer
+		int						FirstSlice;
+		int						NumSlices;
+		RenderShaderView		ShaderTarget;
+		RenderTargetView		RenderTarget;
+		RenderDepthView			DepthTarget;
+		bool					BackBuffer;				// Owned by the application, never released
+		bool					Alive;
+	};
+
+	struct TechniqueRecord;
+	struct VariableRecord;
+
+	struct EffectRecord
+	{
+		std::string				Name;					// The file it was made from
+		RenderEffect			Target;
+		bool					Alive;
+		std::map<std::string, TechniqueRecord*>		Techniques;
+		std::map<std::string, VariableRecord*>		Variables;
+	};
+
+	struct PassRecord
+	{
+		std::string				Name;					// Effect, technique and index, what the commands show
+		const EffectRecord*		Effect;
+		RenderPass				Target;
+	};
+
+	struct TechniqueRecord
+	{
+		std::string				Name;
+		const EffectRecord*		Effect;
+		RenderTechnique			Target;
+		std::vector<PassRecord*>	Passes;
+	};
+
+	struct VariableRecord
+	{
+		std::string				Name;
+		const EffectRecord*		Effect;
+		RenderVariable			Target;
+	};
+
+	struct LayoutRecord
+	{
+		int						Id;
+		RenderInputLayout		Target;
+		bool					Alive;
+	};
+
+	struct QueryRecord
+	{
+		int						Id;
+		RenderQueryType			Type;
+		RenderQuery				Target;
+		bool					Begun;
+		bool					Alive;
+	};
+
+	RenderDevice*					mTarget;				// NULL when nothing is drawn
+	std::vector<BufferRecord>		mBuffers;
+	std::vector<TextureRecord*>		mTextures;
+	std::vector<ViewRecord*>		mViews;
+	std::vector<EffectRecord*>		mEffects;
+	std::vector<TechniqueRecord*>	mTechniques;
+	std::vector<PassRecord*>		mPasses;
+	std::vector<VariableRecord*>	mVariables;
+	std::vector<LayoutRecord*>		mLayouts;
+	std::vector<QueryRecord*>		mQueries;
+	ViewRecord*						mBackBuffer;			// Made the first time they are asked for
+	ViewRecord*						mBackBufferDepth;
+
+	LayoutRecord*					mInputLayout;
+	RenderTopology					mTopology;
+	RenderBuffer					mVertexBuffer;
+	UINT							mVertexStride;
+	RenderBuffer					mIndexBuffer;
+	RenderFormat					mIndexFormat;
+	PassRecord*						mPass;
+	std::vector<ViewRecord*>		mRenderTargets;			// The bound ones, without the NULL slots
+	ViewRecord*						mDepthStencil;
+	RenderViewport					mViewport;
+
+	RenderDeviceStatistics			mFrameStatistics;		// Being counted
+	RenderDeviceStatistics			mStatistics;
+	std::vector<std::string>		mErrors;
+	bool							mRecording;
+	std::vector<std::string>		mCommands;
+
+	static const int				C_MAX_ERRORS;
+
+	HeadlessRenderDevice(const HeadlessRenderDevice&);
+	HeadlessRenderDevice& operator=(const HeadlessRenderDevice&);
+
+	static TextureRecord* ToRecord(RenderTexture texture);
+	static ViewRecord* ToRecord(RenderShaderView view);
+	static ViewRecord* ToRecord(RenderTargetView view);
+	static ViewRecord* ToRecord(RenderDepthView view);
+	static EffectRecord* ToRecord(RenderEffect effect);
+	static TechniqueRecord* ToRecord(RenderTechnique technique);
+	static PassRecord* ToRecord(RenderPass pass);
+	static VariableRecord* ToRecord(RenderVariable variable);
+	static LayoutRecord* ToRecord(RenderInputLayout layout);
+	static QueryRecord* ToRecord(RenderQuery query);
+
+	bool IsAlive(RenderBuffer buffer) const;
+	ViewRecord* CreateView(const char* call, RenderTexture texture, UINT bindFlag, int firstSlice, int numSlices);
+	bool ReleaseView(const char* call, ViewRecord* view);
+	bool CheckView(const char* call, const ViewRecord* view);
+	bool CheckVariable(const char* call, const VariableRecord* variable);
+	bool SetVariable(const char* call, const VariableRecord* variable);
+	void CountStateChange(bool redundant);
+	void CheckDraw(const char* call);
+	void Error(const std::string& message);
+	void Record(const std::string& command);
+};
+#endif
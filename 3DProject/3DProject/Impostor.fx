@@ -0,0 +1,176 @@
+struct VS_INPUT
+{
+	float3		position	: POSITION;
+	float		scale		: SCALE;
+	float2		rotation	: ROTATION;		// Cosine and sine of the rotation about the y axis
+};
+
+struct PS_INPUT
+{
+	float4		position	: SV_POSITION;
+	float3		positionW	: POSITION;
+	float2		uv			: TEXCOORD;
+	float3		directionW	: DIRECTION;	// Of the frame, from the object towards the viewer
+	float		radius		: RADIUS;
+	float2		rotation	: ROTATION;
+};
+
+struct PS_OUTPUT
+{
+	float4		color		: SV_Target0;
+	float		depth		: SV_Depth;
+};
+
+RasterizerState NoCulling
+{
+	CullMode = None;
+};
+
+DepthStencilState EnableDepth
+{
+	DepthEnable = TRUE;
+	DepthWriteMask = ALL;
+	DepthFunc = LESS_EQUAL;
+};
+
+SamplerState clampSampler {
+	Filter = MIN_MAG_MIP_LINEAR;
+	AddressU = Clamp;
+	AddressV = Clamp;
+};
+
+cbuffer cbEveryFrame
+{
+	matrix gViewProj;
+	float4 gEyePos;
+	float3 gLightPosition;
+};
+
+float4 gSphere;					// Object space center and radius the frames are fitted to
+float gFramesPerSide;
+float gAmbient = 0.3f;
+
+Texture2D gColorAtlas;			// Color, alpha is coverage
+Texture2D gNormalDepthAtlas;	// Object space normal, alpha is the depth through the sphere
+
+// ************************************************************************
+// ** HELPER FUNCTIONS
+// ************************************************************************
+
+// The same rotation as the moving objects' world matrices
+float3 RotateToWorld(float3 v, float2 rotation)
+{
+	return float3(v.x * rotation.x + v.z * rotation.y, v.y, v.z * rotation.x - v.x * rotation.y);
+}
+
+float3 RotateToObject(float3 v, float2 rotation)
+{
+	return float3(v.x * rotation.x - v.z * rotation.y, v.y, v.x * rotation.y + v.z * rotation.x);
+}
+
+// Must match ImpostorAtlas::EncodeOctahedral and DecodeOctahedral
+float2 EncodeOctahedral(float3 direction)
+{
+	float2 p = direction.xz / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+	if(direction.y < 0.0f)
+		p = (1.0f - abs(p.yx)) * (p >= 0.0f ? 1.0f : -1.0f);
+
+	return p * 0.5f + 0.5f;
+}
+
+float3 DecodeOctahedral(float2 uv)
+{
+	float2 p = uv * 2.0f - 1.0f;
+	float y = 1.0f - abs(p.x) - abs(p.y);
+	if(y < 0.0f)
+		p = (1.0f - abs(p.yx)) * (p >= 0.0f ? 1.0f : -1.0f);
+
+	return normalize(float3(p.x, y, p.y));
+}
+
+// Must match ImpostorAtlas::GetFrameAxes
+void GetFrameAxes(float3 direction, out float3 right, out float3 up)
+{
+	float3 worldUp = abs(direction.y) > 0.99f ? float3(0.0f, 0.0f, 1.0f) : float3(0.0f, 1.0f, 0.0f);
+	right = normalize(cross(worldUp, -direction));
+	up = cross(-direction, right);
+}
+
+// ************************************************************************
+// ** SHADER FUNCTIONS
+// ************************************************************************
+
+VS_INPUT VS(VS_INPUT input)
+{
+	return input;
+}
+
+// Turn the instance into a quad around its sphere, facing the direction of the closest frame
+[maxvertexcount(4)]
+void GS(point VS_INPUT input[1], inout TriangleStream<PS_INPUT> stream)
+{
+	float2 rotation = input[0].rotation;
+	float3 center = input[0].position + RotateToWorld(gSphere.xyz, rotation) * input[0].scale;
+	float radius = gSphere.w * input[0].scale;
+
+	float3 toEye = RotateToObject(gEyePos.xyz - center, rotation);
+	float2 frame = min(floor(EncodeOctahedral(normalize(toEye)) * gFramesPerSide), gFramesPerSide - 1.0f);
+	float3 direction = DecodeOctahedral((frame + 0.5f) / gFramesPerSide);
+
+	float3 right;
+	float3 up;
+	GetFrameAxes(direction, right, up);
+	right = RotateToWorld(right, rotation);
+	up = RotateToWorld(up, rotation);
+
+	PS_INPUT output;
+	output.directionW = RotateToWorld(direction, rotation);
+	output.radius = radius;
+	output.rotation = rotation;
+
+	[unroll]
+	for(int i = 0; i < 4; ++i)
+	{
+		float2 corner = float2(i % 2 == 0 ? -1.0f : 1.0f, i < 2 ? 1.0f : -1.0f);
+		output.positionW = center + (right * corner.x + up * corner.y) * radius;
+		output.position = mul(float4(output.positionW, 1.0f), gViewProj);
+		output.uv = (frame + float2(corner.x * 0.5f + 0.5f, 0.5f - corner.y * 0.5f)) / gFramesPerSide;
+		stream.Append(output);
+	}
+}
+
+PS_OUTPUT PS(PS_INPUT input)
+{
+	float4 color = gColorAtlas.Sample(clampSampler, input.uv);
+	clip(color.a - 0.5f);
+
+	// The depth is 0 where the frame's rays entered the sphere and 1 on its far side
+	float4 normalDepth = gNormalDepthAtlas.Sample(clampSampler, input.uv);
+	float3 normalW = normalize(RotateToWorld(normalDepth.xyz * 2.0f - 1.0f, input.rotation));
+	float3 positionW = input.positionW + input.directionW * (input.radius * (1.0f - 2.0f * normalDepth.a));
+
+	float3 lightVec = normalize(gLightPosition - positionW);
+	float diffuse = max(dot(lightVec, normalW), 0.0f);
+	float4 positionH = mul(float4(positionW, 1.0f), gViewProj);
+
+	PS_OUTPUT output;
+	output.color = float4(color.rgb * (gAmbient + (1.0f - gAmbient) * diffuse), 1.0f);
+	output.depth = positionH.z / positionH.w;
+	return output;
+}
+
+// ************************************************************************
+// ** TECHNIQUES
+// ************************************************************************
+technique10 DrawTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(CompileShader(gs_4_0, GS()));
+		SetPixelShader(CompileShader(ps_4_0, PS()));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(EnableDepth, 0xff);
+	}
+}
@@ -0,0 +1,352 @@
+#include "ImpostorAtlas.h"
+#include "GameTime.h"
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const unsigned int C_FILE_MAGIC = 0x41504D49;		// "IMPA"
+	const unsigned int C_FILE_VERSION = 1;
+	const int C_DILATION_PASSES = 2;					// Empty texels next to the mesh that get a color
+
+	float Sign(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	unsigned int ToByte(float value)
+	{
+		return (unsigned int)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+
+	unsigned int PackColor(float r, float g, float b, float a)
+	{
+		return ToByte(r) | (ToByte(g) << 8) | (ToByte(b) << 16) | (ToByte(a) << 24);
+	}
+}
+
+ImpostorAtlas::ImpostorAtlas()
+	: mFramesPerSide(0), mFrameSize(0), mMilliseconds(0.0), mBVH(NULL), mNormals(NULL), mOcclusion(NULL),
+	  mTriangleColors(NULL)
+{
+}
+
+// Render the views of a mesh from its tree. The normals and occlusion are given per vertex of the
+// triangle list the tree was built from, the colors per triangle.
+void ImpostorAtlas::Generate(const TriangleBVH& bvh, const D3DXVECTOR3* normals, const float* occlusion,
+							 const D3DXVECTOR3* colors, int framesPerSide, int frameSize, JobSystem* jobSystem)
+{
+	Stopwatch timer;
+	timer.Start();
+
+	mFramesPerSide = framesPerSide;
+	mFrameSize = frameSize;
+	mSphere = BoundingSphere::FromAABB(bvh.GetBounds());
+	mColors.assign(GetSize() * GetSize(), 0);
+	mNormalDepths.assign(GetSize() * GetSize(), 0);
+
+	mBVH = &bvh;
+	mNormals = normals;
+	mOcclusion = occlusion;
+	mTriangleColors = colors;
+
+	int numFrames = framesPerSide * framesPerSide;
+	if(jobSystem == NULL)
+		FramesJob(this, 0, numFrames);
+	else
+	{
+		JobCounter framesDone;
+		jobSystem->ParallelFor(FramesJob, this, numFrames, 1, &framesDone);
+		jobSystem->Wait(&framesDone);
+	}
+
+	mBVH = NULL;
+	mNormals = NULL;
+	mOcclusion = NULL;
+	mTriangleColors = NULL;
+	mMilliseconds = timer.Stop().Milliseconds;
+}
+
+bool ImpostorAtlas::Save(const std::string& filename) const
+{
+	if(IsEmpty())
+		return false;
+
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if(!file)
+		return false;
+
+	file.write((const char*)&C_FILE_MAGIC, sizeof(C_FILE_MAGIC));
+	file.write((const char*)&C_FILE_VERSION, sizeof(C_FILE_VERSION));
+	file.write((const char*)&mFramesPerSide, sizeof(mFramesPerSide));
+	file.write((const char*)&mFrameSize, sizeof(mFrameSize));
+	file.write((const char*)&mSphere.Center, sizeof(mSphere.Center));
+	file.write((const char*)&mSphere.Radius, sizeof(mSphere.Radius));
+	file.write((const char*)&mColors[0], mColors.size() * sizeof(mColors[0]));
+	file.write((const char*)&mNormalDepths[0], mNormalDepths.size() * sizeof(mNormalDepths[0]));
+
+	return file.good();
+}
+
+// Read an atlas written by Save, the atlas is left empty if the file is missing or damaged
+bool ImpostorAtlas::Load(const std::string& filename)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if(!file)
+		return false;
+
+	unsigned int magic = 0;
+	unsigned int version = 0;
+	int framesPerSide = 0;
+	int frameSize = 0;
+	BoundingSphere sphere;
+	file.read((char*)&magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&framesPerSide, sizeof(framesPerSide));
+	file.read((char*)&frameSize, sizeof(frameSize));
+	file.read((char*)&sphere.Center, sizeof(sphere.Center));
+	file.read((char*)&sphere.Radius, sizeof(sphere.Radius));
+
+	if(!file || magic != C_FILE_MAGIC || version != C_FILE_VERSION || framesPerSide <= 0 || frameSize <= 0)
+		return false;
+
+	int numTexels = framesPerSide * frameSize * framesPerSide * frameSize;
+	std::vector<unsigned int> colors(numTexels);
+	std::vector<unsigned int> normalDepths(numTexels);
+	file.read((char*)&colors[0], numTexels * sizeof(colors[0]));
+	file.read((char*)&normalDepths[0], numTexels * sizeof(normalDepths[0]));
+	if(!file)
+		return false;
+
+	mFramesPerSide = framesPerSide;
+	mFrameSize = frameSize;
+	mSphere = sphere;
+	mColors.swap(colors);
+	mNormalDepths.swap(normalDepths);
+	mMilliseconds = 0.0;
+	return true;
+}
+
+bool ImpostorAtlas::IsEmpty() const
+{
+	return mColors.empty();
+}
+
+int ImpostorAtlas::GetFramesPerSide() const
+{
+	return mFramesPerSide;
+}
+
+int ImpostorAtlas::GetFrameSize() const
+{
+	return mFrameSize;
+}
+
+// Texels along each side of the atlas
+int ImpostorAtlas::GetSize() const
+{
+	return mFramesPerSide * mFrameSize;
+}
+
+// Object space sphere that every frame is fitted to
+const BoundingSphere& ImpostorAtlas::GetSphere() const
+{
+	return mSphere;
+}
+
+const std::vector<unsigned int>& ImpostorAtlas::GetColors() const
+{
+	return mColors;
+}
+
+const std::vector<unsigned int>& ImpostorAtlas::GetNormalDepths() const
+{
+	return mNormalDepths;
+}
+
+// How long the last Generate took, 0 for a loaded atlas
+double ImpostorAtlas::GetMilliseconds() const
+{
+	return mMilliseconds;
+}
+
+// Point in [0, 1]² for a direction, the shader does the same
+D3DXVECTOR2 ImpostorAtlas::EncodeOctahedral(const D3DXVECTOR3& direction)
+{
+	float sum = fabs(direction.x) + fabs(direction.y) + fabs(direction.z);
+	float x = direction.x / sum;
+	float z = direction.z / sum;
+
+	if(direction.y < 0.0f)
+	{
+		float foldedX = (1.0f - fabs(z)) * Sign(x);
+		z = (1.0f - fabs(x)) * Sign(z);
+		x = foldedX;
+	}
+
+	return D3DXVECTOR2(x * 0.5f + 0.5f, z * 0.5f + 0.5f);
+}
+
+D3DXVECTOR3 ImpostorAtlas::DecodeOctahedral(const D3DXVECTOR2& uv)
+{
+	float x = uv.x * 2.0f - 1.0f;
+	float z = uv.y * 2.0f - 1.0f;
+	float y = 1.0f - fabs(x) - fabs(z);
+
+	if(y < 0.0f)
+	{
+		float unfoldedX = (1.0f - fabs(z)) * Sign(x);
+		z = (1.0f - fabs(x)) * Sign(z);
+		x = unfoldedX;
+	}
+
+	D3DXVECTOR3 direction(x, y, z);
+	D3DXVec3Normalize(&direction, &direction);
+	return direction;
+}
+
+// Axes of the view from a direction (pointing from the object towards the viewer), built like
+// D3DXMatrixLookAtLH builds them. Straight above and below the up vector is changed to z.
+void ImpostorAtlas::GetFrameAxes(const D3DXVECTOR3& direction, D3DXVECTOR3& right, D3DXVECTOR3& up)
+{
+	D3DXVECTOR3 worldUp = fabs(direction.y) > 0.99f ? D3DXVECTOR3(0.0f, 0.0f, 1.0f) : D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+	D3DXVECTOR3 forward = -direction;
+
+	D3DXVec3Cross(&right, &worldUp, &forward);
+	D3DXVec3Normalize(&right, &right);
+	D3DXVec3Cross(&up, &forward, &right);
+}
+
+void ImpostorAtlas::FramesJob(void* data, int first, int count)
+{
+	ImpostorAtlas* atlas = static_cast<ImpostorAtlas*>(data);
+	for(int frame = first; frame < first + count; ++frame)
+	{
+		atlas->RenderFrame(frame);
+		atlas->DilateFrame(frame);
+	}
+}
+
+// Cast one ray per texel through the sphere, from the side facing the frame's direction. The frame
+// covers the sphere's silhouette, row 0 is the top.
+void ImpostorAtlas::RenderFrame(int frame)
+{
+	int frameX = frame % mFramesPerSide;
+	int frameY = frame / mFramesPerSide;
+	D3DXVECTOR3 direction = DecodeOctahedral(D3DXVECTOR2((frameX + 0.5f) / mFramesPerSide,
+														 (frameY + 0.5f) / mFramesPerSide));
+	D3DXVECTOR3 right;
+	D3DXVECTOR3 up;
+	GetFrameAxes(direction, right, up);
+
+	float radius = mSphere.Radius;
+	D3DXVECTOR3 start = mSphere.Center + direction * radius;
+	D3DXVECTOR3 ray = direction * (-2.0f * radius);
+
+	for(int y = 0; y < mFrameSize; ++y)
+	{
+		for(int x = 0; x < mFrameSize; ++x)
+		{
+			float s = (x + 0.5f) / mFrameSize * 2.0f - 1.0f;
+			float t = 1.0f - (y + 0.5f) / mFrameSize * 2.0f;
+			D3DXVECTOR3 origin = start + right * (s * radius) + up * (t * radius);
+
+			RayHit hit;
+			if(!mBVH->RayCast(origin, ray, 1.0f, hit))
+				continue;
+
+			int v0 = hit.Triangle * 3;
+			float w0 = 1.0f - hit.U - hit.V;
+			D3DXVECTOR3 normal = mNormals[v0] * w0 + mNormals[v0 + 1] * hit.U + mNormals[v0 + 2] * hit.V;
+			if(D3DXVec3LengthSq(&normal) < 1e-12f)
+				normal = direction;
+			D3DXVec3Normalize(&normal, &normal);
+
+			// The meshes are drawn without back face culling, so the side that is seen faces the viewer
+			if(D3DXVec3Dot(&normal, &direction) < 0.0f)
+				normal = -normal;
+
+			float occlusion = 1.0f;
+			if(mOcclusion != NULL)
+				occlusion = mOcclusion[v0] * w0 + mOcclusion[v0 + 1] * hit.U + mOcclusion[v0 + 2] * hit.V;
+
+			const D3DXVECTOR3& color = mTriangleColors[hit.Triangle];
+			int texel = (frameY * mFrameSize + y) * GetSize() + frameX * mFrameSize + x;
+			mColors[texel] = PackColor(color.x * occlusion, color.y * occlusion, color.z * occlusion, 1.0f);
+			mNormalDepths[texel] = PackColor(normal.x * 0.5f + 0.5f, normal.y * 0.5f + 0.5f, normal.z * 0.5f + 0.5f,
+											 hit.Distance);
+		}
+	}
+}
+
+// Give the empty texels around the mesh the average of their covered neighbours, so that filtering
+// at the silhouette does not blend in black. Coverage stays 0, the texels are still cut away.
+void ImpostorAtlas::DilateFrame(int frame)
+{
+	int firstX = (frame % mFramesPerSide) * mFrameSize;
+	int firstY = (frame / mFramesPerSide) * mFrameSize;
+	int size = GetSize();
+
+	for(int pass = 0; pass < C_DILATION_PASSES; ++pass)
+	{
+		// Filled texels are written to a copy of the frame, so they are not read again in the same pass
+		std::vector<unsigned int> colors(mFrameSize * mFrameSize);
+		std::vector<unsigned int> normalDepths(mFrameSize * mFrameSize);
+
+		for(int y = 0; y < mFrameSize; ++y)
+		{
+			for(int x = 0; x < mFrameSize; ++x)
+			{
+				int texel = (firstY + y) * size + firstX + x;
+				colors[y * mFrameSize + x] = mColors[texel];
+				normalDepths[y * mFrameSize + x] = mNormalDepths[texel];
+				if(mColors[texel] != 0)
+					continue;
+
+				unsigned int colorSums[3] = { 0, 0, 0 };
+				unsigned int normalSums[4] = { 0, 0, 0, 0 };
+				int numNeighbours = 0;
+				for(int n = 0; n < 4; ++n)
+				{
+					int neighbourX = x + (n == 0 ? -1 : n == 1 ? 1 : 0);
+					int neighbourY = y + (n == 2 ? -1 : n == 3 ? 1 : 0);
+					if(neighbourX < 0 || neighbourX >= mFrameSize || neighbourY < 0 || neighbourY >= mFrameSize)
+						continue;
+
+					int neighbour = (firstY + neighbourY) * size + firstX + neighbourX;
+					if(mColors[neighbour] == 0)
+						continue;
+
+					for(int c = 0; c < 3; ++c)
+						colorSums[c] += (mColors[neighbour] >> (8 * c)) & 255;
+					for(int c = 0; c < 4; ++c)
+						normalSums[c] += (mNormalDepths[neighbour] >> (8 * c)) & 255;
+					++numNeighbours;
+				}
+
+				if(numNeighbours == 0)
+					continue;
+
+				// Alpha 0 but never all zero, so the next pass counts the texel as filled
+				unsigned int color = 0;
+				unsigned int normalDepth = 0;
+				for(int c = 0; c < 3; ++c)
+					color |= std::max(colorSums[c] / numNeighbours, 1u) << (8 * c);
+				for(int c = 0; c < 4; ++c)
+					normalDepth |= (normalSums[c] / numNeighbours) << (8 * c);
+
+				colors[y * mFrameSize + x] = color;
+				normalDepths[y * mFrameSize + x] = normalDepth;
+			}
+		}
+
+		for(int y = 0; y < mFrameSize; ++y)
+		{
+			std::copy(colors.begin() + y * mFrameSize, colors.begin() + (y + 1) * mFrameSize,
+					  mColors.begin() + (firstY + y) * size + firstX);
+			std::copy(normalDepths.begin() + y * mFrameSize, normalDepths.begin() + (y + 1) * mFrameSize,
+					  mNormalDepths.begin() + (firstY + y) * size + firstX);
+		}
+	}
+}
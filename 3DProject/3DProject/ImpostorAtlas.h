@@ -0,0 +1,63 @@
+#ifndef IMPOSTOR_ATLAS_H
+#define IMPOSTOR_ATLAS_H
+
+#include <vector>
+#include <string>
+#include <D3DX10.h>
+
+#include "TriangleBVH.h"
+#include "JobSystem.h"
+
+// Views of a mesh from a set of directions, for drawing it as a camera facing quad from far away.
+//
+// The directions cover the whole sphere and are laid out on an octahedral map: the upper half of the
+// sphere maps to the inner diamond of a square and the lower half is folded out into its corners. The
+// square is cut into frames, each frame holds the view from the direction at its center. There are
+// two atlases: the color (the material's diffuse color darkened by the baked occlusion, alpha is
+// coverage) and the object space normal with the depth through the bounding sphere in alpha.
+//
+// The views are ray cast against the mesh's tree on the CPU, one job per frame, so an atlas can be
+// made without a device and saved to a file ahead of time.
+class ImpostorAtlas
+{
+public:
+	ImpostorAtlas();
+
+	void Generate(const TriangleBVH& bvh, const D3DXVECTOR3* normals, const float* occlusion,
+				  const D3DXVECTOR3* colors, int framesPerSide, int frameSize, JobSystem* jobSystem);
+	bool Save(const std::string& filename) const;
+	bool Load(const std::string& filename);
+
+	bool IsEmpty() const;
+	int GetFramesPerSide() const;
+	int GetFrameSize() const;
+	int GetSize() const;
+	const BoundingSphere& GetSphere() const;
+	const std::vector<unsigned int>& GetColors() const;
+	const std::vector<unsigned int>& GetNormalDepths() const;
+	double GetMilliseconds() const;
+
+	static D3DXVECTOR2 EncodeOctahedral(const D3DXVECTOR3& direction);
+	static D3DXVECTOR3 DecodeOctahedral(const D3DXVECTOR2& uv);
+	static void GetFrameAxes(const D3DXVECTOR3& direction, D3DXVECTOR3& right, D3DXVECTOR3& up);
+
+private:
+	int							mFramesPerSide;
+	int							mFrameSize;						// Texels along each side of a frame
+	BoundingSphere				mSphere;
+	std::vector<unsigned int>	mColors;						// RGBA, red in the lowest byte
+	std::vector<unsigned int>	mNormalDepths;
+	double						mMilliseconds;
+
+	// What the frame jobs read
+	const TriangleBVH*			mBVH;
+	const D3DXVECTOR3*			mNormals;						// Per vertex of the tree's triangle list
+	const float*				mOcclusion;						// Per vertex, may be NULL
+	const D3DXVECTOR3*			mTriangleColors;
+
+	static void FramesJob(void* data, int first, int count);
+
+	void RenderFrame(int frame);
+	void DilateFrame(int frame);
+};
+#endif
@@ -0,0 +1,125 @@
+#include "ImpostorRenderer.h"
+#include <algorithm>
+
+const int ImpostorRenderer::C_BATCH_SIZE = 16384;
+const char* ImpostorRenderer::C_FILENAME = "Impostor.fx";
+
+ImpostorRenderer::ImpostorRenderer()
+	: mDevice(0), mEffect(0), mTechnique(0), mVertexLayout(0), mInstanceBuffer(RenderDevice::C_NO_BUFFER), mColorSRV(0), mNormalDepthSRV(0),
+	  mSphere(0.0f, 0.0f, 0.0f, 0.0f), mFramesPerSide(0), mfxViewProj(0), mfxEyePos(0), mfxLightPosition(0),
+	  mfxSphere(0), mfxFramesPerSide(0), mfxColorAtlas(0), mfxNormalDepthAtlas(0)
+{
+}
+
+ImpostorRenderer::~ImpostorRenderer()
+{
+	if(mDevice == NULL)
+		return;
+
+	mDevice->ReleaseEffect(mEffect);
+	mDevice->ReleaseInputLayout(mVertexLayout);
+	mDevice->ReleaseBuffer(mInstanceBuffer);
+	mDevice->ReleaseShaderView(mColorSRV);
+	mDevice->ReleaseShaderView(mNormalDepthSRV);
+}
+
+void ImpostorRenderer::Initialize(RenderDevice* device, const ImpostorAtlas& atlas)
+{
+	mDevice = device;
+	mSphere = D3DXVECTOR4(atlas.GetSphere().Center, atlas.GetSphere().Radius);
+	mFramesPerSide = atlas.GetFramesPerSide();
+
+	mEffect = mDevice->CreateEffect(C_FILENAME);
+	if(mEffect == NULL)
+		return;
+
+	mTechnique = mDevice->GetTechnique(mEffect, "DrawTechnique");
+	if(FAILED(CreateVertexLayout()))
+		return;
+
+	mColorSRV = CreateAtlasTexture(atlas.GetColors(), atlas.GetSize());
+	mNormalDepthSRV = CreateAtlasTexture(atlas.GetNormalDepths(), atlas.GetSize());
+
+	RenderBufferDesc bufferDesc(C_BATCH_SIZE * sizeof(ImpostorInstance), RenderBindVertexBuffer, RenderUsageDynamic);
+	mInstanceBuffer = mDevice->CreateBuffer(bufferDesc, NULL);
+	if(mInstanceBuffer == RenderDevice::C_NO_BUFFER)
+		MessageBox(0, "Error Creating Impostor Instance Buffer", "", 0);
+
+	mfxViewProj = mDevice->GetVariable(mEffect, "gViewProj");
+	mfxEyePos = mDevice->GetVariable(mEffect, "gEyePos");
+	mfxLightPosition = mDevice->GetVariable(mEffect, "gLightPosition");
+	mfxSphere = mDevice->GetVariable(mEffect, "gSphere");
+	mfxFramesPerSide = mDevice->GetVariable(mEffect, "gFramesPerSide");
+	mfxColorAtlas = mDevice->GetVariable(mEffect, "gColorAtlas");
+	mfxNormalDepthAtlas = mDevice->GetVariable(mEffect, "gNormalDepthAtlas");
+}
+
+// Draw the instances in batches that fit the instance buffer
+void ImpostorRenderer::Draw(const ImpostorInstance* instances, int count, const D3DXMATRIX& viewProj,
+							const D3DXVECTOR3& eyePos, const D3DXVECTOR3& lightPos)
+{
+	if(mInstanceBuffer == RenderDevice::C_NO_BUFFER || mColorSRV == NULL || mNormalDepthSRV == NULL || count == 0)
+		return;
+
+	D3DXVECTOR4 eye(eyePos, 1.0f);
+	mDevice->SetMatrix(mfxViewProj, (const float*)&viewProj);
+	mDevice->SetFloatVector(mfxEyePos, (const float*)&eye);
+	mDevice->SetFloatVector(mfxLightPosition, (const float*)&lightPos);
+	mDevice->SetFloatVector(mfxSphere, (const float*)&mSphere);
+	mDevice->SetFloat(mfxFramesPerSide, (float)mFramesPerSide);
+	mDevice->SetShaderView(mfxColorAtlas, mColorSRV);
+	mDevice->SetShaderView(mfxNormalDepthAtlas, mNormalDepthSRV);
+
+	mDevice->SetInputLayout(mVertexLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyPointList);
+	mDevice->SetVertexBuffer(mInstanceBuffer, sizeof(ImpostorInstance));
+	mDevice->ApplyPass(mDevice->GetPass(mTechnique, 0));
+
+	for(int first = 0; first < count; first += C_BATCH_SIZE)
+	{
+		int batchSize = std::min(C_BATCH_SIZE, count - first);
+
+		mDevice->UpdateBuffer(mInstanceBuffer, instances + first, batchSize * sizeof(ImpostorInstance));
+		mDevice->Draw(batchSize, 0);
+	}
+
+	mDevice->SetShaderView(mfxColorAtlas, NULL);
+	mDevice->SetShaderView(mfxNormalDepthAtlas, NULL);
+	mDevice->ApplyPass(mDevice->GetPass(mTechnique, 0));
+}
+
+// One point per instance
+HRESULT ImpostorRenderer::CreateVertexLayout()
+{
+	RenderVertexElement vertexDesc[] =
+	{
+		{ "POSITION", 0, RenderFormatR32G32B32Float, 0 },
+		{ "SCALE", 0, RenderFormatR32Float, sizeof(D3DXVECTOR3) },
+		{ "ROTATION", 0, RenderFormatR32G32Float, sizeof(D3DXVECTOR3) + sizeof(float) }
+	};
+
+	mVertexLayout = mDevice->CreateInputLayout(vertexDesc, 3, mDevice->GetPass(mTechnique, 0));
+	return mVertexLayout != NULL ? S_OK : E_FAIL;
+}
+
+// Immutable texture with the atlas texels, no mip maps since they would blend neighbouring frames
+RenderShaderView ImpostorRenderer::CreateAtlasTexture(const std::vector<unsigned int>& texels, int size)
+{
+	if(texels.empty())
+		return NULL;
+
+	RenderTextureDesc desc(size, size, 1, RenderFormatR8G8B8A8Unorm, RenderBindShaderResource, RenderUsageImmutable);
+	RenderTexture texture = mDevice->CreateTexture(desc, &texels[0], size * sizeof(unsigned int));
+	if(texture == NULL)
+	{
+		MessageBox(0, "Error Creating Impostor Atlas Texture", "", 0);
+		return NULL;
+	}
+
+	RenderShaderView srv = mDevice->CreateShaderView(texture, RenderViewTexture2D);
+	if(srv == NULL)
+		MessageBox(0, "Error Creating Impostor Atlas Shader Resource View", "", 0);
+
+	mDevice->ReleaseTexture(texture);
+	return srv;
+}
@@ -0,0 +1,55 @@
+#ifndef IMPOSTOR_RENDERER_H
+#define IMPOSTOR_RENDERER_H
+
+#include <D3DX10.h>
+#include "Globals.h"
+#include "RenderDevice.h"
+#include "ImpostorAtlas.h"
+
+struct ImpostorInstance
+{
+	D3DXVECTOR3			Position;				// Of the mesh's origin
+	float				Scale;
+	float				Cos;					// Rotation about the y axis, as in the moving objects' world matrices
+	float				Sin;
+};
+
+// Draws instances of one mesh as impostors. Every instance is a point that the geometry shader
+// turns into a quad facing the camera, with the atlas frame closest to the direction of the camera.
+// The pixel shader cuts away what the mesh does not cover, lights the rest with the atlas normals
+// and writes the depth of the mesh surface rather than that of the quad.
+class ImpostorRenderer
+{
+public:
+	ImpostorRenderer();
+	~ImpostorRenderer();
+	void Initialize(RenderDevice* device, const ImpostorAtlas& atlas);
+	void Draw(const ImpostorInstance* instances, int count, const D3DXMATRIX& viewProj, const D3DXVECTOR3& eyePos,
+			  const D3DXVECTOR3& lightPos);
+
+private:
+	RenderDevice*							mDevice;
+	RenderEffect							mEffect;
+	RenderTechnique							mTechnique;
+	RenderInputLayout						mVertexLayout;
+	RenderBuffer							mInstanceBuffer;		// Dynamic, refilled for every batch
+	RenderShaderView						mColorSRV;
+	RenderShaderView						mNormalDepthSRV;
+	D3DXVECTOR4								mSphere;
+	int										mFramesPerSide;
+
+	RenderVariable							mfxViewProj;
+	RenderVariable							mfxEyePos;
+	RenderVariable							mfxLightPosition;
+	RenderVariable							mfxSphere;
+	RenderVariable							mfxFramesPerSide;
+	RenderVariable							mfxColorAtlas;
+	RenderVariable							mfxNormalDepthAtlas;
+
+	static const int			C_BATCH_SIZE;
+	static const char*			C_FILENAME;
+
+	HRESULT CreateVertexLayout();
+	RenderShaderView CreateAtlasTexture(const std::vector<unsigned int>& texels, int size);
+};
+#endif
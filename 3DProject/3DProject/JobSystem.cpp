@@ -0,0 +1,304 @@
+#include "JobSystem.h"
+
+namespace
+{
+	const int C_INITIAL_DEQUE_SIZE = 256;
+}
+
+// The worker the calling thread belongs to, NULL for threads that were not started by a job system
+static THREAD_LOCAL void* tCurrentWorker = NULL;
+
+JobCounter::JobCounter()
+	: mPending(0)
+{
+}
+
+// Check if every job counted by the counter has finished
+bool JobCounter::IsDone() const
+{
+	JobCounter* self = const_cast<JobCounter*>(this);
+	if(Atomic::Load(&self->mPending) > 0)
+		return false;
+
+	// Make sure the worker that finished the last job has let go of the counter, so it can be destroyed
+	ScopedLock lock(self->mLock);
+	return true;
+}
+
+JobSystem::Worker::Worker()
+	: Jobs(C_INITIAL_DEQUE_SIZE), Top(0), Bottom(0), JobsExecuted(0), Steals(0), StealAttempts(0),
+	  System(NULL), Index(0)
+{
+}
+
+// Create the workers, one per hardware thread if numWorkers is 0. The creating thread is worker 0.
+JobSystem::JobSystem(int numWorkers)
+	: mQueuedJobs(0), mSleepingWorkers(0), mQuit(0)
+{
+	if(numWorkers <= 0)
+		numWorkers = Thread::GetHardwareThreadCount();
+
+	for(int i = 0; i < numWorkers; ++i)
+	{
+		Worker* worker = new Worker();
+		worker->System = this;
+		worker->Index = i;
+		mWorkers.push_back(worker);
+	}
+
+	tCurrentWorker = mWorkers[0];
+
+	for(int i = 1; i < numWorkers; ++i)
+		mWorkers[i]->WorkerThread.Start(WorkerMain, mWorkers[i]);
+}
+
+JobSystem::~JobSystem()
+{
+	mSleepLock.Lock();
+	Atomic::Store(&mQuit, 1);
+	mWakeUp.NotifyAll();
+	mSleepLock.Unlock();
+
+	if(tCurrentWorker == mWorkers[0])
+		tCurrentWorker = NULL;
+
+	// Every thread must have stopped before any worker is deleted, a thread that is still looking for
+	// a job may be about to lock the deque of any of them
+	for(size_t i = 0; i < mWorkers.size(); ++i)
+		mWorkers[i]->WorkerThread.Join();
+
+	for(size_t i = 0; i < mWorkers.size(); ++i)
+		delete mWorkers[i];
+}
+
+// Queue a job working on [first, first + count). If a dependency is given the job is held back until
+// all of the dependency's jobs have finished.
+void JobSystem::Run(JobFunction function, void* data, int first, int count, JobCounter* counter,
+					JobCounter* dependency)
+{
+	if(counter != NULL)
+		Atomic::Increment(&counter->mPending);
+
+	Job job;
+	job.Function = function;
+	job.Data = data;
+	job.First = first;
+	job.Count = count;
+	job.Counter = counter;
+
+	if(dependency != NULL)
+	{
+		ScopedLock lock(dependency->mLock);
+		if(Atomic::Load(&dependency->mPending) > 0)
+		{
+			dependency->mContinuations.push_back(job);
+			return;
+		}
+	}
+
+	Push(job);
+}
+
+// Split [0, count) into jobs of grainSize elements. Keeping the grain size a multiple of four keeps
+// every job aligned to whole SIMD blocks.
+void JobSystem::ParallelFor(JobFunction function, void* data, int count, int grainSize, JobCounter* counter,
+							JobCounter* dependency)
+{
+	if(grainSize <= 0)
+		grainSize = 1;
+
+	for(int first = 0; first < count; first += grainSize)
+	{
+		int rangeCount = count - first < grainSize ? count - first : grainSize;
+		Run(function, data, first, rangeCount, counter, dependency);
+	}
+}
+
+// Run queued jobs on the calling thread until the counter reaches zero
+void JobSystem::Wait(JobCounter* counter)
+{
+	Worker* worker = GetCurrentWorker();
+
+	while(Atomic::Load(&counter->mPending) > 0)
+	{
+		Job job;
+		if(FindJob(worker, job))
+			Execute(worker, job);
+		else
+			Thread::YieldThread();
+	}
+
+	ScopedLock lock(counter->mLock);
+}
+
+int JobSystem::GetWorkerCount() const
+{
+	return (int)mWorkers.size();
+}
+
+// Sum up the statistics of all workers since the last reset
+JobStatistics JobSystem::GetStatistics() const
+{
+	JobStatistics statistics;
+	statistics.JobsExecuted = 0;
+	statistics.Steals = 0;
+	statistics.StealAttempts = 0;
+	statistics.Workers = (int)mWorkers.size();
+
+	for(size_t i = 0; i < mWorkers.size(); ++i)
+	{
+		statistics.JobsExecuted += mWorkers[i]->JobsExecuted;
+		statistics.Steals += mWorkers[i]->Steals;
+		statistics.StealAttempts += mWorkers[i]->StealAttempts;
+	}
+
+	return statistics;
+}
+
+void JobSystem::ResetStatistics()
+{
+	for(size_t i = 0; i < mWorkers.size(); ++i)
+	{
+		Atomic::Store(&mWorkers[i]->JobsExecuted, 0);
+		Atomic::Store(&mWorkers[i]->Steals, 0);
+		Atomic::Store(&mWorkers[i]->StealAttempts, 0);
+	}
+}
+
+// The loop of the worker threads: run jobs while there are any, sleep when there are none
+void JobSystem::WorkerMain(void* workerPointer)
+{
+	Worker* worker = static_cast<Worker*>(workerPointer);
+	JobSystem* system = worker->System;
+	tCurrentWorker = worker;
+
+	while(Atomic::Load(&system->mQuit) == 0)
+	{
+		Job job;
+		if(system->FindJob(worker, job))
+		{
+			system->Execute(worker, job);
+			continue;
+		}
+
+		system->mSleepLock.Lock();
+		Atomic::Increment(&system->mSleepingWorkers);
+		while(Atomic::Load(&system->mQueuedJobs) == 0 && Atomic::Load(&system->mQuit) == 0)
+			system->mWakeUp.Wait(system->mSleepLock);
+		Atomic::Decrement(&system->mSleepingWorkers);
+		system->mSleepLock.Unlock();
+	}
+}
+
+// Push a job to the bottom of the calling worker's deque and wake a sleeping worker to steal it
+void JobSystem::Push(const Job& job)
+{
+	Worker* worker = GetCurrentWorker();
+
+	worker->Lock.Lock();
+	int size = (int)worker->Jobs.size();
+	if(worker->Bottom - worker->Top == size)
+	{
+		std::vector<Job> jobs(size * 2);
+		for(int i = worker->Top; i < worker->Bottom; ++i)
+			jobs[i - worker->Top] = worker->Jobs[i & (size - 1)];
+
+		worker->Jobs.swap(jobs);
+		worker->Bottom -= worker->Top;
+		worker->Top = 0;
+		size *= 2;
+	}
+
+	worker->Jobs[worker->Bottom & (size - 1)] = job;
+	++worker->Bottom;
+	worker->Lock.Unlock();
+
+	Atomic::Increment(&mQueuedJobs);
+	if(Atomic::Load(&mSleepingWorkers) > 0)
+	{
+		ScopedLock lock(mSleepLock);
+		mWakeUp.NotifyOne();
+	}
+}
+
+// Take the newest job from the worker's own deque
+bool JobSystem::Pop(Worker* worker, Job& job)
+{
+	ScopedLock lock(worker->Lock);
+	if(worker->Bottom == worker->Top)
+		return false;
+
+	--worker->Bottom;
+	job = worker->Jobs[worker->Bottom & (worker->Jobs.size() - 1)];
+	Atomic::Decrement(&mQueuedJobs);
+
+	return true;
+}
+
+// Take the oldest job from another worker's deque, trying the workers in order after the thief
+bool JobSystem::Steal(Worker* thief, Job& job)
+{
+	int numWorkers = (int)mWorkers.size();
+	for(int i = 1; i < numWorkers; ++i)
+	{
+		Worker* victim = mWorkers[(thief->Index + i) % numWorkers];
+		Atomic::Increment(&thief->StealAttempts);
+
+		ScopedLock lock(victim->Lock);
+		if(victim->Bottom == victim->Top)
+			continue;
+
+		job = victim->Jobs[victim->Top & (victim->Jobs.size() - 1)];
+		++victim->Top;
+		Atomic::Decrement(&mQueuedJobs);
+		Atomic::Increment(&thief->Steals);
+
+		return true;
+	}
+
+	return false;
+}
+
+bool JobSystem::FindJob(Worker* worker, Job& job)
+{
+	if(Pop(worker, job))
+		return true;
+	if(Atomic::Load(&mQueuedJobs) == 0)
+		return false;
+
+	return Steal(worker, job);
+}
+
+void JobSystem::Execute(Worker* worker, const Job& job)
+{
+	job.Function(job.Data, job.First, job.Count);
+	Atomic::Increment(&worker->JobsExecuted);
+
+	if(job.Counter != NULL)
+		Finish(job.Counter);
+}
+
+// Count down a finished job and queue the jobs waiting for the counter if it was the last one
+void JobSystem::Finish(JobCounter* counter)
+{
+	std::vector<Job> continuations;
+
+	counter->mLock.Lock();
+	if(Atomic::Decrement(&counter->mPending) == 0)
+		continuations.swap(counter->mContinuations);
+	counter->mLock.Unlock();
+
+	// The counter may be destroyed by a waiting thread from here on
+	for(size_t i = 0; i < continuations.size(); ++i)
+		Push(continuations[i]);
+}
+
+// Threads that are not workers, like the one that created the system, share worker 0's deque
+JobSystem::Worker* JobSystem::GetCurrentWorker()
+{
+	Worker* worker = static_cast<Worker*>(tCurrentWorker);
+	if(worker != NULL && worker->System == this)
+		return worker;
+
+	return mWorkers[0];
+}
@@ -0,0 +1,106 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <vector>
+#include "Threading.h"
+
+// A job works on the range [first, first + count) of whatever data it is given
+typedef void (*JobFunction)(void* data, int first, int count);
+
+class JobCounter;
+
+struct Job
+{
+	JobFunction			Function;
+	void*				Data;
+	int					First;
+	int					Count;
+	JobCounter*			Counter;			// Decremented when the job is finished, may be NULL
+};
+
+// Counts the unfinished jobs of a group. Jobs can be made to depend on a counter, they are then
+// queued first when every job counted by it has finished.
+class JobCounter
+{
+public:
+	JobCounter();
+	bool IsDone() const;
+
+private:
+	friend class JobSystem;
+
+	volatile long				mPending;
+	Mutex						mLock;
+	std::vector<Job>			mContinuations;
+
+	JobCounter(const JobCounter&);
+	JobCounter& operator=(const JobCounter&);
+};
+
+struct JobStatistics
+{
+	long				JobsExecuted;
+	long				Steals;
+	long				StealAttempts;
+	int					Workers;
+};
+
+// Work-stealing scheduler. Every worker, including the thread that created the system, has a deque
+// of its own. New jobs are pushed to the bottom of the spawning worker's deque and popped from there
+// in LIFO order, while idle workers steal from the top of the other workers' deques.
+class JobSystem
+{
+public:
+	JobSystem(int numWorkers = 0);
+	~JobSystem();
+
+	void Run(JobFunction function, void* data, int first, int count, JobCounter* counter,
+			 JobCounter* dependency = NULL);
+	void ParallelFor(JobFunction function, void* data, int count, int grainSize, JobCounter* counter,
+					 JobCounter* dependency = NULL);
+	void Wait(JobCounter* counter);
+
+	int GetWorkerCount() const;
+	JobStatistics GetStatistics() const;
+	void ResetStatistics();
+
+private:
+	// The deque is a ring buffer protected by a lock. The owner works at the bottom, thieves at the top.
+	struct Worker
+	{
+		Mutex					Lock;
+		std::vector<Job>		Jobs;
+		int						Top;
+		int						Bottom;
+		volatile long			JobsExecuted;
+		volatile long			Steals;
+		volatile long			StealAttempts;
+		Thread					WorkerThread;
+		JobSystem*				System;
+		int						Index;
+		char					Padding[64];	// Keep workers that are next to each other off the same cache line
+
+		Worker();
+	};
+
+	std::vector<Worker*>		mWorkers;
+	volatile long				mQueuedJobs;
+	volatile long				mSleepingWorkers;
+	volatile long				mQuit;
+	Mutex						mSleepLock;
+	ConditionVariable			mWakeUp;
+
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+
+	static void WorkerMain(void* worker);
+
+	void Push(const Job& job);
+	bool Pop(Worker* worker, Job& job);
+	bool Steal(Worker* thief, Job& job);
+	bool FindJob(Worker* worker, Job& job);
+	void Execute(Worker* worker, const Job& job);
+	void Finish(JobCounter* counter);
+	Worker* GetCurrentWorker();
+};
+#endif
@@ -0,0 +1,116 @@
+#include "Light.h"
+#include <cmath>
+
+namespace
+{
+	const float C_SPOT_FRUSTUM_MARGIN = 1.1f;	// The frustum is wider than the cone, filters do not reach past the tile
+	const float C_SPOT_NEAR_FRACTION = 0.01f;	// Of the range
+}
+
+Light::Light(D3DXVECTOR3 position, D3DXVECTOR3 target, float width, float height, float nearDistance,
+			 float farDistance)
+	: mPosition(position), mTarget(target), mWidth(width), mHeight(height), mNearDistance(nearDistance),
+	  mFarDistance(farDistance), mVersion(0)
+{
+	UpdateMatrices();
+}
+
+void Light::SetPosition(const D3DXVECTOR3& position)
+{
+	if(position == mPosition)
+		return;
+
+	mPosition = position;
+	UpdateMatrices();
+}
+
+void Light::SetTarget(const D3DXVECTOR3& target)
+{
+	if(target == mTarget)
+		return;
+
+	mTarget = target;
+	UpdateMatrices();
+}
+
+// Size of the orthographic projection
+void Light::SetVolume(float width, float height, float nearDistance, float farDistance)
+{
+	if(width == mWidth && height == mHeight && nearDistance == mNearDistance && farDistance == mFarDistance)
+		return;
+
+	mWidth = width;
+	mHeight = height;
+	mNearDistance = nearDistance;
+	mFarDistance = farDistance;
+	UpdateMatrices();
+}
+
+const D3DXVECTOR3& Light::GetPosition() const
+{
+	return mPosition;
+}
+
+const D3DXVECTOR3& Light::GetTarget() const
+{
+	return mTarget;
+}
+
+const D3DXMATRIX& Light::GetViewMatrix() const
+{
+	return mViewMatrix;
+}
+
+const D3DXMATRIX& Light::GetProjectionMatrix() const
+{
+	return mProjectionMatrix;
+}
+
+const D3DXMATRIX& Light::GetViewProjectionMatrix() const
+{
+	return mViewProjectionMatrix;
+}
+
+const D3DXMATRIX& Light::GetInverseViewProjectionMatrix() const
+{
+	return mInverseViewProjectionMatrix;
+}
+
+const FrustumPlanes& Light::GetFrustumPlanes() const
+{
+	return mFrustumPlanes;
+}
+
+// Changes every time the matrices do
+unsigned int Light::GetVersion() const
+{
+	return mVersion;
+}
+
+void Light::UpdateMatrices()
+{
+	D3DXVECTOR3 up(0.0f, 1.0f, 0.0f);
+	D3DXMatrixLookAtLH(&mViewMatrix, &mPosition, &mTarget, &up);
+	D3DXMatrixOrthoLH(&mProjectionMatrix, mWidth, mHeight, mNearDistance, mFarDistance);
+
+	mViewProjectionMatrix = mViewMatrix * mProjectionMatrix;
+	if(D3DXMatrixInverse(&mInverseViewProjectionMatrix, NULL, &mViewProjectionMatrix) == NULL)
+		D3DXMatrixIdentity(&mInverseViewProjectionMatrix);
+	mFrustumPlanes.Extract(mViewProjectionMatrix);
+
+	++mVersion;
+}
+
+// A square frustum around the cone
+D3DXMATRIX SpotLight::GetViewProjectionMatrix() const
+{
+	D3DXVECTOR3 up = fabs(Direction.y) > 0.99f ? D3DXVECTOR3(0.0f, 0.0f, 1.0f) : D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+	D3DXVECTOR3 target = Position + Direction;
+
+	D3DXMATRIX view;
+	D3DXMATRIX projection;
+	D3DXMatrixLookAtLH(&view, &Position, &target, &up);
+	D3DXMatrixPerspectiveFovLH(&projection, 2.0f * Angle * C_SPOT_FRUSTUM_MARGIN, 1.0f, Range * C_SPOT_NEAR_FRACTION, Range);
+
+	return view * projection;
+}
@@ -0,0 +1,57 @@
+#ifndef LIGHT_H
+#define LIGHT_H
+
+#include <D3DX10.h>
+#include "FrustumPlanes.h"
+
+// The shadow casting light: a position looking at a target with an orthographic projection.
+// Like the camera it keeps its matrices and frustum planes up to date when something is set, and
+// the version changes only when a setter actually changed something.
+class Light
+{
+public:
+	Light(D3DXVECTOR3 position, D3DXVECTOR3 target, float width, float height, float nearDistance, float farDistance);
+	void SetPosition(const D3DXVECTOR3& position);
+	void SetTarget(const D3DXVECTOR3& target);
+	void SetVolume(float width, float height, float nearDistance, float farDistance);
+
+	const D3DXVECTOR3& GetPosition() const;
+	const D3DXVECTOR3& GetTarget() const;
+	const D3DXMATRIX& GetViewMatrix() const;
+	const D3DXMATRIX& GetProjectionMatrix() const;
+	const D3DXMATRIX& GetViewProjectionMatrix() const;
+	const D3DXMATRIX& GetInverseViewProjectionMatrix() const;
+	const FrustumPlanes& GetFrustumPlanes() const;
+	unsigned int GetVersion() const;
+
+private:
+	D3DXVECTOR3				mPosition;
+	D3DXVECTOR3				mTarget;
+	float					mWidth;
+	float					mHeight;
+	float					mNearDistance;
+	float					mFarDistance;
+
+	D3DXMATRIX				mViewMatrix;
+	D3DXMATRIX				mProjectionMatrix;
+	D3DXMATRIX				mViewProjectionMatrix;
+	D3DXMATRIX				mInverseViewProjectionMatrix;
+	FrustumPlanes			mFrustumPlanes;
+	unsigned int			mVersion;
+
+	void UpdateMatrices();
+};
+
+// A light with a cone that casts shadows into a tile of the shadow atlas
+struct SpotLight
+{
+	D3DXVECTOR3				Position;
+	D3DXVECTOR3				Direction;				// Normalized
+	D3DXVECTOR3				Color;
+	float					Range;
+	float					Angle;					// Half the cone's angle, in radians
+	float					Priority;				// Gives the light a larger tile that is drawn more often
+
+	D3DXMATRIX GetViewProjectionMatrix() const;
+};
+#endif
@@ -0,0 +1,299 @@
+#include "LightBaker.h"
+#include "GameTime.h"
+#include "Threading.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const int C_TILE_SIZE = 16;						// Texels along each side of a tile
+	const int C_LIGHTMAP_OCCLUSION_RAYS = 4;		// Per texel and pass
+	const int C_VERTEX_OCCLUSION_RAYS = 64;
+	const int C_VERTEX_GRAIN_SIZE = 256;
+	const float C_RAY_OFFSET = 0.01f;				// Along the normal, so rays do not hit their own surface
+	const float C_VERTEX_RAY_OFFSET = 0.01f;		// The same for vertices, as a fraction of the distance
+	const float C_TWO_PI = 6.28318531f;
+
+	// Number in [0, 1) from a sample's indices, so every bake gives the same result
+	float HashUnit(unsigned int a, unsigned int b, unsigned int c)
+	{
+		unsigned int value = a * 0x9E3779B1u ^ b * 0x85EBCA77u ^ c * 0xC2B2AE3Du;
+		value ^= value >> 16;
+		value *= 0x85EBCA6Bu;
+		value ^= value >> 13;
+		value *= 0xC2B2AE35u;
+		value ^= value >> 16;
+		return (value >> 8) * (1.0f / 16777216.0f);
+	}
+
+	unsigned char ToByte(float value)
+	{
+		return (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+LightBaker::LightBaker()
+	: mLightPosition(0.0f, 0.0f, 0.0f), mLightmapDistance(0.0f), mNumPasses(0), mPassRays(0), mVertexBVH(NULL),
+	  mVertexPositions(NULL), mVertexNormals(NULL), mVertexOcclusion(NULL), mVertexDistance(0.0f)
+{
+	ZeroMemory(&mRect, sizeof(mRect));
+	ZeroMemory(&mLightmapStatistics, sizeof(mLightmapStatistics));
+	ZeroMemory(&mVertexStatistics, sizeof(mVertexStatistics));
+}
+
+// Add a static mesh that shadows and occludes the lightmap. The tree must outlive the baker.
+void LightBaker::AddOccluder(const TriangleBVH* bvh, const D3DXMATRIX& world)
+{
+	Occluder occluder;
+	occluder.BVH = bvh;
+	if(D3DXMatrixInverse(&occluder.WorldInverse, NULL, &world) == NULL)
+		return;
+
+	mOccluders.push_back(occluder);
+}
+
+void LightBaker::ClearOccluders()
+{
+	mOccluders.clear();
+}
+
+void LightBaker::SetLight(const D3DXVECTOR3& position)
+{
+	mLightPosition = position;
+}
+
+// Start a new lightmap, which is then refined by calling RefineLightmap until IsLightmapDone
+void LightBaker::BeginLightmap(const LightmapRect& rect, float occlusionDistance, int numPasses)
+{
+	mRect = rect;
+	mLightmapDistance = occlusionDistance;
+	mNumPasses = numPasses;
+
+	mDirectSums.assign(rect.Width * rect.Height, 0.0f);
+	mOcclusionSums.assign(rect.Width * rect.Height, 0.0f);
+	ZeroMemory(&mLightmapStatistics, sizeof(mLightmapStatistics));
+}
+
+// Trace one more pass over every texel
+void LightBaker::RefineLightmap(JobSystem* jobSystem)
+{
+	if(IsLightmapDone())
+		return;
+
+	Stopwatch timer;
+	timer.Start();
+
+	mPassRays = 0;
+	if(jobSystem == NULL)
+		LightmapTilesJob(this, 0, GetTileCount());
+	else
+	{
+		JobCounter tilesDone;
+		jobSystem->ParallelFor(LightmapTilesJob, this, GetTileCount(), 1, &tilesDone);
+		jobSystem->Wait(&tilesDone);
+	}
+
+	++mLightmapStatistics.Passes;
+	mLightmapStatistics.Rays += mPassRays;
+	mLightmapStatistics.Milliseconds += timer.Stop().Milliseconds;
+}
+
+// Trace every pass of a new lightmap at once. Each texel's sum is only ever added to by the one job
+// that has its tile, in pass order, so this gives exactly the texels of refining it pass by pass.
+void LightBaker::BakeLightmap(const LightmapRect& rect, float occlusionDistance, int numPasses, JobSystem* jobSystem)
+{
+	BeginLightmap(rect, occlusionDistance, numPasses);
+	while(!IsLightmapDone())
+		RefineLightmap(jobSystem);
+}
+
+bool LightBaker::IsLightmapDone() const
+{
+	return mLightmapStatistics.Passes >= mNumPasses;
+}
+
+// Average of the passes so far, two bytes per texel: the direct light and the ambient occlusion,
+// where 1 is fully lit and unoccluded
+void LightBaker::GetLightmapTexels(unsigned char* texels) const
+{
+	int numTexels = mRect.Width * mRect.Height;
+	float scale = mLightmapStatistics.Passes > 0 ? 1.0f / mLightmapStatistics.Passes : 0.0f;
+
+	for(int i = 0; i < numTexels; ++i)
+	{
+		texels[2 * i] = ToByte(mDirectSums[i] * scale);
+		texels[2 * i + 1] = ToByte(mOcclusionSums[i] * scale);
+	}
+}
+
+const LightmapRect& LightBaker::GetLightmapRect() const
+{
+	return mRect;
+}
+
+const BakeStatistics& LightBaker::GetLightmapStatistics() const
+{
+	return mLightmapStatistics;
+}
+
+// Write the fraction of hemisphere rays from each vertex that escape the mesh within the distance.
+// Positions, normals and the distance are in the tree's space.
+void LightBaker::BakeVertexOcclusion(const TriangleBVH& bvh, const D3DXVECTOR3* positions,
+									 const D3DXVECTOR3* normals, int count, float occlusionDistance,
+									 JobSystem* jobSystem, float* occlusion)
+{
+	Stopwatch timer;
+	timer.Start();
+
+	mVertexBVH = &bvh;
+	mVertexPositions = positions;
+	mVertexNormals = normals;
+	mVertexOcclusion = occlusion;
+	mVertexDistance = occlusionDistance;
+	mPassRays = 0;
+
+	if(jobSystem == NULL)
+		VertexOcclusionJob(this, 0, count);
+	else
+	{
+		JobCounter verticesDone;
+		jobSystem->ParallelFor(VertexOcclusionJob, this, count, C_VERTEX_GRAIN_SIZE, &verticesDone);
+		jobSystem->Wait(&verticesDone);
+	}
+
+	mVertexStatistics.Passes = 1;
+	mVertexStatistics.Rays = mPassRays;
+	mVertexStatistics.Milliseconds = timer.Stop().Milliseconds;
+}
+
+const BakeStatistics& LightBaker::GetVertexStatistics() const
+{
+	return mVertexStatistics;
+}
+
+void LightBaker::LightmapTilesJob(void* data, int first, int count)
+{
+	LightBaker* baker = static_cast<LightBaker*>(data);
+	for(int tile = first; tile < first + count; ++tile)
+		baker->BakeTile(tile);
+}
+
+void LightBaker::VertexOcclusionJob(void* data, int first, int count)
+{
+	LightBaker* baker = static_cast<LightBaker*>(data);
+	long numRays = 0;
+
+	for(int i = first; i < first + count; ++i)
+	{
+		D3DXVECTOR3 normal = baker->mVertexNormals[i];
+		if(D3DXVec3LengthSq(&normal) < 1e-12f)
+		{
+			baker->mVertexOcclusion[i] = 1.0f;
+			continue;
+		}
+
+		D3DXVec3Normalize(&normal, &normal);
+		D3DXVECTOR3 origin = baker->mVertexPositions[i] + normal * (baker->mVertexDistance * C_VERTEX_RAY_OFFSET);
+
+		int numOpen = 0;
+		for(int k = 0; k < C_VERTEX_OCCLUSION_RAYS; ++k)
+		{
+			D3DXVECTOR3 direction = SampleHemisphere(normal, HashUnit(i, k, 0), HashUnit(i, k, 1));
+			if(!baker->mVertexBVH->IsOccluded(origin, direction, baker->mVertexDistance))
+				++numOpen;
+		}
+
+		baker->mVertexOcclusion[i] = (float)numOpen / C_VERTEX_OCCLUSION_RAYS;
+		numRays += C_VERTEX_OCCLUSION_RAYS;
+	}
+
+	Atomic::Add(&baker->mPassRays, numRays);
+}
+
+int LightBaker::GetTileCount() const
+{
+	int tilesX = (mRect.Width + C_TILE_SIZE - 1) / C_TILE_SIZE;
+	int tilesY = (mRect.Height + C_TILE_SIZE - 1) / C_TILE_SIZE;
+	return tilesX * tilesY;
+}
+
+// Trace the current pass for the texels of one tile. Each texel gets its own jittered point, one ray
+// towards the light and a few over the hemisphere.
+void LightBaker::BakeTile(int tile)
+{
+	int tilesX = (mRect.Width + C_TILE_SIZE - 1) / C_TILE_SIZE;
+	int firstX = (tile % tilesX) * C_TILE_SIZE;
+	int firstY = (tile / tilesX) * C_TILE_SIZE;
+	int endX = std::min(firstX + C_TILE_SIZE, mRect.Width);
+	int endY = std::min(firstY + C_TILE_SIZE, mRect.Height);
+	unsigned int pass = (unsigned int)mLightmapStatistics.Passes;
+
+	long numRays = 0;
+	for(int y = firstY; y < endY; ++y)
+	{
+		for(int x = firstX; x < endX; ++x)
+		{
+			int texel = y * mRect.Width + x;
+			float u = (x + HashUnit(texel, pass, 0)) / mRect.Width;
+			float v = (y + HashUnit(texel, pass, 1)) / mRect.Height;
+			D3DXVECTOR3 position = mRect.Origin + mRect.AxisU * u + mRect.AxisV * v + mRect.Normal * C_RAY_OFFSET;
+
+			D3DXVECTOR3 toLight = mLightPosition - position;
+			D3DXVECTOR3 lightDirection;
+			D3DXVec3Normalize(&lightDirection, &toLight);
+			float cosine = D3DXVec3Dot(&mRect.Normal, &lightDirection);
+			if(cosine > 0.0f)
+			{
+				++numRays;
+				if(!IsOccluded(position, toLight, 1.0f))
+					mDirectSums[texel] += cosine;
+			}
+
+			int numOpen = 0;
+			for(int k = 0; k < C_LIGHTMAP_OCCLUSION_RAYS; ++k)
+			{
+				D3DXVECTOR3 direction = SampleHemisphere(mRect.Normal, HashUnit(texel, pass, 2 + 2 * k),
+														 HashUnit(texel, pass, 3 + 2 * k));
+				if(!IsOccluded(position, direction, mLightmapDistance))
+					++numOpen;
+			}
+
+			mOcclusionSums[texel] += (float)numOpen / C_LIGHTMAP_OCCLUSION_RAYS;
+			numRays += C_LIGHTMAP_OCCLUSION_RAYS;
+		}
+	}
+
+	Atomic::Add(&mPassRays, numRays);
+}
+
+// Whether any occluder is hit, each one tested in its own object space
+bool LightBaker::IsOccluded(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance) const
+{
+	for(size_t i = 0; i < mOccluders.size(); ++i)
+	{
+		D3DXVECTOR3 localOrigin;
+		D3DXVECTOR3 localDirection;
+		D3DXVec3TransformCoord(&localOrigin, &origin, &mOccluders[i].WorldInverse);
+		D3DXVec3TransformNormal(&localDirection, &direction, &mOccluders[i].WorldInverse);
+
+		if(mOccluders[i].BVH->IsOccluded(localOrigin, localDirection, maxDistance))
+			return true;
+	}
+
+	return false;
+}
+
+// Cosine weighted direction around the normal from two numbers in [0, 1)
+D3DXVECTOR3 LightBaker::SampleHemisphere(const D3DXVECTOR3& normal, float u1, float u2)
+{
+	D3DXVECTOR3 helper = fabs(normal.x) < 0.9f ? D3DXVECTOR3(1.0f, 0.0f, 0.0f) : D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+	D3DXVECTOR3 tangent;
+	D3DXVECTOR3 bitangent;
+	D3DXVec3Cross(&tangent, &helper, &normal);
+	D3DXVec3Normalize(&tangent, &tangent);
+	D3DXVec3Cross(&bitangent, &normal, &tangent);
+
+	float radius = sqrt(u1);
+	float angle = C_TWO_PI * u2;
+	return tangent * (radius * cos(angle)) + bitangent * (radius * sin(angle)) + normal * sqrt(1.0f - u1);
+}
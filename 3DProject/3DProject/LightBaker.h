@@ -0,0 +1,92 @@
+#ifndef LIGHT_BAKER_H
+#define LIGHT_BAKER_H
+
+#include <vector>
+#include <D3DX10.h>
+
+#include "TriangleBVH.h"
+#include "JobSystem.h"
+
+// Rectangle on a flat static receiver that a lightmap covers. Texel (0, 0) starts at the origin, u runs
+// along AxisU and v along AxisV, both given at their full length.
+struct LightmapRect
+{
+	D3DXVECTOR3			Origin;
+	D3DXVECTOR3			AxisU;
+	D3DXVECTOR3			AxisV;
+	D3DXVECTOR3			Normal;
+	int					Width;
+	int					Height;
+};
+
+struct BakeStatistics
+{
+	int					Passes;
+	__int64				Rays;
+	double				Milliseconds;
+};
+
+// Ray traced lighting for static geometry, baked on the CPU with the job system.
+//
+// A lightmap holds the direct light from the scene's point light, shadowed by the static occluders,
+// and the ambient occlusion from them. It is refined one pass at a time, where a pass traces a few
+// rays for every texel from a new jittered point, so it can be shown while it converges. The texels
+// are split into square tiles and each job takes one tile.
+//
+// Vertex occlusion is baked in one go into the vertices of a mesh against its own tree, in object
+// space, so it stays valid however the mesh is moved.
+class LightBaker
+{
+public:
+	LightBaker();
+
+	void AddOccluder(const TriangleBVH* bvh, const D3DXMATRIX& world);
+	void ClearOccluders();
+	void SetLight(const D3DXVECTOR3& position);
+
+	void BeginLightmap(const LightmapRect& rect, float occlusionDistance, int numPasses);
+	void RefineLightmap(JobSystem* jobSystem);
+	void BakeLightmap(const LightmapRect& rect, float occlusionDistance, int numPasses, JobSystem* jobSystem);
+	bool IsLightmapDone() const;
+	void GetLightmapTexels(unsigned char* texels) const;
+	const LightmapRect& GetLightmapRect() const;
+	const BakeStatistics& GetLightmapStatistics() const;
+
+	void BakeVertexOcclusion(const TriangleBVH& bvh, const D3DXVECTOR3* positions, const D3DXVECTOR3* normals,
+							 int count, float occlusionDistance, JobSystem* jobSystem, float* occlusion);
+	const BakeStatistics& GetVertexStatistics() const;
+
+private:
+	struct Occluder
+	{
+		const TriangleBVH*	BVH;
+		D3DXMATRIX			WorldInverse;
+	};
+
+	std::vector<Occluder>	mOccluders;
+	D3DXVECTOR3				mLightPosition;
+
+	LightmapRect			mRect;
+	float					mLightmapDistance;
+	int						mNumPasses;
+	std::vector<float>		mDirectSums;
+	std::vector<float>		mOcclusionSums;
+	BakeStatistics			mLightmapStatistics;
+	volatile long			mPassRays;
+
+	const TriangleBVH*		mVertexBVH;
+	const D3DXVECTOR3*		mVertexPositions;
+	const D3DXVECTOR3*		mVertexNormals;
+	float*					mVertexOcclusion;
+	float					mVertexDistance;
+	BakeStatistics			mVertexStatistics;
+
+	static void LightmapTilesJob(void* data, int first, int count);
+	static void VertexOcclusionJob(void* data, int first, int count);
+
+	int GetTileCount() const;
+	void BakeTile(int tile);
+	bool IsOccluded(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance) const;
+	static D3DXVECTOR3 SampleHemisphere(const D3DXVECTOR3& normal, float u1, float u2);
+};
+#endif
@@ -0,0 +1,473 @@
+#include "MovingObjectStore.h"
+#include <cmath>
+#include <cstring>
+
+#ifdef MOVING_OBJECT_STORE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const int C_ALIGNMENT = 16;
+	const int C_MIN_CAPACITY = 64;
+
+	// Allocate a new aligned array and copy the old contents to it
+	template<typename T>
+	T* GrowArray(T* oldArray, int count, int capacity)
+	{
+		T* newArray = static_cast<T*>(_aligned_malloc(sizeof(T) * capacity, C_ALIGNMENT));
+		if(oldArray != NULL)
+		{
+			memcpy(newArray, oldArray, sizeof(T) * count);
+			_aligned_free(oldArray);
+		}
+
+		return newArray;
+	}
+
+	template<typename T>
+	void FreeArray(T*& array)
+	{
+		if(array != NULL)
+			_aligned_free(array);
+		array = NULL;
+	}
+}
+
+MovingObjectStore::MovingObjectStore()
+	: mPosX(NULL), mPosY(NULL), mPosZ(NULL), mVelX(NULL), mVelY(NULL), mVelZ(NULL), mCos(NULL), mSin(NULL),
+	  mRadius(NULL), mWorld(NULL), mPrevPosX(NULL), mPrevPosY(NULL), mPrevPosZ(NULL), mPrevCos(NULL),
+	  mPrevSin(NULL), mCount(0), mCapacity(0), mBoundsMin(-256.0f, 0.0f, -256.0f), mBoundsMax(256.0f, 30.0f, 256.0f)
+{
+#ifdef MOVING_OBJECT_STORE_SSE
+	mSIMD = true;
+#else
+	mSIMD = false;
+#endif
+}
+
+MovingObjectStore::~MovingObjectStore()
+{
+	FreeArray(mPosX);
+	FreeArray(mPosY);
+	FreeArray(mPosZ);
+	FreeArray(mVelX);
+	FreeArray(mVelY);
+	FreeArray(mVelZ);
+	FreeArray(mCos);
+	FreeArray(mSin);
+	FreeArray(mRadius);
+	FreeArray(mWorld);
+	FreeArray(mPrevPosX);
+	FreeArray(mPrevPosY);
+	FreeArray(mPrevPosZ);
+	FreeArray(mPrevCos);
+	FreeArray(mPrevSin);
+}
+
+// Add a moving object and return its index in the store
+int MovingObjectStore::Add(const D3DXVECTOR3& position, const D3DXVECTOR3& velocity, float rotation, float radius)
+{
+	if(mCount == mCapacity)
+		Reserve(mCapacity < C_MIN_CAPACITY ? C_MIN_CAPACITY : mCapacity * 2);
+
+	int index = mCount++;
+	mPosX[index] = position.x;
+	mPosY[index] = position.y;
+	mPosZ[index] = position.z;
+	mVelX[index] = velocity.x;
+	mVelY[index] = velocity.y;
+	mVelZ[index] = velocity.z;
+	mCos[index] = std::cos(rotation);
+	mSin[index] = std::sin(rotation);
+	mRadius[index] = radius;
+	mPrevPosX[index] = position.x;
+	mPrevPosY[index] = position.y;
+	mPrevPosZ[index] = position.z;
+	mPrevCos[index] = mCos[index];
+	mPrevSin[index] = mSin[index];
+
+	D3DXMatrixIdentity(&mWorld[index]);
+	mWorld[index].m[0][0] = mCos[index];
+	mWorld[index].m[0][2] = -mSin[index];
+	mWorld[index].m[2][0] = mSin[index];
+	mWorld[index].m[2][2] = mCos[index];
+	mWorld[index].m[3][0] = position.x;
+	mWorld[index].m[3][1] = position.y;
+	mWorld[index].m[3][2] = position.z;
+
+	return index;
+}
+
+// Remove all objects, the memory is kept for reuse
+void MovingObjectStore::Clear()
+{
+	mCount = 0;
+}
+
+// Remove all objects from the given count and up, indices below count stay valid
+void MovingObjectStore::Resize(int count)
+{
+	if(count < mCount)
+		mCount = count;
+}
+
+// Set the box the objects bounce inside
+void MovingObjectStore::SetBounds(const D3DXVECTOR3& boundsMin, const D3DXVECTOR3& boundsMax)
+{
+	mBoundsMin = boundsMin;
+	mBoundsMax = boundsMax;
+}
+
+// Update all objects
+void MovingObjectStore::Update(float dt)
+{
+	Update(dt, 0, mCount);
+}
+
+// Move the objects in the range, bounce them against the bounds and rebuild their world matrices
+void MovingObjectStore::Update(float dt, int first, int count)
+{
+	int end = first + count;
+	if(end > mCount)
+		end = mCount;
+	if(first >= end)
+		return;
+
+#ifdef MOVING_OBJECT_STORE_SSE
+	if(mSIMD)
+	{
+		UpdateSSE(dt, first, end);
+		return;
+	}
+#endif
+
+	UpdateScalar(dt, first, end);
+}
+
+void MovingObjectStore::SetSIMD(bool useSIMD)
+{
+#ifdef MOVING_OBJECT_STORE_SSE
+	mSIMD = useSIMD;
+#endif
+}
+
+const bool& MovingObjectStore::GetSIMD() const
+{
+	return mSIMD;
+}
+
+int MovingObjectStore::GetCount() const
+{
+	return mCount;
+}
+
+D3DXVECTOR3 MovingObjectStore::GetPosition(int index) const
+{
+	return D3DXVECTOR3(mPosX[index], mPosY[index], mPosZ[index]);
+}
+
+const float* MovingObjectStore::GetPositionsX() const
+{
+	return mPosX;
+}
+
+const float* MovingObjectStore::GetPositionsY() const
+{
+	return mPosY;
+}
+
+const float* MovingObjectStore::GetPositionsZ() const
+{
+	return mPosZ;
+}
+
+// The velocities can be changed between updates, for example by a physics solver
+float* MovingObjectStore::GetVelocitiesX()
+{
+	return mVelX;
+}
+
+float* MovingObjectStore::GetVelocitiesY()
+{
+	return mVelY;
+}
+
+float* MovingObjectStore::GetVelocitiesZ()
+{
+	return mVelZ;
+}
+
+float MovingObjectStore::GetRadius(int index) const
+{
+	return mRadius[index];
+}
+
+const float* MovingObjectStore::GetRadii() const
+{
+	return mRadius;
+}
+
+const D3DXMATRIX& MovingObjectStore::GetWorldMatrix(int index) const
+{
+	return mWorld[index];
+}
+
+const D3DXMATRIX* MovingObjectStore::GetWorldMatrices() const
+{
+	return mWorld;
+}
+
+// The position a fraction alpha of the way from before the last update to after it
+D3DXVECTOR3 MovingObjectStore::GetInterpolatedPosition(int index, float alpha) const
+{
+	return D3DXVECTOR3(mPrevPosX[index] + (mPosX[index] - mPrevPosX[index]) * alpha,
+					   mPrevPosY[index] + (mPosY[index] - mPrevPosY[index]) * alpha,
+					   mPrevPosZ[index] + (mPosZ[index] - mPrevPosZ[index]) * alpha);
+}
+
+// The world matrix a fraction alpha of the way through the last update. The rotation is blended as
+// (cos, sin) and normalized again, which is close enough to the angle for the small turn of one update.
+D3DXMATRIX MovingObjectStore::GetInterpolatedWorldMatrix(int index, float alpha) const
+{
+	float cosA = mPrevCos[index] + (mCos[index] - mPrevCos[index]) * alpha;
+	float sinA = mPrevSin[index] + (mSin[index] - mPrevSin[index]) * alpha;
+	float length = std::sqrt(cosA * cosA + sinA * sinA);
+	if(length > 0.0f)
+	{
+		cosA /= length;
+		sinA /= length;
+	}
+
+	D3DXVECTOR3 position = GetInterpolatedPosition(index, alpha);
+
+	D3DXMATRIX world;
+	world.m[0][0] = cosA;		world.m[0][1] = 0.0f;		world.m[0][2] = -sinA;		world.m[0][3] = 0.0f;
+	world.m[1][0] = 0.0f;		world.m[1][1] = 1.0f;		world.m[1][2] = 0.0f;		world.m[1][3] = 0.0f;
+	world.m[2][0] = sinA;		world.m[2][1] = 0.0f;		world.m[2][2] = cosA;		world.m[2][3] = 0.0f;
+	world.m[3][0] = position.x;	world.m[3][1] = position.y;	world.m[3][2] = position.z;	world.m[3][3] = 1.0f;
+
+	return world;
+}
+
+// Hash of the exact bits of every position, velocity and rotation. Two runs that took the same steps
+// with the same input must give the same value.
+unsigned int MovingObjectStore::GetChecksum() const
+{
+	const float* arrays[] = { mPosX, mPosY, mPosZ, mVelX, mVelY, mVelZ, mCos, mSin };
+	const int numArrays = sizeof(arrays) / sizeof(arrays[0]);
+
+	unsigned int hash = 2166136261u;
+	for(int a = 0; a < numArrays; ++a)
+	{
+		for(int i = 0; i < mCount; ++i)
+		{
+			unsigned int bits;
+			memcpy(&bits, &arrays[a][i], sizeof(bits));
+			hash = (hash ^ bits) * 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+// Grow all arrays to hold the given number of objects
+void MovingObjectStore::Reserve(int capacity)
+{
+	if(capacity <= mCapacity)
+		return;
+
+	// Round up to whole SIMD blocks so the kernel never has to check the array end
+	capacity = (capacity + 3) & ~3;
+
+	mPosX = GrowArray(mPosX, mCount, capacity);
+	mPosY = GrowArray(mPosY, mCount, capacity);
+	mPosZ = GrowArray(mPosZ, mCount, capacity);
+	mVelX = GrowArray(mVelX, mCount, capacity);
+	mVelY = GrowArray(mVelY, mCount, capacity);
+	mVelZ = GrowArray(mVelZ, mCount, capacity);
+	mCos = GrowArray(mCos, mCount, capacity);
+	mSin = GrowArray(mSin, mCount, capacity);
+	mRadius = GrowArray(mRadius, mCount, capacity);
+	mWorld = GrowArray(mWorld, mCount, capacity);
+	mPrevPosX = GrowArray(mPrevPosX, mCount, capacity);
+	mPrevPosY = GrowArray(mPrevPosY, mCount, capacity);
+	mPrevPosZ = GrowArray(mPrevPosZ, mCount, capacity);
+	mPrevCos = GrowArray(mPrevCos, mCount, capacity);
+	mPrevSin = GrowArray(mPrevSin, mCount, capacity);
+
+	mCapacity = capacity;
+}
+
+// Reference implementation of the update, one object at a time
+void MovingObjectStore::UpdateScalar(float dt, int first, int end)
+{
+	float cosDt = std::cos(dt);
+	float sinDt = std::sin(dt);
+
+	for(int i = first; i < end; ++i)
+	{
+		mPrevPosX[i] = mPosX[i];
+		mPrevPosY[i] = mPosY[i];
+		mPrevPosZ[i] = mPosZ[i];
+		mPrevCos[i] = mCos[i];
+		mPrevSin[i] = mSin[i];
+
+		mPosX[i] += mVelX[i] * dt;
+		mPosY[i] += mVelY[i] * dt;
+		mPosZ[i] += mVelZ[i] * dt;
+
+		if(mPosX[i] < mBoundsMin.x)
+			mVelX[i] = std::abs(mVelX[i]);
+		else if(mPosX[i] > mBoundsMax.x)
+			mVelX[i] = -std::abs(mVelX[i]);
+		if(mPosY[i] < mBoundsMin.y)
+			mVelY[i] = std::abs(mVelY[i]);
+		else if(mPosY[i] > mBoundsMax.y)
+			mVelY[i] = -std::abs(mVelY[i]);
+		if(mPosZ[i] < mBoundsMin.z)
+			mVelZ[i] = std::abs(mVelZ[i]);
+		else if(mPosZ[i] > mBoundsMax.z)
+			mVelZ[i] = -std::abs(mVelZ[i]);
+
+		// Rotate (cos, sin) by dt and pull it back towards unit length to stop rounding errors from growing
+		float cosA = mCos[i] * cosDt - mSin[i] * sinDt;
+		float sinA = mSin[i] * cosDt + mCos[i] * sinDt;
+		float scale = 1.5f - 0.5f * (cosA * cosA + sinA * sinA);
+		cosA *= scale;
+		sinA *= scale;
+		mCos[i] = cosA;
+		mSin[i] = sinA;
+
+		D3DXMATRIX& world = mWorld[i];
+		world.m[0][0] = cosA;	world.m[0][1] = 0.0f;	world.m[0][2] = -sinA;	world.m[0][3] = 0.0f;
+		world.m[1][0] = 0.0f;	world.m[1][1] = 1.0f;	world.m[1][2] = 0.0f;	world.m[1][3] = 0.0f;
+		world.m[2][0] = sinA;	world.m[2][1] = 0.0f;	world.m[2][2] = cosA;	world.m[2][3] = 0.0f;
+		world.m[3][0] = mPosX[i];
+		world.m[3][1] = mPosY[i];
+		world.m[3][2] = mPosZ[i];
+		world.m[3][3] = 1.0f;
+	}
+}
+
+#ifdef MOVING_OBJECT_STORE_SSE
+// Same update as UpdateScalar, four objects per iteration. The bounce tests are done with masks
+// instead of branches and the world matrices are written with a 4x4 transpose.
+void MovingObjectStore::UpdateSSE(float dt, int first, int end)
+{
+	// Unaligned start of the range is done with the scalar path
+	int blockStart = (first + 3) & ~3;
+	if(blockStart > end)
+		blockStart = end;
+	if(first < blockStart)
+		UpdateScalar(dt, first, blockStart);
+
+	int blockEnd = blockStart + ((end - blockStart) & ~3);
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 onePointFive = _mm_set1_ps(1.5f);
+	const __m128 row1 = _mm_set_ps(0.0f, 0.0f, 1.0f, 0.0f);
+	const __m128 dtVec = _mm_set1_ps(dt);
+	const __m128 cosDt = _mm_set1_ps(std::cos(dt));
+	const __m128 sinDt = _mm_set1_ps(std::sin(dt));
+	const __m128 minX = _mm_set1_ps(mBoundsMin.x);
+	const __m128 minY = _mm_set1_ps(mBoundsMin.y);
+	const __m128 minZ = _mm_set1_ps(mBoundsMin.z);
+	const __m128 maxX = _mm_set1_ps(mBoundsMax.x);
+	const __m128 maxY = _mm_set1_ps(mBoundsMax.y);
+	const __m128 maxZ = _mm_set1_ps(mBoundsMax.z);
+
+	for(int i = blockStart; i < blockEnd; i += 4)
+	{
+		__m128 px = _mm_load_ps(mPosX + i);
+		__m128 py = _mm_load_ps(mPosY + i);
+		__m128 pz = _mm_load_ps(mPosZ + i);
+		_mm_store_ps(mPrevPosX + i, px);
+		_mm_store_ps(mPrevPosY + i, py);
+		_mm_store_ps(mPrevPosZ + i, pz);
+		_mm_store_ps(mPrevCos + i, _mm_load_ps(mCos + i));
+		_mm_store_ps(mPrevSin + i, _mm_load_ps(mSin + i));
+
+		px = _mm_add_ps(px, _mm_mul_ps(_mm_load_ps(mVelX + i), dtVec));
+		py = _mm_add_ps(py, _mm_mul_ps(_mm_load_ps(mVelY + i), dtVec));
+		pz = _mm_add_ps(pz, _mm_mul_ps(_mm_load_ps(mVelZ + i), dtVec));
+
+		// Below the minimum: velocity = |v|, above the maximum: velocity = -|v|, else unchanged
+		__m128 vx = _mm_load_ps(mVelX + i);
+		__m128 vy = _mm_load_ps(mVelY + i);
+		__m128 vz = _mm_load_ps(mVelZ + i);
+		__m128 absX = _mm_andnot_ps(signMask, vx);
+		__m128 absY = _mm_andnot_ps(signMask, vy);
+		__m128 absZ = _mm_andnot_ps(signMask, vz);
+		__m128 belowX = _mm_cmplt_ps(px, minX);
+		__m128 belowY = _mm_cmplt_ps(py, minY);
+		__m128 belowZ = _mm_cmplt_ps(pz, minZ);
+		__m128 aboveX = _mm_andnot_ps(belowX, _mm_cmpgt_ps(px, maxX));
+		__m128 aboveY = _mm_andnot_ps(belowY, _mm_cmpgt_ps(py, maxY));
+		__m128 aboveZ = _mm_andnot_ps(belowZ, _mm_cmpgt_ps(pz, maxZ));
+		__m128 bounceX = _mm_or_ps(belowX, aboveX);
+		__m128 bounceY = _mm_or_ps(belowY, aboveY);
+		__m128 bounceZ = _mm_or_ps(belowZ, aboveZ);
+		vx = _mm_or_ps(_mm_andnot_ps(bounceX, vx), _mm_and_ps(bounceX, _mm_or_ps(absX, _mm_and_ps(aboveX, signMask))));
+		vy = _mm_or_ps(_mm_andnot_ps(bounceY, vy), _mm_and_ps(bounceY, _mm_or_ps(absY, _mm_and_ps(aboveY, signMask))));
+		vz = _mm_or_ps(_mm_andnot_ps(bounceZ, vz), _mm_and_ps(bounceZ, _mm_or_ps(absZ, _mm_and_ps(aboveZ, signMask))));
+
+		_mm_store_ps(mPosX + i, px);
+		_mm_store_ps(mPosY + i, py);
+		_mm_store_ps(mPosZ + i, pz);
+		_mm_store_ps(mVelX + i, vx);
+		_mm_store_ps(mVelY + i, vy);
+		_mm_store_ps(mVelZ + i, vz);
+
+		// Rotate (cos, sin) by dt and pull it back towards unit length
+		__m128 c = _mm_load_ps(mCos + i);
+		__m128 s = _mm_load_ps(mSin + i);
+		__m128 cosA = _mm_sub_ps(_mm_mul_ps(c, cosDt), _mm_mul_ps(s, sinDt));
+		__m128 sinA = _mm_add_ps(_mm_mul_ps(s, cosDt), _mm_mul_ps(c, sinDt));
+		__m128 lengthSq = _mm_add_ps(_mm_mul_ps(cosA, cosA), _mm_mul_ps(sinA, sinA));
+		__m128 scale = _mm_sub_ps(onePointFive, _mm_mul_ps(half, lengthSq));
+		cosA = _mm_mul_ps(cosA, scale);
+		sinA = _mm_mul_ps(sinA, scale);
+		_mm_store_ps(mCos + i, cosA);
+		_mm_store_ps(mSin + i, sinA);
+
+		// Row 0 is (cos, 0, -sin, 0) and row 2 is (sin, 0, cos, 0) for every object
+		__m128 negSinA = _mm_xor_ps(sinA, signMask);
+		__m128 row0Lo = _mm_unpacklo_ps(cosA, negSinA);
+		__m128 row0Hi = _mm_unpackhi_ps(cosA, negSinA);
+		__m128 row2Lo = _mm_unpacklo_ps(sinA, cosA);
+		__m128 row2Hi = _mm_unpackhi_ps(sinA, cosA);
+
+		// Row 3 is the position, transposed from the x, y and z arrays
+		__m128 row3A = px;
+		__m128 row3B = py;
+		__m128 row3C = pz;
+		__m128 row3D = one;
+		_MM_TRANSPOSE4_PS(row3A, row3B, row3C, row3D);
+
+		float* world = (float*)&mWorld[i];
+		_mm_store_ps(world + 0, _mm_unpacklo_ps(row0Lo, zero));
+		_mm_store_ps(world + 4, row1);
+		_mm_store_ps(world + 8, _mm_unpacklo_ps(row2Lo, zero));
+		_mm_store_ps(world + 12, row3A);
+		_mm_store_ps(world + 16, _mm_unpackhi_ps(row0Lo, zero));
+		_mm_store_ps(world + 20, row1);
+		_mm_store_ps(world + 24, _mm_unpackhi_ps(row2Lo, zero));
+		_mm_store_ps(world + 28, row3B);
+		_mm_store_ps(world + 32, _mm_unpacklo_ps(row0Hi, zero));
+		_mm_store_ps(world + 36, row1);
+		_mm_store_ps(world + 40, _mm_unpacklo_ps(row2Hi, zero));
+		_mm_store_ps(world + 44, row3C);
+		_mm_store_ps(world + 48, _mm_unpackhi_ps(row0Hi, zero));
+		_mm_store_ps(world + 52, row1);
+		_mm_store_ps(world + 56, _mm_unpackhi_ps(row2Hi, zero));
+		_mm_store_ps(world + 60, row3D);
+	}
+
+	if(blockEnd < end)
+		UpdateScalar(dt, blockEnd, end);
+}
+#endif
@@ -0,0 +1,83 @@
+#ifndef MOVING_OBJECT_STORE_H
+#define MOVING_OBJECT_STORE_H
+
+#include <D3DX10.h>
+#include "Globals.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define MOVING_OBJECT_STORE_SSE
+#endif
+
+// Structure-of-arrays storage for all moving objects in a scene. Every attribute is kept in its own
+// 16 byte aligned array so that the update can integrate, bounce and build world matrices for four
+// objects at a time. The rotation about the y-axis is stored as its cosine and sine, which are advanced
+// each update by rotating with the angle moved during the frame.
+//
+// The position and rotation from before the last update are kept as well, so that the objects can be
+// drawn between the last two updates when the simulation runs at a fixed rate that is not the frame rate.
+class MovingObjectStore
+{
+public:
+	MovingObjectStore();
+	~MovingObjectStore();
+
+	int Add(const D3DXVECTOR3& position, const D3DXVECTOR3& velocity, float rotation, float radius);
+	void Clear();
+	void Resize(int count);
+	void SetBounds(const D3DXVECTOR3& boundsMin, const D3DXVECTOR3& boundsMax);
+
+	void Update(float dt);
+	void Update(float dt, int first, int count);
+	void SetSIMD(bool useSIMD);
+
+	const bool& GetSIMD() const;
+	int GetCount() const;
+	D3DXVECTOR3 GetPosition(int index) const;
+	const float* GetPositionsX() const;
+	const float* GetPositionsY() const;
+	const float* GetPositionsZ() const;
+	float* GetVelocitiesX();
+	float* GetVelocitiesY();
+	float* GetVelocitiesZ();
+	float GetRadius(int index) const;
+	const float* GetRadii() const;
+	const D3DXMATRIX& GetWorldMatrix(int index) const;
+	const D3DXMATRIX* GetWorldMatrices() const;
+	D3DXVECTOR3 GetInterpolatedPosition(int index, float alpha) const;
+	D3DXMATRIX GetInterpolatedWorldMatrix(int index, float alpha) const;
+	unsigned int GetChecksum() const;
+
+private:
+	float*					mPosX;
+	float*					mPosY;
+	float*					mPosZ;
+	float*					mVelX;
+	float*					mVelY;
+	float*					mVelZ;
+	float*					mCos;
+	float*					mSin;
+	float*					mRadius;				// Bounding sphere radius, used for culling and collisions
+	D3DXMATRIX*				mWorld;
+	float*					mPrevPosX;				// State before the last update, for interpolation
+	float*					mPrevPosY;
+	float*					mPrevPosZ;
+	float*					mPrevCos;
+	float*					mPrevSin;
+
+	int						mCount;
+	int						mCapacity;
+	bool					mSIMD;
+
+	D3DXVECTOR3				mBoundsMin;
+	D3DXVECTOR3				mBoundsMax;
+
+	MovingObjectStore(const MovingObjectStore&);
+	MovingObjectStore& operator=(const MovingObjectStore&);
+
+	void Reserve(int capacity);
+	void UpdateScalar(float dt, int first, int end);
+#ifdef MOVING_OBJECT_STORE_SSE
+	void UpdateSSE(float dt, int first, int end);
+#endif
+};
+#endif
@@ -1,552 +1,1073 @@
-#include "Object3D.h"
-#include <sstream>
-#include <cassert>
-
-Object3D::MaterialInfo::MaterialInfo()
-	: Ambient(D3DXVECTOR3(0.2, 0.2, 0.2))
-	, Diffuse(D3DXVECTOR3(0.8, 0.8, 0.8))
-	, Specular(D3DXVECTOR3(1.0, 1.0, 1.0))
-	, Tf(D3DXVECTOR3(1.0, 1.0, 1.0))
-	, IlluminationModel(0)
-	//, Opacitiy(1.0)
-	, RefractionIndex(1.0)
-	, SpecularExp(8.0f)
-	//, Sharpness(60.0)
-	, MainTexture(NULL)
-{}
-
-Object3D::Group::Group()
-	: mVertexBuffer(NULL), mFXKa(NULL), mFXKd(NULL), mFXKs(NULL), mFXSpecExp(NULL), mFXTexture(NULL)
-{}
-
-Object3D::Group::~Group() throw()
-{
-	SafeDelete(mVertexBuffer);
-}
-
-void Object3D::Group::AddVertices(std::vector<Vertex> vertexList)
-{
-	for(int i = 0; i < vertexList.size(); ++i)
-		mVertices.push_back(vertexList[i]);
-}
-
-bool Object3D::Group::Finalize(ID3D10Device* device, ID3D10Effect* effect)
-{
-	mFXTexture = effect->GetVariableByName("gTextureBTH")->AsShaderResource();
-	mFXKa = effect->GetVariableByName("gKa")->AsVector();
-	mFXKd = effect->GetVariableByName("gKd")->AsVector();
-	mFXKs = effect->GetVariableByName("gKs")->AsVector();
-	mFXSpecExp = effect->GetVariableByName("gSExp")->AsScalar();
-
-	if(mVertices.size() <= 0)
-		return false;
-
-	mVertexBuffer = new Buffer();
-	
-	BufferInformation vbDesc;
-	vbDesc.type					= VertexBuffer;
-	vbDesc.usage				= Buffer_Default;
-	vbDesc.elementSize			= sizeof(Vertex);
-	vbDesc.numberOfElements		= mVertices.size();
-	vbDesc.firstElementPointer	= &mVertices[0];
-
-	return mVertexBuffer->Initialize(device, vbDesc) == S_OK;
-}
-
-void Object3D::Group::Draw(ID3D10Device* device)
-{
-	if(mVertexBuffer == NULL)
-		return;
-
-	mFXTexture->SetResource(Material->MainTexture);
-	mFXKa->SetFloatVector((float*)&Material->Ambient);
-	mFXKd->SetFloatVector((float*)&Material->Diffuse);
-	mFXKs->SetFloatVector((float*)&Material->Specular);
-	mFXSpecExp->SetFloat(Material->SpecularExp);
-	//effect->GetVariableByName("Tf")->AsVector()->SetFloatVector(Material->Tf);
-	//effect->GetVariableByName("illum")->AsScalar()->SetInt(Material->IlluminationModel);
-	//effect->GetVariableByName("refrac")->AsScalar()->SetFloat(Material->RefractionIndex);
-
-	mVertexBuffer->MakeActive();
-
-	device->Draw(mVertexBuffer->GetSize(), 0);
-}
-
-Object3D::Object3D(ID3D10Device* device, std::string filename, D3DXVECTOR3 position, D3DXVECTOR3 lightPos)
-	: mDevice(device), mEffect(NULL), mEffectShadows(NULL), mTechnique(NULL), mTechniqueShadows(NULL),
-	  mVertexLayout(NULL), mFont(NULL), mPosition(position), mRotation(0.0f), mLightPosition(lightPos),
-	  mVelocity(D3DXVECTOR3(1.2, 0.5, 0.8)), mFXEyePos(NULL), mFXLightPos(NULL), mFXWorld(NULL), 
-	  mFXWorldViewProj(NULL), mFXShadowWVP(NULL)
-{
-	if(!Load(filename))
-		return;
-
-	mEffect = CreateEffect("Effect.fx");
-	mEffectShadows = CreateEffect("EffectShadows.fx");
-	CreateVertexLayout();
-
-	mMatrixWorld = new D3DXMATRIX();
-	D3DXMatrixIdentity(mMatrixWorld);
-
-	D3DXVec3Normalize(&mVelocity, &mVelocity);
-	mVelocity *= 30;
-
-	UpdateWorldMatrix();
-
-	mFXEyePos = mEffect->GetVariableByName("gEyePos")->AsVector();
-	mFXLightPos = mEffect->GetVariableByName("gLightPosition")->AsVector();
-	mFXWorld = mEffect->GetVariableByName("gWorld")->AsMatrix();
-	mFXWorldViewProj = mEffect->GetVariableByName("gWVP")->AsMatrix();
-	mFXShadowWVP = mEffectShadows->GetVariableByName("gWVP")->AsMatrix();
-	
-	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
-		it->second.Finalize(mDevice, mEffect);
-
-	mFont = new GameFont(mDevice, "Times New Roman", 18);
-}
-
-Object3D::~Object3D()
-{
-	SafeRelease(mEffect);
-	SafeRelease(mEffectShadows);
-	SafeRelease(mVertexLayout);
-
-	SafeDelete(mFont);
-	SafeDelete(mMatrixWorld);
-}
-
-bool Object3D::Load(std::string filename)
-{
-	std::ifstream file;
-	std::vector<Vertex> vertices;
-	std::vector<D3DXVECTOR3> outPositions;
-	std::vector<D3DXVECTOR2> outUVCoords;
-	std::vector<D3DXVECTOR3> outNormals;
-
-	Group currGroup;
-	std::string currGroupName = "";
-
-	file.open(filename.c_str(), std::ios_base::binary);
-	
-	if(!file.is_open())
-		return false;
-
-	while(!file.eof())
-	{
-		// Read first line of file.
-		std::string line;
-		std::getline(file, line);
-
-		// Copy line to a stringstream and copy first word into string key
-		std::stringstream streamLine;
-		streamLine.str(line);
-		std::string key;
-		streamLine >> key;
-
-		if(key == "mtllib")
-		{
-			std::string matFileName;
-			streamLine >> matFileName;
-			LoadMaterials(matFileName);
-		}
-		else if(key == "v")
-		{
-			D3DXVECTOR3 currPos;
-			streamLine >> currPos.x;
-			streamLine >> currPos.y;
-			streamLine >> currPos.z;
-			outPositions.push_back(currPos);
-		}
-		else if(key == "vt")
-		{
-			D3DXVECTOR2 currUV;
-			streamLine >> currUV.x;
-			streamLine >> currUV.y;
-			currUV.y = 1 - currUV.y;
-			outUVCoords.push_back(currUV);
-		}
-		else if(key == "vn")
-		{
-			D3DXVECTOR3 currNormal;
-			streamLine >> currNormal.x;
-			streamLine >> currNormal.y;
-			streamLine >> currNormal.z;
-			outNormals.push_back(currNormal);
-		}
-		else if(key == "g")
-		{
-			std::string groupName;
-			streamLine >> groupName;
-
-			std::streampos pos = file.tellg();
-			std::getline(file, line);
-			streamLine.str(line);
-			streamLine >> key;
-
-			if(key == "usemtl")
-			{
-				streamLine >> key;
-				if(currGroupName != "") // It is not the first group
-				{
-					mGroups[currGroupName].Material = currGroup.Material;
-					mGroups[currGroupName].AddVertices(vertices);
-					vertices.clear();
-					currGroup = Group();
-				}
-
-				assert(mMaterials.find(key) != mMaterials.end()); // Make sure the material exists
-				currGroup.Material = &mMaterials[key];
-				currGroupName = groupName;
-			}
-			else
-				file.seekg(pos);
-		}
-		else if(key == "f")
-		{
-			int pos[3]; 
-			int uv[3];
-			int norm[3];
-
-			for(int i = 0; i < 3; ++i)
-			{
-				streamLine >> pos[i];
-				streamLine.ignore();
-				streamLine >> uv[i];
-				streamLine.ignore();
-				streamLine >> norm[i];
-
-				Vertex currVertex;
-				currVertex.Position = outPositions[pos[i] - 1];
-				currVertex.UV = outUVCoords[uv[i] - 1];
-				currVertex.Normal = outNormals[norm[i] - 1];
-				vertices.push_back(currVertex);
-			}
-		}
-	}
-
-	mGroups[currGroupName].Material = currGroup.Material;
-	mGroups[currGroupName].AddVertices(vertices);
-
-	return true;
-}
-
-bool Object3D::LoadMaterials(std::string filename)
-{
-	MaterialInfo currMaterial;
-	std::string currMaterialName = "";
-	std::ifstream file;
-	file.open(filename.c_str(), std::ios_base::in);
-	
-	if(!file.is_open())
-		return false;
-
-	while(!file.eof())
-	{
-		// Read first line of file.
-		std::string line;
-		std::getline(file, line);
-
-		// Copy line to a stringstream and copy first word into string key
-		std::stringstream streamLine;
-		std::string key;
-
-		streamLine.str(line);
-		streamLine >> key;
-
-		if(key == "newmtl")
-		{
-			if(currMaterialName != "") // It is not the first material read
-			{
-				// Save previous material, making sure the material does not already exist in Materials
-				assert(mMaterials.find(currMaterialName) == mMaterials.end());
-				mMaterials[currMaterialName] = currMaterial;
-			}
-
-			// Set new material name and clear current material
-			streamLine >> currMaterialName;
-			currMaterial = MaterialInfo();
-		}
-		else if(key == "Ka") // Ambient color
-		{
-			streamLine >> currMaterial.Ambient.x;
-			streamLine >> currMaterial.Ambient.y;
-			streamLine >> currMaterial.Ambient.z;
-		}
-		else if(key == "Kd") // Diffuse color
-		{
-			streamLine >> currMaterial.Diffuse.x;
-			streamLine >> currMaterial.Diffuse.y;
-			streamLine >> currMaterial.Diffuse.z;
-		}
-		else if(key == "Ks") // Specular color
-		{
-			streamLine >> currMaterial.Specular.x;
-			streamLine >> currMaterial.Specular.y;
-			streamLine >> currMaterial.Specular.z;
-		}
-		else if(key == "Tf") // Transmission filter
-		{
-			streamLine >> currMaterial.Tf.x;
-			streamLine >> currMaterial.Tf.y;
-			streamLine >> currMaterial.Tf.z;
-		}
-		else if(key == "illum") // Illumination model
-		{
-			streamLine >> currMaterial.IlluminationModel;
-		}
-		//else if(key == "d" || key == "Tr") // Opacity
-		//{
-		//	streamLine >> currMaterial.Opacitiy;
-		//}
-		else if(key == "Ni") // Optical density
-		{
-			streamLine >> currMaterial.RefractionIndex;
-		}
-		else if(key == "Ns") // Specular exponent
-		{
-			streamLine >> currMaterial.SpecularExp;
-		}
-		//else if(key == "sharpness") // Reflection sharpness
-		//{
-		//	streamLine >> currMaterial.Sharpness;
-		//}
-		else if(key == "map_Ka" || key == "map_Kd" || key == "map_Ks")				// Only use one texture at this point
-		{
-			// Get the next argument on the line
-			std::string textureFilename;
-			streamLine >> textureFilename;
-
-			// Make sure there is a period in the name indicating a file name. The other
-			// arguments are not interesting at this point.
-			while (textureFilename.find('.') == std::string::npos && !streamLine.eof())
-				streamLine >> textureFilename;
-
-			// Only try to load the texture if a filename was read
-			if(textureFilename.find('.') != std::string::npos)
-				D3DX10CreateShaderResourceViewFromFile(mDevice, "bthcolor.dds", NULL, NULL, &currMaterial.MainTexture, NULL);
-		}
-	}
-
-	if(currMaterialName != "") // It is not the first material read
-	{
-		// Save previous material, making sure the material does not already exist in Materials
-		assert(mMaterials.find(currMaterialName) == mMaterials.end());
-		mMaterials[currMaterialName] = currMaterial;
-	}
-	
-	return true;
-}
-
-// Compile and create the shader/effect
-ID3D10Effect* Object3D::CreateEffect(std::string filename)
-{
-	ID3D10Effect* returnEffect = NULL;
-	HRESULT result = S_OK;								// Variable that stores the result of the functions
-	UINT shaderFlags = D3D10_SHADER_ENABLE_STRICTNESS;	// Shader flags
-	ID3D10Blob* errors = NULL;							// Variable to store error messages from functions
-	ID3D10Blob* effect = NULL;							// Variable to store compiled (but not created) effect
-	
-	// Compile shader, if failed - show error message and return
-	result = D3DX10CompileFromFileA(filename.c_str(),	// Path and name of the effect file to compile
-								   0,				// Shader macros: none needed
-								   0,				// Include interface: not needed - no #include in shader
-								   "",				// Shader start function, not used when compiling from file
-								   "fx_4_0",		// String specifying shader model (or shader profile)
-								   shaderFlags,		// Shader compile flags - how to compile the shader	
-								   0,				// Effect compile flags - not used when compiling a shader
-								   0,				// Thread pump interface: not needed - return only when finished
-								   &effect,			// Out: Where to put the compiled effect information (pointer)
-								   &errors,			// Out: Where to put the errors, if there are any (pointer)
-								   NULL);			// Out: Result not needed, result is gotten from the return value
-	
-	if(FAILED(result))								// If failed, show error message and return
-	{
-		if(errors)
-		{
-			MessageBox(0, (char*)errors->GetBufferPointer(), "OBJECT3D ERROR", 0);
-			SafeRelease(errors);
-		}
-
-		return NULL;
-	}
-
-	result = D3DX10CreateEffectFromMemory(
-						effect->GetBufferPointer(),	// Pointer to the effect in memory, gotten from the compiled effect
-						effect->GetBufferSize(),	// The effect's size in memory, gotten from the compiled effect
-						filename.c_str(),			// Name of the effect file
-						NULL,						// Shader macros: none needed
-						NULL,						// Include interface: not needed 
-						"fx_4_0",					// String specifying shader model (or shader profile)
-						NULL,						// Shader constants, HLSL compile options						
-						NULL,						// Effect constants, Effect compile options
-						mDevice,					// Pointer to the direct3D device that will use resources
-						NULL,						// Pointer to effect pool for variable sharing between effects
-						NULL,						// Thread pump interface: not needed - return only when finished
-						&returnEffect,				// Out: where to put the created effect (pointer)
-						&errors,					// Out: Where to put the errors, if there are any (pointer)
-						NULL);						// Out: Result not needed, result is gotten from the return value
-
-	if(FAILED(result))								// If failed, show error message and return
-	{
-		MessageBox(0, "Shader creation failed!", "OBJECT3D ERROR", 0);
-		return NULL;
-	}
-
-	return returnEffect;
-}
-
-// Build vertex layout
-HRESULT Object3D::CreateVertexLayout()
-{
-	// Create an array describing each of the elements of the vertex that are inputs to the vertex shader.
-	D3D10_INPUT_ELEMENT_DESC vertexDesc[] = 
-	{
-		{ "POSITION",					// Semantic name, must be same as the vertex shader input semantic name
-		  0,							// Semantic index, if one semantic name exists for more than one element
-		  DXGI_FORMAT_R32G32B32_FLOAT,	// Format of the element, R32G32B32_FLOAT is a 32-bit 3D float vector
-		  0,							// Input slot, of the 0-15 slots, through wich to send vertex data
-		  0,							// AlignedByteOffset, bytes from start of the vertex to this component
-		  D3D10_INPUT_PER_VERTEX_DATA,	// Input data class for this input slot
-		  0 },							// 0 when slot input data class is D3D10_INPUT_PER_VERTEX_DATA
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, sizeof(float) * 3, D3D10_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0,  sizeof(float) * 6, D3D10_INPUT_PER_VERTEX_DATA, 0 }
-	};
-
-		D3D10_PASS_DESC passDesc;
-		HRESULT result;
-
-		// Get the effect technique from the effect, and save the descritption of the first pass
-		mTechnique = mEffect->GetTechniqueByName("DrawTechnique");
-		mTechnique->GetPassByIndex(0)->GetDesc(&passDesc);
-
-		// Create the input layout and save it, if failed - show an error message
-		result = mDevice->CreateInputLayout(
-					vertexDesc,						// Description of input structure - array of element descriptions
-					3,								// Number of elements in the input structure description
-					passDesc.pIAInputSignature,		// Get pointer to the compiled shader
-					passDesc.IAInputSignatureSize,	// The size of the compiled shader
-					&mVertexLayout);				// Out: where to put the created input layout 
-
-		if(FAILED(result))							// If layer creation fails, show an error message and return
-		{
-			MessageBox(0, "Input Layout creation failed!", "OBJECT3D ERROR", 0);
-			return result;
-		}
-
-		// Bind the input layout to the 3D device
-		mDevice->IASetInputLayout(mVertexLayout);
-
-		// --- Repeat for the shadow technique
-		// Get the effect technique from the effect, and save the descritption of the first pass
-		mTechniqueShadows = mEffectShadows->GetTechniqueByName("DrawTechnique");
-		mTechniqueShadows->GetPassByIndex(0)->GetDesc(&passDesc);
-
-		// Create the input layout and save it, if failed - show an error message
-		result = mDevice->CreateInputLayout(
-					vertexDesc,						// Description of input structure - array of element descriptions
-					3,								// Number of elements in the input structure description
-					passDesc.pIAInputSignature,		// Get pointer to the compiled shader
-					passDesc.IAInputSignatureSize,	// The size of the compiled shader
-					&mVertexLayout);				// Out: where to put the created input layout 
-
-		if(FAILED(result))							// If layer creation fails, show an error message and return
-		{
-			MessageBox(0, "Input Layout creation failed!", "OBJECT3D ERROR", 0);
-			return result;
-		}
-
-		return result;
-}
-
-void Object3D::Update(GameTime gameTime)
-{
-	mRotation += gameTime.GetTimeSinceLastTick().Seconds;
-	mPosition += mVelocity * gameTime.GetTimeSinceLastTick().Seconds;
-
-	/*if(mPosition.x < -256 || mPosition.x > 256)
-		mVelocity.x = -mVelocity.x;
-	if(mPosition.y < 0 || mPosition.y > 50)
-		mVelocity.y = -mVelocity.y;
-	if(mPosition.z < -256 || mPosition.z > 256)
-		mVelocity.z = -mVelocity.z;*/
-
-
-	if(mPosition.x < -256)
-		mVelocity.x = abs(mVelocity.x);
-	if(mPosition.x > 256)
-		mVelocity.x = -abs(mVelocity.x);
-	if(mPosition.y < 0)
-		mVelocity.y = abs(mVelocity.y);
-	if(mPosition.y > 30)
-		mVelocity.y = -abs(mVelocity.y);
-	if(mPosition.z < -256)
-		mVelocity.z = abs(mVelocity.z);
-	if(mPosition.z > 256)
-		mVelocity.z = -abs(mVelocity.z);
-
-	UpdateWorldMatrix();
-
-	if(GetAsyncKeyState(VK_F1))
-		mEffect->GetVariableByName("gDrawLight")->AsScalar()->SetBool(false);
-	else if(GetAsyncKeyState(VK_F2))
-		mEffect->GetVariableByName("gDrawLight")->AsScalar()->SetBool(true);
-}
-
-void Object3D::Draw(D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos)
-{
-	mDevice->IASetInputLayout(mVertexLayout);
-	mDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	D3DXMATRIX wvp = (*mMatrixWorld) * (*vpMatrix);
-
-	mFXEyePos->SetFloatVector((float*)&eyePos);
-	mFXLightPos->SetFloatVector((float*)&mLightPosition);
-	mFXWorld->SetMatrix((float*)mMatrixWorld);
-	mFXWorldViewProj->SetMatrix((float*)wvp);
-
-	D3D10_TECHNIQUE_DESC techDesc;
-	mTechnique->GetDesc(&techDesc);
-	for(UINT p = 0; p < techDesc.Passes; ++p)
-	{
-		mTechnique->GetPassByIndex(p)->Apply(0);
-		
-		for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
-			it->second.Draw(mDevice);
-	}
-}
-
-void Object3D::DrawShadows(D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos)
-{
-	mDevice->IASetInputLayout(mVertexLayout);
-	mDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	D3DXMATRIX wvp = (*mMatrixWorld) * (*vpMatrix);
-	mFXShadowWVP->SetMatrix((float*)wvp);
-
-	D3D10_TECHNIQUE_DESC techDesc;
-	mTechniqueShadows->GetDesc(&techDesc);
-	for(UINT p = 0; p < techDesc.Passes; ++p)
-	{
-		mTechniqueShadows->GetPassByIndex(p)->Apply(0);
-		
-		for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
-			it->second.Draw(mDevice);
-	}
-}
-
-void Object3D::UpdateWorldMatrix()
-{
-	// Update rotation in matrix
-	float cosA = std::cos(mRotation);
-	float sinA = std::sin(mRotation);
-
-	mMatrixWorld->m[0][0] = cosA;
-	mMatrixWorld->m[0][2] = -sinA;
-	mMatrixWorld->m[2][0] = sinA;
-	mMatrixWorld->m[2][2] = cosA;
-
-	// Update position in matrix
-	mMatrixWorld->m[3][0] = mPosition.x;
-	mMatrixWorld->m[3][1] = mPosition.y;
-	mMatrixWorld->m[3][2] = mPosition.z;
+#include "Object3D.h"
+#include <sstream>
+#include <cassert>
+#include <algorithm>
+
+namespace
+{
+	const int C_MAX_OCCLUDER_TRIANGLES = 512;
+	const float C_AO_DISTANCE_SCALE = 0.25f;		// Occlusion distance, as a fraction of the bounds' diagonal
+
+	struct OccluderTriangle
+	{
+		float				Area;
+		int					FirstVertex;
+
+		bool operator<(const OccluderTriangle& other) const
+		{
+			return Area > other.Area;
+		}
+	};
+
+	struct PositionLess
+	{
+		bool operator()(const D3DXVECTOR3& a, const D3DXVECTOR3& b) const
+		{
+			if(a.x != b.x)
+				return a.x < b.x;
+			if(a.y != b.y)
+				return a.y < b.y;
+			return a.z < b.z;
+		}
+	};
+}
+
+Object3D::MaterialInfo::MaterialInfo()
+	: Ambient(D3DXVECTOR3(0.2, 0.2, 0.2))
+	, Diffuse(D3DXVECTOR3(0.8, 0.8, 0.8))
+	, Specular(D3DXVECTOR3(1.0, 1.0, 1.0))
+	, Tf(D3DXVECTOR3(1.0, 1.0, 1.0))
+	, IlluminationModel(0)
+	//, Opacitiy(1.0)
+	, RefractionIndex(1.0)
+	, SpecularExp(8.0f)
+	//, Sharpness(60.0)
+	, MainTexture(NULL)
+{}
+
+Object3D::Group::Group()
+	: mVertexBuffer(NULL), mPositionBuffer(NULL), mPositionIndexBuffer(NULL), mVisible(true), mCastsShadow(true), mFXKa(NULL), mFXKd(NULL), mFXKs(NULL), mFXSpecExp(NULL), mFXTexture(NULL)
+{}
+
+Object3D::Group::~Group() throw()
+{
+	SafeDelete(mVertexBuffer);
+	SafeDelete(mPositionBuffer);
+	SafeDelete(mPositionIndexBuffer);
+}
+
+void Object3D::Group::AddVertices(std::vector<Vertex> vertexList)
+{
+	for(int i = 0; i < vertexList.size(); ++i)
+		mVertices.push_back(vertexList[i]);
+}
+
+void Object3D::Group::ComputeBounds()
+{
+	mBounds = AABB();
+	for(int i = 0; i < mVertices.size(); ++i)
+		mBounds.Expand(mVertices[i].Position);
+
+	if(!mBounds.IsEmpty())
+		mSphere = BoundingSphere::FromAABB(mBounds);
+}
+
+bool Object3D::Group::Finalize(RenderDevice* device, RenderEffect effect)
+{
+	mFXTexture = device->GetVariable(effect, "gTextureBTH");
+	mFXKa = device->GetVariable(effect, "gKa");
+	mFXKd = device->GetVariable(effect, "gKd");
+	mFXKs = device->GetVariable(effect, "gKs");
+	mFXSpecExp = device->GetVariable(effect, "gSExp");
+
+	if(mVertices.size() <= 0)
+		return false;
+
+	mVertexBuffer = new Buffer();
+	
+	BufferInformation vbDesc;
+	vbDesc.type					= VertexBuffer;
+	vbDesc.usage				= Buffer_Default;
+	vbDesc.elementSize			= sizeof(Vertex);
+	vbDesc.numberOfElements		= mVertices.size();
+	vbDesc.firstElementPointer	= &mVertices[0];
+
+	return mVertexBuffer->Initialize(device, vbDesc) == S_OK;
+}
+
+// Build the stream the depth passes draw from. Vertices that only differ in their normal, uv or
+// occlusion share one position, so the shared corners are fetched and transformed once.
+bool Object3D::Group::CreatePositionStream(RenderDevice* device)
+{
+	if(mVertices.size() <= 0)
+		return false;
+
+	std::vector<D3DXVECTOR3> positions;
+	std::vector<UINT> indices;
+	std::map<D3DXVECTOR3, UINT, PositionLess> unique;
+
+	indices.reserve(mVertices.size());
+	for(int i = 0; i < mVertices.size(); ++i)
+	{
+		std::map<D3DXVECTOR3, UINT, PositionLess>::iterator it = unique.find(mVertices[i].Position);
+		if(it == unique.end())
+		{
+			it = unique.insert(std::make_pair(mVertices[i].Position, (UINT)positions.size())).first;
+			positions.push_back(mVertices[i].Position);
+		}
+		indices.push_back(it->second);
+	}
+
+	mPositionBuffer = new Buffer();
+	mPositionIndexBuffer = new Buffer();
+
+	BufferInformation vbDesc;
+	vbDesc.type					= VertexBuffer;
+	vbDesc.usage				= Buffer_Default;
+	vbDesc.elementSize			= sizeof(D3DXVECTOR3);
+	vbDesc.numberOfElements		= positions.size();
+	vbDesc.firstElementPointer	= &positions[0];
+
+	BufferInformation ibDesc;
+	ibDesc.type					= IndexBuffer;
+	ibDesc.usage				= Buffer_Default;
+	ibDesc.elementSize			= sizeof(UINT);
+	ibDesc.numberOfElements		= indices.size();
+	ibDesc.firstElementPointer	= &indices[0];
+
+	return mPositionBuffer->Initialize(device, vbDesc) == S_OK && mPositionIndexBuffer->Initialize(device, ibDesc) == S_OK;
+}
+
+void Object3D::Group::Draw(RenderDevice* device)
+{
+	if(mVertexBuffer == NULL)
+		return;
+
+	device->SetShaderView(mFXTexture, Material->MainTexture);
+	device->SetFloatVector(mFXKa, (const float*)&Material->Ambient);
+	device->SetFloatVector(mFXKd, (const float*)&Material->Diffuse);
+	device->SetFloatVector(mFXKs, (const float*)&Material->Specular);
+	device->SetFloat(mFXSpecExp, Material->SpecularExp);
+	//effect->GetVariableByName("Tf")->AsVector()->SetFloatVector(Material->Tf);
+	//effect->GetVariableByName("illum")->AsScalar()->SetInt(Material->IlluminationModel);
+	//effect->GetVariableByName("refrac")->AsScalar()->SetFloat(Material->RefractionIndex);
+
+	mVertexBuffer->MakeActive();
+
+	device->Draw(mVertexBuffer->GetSize(), 0);
+}
+
+// Draw the group's depth from its position stream or, as the depth passes did before it, from the
+// interleaved vertices
+void Object3D::Group::DrawDepth(RenderDevice* device, bool positionStream)
+{
+	if(!positionStream)
+	{
+		if(mVertexBuffer != NULL)
+		{
+			mVertexBuffer->MakeActive();
+			device->Draw(mVertexBuffer->GetSize(), 0);
+		}
+	}
+	else if(mPositionBuffer != NULL && mPositionIndexBuffer != NULL)
+	{
+		mPositionBuffer->MakeActive();
+		mPositionIndexBuffer->MakeActive();
+		device->DrawIndexed(mPositionIndexBuffer->GetSize(), 0, 0);
+	}
+}
+
+void Object3D::Group::AddDepthStatistics(bool positionStream, DepthPassStatistics& statistics) const
+{
+	if(mVertexBuffer == NULL || mPositionBuffer == NULL)
+		return;
+
+	int numVertices = (int)mVertices.size();
+	int interleavedBytes = numVertices * sizeof(Vertex);
+
+	++statistics.Draws;
+	statistics.Triangles += numVertices / 3;
+	statistics.FetchBytes += positionStream ? mPositionBuffer->GetSize() * sizeof(D3DXVECTOR3) + numVertices * sizeof(UINT)
+											: interleavedBytes;
+	statistics.InterleavedFetchBytes += interleavedBytes;
+}
+
+Object3D::Object3D(RenderDevice* device, std::string filename, D3DXVECTOR3 position, D3DXVECTOR3 lightPos)
+	: mDevice(device), mEffect(NULL), mEffectShadows(NULL), mTechnique(NULL), mTechniqueShadows(NULL),
+	  mTechniqueShadowsInterleaved(NULL), mTechniqueSceneDepth(NULL), mTechniqueCube(NULL), mTechniqueCubeFace(NULL), mVertexLayout(NULL), mPositionLayout(NULL), mPositionStreams(true), mLightPosition(lightPos), mShadowMap(NULL), mPointShadowMap(NULL), mFXEyePos(NULL), mFXLightPos(NULL),
+	  mFXWorld(NULL), mFXWorldViewProj(NULL), mFXShadowWVP(NULL), mFXShadowWorld(NULL), mFXCubeViewProj(NULL), mFXCubeFaceMask(NULL),
+	  mBoundingRadius(0.0f)
+{
+	if(!Load(filename))
+		return;
+
+	mEffect = mDevice->CreateEffect("Effect.fx");
+	mEffectShadows = mDevice->CreateEffect("EffectShadows.fx");
+	CreateVertexLayout();
+
+	mMatrixWorld = new D3DXMATRIX();
+	D3DXMatrixTranslation(mMatrixWorld, position.x, position.y, position.z);
+
+	mFXEyePos = mDevice->GetVariable(mEffect, "gEyePos");
+	mFXLightPos = mDevice->GetVariable(mEffect, "gLightPosition");
+	mFXWorld = mDevice->GetVariable(mEffect, "gWorld");
+	mFXWorldViewProj = mDevice->GetVariable(mEffect, "gWVP");
+	mFXShadowWVP = mDevice->GetVariable(mEffectShadows, "gWVP");
+	mFXShadowWorld = mDevice->GetVariable(mEffectShadows, "gWorld");
+	mFXCubeViewProj = mDevice->GetVariable(mEffectShadows, "gCubeViewProj");
+	mFXCubeFaceMask = mDevice->GetVariable(mEffectShadows, "gCubeFaceMask");
+	mShadowVariables.Initialize(mDevice, mEffect);
+	mPointShadowVariables.Initialize(mDevice, mEffect);
+	
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		it->second.Finalize(mDevice, mEffect);
+		it->second.CreatePositionStream(mDevice);
+	}
+}
+
+Object3D::~Object3D()
+{
+	mDevice->ReleaseEffect(mEffect);
+	mDevice->ReleaseEffect(mEffectShadows);
+	mDevice->ReleaseInputLayout(mVertexLayout);
+	mDevice->ReleaseInputLayout(mPositionLayout);
+
+	for(std::map<std::string, MaterialInfo>::iterator it = mMaterials.begin(); it != mMaterials.end(); ++it)
+		mDevice->ReleaseShaderView(it->second.MainTexture);
+
+	SafeDelete(mMatrixWorld);
+}
+
+bool Object3D::Load(std::string filename)
+{
+	std::ifstream file;
+	std::vector<Vertex> vertices;
+	std::vector<D3DXVECTOR3> outPositions;
+	std::vector<D3DXVECTOR2> outUVCoords;
+	std::vector<D3DXVECTOR3> outNormals;
+
+	Group currGroup;
+	std::string currGroupName = "";
+
+	file.open(filename.c_str(), std::ios_base::binary);
+	
+	if(!file.is_open())
+		return false;
+
+	while(!file.eof())
+	{
+		// Read first line of file.
+		std::string line;
+		std::getline(file, line);
+
+		// Copy line to a stringstream and copy first word into string key
+		std::stringstream streamLine;
+		streamLine.str(line);
+		std::string key;
+		streamLine >> key;
+
+		if(key == "mtllib")
+		{
+			std::string matFileName;
+			streamLine >> matFileName;
+			LoadMaterials(matFileName);
+		}
+		else if(key == "v")
+		{
+			D3DXVECTOR3 currPos;
+			streamLine >> currPos.x;
+			streamLine >> currPos.y;
+			streamLine >> currPos.z;
+			outPositions.push_back(currPos);
+		}
+		else if(key == "vt")
+		{
+			D3DXVECTOR2 currUV;
+			streamLine >> currUV.x;
+			streamLine >> currUV.y;
+			currUV.y = 1 - currUV.y;
+			outUVCoords.push_back(currUV);
+		}
+		else if(key == "vn")
+		{
+			D3DXVECTOR3 currNormal;
+			streamLine >> currNormal.x;
+			streamLine >> currNormal.y;
+			streamLine >> currNormal.z;
+			outNormals.push_back(currNormal);
+		}
+		else if(key == "g")
+		{
+			std::string groupName;
+			streamLine >> groupName;
+
+			std::streampos pos = file.tellg();
+			std::getline(file, line);
+			streamLine.str(line);
+			streamLine >> key;
+
+			if(key == "usemtl")
+			{
+				streamLine >> key;
+				if(currGroupName != "") // It is not the first group
+				{
+					mGroups[currGroupName].Material = currGroup.Material;
+					mGroups[currGroupName].AddVertices(vertices);
+					vertices.clear();
+					currGroup = Group();
+				}
+
+				assert(mMaterials.find(key) != mMaterials.end()); // Make sure the material exists
+				currGroup.Material = &mMaterials[key];
+				currGroupName = groupName;
+			}
+			else
+				file.seekg(pos);
+		}
+		else if(key == "f")
+		{
+			int pos[3]; 
+			int uv[3];
+			int norm[3];
+
+			for(int i = 0; i < 3; ++i)
+			{
+				streamLine >> pos[i];
+				streamLine.ignore();
+				streamLine >> uv[i];
+				streamLine.ignore();
+				streamLine >> norm[i];
+
+				Vertex currVertex;
+				currVertex.Position = outPositions[pos[i] - 1];
+				currVertex.UV = outUVCoords[uv[i] - 1];
+				currVertex.Normal = outNormals[norm[i] - 1];
+				currVertex.AO = 1.0f;
+				vertices.push_back(currVertex);
+			}
+		}
+	}
+
+	mGroups[currGroupName].Material = currGroup.Material;
+	mGroups[currGroupName].AddVertices(vertices);
+
+	// Calculate bounding volumes for culling
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		it->second.ComputeBounds();
+		if(!it->second.mBounds.IsEmpty())
+			mBounds.Expand(it->second.mBounds);
+	}
+
+	for(int i = 0; i < outPositions.size(); ++i)
+	{
+		float distance = D3DXVec3Length(&outPositions[i]);
+		if(distance > mBoundingRadius)
+			mBoundingRadius = distance;
+	}
+
+	CreateTriangleList();
+	CreateOccluder();
+
+	return true;
+}
+
+bool Object3D::LoadMaterials(std::string filename)
+{
+	MaterialInfo currMaterial;
+	std::string currMaterialName = "";
+	std::ifstream file;
+	file.open(filename.c_str(), std::ios_base::in);
+	
+	if(!file.is_open())
+		return false;
+
+	while(!file.eof())
+	{
+		// Read first line of file.
+		std::string line;
+		std::getline(file, line);
+
+		// Copy line to a stringstream and copy first word into string key
+		std::stringstream streamLine;
+		std::string key;
+
+		streamLine.str(line);
+		streamLine >> key;
+
+		if(key == "newmtl")
+		{
+			if(currMaterialName != "") // It is not the first material read
+			{
+				// Save previous material, making sure the material does not already exist in Materials
+				assert(mMaterials.find(currMaterialName) == mMaterials.end());
+				mMaterials[currMaterialName] = currMaterial;
+			}
+
+			// Set new material name and clear current material
+			streamLine >> currMaterialName;
+			currMaterial = MaterialInfo();
+		}
+		else if(key == "Ka") // Ambient color
+		{
+			streamLine >> currMaterial.Ambient.x;
+			streamLine >> currMaterial.Ambient.y;
+			streamLine >> currMaterial.Ambient.z;
+		}
+		else if(key == "Kd") // Diffuse color
+		{
+			streamLine >> currMaterial.Diffuse.x;
+			streamLine >> currMaterial.Diffuse.y;
+			streamLine >> currMaterial.Diffuse.z;
+		}
+		else if(key == "Ks") // Specular color
+		{
+			streamLine >> currMaterial.Specular.x;
+			streamLine >> currMaterial.Specular.y;
+			streamLine >> currMaterial.Specular.z;
+		}
+		else if(key == "Tf") // Transmission filter
+		{
+			streamLine >> currMaterial.Tf.x;
+			streamLine >> currMaterial.Tf.y;
+			streamLine >> currMaterial.Tf.z;
+		}
+		else if(key == "illum") // Illumination model
+		{
+			streamLine >> currMaterial.IlluminationModel;
+		}
+		//else if(key == "d" || key == "Tr") // Opacity
+		//{
+		//	streamLine >> currMaterial.Opacitiy;
+		//}
+		else if(key == "Ni") // Optical density
+		{
+			streamLine >> currMaterial.RefractionIndex;
+		}
+		else if(key == "Ns") // Specular exponent
+		{
+			streamLine >> currMaterial.SpecularExp;
+		}
+		//else if(key == "sharpness") // Reflection sharpness
+		//{
+		//	streamLine >> currMaterial.Sharpness;
+		//}
+		else if(key == "map_Ka" || key == "map_Kd" || key == "map_Ks")				// Only use one texture at this point
+		{
+			// Get the next argument on the line
+			std::string textureFilename;
+			streamLine >> textureFilename;
+
+			// Make sure there is a period in the name indicating a file name. The other
+			// arguments are not interesting at this point.
+			while (textureFilename.find('.') == std::string::npos && !streamLine.eof())
+				streamLine >> textureFilename;
+
+			// Only try to load the texture if a filename was read
+			if(textureFilename.find('.') != std::string::npos)
+				currMaterial.MainTexture = mDevice->LoadTexture("bthcolor.dds");
+		}
+	}
+
+	if(currMaterialName != "") // It is not the first material read
+	{
+		// Save previous material, making sure the material does not already exist in Materials
+		assert(mMaterials.find(currMaterialName) == mMaterials.end());
+		mMaterials[currMaterialName] = currMaterial;
+	}
+	
+	return true;
+}
+
+// Build vertex layout
+HRESULT Object3D::CreateVertexLayout()
+{
+	// Create an array describing each of the elements of the vertex that are inputs to the vertex shader.
+	// Each element has its semantic name, which must be the same as the vertex shader input's, the
+	// semantic index and format, and its offset in bytes from the start of the vertex.
+	RenderVertexElement vertexDesc[] = 
+	{
+		{ "POSITION", 0, RenderFormatR32G32B32Float, 0 },
+		{ "NORMAL", 0, RenderFormatR32G32B32Float, sizeof(float) * 3 },
+		{ "TEXCOORD", 0, RenderFormatR32G32Float, sizeof(float) * 6 },
+		{ "AO", 0, RenderFormatR32Float, sizeof(float) * 8 }
+	};
+
+		// Get the effect technique from the effect, and create the input layout from its first pass
+		mTechnique = mDevice->GetTechnique(mEffect, "DrawTechnique");
+		mVertexLayout = mDevice->CreateInputLayout(vertexDesc, 4, mDevice->GetPass(mTechnique, 0));
+		if(mVertexLayout == NULL)
+			return E_FAIL;
+
+		// Bind the input layout to the 3D device
+		mDevice->SetInputLayout(mVertexLayout);
+
+		// --- Repeat for the shadow technique, which only reads the position stream
+		mTechniqueShadows = mDevice->GetTechnique(mEffectShadows, "DrawTechnique");
+		mTechniqueShadowsInterleaved = mDevice->GetTechnique(mEffectShadows, "DrawInterleavedTechnique");
+		mTechniqueSceneDepth = mDevice->GetTechnique(mEffectShadows, "DrawSceneDepthTechnique");
+		mTechniqueCube = mDevice->GetTechnique(mEffectShadows, "DrawCubeTechnique");
+		mTechniqueCubeFace = mDevice->GetTechnique(mEffectShadows, "DrawCubeFaceTechnique");
+		mPositionLayout = mDevice->CreateInputLayout(vertexDesc, 1, mDevice->GetPass(mTechniqueShadows, 0));
+		if(mPositionLayout == NULL)
+			return E_FAIL;
+
+		return S_OK;
+}
+
+// Movement is integrated by the scene's MovingObjectStore, only input is handled here
+void Object3D::Update(GameTime gameTime)
+{
+	if(GetAsyncKeyState(VK_F1))
+		mDevice->SetBool(mDevice->GetVariable(mEffect, "gDrawLight"), false);
+	else if(GetAsyncKeyState(VK_F2))
+		mDevice->SetBool(mDevice->GetVariable(mEffect, "gDrawLight"), true);
+}
+
+// Set the world matrix used when drawing, built by the scene's MovingObjectStore
+void Object3D::SetWorldMatrix(const D3DXMATRIX& world)
+{
+	*mMatrixWorld = world;
+}
+
+// The shadows the object receives, NULL for none
+void Object3D::SetShadowMap(const CascadedShadowMap* shadowMap)
+{
+	mShadowMap = shadowMap;
+}
+
+// A point light's shadows received instead of the cascades, NULL to go back to the cascades
+void Object3D::SetPointShadowMap(const PointShadowMap* pointShadowMap)
+{
+	mPointShadowMap = pointShadowMap;
+}
+
+// Test the world space bounding spheres of all groups against the frustum and return how many are
+// visible. Only the visible groups are drawn by Draw.
+int Object3D::Cull(const FrustumPlanes& frustum)
+{
+	int numGroups = (int)mGroups.size();
+	for(int i = 0; i < 3; ++i)
+		mCullCenters[i].resize(numGroups);
+	mCullRadii.resize(numGroups);
+	mCullVisible.resize(numGroups);
+
+	int index = 0;
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it, ++index)
+	{
+		D3DXVECTOR3 center;
+		D3DXVec3TransformCoord(&center, &it->second.mSphere.Center, mMatrixWorld);
+		mCullCenters[0][index] = center.x;
+		mCullCenters[1][index] = center.y;
+		mCullCenters[2][index] = center.z;
+		mCullRadii[index] = it->second.mVertexBuffer != NULL ? it->second.mSphere.Radius : -FLT_MAX;
+	}
+
+	int numVisible = 0;
+	if(numGroups > 0)
+		numVisible = frustum.CullSpheres(&mCullCenters[0][0], &mCullCenters[1][0], &mCullCenters[2][0], &mCullRadii[0],
+										 numGroups, &mCullVisible[0]);
+
+	index = 0;
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it, ++index)
+		it->second.mVisible = mCullVisible[index] != 0;
+
+	return numVisible;
+}
+
+// Test the world space boxes of the groups that passed the frustum test against the occlusion
+// buffer, returns how many were found to be hidden
+int Object3D::CullOccluded(const OcclusionCuller& culler)
+{
+	int numOccluded = 0;
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		Group& group = it->second;
+		if(!group.mVisible || group.mBounds.IsEmpty())
+			continue;
+
+		if(!culler.TestBox(group.mBounds.Transform(*mMatrixWorld)))
+		{
+			group.mVisible = false;
+			++numOccluded;
+		}
+	}
+
+	return numOccluded;
+}
+
+// Decide which groups are drawn by DrawShadows. A group casts a shadow if it is inside the light
+// frustum and its shadow, swept from the group along the light direction, can reach the receivers.
+// Both the light frustum and the receiver bounds (in light view space) come from the scene.
+void Object3D::CullCasters(const FrustumPlanes& lightFrustum, const D3DXMATRIX& lightView, const AABB& receivers,
+						   int& numInLightFrustum, int& numCasters)
+{
+	numInLightFrustum = 0;
+	numCasters = 0;
+
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		Group& group = it->second;
+		group.mCastsShadow = false;
+		if(group.mVertexBuffer == NULL || group.mBounds.IsEmpty())
+			continue;
+
+		AABB worldBounds = group.mBounds.Transform(*mMatrixWorld);
+		if(!lightFrustum.TestBox(worldBounds))
+			continue;
+
+		++numInLightFrustum;
+
+		// The light looks down +z in its view space, so the shadow covers the group's xy rectangle
+		// from the group's nearest z and onwards
+		AABB lightBounds = worldBounds.Transform(lightView);
+		if(receivers.IsEmpty() ||
+		   lightBounds.Min.x > receivers.Max.x || lightBounds.Max.x < receivers.Min.x ||
+		   lightBounds.Min.y > receivers.Max.y || lightBounds.Max.y < receivers.Min.y ||
+		   lightBounds.Min.z > receivers.Max.z)
+			continue;
+
+		group.mCastsShadow = true;
+		++numCasters;
+	}
+}
+
+// Grow the light view space receiver bounds by the groups that are visible to the camera
+void Object3D::ExpandReceiverBounds(const D3DXMATRIX& lightView, AABB& receivers) const
+{
+	D3DXMATRIX worldToLight = (*mMatrixWorld) * lightView;
+	for(std::map<std::string, Group>::const_iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		if(it->second.mVisible && !it->second.mBounds.IsEmpty())
+			receivers.Expand(it->second.mBounds.Transform(worldToLight));
+	}
+}
+
+void Object3D::Draw(const D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos)
+{
+	mDevice->SetInputLayout(mVertexLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	D3DXMATRIX wvp = (*mMatrixWorld) * (*vpMatrix);
+
+	mDevice->SetFloatVector(mFXEyePos, (const float*)&eyePos);
+	mDevice->SetFloatVector(mFXLightPos, (const float*)&mLightPosition);
+	mDevice->SetMatrix(mFXWorld, (const float*)mMatrixWorld);
+	mDevice->SetMatrix(mFXWorldViewProj, (const float*)&wvp);
+	mShadowVariables.Set(mShadowMap);
+	mPointShadowVariables.Set(mPointShadowMap);
+
+	RenderTechnique technique = GetReceiverTechnique();
+	int numPasses = mDevice->GetPassCount(technique);
+	for(int p = 0; p < numPasses; ++p)
+	{
+		mDevice->ApplyPass(mDevice->GetPass(technique, p));
+		
+		for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+		{
+			if(it->second.mVisible)
+				it->second.Draw(mDevice);
+		}
+	}
+
+	mShadowVariables.Clear();
+	mPointShadowVariables.Clear();
+}
+
+// Draw every group once per world matrix, one draw call per group and instance
+void Object3D::DrawInstances(const D3DXMATRIX* worlds, int count, const D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos)
+{
+	mDevice->SetInputLayout(mVertexLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	mDevice->SetFloatVector(mFXEyePos, (const float*)&eyePos);
+	mDevice->SetFloatVector(mFXLightPos, (const float*)&mLightPosition);
+	mShadowVariables.Set(mShadowMap);
+	mPointShadowVariables.Set(mPointShadowMap);
+
+	RenderTechnique technique = GetReceiverTechnique();
+	int numPasses = mDevice->GetPassCount(technique);
+	for(int i = 0; i < count; ++i)
+	{
+		D3DXMATRIX wvp = worlds[i] * (*vpMatrix);
+		mDevice->SetMatrix(mFXWorld, (const float*)&worlds[i]);
+		mDevice->SetMatrix(mFXWorldViewProj, (const float*)&wvp);
+
+		for(int p = 0; p < numPasses; ++p)
+		{
+			mDevice->ApplyPass(mDevice->GetPass(technique, p));
+
+			for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+				it->second.Draw(mDevice);
+		}
+	}
+
+	mDevice->SetMatrix(mFXWorld, (const float*)mMatrixWorld);
+	mShadowVariables.Clear();
+	mPointShadowVariables.Clear();
+}
+
+// Draw the depth of the visible groups for the camera, from the position streams
+void Object3D::DrawDepth(const D3DXMATRIX* vpMatrix)
+{
+	mDevice->SetInputLayout(mPositionLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	D3DXMATRIX wvp = (*mMatrixWorld) * (*vpMatrix);
+	mDevice->SetMatrix(mFXShadowWVP, (const float*)&wvp);
+
+	int numPasses = mDevice->GetPassCount(mTechniqueSceneDepth);
+	for(int p = 0; p < numPasses; ++p)
+	{
+		mDevice->ApplyPass(mDevice->GetPass(mTechniqueSceneDepth, p));
+
+		for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+		{
+			if(it->second.mVisible)
+				it->second.DrawDepth(mDevice, true);
+		}
+	}
+}
+
+// The depth of every group once per world matrix, for the copies drawn by DrawInstances
+void Object3D::DrawDepthInstances(const D3DXMATRIX* worlds, int count, const D3DXMATRIX* vpMatrix)
+{
+	mDevice->SetInputLayout(mPositionLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	int numPasses = mDevice->GetPassCount(mTechniqueSceneDepth);
+	for(int i = 0; i < count; ++i)
+	{
+		D3DXMATRIX wvp = worlds[i] * (*vpMatrix);
+		mDevice->SetMatrix(mFXShadowWVP, (const float*)&wvp);
+
+		for(int p = 0; p < numPasses; ++p)
+		{
+			mDevice->ApplyPass(mDevice->GetPass(mTechniqueSceneDepth, p));
+
+			for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+				it->second.DrawDepth(mDevice, true);
+		}
+	}
+}
+
+void Object3D::DrawShadows(const D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos, DepthPassStatistics& statistics)
+{
+	mDevice->SetInputLayout(mPositionStreams ? mPositionLayout : mVertexLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	D3DXMATRIX wvp = (*mMatrixWorld) * (*vpMatrix);
+	mDevice->SetMatrix(mFXShadowWVP, (const float*)&wvp);
+
+	RenderTechnique technique = mPositionStreams ? mTechniqueShadows : mTechniqueShadowsInterleaved;
+	int numPasses = mDevice->GetPassCount(technique);
+	for(int p = 0; p < numPasses; ++p)
+	{
+		mDevice->ApplyPass(mDevice->GetPass(technique, p));
+		DrawShadowGroups(true, statistics);
+	}
+}
+
+// Draw every group of the object into the depth map once per world matrix, for copies of the object
+// that are not culled group by group
+void Object3D::DrawShadowInstances(const D3DXMATRIX* worlds, int count, const D3DXMATRIX* vpMatrix,
+								   DepthPassStatistics& statistics)
+{
+	mDevice->SetInputLayout(mPositionStreams ? mPositionLayout : mVertexLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	RenderTechnique technique = mPositionStreams ? mTechniqueShadows : mTechniqueShadowsInterleaved;
+	int numPasses = mDevice->GetPassCount(technique);
+	for(int i = 0; i < count; ++i)
+	{
+		D3DXMATRIX wvp = worlds[i] * (*vpMatrix);
+		mDevice->SetMatrix(mFXShadowWVP, (const float*)&wvp);
+
+		for(int p = 0; p < numPasses; ++p)
+		{
+			mDevice->ApplyPass(mDevice->GetPass(technique, p));
+			DrawShadowGroups(false, statistics);
+		}
+	}
+}
+
+// Draw every group into all faces of the bound cube at once, once per world matrix. Each group is only
+// sent to the faces its bounds reach into, the geometry shader culls the triangles against those.
+void Object3D::DrawCubeShadowInstances(const D3DXMATRIX* worlds, int count, const PointShadowMap& shadowMap,
+									   DepthPassStatistics& statistics)
+{
+	mDevice->SetInputLayout(mPositionLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	for(int i = 0; i < PointShadowMap::FaceCount; ++i)
+		mDevice->SetMatrixArray(mFXCubeViewProj, (const float*)&shadowMap.GetViewProjectionMatrix(i), i, 1);
+
+	int numPasses = mDevice->GetPassCount(mTechniqueCube);
+	for(int i = 0; i < count; ++i)
+	{
+		mDevice->SetMatrix(mFXShadowWorld, (const float*)&worlds[i]);
+
+		for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+		{
+			int faceMask = shadowMap.GetFaceMask(it->second.mBounds.Transform(worlds[i]));
+			if(faceMask == 0)
+				continue;
+
+			mDevice->SetInt(mFXCubeFaceMask, faceMask);
+			for(int p = 0; p < numPasses; ++p)
+			{
+				mDevice->ApplyPass(mDevice->GetPass(mTechniqueCube, p));
+				it->second.DrawDepth(mDevice, true);
+				it->second.AddDepthStatistics(true, statistics);
+			}
+		}
+	}
+}
+
+// Draw the groups that reach into one face of the cube, once per world matrix, into the bound face.
+// Six of these are what the single pass above replaces.
+void Object3D::DrawCubeFaceShadowInstances(const D3DXMATRIX* worlds, int count, const PointShadowMap& shadowMap, int face,
+										   DepthPassStatistics& statistics)
+{
+	mDevice->SetInputLayout(mPositionLayout);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	const FrustumPlanes& frustum = shadowMap.GetFrustumPlanes(face);
+	int numPasses = mDevice->GetPassCount(mTechniqueCubeFace);
+	for(int i = 0; i < count; ++i)
+	{
+		D3DXMATRIX wvp = worlds[i] * shadowMap.GetViewProjectionMatrix(face);
+		mDevice->SetMatrix(mFXShadowWVP, (const float*)&wvp);
+
+		for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+		{
+			if(!frustum.TestBox(it->second.mBounds.Transform(worlds[i])))
+				continue;
+
+			for(int p = 0; p < numPasses; ++p)
+			{
+				mDevice->ApplyPass(mDevice->GetPass(mTechniqueCubeFace, p));
+				it->second.DrawDepth(mDevice, true);
+				it->second.AddDepthStatistics(true, statistics);
+			}
+		}
+	}
+}
+
+// Draw the groups into the bound depth map, only those that cast a shadow this frame if castersOnly
+void Object3D::DrawShadowGroups(bool castersOnly, DepthPassStatistics& statistics)
+{
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		if(castersOnly && !it->second.mCastsShadow)
+			continue;
+
+		it->second.DrawDepth(mDevice, mPositionStreams);
+		it->second.AddDepthStatistics(mPositionStreams, statistics);
+	}
+}
+
+// The point light's technique when the object receives its shadows, else the cascades' one
+RenderTechnique Object3D::GetReceiverTechnique() const
+{
+	if(mPointShadowMap != NULL)
+		return mPointShadowVariables.GetTechnique();
+
+	return mShadowVariables.GetTechnique(mShadowMap);
+}
+
+void Object3D::SetPositionStreams(bool enabled)
+{
+	mPositionStreams = enabled;
+}
+
+int Object3D::GetGroupCount() const
+{
+	return (int)mGroups.size();
+}
+
+// Get the object space bounding box of the whole object
+const AABB& Object3D::GetBounds() const
+{
+	return mBounds;
+}
+
+// Get the radius of a sphere around the object space origin that contains the whole object, it
+// stays valid however the object is rotated
+float Object3D::GetBoundingRadius() const
+{
+	return mBoundingRadius;
+}
+
+const D3DXMATRIX& Object3D::GetWorldMatrix() const
+{
+	return *mMatrixWorld;
+}
+
+// Get the object space triangle list used as occluder by the occlusion culling
+const std::vector<D3DXVECTOR3>& Object3D::GetOccluderVertices() const
+{
+	return mOccluderVertices;
+}
+
+// Build the tree for ray casts against the mesh. It is not built on load, since only some objects
+// need it and the scene has the job system to build it with.
+void Object3D::BuildBVH(JobSystem* jobSystem)
+{
+	mBVH.Build(mTriangleVertices.empty() ? NULL : &mTriangleVertices[0], (int)mTriangleVertices.size() / 3,
+			   jobSystem);
+}
+
+// Find the closest triangle hit by a world space ray. The ray is moved into object space rather than
+// the mesh into world space, which keeps the distance in lengths of the world space direction.
+bool Object3D::RayCast(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance,
+					   RayHit& hit) const
+{
+	D3DXMATRIX inverse;
+	if(D3DXMatrixInverse(&inverse, NULL, mMatrixWorld) == NULL)
+	{
+		hit.Distance = maxDistance;
+		hit.Triangle = -1;
+		return false;
+	}
+
+	D3DXVECTOR3 localOrigin;
+	D3DXVECTOR3 localDirection;
+	D3DXVec3TransformCoord(&localOrigin, &origin, &inverse);
+	D3DXVec3TransformNormal(&localDirection, &direction, &inverse);
+
+	return mBVH.RayCast(localOrigin, localDirection, maxDistance, hit);
+}
+
+// Bake the ambient occlusion of the mesh on itself into the vertices and recreate the vertex buffers.
+// The tree must have been built.
+void Object3D::BakeAmbientOcclusion(LightBaker& baker, JobSystem* jobSystem)
+{
+	if(mTriangleVertices.empty())
+		return;
+
+	std::vector<D3DXVECTOR3> normals;
+	normals.reserve(mTriangleVertices.size());
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		for(int i = 0; i < it->second.mVertices.size(); ++i)
+			normals.push_back(it->second.mVertices[i].Normal);
+	}
+
+	D3DXVECTOR3 diagonal = mBounds.Max - mBounds.Min;
+	std::vector<float> occlusion(mTriangleVertices.size());
+	baker.BakeVertexOcclusion(mBVH, &mTriangleVertices[0], &normals[0], (int)mTriangleVertices.size(),
+							  D3DXVec3Length(&diagonal) * C_AO_DISTANCE_SCALE, jobSystem, &occlusion[0]);
+
+	// The vertex buffers are immutable, so they are created again with the new vertices
+	int vertex = 0;
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		for(int i = 0; i < it->second.mVertices.size(); ++i)
+			it->second.mVertices[i].AO = occlusion[vertex++];
+
+		SafeDelete(it->second.mVertexBuffer);
+		it->second.Finalize(mDevice, mEffect);
+	}
+}
+
+// Render the impostor views of the mesh from its tree, with the diffuse color of each group's
+// material and the baked vertex occlusion. Textures are not sampled.
+void Object3D::CreateImpostorAtlas(ImpostorAtlas& atlas, int framesPerSide, int frameSize, JobSystem* jobSystem) const
+{
+	if(mTriangleVertices.empty())
+		return;
+
+	std::vector<D3DXVECTOR3> normals;
+	std::vector<float> occlusion;
+	std::vector<D3DXVECTOR3> colors;
+	normals.reserve(mTriangleVertices.size());
+	occlusion.reserve(mTriangleVertices.size());
+	colors.reserve(mTriangleVertices.size() / 3);
+	for(std::map<std::string, Group>::const_iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		for(int i = 0; i < it->second.mVertices.size(); ++i)
+		{
+			normals.push_back(it->second.mVertices[i].Normal);
+			occlusion.push_back(it->second.mVertices[i].AO);
+		}
+
+		D3DXVECTOR3 color = it->second.Material != NULL ? it->second.Material->Diffuse : D3DXVECTOR3(0.8f, 0.8f, 0.8f);
+		colors.insert(colors.end(), it->second.mVertices.size() / 3, color);
+	}
+
+	atlas.Generate(mBVH, &normals[0], &occlusion[0], &colors[0], framesPerSide, frameSize, jobSystem);
+}
+
+// Get the object space triangle list of all groups, which the ray cast triangle indices refer to
+const std::vector<D3DXVECTOR3>& Object3D::GetTriangleVertices() const
+{
+	return mTriangleVertices;
+}
+
+bool Object3D::GetPositionStreams() const
+{
+	return mPositionStreams;
+}
+
+const TriangleBVH& Object3D::GetBVH() const
+{
+	return mBVH;
+}
+
+std::string Object3D::GetTriangleGroupName(int triangle) const
+{
+	int group = 0;
+	for(std::map<std::string, Group>::const_iterator it = mGroups.begin(); it != mGroups.end(); ++it, ++group)
+	{
+		if(triangle < mGroupTriangleEnds[group])
+			return it->first;
+	}
+
+	return "";
+}
+
+void Object3D::CreateTriangleList()
+{
+	mTriangleVertices.clear();
+	mGroupTriangleEnds.clear();
+	for(std::map<std::string, Group>::iterator it = mGroups.begin(); it != mGroups.end(); ++it)
+	{
+		for(int i = 0; i < it->second.mVertices.size(); ++i)
+			mTriangleVertices.push_back(it->second.mVertices[i].Position);
+
+		mGroupTriangleEnds.push_back((int)mTriangleVertices.size() / 3);
+	}
+}
+
+// The occluder is a simplified version of the mesh made from its largest triangles. Dropping
+// triangles keeps it inside the real mesh, which is all an occluder needs.
+void Object3D::CreateOccluder()
+{
+	const std::vector<D3DXVECTOR3>& vertices = mTriangleVertices;
+
+	std::vector<OccluderTriangle> triangles;
+	for(int i = 0; i + 2 < (int)vertices.size(); i += 3)
+	{
+		D3DXVECTOR3 edge1 = vertices[i + 1] - vertices[i];
+		D3DXVECTOR3 edge2 = vertices[i + 2] - vertices[i];
+		D3DXVECTOR3 normal;
+		D3DXVec3Cross(&normal, &edge1, &edge2);
+
+		OccluderTriangle triangle;
+		triangle.Area = D3DXVec3Length(&normal);
+		triangle.FirstVertex = i;
+		triangles.push_back(triangle);
+	}
+
+	int numTriangles = std::min((int)triangles.size(), C_MAX_OCCLUDER_TRIANGLES);
+	std::partial_sort(triangles.begin(), triangles.begin() + numTriangles, triangles.end());
+
+	mOccluderVertices.clear();
+	for(int i = 0; i < numTriangles; ++i)
+	{
+		for(int k = 0; k < 3; ++k)
+			mOccluderVertices.push_back(vertices[triangles[i].FirstVertex + k]);
+	}
 }
\ No newline at end of file
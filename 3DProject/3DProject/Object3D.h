@@ -1,103 +1,183 @@
-#ifndef OBJECT3D_H
-#define OBJECT3D_H
-
-#include <fstream>
-#include <vector>
-#include <map>
-#include <string>
-#include <D3D10.h>
-
-#include "Globals.h"
-#include "Buffer.h"
-#include "GameFont.h"
-#include "GameTime.h"
-
-class Object3D
-{
-public:
-	Object3D(ID3D10Device* device, std::string filename, D3DXVECTOR3 position, D3DXVECTOR3 lightPos);
-	~Object3D();
-	
-	void Update(GameTime gameTime);
-	void Draw(D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos);
-	void DrawShadows(D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos);
-
-private:
-	struct Vertex
-	{
-		D3DXVECTOR3			Position;
-		D3DXVECTOR3			Normal;
-		D3DXVECTOR2			UV;
-	};
-
-	struct MaterialInfo
-	{
-		D3DXVECTOR3 Ambient;					// Ka coefficient, default (0.2, 0.2, 0.2)
-		D3DXVECTOR3 Diffuse;					// Kd coefficient, default (0.8, 0.8, 0.8)
-		D3DXVECTOR3 Specular;					// Ks coefficient, default (1.0, 1.0, 1.0)
-		D3DXVECTOR3 Tf;							// Transmission filter, how much of each color to pass through
-		int IlluminationModel;					// illum, 0-10
-		//float Opacitiy;						// d or Tr, 1.0-> fully opaque, 0.0-> fully transparent
-		float RefractionIndex;					// Ni, optical density, (0.001)1.0-10.0, 1.0-> light doesn't bend
-		float SpecularExp;						// Ns, ~0-1000, High value-> concentrated highlight
-		//float Sharpness;						// Sharpness of reflections, 0-1000, default 60.0
-		ID3D10ShaderResourceView* MainTexture;	// Texture that can be sent to the shaders
-
-		MaterialInfo();
-	};
-
-	struct Group
-	{
-	public:
-		MaterialInfo* Material;
-		Buffer*						mVertexBuffer;
-		std::vector<Vertex>			mVertices;
-
-		Group();
-		~Group() throw();
-		void AddVertices(std::vector<Vertex> vertexList);
-		bool Finalize(ID3D10Device* device, ID3D10Effect* effect);
-		void Draw(ID3D10Device* device);
-
-	private:
-		ID3D10EffectShaderResourceVariable* mFXTexture;
-		ID3D10EffectVectorVariable* mFXKa;
-		ID3D10EffectVectorVariable* mFXKd;
-		ID3D10EffectVectorVariable* mFXKs;
-		ID3D10EffectScalarVariable* mFXSpecExp;
-		/*Group(const Group&);
-		Group& operator=(const Group&);*/
-	};
-
-	std::map<std::string, MaterialInfo> mMaterials;
-	std::map<std::string, Group> mGroups;
-
-	ID3D10Device*				mDevice;
-	ID3D10Effect*				mEffect;
-	ID3D10Effect*				mEffectShadows;
-	ID3D10EffectTechnique*		mTechnique;
-	ID3D10EffectTechnique*		mTechniqueShadows;
-
-	ID3D10InputLayout*			mVertexLayout;
-	GameFont*					mFont;
-
-	D3DXMATRIX*					mMatrixWorld;
-	D3DXVECTOR3					mPosition;
-	D3DXVECTOR3					mVelocity;
-	float						mRotation;
-	D3DXVECTOR3					mLightPosition;
-
-	ID3D10EffectMatrixVariable* mFXWorld;
-	ID3D10EffectMatrixVariable* mFXWorldViewProj;
-	ID3D10EffectVectorVariable* mFXLightPos;
-	ID3D10EffectVectorVariable* mFXEyePos;
-	ID3D10EffectMatrixVariable* mFXShadowWVP;
-
-	bool Load(std::string filename);
-	bool LoadMaterials(std::string filename);
-
-	ID3D10Effect* CreateEffect(std::string filename);
-	HRESULT CreateVertexLayout();
-	void UpdateWorldMatrix();
-};
+#ifndef OBJECT3D_H
+#define OBJECT3D_H
+
+#include <fstream>
+#include <vector>
+#include <map>
+#include <string>
+#include <D3DX10.h>
+
+#include "Globals.h"
+#include "Buffer.h"
+#include "GameTime.h"
+#include "BoundingVolumes.h"
+#include "FrustumPlanes.h"
+#include "OcclusionCuller.h"
+#include "TriangleBVH.h"
+#include "LightBaker.h"
+#include "ImpostorAtlas.h"
+#include "CascadedShadowMap.h"
+#include "PointShadowMap.h"
+
+// What the draws into a depth map read, added up over a frame
+struct DepthPassStatistics
+{
+	int					Draws;
+	int					Triangles;					// Submitted, before the rasterizer culls any
+	int					FetchBytes;					// Vertex and index bytes, each vertex counted once
+	int					InterleavedFetchBytes;		// The same draws from the interleaved vertices
+};
+
+class Object3D
+{
+public:
+	Object3D(RenderDevice* device, std::string filename, D3DXVECTOR3 position, D3DXVECTOR3 lightPos);
+	~Object3D();
+	
+	void Update(GameTime gameTime);
+	void SetWorldMatrix(const D3DXMATRIX& world);
+	void SetShadowMap(const CascadedShadowMap* shadowMap);
+	void SetPointShadowMap(const PointShadowMap* pointShadowMap);
+	int Cull(const FrustumPlanes& frustum);
+	int CullOccluded(const OcclusionCuller& culler);
+	void CullCasters(const FrustumPlanes& lightFrustum, const D3DXMATRIX& lightView, const AABB& receivers,
+					 int& numInLightFrustum, int& numCasters);
+	void ExpandReceiverBounds(const D3DXMATRIX& lightView, AABB& receivers) const;
+	void Draw(const D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos);
+	void DrawShadows(const D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos, DepthPassStatistics& statistics);
+	void DrawShadowInstances(const D3DXMATRIX* worlds, int count, const D3DXMATRIX* vpMatrix,
+							 DepthPassStatistics& statistics);
+	void DrawCubeShadowInstances(const D3DXMATRIX* worlds, int count, const PointShadowMap& shadowMap,
+								 DepthPassStatistics& statistics);
+	void DrawCubeFaceShadowInstances(const D3DXMATRIX* worlds, int count, const PointShadowMap& shadowMap, int face,
+									 DepthPassStatistics& statistics);
+	void DrawInstances(const D3DXMATRIX* worlds, int count, const D3DXMATRIX* vpMatrix, D3DXVECTOR3 eyePos);
+	void DrawDepth(const D3DXMATRIX* vpMatrix);
+	void DrawDepthInstances(const D3DXMATRIX* worlds, int count, const D3DXMATRIX* vpMatrix);
+	void BuildBVH(JobSystem* jobSystem);
+	bool RayCast(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance, RayHit& hit) const;
+	void BakeAmbientOcclusion(LightBaker& baker, JobSystem* jobSystem);
+	void CreateImpostorAtlas(ImpostorAtlas& atlas, int framesPerSide, int frameSize, JobSystem* jobSystem) const;
+	void SetPositionStreams(bool enabled);
+
+	int GetGroupCount() const;
+	const AABB& GetBounds() const;
+	float GetBoundingRadius() const;
+	const D3DXMATRIX& GetWorldMatrix() const;
+	const std::vector<D3DXVECTOR3>& GetOccluderVertices() const;
+	const std::vector<D3DXVECTOR3>& GetTriangleVertices() const;
+	const TriangleBVH& GetBVH() const;
+	std::string GetTriangleGroupName(int triangle) const;
+	bool GetPositionStreams() const;
+
+private:
+	struct Vertex
+	{
+		D3DXVECTOR3			Position;
+		D3DXVECTOR3			Normal;
+		D3DXVECTOR2			UV;
+		float				AO;						// Baked ambient occlusion, 1 when unoccluded
+	};
+
+	struct MaterialInfo
+	{
+		D3DXVECTOR3 Ambient;					// Ka coefficient, default (0.2, 0.2, 0.2)
+		D3DXVECTOR3 Diffuse;					// Kd coefficient, default (0.8, 0.8, 0.8)
+		D3DXVECTOR3 Specular;					// Ks coefficient, default (1.0, 1.0, 1.0)
+		D3DXVECTOR3 Tf;							// Transmission filter, how much of each color to pass through
+		int IlluminationModel;					// illum, 0-10
+		//float Opacitiy;						// d or Tr, 1.0-> fully opaque, 0.0-> fully transparent
+		float RefractionIndex;					// Ni, optical density, (0.001)1.0-10.0, 1.0-> light doesn't bend
+		float SpecularExp;						// Ns, ~0-1000, High value-> concentrated highlight
+		//float Sharpness;						// Sharpness of reflections, 0-1000, default 60.0
+		RenderShaderView MainTexture;			// Texture that can be sent to the shaders
+
+		MaterialInfo();
+	};
+
+	struct Group
+	{
+	public:
+		MaterialInfo* Material;
+		Buffer*						mVertexBuffer;
+		Buffer*						mPositionBuffer;			// Unique positions, for the depth passes
+		Buffer*						mPositionIndexBuffer;		// Into mPositionBuffer, one per vertex
+		std::vector<Vertex>			mVertices;
+		AABB						mBounds;					// Object space bounds of the vertices
+		BoundingSphere				mSphere;					// Object space sphere around mBounds
+		bool						mVisible;					// Result of the last frustum test
+		bool						mCastsShadow;				// Result of the last caster test
+
+		Group();
+		~Group() throw();
+		void AddVertices(std::vector<Vertex> vertexList);
+		void ComputeBounds();
+		bool Finalize(RenderDevice* device, RenderEffect effect);
+		bool CreatePositionStream(RenderDevice* device);
+		void Draw(RenderDevice* device);
+		void DrawDepth(RenderDevice* device, bool positionStream);
+		void AddDepthStatistics(bool positionStream, DepthPassStatistics& statistics) const;
+
+	private:
+		RenderVariable mFXTexture;
+		RenderVariable mFXKa;
+		RenderVariable mFXKd;
+		RenderVariable mFXKs;
+		RenderVariable mFXSpecExp;
+		/*Group(const Group&);
+		Group& operator=(const Group&);*/
+	};
+
+	std::map<std::string, MaterialInfo> mMaterials;
+	std::map<std::string, Group> mGroups;
+
+	RenderDevice*				mDevice;
+	RenderEffect				mEffect;
+	RenderEffect				mEffectShadows;
+	RenderTechnique				mTechnique;
+	RenderTechnique				mTechniqueShadows;
+	RenderTechnique				mTechniqueShadowsInterleaved;
+	RenderTechnique				mTechniqueSceneDepth;
+	RenderTechnique				mTechniqueCube;
+	RenderTechnique				mTechniqueCubeFace;
+
+	RenderInputLayout			mVertexLayout;
+	RenderInputLayout			mPositionLayout;
+	bool						mPositionStreams;				// Depth passes use the position streams
+
+	D3DXMATRIX*					mMatrixWorld;
+	D3DXVECTOR3					mLightPosition;
+	const CascadedShadowMap*	mShadowMap;
+	ShadowEffectVariables		mShadowVariables;
+	const PointShadowMap*		mPointShadowMap;				// Used instead of the cascades when set
+	PointShadowEffectVariables	mPointShadowVariables;
+
+	AABB						mBounds;
+	float						mBoundingRadius;				// Radius around the object space origin
+	std::vector<float>			mCullCenters[3];
+	std::vector<float>			mCullRadii;
+	std::vector<unsigned char>	mCullVisible;
+	std::vector<D3DXVECTOR3>	mOccluderVertices;				// Triangle list of the largest triangles
+	std::vector<D3DXVECTOR3>	mTriangleVertices;				// Triangle list of all groups, in map order
+	std::vector<int>			mGroupTriangleEnds;				// One past each group's last triangle
+	TriangleBVH					mBVH;
+
+	RenderVariable mFXWorld;
+	RenderVariable mFXWorldViewProj;
+	RenderVariable mFXLightPos;
+	RenderVariable mFXEyePos;
+	RenderVariable mFXShadowWVP;
+	RenderVariable mFXShadowWorld;
+	RenderVariable mFXCubeViewProj;
+	RenderVariable mFXCubeFaceMask;
+
+	bool Load(std::string filename);
+	bool LoadMaterials(std::string filename);
+	void CreateTriangleList();
+	void CreateOccluder();
+	void DrawShadowGroups(bool castersOnly, DepthPassStatistics& statistics);
+	RenderTechnique GetReceiverTechnique() const;
+
+	HRESULT CreateVertexLayout();
+};
 #endif
\ No newline at end of file
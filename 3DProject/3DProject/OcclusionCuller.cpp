@@ -0,0 +1,434 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+
+#ifdef OCCLUSION_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const int C_TILE_SIZE = 32;				// The buffer size is rounded up to whole tiles
+	const int C_TEST_TEXELS = 4;			// Boxes are tested at the level where they cover at most 4x4 texels
+	const int C_DEFAULT_TRIANGLE_BUDGET = 4096;
+	const float C_MIN_W = 0.001f;
+
+	// Every box corner, as indices into the min/max of each axis
+	const int C_BOX_TRIANGLES[12][3][3] =
+	{
+		{ {0,0,0}, {0,1,0}, {1,1,0} }, { {0,0,0}, {1,1,0}, {1,0,0} },
+		{ {0,0,1}, {1,1,1}, {0,1,1} }, { {0,0,1}, {1,0,1}, {1,1,1} },
+		{ {0,0,0}, {0,0,1}, {0,1,1} }, { {0,0,0}, {0,1,1}, {0,1,0} },
+		{ {1,0,0}, {1,1,1}, {1,0,1} }, { {1,0,0}, {1,1,0}, {1,1,1} },
+		{ {0,0,0}, {1,0,0}, {1,0,1} }, { {0,0,0}, {1,0,1}, {0,0,1} },
+		{ {0,1,0}, {0,1,1}, {1,1,1} }, { {0,1,0}, {1,1,1}, {1,1,0} }
+	};
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+	: mTriangleBudget(C_DEFAULT_TRIANGLE_BUDGET), mRejectedTriangles(0)
+{
+	mWidth = (width + C_TILE_SIZE - 1) / C_TILE_SIZE * C_TILE_SIZE;
+	mHeight = (height + C_TILE_SIZE - 1) / C_TILE_SIZE * C_TILE_SIZE;
+	mTilesX = mWidth / C_TILE_SIZE;
+	mTilesY = mHeight / C_TILE_SIZE;
+	mTileBins.resize(mTilesX * mTilesY);
+
+	D3DXMatrixIdentity(&mViewProj);
+
+	int levelWidth = mWidth;
+	int levelHeight = mHeight;
+	while(true)
+	{
+		mLevelWidth.push_back(levelWidth);
+		mLevelHeight.push_back(levelHeight);
+		mMaxDepth.push_back(std::vector<float>(levelWidth * levelHeight, 1.0f));
+		mMinDepth.push_back(std::vector<float>(levelWidth * levelHeight, 1.0f));
+
+		if(levelWidth == 1 && levelHeight == 1)
+			break;
+
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
+
+// Clear the occluders of the last frame and set the camera they are seen from
+void OcclusionCuller::BeginFrame(const D3DXMATRIX& viewProj)
+{
+	mViewProj = viewProj;
+	mTriangles.clear();
+	mRejectedTriangles = 0;
+
+	for(size_t i = 0; i < mTileBins.size(); ++i)
+		mTileBins[i].clear();
+}
+
+// Add a triangle list in object space, returns the number of triangles that were kept. Triangles
+// crossing the near plane are dropped, which only makes the culling less aggressive.
+int OcclusionCuller::AddOccluder(const D3DXVECTOR3* vertices, int numVertices, const D3DXMATRIX& world)
+{
+	D3DXMATRIX worldViewProj = world * mViewProj;
+
+	int numAdded = 0;
+	for(int i = 0; i + 2 < numVertices; i += 3)
+	{
+		D3DXVECTOR4 clip[3];
+		for(int k = 0; k < 3; ++k)
+			D3DXVec3Transform(&clip[k], &vertices[i + k], &worldViewProj);
+
+		if(AddTriangle(clip[0], clip[1], clip[2]))
+			++numAdded;
+	}
+
+	return numAdded;
+}
+
+// Add the twelve triangles of a world space box
+int OcclusionCuller::AddOccluderBox(const AABB& box)
+{
+	D3DXVECTOR3 vertices[36];
+	for(int i = 0; i < 12; ++i)
+	{
+		for(int k = 0; k < 3; ++k)
+		{
+			const int* corner = C_BOX_TRIANGLES[i][k];
+			vertices[i * 3 + k] = D3DXVECTOR3(corner[0] ? box.Max.x : box.Min.x, corner[1] ? box.Max.y : box.Min.y,
+											  corner[2] ? box.Max.z : box.Min.z);
+		}
+	}
+
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+
+	return AddOccluder(vertices, 36, identity);
+}
+
+// Rasterize the binned triangles, one job per tile, and build the depth pyramid
+void OcclusionCuller::Rasterize(JobSystem* jobSystem)
+{
+	if(jobSystem != NULL)
+	{
+		JobCounter tilesDone;
+		jobSystem->ParallelFor(RasterizeTilesJob, this, mTilesX * mTilesY, 1, &tilesDone);
+		jobSystem->Wait(&tilesDone);
+	}
+	else
+		RasterizeTilesJob(this, 0, mTilesX * mTilesY);
+
+	BuildPyramid();
+}
+
+// Returns false if the box is certainly hidden behind the occluders
+bool OcclusionCuller::TestBox(const AABB& box) const
+{
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float minZ = FLT_MAX;
+
+	for(int i = 0; i < 8; ++i)
+	{
+		D3DXVECTOR3 corner((i & 1) ? box.Max.x : box.Min.x, (i & 2) ? box.Max.y : box.Min.y,
+						   (i & 4) ? box.Max.z : box.Min.z);
+		D3DXVECTOR4 clip;
+		D3DXVec3Transform(&clip, &corner, &mViewProj);
+
+		// Boxes reaching behind the near plane are always visible
+		if(clip.w < C_MIN_W)
+			return true;
+
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * mWidth;
+		float y = (0.5f - clip.y * invW * 0.5f) * mHeight;
+		float z = clip.z * invW;
+
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minZ = std::min(minZ, z);
+	}
+
+	if(minZ <= 0.0f)
+		return true;
+
+	int x0 = std::max(0, (int)floor(minX));
+	int y0 = std::max(0, (int)floor(minY));
+	int x1 = std::min(mWidth - 1, (int)floor(maxX));
+	int y1 = std::min(mHeight - 1, (int)floor(maxY));
+
+	// Outside of the screen, that is for the frustum culling to decide
+	if(x0 > x1 || y0 > y1)
+		return true;
+
+	int lastLevel = (int)mLevelWidth.size() - 1;
+	int level = 0;
+	while(level < lastLevel && ((x1 >> level) - (x0 >> level) >= C_TEST_TEXELS ||
+								(y1 >> level) - (y0 >> level) >= C_TEST_TEXELS))
+		++level;
+
+	// Quick accept: the box is nearer than everything drawn in the texels it covers
+	int coarseLevel = std::min(level + 1, lastLevel);
+	const std::vector<float>& minDepth = mMinDepth[coarseLevel];
+	float nearestOccluder = 1.0f;
+	for(int ty = y0 >> coarseLevel; ty <= y1 >> coarseLevel; ++ty)
+		for(int tx = x0 >> coarseLevel; tx <= x1 >> coarseLevel; ++tx)
+			nearestOccluder = std::min(nearestOccluder, minDepth[ty * mLevelWidth[coarseLevel] + tx]);
+
+	if(minZ < nearestOccluder)
+		return true;
+
+	const std::vector<float>& maxDepth = mMaxDepth[level];
+	for(int ty = y0 >> level; ty <= y1 >> level; ++ty)
+	{
+		for(int tx = x0 >> level; tx <= x1 >> level; ++tx)
+		{
+			if(minZ <= maxDepth[ty * mLevelWidth[level] + tx])
+				return true;
+		}
+	}
+
+	return false;
+}
+
+bool OcclusionCuller::TestSphere(const BoundingSphere& sphere) const
+{
+	D3DXVECTOR3 radius(sphere.Radius, sphere.Radius, sphere.Radius);
+	return TestBox(AABB(sphere.Center - radius, sphere.Center + radius));
+}
+
+// Limit the number of occluder triangles rasterized per frame, the rest are dropped
+void OcclusionCuller::SetTriangleBudget(int numTriangles)
+{
+	mTriangleBudget = numTriangles;
+}
+
+int OcclusionCuller::GetTriangleCount() const
+{
+	return (int)mTriangles.size();
+}
+
+int OcclusionCuller::GetRejectedTriangleCount() const
+{
+	return mRejectedTriangles;
+}
+
+int OcclusionCuller::GetWidth() const
+{
+	return mWidth;
+}
+
+int OcclusionCuller::GetHeight() const
+{
+	return mHeight;
+}
+
+const float* OcclusionCuller::GetDepthBuffer() const
+{
+	return &mMaxDepth[0][0];
+}
+
+void OcclusionCuller::RasterizeTilesJob(void* data, int first, int count)
+{
+	OcclusionCuller* culler = static_cast<OcclusionCuller*>(data);
+	for(int i = first; i < first + count; ++i)
+		culler->RasterizeTile(i);
+}
+
+// Project the triangle to the screen and put it in the bins of the tiles its bounding rectangle touches
+bool OcclusionCuller::AddTriangle(const D3DXVECTOR4& a, const D3DXVECTOR4& b, const D3DXVECTOR4& c)
+{
+	if((int)mTriangles.size() >= mTriangleBudget)
+	{
+		++mRejectedTriangles;
+		return false;
+	}
+
+	const D3DXVECTOR4* clip[3] = { &a, &b, &c };
+	ScreenTriangle triangle;
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+	for(int k = 0; k < 3; ++k)
+	{
+		if(clip[k]->w < C_MIN_W || clip[k]->z < 0.0f)
+			return false;
+
+		float invW = 1.0f / clip[k]->w;
+		triangle.X[k] = (clip[k]->x * invW * 0.5f + 0.5f) * mWidth;
+		triangle.Y[k] = (0.5f - clip[k]->y * invW * 0.5f) * mHeight;
+		triangle.Z[k] = clip[k]->z * invW;
+
+		minX = std::min(minX, triangle.X[k]);
+		maxX = std::max(maxX, triangle.X[k]);
+		minY = std::min(minY, triangle.Y[k]);
+		maxY = std::max(maxY, triangle.Y[k]);
+	}
+
+	// Only pixel centers are sampled, so the rectangle covers the centers inside the bounds
+	triangle.MinX = std::max(0, (int)ceil(minX - 0.5f));
+	triangle.MinY = std::max(0, (int)ceil(minY - 0.5f));
+	triangle.MaxX = std::min(mWidth - 1, (int)floor(maxX - 0.5f));
+	triangle.MaxY = std::min(mHeight - 1, (int)floor(maxY - 0.5f));
+
+	if(triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+		return false;
+
+	int index = (int)mTriangles.size();
+	mTriangles.push_back(triangle);
+
+	for(int ty = triangle.MinY / C_TILE_SIZE; ty <= triangle.MaxY / C_TILE_SIZE; ++ty)
+		for(int tx = triangle.MinX / C_TILE_SIZE; tx <= triangle.MaxX / C_TILE_SIZE; ++tx)
+			mTileBins[ty * mTilesX + tx].push_back(index);
+
+	return true;
+}
+
+void OcclusionCuller::RasterizeTile(int tile)
+{
+	int tileX = (tile % mTilesX) * C_TILE_SIZE;
+	int tileY = (tile / mTilesX) * C_TILE_SIZE;
+
+	std::vector<float>& depth = mMaxDepth[0];
+	for(int y = tileY; y < tileY + C_TILE_SIZE; ++y)
+		std::fill(depth.begin() + y * mWidth + tileX, depth.begin() + y * mWidth + tileX + C_TILE_SIZE, 1.0f);
+
+	const std::vector<int>& bin = mTileBins[tile];
+	for(size_t i = 0; i < bin.size(); ++i)
+	{
+		const ScreenTriangle& triangle = mTriangles[bin[i]];
+		RasterizeTriangle(triangle, std::max(triangle.MinX, tileX), std::max(triangle.MinY, tileY),
+						  std::min(triangle.MaxX, tileX + C_TILE_SIZE - 1), std::min(triangle.MaxY, tileY + C_TILE_SIZE - 1));
+	}
+}
+
+// Rasterize the part of a triangle inside [minX, maxX] x [minY, maxY] with edge functions. Both
+// windings are accepted, occluders do not need to be closed or consistently wound.
+void OcclusionCuller::RasterizeTriangle(const ScreenTriangle& triangle, int minX, int minY, int maxX, int maxY)
+{
+	float x[3] = { triangle.X[0], triangle.X[1], triangle.X[2] };
+	float y[3] = { triangle.Y[0], triangle.Y[1], triangle.Y[2] };
+	float z[3] = { triangle.Z[0], triangle.Z[1], triangle.Z[2] };
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if(area == 0.0f)
+		return;
+
+	if(area < 0.0f)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+
+	// Edge i is the one opposite vertex i, e(px, py) = A * px + B * py + C is positive inside
+	float edgeA[3], edgeB[3], edgeC[3];
+	for(int i = 0; i < 3; ++i)
+	{
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		edgeA[i] = y[from] - y[to];
+		edgeB[i] = x[to] - x[from];
+		edgeC[i] = -(edgeA[i] * x[from] + edgeB[i] * y[from]);
+	}
+
+	// Depth is linear in screen space: z = zA * px + zB * py + zC
+	float invArea = 1.0f / area;
+	float zA = (edgeA[0] * z[0] + edgeA[1] * z[1] + edgeA[2] * z[2]) * invArea;
+	float zB = (edgeB[0] * z[0] + edgeB[1] * z[1] + edgeB[2] * z[2]) * invArea;
+	float zC = (edgeC[0] * z[0] + edgeC[1] * z[1] + edgeC[2] * z[2]) * invArea;
+
+	float* depth = &mMaxDepth[0][0];
+
+#ifdef OCCLUSION_CULLER_SSE
+	// Start at a multiple of four, tiles are aligned to four pixels so no lane leaves the tile
+	int startX = minX & ~3;
+	__m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	__m128 zero = _mm_setzero_ps();
+
+	for(int py = minY; py <= maxY; ++py)
+	{
+		float centerY = py + 0.5f;
+		__m128 px = _mm_add_ps(_mm_set1_ps((float)startX), laneOffsets);
+
+		__m128 e0 = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(edgeA[0])), _mm_set1_ps(edgeB[0] * centerY + edgeC[0]));
+		__m128 e1 = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(edgeA[1])), _mm_set1_ps(edgeB[1] * centerY + edgeC[1]));
+		__m128 e2 = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(edgeA[2])), _mm_set1_ps(edgeB[2] * centerY + edgeC[2]));
+		__m128 zRow = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(zA)), _mm_set1_ps(zB * centerY + zC));
+
+		__m128 e0Step = _mm_set1_ps(edgeA[0] * 4.0f);
+		__m128 e1Step = _mm_set1_ps(edgeA[1] * 4.0f);
+		__m128 e2Step = _mm_set1_ps(edgeA[2] * 4.0f);
+		__m128 zStep = _mm_set1_ps(zA * 4.0f);
+
+		float* row = depth + py * mWidth;
+		for(int px4 = startX; px4 <= maxX; px4 += 4)
+		{
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+
+			if(_mm_movemask_ps(inside) != 0)
+			{
+				__m128 current = _mm_loadu_ps(row + px4);
+				__m128 nearer = _mm_min_ps(current, zRow);
+				_mm_storeu_ps(row + px4, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+			}
+
+			e0 = _mm_add_ps(e0, e0Step);
+			e1 = _mm_add_ps(e1, e1Step);
+			e2 = _mm_add_ps(e2, e2Step);
+			zRow = _mm_add_ps(zRow, zStep);
+		}
+	}
+#else
+	for(int py = minY; py <= maxY; ++py)
+	{
+		float centerY = py + 0.5f;
+		float* row = depth + py * mWidth;
+
+		for(int px = minX; px <= maxX; ++px)
+		{
+			float centerX = px + 0.5f;
+			if(edgeA[0] * centerX + edgeB[0] * centerY + edgeC[0] < 0.0f ||
+			   edgeA[1] * centerX + edgeB[1] * centerY + edgeC[1] < 0.0f ||
+			   edgeA[2] * centerX + edgeB[2] * centerY + edgeC[2] < 0.0f)
+				continue;
+
+			float pixelZ = zA * centerX + zB * centerY + zC;
+			if(pixelZ < row[px])
+				row[px] = pixelZ;
+		}
+	}
+#endif
+}
+
+// Every texel of a level gets the min and max of the (up to) four texels below it
+void OcclusionCuller::BuildPyramid()
+{
+	mMinDepth[0] = mMaxDepth[0];
+
+	for(size_t level = 1; level < mLevelWidth.size(); ++level)
+	{
+		const std::vector<float>& finerMax = mMaxDepth[level - 1];
+		const std::vector<float>& finerMin = mMinDepth[level - 1];
+		int finerWidth = mLevelWidth[level - 1];
+		int finerHeight = mLevelHeight[level - 1];
+
+		for(int y = 0; y < mLevelHeight[level]; ++y)
+		{
+			int y0 = y * 2;
+			int y1 = std::min(y0 + 1, finerHeight - 1);
+
+			for(int x = 0; x < mLevelWidth[level]; ++x)
+			{
+				int x0 = x * 2;
+				int x1 = std::min(x0 + 1, finerWidth - 1);
+
+				float maxValue = std::max(std::max(finerMax[y0 * finerWidth + x0], finerMax[y0 * finerWidth + x1]),
+										  std::max(finerMax[y1 * finerWidth + x0], finerMax[y1 * finerWidth + x1]));
+				float minValue = std::min(std::min(finerMin[y0 * finerWidth + x0], finerMin[y0 * finerWidth + x1]),
+										  std::min(finerMin[y1 * finerWidth + x0], finerMin[y1 * finerWidth + x1]));
+
+				mMaxDepth[level][y * mLevelWidth[level] + x] = maxValue;
+				mMinDepth[level][y * mLevelWidth[level] + x] = minValue;
+			}
+		}
+	}
+}
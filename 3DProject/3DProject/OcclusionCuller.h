@@ -0,0 +1,78 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <vector>
+#include <D3DX10.h>
+
+#include "BoundingVolumes.h"
+#include "JobSystem.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define OCCLUSION_CULLER_SSE
+#endif
+
+// Software occlusion culling. Occluder triangles are rasterized into a small depth buffer, split into
+// tiles that are rasterized in parallel, four pixels at a time. From the depth buffer a pyramid is
+// built where every texel holds the nearest (min) and the farthest (max) depth of the texels below it.
+// Occludees are tested by projecting their boxes and comparing the nearest depth of the box with the
+// farthest occluder depth in the covered texels, at a level where the box covers only a few texels.
+//
+// Occluders must lie inside the objects they stand for, otherwise visible objects can be culled.
+// Depths are D3D post-projection depths, 0 at the near plane and 1 at the far plane.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(int width = 256, int height = 128);
+
+	void BeginFrame(const D3DXMATRIX& viewProj);
+	int AddOccluder(const D3DXVECTOR3* vertices, int numVertices, const D3DXMATRIX& world);
+	int AddOccluderBox(const AABB& box);
+	void Rasterize(JobSystem* jobSystem);
+
+	bool TestBox(const AABB& box) const;
+	bool TestSphere(const BoundingSphere& sphere) const;
+
+	void SetTriangleBudget(int numTriangles);
+	int GetTriangleCount() const;
+	int GetRejectedTriangleCount() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	const float* GetDepthBuffer() const;
+
+private:
+	struct ScreenTriangle
+	{
+		float				X[3];
+		float				Y[3];
+		float				Z[3];
+		int					MinX;
+		int					MinY;
+		int					MaxX;
+		int					MaxY;
+	};
+
+	int										mWidth;
+	int										mHeight;
+	int										mTilesX;
+	int										mTilesY;
+	D3DXMATRIX								mViewProj;
+
+	std::vector<ScreenTriangle>				mTriangles;
+	std::vector<std::vector<int> >			mTileBins;
+	int										mTriangleBudget;
+	int										mRejectedTriangles;		// Triangles over the budget this frame
+
+	// Level 0 is the depth buffer itself
+	std::vector<std::vector<float> >		mMaxDepth;
+	std::vector<std::vector<float> >		mMinDepth;
+	std::vector<int>						mLevelWidth;
+	std::vector<int>						mLevelHeight;
+
+	static void RasterizeTilesJob(void* data, int first, int count);
+
+	bool AddTriangle(const D3DXVECTOR4& a, const D3DXVECTOR4& b, const D3DXVECTOR4& c);
+	void RasterizeTile(int tile);
+	void RasterizeTriangle(const ScreenTriangle& triangle, int minX, int minY, int maxX, int maxY);
+	void BuildPyramid();
+};
+#endif
@@ -0,0 +1,81 @@
+#include "PipelineStatisticsQuery.h"
+
+PipelineStatisticsQuery::PipelineStatisticsQuery()
+	: mDevice(NULL), mCurrent(0), mMeasuring(false)
+{
+	ZeroMemory(mFrames, sizeof(mFrames));
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+PipelineStatisticsQuery::~PipelineStatisticsQuery()
+{
+	if(mDevice == NULL)
+		return;
+
+	for(int i = 0; i < C_FRAMES; ++i)
+		mDevice->ReleaseQuery(mFrames[i].Query);
+}
+
+void PipelineStatisticsQuery::Initialize(RenderDevice* device)
+{
+	mDevice = device;
+
+	for(int i = 0; i < C_FRAMES; ++i)
+	{
+		mFrames[i].Query = mDevice->CreateQuery(RenderQueryPipelineStatistics);
+		if(mFrames[i].Query == NULL)
+		{
+			MessageBox(0, "Error Creating Pipeline Statistics Queries", "", 0);
+			return;
+		}
+	}
+}
+
+// Start counting, unless the GPU has not yet finished the frame that last used this query
+void PipelineStatisticsQuery::Begin()
+{
+	ReadResults();
+
+	Frame& frame = mFrames[mCurrent];
+	mMeasuring = frame.Query != NULL && !frame.Pending;
+	if(!mMeasuring)
+		return;
+
+	mDevice->BeginQuery(frame.Query);
+}
+
+void PipelineStatisticsQuery::End()
+{
+	if(!mMeasuring)
+		return;
+
+	Frame& frame = mFrames[mCurrent];
+	mDevice->EndQuery(frame.Query);
+	frame.Pending = true;
+
+	mCurrent = (mCurrent + 1) % C_FRAMES;
+	mMeasuring = false;
+}
+
+const RenderPipelineStatistics& PipelineStatisticsQuery::GetStatistics() const
+{
+	return mStatistics;
+}
+
+// Read the frames the GPU has finished, oldest first so the newest counts are kept
+void PipelineStatisticsQuery::ReadResults()
+{
+	for(int i = 0; i < C_FRAMES; ++i)
+	{
+		Frame& frame = mFrames[(mCurrent + i) % C_FRAMES];
+		if(!frame.Pending)
+			continue;
+
+		RenderPipelineStatistics statistics;
+		if(!mDevice->GetPipelineStatistics(frame.Query, statistics))
+			continue;
+
+		mStatistics = statistics;
+		frame.Pending = false;
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef PIPELINE_STATISTICS_QUERY_H
+#define PIPELINE_STATISTICS_QUERY_H
+
+#include "RenderDevice.h"
+
+// What the pipeline did with the commands between Begin and End: vertices read and shaded,
+// primitives sent to and left after the rasterizer. Read back like GpuTimer, a few frames late
+// and without waiting for the GPU.
+class PipelineStatisticsQuery
+{
+public:
+	PipelineStatisticsQuery();
+	~PipelineStatisticsQuery();
+	void Initialize(RenderDevice* device);
+	void Begin();
+	void End();
+
+	const RenderPipelineStatistics& GetStatistics() const;
+
+private:
+	struct Frame
+	{
+		RenderQuery				Query;
+		bool					Pending;			// Issued but not read back yet
+	};
+
+	static const int			C_FRAMES = 4;
+
+	RenderDevice*							mDevice;
+	Frame									mFrames[C_FRAMES];
+	int										mCurrent;
+	bool									mMeasuring;
+	RenderPipelineStatistics				mStatistics;
+
+	PipelineStatisticsQuery(const PipelineStatisticsQuery&);
+	PipelineStatisticsQuery& operator=(const PipelineStatisticsQuery&);
+
+	void ReadResults();
+};
+#endif
@@ -0,0 +1,193 @@
+#include "PointShadowMap.h"
+
+namespace
+{
+	// Where each face looks and its up vector, in the order of the cube's slices
+	const D3DXVECTOR3 C_FACE_DIRECTIONS[] = { D3DXVECTOR3(1.0f, 0.0f, 0.0f), D3DXVECTOR3(-1.0f, 0.0f, 0.0f),
+											  D3DXVECTOR3(0.0f, 1.0f, 0.0f), D3DXVECTOR3(0.0f, -1.0f, 0.0f),
+											  D3DXVECTOR3(0.0f, 0.0f, 1.0f), D3DXVECTOR3(0.0f, 0.0f, -1.0f) };
+	const D3DXVECTOR3 C_FACE_UPS[] = { D3DXVECTOR3(0.0f, 1.0f, 0.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f),
+									   D3DXVECTOR3(0.0f, 0.0f, -1.0f), D3DXVECTOR3(0.0f, 0.0f, 1.0f),
+									   D3DXVECTOR3(0.0f, 1.0f, 0.0f), D3DXVECTOR3(0.0f, 1.0f, 0.0f) };
+}
+
+PointShadowMap::PointShadowMap()
+	: mDevice(NULL), mTexture(NULL), mSRV(NULL), mCubeDSV(NULL), mSize(0), mPosition(0.0f, 0.0f, 0.0f),
+	  mNearDistance(1.0f), mFarDistance(2.0f)
+{
+	for(int i = 0; i < FaceCount; ++i)
+	{
+		mFaceDSV[i] = NULL;
+		D3DXMatrixIdentity(&mViewProjection[i]);
+	}
+
+	ZeroMemory(&mViewport, sizeof(RenderViewport));
+	mViewport.MaxDepth = 1.0f;
+}
+
+PointShadowMap::~PointShadowMap()
+{
+	ReleaseTexture();
+}
+
+// A typeless cube, written through depth stencil views and read as a cube of floats
+void PointShadowMap::Initialize(RenderDevice* device, int size)
+{
+	mDevice = device;
+	mSize = size;
+	mViewport.Width = size;
+	mViewport.Height = size;
+
+	RenderTextureDesc textureDesc(size, size, FaceCount, RenderFormatR32Typeless,
+								  RenderBindDepthStencil | RenderBindShaderResource, RenderUsageDefault, 1, true);
+	mTexture = mDevice->CreateTexture(textureDesc, NULL, 0);
+	if(mTexture == NULL)
+	{
+		MessageBox(0, "Texture creation failed: Point shadow map!", "ERROR", 0);
+		return;
+	}
+
+	mSRV = mDevice->CreateShaderView(mTexture, RenderViewTextureCube);
+	mCubeDSV = mDevice->CreateDepthView(mTexture, 0, FaceCount);
+	for(int i = 0; i < FaceCount; ++i)
+		mFaceDSV[i] = mDevice->CreateDepthView(mTexture, i, 1);
+}
+
+// Point every face's frustum out from the light
+void PointShadowMap::SetLight(const D3DXVECTOR3& position, float nearDistance, float farDistance)
+{
+	mPosition = position;
+	mNearDistance = nearDistance;
+	mFarDistance = farDistance;
+
+	D3DXMATRIX projection;
+	D3DXMatrixPerspectiveFovLH(&projection, (float)D3DX_PI * 0.5f, 1.0f, nearDistance, farDistance);
+
+	for(int i = 0; i < FaceCount; ++i)
+	{
+		D3DXVECTOR3 target = position + C_FACE_DIRECTIONS[i];
+		D3DXMATRIX view;
+		D3DXMatrixLookAtLH(&view, &position, &target, &C_FACE_UPS[i]);
+
+		mViewProjection[i] = view * projection;
+		mFrustumPlanes[i].Extract(mViewProjection[i]);
+	}
+}
+
+// One bit per face whose frustum the bounds may reach into
+int PointShadowMap::GetFaceMask(const AABB& worldBounds) const
+{
+	int mask = 0;
+	for(int i = 0; i < FaceCount; ++i)
+	{
+		if(mFrustumPlanes[i].TestBox(worldBounds))
+			mask |= 1 << i;
+	}
+
+	return mask;
+}
+
+// Bind every face for the geometry shader and clear them all
+void PointShadowMap::BeginCube()
+{
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, mCubeDSV);
+	mDevice->SetViewport(mViewport);
+
+	if(mCubeDSV != NULL)
+		mDevice->ClearDepthStencil(mCubeDSV);
+}
+
+// Bind and clear a single face
+void PointShadowMap::BeginFace(int face)
+{
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, mFaceDSV[face]);
+	mDevice->SetViewport(mViewport);
+
+	if(mFaceDSV[face] != NULL)
+		mDevice->ClearDepthStencil(mFaceDSV[face]);
+}
+
+const D3DXVECTOR3& PointShadowMap::GetPosition() const
+{
+	return mPosition;
+}
+
+const D3DXMATRIX& PointShadowMap::GetViewProjectionMatrix(int face) const
+{
+	return mViewProjection[face];
+}
+
+const FrustumPlanes& PointShadowMap::GetFrustumPlanes(int face) const
+{
+	return mFrustumPlanes[face];
+}
+
+// The projection's depth as a function of the distance along a face's axis, x + y / distance
+D3DXVECTOR2 PointShadowMap::GetDepthParameters() const
+{
+	float range = mFarDistance - mNearDistance;
+	return D3DXVECTOR2(mFarDistance / range, -mFarDistance * mNearDistance / range);
+}
+
+RenderShaderView PointShadowMap::GetSRV() const
+{
+	return mSRV;
+}
+
+int PointShadowMap::GetSize() const
+{
+	return mSize;
+}
+
+void PointShadowMap::ReleaseTexture()
+{
+	if(mDevice == NULL)
+		return;
+
+	for(int i = 0; i < FaceCount; ++i)
+		mDevice->ReleaseDepthView(mFaceDSV[i]);
+	mDevice->ReleaseDepthView(mCubeDSV);
+	mDevice->ReleaseShaderView(mSRV);
+	mDevice->ReleaseTexture(mTexture);
+}
+
+PointShadowEffectVariables::PointShadowEffectVariables()
+	: mDevice(0), mTechnique(0), mfxShadowMap(0), mfxLightPosition(0), mfxDepthParams(0)
+{
+}
+
+void PointShadowEffectVariables::Initialize(RenderDevice* device, RenderEffect effect)
+{
+	mDevice = device;
+	mTechnique = mDevice->GetTechnique(effect, "DrawPointShadowTechnique");
+	mfxShadowMap = mDevice->GetVariable(effect, "gPointShadowMap");
+	mfxLightPosition = mDevice->GetVariable(effect, "gPointLightPosition");
+	mfxDepthParams = mDevice->GetVariable(effect, "gPointDepthParams");
+}
+
+void PointShadowEffectVariables::Set(const PointShadowMap* shadowMap)
+{
+	if(shadowMap == NULL)
+	{
+		mDevice->SetShaderView(mfxShadowMap, NULL);
+		return;
+	}
+
+	D3DXVECTOR2 depthParams = shadowMap->GetDepthParameters();
+	mDevice->SetShaderView(mfxShadowMap, shadowMap->GetSRV());
+	mDevice->SetFloatVector(mfxLightPosition, (const float*)&shadowMap->GetPosition());
+	mDevice->SetFloatVector(mfxDepthParams, (const float*)&depthParams);
+}
+
+// Unbind the cube, so it can be drawn to again
+void PointShadowEffectVariables::Clear()
+{
+	mDevice->SetShaderView(mfxShadowMap, NULL);
+}
+
+RenderTechnique PointShadowEffectVariables::GetTechnique() const
+{
+	return mTechnique;
+}
@@ -0,0 +1,76 @@
+#ifndef POINT_SHADOW_MAP_H
+#define POINT_SHADOW_MAP_H
+
+#include <D3DX10.h>
+#include "Globals.h"
+#include "RenderDevice.h"
+#include "BoundingVolumes.h"
+#include "FrustumPlanes.h"
+
+// The shadows of a point light, a depth cube around it with a 90 degree perspective projection per
+// face. The faces can be drawn all at once with a geometry shader that picks each triangle's slices,
+// or one at a time. The texture is made here, the render target pool has no cube textures.
+class PointShadowMap
+{
+public:
+	enum Face
+	{
+		PositiveX, NegativeX, PositiveY, NegativeY, PositiveZ, NegativeZ, FaceCount
+	};
+
+	PointShadowMap();
+	~PointShadowMap();
+	void Initialize(RenderDevice* device, int size);
+	void SetLight(const D3DXVECTOR3& position, float nearDistance, float farDistance);
+	int GetFaceMask(const AABB& worldBounds) const;
+	void BeginCube();
+	void BeginFace(int face);
+
+	const D3DXVECTOR3& GetPosition() const;
+	const D3DXMATRIX& GetViewProjectionMatrix(int face) const;
+	const FrustumPlanes& GetFrustumPlanes(int face) const;
+	D3DXVECTOR2 GetDepthParameters() const;
+	RenderShaderView GetSRV() const;
+	int GetSize() const;
+
+	static const int C_ALL_FACES = (1 << FaceCount) - 1;
+
+private:
+	RenderDevice*							mDevice;
+	RenderTexture							mTexture;
+	RenderShaderView						mSRV;
+	RenderDepthView							mCubeDSV;				// Every face, for the geometry shader
+	RenderDepthView							mFaceDSV[FaceCount];
+	RenderViewport							mViewport;
+	int										mSize;
+
+	D3DXVECTOR3								mPosition;
+	float									mNearDistance;
+	float									mFarDistance;
+	D3DXMATRIX								mViewProjection[FaceCount];
+	FrustumPlanes							mFrustumPlanes[FaceCount];
+
+	PointShadowMap(const PointShadowMap&);
+	PointShadowMap& operator=(const PointShadowMap&);
+
+	void ReleaseTexture();
+};
+
+// The cube variables of an effect that receives a point light's shadow
+class PointShadowEffectVariables
+{
+public:
+	PointShadowEffectVariables();
+	void Initialize(RenderDevice* device, RenderEffect effect);
+	void Set(const PointShadowMap* shadowMap);
+	void Clear();
+	RenderTechnique GetTechnique() const;
+
+private:
+	RenderDevice*							mDevice;
+	RenderTechnique							mTechnique;
+	RenderVariable							mfxShadowMap;
+	RenderVariable							mfxLightPosition;
+	RenderVariable							mfxDepthParams;
+};
+#endif
@@ -0,0 +1,34 @@
+#include "RenderDevice.h"
+
+const RenderBuffer RenderDevice::C_NO_BUFFER = -1;
+
+namespace
+{
+	int GetBytesPerTexel(RenderFormat format)
+	{
+		switch(format)
+		{
+		case RenderFormatR32G32B32A32Float:		return 16;
+		case RenderFormatR32G32B32Float:		return 12;
+		case RenderFormatR16G16B16A16Float:
+		case RenderFormatR32G32Float:			return 8;
+		case RenderFormatR16Typeless:
+		case RenderFormatR16Uint:
+		case RenderFormatR8G8Unorm:				return 2;
+		case RenderFormatR8Unorm:				return 1;
+		default:								return 4;
+		}
+	}
+}
+
+int GetTextureBytes(const RenderTextureDesc& desc)
+{
+	int bytes = desc.Width * desc.Height * desc.ArraySize * GetBytesPerTexel(desc.Format);
+	if(desc.MipLevels != 1)
+		bytes += bytes / 3;
+	return bytes;
+}
+
+RenderDevice::~RenderDevice()
+{
+}
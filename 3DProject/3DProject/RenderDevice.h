@@ -0,0 +1,216 @@
+#ifndef RENDER_DEVICE_H
+#define RENDER_DEVICE_H
+
+#include <Windows.h>
+#include "Globals.h"
+
+// A buffer made by a render device, an index into the device's own table
+typedef int RenderBuffer;
+
+// Everything else a render device makes is a pointer to a type only that device knows, NULL is none.
+// Techniques, passes and variables belong to their effect and are never released on their own.
+typedef struct RenderEffectObject*			RenderEffect;
+typedef struct RenderTechniqueObject*		RenderTechnique;
+typedef struct RenderPassObject*			RenderPass;
+typedef struct RenderVariableObject*		RenderVariable;
+typedef struct RenderTextureObject*			RenderTexture;
+typedef struct RenderShaderViewObject*		RenderShaderView;
+typedef struct RenderTargetViewObject*		RenderTargetView;
+typedef struct RenderDepthViewObject*		RenderDepthView;
+typedef struct RenderInputLayoutObject*		RenderInputLayout;
+typedef struct RenderQueryObject*			RenderQuery;
+
+// The typeless formats are depth textures that are also read, their views pick the depth or colour format
+enum RenderFormat
+{
+	RenderFormatUnknown,
+	RenderFormatR32Float,
+	RenderFormatR32G32Float,
+	RenderFormatR32G32B32Float,
+	RenderFormatR32G32B32A32Float,
+	RenderFormatR16G16B16A16Float,
+	RenderFormatR8Unorm,
+	RenderFormatR8G8Unorm,
+	RenderFormatR8G8B8A8Unorm,
+	RenderFormatR16Uint,
+	RenderFormatR32Uint,
+	RenderFormatR32Typeless,
+	RenderFormatR24G8Typeless,
+	RenderFormatR16Typeless
+};
+
+// What a buffer or texture may be bound as, or-ed together
+enum RenderBind
+{
+	RenderBindVertexBuffer	= 1,
+	RenderBindIndexBuffer	= 2,
+	RenderBindShaderResource	= 4,
+	RenderBindRenderTarget	= 8,
+	RenderBindDepthStencil	= 16
+};
+
+enum RenderUsage
+{
+	RenderUsageDefault,						// Written by the GPU
+	RenderUsageImmutable,					// Given its contents when it is made
+	RenderUsageDynamic,						// Written by the CPU, all of it at once
+	RenderUsageReadback						// Read by the CPU
+};
+
+enum RenderTopology
+{
+	RenderTopologyUndefined,
+	RenderTopologyPointList,
+	RenderTopologyTriangleList,
+	RenderTopologyTriangleStrip
+};
+
+// How a shader view sees every mip and slice of its texture
+enum RenderViewType
+{
+	RenderViewTexture2D,
+	RenderViewTexture2DArray,
+	RenderViewTextureCube
+};
+
+enum RenderQueryType
+{
+	RenderQueryTimestamp,
+	RenderQueryTimestampDisjoint,			// Begun and ended around timestamps, gives their frequency
+	RenderQueryPipelineStatistics
+};
+
+struct RenderBufferDesc
+{
+	int						Bytes;
+	UINT					BindFlags;
+	RenderUsage				Usage;
+
+	RenderBufferDesc(int bytes, UINT bindFlags, RenderUsage usage)
+		: Bytes(bytes), BindFlags(bindFlags), Usage(usage) {}
+};
+
+// Render targets with more than one mip have them filled by GenerateMips
+struct RenderTextureDesc
+{
+	int						Width;
+	int						Height;
+	int						ArraySize;				// 6 for a cube
+	int						MipLevels;				// 0 is a full chain
+	RenderFormat			Format;
+	UINT					BindFlags;
+	RenderUsage				Usage;
+	bool					Cube;
+
+	RenderTextureDesc(int width, int height, int arraySize, RenderFormat format, UINT bindFlags,
+					  RenderUsage usage = RenderUsageDefault, int mipLevels = 1, bool cube = false)
+		: Width(width), Height(height), ArraySize(arraySize), MipLevels(mipLevels), Format(format),
+		  BindFlags(bindFlags), Usage(usage), Cube(cube) {}
+};
+
+// The memory a texture takes, a mip chain adds a third of the top level
+int GetTextureBytes(const RenderTextureDesc& desc);
+
+// One element of a vertex, every vertex format in the program is a single stream
+struct RenderVertexElement
+{
+	const char*				Semantic;
+	int						SemanticIndex;
+	RenderFormat			Format;
+	int						Offset;					// Bytes from the start of the vertex
+};
+
+struct RenderViewport
+{
+	INT						TopLeftX;
+	INT						TopLeftY;
+	UINT					Width;
+	UINT					Height;
+	FLOAT					MinDepth;
+	FLOAT					MaxDepth;
+};
+
+struct RenderPipelineStatistics
+{
+	UINT64					IAVertices;
+	UINT64					IAPrimitives;
+	UINT64					VSInvocations;
+	UINT64					GSInvocations;
+	UINT64					GSPrimitives;
+	UINT64					CInvocations;
+	UINT64					CPrimitives;
+	UINT64					PSInvocations;
+};
+
+// Everything the frame is made and drawn with: buffers, textures and their views, effects, input
+// layouts, queries, input assembly, targets and draws. Nothing outside a device sees the API it
+// draws with.
+class RenderDevice
+{
+public:
+	static const RenderBuffer		C_NO_BUFFER;
+	static const int				C_MAX_RENDER_TARGETS = 8;
+
+	virtual ~RenderDevice();
+	virtual void BeginFrame() = 0;
+
+	virtual RenderBuffer CreateBuffer(const RenderBufferDesc& desc, const void* data) = 0;
+	virtual void ReleaseBuffer(RenderBuffer buffer) = 0;
+	virtual void UpdateBuffer(RenderBuffer buffer, const void* data, int bytes) = 0;
+
+	virtual RenderTexture CreateTexture(const RenderTextureDesc& desc, const void* data, int rowBytes) = 0;
+	virtual void ReleaseTexture(RenderTexture texture) = 0;
+	virtual void UpdateTexture(RenderTexture texture, const void* data, int rowBytes, int rows) = 0;
+	virtual void CopyTexture(RenderTexture destination, RenderTexture source) = 0;
+	virtual RenderShaderView LoadTexture(const char* filename) = 0;
+	virtual RenderShaderView CreateShaderView(RenderTexture texture, RenderViewType type) = 0;
+	virtual RenderTargetView CreateRenderTargetView(RenderTexture texture, int firstSlice, int numSlices) = 0;
+	virtual RenderDepthView CreateDepthView(RenderTexture texture, int firstSlice, int numSlices) = 0;
+	virtual void ReleaseShaderView(RenderShaderView view) = 0;
+	virtual void ReleaseRenderTargetView(RenderTargetView view) = 0;
+	virtual void ReleaseDepthView(RenderDepthView view) = 0;
+	virtual void GenerateMips(RenderShaderView view) = 0;
+	virtual RenderTargetView GetBackBuffer() = 0;
+	virtual RenderDepthView GetBackBufferDepth() = 0;
+
+	virtual RenderEffect CreateEffect(const char* filename) = 0;
+	virtual void ReleaseEffect(RenderEffect effect) = 0;
+	virtual RenderTechnique GetTechnique(RenderEffect effect, const char* name) = 0;
+	virtual int GetPassCount(RenderTechnique technique) = 0;
+	virtual RenderPass GetPass(RenderTechnique technique, int index) = 0;
+	virtual RenderVariable GetVariable(RenderEffect effect, const char* name) = 0;
+	virtual void SetMatrix(RenderVariable variable, const float* matrix) = 0;
+	virtual void SetMatrixArray(RenderVariable variable, const float* matrices, int first, int count) = 0;
+	virtual void SetFloatVector(RenderVariable variable, const float* vector) = 0;
+	virtual void SetFloatVectorArray(RenderVariable variable, const float* vectors, int first, int count) = 0;
+	virtual void SetFloat(RenderVariable variable, float value) = 0;
+	virtual void SetInt(RenderVariable variable, int value) = 0;
+	virtual void SetBool(RenderVariable variable, bool value) = 0;
+	virtual void SetShaderView(RenderVariable variable, RenderShaderView view) = 0;
+	virtual RenderInputLayout CreateInputLayout(const RenderVertexElement* elements, int count, RenderPass pass) = 0;
+	virtual void ReleaseInputLayout(RenderInputLayout layout) = 0;
+
+	virtual RenderQuery CreateQuery(RenderQueryType type) = 0;
+	virtual void ReleaseQuery(RenderQuery query) = 0;
+	virtual void BeginQuery(RenderQuery query) = 0;
+	virtual void EndQuery(RenderQuery query) = 0;
+	virtual bool GetTimestamp(RenderQuery query, UINT64& timestamp) = 0;
+	virtual bool GetTimestampFrequency(RenderQuery query, UINT64& frequency, bool& disjoint) = 0;
+	virtual bool GetPipelineStatistics(RenderQuery query, RenderPipelineStatistics& statistics) = 0;
+
+	virtual void SetInputLayout(RenderInputLayout layout) = 0;
+	virtual void SetPrimitiveTopology(RenderTopology topology) = 0;
+	virtual void SetVertexBuffer(RenderBuffer buffer, UINT stride) = 0;
+	virtual void SetIndexBuffer(RenderBuffer buffer, RenderFormat format) = 0;
+	virtual void ApplyPass(RenderPass pass) = 0;
+
+	virtual void SetRenderTargets(int count, const RenderTargetView* renderTargets, RenderDepthView depthStencil) = 0;
+	virtual void SetViewport(const RenderViewport& viewport) = 0;
+	virtual void UnbindShaderResources() = 0;
+	virtual void ClearRenderTarget(RenderTargetView renderTarget, const float color[4]) = 0;
+	virtual void ClearDepthStencil(RenderDepthView depthStencil) = 0;
+
+	virtual void Draw(UINT vertexCount, UINT startVertex) = 0;
+	virtual void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) = 0;
+};
+#endif
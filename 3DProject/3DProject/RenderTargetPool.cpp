@@ -0,0 +1,149 @@
+#include "RenderTargetPool.h"
+
+const int RenderTargetPool::C_MAX_IDLE_FRAMES = 60;
+
+RenderTargetPool::RenderTargetPool()
+	: mDevice(NULL), mFrame(0)
+{
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	for(size_t i = 0; i < mTextures.size(); ++i)
+		FreeTexture(mTextures[i]);
+}
+
+void RenderTargetPool::Initialize(RenderDevice* device)
+{
+	mDevice = device;
+}
+
+// Get a texture that nobody else uses until it is released, from the pool if there is one that fits
+PooledTexture* RenderTargetPool::Acquire(const RenderTargetDesc& desc)
+{
+	PooledTexture* texture = NULL;
+	for(size_t i = 0; i < mTextures.size() && texture == NULL; ++i)
+	{
+		if(!mTextures[i]->InUse && mTextures[i]->Desc == desc)
+			texture = mTextures[i];
+	}
+
+	if(texture != NULL)
+		++mStatistics.Reuses;
+	else
+	{
+		texture = CreateTexture(desc);
+		if(texture == NULL)
+			return NULL;
+
+		mTextures.push_back(texture);
+		++mStatistics.Allocations;
+		++mStatistics.Textures;
+		mStatistics.Bytes += texture->Bytes;
+		if(mStatistics.Bytes > mStatistics.PeakBytes)
+			mStatistics.PeakBytes = mStatistics.Bytes;
+	}
+
+	texture->InUse = true;
+	texture->LastUsedFrame = mFrame;
+	++mStatistics.InUse;
+	return texture;
+}
+
+// Give the texture back, its contents may be overwritten by the next user
+void RenderTargetPool::Release(PooledTexture* texture)
+{
+	if(texture == NULL || !texture->InUse)
+		return;
+
+	texture->InUse = false;
+	texture->LastUsedFrame = mFrame;
+	--mStatistics.InUse;
+}
+
+// Free the textures that have waited in the pool for too many frames
+void RenderTargetPool::EndFrame()
+{
+	++mFrame;
+
+	for(size_t i = 0; i < mTextures.size(); )
+	{
+		PooledTexture* texture = mTextures[i];
+		if(!texture->InUse && mFrame - texture->LastUsedFrame > C_MAX_IDLE_FRAMES)
+		{
+			--mStatistics.Textures;
+			mStatistics.Bytes -= texture->Bytes;
+			FreeTexture(texture);
+
+			mTextures[i] = mTextures.back();
+			mTextures.pop_back();
+		}
+		else
+			++i;
+	}
+}
+
+const RenderTargetStatistics& RenderTargetPool::GetStatistics() const
+{
+	return mStatistics;
+}
+
+PooledTexture* RenderTargetPool::CreateTexture(const RenderTargetDesc& desc)
+{
+	PooledTexture* texture = new PooledTexture(desc);
+
+	RenderTextureDesc textureDesc(desc.Width, desc.Height, desc.ArraySize, desc.Format, desc.BindFlags,
+								  RenderUsageDefault, desc.MipLevels);
+	texture->Texture = mDevice->CreateTexture(textureDesc, NULL, 0);
+	if(texture->Texture == NULL)
+	{
+		MessageBox(0, "Error Creating Pooled Texture", "", 0);
+		delete texture;
+		return NULL;
+	}
+
+	if(desc.BindFlags & RenderBindShaderResource)
+	{
+		texture->SRV = mDevice->CreateShaderView(texture->Texture, RenderViewTexture2DArray);
+		if(texture->SRV == NULL)
+			MessageBox(0, "Error Creating Pooled Shader Resource View", "", 0);
+	}
+
+	if(desc.BindFlags & RenderBindDepthStencil)
+	{
+		texture->DSV.resize(desc.ArraySize, NULL);
+		for(int i = 0; i < desc.ArraySize; ++i)
+		{
+			texture->DSV[i] = mDevice->CreateDepthView(texture->Texture, i, 1);
+			if(texture->DSV[i] == NULL)
+				MessageBox(0, "Error Creating Pooled Depth Stencil View", "", 0);
+		}
+	}
+
+	if(desc.BindFlags & RenderBindRenderTarget)
+	{
+		texture->RTV.resize(desc.ArraySize, NULL);
+		for(int i = 0; i < desc.ArraySize; ++i)
+		{
+			texture->RTV[i] = mDevice->CreateRenderTargetView(texture->Texture, i, 1);
+			if(texture->RTV[i] == NULL)
+				MessageBox(0, "Error Creating Pooled Render Target View", "", 0);
+		}
+	}
+
+	texture->Bytes = GetTextureBytes(textureDesc);
+	return texture;
+}
+
+void RenderTargetPool::FreeTexture(PooledTexture* texture)
+{
+	for(size_t i = 0; i < texture->DSV.size(); ++i)
+		mDevice->ReleaseDepthView(texture->DSV[i]);
+	for(size_t i = 0; i < texture->RTV.size(); ++i)
+		mDevice->ReleaseRenderTargetView(texture->RTV[i]);
+	mDevice->ReleaseShaderView(texture->SRV);
+	mDevice->ReleaseTexture(texture->Texture);
+
+	delete texture;
+}
@@ -0,0 +1,85 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <vector>
+#include "RenderDevice.h"
+
+struct RenderTargetDesc
+{
+	int						Width;
+	int						Height;
+	int						ArraySize;
+	RenderFormat			Format;					// Typeless for depth textures that are also read
+	UINT					BindFlags;
+	int						MipLevels;				// 0 is a full chain, filled by GenerateMips
+
+	RenderTargetDesc(int width, int height, int arraySize, RenderFormat format, UINT bindFlags, int mipLevels = 1)
+		: Width(width), Height(height), ArraySize(arraySize), Format(format), BindFlags(bindFlags),
+		  MipLevels(mipLevels) {}
+
+	bool operator==(const RenderTargetDesc& other) const
+	{
+		return Width == other.Width && Height == other.Height && ArraySize == other.ArraySize &&
+			   Format == other.Format && BindFlags == other.BindFlags && MipLevels == other.MipLevels;
+	}
+};
+
+// A texture from the pool with a view of every kind its bind flags allow: one shader resource view
+// of the whole array and a depth stencil or render target view of the top mip of every slice
+struct PooledTexture
+{
+	RenderTargetDesc						Desc;
+	RenderTexture							Texture;
+	RenderShaderView						SRV;
+	std::vector<RenderDepthView>			DSV;
+	std::vector<RenderTargetView>			RTV;
+	int										Bytes;
+	bool									InUse;
+	int										LastUsedFrame;
+
+	PooledTexture(const RenderTargetDesc& desc)
+		: Desc(desc), Texture(NULL), SRV(NULL), Bytes(0), InUse(false), LastUsedFrame(0) {}
+};
+
+struct RenderTargetStatistics
+{
+	int						Textures;				// Allocated, in use or waiting in the pool
+	int						InUse;
+	int						Bytes;
+	int						PeakBytes;
+	int						Allocations;			// Textures created since the start
+	int						Reuses;					// Requests met with a texture already in the pool
+};
+
+// Render targets and depth textures shared between passes. A pass acquires a texture with the size,
+// format and bind flags it needs and releases it when the last pass that reads it is done. A released
+// texture goes back to the pool and is handed to the next request with the same description, later
+// in the same frame when the passes do not overlap or in the next frame. Textures that have not been
+// used for a while are freed at the end of a frame.
+class RenderTargetPool
+{
+public:
+	RenderTargetPool();
+	~RenderTargetPool();
+	void Initialize(RenderDevice* device);
+	PooledTexture* Acquire(const RenderTargetDesc& desc);
+	void Release(PooledTexture* texture);
+	void EndFrame();
+
+	const RenderTargetStatistics& GetStatistics() const;
+
+private:
+	RenderDevice*					mDevice;
+	std::vector<PooledTexture*>		mTextures;
+	int								mFrame;
+	RenderTargetStatistics			mStatistics;
+
+	static const int				C_MAX_IDLE_FRAMES;
+
+	RenderTargetPool(const RenderTargetPool&);
+	RenderTargetPool& operator=(const RenderTargetPool&);
+
+	PooledTexture* CreateTexture(const RenderTargetDesc& desc);
+	void FreeTexture(PooledTexture* texture);
+};
+#endif
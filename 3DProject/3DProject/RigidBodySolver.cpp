@@ -0,0 +1,526 @@
+#include "RigidBodySolver.h"
+#include "GameTime.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace
+{
+	const int C_BODY_GRAIN_SIZE = 4096;
+	const int C_CONSTRAINT_GRAIN_SIZE = 512;
+	const int C_MAX_COLORS = 64;				// The last color takes the rest and is solved serially
+	const int C_DEFAULT_ITERATIONS = 10;
+
+	const float C_REFERENCE_RADIUS = 0.5f;		// Radius of a body with mass 1
+	const float C_MAX_MASS = 10.0f;			// Large mass ratios make the iterations converge too slowly
+	const float C_FRICTION = 0.5f;
+	const float C_RESTITUTION = 0.2f;
+	const float C_RESTITUTION_SPEED = 2.0f;	// Slower impacts do not bounce
+	const float C_BAUMGARTE = 0.1f;			// Part of the penetration removed per step
+	const float C_ALLOWED_PENETRATION = 0.01f;
+	const float C_MAX_CORRECTION_SPEED = 10.0f;
+	const float C_SLEEP_SPEED = 0.1f;
+	const float C_TIME_TO_SLEEP = 0.5f;
+
+	unsigned long long MakeConstraintKey(int a, int b)
+	{
+		return ((unsigned long long)(unsigned int)a << 32) | (unsigned int)b;
+	}
+}
+
+RigidBodySolver::RigidBodySolver()
+	: mVelX(NULL), mVelY(NULL), mVelZ(NULL), mRadius(NULL), mCount(0), mDt(0.0f), mDetector(NULL),
+	  mGravity(0.0f, -9.81f, 0.0f), mNumIterations(C_DEFAULT_ITERATIONS), mCurrentColor(0), mNumWarmStarted(0)
+{
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+void RigidBodySolver::SetGravity(const D3DXVECTOR3& gravity)
+{
+	mGravity = gravity;
+}
+
+void RigidBodySolver::SetIterations(int numIterations)
+{
+	mNumIterations = numIterations;
+}
+
+// Forget the impulses and sleep state, for when the bodies have been replaced
+void RigidBodySolver::Reset()
+{
+	mInvMass.clear();
+	mSleepTime.clear();
+	mAwake.clear();
+	mImpulseCache.clear();
+	ZeroMemory(&mStatistics, sizeof(mStatistics));
+}
+
+// Add gravity, solve the contacts and leave the new velocities in the arrays. The positions are then
+// moved by the caller.
+void RigidBodySolver::Step(float* velX, float* velY, float* velZ, const float* radius, int count,
+						   const CollisionDetector& detector, float dt, JobSystem* jobSystem)
+{
+	Stopwatch timer;
+	timer.Start();
+
+	mVelX = velX;
+	mVelY = velY;
+	mVelZ = velZ;
+	mRadius = radius;
+	mCount = count;
+	mDt = dt;
+	mDetector = &detector;
+
+	// New bodies start awake
+	mInvMass.resize(count);
+	mSleepTime.resize(count, 0.0f);
+	mAwake.resize(count, 1);
+	mIslandParent.resize(count);
+	mIslandSleepTime.resize(count);
+
+	BuildIslands();
+	RunJobs(jobSystem, PrepareBodiesJob, count, C_BODY_GRAIN_SIZE);
+
+	CollectConstraints();
+	mNumWarmStarted = 0;
+	RunJobs(jobSystem, PrepareConstraintsJob, (int)mConstraints.size(), C_CONSTRAINT_GRAIN_SIZE);
+	ColorConstraints();
+
+	SolveColors(jobSystem, WarmStartJob);
+	for(int i = 0; i < mNumIterations; ++i)
+		SolveColors(jobSystem, SolveJob);
+
+	StoreImpulses();
+	RunJobs(jobSystem, UpdateSleepJob, count, C_BODY_GRAIN_SIZE);
+	PutIslandsToSleep();
+
+	mStatistics.Bodies = count;
+	mStatistics.Constraints = (int)mConstraints.size();
+	mStatistics.WarmStarted = mNumWarmStarted;
+	mStatistics.Colors = (int)mColorStart.size() - 1;
+	mStatistics.Checksum = ComputeChecksum();
+	mStatistics.Milliseconds = timer.Stop().Milliseconds;
+}
+
+bool RigidBodySolver::IsAwake(int body) const
+{
+	return body >= (int)mAwake.size() || mAwake[body] != 0;
+}
+
+const SolverStatistics& RigidBodySolver::GetStatistics() const
+{
+	return mStatistics;
+}
+
+// Mass from the radius and gravity for the awake bodies
+void RigidBodySolver::PrepareBodiesJob(void* data, int first, int count)
+{
+	RigidBodySolver* solver = static_cast<RigidBodySolver*>(data);
+	D3DXVECTOR3 gravityStep = solver->mGravity * solver->mDt;
+
+	for(int i = first; i < first + count; ++i)
+	{
+		float scale = solver->mRadius[i] / C_REFERENCE_RADIUS;
+		solver->mInvMass[i] = 1.0f / std::min(scale * scale * scale, C_MAX_MASS);
+
+		if(solver->mAwake[i])
+		{
+			solver->mVelX[i] += gravityStep.x;
+			solver->mVelY[i] += gravityStep.y;
+			solver->mVelZ[i] += gravityStep.z;
+		}
+	}
+}
+
+void RigidBodySolver::PrepareConstraintsJob(void* data, int first, int count)
+{
+	RigidBodySolver* solver = static_cast<RigidBodySolver*>(data);
+	long numWarmStarted = 0;
+
+	for(int i = first; i < first + count; ++i)
+	{
+		solver->PrepareConstraint(i);
+		if(solver->mConstraints[i].NormalImpulse > 0.0f)
+			++numWarmStarted;
+	}
+
+	Atomic::Add(&solver->mNumWarmStarted, numWarmStarted);
+}
+
+// Apply the impulses from the last step
+void RigidBodySolver::WarmStartJob(void* data, int first, int count)
+{
+	RigidBodySolver* solver = static_cast<RigidBodySolver*>(data);
+	const int* order = &solver->mColorOrder[solver->mColorStart[solver->mCurrentColor]];
+
+	for(int i = first; i < first + count; ++i)
+	{
+		const Constraint& constraint = solver->mConstraints[order[i]];
+		D3DXVECTOR3 impulse = constraint.Normal * constraint.NormalImpulse +
+							  constraint.Tangent1 * constraint.TangentImpulse1 +
+							  constraint.Tangent2 * constraint.TangentImpulse2;
+		solver->ApplyImpulse(constraint, impulse);
+	}
+}
+
+void RigidBodySolver::SolveJob(void* data, int first, int count)
+{
+	RigidBodySolver* solver = static_cast<RigidBodySolver*>(data);
+	const int* order = &solver->mColorOrder[solver->mColorStart[solver->mCurrentColor]];
+
+	for(int i = first; i < first + count; ++i)
+		solver->SolveConstraint(solver->mConstraints[order[i]]);
+}
+
+// Count how long every awake body has been slow
+void RigidBodySolver::UpdateSleepJob(void* data, int first, int count)
+{
+	RigidBodySolver* solver = static_cast<RigidBodySolver*>(data);
+
+	for(int i = first; i < first + count; ++i)
+	{
+		if(!solver->mAwake[i])
+			continue;
+
+		float speedSq = solver->mVelX[i] * solver->mVelX[i] + solver->mVelY[i] * solver->mVelY[i] +
+						solver->mVelZ[i] * solver->mVelZ[i];
+		if(speedSq < C_SLEEP_SPEED * C_SLEEP_SPEED)
+			solver->mSleepTime[i] += solver->mDt;
+		else
+			solver->mSleepTime[i] = 0.0f;
+	}
+}
+
+// Run the jobs and wait for them, or run them here when there is too little work to split
+void RigidBodySolver::RunJobs(JobSystem* jobSystem, JobFunction function, int count, int grainSize)
+{
+	if(count == 0)
+		return;
+
+	if(jobSystem == NULL || count <= grainSize)
+	{
+		function(this, 0, count);
+		return;
+	}
+
+	JobCounter done;
+	jobSystem->ParallelFor(function, this, count, grainSize, &done);
+	jobSystem->Wait(&done);
+}
+
+// Join the bodies that touch each other and wake every island with an awake body in it
+void RigidBodySolver::BuildIslands()
+{
+	for(int i = 0; i < mCount; ++i)
+		mIslandParent[i] = i;
+
+	const std::vector<ContactPair>& contacts = mDetector->GetContacts();
+	for(size_t i = 0; i < contacts.size(); ++i)
+		JoinIslands(contacts[i].A, contacts[i].B);
+
+	// A negative sleep time at the root marks an island with an awake body
+	std::fill(mIslandSleepTime.begin(), mIslandSleepTime.end(), 0.0f);
+	for(int i = 0; i < mCount; ++i)
+	{
+		if(mAwake[i])
+			mIslandSleepTime[FindIsland(i)] = -1.0f;
+	}
+
+	for(int i = 0; i < mCount; ++i)
+	{
+		if(!mAwake[i] && mIslandSleepTime[FindIsland(i)] < 0.0f)
+		{
+			mAwake[i] = 1;
+			mSleepTime[i] = 0.0f;
+		}
+	}
+}
+
+// Make a constraint of every contact with an awake body, in the order the detector found them
+void RigidBodySolver::CollectConstraints()
+{
+	const std::vector<ContactPair>& contacts = mDetector->GetContacts();
+	const std::vector<StaticContact>& staticContacts = mDetector->GetStaticContacts();
+
+	mConstraints.clear();
+	mConstraintKeys.clear();
+
+	for(size_t i = 0; i < contacts.size(); ++i)
+	{
+		const ContactPair& contact = contacts[i];
+		if(!mAwake[contact.A] && !mAwake[contact.B])
+			continue;
+
+		Constraint constraint;
+		constraint.A = contact.A;
+		constraint.B = contact.B;
+		constraint.Normal = contact.Normal;
+		constraint.Depth = contact.Depth;
+		mConstraints.push_back(constraint);
+		mConstraintKeys.push_back(MakeConstraintKey(contact.A, contact.B));
+	}
+
+	// Static keys have the inverted box index on top, above every body index
+	for(size_t i = 0; i < staticContacts.size(); ++i)
+	{
+		const StaticContact& contact = staticContacts[i];
+		if(!mAwake[contact.Object])
+			continue;
+
+		Constraint constraint;
+		constraint.A = -1;
+		constraint.B = contact.Object;
+		constraint.Normal = contact.Normal;
+		constraint.Depth = contact.Depth;
+		mConstraints.push_back(constraint);
+		mConstraintKeys.push_back(MakeConstraintKey(~contact.Box, contact.Object));
+	}
+}
+
+// Give every constraint the lowest color not used by another constraint of its bodies, then group
+// the constraints by color keeping their order within a color
+void RigidBodySolver::ColorConstraints()
+{
+	int numConstraints = (int)mConstraints.size();
+	int numColors = 0;
+
+	mBodyColors.assign(mCount, 0);
+	mConstraintColors.resize(numConstraints);
+
+	for(int i = 0; i < numConstraints; ++i)
+	{
+		const Constraint& constraint = mConstraints[i];
+		unsigned long long used = mBodyColors[constraint.B];
+		if(constraint.A >= 0)
+			used |= mBodyColors[constraint.A];
+
+		int color = 0;
+		while(color < C_MAX_COLORS - 1 && (used & (1ULL << color)))
+			++color;
+
+		if(color < C_MAX_COLORS - 1)
+		{
+			mBodyColors[constraint.B] |= 1ULL << color;
+			if(constraint.A >= 0)
+				mBodyColors[constraint.A] |= 1ULL << color;
+		}
+
+		mConstraintColors[i] = color;
+		numColors = std::max(numColors, color + 1);
+	}
+
+	mColorStart.assign(numColors + 1, 0);
+	for(int i = 0; i < numConstraints; ++i)
+		++mColorStart[mConstraintColors[i] + 1];
+	for(int color = 0; color < numColors; ++color)
+		mColorStart[color + 1] += mColorStart[color];
+
+	std::vector<int> next(mColorStart.begin(), mColorStart.end() - 1);
+	mColorOrder.resize(numConstraints);
+	for(int i = 0; i < numConstraints; ++i)
+		mColorOrder[next[mConstraintColors[i]]++] = i;
+}
+
+// Run the job over every color in turn. The last color can have bodies in common and is run serially.
+void RigidBodySolver::SolveColors(JobSystem* jobSystem, JobFunction function)
+{
+	int numColors = (int)mColorStart.size() - 1;
+	for(int color = 0; color < numColors; ++color)
+	{
+		mCurrentColor = color;
+		int count = mColorStart[color + 1] - mColorStart[color];
+
+		if(color == C_MAX_COLORS - 1)
+			function(this, 0, count);
+		else
+			RunJobs(jobSystem, function, count, C_CONSTRAINT_GRAIN_SIZE);
+	}
+}
+
+// Put the islands where every body has been slow long enough to sleep, and count the islands
+void RigidBodySolver::PutIslandsToSleep()
+{
+	std::fill(mIslandSleepTime.begin(), mIslandSleepTime.end(), FLT_MAX);
+	for(int i = 0; i < mCount; ++i)
+	{
+		int island = FindIsland(i);
+		mIslandSleepTime[island] = std::min(mIslandSleepTime[island], mSleepTime[i]);
+	}
+
+	mStatistics.Islands = 0;
+	mStatistics.SleepingIslands = 0;
+	mStatistics.AwakeBodies = 0;
+
+	for(int i = 0; i < mCount; ++i)
+	{
+		int island = FindIsland(i);
+		if(mAwake[i] && mIslandSleepTime[island] >= C_TIME_TO_SLEEP)
+		{
+			mAwake[i] = 0;
+			mVelX[i] = 0.0f;
+			mVelY[i] = 0.0f;
+			mVelZ[i] = 0.0f;
+		}
+
+		if(island == i)
+		{
+			++mStatistics.Islands;
+			if(!mAwake[i])
+				++mStatistics.SleepingIslands;
+		}
+
+		if(mAwake[i])
+			++mStatistics.AwakeBodies;
+	}
+}
+
+// Keep the impulses sorted by key, for the warm start of the next step
+void RigidBodySolver::StoreImpulses()
+{
+	mNewImpulseCache.resize(mConstraints.size());
+	for(size_t i = 0; i < mConstraints.size(); ++i)
+	{
+		mNewImpulseCache[i].Key = mConstraintKeys[i];
+		mNewImpulseCache[i].NormalImpulse = mConstraints[i].NormalImpulse;
+		mNewImpulseCache[i].TangentImpulse1 = mConstraints[i].TangentImpulse1;
+		mNewImpulseCache[i].TangentImpulse2 = mConstraints[i].TangentImpulse2;
+	}
+
+	std::sort(mNewImpulseCache.begin(), mNewImpulseCache.end());
+	mImpulseCache.swap(mNewImpulseCache);
+}
+
+int RigidBodySolver::FindIsland(int body)
+{
+	while(mIslandParent[body] != body)
+	{
+		mIslandParent[body] = mIslandParent[mIslandParent[body]];
+		body = mIslandParent[body];
+	}
+
+	return body;
+}
+
+// The lower root becomes the parent, so the islands do not depend on the order of the joins
+void RigidBodySolver::JoinIslands(int a, int b)
+{
+	a = FindIsland(a);
+	b = FindIsland(b);
+	if(a < b)
+		mIslandParent[b] = a;
+	else if(b < a)
+		mIslandParent[a] = b;
+}
+
+// Compute the tangents, mass and bias of the constraint and look up its impulses from the last step
+void RigidBodySolver::PrepareConstraint(int index)
+{
+	Constraint& constraint = mConstraints[index];
+	const D3DXVECTOR3& n = constraint.Normal;
+
+	if(fabs(n.x) >= 0.57735f)
+		constraint.Tangent1 = D3DXVECTOR3(n.y, -n.x, 0.0f);
+	else
+		constraint.Tangent1 = D3DXVECTOR3(0.0f, n.z, -n.y);
+	D3DXVec3Normalize(&constraint.Tangent1, &constraint.Tangent1);
+	D3DXVec3Cross(&constraint.Tangent2, &n, &constraint.Tangent1);
+
+	int b = constraint.B;
+	int a = constraint.A;
+	float invMassA = a >= 0 ? mInvMass[a] : 0.0f;
+	constraint.Mass = 1.0f / (invMassA + mInvMass[b]);
+
+	D3DXVECTOR3 relativeVelocity(mVelX[b], mVelY[b], mVelZ[b]);
+	if(a >= 0)
+		relativeVelocity -= D3DXVECTOR3(mVelX[a], mVelY[a], mVelZ[a]);
+	float normalVelocity = D3DXVec3Dot(&relativeVelocity, &n);
+
+	float correction = std::max(constraint.Depth - C_ALLOWED_PENETRATION, 0.0f) * C_BAUMGARTE / mDt;
+	constraint.Bias = std::min(correction, C_MAX_CORRECTION_SPEED);
+	if(normalVelocity < -C_RESTITUTION_SPEED)
+		constraint.Bias = std::max(constraint.Bias, -C_RESTITUTION * normalVelocity);
+
+	CachedImpulse key;
+	key.Key = mConstraintKeys[index];
+	std::vector<CachedImpulse>::const_iterator cached = std::lower_bound(mImpulseCache.begin(), mImpulseCache.end(), key);
+	if(cached != mImpulseCache.end() && cached->Key == key.Key)
+	{
+		constraint.NormalImpulse = cached->NormalImpulse;
+		constraint.TangentImpulse1 = cached->TangentImpulse1;
+		constraint.TangentImpulse2 = cached->TangentImpulse2;
+	}
+	else
+	{
+		constraint.NormalImpulse = 0.0f;
+		constraint.TangentImpulse1 = 0.0f;
+		constraint.TangentImpulse2 = 0.0f;
+	}
+}
+
+// One sequential impulse iteration of a contact: push the bodies apart, then apply friction bounded
+// by the normal impulse. Impulses are accumulated and the total is clamped, not every increment.
+void RigidBodySolver::SolveConstraint(Constraint& constraint)
+{
+	int a = constraint.A;
+	int b = constraint.B;
+
+	D3DXVECTOR3 relativeVelocity(mVelX[b], mVelY[b], mVelZ[b]);
+	if(a >= 0)
+		relativeVelocity -= D3DXVECTOR3(mVelX[a], mVelY[a], mVelZ[a]);
+
+	float normalVelocity = D3DXVec3Dot(&relativeVelocity, &constraint.Normal);
+	float oldImpulse = constraint.NormalImpulse;
+	constraint.NormalImpulse = std::max(oldImpulse + constraint.Mass * (constraint.Bias - normalVelocity), 0.0f);
+	float normalImpulse = constraint.NormalImpulse - oldImpulse;
+	relativeVelocity += constraint.Normal * (normalImpulse / constraint.Mass);
+
+	float maxFriction = C_FRICTION * constraint.NormalImpulse;
+	float oldImpulse1 = constraint.TangentImpulse1;
+	float oldImpulse2 = constraint.TangentImpulse2;
+	float tangentVelocity1 = D3DXVec3Dot(&relativeVelocity, &constraint.Tangent1);
+	float tangentVelocity2 = D3DXVec3Dot(&relativeVelocity, &constraint.Tangent2);
+	constraint.TangentImpulse1 = std::max(-maxFriction, std::min(oldImpulse1 - constraint.Mass * tangentVelocity1, maxFriction));
+	constraint.TangentImpulse2 = std::max(-maxFriction, std::min(oldImpulse2 - constraint.Mass * tangentVelocity2, maxFriction));
+
+	D3DXVECTOR3 impulse = constraint.Normal * normalImpulse +
+						  constraint.Tangent1 * (constraint.TangentImpulse1 - oldImpulse1) +
+						  constraint.Tangent2 * (constraint.TangentImpulse2 - oldImpulse2);
+	ApplyImpulse(constraint, impulse);
+}
+
+// Apply the impulse to B and its opposite to A
+void RigidBodySolver::ApplyImpulse(const Constraint& constraint, const D3DXVECTOR3& impulse)
+{
+	int a = constraint.A;
+	int b = constraint.B;
+
+	if(a >= 0)
+	{
+		mVelX[a] -= impulse.x * mInvMass[a];
+		mVelY[a] -= impulse.y * mInvMass[a];
+		mVelZ[a] -= impulse.z * mInvMass[a];
+	}
+
+	mVelX[b] += impulse.x * mInvMass[b];
+	mVelY[b] += impulse.y * mInvMass[b];
+	mVelZ[b] += impulse.z * mInvMass[b];
+}
+
+// FNV-1a over the bits of every velocity
+unsigned int RigidBodySolver::ComputeChecksum() const
+{
+	unsigned int checksum = 2166136261u;
+	const float* velocities[3] = { mVelX, mVelY, mVelZ };
+
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		for(int i = 0; i < mCount; ++i)
+		{
+			unsigned int bits;
+			memcpy(&bits, &velocities[axis][i], sizeof(bits));
+			checksum = (checksum ^ bits) * 16777619u;
+		}
+	}
+
+	return checksum;
+}
@@ -0,0 +1,128 @@
+#ifndef RIGID_BODY_SOLVER_H
+#define RIGID_BODY_SOLVER_H
+
+#include <vector>
+#include <D3DX10.h>
+
+#include "CollisionDetector.h"
+#include "JobSystem.h"
+
+struct SolverStatistics
+{
+	int					Bodies;
+	int					AwakeBodies;
+	int					Islands;
+	int					SleepingIslands;
+	int					Constraints;
+	int					WarmStarted;		// Constraints that got their impulses from the last step
+	int					Colors;
+	double				Milliseconds;
+	unsigned int		Checksum;			// Hash of the velocities after the step
+};
+
+// Sequential impulse solver for spheres, with velocities given as separate x, y and z arrays and the
+// contacts found by a CollisionDetector. Bodies have a mass from their radius and no rotation, so
+// contacts push along the normal and friction acts on the linear velocity only.
+//
+// Contacts are grouped into colors where no two contacts of a color share a body. The contacts of a
+// color are then solved in parallel and the colors one after another, which gives the same result
+// as a serial solve in that order whatever number of workers is used. Impulses are kept between
+// steps and used as the starting point for the contacts that still exist (warm starting).
+//
+// Bodies connected by contacts form islands. An island whose bodies have all been slow for a while
+// is put to sleep: it gets no gravity and its contacts are not solved until an awake body touches it.
+class RigidBodySolver
+{
+public:
+	RigidBodySolver();
+
+	void SetGravity(const D3DXVECTOR3& gravity);
+	void SetIterations(int numIterations);
+	void Reset();
+
+	void Step(float* velX, float* velY, float* velZ, const float* radius, int count,
+			  const CollisionDetector& detector, float dt, JobSystem* jobSystem);
+
+	bool IsAwake(int body) const;
+	const SolverStatistics& GetStatistics() const;
+
+private:
+	struct Constraint
+	{
+		int					A;					// -1 for a static box
+		int					B;
+		D3DXVECTOR3			Normal;				// From A to B
+		D3DXVECTOR3			Tangent1;
+		D3DXVECTOR3			Tangent2;
+		float				Depth;
+		float				Mass;				// Effective mass, the same in every direction without rotation
+		float				Bias;				// Wanted separating velocity
+		float				NormalImpulse;
+		float				TangentImpulse1;
+		float				TangentImpulse2;
+	};
+
+	struct CachedImpulse
+	{
+		unsigned long long	Key;
+		float				NormalImpulse;
+		float				TangentImpulse1;
+		float				TangentImpulse2;
+
+		bool operator<(const CachedImpulse& other) const { return Key < other.Key; }
+	};
+
+	// Everything the jobs read and write
+	float*									mVelX;
+	float*									mVelY;
+	float*									mVelZ;
+	const float*							mRadius;
+	int										mCount;
+	float									mDt;
+	const CollisionDetector*				mDetector;
+
+	D3DXVECTOR3								mGravity;
+	int										mNumIterations;
+
+	std::vector<float>						mInvMass;
+	std::vector<float>						mSleepTime;
+	std::vector<unsigned char>				mAwake;
+	std::vector<int>						mIslandParent;
+	std::vector<float>						mIslandSleepTime;	// Shortest sleep time of the island, at the root
+
+	std::vector<Constraint>					mConstraints;
+	std::vector<unsigned long long>			mConstraintKeys;
+	std::vector<int>						mConstraintColors;
+	std::vector<int>						mColorOrder;		// Constraint indices grouped by color
+	std::vector<int>						mColorStart;		// First entry of every color in mColorOrder
+	std::vector<unsigned long long>			mBodyColors;		// Colors used by the constraints of a body
+	int										mCurrentColor;
+
+	std::vector<CachedImpulse>				mImpulseCache;
+	std::vector<CachedImpulse>				mNewImpulseCache;
+	volatile long							mNumWarmStarted;
+
+	SolverStatistics						mStatistics;
+
+	static void PrepareBodiesJob(void* data, int first, int count);
+	static void PrepareConstraintsJob(void* data, int first, int count);
+	static void WarmStartJob(void* data, int first, int count);
+	static void SolveJob(void* data, int first, int count);
+	static void UpdateSleepJob(void* data, int first, int count);
+
+	void RunJobs(JobSystem* jobSystem, JobFunction function, int count, int grainSize);
+	void BuildIslands();
+	void CollectConstraints();
+	void ColorConstraints();
+	void SolveColors(JobSystem* jobSystem, JobFunction function);
+	void PutIslandsToSleep();
+	void StoreImpulses();
+
+	int FindIsland(int body);
+	void JoinIslands(int a, int b);
+	void PrepareConstraint(int index);
+	void SolveConstraint(Constraint& constraint);
+	void ApplyImpulse(const Constraint& constraint, const D3DXVECTOR3& impulse);
+	unsigned int ComputeChecksum() const;
+};
+#endif
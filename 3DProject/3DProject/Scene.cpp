@@ -1,153 +1,1550 @@
 #include "Scene.h"
 #include <sstream>
+#include <cstdlib>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
-Scene::Scene(ID3D10Device* device, const int& screenWidth)
-	: mDevice(device), mDepthMapIndex(0), mObject(NULL), mLightDirection(D3DXVECTOR3(-300.0f, 50.0f, -300.0f))
+const int C_SIMULATION_RATE = 60;				// Steps per second
+const int C_MAX_SIMULATION_STEPS = 4;			// Most steps one frame may take to catch up
+const int C_CHECKSUM_INTERVAL = 600;			// Steps between the mover checksums
+const float C_BENCHMARK_MOVER_RADIUS = 0.5f;
+const int C_MOVER_GRAIN_SIZE = 16384;
+const float C_MOVER_TREE_MARGIN = 2.0f;
+const int C_OCCLUDER_MOVERS = 256;
+const int C_OCCLUSION_BATCH_SIZE = 1024;
+const double C_OCCLUSION_BUDGET_MS = 2.0;
+const float C_FLOOR_THICKNESS = 10.0f;
+const int C_PHYSICS_ROW_SIZE = 25;
+const float C_PHYSICS_SPACING = 1.05f;
+const int C_PHYSICS_CHECKSUM_STEP = 600;
+const int C_LIGHTMAP_SIZE = 256;
+const int C_LIGHTMAP_PASSES = 64;
+const float C_LIGHTMAP_AO_DISTANCE = 20.0f;
+const float C_IMPOSTOR_SCREEN_SIZE = 0.04f;		// Fraction of the view height below which impostors are drawn
+const int C_IMPOSTOR_FRAMES = 8;				// Frames along each side of the atlas
+const int C_IMPOSTOR_FRAME_SIZE = 64;
+const char* C_IMPOSTOR_FILENAME = "bth.impostor";
+const int C_SHADOW_MAP_SIZES[] = { 256, 512, 1024, 2048 };
+const int C_SHADOW_CASCADES = 3;
+const float C_SHADOW_DISTANCE = 600.0f;			// No shadows beyond this distance from the camera
+const int C_SHADOW_MAP_SIZE_COUNT = sizeof(C_SHADOW_MAP_SIZES) / sizeof(C_SHADOW_MAP_SIZES[0]);
+const int C_FILTER_BENCHMARK_WARMUP = 8;			// Frames before the timers show a new configuration
+const int C_FILTER_BENCHMARK_FRAMES = 32;			// Frames averaged per configuration
+const int C_STATIC_PROPS = 12;
+const float C_STATIC_PROP_AREA = 200.0f;		// Props stand within this distance of the floor's center
+const int C_SPOT_LIGHTS = 64;					// Of the benchmark, in rows over the floor
+const int C_SPOT_LIGHT_ROW_SIZE = 8;
+const float C_SPOT_LIGHT_HEIGHT = 60.0f;		// Above the floor
+const float C_SPOT_LIGHT_RANGE = 120.0f;
+const float C_SPOT_LIGHT_ANGLE = 0.5f;			// Half the cone, in radians
+const int C_SWAYING_SPOT_LIGHT_STEP = 4;		// Every fourth light sways, its tile asks to be drawn again
+const float C_SPOT_LIGHT_SWAY_SPEED = 0.5f;		// Radians per second
+const int C_ATLAS_SIZE = 2048;
+const int C_ATLAS_MIN_TILE = 64;
+const int C_ATLAS_MAX_TILE = 512;
+const int C_ATLAS_UPDATES_PER_FRAME = 8;
+const int C_POINT_SHADOW_SIZE = 1024;			// Of each face of the cube
+const float C_POINT_SHADOW_NEAR = 1.0f;
+const float C_POINT_SHADOW_FAR = 1500.0f;		// Past the far corner of the floor from the light
+const int C_RASTERIZER_BENCHMARK_RUNS = 8;		// Of each size, averaged
+
+namespace
 {
-	D3DXVECTOR3& lightPosition = mLightDirection;
-	mObject = new Object3D(mDevice, "bth.obj", D3DXVECTOR3(-100.0, 0.0, -100.0), lightPosition);
+	// Orders moving objects by their squared distance to a point
+	struct MoverDistanceLess
+	{
+		const MovingObjectStore*	Store;
+		D3DXVECTOR3					Point;
+
+		MoverDistanceLess(const MovingObjectStore* store, const D3DXVECTOR3& point)
+			: Store(store), Point(point) {}
+
+		bool operator()(int a, int b) const
+		{
+			D3DXVECTOR3 toA = Store->GetPosition(a) - Point;
+			D3DXVECTOR3 toB = Store->GetPosition(b) - Point;
+			return D3DXVec3LengthSq(&toA) < D3DXVec3LengthSq(&toB);
+		}
+	};
 
-	ZeroMemory(&mLightViewMatrix, sizeof(D3DXMATRIX));
-	ZeroMemory(&mLightProjMatrix, sizeof(D3DXMATRIX));
-	CreateLightMatrices();
+	// Number in [0, 1) from an integer, so the benchmarks give the same rays and meshes every run
+	float HashUnit(unsigned int value)
+	{
+		value ^= value >> 16;
+		value *= 0x85EBCA6Bu;
+		value ^= value >> 13;
+		value *= 0xC2B2AE35u;
+		value ^= value >> 16;
+		return (value >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+Scene::Scene(RenderDevice* device, const int& screenWidth)
+	: mLight(D3DXVECTOR3(-300.0f, 50.0f, -300.0f), D3DXVECTOR3(0.0f, 0.0f, 0.0f), 1000.0f, 1000.0f, 1.0f, 1000.0f),
+	  mDepthMapIndex(2), mScreenShadows(ScreenShadowsFull), mSpotLightSeconds(0.0), mPointShadows(PointShadowsOff),
+	  mCpuShadows(false), mFilterBenchmarkStep(-1), mFilterBenchmarkFrame(0), mFilterBenchmarkSum(0.0),
+	  mFilterBenchmarkDepthMap(0), mFilterBenchmarkFilter(ShadowFilter3x3), mShowStaticProps(true), mStaticVersion(0),
+	  mJobSystem(NULL), mTimestep(C_SIMULATION_RATE, C_MAX_SIMULATION_STEPS), mSimulationSteps(0), mChecksumStep(0),
+	  mMoverChecksum(0), mCollisionDetection(false), mPhysics(false), mPhysicsSteps(0), mPhysicsChecksum(0),
+	  mPicked(false), mPickPoint(0.0f, 0.0f, 0.0f), mPickMilliseconds(0.0), mInstanceMode(InstancesHidden),
+	  mMoverTree(C_MOVER_TREE_MARGIN), mTreeCulling(false), mTreeUpdateMilliseconds(0.0), mOcclusionCulling(false),
+	  mFloorCullVersion(0), mFloorInFrustum(false), mObjectMoverIndex(0), mDevice(device), mObject(NULL)
+{
+	mJobSystem = new JobSystem();
+	mJobStatistics = mJobSystem->GetStatistics();
+
+	D3DXVECTOR3 lightPosition = mLight.GetPosition();
+	D3DXVECTOR3 objectPosition = D3DXVECTOR3(-100.0, 0.0, -100.0);
+	mObject = new Object3D(mDevice, "bth.obj", objectPosition, lightPosition);
+	mObject->BuildBVH(mJobSystem);
+
+	D3DXVECTOR3 objectVelocity = D3DXVECTOR3(1.2f, 0.5f, 0.8f);
+	D3DXVec3Normalize(&objectVelocity, &objectVelocity);
+	objectVelocity *= 30;
+	mObjectVelocity = objectVelocity;
+
+	mMovingObjects.SetBounds(D3DXVECTOR3(-256.0f, 0.0f, -256.0f), D3DXVECTOR3(256.0f, 30.0f, 256.0f));
+	mObjectMoverIndex = mMovingObjects.Add(objectPosition, objectVelocity, 0.0f, mObject->GetBoundingRadius());
+	mMovingObjectsTime.Milliseconds = 0.0;
+	mMovingObjectsTime.Seconds = 0.0;
+	ZeroMemory(&mCullingStatistics, sizeof(mCullingStatistics));
+	ZeroMemory(&mOcclusionStatistics, sizeof(mOcclusionStatistics));
+	ZeroMemory(&mCasterStatistics, sizeof(mCasterStatistics));
+	ZeroMemory(&mShadowStatistics, sizeof(mShadowStatistics));
+	ZeroMemory(&mPickHit, sizeof(mPickHit));
+	ZeroMemory(&mInstanceStatistics, sizeof(mInstanceStatistics));
+	ZeroMemory(mPointShadowStatistics, sizeof(mPointShadowStatistics));
+	ZeroMemory(&mRasterizerStatistics, sizeof(mRasterizerStatistics));
 
 	// Shadow map things
-	mDepthMap.push_back(CreateDepthTexture(256, 256));
-	mDepthMap.push_back(CreateDepthTexture(512, 512));
-	mDepthMap.push_back(CreateDepthTexture(1024, 1024));
-	mDepthMap.push_back(CreateDepthTexture(2048, 2048));
+	mRenderTargets.Initialize(mDevice);
+	mShadowMap.Initialize(mDevice, &mRenderTargets, C_SHADOW_MAP_SIZES[mDepthMapIndex], C_SHADOW_CASCADES);
+	mMomentFilter.Initialize(mDevice, &mRenderTargets);
+	mShadowMask.Initialize(mDevice, &mRenderTargets);
+	mShadowAtlas.Initialize(mDevice, &mRenderTargets, C_ATLAS_SIZE, C_ATLAS_MIN_TILE, C_ATLAS_MAX_TILE,
+							C_ATLAS_UPDATES_PER_FRAME);
+	mShadowGpuTimer.Initialize(mDevice);
+	mMomentGpuTimer.Initialize(mDevice);
+	mMaskGpuTimer.Initialize(mDevice);
+	mAtlasGpuTimer.Initialize(mDevice);
+	mPointGpuTimer.Initialize(mDevice);
+	mPointQuery.Initialize(mDevice);
+	mPointShadowMap.Initialize(mDevice, C_POINT_SHADOW_SIZE);
+	mDepthUpload.Initialize(mDevice);
+	mReceiverGpuTimer.Initialize(mDevice);
+	mDepthPassQuery.Initialize(mDevice);
+	mObject->SetShadowMap(&mShadowMap);
+
+	mFloor.Initialize(mDevice, &mShadowMap, D3DXVECTOR3(0, -50, 0), 512, 512);
+	mFloor.SetShadowAtlas(&mShadowAtlas);
+
+	// The floor is flat, give it some thickness so fast bodies cannot pass through it in one step
+	AABB floorBox = mFloor.GetBounds();
+	floorBox.Min.y -= C_FLOOR_THICKNESS;
+	mCollisionDetector.AddStaticBox(floorBox);
+	mScreenSquare.Initialize(mDevice, NULL, D3DXVECTOR2((float)screenWidth - 100, 0), 100.0f, 100.0f);
 
-	ZeroMemory(&mViewport, sizeof(D3D10_VIEWPORT));
-	mViewport.TopLeftX = 0;
-	mViewport.TopLeftY = 0;
-	mViewport.Width = mDepthMap[mDepthMapIndex]->C_WIDTH;
-	mViewport.Height = mDepthMap[mDepthMapIndex]->C_HEIGHT;
-	mViewport.MinDepth = 0.0f;
-	mViewport.MaxDepth = 1.0f;
+	// The object moves, so it only occludes itself. The props shadow the floor's lightmap, which is
+	// refined a pass per frame.
+	mLightBaker.SetLight(mLight.GetPosition());
+	mObject->BakeAmbientOcclusion(mLightBaker, mJobSystem);
+	CreateStaticProps();
+	CreateImpostors();
+}
 
-	mFloor.Initialize(mDevice, mDepthMap[mDepthMapIndex], D3DXVECTOR3(0, -50, 0), 512, 512);
-	mScreenSquare.Initialize(mDevice, mDepthMap[mDepthMapIndex]->SRV, D3DXVECTOR2((float)screenWidth - 100, 0), 100.0f, 100.0f);
+Scene::~Scene()
+{
+	SafeDelete(mObject);
+	SafeDelete(mJobSystem);
 }
 
 void Scene::Update(const GameTime& gameTime)
 {
-	if(GetAsyncKeyState('1'))
-		ChangeDepthMap(0);
-	else if(GetAsyncKeyState('2'))
-		ChangeDepthMap(1);
-	else if(GetAsyncKeyState('3'))
-		ChangeDepthMap(2);
-	else if(GetAsyncKeyState('4'))
-		ChangeDepthMap(3);
-	else if(GetAsyncKeyState(VK_F1))
-		mFloor.SetPCF(false);
-	else if(GetAsyncKeyState(VK_F2))
-		mFloor.SetPCF(true);
+	if(mFilterBenchmarkStep >= 0)
+		StepFilterBenchmark();
+
+	mJobSystem->ResetStatistics();
+	mUpdateTimer.Start();
+
+	int numSteps = mTimestep.Advance(gameTime.GetTimeSinceLastTick());
+	for(int i = 0; i < numSteps; ++i)
+		StepSimulation(mTimestep.GetStepSeconds());
+
+	mMovingObjectsTime = mUpdateTimer.Stop();
+
+	if(mCollisionDetection && !mPhysics && numSteps > 0)
+	{
+		mCollisionDetector.Detect(mMovingObjects.GetPositionsX(), mMovingObjects.GetPositionsY(),
+								  mMovingObjects.GetPositionsZ(), mMovingObjects.GetRadii(),
+								  mMovingObjects.GetCount(), mJobSystem);
+	}
 
+	if(mTreeCulling)
+		UpdateMoverTree();
+
+	if(!mLightBaker.IsLightmapDone())
+	{
+		mLightBaker.RefineLightmap(mJobSystem);
+		mLightBaker.GetLightmapTexels(&mLightmapTexels[0]);
+		mFloor.SetLightmap(&mLightmapTexels[0], C_LIGHTMAP_SIZE, C_LIGHTMAP_SIZE);
+	}
+
+	mJobStatistics = mJobSystem->GetStatistics();
+
+	mObject->SetWorldMatrix(mMovingObjects.GetInterpolatedWorldMatrix(mObjectMoverIndex, mTimestep.GetAlpha()));
 	mObject->Update(gameTime);
 	mFloor.Update();
+	UpdateSpotLights((float)gameTime.GetTimeSinceLastTick().Seconds);
 }
 
-void Scene::DrawShadows(const D3DXVECTOR3& eyePos)
+// Decide what is drawn this frame, must be called before AddPasses
+void Scene::Cull(const Camera& camera)
 {
-	SetupShadowMapDrawing();
-	mObject->DrawShadows(&(mLightViewMatrix * mLightProjMatrix), eyePos);
+	mShadowMap.Update(camera, mLight, C_SHADOW_DISTANCE);
+	mShadowAtlas.Update(mSpotLights, camera);
+	mPointShadowMap.SetLight(mLight.GetPosition(), C_POINT_SHADOW_NEAR, C_POINT_SHADOW_FAR);
+	CullView(camera);
+
+	if(mInstanceMode != InstancesHidden)
+		GatherInstances(camera.GetProjectionMatrix(), camera.GetPos());
 }
 
-void Scene::Draw(const Camera& camera)
+// Declare the shadow passes, the screen-space mask and the receivers. Every shadow pass writes a
+// resource the receivers only read while those shadows are used, so the graph culls the rest. The
+// shadow textures are held by their own classes and only order the passes, the mask's depth is a
+// transient of the graph.
+void Scene::AddPasses(FrameGraph& graph, const Camera& camera, int colorTarget, int depthTarget)
 {
-	D3DXMATRIX view, proj, vp;
+	mFramePassData.Owner = this;
+	mFramePassData.View = &camera;
+	mFramePassData.Graph = &graph;
 
-	view = camera.GetViewMatrix();
-	proj = camera.GetProjectionMatrix();
-	vp = view * proj;
+	int cascades = graph.ImportTexture("Shadow cascades", ImportedViews());
+	int atlas = graph.ImportTexture("Shadow atlas", ImportedViews());
+	int pointShadows = graph.ImportTexture("Point shadow cube", ImportedViews());
+	int shadowMask = graph.ImportTexture("Shadow mask", ImportedViews());
+	mFramePassData.MaskDepth = graph.CreateTexture("Shadow mask depth",
+		RenderTargetDesc(graph.GetWidth(colorTarget), graph.GetHeight(colorTarget), 1, RenderFormatR32Typeless,
+						 RenderBindDepthStencil | RenderBindShaderResource));
 
-	mObject->Draw(&vp, camera.GetPos());
-	mFloor.Draw(&vp, &(mLightViewMatrix * mLightProjMatrix));
-	mScreenSquare.Draw();
+	int pass = graph.AddPass("Shadow cascades", CascadePass, &mFramePassData);
+	graph.Write(pass, cascades);
+
+	pass = graph.AddPass("Shadow atlas tiles", AtlasPass, &mFramePassData);
+	graph.Write(pass, atlas);
+
+	pass = graph.AddPass("Point shadows", PointShadowPass, &mFramePassData);
+	graph.Write(pass, pointShadows);
+
+	pass = graph.AddPass("Shadow mask", ShadowMaskPass, &mFramePassData);
+	graph.Read(pass, cascades);
+	graph.Read(pass, mFramePassData.MaskDepth);
+	graph.Write(pass, mFramePassData.MaskDepth, true);
+	graph.Write(pass, shadowMask);
+
+	pass = graph.AddPass("Receivers", ReceiverPass, &mFramePassData);
+	graph.Read(pass, cascades);
+	if(!mSpotLights.empty())
+		graph.Read(pass, atlas);
+	if(mPointShadows != PointShadowsOff)
+		graph.Read(pass, pointShadows);
+	else if(mScreenShadows != ScreenShadowsOff)
+		graph.Read(pass, shadowMask);
+	graph.Write(pass, colorTarget, true);
+	graph.Write(pass, depthTarget, true);
+}
+
+// Nothing reads the shadow map or the mask after the frame graph has run, they can go back to the pool
+void Scene::EndFrame()
+{
+	mShadowMask.EndFrame();
+	mShadowMap.EndFrame();
+	mRenderTargets.EndFrame();
+}
+
+// Find the closest mesh triangle hit by a world space ray. The object is the only mesh in the scene,
+// it moves the ray into its own object space.
+bool Scene::RayCast(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance, RayHit& hit) const
+{
+	return mObject->RayCast(origin, direction, maxDistance, hit);
+}
+
+// Cast a ray through a pixel of the view and remember what it hit for the info string
+void Scene::Pick(const Camera& camera, int x, int y, int width, int height)
+{
+	const D3DXMATRIX& inverse = camera.GetInverseViewProjectionMatrix();
+	D3DXVECTOR3 nearPoint(2.0f * (x + 0.5f) / width - 1.0f, 1.0f - 2.0f * (y + 0.5f) / height, 0.0f);
+	D3DXVECTOR3 farPoint(nearPoint.x, nearPoint.y, 1.0f);
+	D3DXVec3TransformCoord(&nearPoint, &nearPoint, &inverse);
+	D3DXVec3TransformCoord(&farPoint, &farPoint, &inverse);
+
+	// From the near plane to the far plane, so the hit distance is a fraction of the way
+	Stopwatch timer;
+	timer.Start();
+
+	D3DXVECTOR3 direction = farPoint - nearPoint;
+	mPicked = true;
+	mPickGroup = "";
+	if(RayCast(nearPoint, direction, 1.0f, mPickHit))
+	{
+		mPickPoint = nearPoint + direction * mPickHit.Distance;
+		mPickGroup = mObject->GetTriangleGroupName(mPickHit.Triangle);
+	}
+
+	mPickMilliseconds = timer.Stop().Milliseconds;
 }
 
 std::string Scene::GetInfoString() const
 {
 	std::stringstream stream;
-	stream << "Depth texture " << (mDepthMapIndex + 1) << ": " << mDepthMap[mDepthMapIndex]->C_WIDTH;
-	stream << "x" << mDepthMap[mDepthMapIndex]->C_HEIGHT;
+	int numCascades = mShadowMap.GetCascadeCount();
+	stream << "Depth texture " << (mDepthMapIndex + 1) << ": " << numCascades << " cascades of " << mShadowMap.GetSize();
+	stream << "x" << mShadowMap.GetSize() << " (" << mShadowMap.GetMemorySize() / (1024 * 1024) << " MB), splits at";
+	for(int i = 0; i < numCascades; ++i)
+		stream << " " << (int)mShadowMap.GetSplitDistance(i);
+
+	ShadowFilter filter = mShadowMap.GetFilter();
+	stream << ", filter: " << ShadowEffectVariables::GetFilterName(filter) << " (";
+	stream << ShadowEffectVariables::GetFilterTaps(filter) << " taps)";
 
-	if(mFloor.GetPCF())
-		stream << ", PCF: ON";
+	stream << "\nMoving objects: " << mMovingObjects.GetCount() << ", update: " << mMovingObjectsTime.Milliseconds << " ms";
+	if(mMovingObjects.GetSIMD())
+		stream << " (SSE)";
 	else
-		stream << ", PCF: OFF";
+		stream << " (scalar)";
+
+	stream << "\nSimulation: " << mTimestep.GetStepsPerSecond() << " steps/s, step " << mSimulationSteps;
+	stream << ", blend " << mTimestep.GetAlpha() << ", dropped " << mTimestep.GetDroppedMilliseconds() << " ms";
+	if(mChecksumStep > 0)
+		stream << ", checksum at step " << mChecksumStep << ": " << std::hex << mMoverChecksum << std::dec;
+
+	stream << "\nCulling: " << mCullingStatistics.Visible << "/" << mCullingStatistics.Tested << " visible, ";
+	if(mCullingStatistics.Milliseconds > 0.0)
+		stream << (int)(mCullingStatistics.Tested / mCullingStatistics.Milliseconds) << " bounds/ms";
+
+	if(mTreeCulling)
+	{
+		stream << " (tree, height " << mMoverTree.GetHeight() << ", cost " << mMoverTree.GetCost();
+		stream << ", rebuilds " << mMoverTree.GetRebuildCount() << ", update " << mTreeUpdateMilliseconds << " ms)";
+	}
+	else
+		stream << " (brute force)";
+
+	if(mOcclusionCulling)
+	{
+		stream << "\nOcclusion: " << mOcclusionStatistics.Occluded << "/" << mOcclusionStatistics.Tested << " hidden, ";
+		stream << mOcclusionStatistics.Triangles << " occluder triangles, " << mOcclusionStatistics.Milliseconds << " ms";
+		if(mOcclusionStatistics.Untested > 0)
+			stream << " (over budget, " << mOcclusionStatistics.Untested << " untested)";
+	}
+
+	if(mCollisionDetection)
+	{
+		const CollisionStatistics& collisions = mCollisionDetector.GetStatistics();
+		double milliseconds = collisions.BroadPhaseMilliseconds + collisions.NarrowPhaseMilliseconds;
+
+		stream << "\nCollisions: " << collisions.Pairs << " pairs, " << collisions.StaticContacts << " static, ";
+		stream << collisions.CandidatePairs << " candidates, " << collisions.BroadPhaseMilliseconds << " + ";
+		stream << collisions.NarrowPhaseMilliseconds << " ms";
+		if(milliseconds > 0.0)
+			stream << ", " << (int)(collisions.CandidatePairs / milliseconds) << " pairs/ms";
+		stream << ", checksum " << std::hex << collisions.Checksum << std::dec;
+	}
+
+	if(mPhysics)
+	{
+		const SolverStatistics& solver = mRigidBodies.GetStatistics();
+		stream << "\nPhysics: step " << mPhysicsSteps << ", " << solver.AwakeBodies << "/" << solver.Bodies << " awake, ";
+		stream << solver.SleepingIslands << "/" << solver.Islands << " islands asleep, " << solver.Constraints;
+		stream << " contacts (" << solver.WarmStarted << " warm), " << solver.Colors << " colors, ";
+		stream << solver.Milliseconds << " ms";
+		if(mPhysicsSteps >= C_PHYSICS_CHECKSUM_STEP)
+			stream << ", checksum at step " << C_PHYSICS_CHECKSUM_STEP << ": " << std::hex << mPhysicsChecksum << std::dec;
+	}
+
+	const BakeStatistics& vertexBake = mLightBaker.GetVertexStatistics();
+	const BakeStatistics& lightmapBake = mLightBaker.GetLightmapStatistics();
+	stream << "\nBaked lighting: " << (mFloor.GetBakedLighting() ? "ON" : "OFF") << ", lightmap pass ";
+	stream << lightmapBake.Passes << "/" << C_LIGHTMAP_PASSES;
+	if(lightmapBake.Milliseconds > 0.0)
+		stream << " (" << lightmapBake.Rays / (lightmapBake.Milliseconds * 1000.0) << " Mrays/s)";
+	stream << ", object AO " << vertexBake.Rays << " rays in " << vertexBake.Milliseconds << " ms";
+	if(vertexBake.Milliseconds > 0.0)
+		stream << " (" << vertexBake.Rays / (vertexBake.Milliseconds * 1000.0) << " Mrays/s)";
+
+	stream << "\nInstances: ";
+	if(mInstanceMode == InstancesHidden)
+		stream << "OFF";
+	else
+	{
+		stream << mInstanceStatistics.Meshes << " meshes, " << mInstanceStatistics.Impostors << " impostors (";
+		stream << (mInstanceMode == InstancesImpostors ? "ON" : "OFF") << ", atlas " << mImpostorAtlas.GetSize();
+		stream << "x" << mImpostorAtlas.GetSize() << "), draw " << mInstanceStatistics.Milliseconds << " ms";
+	}
+
+	if(mPicked)
+	{
+		if(mPickHit.Triangle >= 0)
+		{
+			stream << "\nPicked: " << mPickGroup << ", triangle " << mPickHit.Triangle << " at (" << mPickPoint.x;
+			stream << ", " << mPickPoint.y << ", " << mPickPoint.z << "), " << mPickMilliseconds << " ms";
+		}
+		else
+			stream << "\nPicked: nothing, " << mPickMilliseconds << " ms";
+	}
+
+	stream << "\nShadow casters" << (mCpuShadows ? " (CPU, objects)" : " (groups)") << ": " << mCasterStatistics.Drawn;
+	stream << "/" << mCasterStatistics.Total << " drawn, " << mCasterStatistics.InLightFrustum << " in light frustum";
+	if(mCpuShadows)
+		stream << "\nShadow cache: not used by the CPU rasterizer, ";
+	else
+	{
+		stream << "\nShadow cache: " << mShadowStatistics.StaticRenders << " static cascades drawn this frame, ";
+		stream << mShadowMap.GetStaticRenderCount() << " in total, " << mShadowStatistics.StaticCasters;
+		stream << " static casters, ";
+	}
+	stream << "props " << (mShowStaticProps ? "ON" : "OFF") << ", shadows " << mShadowStatistics.Milliseconds << " ms";
+
+	// The GPU counts are from a few frames back, the rasterized triangles are those left after culling
+	const DepthPassStatistics& depthPass = mShadowStatistics.DepthPass;
+	const RenderPipelineStatistics& depthPipeline = mDepthPassQuery.GetStatistics();
+	stream << "\nDepth pass: " << (mObject->GetPositionStreams() ? "position streams, front faces culled" : "interleaved");
+	stream << " (F11/Z), " << depthPass.Draws << " draws, " << depthPass.Triangles << " triangles, ";
+	stream << depthPass.FetchBytes / 1024 << " KB fetched (interleaved " << depthPass.InterleavedFetchBytes / 1024;
+	stream << " KB), GPU: " << (int)depthPipeline.VSInvocations << " vertices shaded, ";
+	stream << (int)depthPipeline.CPrimitives << "/" << (int)depthPipeline.IAPrimitives << " triangles rasterized";
+
+	stream << "\nGPU: shadow pass " << mShadowGpuTimer.GetMilliseconds() << " ms";
+	if(mShadowMap.UsesMoments())
+		stream << " (moments " << mMomentGpuTimer.GetMilliseconds() << " ms)";
+	if(mScreenShadows != ScreenShadowsOff)
+		stream << ", mask " << mMaskGpuTimer.GetMilliseconds() << " ms";
+	stream << ", receivers " << mReceiverGpuTimer.GetMilliseconds() << " ms";
+
+	const char* screenShadowNames[] = { "OFF", "full resolution", "half resolution" };
+	stream << "\nShadow mask (Delete/Insert/Home): " << screenShadowNames[mScreenShadows];
+
+	const ShadowAtlasStatistics& atlas = mShadowAtlas.GetStatistics();
+	int atlasSize = mShadowAtlas.GetSize();
+	stream << "\nShadow atlas (End, budget PageUp/PageDown): " << mSpotLights.size() << " spot lights, ";
+	stream << atlas.Tiles << " tiles in " << atlasSize << "x" << atlasSize << " (";
+	stream << (int)(100.0 * atlas.UsedTexels / ((double)atlasSize * atlasSize)) << "% used), ";
+	stream << atlas.Updated << "/" << mShadowAtlas.GetUpdatesPerFrame() << " drawn with ";
+	stream << mShadowStatistics.AtlasCasters << " casters, " << mShadowStatistics.AtlasPass.Triangles << " triangles, ";
+	stream << "oldest " << atlas.MaxAge << " frames, " << atlas.Reallocated << " reallocated, ";
+	stream << atlas.Unallocated << " without a tile, GPU " << mAtlasGpuTimer.GetMilliseconds() << " ms";
+
+	// Amplification is triangles out of the geometry shader, or submitted over all six passes, per
+	// caster triangle
+	const char* pointShadowNames[] = { "OFF", "one pass with a geometry shader", "six passes" };
+	stream << "\nPoint shadows (Left/Up/Down): " << pointShadowNames[mPointShadows];
+	for(int i = PointShadowsSinglePass; i < PointShadowModeCount; ++i)
+	{
+		const PointShadowStatistics& point = mPointShadowStatistics[i];
+		if(point.Passes == 0)
+			continue;
+
+		double amplified = i == PointShadowsSinglePass ? (double)point.Pipeline.GSPrimitives : (double)point.Pipeline.IAPrimitives;
+		int casterTriangles = point.CasterTriangles > 0 ? point.CasterTriangles : 1;
+		stream << "\n  " << pointShadowNames[i] << ": " << point.DepthPass.Draws << " draws, ";
+		stream << point.DepthPass.Triangles << " triangles submitted, GPU: " << (int)amplified << " triangles (";
+		stream << amplified / casterTriangles << "x), " << (int)point.Pipeline.CPrimitives << " rasterized, ";
+		stream << point.GpuMilliseconds << " ms";
+	}
+
+	stream << "\nShadow rasterizer (Tab/Space, F benchmark): " << (mCpuShadows ? "CPU" : "GPU");
+	if(mCpuShadows)
+	{
+		stream << ", " << mRasterizerStatistics.Triangles << " triangles, " << mRasterizerStatistics.Culled;
+		stream << " culled, " << mRasterizerStatistics.Milliseconds << " ms";
+	}
+
+	if(!mRasterizerBenchmark.empty())
+	{
+		stream << "\nRasterizer benchmark:";
+		for(size_t i = 0; i < mRasterizerBenchmark.size(); ++i)
+		{
+			const RasterizerBenchmarkResult& result = mRasterizerBenchmark[i];
+			stream << (i == 0 ? " " : ", ") << result.Size << "x" << result.Size << " ";
+			if(result.Milliseconds > 0.0)
+				stream << result.Triangles / (result.Milliseconds * 1000.0) << " Mtris/s";
+			stream << " (" << result.Milliseconds << " ms)";
+		}
+	}
+
+	if(mFilterBenchmarkStep >= 0)
+		stream << "\nFilter benchmark: " << mFilterBenchmarkStep + 1 << "/" << mFilterBenchmark.size();
+	else if(!mFilterBenchmark.empty())
+	{
+		for(int i = 0; i < C_SHADOW_MAP_SIZE_COUNT; ++i)
+		{
+			stream << "\nFilter benchmark at " << C_SHADOW_MAP_SIZES[i] << ", shadow pass, mask and receivers in ms:";
+			for(int j = 0; j < ShadowFilterCount; ++j)
+			{
+				stream << " " << ShadowEffectVariables::GetFilterName((ShadowFilter)j) << " ";
+				stream << mFilterBenchmark[i * ShadowFilterCount + j];
+			}
+		}
+	}
+
+	const RenderTargetStatistics& targets = mRenderTargets.GetStatistics();
+	stream << "\nRender targets: " << targets.InUse << "/" << targets.Textures << " in use, ";
+	stream << targets.Bytes / (1024 * 1024) << " MB, peak " << targets.PeakBytes / (1024 * 1024) << " MB, ";
+	stream << targets.Allocations << " allocated, " << targets.Reuses << " reused";
+
+	stream << "\nWorkers: " << mJobStatistics.Workers << ", jobs: " << mJobStatistics.JobsExecuted;
+	stream << ", steals: " << mJobStatistics.Steals << "/" << mJobStatistics.StealAttempts;
 
 	return stream.str();
 }
 
+// Number of bounds that were outside the view frustum last frame
+int Scene::GetCulledCount() const
+{
+	return mCullingStatistics.Tested - mCullingStatistics.Visible;
+}
+
+// Number of bounds that were inside the view frustum last frame
+int Scene::GetVisibleCount() const
+{
+	return mCullingStatistics.Visible;
+}
+
+void Scene::SetShadowFilter(ShadowFilter filter)
+{
+	mShadowMap.SetFilter(filter);
+}
+
+void Scene::SetScreenShadows(ScreenShadowMode mode)
+{
+	mScreenShadows = mode;
+}
+
+// Rasterize the cascades on the CPU and upload them instead of drawing them on the GPU
+void Scene::SetCpuShadows(bool cpuShadows)
+{
+	mCpuShadows = cpuShadows;
+}
+
+bool Scene::IsShowingStaticProps() const
+{
+	return mShowStaticProps;
+}
+
+bool Scene::HasSpotLights() const
+{
+	return !mSpotLights.empty();
+}
+
+// Draw every tile that asks for it each frame instead of only a few
+void Scene::SetAtlasUnlimited(bool unlimited)
+{
+	mShadowAtlas.SetUpdatesPerFrame(unlimited ? C_SPOT_LIGHTS : C_ATLAS_UPDATES_PER_FRAME);
+}
+
+void Scene::SetBakedLighting(bool baked)
+{
+	mFloor.SetBakedLighting(baked);
+}
+
+void Scene::SetInstanceMode(InstanceMode mode)
+{
+	mInstanceMode = mode;
+}
+
+// Draw the depth passes from the position-only stream or from the full vertices
+void Scene::SetPositionStreams(bool positionStreams)
+{
+	mObject->SetPositionStreams(positionStreams);
+}
+
+void Scene::SetMoverSIMD(bool simd)
+{
+	mMovingObjects.SetSIMD(simd);
+}
+
+// Remove every moving object but the one carrying the object
+void Scene::RemoveBenchmarkMovers()
+{
+	mMovingObjects.Resize(1);
+}
+
+int Scene::GetMoverCount() const
+{
+	return mMovingObjects.GetCount();
+}
+
+bool Scene::IsPhysicsRunning() const
+{
+	return mPhysics;
+}
+
+void Scene::SetCollisionDetection(bool detect)
+{
+	mCollisionDetection = detect;
+}
+
+int Scene::GetWorkerCount() const
+{
+	return mJobSystem->GetWorkerCount();
+}
+
+void Scene::SetOcclusionCulling(bool occlusionCulling)
+{
+	mOcclusionCulling = occlusionCulling;
+}
+
+bool Scene::IsFilterBenchmarkRunning() const
+{
+	return mFilterBenchmarkStep >= 0;
+}
+
+bool Scene::HasRasterizerBenchmark() const
+{
+	return !mRasterizerBenchmark.empty();
+}
+
+RenderTargetPool& Scene::GetRenderTargetPool()
+{
+	return mRenderTargets;
+}
+
+void Scene::CascadePass(void* data)
+{
+	FramePassData* passData = static_cast<FramePassData*>(data);
+	passData->Owner->DrawCascades(passData->View->GetPos());
+}
+
+void Scene::AtlasPass(void* data)
+{
+	Scene* scene = static_cast<FramePassData*>(data)->Owner;
+	scene->mAtlasGpuTimer.Begin();
+	scene->DrawAtlasTiles();
+	scene->mAtlasGpuTimer.End();
+}
+
+void Scene::PointShadowPass(void* data)
+{
+	Scene* scene = static_cast<FramePassData*>(data)->Owner;
+	scene->mPointGpuTimer.Begin();
+	scene->mPointQuery.Begin();
+	scene->DrawPointShadows();
+	scene->mPointQuery.End();
+	scene->mPointGpuTimer.End();
+
+	scene->mPointShadowStatistics[scene->mPointShadows].Pipeline = scene->mPointQuery.GetStatistics();
+	scene->mPointShadowStatistics[scene->mPointShadows].GpuMilliseconds = scene->mPointGpuTimer.GetMilliseconds();
+}
+
+void Scene::ShadowMaskPass(void* data)
+{
+	FramePassData* passData = static_cast<FramePassData*>(data);
+	passData->Owner->DrawShadowMask(*passData->View, passData->Graph->GetTexture(passData->MaskDepth));
+}
+
+void Scene::ReceiverPass(void* data)
+{
+	FramePassData* passData = static_cast<FramePassData*>(data);
+	passData->Owner->DrawReceivers(*passData->View);
+}
+
+void Scene::UpdateMoversJob(void* data, int first, int count)
+{
+	MoverUpdateData* moverData = static_cast<MoverUpdateData*>(data);
+	moverData->Store->Update(moverData->DeltaTime, first, count);
+}
+
+void Scene::CullMoversJob(void* data, int first, int count)
+{
+	MoverCullData* cullData = static_cast<MoverCullData*>(data);
+	const MovingObjectStore* store = cullData->Store;
+
+	int numVisible = cullData->Frustum->CullSpheres(store->GetPositionsX() + first, store->GetPositionsY() + first,
+		store->GetPositionsZ() + first, store->GetRadii() + first, count, cullData->Visible + first);
+	Atomic::Add(&cullData->NumVisible, numVisible);
+}
+
+void Scene::MoveProxiesJob(void* data, int first, int count)
+{
+	MoverTreeData* treeData = static_cast<MoverTreeData*>(data);
+	const float* x = treeData->Store->GetPositionsX();
+	const float* y = treeData->Store->GetPositionsY();
+	const float* z = treeData->Store->GetPositionsZ();
+	const float* r = treeData->Store->GetRadii();
+
+	for(int i = first; i < first + count; ++i)
+	{
+		D3DXVECTOR3 position(x[i], y[i], z[i]);
+		D3DXVECTOR3 radius(r[i], r[i], r[i]);
+		treeData->Tree->MoveProxy(treeData->Proxies[i], AABB(position - radius, position + radius));
+	}
+}
+
+// Switch between testing every moving object (brute force) and querying the tree built over them
+void Scene::SetTreeCulling(bool useTree)
+{
+	if(useTree == mTreeCulling)
+		return;
+
+	mTreeCulling = useTree;
+	mMoverTree.Clear();
+	mMoverProxies.clear();
+}
+
+// Move the proxies of all moving objects and refit the tree. It is built from scratch whenever the
+// number of moving objects has changed.
+void Scene::UpdateMoverTree()
+{
+	Stopwatch timer;
+	timer.Start();
+
+	int numMovers = mMovingObjects.GetCount();
+
+	if((int)mMoverProxies.size() != numMovers)
+	{
+		std::vector<AABB> bounds(numMovers);
+		std::vector<int> indices(numMovers);
+		for(int i = 0; i < numMovers; ++i)
+		{
+			D3DXVECTOR3 position = mMovingObjects.GetPosition(i);
+			float radius = mMovingObjects.GetRadius(i);
+			bounds[i] = AABB(position - D3DXVECTOR3(radius, radius, radius), position + D3DXVECTOR3(radius, radius, radius));
+			indices[i] = i;
+		}
+
+		mMoverTree.Clear();
+		mMoverProxies.resize(numMovers);
+		if(numMovers > 0)
+			mMoverTree.CreateProxies(&bounds[0], &indices[0], numMovers, &mMoverProxies[0]);
+	}
+	else
+	{
+		JobCounter proxiesMoved;
+		mMoverTreeData.Tree = &mMoverTree;
+		mMoverTreeData.Store = &mMovingObjects;
+		mMoverTreeData.Proxies = numMovers > 0 ? &mMoverProxies[0] : NULL;
+		mJobSystem->ParallelFor(MoveProxiesJob, &mMoverTreeData, numMovers, C_MOVER_GRAIN_SIZE, &proxiesMoved);
+		mJobSystem->Wait(&proxiesMoved);
+
+		mMoverTree.Refit();
+		mMoverTree.Optimize();
+	}
+
+	mTreeUpdateMilliseconds = timer.Stop().Milliseconds;
+}
+
+// Test moving objects against the occlusion buffer in batches. When the time budget has run out the
+// rest are left visible.
+void Scene::OccludeMoversJob(void* data, int first, int count)
+{
+	MoverOcclusionData* occlusionData = static_cast<MoverOcclusionData*>(data);
+	int end = first + count;
+
+	for(int batch = first; batch < end; batch += C_OCCLUSION_BATCH_SIZE)
+	{
+		if(occlusionData->Timer->Stop().Milliseconds > occlusionData->BudgetMilliseconds)
+		{
+			for(int i = batch; i < end; ++i)
+				occlusionData->Visible[i] = 1;
+
+			Atomic::Add(&occlusionData->NumUntested, end - batch);
+			return;
+		}
+
+		int batchEnd = std::min(batch + C_OCCLUSION_BATCH_SIZE, end);
+		int numOccluded = 0;
+		for(int i = batch; i < batchEnd; ++i)
+		{
+			int mover = occlusionData->Movers[i];
+			BoundingSphere sphere(occlusionData->Store->GetPosition(mover), occlusionData->Store->GetRadius(mover));
+			occlusionData->Visible[i] = occlusionData->Culler->TestSphere(sphere) ? 1 : 0;
+			numOccluded += 1 - occlusionData->Visible[i];
+		}
+
+		Atomic::Add(&occlusionData->NumOccluded, numOccluded);
+	}
+}
+
+// Test the object's groups, the floor and all moving objects against the view frustum
+void Scene::CullView(const Camera& camera)
+{
+	const FrustumPlanes& frustum = camera.GetFrustumPlanes();
+
+	mCullTimer.Start();
+
+	int numMovers = mMovingObjects.GetCount();
+	int visibleMovers = 0;
+
+	if(mTreeCulling)
+	{
+		mVisibleMovers.clear();
+		visibleMovers = mMoverTree.QueryFrustum(frustum, mVisibleMovers);
+	}
+	else
+	{
+		mMoverVisibility.resize(numMovers);
+
+		JobCounter moversCulled;
+		mMoverCullData.Frustum = &frustum;
+		mMoverCullData.Store = &mMovingObjects;
+		mMoverCullData.Visible = numMovers > 0 ? &mMoverVisibility[0] : NULL;
+		mMoverCullData.NumVisible = 0;
+		mJobSystem->ParallelFor(CullMoversJob, &mMoverCullData, numMovers, C_MOVER_GRAIN_SIZE, &moversCulled);
+		mJobSystem->Wait(&moversCulled);
+
+		visibleMovers = (int)mMoverCullData.NumVisible;
+	}
+
+	int visibleGroups = mObject->Cull(frustum);
+
+	mVisibleProps.clear();
+	if(mShowStaticProps)
+	{
+		for(size_t i = 0; i < mStaticProps.size(); ++i)
+		{
+			if(frustum.TestBox(mObject->GetBounds().Transform(mStaticProps[i])))
+				mVisibleProps.push_back(mStaticProps[i]);
+		}
+	}
+
+	// The floor does not move, so it is only tested again when the camera has
+	if(camera.GetVersion() != mFloorCullVersion)
+	{
+		mFloorInFrustum = frustum.TestBox(mFloor.GetBounds());
+		mFloorCullVersion = camera.GetVersion();
+	}
+	mFloor.SetVisible(mFloorInFrustum);
+
+	mCullingStatistics.Tested = numMovers + mObject->GetGroupCount() + 1;
+	mCullingStatistics.Visible = visibleMovers + visibleGroups + (mFloor.IsVisible() ? 1 : 0);
+
+	if(mOcclusionCulling)
+	{
+		// The occlusion test works on a list of the movers that passed the frustum test
+		if(!mTreeCulling)
+		{
+			mVisibleMovers.clear();
+			for(int i = 0; i < numMovers; ++i)
+			{
+				if(mMoverVisibility[i])
+					mVisibleMovers.push_back(i);
+			}
+		}
+
+		mCullingStatistics.Visible -= CullOccluded(camera.GetViewProjectionMatrix(), camera.GetPos());
+	}
+	mCullingStatistics.Milliseconds = mCullTimer.Stop().Milliseconds;
+}
+
+// Rasterize the occluders and test everything that passed the frustum test against them, returns
+// how many objects were found to be hidden. Expects mCullingStatistics to hold the frustum results.
+// The object is an occluder through its simplified mesh. The benchmark movers are taken to be solid
+// spheres, so the nearest of them are added as occluders by the largest box that fits inside the
+// sphere.
+int Scene::CullOccluded(const D3DXMATRIX& viewProj, const D3DXVECTOR3& eyePos)
+{
+	mOcclusionTimer.Start();
+	mOcclusionCuller.BeginFrame(viewProj);
+
+	const std::vector<D3DXVECTOR3>& occluder = mObject->GetOccluderVertices();
+	if(!occluder.empty())
+		mOcclusionCuller.AddOccluder(&occluder[0], (int)occluder.size(), mObject->GetWorldMatrix());
+
+	int numOccluderMovers = std::min((int)mVisibleMovers.size(), C_OCCLUDER_MOVERS);
+	std::vector<int> nearestMovers(mVisibleMovers);
+	std::partial_sort(nearestMovers.begin(), nearestMovers.begin() + numOccluderMovers, nearestMovers.end(),
+					  MoverDistanceLess(&mMovingObjects, eyePos));
+
+	for(int i = 0; i < numOccluderMovers; ++i)
+	{
+		if(nearestMovers[i] == mObjectMoverIndex)
+			continue;
+
+		float halfSide = mMovingObjects.GetRadius(nearestMovers[i]) / sqrtf(3.0f);
+		D3DXVECTOR3 halfExtents(halfSide, halfSide, halfSide);
+		D3DXVECTOR3 position = mMovingObjects.GetPosition(nearestMovers[i]);
+		mOcclusionCuller.AddOccluderBox(AABB(position - halfExtents, position + halfExtents));
+	}
+
+	mOcclusionCuller.Rasterize(mJobSystem);
+
+	int numOccluded = mObject->CullOccluded(mOcclusionCuller);
+	if(mFloor.IsVisible() && !mOcclusionCuller.TestBox(mFloor.GetBounds()))
+	{
+		mFloor.SetVisible(false);
+		++numOccluded;
+	}
+
+	int numMovers = (int)mVisibleMovers.size();
+	mMoverOcclusion.resize(numMovers);
+
+	JobCounter moversTested;
+	mMoverOcclusionData.Culler = &mOcclusionCuller;
+	mMoverOcclusionData.Store = &mMovingObjects;
+	mMoverOcclusionData.Movers = numMovers > 0 ? &mVisibleMovers[0] : NULL;
+	mMoverOcclusionData.Visible = numMovers > 0 ? &mMoverOcclusion[0] : NULL;
+	mMoverOcclusionData.Timer = &mOcclusionTimer;
+	mMoverOcclusionData.BudgetMilliseconds = C_OCCLUSION_BUDGET_MS;
+	mMoverOcclusionData.NumOccluded = 0;
+	mMoverOcclusionData.NumUntested = 0;
+	mJobSystem->ParallelFor(OccludeMoversJob, &mMoverOcclusionData, numMovers, C_MOVER_GRAIN_SIZE, &moversTested);
+	mJobSystem->Wait(&moversTested);
+
+	// Keep only the movers that are still visible
+	int numVisible = 0;
+	for(int i = 0; i < numMovers; ++i)
+	{
+		if(mMoverOcclusion[i])
+			mVisibleMovers[numVisible++] = mVisibleMovers[i];
+	}
+	mVisibleMovers.resize(numVisible);
+
+	numOccluded += (int)mMoverOcclusionData.NumOccluded;
+
+	mOcclusionStatistics.Tested = mCullingStatistics.Visible;
+	mOcclusionStatistics.Occluded = numOccluded;
+	mOcclusionStatistics.Untested = (int)mMoverOcclusionData.NumUntested;
+	mOcclusionStatistics.Triangles = mOcclusionCuller.GetTriangleCount();
+	mOcclusionStatistics.Milliseconds = mOcclusionTimer.Stop().Milliseconds;
+
+	return numOccluded;
+}
+
+// Find the groups that cast a shadow into one cascade by culling them against the cascade's light
+// frustum and against the receivers the camera can see, the counts are added to the caster
+// statistics. The frustum has no near plane, since casters between the light and the near plane
+// still throw shadows into the scene (the shadow shader flattens them onto the near plane).
+void Scene::CullCasters(int cascade)
+{
+	FrustumPlanes lightFrustum = mShadowMap.GetFrustumPlanes(cascade);
+	lightFrustum.Planes[FrustumPlanes::Near] = D3DXPLANE(0.0f, 0.0f, 0.0f, 1.0f);
+
+	AABB receivers;
+	if(mFloor.IsVisible())
+		receivers.Expand(mFloor.GetBounds().Transform(mLight.GetViewMatrix()));
+	mObject->ExpandReceiverBounds(mLight.GetViewMatrix(), receivers);
+
+	int numInLightFrustum = 0;
+	int numCasters = 0;
+	mObject->CullCasters(lightFrustum, mLight.GetViewMatrix(), receivers, numInLightFrustum, numCasters);
+	mCasterStatistics.InLightFrustum += numInLightFrustum;
+	mCasterStatistics.Drawn += numCasters;
+}
+
+// Recreate the job system with the given number of workers, 0 means one per hardware thread
+void Scene::SetWorkerCount(int numWorkers)
+{
+	SafeDelete(mJobSystem);
+	mJobSystem = new JobSystem(numWorkers);
+}
+
+// Fill the store with objects that are only updated, never drawn, to measure the cost of the update.
+// The values are hashed from the index, so every run starts from the same state.
+void Scene::AddBenchmarkMovers(int count)
+{
+	for(int i = 0; i < count; ++i)
+	{
+		unsigned int seed = i * 7;
+		D3DXVECTOR3 position(HashUnit(seed) * 512.0f - 256.0f, HashUnit(seed + 1) * 30.0f, HashUnit(seed + 2) * 512.0f - 256.0f);
+		D3DXVECTOR3 velocity(HashUnit(seed + 3) * 60.0f - 30.0f, HashUnit(seed + 4) * 60.0f - 30.0f,
+							 HashUnit(seed + 5) * 60.0f - 30.0f);
+		mMovingObjects.Add(position, velocity, HashUnit(seed + 6) * 6.28f, C_BENCHMARK_MOVER_RADIUS);
+	}
+}
+
+void Scene::UpdateMovers(float dt)
+{
+	JobCounter moversDone;
+	mMoverUpdateData.Store = &mMovingObjects;
+	mMoverUpdateData.DeltaTime = dt;
+	mJobSystem->ParallelFor(UpdateMoversJob, &mMoverUpdateData, mMovingObjects.GetCount(), C_MOVER_GRAIN_SIZE, &moversDone);
+	mJobSystem->Wait(&moversDone);
+}
+
+// Replace the movers with bodies stacked in columns on the floor. The layout has no randomness, so
+// every run is the same and the checksums of runs with different worker counts can be compared.
+void Scene::StartPhysics(int numBodies)
+{
+	mMovingObjects.Resize(1);
+	mMovingObjects.SetBounds(D3DXVECTOR3(-256.0f, -FLT_MAX, -256.0f), D3DXVECTOR3(256.0f, FLT_MAX, 256.0f));
+
+	float floorY = mFloor.GetBounds().Max.y;
+	float offset = (C_PHYSICS_ROW_SIZE - 1) * C_PHYSICS_SPACING * 0.5f;
+	for(int i = 0; i < numBodies; ++i)
+	{
+		int x = i % C_PHYSICS_ROW_SIZE;
+		int z = (i / C_PHYSICS_ROW_SIZE) % C_PHYSICS_ROW_SIZE;
+		int y = i / (C_PHYSICS_ROW_SIZE * C_PHYSICS_ROW_SIZE);
+
+		// Small sideways offsets so the columns do not stand perfectly still
+		unsigned int hash = (x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u);
+		float jitterX = ((hash & 255) / 255.0f - 0.5f) * 0.1f;
+		float jitterZ = (((hash >> 8) & 255) / 255.0f - 0.5f) * 0.1f;
+
+		D3DXVECTOR3 position(x * C_PHYSICS_SPACING - offset + jitterX,
+							 floorY + C_BENCHMARK_MOVER_RADIUS + 0.1f + y * C_PHYSICS_SPACING,
+							 z * C_PHYSICS_SPACING - offset + jitterZ);
+		mMovingObjects.Add(position, D3DXVECTOR3(0.0f, 0.0f, 0.0f), 0.0f, C_BENCHMARK_MOVER_RADIUS);
+	}
+
+	mRigidBodies.Reset();
+	mPhysicsSteps = 0;
+	mPhysicsChecksum = 0;
+	mPhysics = true;
+}
+
+// Remove the bodies and send the object flying again
+void Scene::StopPhysics()
+{
+	mMovingObjects.Resize(1);
+	mMovingObjects.SetBounds(D3DXVECTOR3(-256.0f, 0.0f, -256.0f), D3DXVECTOR3(256.0f, 30.0f, 256.0f));
+	mMovingObjects.GetVelocitiesX()[mObjectMoverIndex] = mObjectVelocity.x;
+	mMovingObjects.GetVelocitiesY()[mObjectMoverIndex] = mObjectVelocity.y;
+	mMovingObjects.GetVelocitiesZ()[mObjectMoverIndex] = mObjectVelocity.z;
+	mPhysics = false;
+}
+
+// Advance the simulation by one fixed step. With physics on the solver sets the velocities from the
+// contacts first. Nothing here may depend on the frame time or the worker count, so that the same
+// steps with the same input give the same state, which the checksums make visible.
+void Scene::StepSimulation(float dt)
+{
+	if(mPhysics)
+	{
+		mCollisionDetector.Detect(mMovingObjects.GetPositionsX(), mMovingObjects.GetPositionsY(),
+								  mMovingObjects.GetPositionsZ(), mMovingObjects.GetRadii(),
+								  mMovingObjects.GetCount(), mJobSystem);
+		mRigidBodies.Step(mMovingObjects.GetVelocitiesX(), mMovingObjects.GetVelocitiesY(),
+						  mMovingObjects.GetVelocitiesZ(), mMovingObjects.GetRadii(), mMovingObjects.GetCount(),
+						  mCollisionDetector, dt, mJobSystem);
+	}
+
+	UpdateMovers(dt);
+
+	if(mPhysics)
+	{
+		++mPhysicsSteps;
+		if(mPhysicsSteps == C_PHYSICS_CHECKSUM_STEP)
+			mPhysicsChecksum = mRigidBodies.GetStatistics().Checksum;
+	}
+
+	++mSimulationSteps;
+	if(mSimulationSteps % C_CHECKSUM_INTERVAL == 0)
+	{
+		mMoverChecksum = mMovingObjects.GetChecksum();
+		mChecksumStep = mSimulationSteps;
+	}
+}
+
+// Start baking the floor's lightmap, the floor is lit from its top side
+void Scene::BeginFloorLightmap()
+{
+	const AABB& bounds = mFloor.GetBounds();
+
+	LightmapRect rect;
+	rect.Origin = D3DXVECTOR3(bounds.Min.x, bounds.Max.y, bounds.Max.z);
+	rect.AxisU = D3DXVECTOR3(bounds.Max.x - bounds.Min.x, 0.0f, 0.0f);
+	rect.AxisV = D3DXVECTOR3(0.0f, 0.0f, bounds.Min.z - bounds.Max.z);
+	rect.Normal = D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+	rect.Width = C_LIGHTMAP_SIZE;
+	rect.Height = C_LIGHTMAP_SIZE;
+
+	mLightmapTexels.resize(C_LIGHTMAP_SIZE * C_LIGHTMAP_SIZE * 2);
+	mLightBaker.BeginLightmap(rect, C_LIGHTMAP_AO_DISTANCE, C_LIGHTMAP_PASSES);
+}
+
+// Load the object's impostor atlas, or render it and save it for the next run when there is none
+void Scene::CreateImpostors()
+{
+	if(!mImpostorAtlas.Load(C_IMPOSTOR_FILENAME) || mImpostorAtlas.GetFramesPerSide() != C_IMPOSTOR_FRAMES ||
+	   mImpostorAtlas.GetFrameSize() != C_IMPOSTOR_FRAME_SIZE)
+	{
+		mObject->CreateImpostorAtlas(mImpostorAtlas, C_IMPOSTOR_FRAMES, C_IMPOSTOR_FRAME_SIZE, mJobSystem);
+		mImpostorAtlas.Save(C_IMPOSTOR_FILENAME);
+	}
+
+	mImpostorRenderer.Initialize(mDevice, mImpostorAtlas);
+}
+
+// Draw the casters of every cascade into its slice of the shadow map. The static casters are only
+// drawn into the cascades whose cached slice is out of date, the object is drawn every frame. When
+// the cascades are rasterized on the CPU all casters are rasterized and uploaded every frame.
+void Scene::DrawCascades(const D3DXVECTOR3& eyePos)
+{
+	Stopwatch timer;
+	timer.Start();
+	mShadowGpuTimer.Begin();
+
+	mShadowMap.BeginFrame();
+	mDepthPassQuery.Begin();
+
+	int numCascades = mShadowMap.GetCascadeCount();
+	mShadowStatistics.StaticRenders = 0;
+	mShadowStatistics.StaticCasters = 0;
+	mShadowStatistics.DepthPass = DepthPassStatistics();
+	if(mCpuShadows)
+		DrawCpuShadows();
+	else
+	{
+		for(int i = 0; i < numCascades; ++i)
+		{
+			if(mShadowMap.BeginStaticCascade(i, mStaticVersion))
+			{
+				DrawStaticCasters(i);
+				++mShadowStatistics.StaticRenders;
+			}
+		}
+
+		mShadowMap.CopyStaticCascades();
+
+		mCasterStatistics.Total = mObject->GetGroupCount() * numCascades;
+		mCasterStatistics.InLightFrustum = 0;
+		mCasterStatistics.Drawn = 0;
+		for(int i = 0; i < numCascades; ++i)
+		{
+			CullCasters(i);
+			mShadowMap.BeginCascade(i);
+			mObject->DrawShadows(&mShadowMap.GetViewProjectionMatrix(i), eyePos, mShadowStatistics.DepthPass);
+		}
+	}
+
+	mDepthPassQuery.End();
+
+	if(mShadowMap.UsesMoments())
+	{
+		mMomentGpuTimer.Begin();
+		mMomentFilter.Apply(mShadowMap);
+		mMomentGpuTimer.End();
+	}
+
+	mShadowGpuTimer.End();
+	mShadowStatistics.Milliseconds = timer.Stop().Milliseconds;
+}
+
+// Draw the depth of everything that reads the mask into the bound depth texture, then filter the
+// mask from it. The impostors do not receive shadows and are left out.
+void Scene::DrawShadowMask(const Camera& camera, PooledTexture* depthTexture)
+{
+	const D3DXMATRIX& vp = camera.GetViewProjectionMatrix();
+
+	mMaskGpuTimer.Begin();
+	mShadowMask.BeginDepth(depthTexture, mScreenShadows == ScreenShadowsHalf);
+
+	mObject->DrawDepth(&vp);
+	if(!mVisibleProps.empty())
+		mObject->DrawDepthInstances(&mVisibleProps[0], (int)mVisibleProps.size(), &vp);
+	if(mInstanceMode != InstancesHidden && !mInstanceWorlds.empty())
+		mObject->DrawDepthInstances(&mInstanceWorlds[0], (int)mInstanceWorlds.size(), &vp);
+	if(mFloor.IsVisible())
+		mFloor.DrawDepth(&vp);
+
+	mShadowMask.Apply(mShadowMap, camera);
+	mMaskGpuTimer.End();
+}
+
+// Draw everything that receives shadows into the bound targets
+void Scene::DrawReceivers(const Camera& camera)
+{
+	const D3DXMATRIX& vp = camera.GetViewProjectionMatrix();
+
+	mReceiverGpuTimer.Begin();
+	mObject->Draw(&vp, camera.GetPos());
+	if(!mVisibleProps.empty())
+		mObject->DrawInstances(&mVisibleProps[0], (int)mVisibleProps.size(), &vp, camera.GetPos());
+	if(mInstanceMode != InstancesHidden)
+		DrawInstances(vp, camera.GetPos());
+	if(mFloor.IsVisible())
+		mFloor.Draw(&vp);
+	mReceiverGpuTimer.End();
+
+	mScreenSquare.SetTexture(mShadowMap.GetSRV());
+	mScreenSquare.Draw();
+}
+
+// Sort the visible moving objects into meshes and impostors, before the mask's pre-pass draws them
+void Scene::GatherInstances(const D3DXMATRIX& proj, const D3DXVECTOR3& eyePos)
+{
+	Stopwatch timer;
+	timer.Start();
+
+	mInstanceWorlds.clear();
+	mImpostorInstances.clear();
+
+	// The visible list is only kept by the tree and the occlusion test
+	if(mTreeCulling || mOcclusionCulling)
+	{
+		for(size_t i = 0; i < mVisibleMovers.size(); ++i)
+			AddInstance(mVisibleMovers[i], proj._22, eyePos);
+	}
+	else
+	{
+		for(int i = 0; i < (int)mMoverVisibility.size(); ++i)
+		{
+			if(mMoverVisibility[i])
+				AddInstance(i, proj._22, eyePos);
+		}
+	}
+
+	mInstanceStatistics.Meshes = (int)mInstanceWorlds.size();
+	mInstanceStatistics.Impostors = (int)mImpostorInstances.size();
+	mInstanceStatistics.Milliseconds = timer.Stop().Milliseconds;
+}
+
+// Draw the object for every visible moving object except its own, scaled to the mover's radius.
+// With impostors on, the instances that cover less than the threshold of the view height are drawn
+// as impostors in a few batches and the rest as meshes, otherwise all of them are meshes.
+void Scene::DrawInstances(const D3DXMATRIX& viewProj, const D3DXVECTOR3& eyePos)
+{
+	Stopwatch timer;
+	timer.Start();
+
+	if(!mInstanceWorlds.empty())
+		mObject->DrawInstances(&mInstanceWorlds[0], (int)mInstanceWorlds.size(), &viewProj, eyePos);
+	if(!mImpostorInstances.empty())
+		mImpostorRenderer.Draw(&mImpostorInstances[0], (int)mImpostorInstances.size(), viewProj, eyePos, mLight.GetPosition());
+
+	mInstanceStatistics.Milliseconds += timer.Stop().Milliseconds;
+}
+
+// Put a moving object in the mesh or the impostor list. The screen size is the fraction of the view
+// height that the diameter covers, from the projection's y scale.
+void Scene::AddInstance(int mover, float projectionScale, const D3DXVECTOR3& eyePos)
+{
+	if(mover == mObjectMoverIndex)
+		return;
+
+	float radius = mMovingObjects.GetRadius(mover);
+	float scale = radius / mObject->GetBoundingRadius();
+	D3DXVECTOR3 toEye = eyePos - mMovingObjects.GetPosition(mover);
+	float distance = D3DXVec3Length(&toEye);
+
+	D3DXMATRIX world = mMovingObjects.GetInterpolatedWorldMatrix(mover, mTimestep.GetAlpha());
+	if(mInstanceMode == InstancesImpostors && radius * projectionScale < C_IMPOSTOR_SCREEN_SIZE * distance)
+	{
+		ImpostorInstance instance;
+		instance.Position = D3DXVECTOR3(world._41, world._42, world._43);
+		instance.Scale = scale;
+		instance.Cos = world._11;
+		instance.Sin = world._31;
+		mImpostorInstances.push_back(instance);
+	}
+	else
+	{
+		D3DXMATRIX scaling;
+		D3DXMatrixScaling(&scaling, scale, scale, scale);
+		mInstanceWorlds.push_back(scaling * world);
+	}
+}
+
 void Scene::ChangeDepthMap(int newIndex)
 {
 	mDepthMapIndex = newIndex;
 
-	mViewport.Width = mDepthMap[mDepthMapIndex]->C_WIDTH;
-	mViewport.Height = mDepthMap[mDepthMapIndex]->C_HEIGHT;
+	mShadowMap.Resize(C_SHADOW_MAP_SIZES[mDepthMapIndex], mShadowMap.GetCascadeCount());
+}
 
-	mFloor.SetDepthTexture(mDepthMap[mDepthMapIndex]);
-	mScreenSquare.SetTexture(mDepthMap[mDepthMapIndex]->SRV);
+void Scene::SetCascadeCount(int numCascades)
+{
+	mShadowMap.Resize(mShadowMap.GetSize(), numCascades);
 }
 
-DepthTexture* Scene::CreateDepthTexture(int width, int height)
+// Time every shadow filter at every cascade size, the size and filter are put back when done
+void Scene::StartFilterBenchmark()
 {
-	ID3D10DepthStencilView* dsv;
-	ID3D10ShaderResourceView* srv;
+	mFilterBenchmark.assign(C_SHADOW_MAP_SIZE_COUNT * ShadowFilterCount, 0.0);
+	mFilterBenchmarkStep = 0;
+	mFilterBenchmarkFrame = 0;
+	mFilterBenchmarkSum = 0.0;
+	mFilterBenchmarkDepthMap = mDepthMapIndex;
+	mFilterBenchmarkFilter = mShadowMap.GetFilter();
 
-	D3D10_TEXTURE2D_DESC desc;
-	desc.Width = width;
-	desc.Height = height;
-	desc.MipLevels = 1;
-	desc.ArraySize = 1;
-	desc.Format = DXGI_FORMAT_R32_TYPELESS;
-	desc.SampleDesc.Count = 1;
-	desc.SampleDesc.Quality = 0;
-	desc.Usage = D3D10_USAGE_DEFAULT;
-	desc.BindFlags = D3D10_BIND_DEPTH_STENCIL | D3D10_BIND_SHADER_RESOURCE;
-	desc.CPUAccessFlags = 0;
-	desc.MiscFlags = 0;
+	ChangeDepthMap(0);
+	mShadowMap.SetFilter((ShadowFilter)0);
+}
 
-	ID3D10Texture2D* depthTexture = NULL;
-	if(FAILED(mDevice->CreateTexture2D(&desc, NULL, &depthTexture)))
-		MessageBox(0, "Error Creating Depth Texture", "", 0);
+// Called once a frame. The timers lag behind the CPU, so the first frames of a configuration are
+// not counted.
+void Scene::StepFilterBenchmark()
+{
+	if(mFilterBenchmarkFrame >= C_FILTER_BENCHMARK_WARMUP)
+	{
+		mFilterBenchmarkSum += mShadowGpuTimer.GetMilliseconds() + mReceiverGpuTimer.GetMilliseconds();
+		if(mScreenShadows != ScreenShadowsOff)
+			mFilterBenchmarkSum += mMaskGpuTimer.GetMilliseconds();
+	}
 
-	D3D10_DEPTH_STENCIL_VIEW_DESC dsvDesc;
-	dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
-	dsvDesc.ViewDimension = D3D10_DSV_DIMENSION_TEXTURE2D;
-	dsvDesc.Texture2D.MipSlice = 0;
+	if(++mFilterBenchmarkFrame < C_FILTER_BENCHMARK_WARMUP + C_FILTER_BENCHMARK_FRAMES)
+		return;
 
-	if(FAILED(mDevice->CreateDepthStencilView(depthTexture, &dsvDesc, &dsv)))
-		MessageBox(0, "Error Creating Depth Stencil View", "", 0);
+	mFilterBenchmark[mFilterBenchmarkStep] = mFilterBenchmarkSum / C_FILTER_BENCHMARK_FRAMES;
+	mFilterBenchmarkFrame = 0;
+	mFilterBenchmarkSum = 0.0;
 
-	D3D10_SHADER_RESOURCE_VIEW_DESC srvDesc;
-	srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
-	srvDesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = 1;
+	if(++mFilterBenchmarkStep < (int)mFilterBenchmark.size())
+	{
+		ChangeDepthMap(mFilterBenchmarkStep / ShadowFilterCount);
+		mShadowMap.SetFilter((ShadowFilter)(mFilterBenchmarkStep % ShadowFilterCount));
+	}
+	else
+	{
+		mFilterBenchmarkStep = -1;
+		ChangeDepthMap(mFilterBenchmarkDepthMap);
+		mShadowMap.SetFilter(mFilterBenchmarkFilter);
+	}
+}
 
-	if(FAILED(mDevice->CreateShaderResourceView(depthTexture, &srvDesc, &srv)))
-		MessageBox(0, "Error Creating Depth Shader Resource View", "", 0);
+// Stand copies of the object on the floor at places hashed from their index. They are the static
+// shadow casters and the occluders of the floor's lightmap.
+void Scene::CreateStaticProps()
+{
+	float floorY = mFloor.GetBounds().Max.y - mObject->GetBounds().Min.y;
+	D3DXVECTOR3 center = mFloor.GetBounds().GetCenter();
 
-	SafeRelease(depthTexture);
+	mStaticProps.resize(C_STATIC_PROPS);
+	for(int i = 0; i < C_STATIC_PROPS; ++i)
+	{
+		unsigned int seed = 1000003u + i * 3;
+		D3DXMATRIX rotation;
+		D3DXMATRIX translation;
+		D3DXMatrixRotationY(&rotation, HashUnit(seed) * 6.28f);
+		D3DXMatrixTranslation(&translation, center.x + (HashUnit(seed + 1) * 2.0f - 1.0f) * C_STATIC_PROP_AREA, floorY,
+							  center.z + (HashUnit(seed + 2) * 2.0f - 1.0f) * C_STATIC_PROP_AREA);
+		mStaticProps[i] = rotation * translation;
+	}
 
-	return new DepthTexture(static_cast<float>(width), static_cast<float>(height), dsv, srv);
+	SetStaticProps(mShowStaticProps);
 }
 
-void Scene::CreateLightMatrices()
+// Show or hide the props. Either way the static shadows are drawn again and the lightmap is baked
+// again with the props that are shown.
+void Scene::SetStaticProps(bool show)
 {
-	D3DXMatrixLookAtLH(&mLightViewMatrix, &mLightDirection, &D3DXVECTOR3(0.0f, 0.0f, 0.0f), &D3DXVECTOR3(0.0f, 1.0f, 0.0f));
-	D3DXMatrixOrthoLH(&mLightProjMatrix, 1000.0f, 1000.0f, 1.0f, 1000.0f);
+	mShowStaticProps = show;
+	++mStaticVersion;
+
+	mLightBaker.ClearOccluders();
+	if(mShowStaticProps)
+	{
+		for(size_t i = 0; i < mStaticProps.size(); ++i)
+			mLightBaker.AddOccluder(&mObject->GetBVH(), mStaticProps[i]);
+	}
+
+	BeginFloorLightmap();
 }
 
-void Scene::SetupShadowMapDrawing()
+// Draw the props inside a cascade into its static slice
+void Scene::DrawStaticCasters(int cascade)
 {
-	ID3D10RenderTargetView* renderTargets[1] = { NULL };
-	mDevice->OMSetRenderTargets(1, renderTargets, mDepthMap[mDepthMapIndex]->DSV);
+	if(!mShowStaticProps)
+		return;
+
+	FrustumPlanes lightFrustum = mShadowMap.GetFrustumPlanes(cascade);
+	lightFrustum.Planes[FrustumPlanes::Near] = D3DXPLANE(0.0f, 0.0f, 0.0f, 1.0f);
 
-	mDevice->RSSetViewports(1, &mViewport);
-	mDevice->ClearDepthStencilView(mDepthMap[mDepthMapIndex]->DSV, D3D10_CLEAR_DEPTH, 1.0f, 0);
+	mStaticCasters.clear();
+	for(size_t i = 0; i < mStaticProps.size(); ++i)
+	{
+		if(lightFrustum.TestBox(mObject->GetBounds().Transform(mStaticProps[i])))
+			mStaticCasters.push_back(mStaticProps[i]);
+	}
+
+	if(!mStaticCasters.empty())
+		mObject->DrawShadowInstances(&mStaticCasters[0], (int)mStaticCasters.size(), &mShadowMap.GetViewProjectionMatrix(cascade),
+									 mShadowStatistics.DepthPass);
+	mShadowStatistics.StaticCasters += (int)mStaticCasters.size();
 }
 
+// The benchmark's spot lights, rows of them over the floor looking down. Every few lights sway and
+// some have a higher priority, which gives them larger tiles that are drawn more often.
+void Scene::CreateSpotLights()
+{
+	const AABB& floor = mFloor.GetBounds();
+	float spacingX = (floor.Max.x - floor.Min.x) / C_SPOT_LIGHT_ROW_SIZE;
+	float spacingZ = (floor.Max.z - floor.Min.z) / (C_SPOT_LIGHTS / C_SPOT_LIGHT_ROW_SIZE);
+
+	mSpotLights.resize(C_SPOT_LIGHTS);
+	for(int i = 0; i < C_SPOT_LIGHTS; ++i)
+	{
+		unsigned int seed = 2000003u + i * 3;
+		SpotLight& light = mSpotLights[i];
+		light.Position = D3DXVECTOR3(floor.Min.x + (i % C_SPOT_LIGHT_ROW_SIZE + 0.5f) * spacingX,
+									 floor.Max.y + C_SPOT_LIGHT_HEIGHT,
+									 floor.Min.z + (i / C_SPOT_LIGHT_ROW_SIZE + 0.5f) * spacingZ);
+		light.Direction = D3DXVECTOR3(0.0f, -1.0f, 0.0f);
+		light.Color = D3DXVECTOR3(HashUnit(seed), HashUnit(seed + 1), HashUnit(seed + 2)) * 0.6f;
+		light.Range = C_SPOT_LIGHT_RANGE;
+		light.Angle = C_SPOT_LIGHT_ANGLE;
+		light.Priority = i % 5 == 0 ? 2.0f : 1.0f;
+	}
+
+	mSpotLightSeconds = 0.0;
+	UpdateSpotLights(0.0f);
+}
+
+void Scene::UpdateSpotLights(float dt)
+{
+	mSpotLightSeconds += dt;
+	for(int i = 0; i < (int)mSpotLights.size(); i += C_SWAYING_SPOT_LIGHT_STEP)
+	{
+		float phase = (float)mSpotLightSeconds * C_SPOT_LIGHT_SWAY_SPEED + i;
+		D3DXVECTOR3 direction(sinf(phase) * 0.3f, -1.0f, cosf(phase) * 0.3f);
+		D3DXVec3Normalize(&mSpotLights[i].Direction, &direction);
+	}
+}
+
+// Draw the casters into the tiles the atlas picked this frame, the other tiles keep their depth. The
+// object and the props cast, the floor only receives.
+void Scene::DrawAtlasTiles()
+{
+	mShadowStatistics.AtlasCasters = 0;
+	mShadowStatistics.AtlasPass = DepthPassStatistics();
+
+	const std::vector<int>& updates = mShadowAtlas.GetUpdates();
+	for(size_t i = 0; i < updates.size(); ++i)
+	{
+		int light = updates[i];
+		const FrustumPlanes& lightFrustum = mShadowAtlas.GetFrustumPlanes(light);
+
+		mAtlasCasters.clear();
+		if(lightFrustum.TestBox(mObject->GetBounds().Transform(mObject->GetWorldMatrix())))
+			mAtlasCasters.push_back(mObject->GetWorldMatrix());
+		for(size_t j = 0; j < mStaticProps.size() && mShowStaticProps; ++j)
+		{
+			if(lightFrustum.TestBox(mObject->GetBounds().Transform(mStaticProps[j])))
+				mAtlasCasters.push_back(mStaticProps[j]);
+		}
+
+		mShadowAtlas.BeginTile(light);
+		if(!mAtlasCasters.empty())
+			mObject->DrawShadowInstances(&mAtlasCasters[0], (int)mAtlasCasters.size(),
+										 &mShadowAtlas.GetViewProjectionMatrix(light), mShadowStatistics.AtlasPass);
+		mShadowStatistics.AtlasCasters += (int)mAtlasCasters.size();
+	}
+}
+
+// Receive the light's shadows from the cube instead of the cascades, or go back to the cascades
+void Scene::SetPointShadows(PointShadowMode mode)
+{
+	mPointShadows = mode;
+
+	const PointShadowMap* pointShadowMap = mode != PointShadowsOff ? &mPointShadowMap : NULL;
+	mObject->SetPointShadowMap(pointShadowMap);
+	mFloor.SetPointShadowMap(pointShadowMap);
+}
+
+// Draw the object and the props into every face of the light's cube, either all faces in one pass
+// or each face in a pass of its own
+void Scene::DrawPointShadows()
+{
+	mPointCasters.clear();
+	mPointCasters.push_back(mObject->GetWorldMatrix());
+	if(mShowStaticProps)
+		mPointCasters.insert(mPointCasters.end(), mStaticProps.begin(), mStaticProps.end());
+
+	PointShadowStatistics& statistics = mPointShadowStatistics[mPointShadows];
+	statistics.DepthPass = DepthPassStatistics();
+	statistics.CasterTriangles = (int)(mObject->GetTriangleVertices().size() / 3 * mPointCasters.size());
+
+	if(mPointShadows == PointShadowsSinglePass)
+	{
+		mPointShadowMap.BeginCube();
+		mObject->DrawCubeShadowInstances(&mPointCasters[0], (int)mPointCasters.size(), mPointShadowMap,
+										 statistics.DepthPass);
+		statistics.Passes = 1;
+	}
+	else
+	{
+		for(int i = 0; i < PointShadowMap::FaceCount; ++i)
+		{
+			mPointShadowMap.BeginFace(i);
+			mObject->DrawCubeFaceShadowInstances(&mPointCasters[0], (int)mPointCasters.size(), mPointShadowMap, i,
+												 statistics.DepthPass);
+		}
+		statistics.Passes = PointShadowMap::FaceCount;
+	}
+}
+
+// Rasterize the object and the props in a cascade's light frustum on the CPU, returns the number of
+// casters added
+int Scene::RasterizeCascade(int cascade)
+{
+	mShadowRasterizer.BeginFrame(mShadowMap.GetViewProjectionMatrix(cascade));
+
+	const std::vector<D3DXVECTOR3>& vertices = mObject->GetTriangleVertices();
+	if(vertices.empty())
+		return 0;
+
+	mShadowRasterizer.AddCaster(&vertices[0], (int)vertices.size(), mObject->GetWorldMatrix());
+	int numCasters = 1;
+	if(mShowStaticProps)
+	{
+		FrustumPlanes lightFrustum = mShadowMap.GetFrustumPlanes(cascade);
+		lightFrustum.Planes[FrustumPlanes::Near] = D3DXPLANE(0.0f, 0.0f, 0.0f, 1.0f);
+
+		for(size_t i = 0; i < mStaticProps.size(); ++i)
+		{
+			if(lightFrustum.TestBox(mObject->GetBounds().Transform(mStaticProps[i])))
+			{
+				mShadowRasterizer.AddCaster(&vertices[0], (int)vertices.size(), mStaticProps[i]);
+				++numCasters;
+			}
+		}
+	}
+
+	mShadowRasterizer.Rasterize(mJobSystem);
+	return numCasters;
+}
+
+// Rasterize every cascade on the CPU and write it into its slice of the shadow map
+void Scene::DrawCpuShadows()
+{
+	if(mShadowRasterizer.GetSize() != mShadowMap.GetSize())
+		mShadowRasterizer.Resize(mShadowMap.GetSize());
+
+	// The rasterizer takes whole objects, not groups, and only culls them against the light frustum
+	int numCascades = mShadowMap.GetCascadeCount();
+	mCasterStatistics.Total = (1 + (mShowStaticProps ? (int)mStaticProps.size() : 0)) * numCascades;
+	mCasterStatistics.InLightFrustum = 0;
+	mCasterStatistics.Drawn = 0;
+
+	ZeroMemory(&mRasterizerStatistics, sizeof(mRasterizerStatistics));
+	for(int i = 0; i < numCascades; ++i)
+	{
+		Stopwatch timer;
+		timer.Start();
+		int numCasters = RasterizeCascade(i);
+		mCasterStatistics.InLightFrustum += numCasters;
+		mCasterStatistics.Drawn += numCasters;
+		mRasterizerStatistics.Milliseconds += timer.Stop().Milliseconds;
+		mRasterizerStatistics.Triangles += mShadowRasterizer.GetTriangleCount();
+		mRasterizerStatistics.Culled += mShadowRasterizer.GetCulledTriangleCount();
+
+		mShadowMap.BeginCascade(i);
+		mDepthUpload.Upload(mShadowRasterizer.GetDepthBuffer(), mShadowRasterizer.GetSize());
+	}
+}
+
+// Rasterize the first cascade at every shadow map size and record how long it took
+void Scene::RunRasterizerBenchmark()
+{
+	mRasterizerBenchmark.clear();
+
+	for(int s = 0; s < C_SHADOW_MAP_SIZE_COUNT; ++s)
+	{
+		mShadowRasterizer.Resize(C_SHADOW_MAP_SIZES[s]);
+
+		Stopwatch timer;
+		timer.Start();
+		for(int i = 0; i < C_RASTERIZER_BENCHMARK_RUNS; ++i)
+			RasterizeCascade(0);
+
+		RasterizerBenchmarkResult result;
+		result.Size = mShadowRasterizer.GetSize();
+		result.Triangles = mShadowRasterizer.GetTriangleCount() + mShadowRasterizer.GetCulledTriangleCount();
+		result.Milliseconds = timer.Stop().Milliseconds / C_RASTERIZER_BENCHMARK_RUNS;
+		mRasterizerBenchmark.push_back(result);
+	}
+
+	mShadowRasterizer.Resize(mShadowMap.GetSize());
+}
@@ -1,45 +1,382 @@
 #ifndef SCENE_H
 #define SCENE_H
 
-#include <D3D10.h>
 #include <vector>
 #include <string>
 
 #include "Object3D.h"
+#include "MovingObjectStore.h"
+#include "JobSystem.h"
+#include "DynamicAABBTree.h"
+#include "CollisionDetector.h"
+#include "RigidBodySolver.h"
+#include "LightBaker.h"
+#include "ImpostorRenderer.h"
 #include "Floor.h"
 #include "ScreenSquare.h"
 #include "GameTime.h"
 #include "Camera.h"
+#include "Light.h"
+#include "RenderDevice.h"
+#include "RenderTargetPool.h"
+#include "CascadedShadowMap.h"
+#include "ShadowMomentFilter.h"
+#include "ShadowMask.h"
+#include "ShadowAtlas.h"
+#include "PointShadowMap.h"
+#include "ShadowRasterizer.h"
+#include "DepthUpload.h"
+#include "FrameGraph.h"
+#include "GpuTimer.h"
+#include "PipelineStatisticsQuery.h"
 
 class Scene
 {
 public:
-	Scene(ID3D10Device* device, const int& screenWidth);
+	enum ScreenShadowMode
+	{
+		ScreenShadowsOff,				// Every receiver pixel filters the cascades
+		ScreenShadowsFull,
+		ScreenShadowsHalf				// Filtered at half resolution, upsampled along the depth
+	};
+
+	enum PointShadowMode
+	{
+		PointShadowsOff,				// The receivers use the cascades
+		PointShadowsSinglePass,			// A geometry shader sends each triangle to its faces
+		PointShadowsSixPasses,
+		PointShadowModeCount
+	};
+
+	enum InstanceMode
+	{
+		InstancesHidden,
+		InstancesMeshes,			// Every instance as a mesh
+		InstancesImpostors			// Impostors for the instances below the screen size threshold
+	};
+
+	Scene(RenderDevice* device, const int& screenWidth);
+	~Scene();
 	void Update(const GameTime& gameTime);
-	void DrawShadows(const D3DXVECTOR3& eyePos);
-	void Draw(const Camera& camera);
+	void Cull(const Camera& camera);
+	void AddPasses(FrameGraph& graph, const Camera& camera, int colorTarget, int depthTarget);
+	void EndFrame();
+	bool RayCast(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance, RayHit& hit) const;
+	void Pick(const Camera& camera, int x, int y, int width, int height);
 
+	RenderTargetPool& GetRenderTargetPool();
 	std::string GetInfoString() const;
+	int GetCulledCount() const;
+	int GetVisibleCount() const;
+
+	// Settings and benchmarks, switched by SceneController
+	void ChangeDepthMap(int newIndex);
+	void SetCascadeCount(int numCascades);
+	void SetShadowFilter(ShadowFilter filter);
+	void SetScreenShadows(ScreenShadowMode mode);
+	void SetPointShadows(PointShadowMode mode);
+	void SetCpuShadows(bool cpuShadows);
+	void SetStaticProps(bool show);
+	bool IsShowingStaticProps() const;
+	void CreateSpotLights();
+	bool HasSpotLights() const;
+	void SetAtlasUnlimited(bool unlimited);
+	void SetBakedLighting(bool baked);
+	void SetInstanceMode(InstanceMode mode);
+	void SetPositionStreams(bool positionStreams);
+	void SetMoverSIMD(bool simd);
+	void AddBenchmarkMovers(int count);
+	void RemoveBenchmarkMovers();
+	int GetMoverCount() const;
+	void StartPhysics(int numBodies);
+	void StopPhysics();
+	bool IsPhysicsRunning() const;
+	void SetCollisionDetection(bool detect);
+	void SetWorkerCount(int numWorkers);
+	int GetWorkerCount() const;
+	void SetTreeCulling(bool useTree);
+	void SetOcclusionCulling(bool occlusionCulling);
+	void StartFilterBenchmark();
+	bool IsFilterBenchmarkRunning() const;
+	void RunRasterizerBenchmark();
+	bool HasRasterizerBenchmark() const;
 
 private:
 	// Light variables
-	D3DXVECTOR3						mLightDirection;
-	D3DXMATRIX						mLightViewMatrix;
-	D3DXMATRIX						mLightProjMatrix;
+	Light							mLight;
 	
-	// Depth map variables
-	D3D10_VIEWPORT					mViewport;
-	std::vector<DepthTexture*>		mDepthMap;
-	int								mDepthMapIndex;
+	// Render targets shared by the passes, must outlive everything that holds one of them
+	RenderTargetPool				mRenderTargets;
+
+	// What the passes of the frame graph are called with, set by AddPasses
+	struct FramePassData
+	{
+		Scene*						Owner;
+		const Camera*				View;
+		const FrameGraph*			Graph;
+		int							MaskDepth;				// Transient depth of the shadow mask
+	};
+
+	FramePassData					mFramePassData;
+
+	// Shadow cascades
+	CascadedShadowMap				mShadowMap;
+	ShadowMomentFilter				mMomentFilter;
+	int								mDepthMapIndex;			// Size of the cascades, from C_SHADOW_MAP_SIZES
+
+	// Shadows filtered once per screen pixel after a depth pre-pass, read by the receivers
+	ShadowMask						mShadowMask;
+	ScreenShadowMode				mScreenShadows;
+
+	// Spot lights with their shadows in tiles of one atlas, a few tiles are drawn per frame
+	ShadowAtlas						mShadowAtlas;
+	std::vector<SpotLight>			mSpotLights;
+	double							mSpotLightSeconds;		// Drives the swaying lights
+	std::vector<D3DXMATRIX>			mAtlasCasters;			// In the tile being drawn
+	GpuTimer						mAtlasGpuTimer;
+
+	// The light's shadow from a cube around it, drawn in one pass or one pass per face
+	struct PointShadowStatistics
+	{
+		int							Passes;
+		int							CasterTriangles;		// In the casters, each counted once
+		DepthPassStatistics			DepthPass;
+		RenderPipelineStatistics	Pipeline;				// From a few frames back
+		double						GpuMilliseconds;
+	};
+
+	PointShadowMap					mPointShadowMap;
+	PointShadowMode					mPointShadows;
+	PointShadowStatistics			mPointShadowStatistics[PointShadowModeCount];	// The last frame of each mode
+	std::vector<D3DXMATRIX>			mPointCasters;
+	GpuTimer						mPointGpuTimer;
+	PipelineStatisticsQuery			mPointQuery;
+
+	// The cascades rasterized on the CPU and uploaded instead of drawn by the GPU
+	struct RasterizerStatistics
+	{
+		int							Triangles;				// Rasterized, in every cascade
+		int							Culled;
+		double						Milliseconds;			// Setup and rasterization, not the upload
+	};
+
+	struct RasterizerBenchmarkResult
+	{
+		int							Size;
+		int							Triangles;				// Submitted
+		double						Milliseconds;
+	};
+
+	ShadowRasterizer				mShadowRasterizer;
+	DepthUpload						mDepthUpload;
+	bool							mCpuShadows;
+	RasterizerStatistics			mRasterizerStatistics;
+	std::vector<RasterizerBenchmarkResult>	mRasterizerBenchmark;
+
+	// GPU time of the shadow pass, of its moment filter, of the mask and its pre-pass and of the receivers
+	GpuTimer						mShadowGpuTimer;
+	GpuTimer						mMomentGpuTimer;
+	GpuTimer						mMaskGpuTimer;
+	GpuTimer						mReceiverGpuTimer;
+	PipelineStatisticsQuery			mDepthPassQuery;
+
+	// Shadow pass and receiver time of every filter at every cascade size, filters vary fastest
+	std::vector<double>				mFilterBenchmark;
+	int								mFilterBenchmarkStep;	// -1 when not running
+	int								mFilterBenchmarkFrame;
+	double							mFilterBenchmarkSum;
+	int								mFilterBenchmarkDepthMap;	// Restored when done
+	ShadowFilter					mFilterBenchmarkFilter;
+
+	// Copies of the object standing on the floor, the static shadow casters
+	std::vector<D3DXMATRIX>			mStaticProps;
+	std::vector<D3DXMATRIX>			mVisibleProps;
+	std::vector<D3DXMATRIX>			mStaticCasters;			// Props in the cascade being drawn
+	bool							mShowStaticProps;
+	unsigned int					mStaticVersion;			// Changes with the set of static casters
+
+	// Jobs
+	JobSystem*						mJobSystem;
+	JobStatistics					mJobStatistics;
+
+	// Moving objects
+	struct MoverUpdateData
+	{
+		MovingObjectStore*			Store;
+		float						DeltaTime;
+	};
+
+	MovingObjectStore				mMovingObjects;
+	MoverUpdateData					mMoverUpdateData;
 
-	ID3D10Device*					mDevice;
+	// Fixed rate simulation, drawn interpolated between the last two steps
+	FixedTimestep					mTimestep;
+	int								mSimulationSteps;
+	int								mChecksumStep;			// Step the mover checksum was taken at
+	unsigned int					mMoverChecksum;
+
+	// Collisions
+	CollisionDetector				mCollisionDetector;
+	bool							mCollisionDetection;
+
+	// Physics
+	RigidBodySolver					mRigidBodies;
+	bool							mPhysics;
+	int								mPhysicsSteps;
+	unsigned int					mPhysicsChecksum;		// Solver checksum at C_PHYSICS_CHECKSUM_STEP
+	D3DXVECTOR3						mObjectVelocity;
+
+	// Picking
+	bool							mPicked;
+	RayHit							mPickHit;
+	D3DXVECTOR3						mPickPoint;
+	std::string						mPickGroup;
+	double							mPickMilliseconds;
+
+	// Baked lighting
+	LightBaker						mLightBaker;
+	std::vector<unsigned char>		mLightmapTexels;
+
+	// Instances of the object drawn for the moving objects
+	struct InstanceStatistics
+	{
+		int							Meshes;
+		int							Impostors;
+		double						Milliseconds;		// CPU time to sort and submit the instances
+	};
+
+	ImpostorAtlas					mImpostorAtlas;
+	ImpostorRenderer				mImpostorRenderer;
+	InstanceMode					mInstanceMode;
+	InstanceStatistics				mInstanceStatistics;
+	std::vector<D3DXMATRIX>			mInstanceWorlds;
+	std::vector<ImpostorInstance>	mImpostorInstances;
+
+	// Culling
+	struct MoverCullData
+	{
+		const FrustumPlanes*		Frustum;
+		const MovingObjectStore*	Store;
+		unsigned char*				Visible;
+		volatile long				NumVisible;
+	};
+
+	struct CullingStatistics
+	{
+		int							Tested;
+		int							Visible;
+		double						Milliseconds;
+	};
+
+	struct MoverTreeData
+	{
+		DynamicAABBTree*			Tree;
+		const MovingObjectStore*	Store;
+		const int*					Proxies;
+	};
+
+	struct MoverOcclusionData
+	{
+		const OcclusionCuller*		Culler;
+		const MovingObjectStore*	Store;
+		const int*					Movers;
+		unsigned char*				Visible;
+		const Stopwatch*			Timer;
+		double						BudgetMilliseconds;
+		volatile long				NumOccluded;
+		volatile long				NumUntested;
+	};
+
+	struct OcclusionStatistics
+	{
+		int							Tested;
+		int							Occluded;
+		int							Untested;			// Left visible because the time budget ran out
+		int							Triangles;
+		double						Milliseconds;
+	};
+
+	MoverCullData					mMoverCullData;
+	MoverTreeData					mMoverTreeData;
+	std::vector<unsigned char>		mMoverVisibility;
+	DynamicAABBTree					mMoverTree;
+	std::vector<int>				mMoverProxies;
+	std::vector<int>				mVisibleMovers;
+	bool							mTreeCulling;
+	double							mTreeUpdateMilliseconds;
+
+	OcclusionCuller					mOcclusionCuller;
+	MoverOcclusionData				mMoverOcclusionData;
+	std::vector<unsigned char>		mMoverOcclusion;
+	OcclusionStatistics				mOcclusionStatistics;
+	Stopwatch						mOcclusionTimer;
+	bool							mOcclusionCulling;
+	unsigned int					mFloorCullVersion;		// Camera version the floor was last tested at
+	bool							mFloorInFrustum;
+
+	// Shadow casters
+	struct CasterStatistics
+	{
+		int							Total;
+		int							InLightFrustum;
+		int							Drawn;
+	};
+
+	CasterStatistics				mCasterStatistics;
+
+	struct ShadowStatistics
+	{
+		int							StaticRenders;			// Static cascades drawn again this frame
+		int							StaticCasters;
+		DepthPassStatistics			DepthPass;				// Static and dynamic casters
+		int							AtlasCasters;			// Drawn into the tiles of the shadow atlas
+		DepthPassStatistics			AtlasPass;
+		double						Milliseconds;			// All of the cascade pass
+	};
+
+	ShadowStatistics				mShadowStatistics;
+	CullingStatistics				mCullingStatistics;
+	Stopwatch						mCullTimer;
+	int								mObjectMoverIndex;
+	Stopwatch						mUpdateTimer;
+	Time							mMovingObjectsTime;
+
+	RenderDevice*					mDevice;
 	Object3D*						mObject;
 	Floor							mFloor;
 	ScreenSquare					mScreenSquare;
 
-	void ChangeDepthMap(int newIndex);
-	DepthTexture* CreateDepthTexture(int width, int height);
-	void CreateLightMatrices();
-	void SetupShadowMapDrawing();
+	static void UpdateMoversJob(void* data, int first, int count);
+	static void CullMoversJob(void* data, int first, int count);
+	static void MoveProxiesJob(void* data, int first, int count);
+	static void OccludeMoversJob(void* data, int first, int count);
+	static void CascadePass(void* data);
+	static void AtlasPass(void* data);
+	static void PointShadowPass(void* data);
+	static void ShadowMaskPass(void* data);
+	static void ReceiverPass(void* data);
+
+	void UpdateMovers(float dt);
+	void StepSimulation(float dt);
+	void BeginFloorLightmap();
+	void CreateImpostors();
+	void GatherInstances(const D3DXMATRIX& proj, const D3DXVECTOR3& eyePos);
+	void DrawInstances(const D3DXMATRIX& viewProj, const D3DXVECTOR3& eyePos);
+	void DrawCascades(const D3DXVECTOR3& eyePos);
+	void DrawShadowMask(const Camera& camera, PooledTexture* depthTexture);
+	void DrawReceivers(const Camera& camera);
+	void AddInstance(int mover, float projectionScale, const D3DXVECTOR3& eyePos);
+	void UpdateMoverTree();
+	void CullView(const Camera& camera);
+	int CullOccluded(const D3DXMATRIX& viewProj, const D3DXVECTOR3& eyePos);
+	void CullCasters(int cascade);
+	void StepFilterBenchmark();
+	void CreateStaticProps();
+	void DrawStaticCasters(int cascade);
+	void UpdateSpotLights(float dt);
+	void DrawAtlasTiles();
+	void DrawPointShadows();
+	int RasterizeCascade(int cascade);
+	void DrawCpuShadows();
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "SceneController.h"
+#include "Threading.h"
+
+const int C_BENCHMARK_MOVERS = 1000000;
+const int C_INSTANCE_BENCHMARK_MOVERS = 100000;
+const int C_PHYSICS_BODIES = 10000;
+
+SceneController::SceneController()
+{
+}
+
+void SceneController::Update(Scene& scene)
+{
+	UpdateShadows(scene);
+	UpdateSimulation(scene);
+	UpdateCulling(scene);
+}
+
+bool SceneController::IsDown(int key)
+{
+	return GetAsyncKeyState(key) != 0;
+}
+
+// Cascade size and count, filters, the screen-space mask, spot and point light shadows
+void SceneController::UpdateShadows(Scene& scene)
+{
+	if(IsDown('1'))
+		scene.ChangeDepthMap(0);
+	else if(IsDown('2'))
+		scene.ChangeDepthMap(1);
+	else if(IsDown('3'))
+		scene.ChangeDepthMap(2);
+	else if(IsDown('4'))
+		scene.ChangeDepthMap(3);
+	else if(IsDown('5'))
+		scene.SetCascadeCount(2);
+	else if(IsDown('6'))
+		scene.SetCascadeCount(3);
+	else if(IsDown('7'))
+		scene.SetCascadeCount(4);
+	else if(IsDown('J') && scene.IsShowingStaticProps())
+		scene.SetStaticProps(false);
+	else if(IsDown('G') && !scene.IsShowingStaticProps())
+		scene.SetStaticProps(true);
+	else if(IsDown(VK_F1))
+		scene.SetShadowFilter(ShadowFilter2x2);
+	else if(IsDown(VK_F2))
+		scene.SetShadowFilter(ShadowFilter3x3);
+	else if(IsDown('8'))
+		scene.SetShadowFilter(ShadowFilter5x5);
+	else if(IsDown('9'))
+		scene.SetShadowFilter(ShadowFilterPoisson);
+	else if(IsDown('0'))
+		scene.SetShadowFilter(ShadowFilterVSM);
+	else if(IsDown('V'))
+		scene.SetShadowFilter(ShadowFilterEVSM);
+	else if(IsDown('T') && !scene.IsFilterBenchmarkRunning())
+		scene.StartFilterBenchmark();
+	else if(IsDown('K'))
+		scene.SetBakedLighting(false);
+	else if(IsDown('L'))
+		scene.SetBakedLighting(true);
+	else if(IsDown(VK_DELETE))
+		scene.SetScreenShadows(Scene::ScreenShadowsOff);
+	else if(IsDown(VK_INSERT))
+		scene.SetScreenShadows(Scene::ScreenShadowsFull);
+	else if(IsDown(VK_HOME))
+		scene.SetScreenShadows(Scene::ScreenShadowsHalf);
+	else if(IsDown(VK_END) && !scene.HasSpotLights())
+		scene.CreateSpotLights();
+	else if(IsDown(VK_PRIOR))
+		scene.SetAtlasUnlimited(true);
+	else if(IsDown(VK_NEXT))
+		scene.SetAtlasUnlimited(false);
+	else if(IsDown(VK_LEFT))
+		scene.SetPointShadows(Scene::PointShadowsOff);
+	else if(IsDown(VK_UP))
+		scene.SetPointShadows(Scene::PointShadowsSinglePass);
+	else if(IsDown(VK_DOWN))
+		scene.SetPointShadows(Scene::PointShadowsSixPasses);
+	else if(IsDown(VK_TAB))
+		scene.SetCpuShadows(false);
+	else if(IsDown(VK_SPACE))
+		scene.SetCpuShadows(true);
+	else if(IsDown('F') && !scene.HasRasterizerBenchmark())
+		scene.RunRasterizerBenchmark();
+}
+
+// Moving objects, physics, collisions and the worker count
+void SceneController::UpdateSimulation(Scene& scene)
+{
+	bool onlyObject = scene.GetMoverCount() == 1 && !scene.IsPhysicsRunning();
+
+	if(IsDown(VK_F3))
+		scene.SetMoverSIMD(false);
+	else if(IsDown(VK_F4))
+		scene.SetMoverSIMD(true);
+	else if(IsDown('B') && onlyObject)
+		scene.AddBenchmarkMovers(C_BENCHMARK_MOVERS);
+	else if(IsDown('H') && onlyObject)
+		scene.AddBenchmarkMovers(C_INSTANCE_BENCHMARK_MOVERS);
+	else if(IsDown('N') && !scene.IsPhysicsRunning())
+		scene.RemoveBenchmarkMovers();
+	else if(IsDown('P') && !scene.IsPhysicsRunning())
+		scene.StartPhysics(C_PHYSICS_BODIES);
+	else if(IsDown('O') && scene.IsPhysicsRunning())
+		scene.StopPhysics();
+	else if(IsDown(VK_F5) && scene.GetWorkerCount() != 1)
+		scene.SetWorkerCount(1);
+	else if(IsDown(VK_F6) && scene.GetWorkerCount() != Thread::GetHardwareThreadCount())
+		scene.SetWorkerCount(0);
+	else if(IsDown('X'))
+		scene.SetCollisionDetection(false);
+	else if(IsDown('C'))
+		scene.SetCollisionDetection(true);
+}
+
+// Frustum, tree and occlusion culling, the depth streams and the instances
+void SceneController::UpdateCulling(Scene& scene)
+{
+	if(IsDown(VK_F7))
+		scene.SetTreeCulling(false);
+	else if(IsDown(VK_F8))
+		scene.SetTreeCulling(true);
+	else if(IsDown(VK_F9))
+		scene.SetOcclusionCulling(false);
+	else if(IsDown(VK_F10))
+		scene.SetOcclusionCulling(true);
+	else if(IsDown(VK_F11))
+		scene.SetPositionStreams(false);
+	else if(IsDown('Z'))
+		scene.SetPositionStreams(true);
+	else if(IsDown('U'))
+		scene.SetInstanceMode(Scene::InstancesHidden);
+	else if(IsDown('Y'))
+		scene.SetInstanceMode(Scene::InstancesMeshes);
+	else if(IsDown('I'))
+		scene.SetInstanceMode(Scene::InstancesImpostors);
+}
@@ -0,0 +1,20 @@
+#ifndef SCENE_CONTROLLER_H
+#define SCENE_CONTROLLER_H
+
+#include "Scene.h"
+
+// The keys that switch the scene's settings and start its benchmarks. Of the shadow, simulation and
+// culling keys only the first one found down in each group is handled each frame.
+class SceneController
+{
+public:
+	SceneController();
+	void Update(Scene& scene);
+
+private:
+	static bool IsDown(int key);
+	void UpdateShadows(Scene& scene);
+	void UpdateSimulation(Scene& scene);
+	void UpdateCulling(Scene& scene);
+};
+#endif
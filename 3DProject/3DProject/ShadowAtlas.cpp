@@ -0,0 +1,233 @@
+#include "ShadowAtlas.h"
+#include <cmath>
+
+const char* ShadowAtlas::C_FILENAME = "ShadowAtlas.fx";
+
+ShadowAtlas::ShadowAtlas()
+	: mDevice(0), mPool(0), mTexture(0), mEffect(0), mClearTechnique(0), mSize(0)
+{
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+	if(mDevice != NULL)
+		mDevice->ReleaseEffect(mEffect);
+	if(mPool != NULL)
+		mPool->Release(mTexture);
+}
+
+void ShadowAtlas::Initialize(RenderDevice* device, RenderTargetPool* pool, int size, int minTileSize, int maxTileSize,
+							 int updatesPerFrame)
+{
+	mDevice = device;
+	mPool = pool;
+	mSize = size;
+	mScheduler.Initialize(size, minTileSize, maxTileSize, updatesPerFrame);
+
+	mTexture = mPool->Acquire(RenderTargetDesc(size, size, 1, RenderFormatR32Typeless,
+											   RenderBindDepthStencil | RenderBindShaderResource));
+
+	mEffect = mDevice->CreateEffect(C_FILENAME);
+	if(mEffect == NULL)
+		return;
+
+	mClearTechnique = mDevice->GetTechnique(mEffect, "ClearTileTechnique");
+}
+
+// Ask for a tile for every light and decide which tiles are drawn this frame. The lights are copied,
+// the receivers read them from here.
+void ShadowAtlas::Update(const std::vector<SpotLight>& lights, const Camera& camera)
+{
+	int numLights = (int)lights.size();
+	int numOld = (int)mViewProjection.size();
+
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+
+	mLights = lights;
+	mRequests.resize(numLights);
+	mViewProjection.resize(numLights, identity);
+	mDrawnViewProjection.resize(numLights, identity);
+	mShadowMatrices.resize(numLights, identity);
+	mFrustumPlanes.resize(numLights);
+
+	for(int i = 0; i < numLights; ++i)
+	{
+		mViewProjection[i] = lights[i].GetViewProjectionMatrix();
+		mFrustumPlanes[i].Extract(mViewProjection[i]);
+
+		mRequests[i].Coverage = GetCoverage(lights[i], camera);
+		mRequests[i].Priority = lights[i].Priority;
+		mRequests[i].Moved = i >= numOld || mViewProjection[i] != mDrawnViewProjection[i];
+	}
+
+	mScheduler.Schedule(mRequests, mUpdates);
+	for(size_t i = 0; i < mUpdates.size(); ++i)
+		mDrawnViewProjection[mUpdates[i]] = mViewProjection[mUpdates[i]];
+
+	// Normalized device coordinates to the light's tile, in texture coordinates of the atlas. A tile
+	// that is not drawn this frame is read with the matrix it was drawn with.
+	for(int i = 0; i < numLights; ++i)
+	{
+		if(!mScheduler.HasTile(i))
+			continue;
+
+		ShadowTile tile = mScheduler.GetTile(i);
+		float scale = (float)tile.Size / mSize;
+		D3DXMATRIX toTile(0.5f * scale, 0.0f, 0.0f, 0.0f,
+						  0.0f, -0.5f * scale, 0.0f, 0.0f,
+						  0.0f, 0.0f, 1.0f, 0.0f,
+						  0.5f * scale + (float)tile.X / mSize, 0.5f * scale + (float)tile.Y / mSize, 0.0f, 1.0f);
+		mShadowMatrices[i] = mDrawnViewProjection[i] * toTile;
+	}
+}
+
+// Bind the light's tile and clear it. A depth stencil view can only be cleared whole, so the tile is
+// cleared by drawing the far plane over it.
+void ShadowAtlas::BeginTile(int light)
+{
+	if(mTexture == NULL || mClearTechnique == NULL)
+		return;
+
+	ShadowTile tile = mScheduler.GetTile(light);
+	RenderViewport viewport = { tile.X, tile.Y, (UINT)tile.Size, (UINT)tile.Size, 0.0f, 1.0f };
+
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, mTexture->DSV[0]);
+	mDevice->SetViewport(viewport);
+
+	mDevice->SetInputLayout(NULL);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+	mDevice->ApplyPass(mDevice->GetPass(mClearTechnique, 0));
+	mDevice->Draw(3, 0);
+}
+
+void ShadowAtlas::SetUpdatesPerFrame(int updatesPerFrame)
+{
+	mScheduler.SetUpdatesPerFrame(updatesPerFrame);
+}
+
+int ShadowAtlas::GetUpdatesPerFrame() const
+{
+	return mScheduler.GetUpdatesPerFrame();
+}
+
+// Lights whose tiles are drawn this frame
+const std::vector<int>& ShadowAtlas::GetUpdates() const
+{
+	return mUpdates;
+}
+
+int ShadowAtlas::GetLightCount() const
+{
+	return (int)mLights.size();
+}
+
+const SpotLight& ShadowAtlas::GetLight(int light) const
+{
+	return mLights[light];
+}
+
+// The light has a tile that has been drawn into
+bool ShadowAtlas::HasTile(int light) const
+{
+	return mScheduler.HasTile(light);
+}
+
+const D3DXMATRIX& ShadowAtlas::GetViewProjectionMatrix(int light) const
+{
+	return mViewProjection[light];
+}
+
+const D3DXMATRIX& ShadowAtlas::GetShadowMatrix(int light) const
+{
+	return mShadowMatrices[light];
+}
+
+const FrustumPlanes& ShadowAtlas::GetFrustumPlanes(int light) const
+{
+	return mFrustumPlanes[light];
+}
+
+RenderShaderView ShadowAtlas::GetSRV() const
+{
+	return mTexture != NULL ? mTexture->SRV : NULL;
+}
+
+int ShadowAtlas::GetSize() const
+{
+	return mSize;
+}
+
+const ShadowAtlasStatistics& ShadowAtlas::GetStatistics() const
+{
+	return mScheduler.GetStatistics();
+}
+
+// Height of the light's range on screen as a fraction of the view's height, 1 when the camera is
+// inside the range and 0 when the range is out of view
+float ShadowAtlas::GetCoverage(const SpotLight& light, const Camera& camera) const
+{
+	if(!camera.GetFrustumPlanes().TestSphere(BoundingSphere(light.Position, light.Range)))
+		return 0.0f;
+
+	D3DXVECTOR3 toLight = light.Position - camera.GetPos();
+	float distance = D3DXVec3Length(&toLight);
+	if(distance <= light.Range)
+		return 1.0f;
+
+	float coverage = light.Range * camera.GetProjectionMatrix()._22 / distance;
+	return coverage < 1.0f ? coverage : 1.0f;
+}
+
+SpotLightEffectVariables::SpotLightEffectVariables()
+	: mDevice(0), mfxShadowMatrices(0), mfxPositionRange(0), mfxDirectionCos(0), mfxColor(0), mfxCount(0), mfxShadowAtlas(0)
+{
+}
+
+void SpotLightEffectVariables::Initialize(RenderDevice* device, RenderEffect effect)
+{
+	mDevice = device;
+	mfxShadowMatrices = mDevice->GetVariable(effect, "gSpotShadowMatrix");
+	mfxPositionRange = mDevice->GetVariable(effect, "gSpotPositionRange");
+	mfxDirectionCos = mDevice->GetVariable(effect, "gSpotDirectionCos");
+	mfxColor = mDevice->GetVariable(effect, "gSpotColor");
+	mfxCount = mDevice->GetVariable(effect, "gSpotLightCount");
+	mfxShadowAtlas = mDevice->GetVariable(effect, "gShadowAtlas");
+}
+
+void SpotLightEffectVariables::Set(const ShadowAtlas* atlas)
+{
+	if(atlas == NULL || atlas->GetLightCount() == 0)
+	{
+		mDevice->SetInt(mfxCount, 0);
+		mDevice->SetShaderView(mfxShadowAtlas, NULL);
+		return;
+	}
+
+	int numLights = atlas->GetLightCount();
+	if(numLights > C_MAX_LIGHTS)
+		numLights = C_MAX_LIGHTS;
+
+	for(int i = 0; i < numLights; ++i)
+	{
+		const SpotLight& light = atlas->GetLight(i);
+		D3DXVECTOR4 positionRange(light.Position, light.Range);
+		D3DXVECTOR4 directionCos(light.Direction, cosf(light.Angle));
+		D3DXVECTOR4 color(light.Color, atlas->HasTile(i) ? 1.0f : 0.0f);
+
+		mDevice->SetMatrixArray(mfxShadowMatrices, (const float*)&atlas->GetShadowMatrix(i), i, 1);
+		mDevice->SetFloatVectorArray(mfxPositionRange, (const float*)&positionRange, i, 1);
+		mDevice->SetFloatVectorArray(mfxDirectionCos, (const float*)&directionCos, i, 1);
+		mDevice->SetFloatVectorArray(mfxColor, (const float*)&color, i, 1);
+	}
+
+	mDevice->SetInt(mfxCount, numLights);
+	mDevice->SetShaderView(mfxShadowAtlas, atlas->GetSRV());
+}
+
+// Unbind the atlas, so it can be drawn to again
+void SpotLightEffectVariables::Clear()
+{
+	mDevice->SetShaderView(mfxShadowAtlas, NULL);
+}
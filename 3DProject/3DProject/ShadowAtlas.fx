@@ -0,0 +1,42 @@
+// Clears one tile of the shadow atlas. The viewport is set to the tile, the triangle covers it at
+// the far plane and the depth test always passes.
+
+RasterizerState NoCulling
+{
+	CullMode = None;
+};
+
+DepthStencilState WriteDepthAlways
+{
+	DepthEnable = TRUE;
+	DepthWriteMask = ALL;
+	DepthFunc = ALWAYS;
+};
+
+// ************************************************************************
+// ** SHADER FUNCTIONS
+// ************************************************************************
+
+// A triangle that covers the viewport, made from the vertex index without a vertex buffer
+float4 VS(uint vertexID : SV_VertexID) : SV_POSITION
+{
+	float2 uv = float2((vertexID << 1) & 2, vertexID & 2);
+	return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 1.0f, 1.0f);
+}
+
+// ************************************************************************
+// ** TECHNIQUES
+// ************************************************************************
+
+technique10 ClearTileTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(NULL);
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(WriteDepthAlways, 0);
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <vector>
+#include <D3DX10.h>
+#include "Globals.h"
+#include "RenderDevice.h"
+#include "RenderTargetPool.h"
+#include "ShadowAtlasAllocator.h"
+#include "FrustumPlanes.h"
+#include "Camera.h"
+#include "Light.h"
+
+// The shadows of the spot lights, one tile of a single depth texture per light. The scheduler picks
+// the tile sizes from how much of the view each light covers and which tiles are drawn this frame,
+// a tile that is not drawn keeps its depth from an earlier frame. The texture is held for as long as
+// the atlas lives, since its contents are reused.
+class ShadowAtlas
+{
+public:
+	ShadowAtlas();
+	~ShadowAtlas();
+	void Initialize(RenderDevice* device, RenderTargetPool* pool, int size, int minTileSize, int maxTileSize,
+					int updatesPerFrame);
+	void Update(const std::vector<SpotLight>& lights, const Camera& camera);
+	void BeginTile(int light);
+
+	void SetUpdatesPerFrame(int updatesPerFrame);
+	int GetUpdatesPerFrame() const;
+	const std::vector<int>& GetUpdates() const;
+	int GetLightCount() const;
+	const SpotLight& GetLight(int light) const;
+	bool HasTile(int light) const;
+	const D3DXMATRIX& GetViewProjectionMatrix(int light) const;
+	const D3DXMATRIX& GetShadowMatrix(int light) const;
+	const FrustumPlanes& GetFrustumPlanes(int light) const;
+	RenderShaderView GetSRV() const;
+	int GetSize() const;
+	const ShadowAtlasStatistics& GetStatistics() const;
+
+private:
+	RenderDevice*							mDevice;
+	RenderTargetPool*						mPool;
+	PooledTexture*							mTexture;
+	RenderEffect							mEffect;
+	RenderTechnique							mClearTechnique;
+	int										mSize;
+
+	ShadowAtlasScheduler					mScheduler;
+	std::vector<SpotLight>					mLights;
+	std::vector<ShadowAtlasRequest>			mRequests;
+	std::vector<int>						mUpdates;
+	std::vector<D3DXMATRIX>					mViewProjection;
+	std::vector<D3DXMATRIX>					mDrawnViewProjection;	// Of the depth in each tile
+	std::vector<D3DXMATRIX>					mShadowMatrices;		// World to atlas texture coordinates
+	std::vector<FrustumPlanes>				mFrustumPlanes;
+
+	static const char*			C_FILENAME;
+
+	ShadowAtlas(const ShadowAtlas&);
+	ShadowAtlas& operator=(const ShadowAtlas&);
+
+	float GetCoverage(const SpotLight& light, const Camera& camera) const;
+};
+
+// The spot light variables of an effect that receives the atlas' shadows. Lights without a drawn
+// tile are lit without a shadow.
+class SpotLightEffectVariables
+{
+public:
+	SpotLightEffectVariables();
+	void Initialize(RenderDevice* device, RenderEffect effect);
+	void Set(const ShadowAtlas* atlas);
+	void Clear();
+
+	static const int C_MAX_LIGHTS = 64;						// Size of the arrays in the effect
+
+private:
+	RenderDevice*							mDevice;
+	RenderVariable							mfxShadowMatrices;
+	RenderVariable							mfxPositionRange;
+	RenderVariable							mfxDirectionCos;
+	RenderVariable							mfxColor;
+	RenderVariable							mfxCount;
+	RenderVariable							mfxShadowAtlas;
+};
+#endif
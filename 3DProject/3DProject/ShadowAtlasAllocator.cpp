@@ -0,0 +1,391 @@
+#include "ShadowAtlasAllocator.h"
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	const float C_MOVED_WEIGHT = 4.0f;			// A moved light's tile counts as this many times older
+
+	// Tiles to draw, the new ones first, then the oldest by priority
+	struct UpdateCandidate
+	{
+		int					Tier;
+		float				Score;
+		int					Light;
+
+		bool operator<(const UpdateCandidate& other) const
+		{
+			if(Tier != other.Tier)
+				return Tier > other.Tier;
+			return Score > other.Score;
+		}
+	};
+}
+
+ShadowAtlasAllocator::ShadowAtlasAllocator()
+	: mAtlasSize(0), mMinTileSize(0), mUsedTexels(0)
+{
+}
+
+// Forget every tile, the whole atlas is one free node again
+void ShadowAtlasAllocator::Reset(int atlasSize, int minTileSize)
+{
+	mAtlasSize = atlasSize;
+	mMinTileSize = minTileSize;
+	mUsedTexels = 0;
+
+	int numLevels = 1;
+	for(int size = atlasSize; size > minTileSize; size /= 2)
+		++numLevels;
+
+	Node root = { 0, 0, 0, -1, -1, true, false };
+	mNodes.assign(1, root);
+	mFreeNodes.assign(numLevels, std::vector<int>());
+	mFreeNodes[0].push_back(0);
+}
+
+// A node of the smallest size that holds the tile, -1 if the atlas has no room for it
+int ShadowAtlasAllocator::Allocate(int tileSize)
+{
+	int node = TakeNode(GetLevel(tileSize));
+	if(node < 0)
+		return -1;
+
+	int size = mAtlasSize >> mNodes[node].Level;
+	mUsedTexels += size * size;
+	return node;
+}
+
+void ShadowAtlasAllocator::Free(int node)
+{
+	if(node < 0 || mNodes[node].Free || mNodes[node].Split)
+		return;
+
+	int size = mAtlasSize >> mNodes[node].Level;
+	mUsedTexels -= size * size;
+	mNodes[node].Free = true;
+
+	// Merge upwards while all four siblings are free
+	int current = node;
+	for(;;)
+	{
+		int parent = mNodes[current].Parent;
+		bool siblingsFree = parent >= 0;
+		for(int i = 0; siblingsFree && i < 4; ++i)
+			siblingsFree = mNodes[mNodes[parent].FirstChild + i].Free;
+
+		if(!siblingsFree)
+		{
+			mFreeNodes[mNodes[current].Level].push_back(current);
+			return;
+		}
+
+		for(int i = 0; i < 4; ++i)
+		{
+			if(mNodes[parent].FirstChild + i != current)
+				RemoveFree(mNodes[parent].FirstChild + i);
+		}
+
+		mNodes[parent].Split = false;
+		mNodes[parent].Free = true;
+		current = parent;
+	}
+}
+
+ShadowTile ShadowAtlasAllocator::GetTile(int node) const
+{
+	ShadowTile tile = { mNodes[node].X, mNodes[node].Y, mAtlasSize >> mNodes[node].Level };
+	return tile;
+}
+
+int ShadowAtlasAllocator::GetAtlasSize() const
+{
+	return mAtlasSize;
+}
+
+int ShadowAtlasAllocator::GetMinTileSize() const
+{
+	return mMinTileSize;
+}
+
+int ShadowAtlasAllocator::GetUsedTexels() const
+{
+	return mUsedTexels;
+}
+
+// The level of the smallest node that holds a tile of the size, -1 when it is larger than the atlas
+int ShadowAtlasAllocator::GetLevel(int tileSize) const
+{
+	if(tileSize > mAtlasSize || tileSize <= 0)
+		return -1;
+
+	int level = 0;
+	for(int size = mAtlasSize; size / 2 >= tileSize && size > mMinTileSize; size /= 2)
+		++level;
+
+	return level;
+}
+
+// Take a free node of the level, splitting a larger one if there is none
+int ShadowAtlasAllocator::TakeNode(int level)
+{
+	if(level < 0)
+		return -1;
+
+	if(!mFreeNodes[level].empty())
+	{
+		int node = mFreeNodes[level].back();
+		mFreeNodes[level].pop_back();
+		mNodes[node].Free = false;
+		return node;
+	}
+
+	int parent = TakeNode(level - 1);
+	if(parent < 0)
+		return -1;
+
+	if(mNodes[parent].FirstChild < 0)
+	{
+		int half = mAtlasSize >> level;
+		mNodes[parent].FirstChild = (int)mNodes.size();
+		for(int i = 0; i < 4; ++i)
+		{
+			Node child = { mNodes[parent].X + (i % 2) * half, mNodes[parent].Y + (i / 2) * half, level, parent, -1,
+						   true, false };
+			mNodes.push_back(child);
+		}
+	}
+
+	mNodes[parent].Split = true;
+
+	// The first child is used, the other three wait in the free list
+	int firstChild = mNodes[parent].FirstChild;
+	for(int i = 3; i > 0; --i)
+	{
+		mNodes[firstChild + i].Free = true;
+		mFreeNodes[level].push_back(firstChild + i);
+	}
+
+	mNodes[firstChild].Free = false;
+	return firstChild;
+}
+
+void ShadowAtlasAllocator::RemoveFree(int node)
+{
+	std::vector<int>& freeNodes = mFreeNodes[mNodes[node].Level];
+	std::vector<int>::iterator it = std::find(freeNodes.begin(), freeNodes.end(), node);
+	if(it != freeNodes.end())
+		freeNodes.erase(it);
+}
+
+ShadowAtlasScheduler::ShadowAtlasScheduler()
+	: mMaxTileSize(0), mUpdatesPerFrame(0)
+{
+	mStatistics = ShadowAtlasStatistics();
+}
+
+void ShadowAtlasScheduler::Initialize(int atlasSize, int minTileSize, int maxTileSize, int updatesPerFrame)
+{
+	mAllocator.Reset(atlasSize, minTileSize);
+	mSlots.clear();
+	mMaxTileSize = std::min(maxTileSize, atlasSize);
+	mUpdatesPerFrame = updatesPerFrame;
+}
+
+void ShadowAtlasScheduler::SetUpdatesPerFrame(int updatesPerFrame)
+{
+	mUpdatesPerFrame = updatesPerFrame;
+}
+
+// Give every light with a request a tile and return the lights whose tiles are drawn this frame, one
+// request per light in the same order every frame
+void ShadowAtlasScheduler::Schedule(const std::vector<ShadowAtlasRequest>& requests, std::vector<int>& updates)
+{
+	updates.clear();
+	mStatistics = ShadowAtlasStatistics();
+
+	while(mSlots.size() > requests.size())
+	{
+		FreeSlot(mSlots.back());
+		mSlots.pop_back();
+	}
+
+	Slot emptySlot = { -1, 0, 0, false };
+	mSlots.resize(requests.size(), emptySlot);
+
+	std::vector<int> desiredSizes(requests.size());
+	for(int i = 0; i < (int)requests.size(); ++i)
+		desiredSizes[i] = GetDesiredSize(requests[i]);
+	FitDesiredSizes(requests, desiredSizes);
+
+	// Tiles of the wrong size are given back before any is taken, so they can merge into larger ones
+	std::vector<std::pair<float, int> > order;
+	for(int i = 0; i < (int)requests.size(); ++i)
+	{
+		Slot& slot = mSlots[i];
+		int desired = desiredSizes[i];
+		if(slot.Node >= 0)
+		{
+			int size = mAllocator.GetTile(slot.Node).Size;
+			if(desired > slot.Requested || desired * 4 <= size)
+			{
+				FreeSlot(slot);
+				if(desired > 0)
+					++mStatistics.Reallocated;
+			}
+		}
+
+		if(desired > 0 && (slot.Node < 0 || mAllocator.GetTile(slot.Node).Size < desired))
+			order.push_back(std::make_pair(requests[i].Coverage * requests[i].Priority, i));
+	}
+
+	std::sort(order.begin(), order.end(), std::greater<std::pair<float, int> >());
+	for(size_t i = 0; i < order.size(); ++i)
+	{
+		Slot& slot = mSlots[order[i].second];
+		int desired = desiredSizes[order[i].second];
+
+		// A light that got a smaller tile than it wanted moves to the size it wants once that fits,
+		// until then it keeps the tile it has
+		if(slot.Node >= 0)
+		{
+			int node = mAllocator.Allocate(desired);
+			if(node >= 0)
+			{
+				mAllocator.Free(slot.Node);
+				slot.Node = node;
+				slot.Age = 0;
+				slot.Drawn = false;
+				++mStatistics.Reallocated;
+			}
+			continue;
+		}
+
+		for(int size = desired; size >= mAllocator.GetMinTileSize() && slot.Node < 0; size /= 2)
+			slot.Node = mAllocator.Allocate(size);
+
+		if(slot.Node < 0)
+		{
+			++mStatistics.Unallocated;
+			continue;
+		}
+
+		slot.Requested = desired;
+		slot.Age = 0;
+		slot.Drawn = false;
+	}
+
+	std::vector<UpdateCandidate> candidates;
+	for(int i = 0; i < (int)mSlots.size(); ++i)
+	{
+		if(mSlots[i].Node < 0)
+			continue;
+
+		float weight = requests[i].Moved ? C_MOVED_WEIGHT : 1.0f;
+		UpdateCandidate candidate = { mSlots[i].Drawn ? 0 : 1, (mSlots[i].Age + 1) * requests[i].Priority * weight, i };
+		candidates.push_back(candidate);
+	}
+
+	int numUpdates = std::min((int)candidates.size(), mUpdatesPerFrame);
+	std::partial_sort(candidates.begin(), candidates.begin() + numUpdates, candidates.end());
+	for(int i = 0; i < (int)candidates.size(); ++i)
+	{
+		Slot& slot = mSlots[candidates[i].Light];
+		if(i < numUpdates)
+		{
+			updates.push_back(candidates[i].Light);
+			slot.Age = 0;
+			slot.Drawn = true;
+		}
+		else
+			++slot.Age;
+
+		mStatistics.MaxAge = std::max(mStatistics.MaxAge, slot.Age);
+	}
+
+	mStatistics.Tiles = (int)candidates.size();
+	mStatistics.Updated = numUpdates;
+	mStatistics.UsedTexels = mAllocator.GetUsedTexels();
+}
+
+// A light only has a tile once it has been drawn into, until then nothing should read it
+bool ShadowAtlasScheduler::HasTile(int light) const
+{
+	return light < (int)mSlots.size() && mSlots[light].Node >= 0 && mSlots[light].Drawn;
+}
+
+ShadowTile ShadowAtlasScheduler::GetTile(int light) const
+{
+	return mAllocator.GetTile(mSlots[light].Node);
+}
+
+// The power of two tile that gives the light about as many texels as its coverage times priority
+// of the largest tile, 0 when it is out of view
+int ShadowAtlasScheduler::GetDesiredSize(const ShadowAtlasRequest& request) const
+{
+	if(request.Coverage <= 0.0f)
+		return 0;
+
+	float wanted = request.Coverage * request.Priority * mMaxTileSize;
+	int size = mAllocator.GetMinTileSize();
+	while(size < wanted && size < mMaxTileSize)
+		size *= 2;
+
+	return size;
+}
+
+int ShadowAtlasScheduler::GetUpdatesPerFrame() const
+{
+	return mUpdatesPerFrame;
+}
+
+const ShadowAtlasAllocator& ShadowAtlasScheduler::GetAllocator() const
+{
+	return mAllocator;
+}
+
+const ShadowAtlasStatistics& ShadowAtlasScheduler::GetStatistics() const
+{
+	return mStatistics;
+}
+
+// Halve the largest tiles until all of them fit in the atlas, of equally large ones the tile of the
+// light with the least coverage times priority first. When every tile is as small as it can be, the
+// lights with the least are left without one.
+void ShadowAtlasScheduler::FitDesiredSizes(const std::vector<ShadowAtlasRequest>& requests,
+										   std::vector<int>& desiredSizes) const
+{
+	int atlasSize = mAllocator.GetAtlasSize();
+	int minTileSize = mAllocator.GetMinTileSize();
+	int capacity = atlasSize * atlasSize;
+
+	int total = 0;
+	for(size_t i = 0; i < desiredSizes.size(); ++i)
+		total += desiredSizes[i] * desiredSizes[i];
+
+	while(total > capacity)
+	{
+		int largest = -1;
+		for(int i = 0; i < (int)desiredSizes.size(); ++i)
+		{
+			if(desiredSizes[i] == 0)
+				continue;
+			if(largest < 0 || desiredSizes[i] > desiredSizes[largest] || (desiredSizes[i] == desiredSizes[largest] &&
+			   requests[i].Coverage * requests[i].Priority < requests[largest].Coverage * requests[largest].Priority))
+				largest = i;
+		}
+
+		int size = desiredSizes[largest];
+		int newSize = size > minTileSize ? size / 2 : 0;
+		total -= size * size - newSize * newSize;
+		desiredSizes[largest] = newSize;
+	}
+}
+
+void ShadowAtlasScheduler::FreeSlot(Slot& slot)
+{
+	mAllocator.Free(slot.Node);
+	slot.Node = -1;
+	slot.Requested = 0;
+	slot.Drawn = false;
+}
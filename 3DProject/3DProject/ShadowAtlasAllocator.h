@@ -0,0 +1,116 @@
+#ifndef SHADOW_ATLAS_ALLOCATOR_H
+#define SHADOW_ATLAS_ALLOCATOR_H
+
+#include <vector>
+
+// A square of the atlas, in texels
+struct ShadowTile
+{
+	int						X;
+	int						Y;
+	int						Size;
+};
+
+// Hands out power of two tiles of a square atlas. The atlas is the root of a quadtree, a tile is
+// taken from the free nodes of its size and when there are none a larger free node is split into
+// four. A freed node is merged with its siblings as soon as all four are free, so large tiles become
+// available again. Nodes are never removed, a node that is split again reuses its old children.
+// Nothing here touches the GPU.
+class ShadowAtlasAllocator
+{
+public:
+	ShadowAtlasAllocator();
+	void Reset(int atlasSize, int minTileSize);
+	int Allocate(int tileSize);
+	void Free(int node);
+
+	ShadowTile GetTile(int node) const;
+	int GetAtlasSize() const;
+	int GetMinTileSize() const;
+	int GetUsedTexels() const;
+
+private:
+	struct Node
+	{
+		int					X;
+		int					Y;
+		int					Level;					// 0 is the whole atlas
+		int					Parent;
+		int					FirstChild;				// -1 until the node is split the first time
+		bool				Free;					// Not used and not split
+		bool				Split;
+	};
+
+	std::vector<Node>				mNodes;
+	std::vector<std::vector<int> >	mFreeNodes;		// Per level
+	int								mAtlasSize;
+	int								mMinTileSize;
+	int								mUsedTexels;
+
+	int GetLevel(int tileSize) const;
+	int TakeNode(int level);
+	void RemoveFree(int node);
+};
+
+// What a light asks of the atlas this frame
+struct ShadowAtlasRequest
+{
+	float					Coverage;				// Fraction of the view height, 0 when out of view
+	float					Priority;				// Scales the tile size and how often it is drawn
+	bool					Moved;					// The light's matrix changed since the last frame
+};
+
+struct ShadowAtlasStatistics
+{
+	int						Tiles;
+	int						Unallocated;			// Lights in view without a tile, the atlas is full
+	int						Reallocated;			// Tiles that changed size this frame
+	int						Updated;				// Tiles drawn this frame
+	int						MaxAge;					// Frames since the oldest tile was drawn
+	int						UsedTexels;
+};
+
+// Decides the tile of every light and which tiles are drawn this frame. Each light wants a tile sized
+// by its coverage and priority, when they do not all fit the largest are halved until they do. A
+// tile grows as soon as the light wants it to and shrinks only when the light wants a quarter of it,
+// so a light near a size threshold does not change tile every frame. Lights are given space in the
+// order of their coverage times priority, one that does not fit gets the largest smaller tile that
+// does and moves to the size it wants in a later frame that has room for it.
+//
+// At most the budget of tiles is drawn per frame, the rest keep what was drawn into them earlier.
+// New tiles go first since they hold nothing, then the oldest tiles weighted by priority, where a
+// light that moved counts its tile as older.
+class ShadowAtlasScheduler
+{
+public:
+	ShadowAtlasScheduler();
+	void Initialize(int atlasSize, int minTileSize, int maxTileSize, int updatesPerFrame);
+	void SetUpdatesPerFrame(int updatesPerFrame);
+	void Schedule(const std::vector<ShadowAtlasRequest>& requests, std::vector<int>& updates);
+
+	bool HasTile(int light) const;
+	ShadowTile GetTile(int light) const;
+	int GetDesiredSize(const ShadowAtlasRequest& request) const;
+	int GetUpdatesPerFrame() const;
+	const ShadowAtlasAllocator& GetAllocator() const;
+	const ShadowAtlasStatistics& GetStatistics() const;
+
+private:
+	struct Slot
+	{
+		int					Node;					// -1 without a tile
+		int					Age;					// Frames since the tile was drawn
+		int					Requested;				// Desired size when the tile was taken, it can be smaller
+		bool				Drawn;					// The tile holds the light's depth
+	};
+
+	ShadowAtlasAllocator			mAllocator;
+	std::vector<Slot>				mSlots;
+	int								mMaxTileSize;
+	int								mUpdatesPerFrame;
+	ShadowAtlasStatistics			mStatistics;
+
+	void FitDesiredSizes(const std::vector<ShadowAtlasRequest>& requests, std::vector<int>& desiredSizes) const;
+	void FreeSlot(Slot& slot);
+};
+#endif
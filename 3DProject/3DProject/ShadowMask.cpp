@@ -0,0 +1,148 @@
+#include "ShadowMask.h"
+
+const char* ShadowMask::C_FILENAME = "ShadowMask.fx";
+const char* ShadowMask::C_MASK_TECHNIQUES[ShadowFilterCount] = { "Mask2x2Technique", "Mask3x3Technique",
+	"Mask5x5Technique", "MaskPoissonTechnique", "MaskVSMTechnique", "MaskEVSMTechnique" };
+
+ShadowMask::ShadowMask()
+	: mDevice(0), mPool(0), mEffect(0), mUpsampleTechnique(0), mfxSceneDepth(0), mfxHalfMask(0), mfxInvViewProj(0),
+	  mfxScreenSize(0), mfxDepthToViewZ(0), mfxMaskStep(0), mDepthTexture(0), mMaskTexture(0), mWidth(0), mHeight(0),
+	  mHalfResolution(false)
+{
+	for(int i = 0; i < ShadowFilterCount; ++i)
+		mMaskTechniques[i] = 0;
+}
+
+ShadowMask::~ShadowMask()
+{
+	if(mDevice != NULL)
+		mDevice->ReleaseEffect(mEffect);
+}
+
+void ShadowMask::Initialize(RenderDevice* device, RenderTargetPool* pool)
+{
+	mDevice = device;
+	mPool = pool;
+
+	mEffect = mDevice->CreateEffect(C_FILENAME);
+	if(mEffect == NULL)
+		return;
+
+	for(int i = 0; i < ShadowFilterCount; ++i)
+		mMaskTechniques[i] = mDevice->GetTechnique(mEffect, C_MASK_TECHNIQUES[i]);
+	mUpsampleTechnique = mDevice->GetTechnique(mEffect, "UpsampleTechnique");
+
+	// Only the cascade variables are used, the mask effect has none of the receivers' techniques
+	mShadowVariables.Initialize(mDevice, mEffect);
+	mfxSceneDepth = mDevice->GetVariable(mEffect, "gSceneDepth");
+	mfxHalfMask = mDevice->GetVariable(mEffect, "gHalfMask");
+	mfxInvViewProj = mDevice->GetVariable(mEffect, "gInvViewProj");
+	mfxScreenSize = mDevice->GetVariable(mEffect, "gScreenSize");
+	mfxDepthToViewZ = mDevice->GetVariable(mEffect, "gDepthToViewZ");
+	mfxMaskStep = mDevice->GetVariable(mEffect, "gMaskStep");
+}
+
+// Take the depth texture the receivers' depth is drawn into next, bound and cleared by the caller
+void ShadowMask::BeginDepth(PooledTexture* depthTexture, bool halfResolution)
+{
+	mDepthTexture = depthTexture;
+	mHalfResolution = halfResolution;
+	if(mDepthTexture != NULL)
+	{
+		mWidth = mDepthTexture->Desc.Width;
+		mHeight = mDepthTexture->Desc.Height;
+	}
+}
+
+// Filter the mask from the depth drawn since BeginDepth and give it to the shadow map. No targets
+// are bound afterwards.
+void ShadowMask::Apply(CascadedShadowMap& shadowMap, const Camera& camera)
+{
+	if(mEffect == NULL)
+		return;
+
+	if(mDepthTexture != NULL && shadowMap.GetSRV() != NULL)
+	{
+		const D3DXMATRIX& projection = camera.GetProjectionMatrix();
+		D3DXMATRIX invViewProj;
+		D3DXMatrixInverse(&invViewProj, NULL, &camera.GetViewProjectionMatrix());
+		D3DXVECTOR4 screenSize((float)mWidth, (float)mHeight, 1.0f / mWidth, 1.0f / mHeight);
+		D3DXVECTOR4 depthToViewZ(projection._33, projection._43, 0.0f, 0.0f);
+
+		mShadowVariables.Set(&shadowMap);
+		mDevice->SetMatrix(mfxInvViewProj, (const float*)&invViewProj);
+		mDevice->SetFloatVector(mfxScreenSize, (const float*)&screenSize);
+		mDevice->SetFloatVector(mfxDepthToViewZ, (const float*)&depthToViewZ);
+
+		// Unbound before it is read
+		RenderTargetView renderTargets[1] = { NULL };
+		mDevice->SetRenderTargets(1, renderTargets, NULL);
+		mDevice->SetShaderView(mfxSceneDepth, mDepthTexture->SRV);
+
+		mDevice->SetInputLayout(NULL);
+		mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+		RenderTargetDesc maskDesc(mWidth, mHeight, 1, RenderFormatR8Unorm,
+								  RenderBindRenderTarget | RenderBindShaderResource);
+		RenderTechnique technique = mMaskTechniques[shadowMap.GetFilter()];
+		if(mHalfResolution)
+		{
+			int halfWidth = (mWidth + 1) / 2;
+			int halfHeight = (mHeight + 1) / 2;
+			PooledTexture* halfMask = mPool->Acquire(RenderTargetDesc(halfWidth, halfHeight, 1, RenderFormatR8Unorm,
+												RenderBindRenderTarget | RenderBindShaderResource));
+			mMaskTexture = mPool->Acquire(maskDesc);
+			if(halfMask != NULL && mMaskTexture != NULL)
+			{
+				mDevice->SetInt(mfxMaskStep, 2);
+				DrawPass(technique, halfMask->RTV[0], halfWidth, halfHeight);
+
+				mDevice->SetShaderView(mfxHalfMask, halfMask->SRV);
+				DrawPass(mUpsampleTechnique, mMaskTexture->RTV[0], mWidth, mHeight);
+			}
+			mPool->Release(halfMask);
+		}
+		else
+		{
+			mMaskTexture = mPool->Acquire(maskDesc);
+			if(mMaskTexture != NULL)
+			{
+				mDevice->SetInt(mfxMaskStep, 1);
+				DrawPass(technique, mMaskTexture->RTV[0], mWidth, mHeight);
+			}
+		}
+
+		mDevice->SetRenderTargets(1, renderTargets, NULL);
+		mDevice->SetShaderView(mfxSceneDepth, NULL);
+		mDevice->SetShaderView(mfxHalfMask, NULL);
+		mShadowVariables.Clear();
+		mDevice->ApplyPass(mDevice->GetPass(mUpsampleTechnique, 0));
+
+		if(mMaskTexture != NULL)
+			shadowMap.SetScreenMask(mMaskTexture->SRV);
+	}
+
+	mDepthTexture = NULL;
+}
+
+// Give the mask back once the receivers that read it are drawn
+void ShadowMask::EndFrame()
+{
+	mPool->Release(mMaskTexture);
+	mMaskTexture = NULL;
+}
+
+// The target is bound after the pass so a texture is never bound for reading and writing at once
+void ShadowMask::DrawPass(RenderTechnique technique, RenderTargetView target, int width, int height)
+{
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, NULL);
+	mDevice->ApplyPass(mDevice->GetPass(technique, 0));
+
+	RenderViewport viewport = { 0, 0, (UINT)width, (UINT)height, 0.0f, 1.0f };
+	mDevice->SetViewport(viewport);
+
+	renderTargets[0] = target;
+	mDevice->SetRenderTargets(1, renderTargets, NULL);
+	mDevice->Draw(3, 0);
+}
@@ -0,0 +1,211 @@
+// Shadows in screen space. The depth pre-pass leaves the depth of every receiver pixel, the mask
+// pass turns it back into a world position and filters the cascades once for the pixel, so the
+// cost does not grow with overdraw. At half resolution the mask is upsampled with weights that
+// follow the depth, which keeps the shadow from bleeding across silhouettes. Ground.fx and Effect.fx
+// read one texel of the result.
+
+struct PS_INPUT
+{
+	float4		position	: SV_POSITION;
+	float2		uv			: TEXCOORD;
+};
+
+RasterizerState NoCulling
+{
+	CullMode = None;
+};
+
+DepthStencilState DisableDepth
+{
+	DepthEnable = FALSE;
+	DepthWriteMask = ZERO;
+};
+
+// Set by ShadowMask
+Texture2D gSceneDepth;					// Of the depth pre-pass, always full resolution
+Texture2D gHalfMask;					// Source of the upsampling
+matrix gInvViewProj;
+float4 gScreenSize;						// Width, height, 1 / width, 1 / height of the full resolution
+float2 gDepthToViewZ;					// The projection's _33 and _43, view z = y / (depth - x)
+int gMaskStep = 1;						// Pixels per mask texel along each axis
+
+// Relative difference in view z at which a half resolution texel has half the weight of one on the
+// same surface
+static const float gDepthTolerance = 0.02f;
+
+// ************************************************************************
+// ** SHADOW FILTERS
+// ************************************************************************
+
+#include "ShadowFilters.fxh"
+
+// ************************************************************************
+// ** HELPER FUNCTIONS
+// ************************************************************************
+
+float GetViewZ(float depth)
+{
+	return gDepthToViewZ.y / (depth - gDepthToViewZ.x);
+}
+
+// The world position seen through the center of a full resolution pixel at a depth
+float3 GetWorldPosition(int2 texel, float depth)
+{
+	float2 ndc = (texel + 0.5f) * gScreenSize.zw * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+	float4 position = mul(float4(ndc, depth, 1.0f), gInvViewProj);
+	return position.xyz / position.w;
+}
+
+// ************************************************************************
+// ** SHADER FUNCTIONS
+// ************************************************************************
+
+// A triangle that covers the target, made from the vertex index without a vertex buffer
+PS_INPUT VS(uint vertexID : SV_VertexID)
+{
+	PS_INPUT output;
+
+	output.uv = float2((vertexID << 1) & 2, vertexID & 2);
+	output.position = float4(output.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+
+	return output;
+}
+
+// A half resolution texel takes the first of the 2x2 pixels it covers, the upsampling compares
+// against the depth of the same pixel. Where nothing was drawn the far plane is filtered and
+// thrown away, so the gradients of the filters stay defined.
+float MaskPS(PS_INPUT input, uniform int shadowFilter) : SV_Target0
+{
+	int2 texel = (int2)input.position.xy * gMaskStep;
+	float depth = gSceneDepth.Load(int3(texel, 0)).r;
+
+	float3 positionW = GetWorldPosition(texel, depth);
+	float shadowFactor = CalcCascadeShadowFactor(positionW, (float2)texel, shadowFilter);
+
+	return depth < 1.0f ? shadowFactor : 1.0f;
+}
+
+// The four half resolution texels around the pixel, weighted bilinearly and by how close their
+// depth is to the pixel's
+float UpsamplePS(PS_INPUT input) : SV_Target0
+{
+	int2 texel = (int2)input.position.xy;
+	float viewZ = GetViewZ(gSceneDepth.Load(int3(texel, 0)).r);
+
+	int2 halfSize = ((int2)gScreenSize.xy + 1) / 2;
+	float2 halfPosition = input.position.xy * 0.5f - 0.5f;
+	float2 base = floor(halfPosition);
+	float2 s = halfPosition - base;
+
+	float sum = 0.0f;
+	float weightSum = 0.0f;
+	[unroll]
+	for(int i = 0; i < 4; ++i)
+	{
+		int2 offset = int2(i % 2, i / 2);
+		int2 halfTexel = clamp((int2)base + offset, 0, halfSize - 1);
+		float sampleViewZ = GetViewZ(gSceneDepth.Load(int3(halfTexel * 2, 0)).r);
+
+		float2 bilinear = offset ? s : 1.0f - s;
+		float weight = bilinear.x * bilinear.y / (gDepthTolerance + abs(sampleViewZ - viewZ) / viewZ);
+		sum += gHalfMask.Load(int3(halfTexel, 0)).r * weight;
+		weightSum += weight;
+	}
+
+	return sum / weightSum;
+}
+
+// ************************************************************************
+// ** TECHNIQUES
+// ************************************************************************
+
+technique10 Mask2x2Technique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, MaskPS(SHADOW_FILTER_2X2)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 Mask3x3Technique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, MaskPS(SHADOW_FILTER_3X3)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 Mask5x5Technique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, MaskPS(SHADOW_FILTER_5X5)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 MaskPoissonTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, MaskPS(SHADOW_FILTER_POISSON)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 MaskVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, MaskPS(SHADOW_FILTER_VSM)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 MaskEVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, MaskPS(SHADOW_FILTER_EVSM)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 UpsampleTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, UpsamplePS()));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
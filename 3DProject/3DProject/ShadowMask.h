@@ -0,0 +1,56 @@
+#ifndef SHADOW_MASK_H
+#define SHADOW_MASK_H
+
+#include <D3DX10.h>
+#include "Globals.h"
+#include "RenderDevice.h"
+#include "Camera.h"
+#include "RenderTargetPool.h"
+#include "CascadedShadowMap.h"
+
+// Shadows of the cascades filtered once per screen pixel. BeginDepth is given the depth texture the
+// receivers' depth is drawn into, a transient of the frame graph. Apply turns every pixel of it back
+// into a world position, filters the cascades with the shadow map's filter into an R8 mask from the
+// pool and sets the mask on the shadow map, so receivers drawn after it read one texel instead of
+// filtering. The mask can be filtered at half resolution and upsampled with weights that follow the
+// depth.
+class ShadowMask
+{
+public:
+	ShadowMask();
+	~ShadowMask();
+	void Initialize(RenderDevice* device, RenderTargetPool* pool);
+	void BeginDepth(PooledTexture* depthTexture, bool halfResolution);
+	void Apply(CascadedShadowMap& shadowMap, const Camera& camera);
+	void EndFrame();
+
+private:
+	RenderDevice*							mDevice;
+	RenderTargetPool*						mPool;
+	RenderEffect							mEffect;
+	RenderTechnique							mMaskTechniques[ShadowFilterCount];
+	RenderTechnique							mUpsampleTechnique;
+	ShadowEffectVariables					mShadowVariables;
+
+	RenderVariable							mfxSceneDepth;
+	RenderVariable							mfxHalfMask;
+	RenderVariable							mfxInvViewProj;
+	RenderVariable							mfxScreenSize;
+	RenderVariable							mfxDepthToViewZ;
+	RenderVariable							mfxMaskStep;
+
+	PooledTexture*							mDepthTexture;			// From BeginDepth until Apply
+	PooledTexture*							mMaskTexture;			// From Apply until EndFrame
+	int										mWidth;
+	int										mHeight;
+	bool									mHalfResolution;
+
+	static const char*			C_FILENAME;
+	static const char*			C_MASK_TECHNIQUES[ShadowFilterCount];
+
+	ShadowMask(const ShadowMask&);
+	ShadowMask& operator=(const ShadowMask&);
+
+	void DrawPass(RenderTechnique technique, RenderTargetView target, int width, int height);
+};
+#endif
@@ -0,0 +1,96 @@
+#include "ShadowMomentFilter.h"
+
+const char* ShadowMomentFilter::C_FILENAME = "ShadowMoments.fx";
+
+ShadowMomentFilter::ShadowMomentFilter()
+	: mDevice(0), mPool(0), mEffect(0), mResolveVSM(0), mResolveEVSM(0), mBlurHorizontal(0), mBlurVertical(0),
+	  mfxDepthMap(0), mfxMomentMap(0), mfxSlice(0), mfxTexelSize(0)
+{
+}
+
+ShadowMomentFilter::~ShadowMomentFilter()
+{
+	if(mDevice != NULL)
+		mDevice->ReleaseEffect(mEffect);
+}
+
+void ShadowMomentFilter::Initialize(RenderDevice* device, RenderTargetPool* pool)
+{
+	mDevice = device;
+	mPool = pool;
+
+	mEffect = mDevice->CreateEffect(C_FILENAME);
+	if(mEffect == NULL)
+		return;
+
+	mResolveVSM = mDevice->GetTechnique(mEffect, "ResolveVSMTechnique");
+	mResolveEVSM = mDevice->GetTechnique(mEffect, "ResolveEVSMTechnique");
+	mBlurHorizontal = mDevice->GetTechnique(mEffect, "BlurHorizontalTechnique");
+	mBlurVertical = mDevice->GetTechnique(mEffect, "BlurVerticalTechnique");
+
+	mfxDepthMap = mDevice->GetVariable(mEffect, "gDepthMap");
+	mfxMomentMap = mDevice->GetVariable(mEffect, "gMomentMap");
+	mfxSlice = mDevice->GetVariable(mEffect, "gSlice");
+	mfxTexelSize = mDevice->GetVariable(mEffect, "gTexelSize");
+}
+
+// Resolve, blur and mip-map every cascade. Must come after the last caster of the frame is drawn.
+void ShadowMomentFilter::Apply(const CascadedShadowMap& shadowMap)
+{
+	PooledTexture* moments = shadowMap.GetMomentTexture();
+	RenderShaderView depth = shadowMap.GetSRV();
+	if(mEffect == NULL || moments == NULL || depth == NULL)
+		return;
+
+	// One slice is enough for the horizontal pass, it goes back to the pool for the next user
+	int size = shadowMap.GetMomentSize();
+	PooledTexture* blurTarget = mPool->Acquire(RenderTargetDesc(size, size, 1, RenderFormatR32G32Float,
+															   RenderBindRenderTarget | RenderBindShaderResource));
+	if(blurTarget == NULL)
+		return;
+
+	RenderViewport viewport = { 0, 0, (UINT)size, (UINT)size, 0.0f, 1.0f };
+	mDevice->SetViewport(viewport);
+	mDevice->SetInputLayout(NULL);
+	mDevice->SetPrimitiveTopology(RenderTopologyTriangleList);
+
+	D3DXVECTOR4 texelSize(1.0f / size, 1.0f / size, 0.0f, 0.0f);
+	mDevice->SetFloatVector(mfxTexelSize, (const float*)&texelSize);
+
+	RenderTechnique resolve = shadowMap.GetFilter() == ShadowFilterEVSM ? mResolveEVSM : mResolveVSM;
+	for(int i = 0; i < shadowMap.GetCascadeCount(); ++i)
+	{
+		mDevice->SetInt(mfxSlice, i);
+		mDevice->SetShaderView(mfxDepthMap, depth);
+		mDevice->SetShaderView(mfxMomentMap, NULL);
+		DrawPass(resolve, moments->RTV[i]);
+
+		mDevice->SetShaderView(mfxMomentMap, moments->SRV);
+		DrawPass(mBlurHorizontal, blurTarget->RTV[0]);
+
+		mDevice->SetInt(mfxSlice, 0);
+		mDevice->SetShaderView(mfxMomentMap, blurTarget->SRV);
+		DrawPass(mBlurVertical, moments->RTV[i]);
+	}
+
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, NULL);
+	mDevice->SetShaderView(mfxDepthMap, NULL);
+	mDevice->SetShaderView(mfxMomentMap, NULL);
+	mDevice->ApplyPass(mDevice->GetPass(mBlurVertical, 0));
+
+	mDevice->GenerateMips(moments->SRV);
+	mPool->Release(blurTarget);
+}
+
+// The target is bound after the pass so a texture is never bound for reading and writing at once
+void ShadowMomentFilter::DrawPass(RenderTechnique technique, RenderTargetView target)
+{
+	RenderTargetView renderTargets[1] = { NULL };
+	mDevice->SetRenderTargets(1, renderTargets, NULL);
+	mDevice->ApplyPass(mDevice->GetPass(technique, 0));
+
+	renderTargets[0] = target;
+	mDevice->SetRenderTargets(1, renderTargets, NULL);
+	mDevice->Draw(3, 0);
+}
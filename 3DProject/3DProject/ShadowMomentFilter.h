@@ -0,0 +1,42 @@
+#ifndef SHADOW_MOMENT_FILTER_H
+#define SHADOW_MOMENT_FILTER_H
+
+#include <D3DX10.h>
+#include "Globals.h"
+#include "RenderDevice.h"
+#include "RenderTargetPool.h"
+#include "CascadedShadowMap.h"
+
+// Fills the moment array of a shadow map for the VSM and EVSM filters. Every cascade's depth is
+// resolved into moments at half the size, blurred horizontally into a texture from the pool and
+// back vertically, then the mip chain is generated so receivers can take one filtered sample.
+class ShadowMomentFilter
+{
+public:
+	ShadowMomentFilter();
+	~ShadowMomentFilter();
+	void Initialize(RenderDevice* device, RenderTargetPool* pool);
+	void Apply(const CascadedShadowMap& shadowMap);
+
+private:
+	RenderDevice*							mDevice;
+	RenderTargetPool*						mPool;
+	RenderEffect							mEffect;
+	RenderTechnique							mResolveVSM;
+	RenderTechnique							mResolveEVSM;
+	RenderTechnique							mBlurHorizontal;
+	RenderTechnique							mBlurVertical;
+
+	RenderVariable							mfxDepthMap;
+	RenderVariable							mfxMomentMap;
+	RenderVariable							mfxSlice;
+	RenderVariable							mfxTexelSize;
+
+	static const char*			C_FILENAME;
+
+	ShadowMomentFilter(const ShadowMomentFilter&);
+	ShadowMomentFilter& operator=(const ShadowMomentFilter&);
+
+	void DrawPass(RenderTechnique technique, RenderTargetView target);
+};
+#endif
@@ -0,0 +1,151 @@
+// Turns the cascades of the shadow map into moments for the VSM and EVSM filters of Ground.fx and
+// Effect.fx. Every slice is resolved at half the size and blurred with a separable Gaussian, the mip
+// chain is generated afterwards.
+
+struct PS_INPUT
+{
+	float4		position	: SV_POSITION;
+	float2		uv			: TEXCOORD;
+};
+
+RasterizerState NoCulling
+{
+	CullMode = None;
+};
+
+DepthStencilState DisableDepth
+{
+	DepthEnable = FALSE;
+	DepthWriteMask = ZERO;
+};
+
+SamplerState clampSampler {
+	Filter = MIN_MAG_MIP_LINEAR;
+	AddressU = Clamp;
+	AddressV = Clamp;
+};
+
+Texture2DArray gDepthMap;		// The cascades
+Texture2DArray gMomentMap;		// Source of a blur
+int gSlice;
+float2 gTexelSize;				// Of the source of a blur
+
+// Must match ShadowFilters.fxh. exp(2 * 40) is still well inside a 32-bit float.
+static const float gEVSMExponent = 40.0f;
+
+// A Gaussian over 9 texels in 5 bilinear taps, the outer taps fall between two texels
+static const float gBlurOffsets[3] = { 0.0f, 1.3846153846f, 3.2307692308f };
+static const float gBlurWeights[3] = { 0.2270270270f, 0.3162162162f, 0.0702702703f };
+
+// ************************************************************************
+// ** HELPER FUNCTIONS
+// ************************************************************************
+
+float2 GetMoments(float depth, uniform bool exponential)
+{
+	float warped = exponential ? exp(gEVSMExponent * depth) : depth;
+	return float2(warped, warped * warped);
+}
+
+// ************************************************************************
+// ** SHADER FUNCTIONS
+// ************************************************************************
+
+// A triangle that covers the target, made from the vertex index without a vertex buffer
+PS_INPUT VS(uint vertexID : SV_VertexID)
+{
+	PS_INPUT output;
+
+	output.uv = float2((vertexID << 1) & 2, vertexID & 2);
+	output.position = float4(output.uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+
+	return output;
+}
+
+// Each moment texel averages the moments of the 2x2 depth texels under it
+float2 ResolvePS(PS_INPUT input, uniform bool exponential) : SV_Target0
+{
+	int2 texel = (int2)input.position.xy * 2;
+
+	float2 moments = 0.0f;
+	[unroll]
+	for(int i = 0; i < 4; ++i)
+	{
+		float depth = gDepthMap.Load(int4(texel + int2(i % 2, i / 2), gSlice, 0)).r;
+		moments += GetMoments(depth, exponential);
+	}
+
+	return moments * 0.25f;
+}
+
+float2 BlurPS(PS_INPUT input, uniform float2 direction) : SV_Target0
+{
+	float3 uv = float3(input.uv, gSlice);
+	float2 moments = gMomentMap.SampleLevel(clampSampler, uv, 0).rg * gBlurWeights[0];
+
+	[unroll]
+	for(int i = 1; i < 3; ++i)
+	{
+		float3 offset = float3(direction * gTexelSize * gBlurOffsets[i], 0.0f);
+		moments += gMomentMap.SampleLevel(clampSampler, uv + offset, 0).rg * gBlurWeights[i];
+		moments += gMomentMap.SampleLevel(clampSampler, uv - offset, 0).rg * gBlurWeights[i];
+	}
+
+	return moments;
+}
+
+// ************************************************************************
+// ** TECHNIQUES
+// ************************************************************************
+
+technique10 ResolveVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, ResolvePS(false)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 ResolveEVSMTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, ResolvePS(true)));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 BlurHorizontalTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, BlurPS(float2(1.0f, 0.0f))));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
+
+technique10 BlurVerticalTechnique
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VS()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, BlurPS(float2(0.0f, 1.0f))));
+
+		SetRasterizerState(NoCulling);
+		SetDepthStencilState(DisableDepth, 0);
+	}
+}
@@ -0,0 +1,316 @@
+#include "ShadowRasterizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#ifdef SHADOW_RASTERIZER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const int C_TILE_SIZE = 8;				// The buffer size is rounded up to whole tiles
+	const int C_TILE_GRAIN_SIZE = 64;		// Tiles per job
+	const float C_MIN_W = 0.001f;
+
+	// The rasterizer state CullFrontBiased of EffectShadows.fx
+	const float C_DEPTH_BIAS = 8.0f;
+	const float C_SLOPE_SCALED_DEPTH_BIAS = 2.0f;
+	const float C_DEPTH_BIAS_CLAMP = 0.01f;
+}
+
+ShadowRasterizer::ShadowRasterizer(int size)
+	: mSize(0), mTilesPerSide(0), mCulledTriangles(0)
+{
+	D3DXMatrixIdentity(&mViewProj);
+	Resize(size);
+}
+
+void ShadowRasterizer::Resize(int size)
+{
+	mSize = (size + C_TILE_SIZE - 1) / C_TILE_SIZE * C_TILE_SIZE;
+	mTilesPerSide = mSize / C_TILE_SIZE;
+	mDepth.assign(mSize * mSize, 1.0f);
+	mTileBins.clear();
+	mTileBins.resize(mTilesPerSide * mTilesPerSide);
+	mTriangles.clear();
+}
+
+// Clear the casters of the last frame and set the light they are seen from
+void ShadowRasterizer::BeginFrame(const D3DXMATRIX& viewProj)
+{
+	mViewProj = viewProj;
+	mTriangles.clear();
+	mCulledTriangles = 0;
+
+	for(size_t i = 0; i < mTileBins.size(); ++i)
+		mTileBins[i].clear();
+}
+
+// Add a triangle list in object space, returns the number of triangles that were kept
+int ShadowRasterizer::AddCaster(const D3DXVECTOR3* vertices, int numVertices, const D3DXMATRIX& world)
+{
+	D3DXMATRIX worldViewProj = world * mViewProj;
+
+	int numAdded = 0;
+	for(int i = 0; i + 2 < numVertices; i += 3)
+	{
+		D3DXVECTOR4 clip[3];
+		for(int k = 0; k < 3; ++k)
+			D3DXVec3Transform(&clip[k], &vertices[i + k], &worldViewProj);
+
+		if(AddTriangle(clip[0], clip[1], clip[2]))
+			++numAdded;
+		else
+			++mCulledTriangles;
+	}
+
+	return numAdded;
+}
+
+// Rasterize the binned triangles, a job per group of tiles
+void ShadowRasterizer::Rasterize(JobSystem* jobSystem)
+{
+	int numTiles = mTilesPerSide * mTilesPerSide;
+	if(jobSystem != NULL)
+	{
+		JobCounter tilesDone;
+		jobSystem->ParallelFor(RasterizeTilesJob, this, numTiles, C_TILE_GRAIN_SIZE, &tilesDone);
+		jobSystem->Wait(&tilesDone);
+	}
+	else
+		RasterizeTilesJob(this, 0, numTiles);
+}
+
+int ShadowRasterizer::GetSize() const
+{
+	return mSize;
+}
+
+int ShadowRasterizer::GetTriangleCount() const
+{
+	return (int)mTriangles.size();
+}
+
+// Front facing, degenerate, behind the light or out of the buffer
+int ShadowRasterizer::GetCulledTriangleCount() const
+{
+	return mCulledTriangles;
+}
+
+const float* ShadowRasterizer::GetDepthBuffer() const
+{
+	return &mDepth[0];
+}
+
+void ShadowRasterizer::RasterizeTilesJob(void* data, int first, int count)
+{
+	ShadowRasterizer* rasterizer = static_cast<ShadowRasterizer*>(data);
+	for(int i = first; i < first + count; ++i)
+		rasterizer->RasterizeTile(i);
+}
+
+// Set the triangle up like the GPU would and put it in the bins of the tiles it may touch
+bool ShadowRasterizer::AddTriangle(const D3DXVECTOR4& a, const D3DXVECTOR4& b, const D3DXVECTOR4& c)
+{
+	const D3DXVECTOR4* clip[3] = { &a, &b, &c };
+	float x[3], y[3], z[3];
+	int numBeyondFar = 0;
+
+	for(int k = 0; k < 3; ++k)
+	{
+		if(clip[k]->w < C_MIN_W)
+			return false;
+
+		// Flattened onto the near plane like the vertex shader does
+		float invW = 1.0f / clip[k]->w;
+		x[k] = (clip[k]->x * invW * 0.5f + 0.5f) * mSize;
+		y[k] = (0.5f - clip[k]->y * invW * 0.5f) * mSize;
+		z[k] = std::max(clip[k]->z, 0.0f) * invW;
+
+		if(z[k] > 1.0f)
+			++numBeyondFar;
+	}
+
+	if(numBeyondFar == 3)
+		return false;
+
+	// Clockwise on the screen is the front face, which is culled
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if(area >= 0.0f)
+		return false;
+
+	std::swap(x[1], x[2]);
+	std::swap(y[1], y[2]);
+	std::swap(z[1], z[2]);
+	area = -area;
+
+	ScreenTriangle triangle;
+	float minX = std::min(x[0], std::min(x[1], x[2]));
+	float maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2]));
+	float maxY = std::max(y[0], std::max(y[1], y[2]));
+
+	// Only pixel centers are sampled, so the rectangle covers the centers inside the bounds
+	triangle.MinX = std::max(0, (int)ceil(minX - 0.5f));
+	triangle.MinY = std::max(0, (int)ceil(minY - 0.5f));
+	triangle.MaxX = std::min(mSize - 1, (int)floor(maxX - 0.5f));
+	triangle.MaxY = std::min(mSize - 1, (int)floor(maxY - 0.5f));
+
+	if(triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+		return false;
+
+	// Edge i is the one opposite vertex i. A pixel center on an edge belongs to the triangle if the
+	// edge is a top edge, with the inside below it, or a left edge, with the inside to its right.
+	triangle.TopLeft = 0;
+	for(int i = 0; i < 3; ++i)
+	{
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		triangle.EdgeA[i] = y[from] - y[to];
+		triangle.EdgeB[i] = x[to] - x[from];
+		triangle.EdgeC[i] = -(triangle.EdgeA[i] * x[from] + triangle.EdgeB[i] * y[from]);
+
+		if(triangle.EdgeA[i] > 0.0f || (triangle.EdgeA[i] == 0.0f && triangle.EdgeB[i] > 0.0f))
+			triangle.TopLeft |= 1 << i;
+	}
+
+	// Depth is linear in screen space: z = ZA * px + ZB * py + ZC
+	float invArea = 1.0f / area;
+	triangle.ZA = (triangle.EdgeA[0] * z[0] + triangle.EdgeA[1] * z[1] + triangle.EdgeA[2] * z[2]) * invArea;
+	triangle.ZB = (triangle.EdgeB[0] * z[0] + triangle.EdgeB[1] * z[1] + triangle.EdgeB[2] * z[2]) * invArea;
+	triangle.ZC = (triangle.EdgeC[0] * z[0] + triangle.EdgeC[1] * z[1] + triangle.EdgeC[2] * z[2]) * invArea;
+
+	// The bias of a float depth buffer: DepthBias units of the largest depth's exponent minus the
+	// mantissa bits, plus the slope scaled part, clamped
+	float maxZ = std::max(z[0], std::max(z[1], z[2]));
+	int exponent = 0;
+	frexp(maxZ, &exponent);
+	float bias = (maxZ > 0.0f ? C_DEPTH_BIAS * (float)ldexp(1.0, exponent - 24) : 0.0f) +
+				 C_SLOPE_SCALED_DEPTH_BIAS * std::max(fabs(triangle.ZA), fabs(triangle.ZB));
+	triangle.ZC += std::min(bias, C_DEPTH_BIAS_CLAMP);
+
+	int index = (int)mTriangles.size();
+	mTriangles.push_back(triangle);
+
+	// Tiles whose pixel centers are all outside one of the edges are skipped
+	for(int ty = triangle.MinY / C_TILE_SIZE; ty <= triangle.MaxY / C_TILE_SIZE; ++ty)
+	{
+		float tileMinY = ty * C_TILE_SIZE + 0.5f;
+		float tileMaxY = tileMinY + C_TILE_SIZE - 1;
+
+		for(int tx = triangle.MinX / C_TILE_SIZE; tx <= triangle.MaxX / C_TILE_SIZE; ++tx)
+		{
+			float tileMinX = tx * C_TILE_SIZE + 0.5f;
+			float tileMaxX = tileMinX + C_TILE_SIZE - 1;
+
+			bool outside = false;
+			for(int i = 0; i < 3 && !outside; ++i)
+			{
+				float edgeMax = triangle.EdgeA[i] * (triangle.EdgeA[i] > 0.0f ? tileMaxX : tileMinX) +
+								triangle.EdgeB[i] * (triangle.EdgeB[i] > 0.0f ? tileMaxY : tileMinY) + triangle.EdgeC[i];
+				outside = edgeMax < 0.0f;
+			}
+
+			if(!outside)
+				mTileBins[ty * mTilesPerSide + tx].push_back(index);
+		}
+	}
+
+	return true;
+}
+
+void ShadowRasterizer::RasterizeTile(int tile)
+{
+	int tileX = (tile % mTilesPerSide) * C_TILE_SIZE;
+	int tileY = (tile / mTilesPerSide) * C_TILE_SIZE;
+
+	for(int y = tileY; y < tileY + C_TILE_SIZE; ++y)
+		std::fill(mDepth.begin() + y * mSize + tileX, mDepth.begin() + y * mSize + tileX + C_TILE_SIZE, 1.0f);
+
+	const std::vector<int>& bin = mTileBins[tile];
+	for(size_t i = 0; i < bin.size(); ++i)
+		RasterizeTriangle(mTriangles[bin[i]], tileX, tileY);
+}
+
+// Rasterize the part of a triangle inside one tile
+void ShadowRasterizer::RasterizeTriangle(const ScreenTriangle& triangle, int tileX, int tileY)
+{
+	int minY = std::max(triangle.MinY, tileY);
+	int maxY = std::min(triangle.MaxY, tileY + C_TILE_SIZE - 1);
+	float* depth = &mDepth[0];
+
+#ifdef SHADOW_RASTERIZER_SSE
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 allBits = _mm_cmpeq_ps(zero, zero);
+
+	__m128 edgeA[3];
+	__m128 topLeft[3];
+	for(int i = 0; i < 3; ++i)
+	{
+		edgeA[i] = _mm_set1_ps(triangle.EdgeA[i]);
+		topLeft[i] = (triangle.TopLeft & (1 << i)) != 0 ? allBits : zero;
+	}
+	__m128 zA = _mm_set1_ps(triangle.ZA);
+
+	// The two groups of four pixels in a row of the tile, skipped when outside the triangle's bounds
+	int firstGroup = triangle.MinX > tileX + 3 ? 1 : 0;
+	int lastGroup = triangle.MaxX < tileX + 4 ? 0 : 1;
+
+	for(int py = minY; py <= maxY; ++py)
+	{
+		float centerY = py + 0.5f;
+		float* row = depth + py * mSize + tileX;
+
+		for(int group = firstGroup; group <= lastGroup; ++group)
+		{
+			float groupX = (float)(tileX + group * 4);
+			__m128 px = _mm_add_ps(_mm_set1_ps(groupX), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+
+			__m128 inside = allBits;
+			for(int i = 0; i < 3; ++i)
+			{
+				__m128 edge = _mm_add_ps(_mm_mul_ps(px, edgeA[i]),
+										 _mm_set1_ps(triangle.EdgeB[i] * centerY + triangle.EdgeC[i]));
+				__m128 onEdge = _mm_and_ps(_mm_cmpeq_ps(edge, zero), topLeft[i]);
+				inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(edge, zero), onEdge));
+			}
+
+			if(_mm_movemask_ps(inside) == 0)
+				continue;
+
+			__m128 pixelZ = _mm_add_ps(_mm_mul_ps(px, zA), _mm_set1_ps(triangle.ZB * centerY + triangle.ZC));
+			inside = _mm_and_ps(inside, _mm_cmple_ps(pixelZ, one));
+
+			__m128 current = _mm_loadu_ps(row + group * 4);
+			__m128 nearer = _mm_min_ps(current, pixelZ);
+			_mm_storeu_ps(row + group * 4, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+		}
+	}
+#else
+	int minX = std::max(triangle.MinX, tileX);
+	int maxX = std::min(triangle.MaxX, tileX + C_TILE_SIZE - 1);
+
+	for(int py = minY; py <= maxY; ++py)
+	{
+		float centerY = py + 0.5f;
+		float* row = depth + py * mSize;
+
+		for(int px = minX; px <= maxX; ++px)
+		{
+			float centerX = px + 0.5f;
+			bool inside = true;
+			for(int i = 0; i < 3 && inside; ++i)
+			{
+				float edge = triangle.EdgeA[i] * centerX + triangle.EdgeB[i] * centerY + triangle.EdgeC[i];
+				inside = edge > 0.0f || (edge == 0.0f && (triangle.TopLeft & (1 << i)) != 0);
+			}
+
+			float pixelZ = triangle.ZA * centerX + triangle.ZB * centerY + triangle.ZC;
+			if(inside && pixelZ <= 1.0f && pixelZ < row[px])
+				row[px] = pixelZ;
+		}
+	}
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef SHADOW_RASTERIZER_H
+#define SHADOW_RASTERIZER_H
+
+#include <vector>
+#include <D3DX10.h>
+
+#include "JobSystem.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define SHADOW_RASTERIZER_SSE
+#endif
+
+// Draws the depth of shadow casters on the CPU, for a square buffer that is uploaded as a slice of
+// the shadow map. It follows the depth pass of EffectShadows.fx so the receivers cannot tell the
+// difference: depth in front of the near plane is flattened onto it, front faces are culled, the
+// same slope scaled bias is added, pixel centers are sampled with the top-left rule and the nearest
+// depth wins. Row 0 is the top of the light's view, like the texture.
+//
+// Triangles are set up and binned into 8x8 pixel tiles on the calling thread. The tiles are then
+// rasterized in parallel, a row of a tile is two groups of four pixels.
+class ShadowRasterizer
+{
+public:
+	ShadowRasterizer(int size = 1024);
+	void Resize(int size);
+
+	void BeginFrame(const D3DXMATRIX& viewProj);
+	int AddCaster(const D3DXVECTOR3* vertices, int numVertices, const D3DXMATRIX& world);
+	void Rasterize(JobSystem* jobSystem);
+
+	int GetSize() const;
+	int GetTriangleCount() const;			// Added since BeginFrame, after culling
+	int GetCulledTriangleCount() const;
+	const float* GetDepthBuffer() const;
+
+private:
+	// The edge functions and depth plane of a triangle in pixels, e(x, y) = A * x + B * y + C is
+	// positive inside
+	struct ScreenTriangle
+	{
+		float				EdgeA[3];
+		float				EdgeB[3];
+		float				EdgeC[3];
+		float				ZA;
+		float				ZB;
+		float				ZC;
+		int					MinX;
+		int					MinY;
+		int					MaxX;
+		int					MaxY;
+		int					TopLeft;				// One bit per edge that owns the pixels on it
+	};
+
+	int										mSize;
+	int										mTilesPerSide;
+	D3DXMATRIX								mViewProj;
+	std::vector<float>						mDepth;
+
+	std::vector<ScreenTriangle>				mTriangles;
+	std::vector<std::vector<int> >			mTileBins;
+	int										mCulledTriangles;
+
+	static void RasterizeTilesJob(void* data, int first, int count);
+
+	bool AddTriangle(const D3DXVECTOR4& a, const D3DXVECTOR4& b, const D3DXVECTOR4& c);
+	void RasterizeTile(int tile);
+	void RasterizeTriangle(const ScreenTriangle& triangle, int tileX, int tileY);
+};
+#endif
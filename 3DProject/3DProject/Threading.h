@@ -0,0 +1,187 @@
+#ifndef THREADING_H
+#define THREADING_H
+
+// Thin wrappers around the platform threading primitives, so that the systems built on them
+// (JobSystem and everything that runs jobs) do not depend on Windows or Direct3D.
+
+#ifdef _WIN32
+#include <Windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#define THREAD_LOCAL __thread
+#endif
+
+// Atomic operations on a 32-bit integer, all of them act as full memory barriers
+namespace Atomic
+{
+#ifdef _WIN32
+	inline long Increment(volatile long* value)		{ return InterlockedIncrement(value); }
+	inline long Decrement(volatile long* value)		{ return InterlockedDecrement(value); }
+	inline long Add(volatile long* value, long add)	{ return InterlockedExchangeAdd(value, add) + add; }
+	inline long Load(volatile long* value)			{ return InterlockedCompareExchange(value, 0, 0); }
+	inline void Store(volatile long* value, long v)	{ InterlockedExchange(value, v); }
+#else
+	inline long Increment(volatile long* value)		{ return __sync_add_and_fetch(value, 1); }
+	inline long Decrement(volatile long* value)		{ return __sync_sub_and_fetch(value, 1); }
+	inline long Add(volatile long* value, long add)	{ return __sync_add_and_fetch(value, add); }
+	inline long Load(volatile long* value)			{ return __sync_add_and_fetch(value, 0); }
+	inline void Store(volatile long* value, long v)	{ __sync_lock_test_and_set(value, v); __sync_synchronize(); }
+#endif
+}
+
+class Mutex
+{
+public:
+#ifdef _WIN32
+	Mutex()			{ InitializeCriticalSection(&mLock); }
+	~Mutex()		{ DeleteCriticalSection(&mLock); }
+	void Lock()		{ EnterCriticalSection(&mLock); }
+	void Unlock()	{ LeaveCriticalSection(&mLock); }
+#else
+	Mutex()			{ pthread_mutex_init(&mLock, NULL); }
+	~Mutex()		{ pthread_mutex_destroy(&mLock); }
+	void Lock()		{ pthread_mutex_lock(&mLock); }
+	void Unlock()	{ pthread_mutex_unlock(&mLock); }
+#endif
+
+private:
+	friend class ConditionVariable;
+
+#ifdef _WIN32
+	CRITICAL_SECTION		mLock;
+#else
+	pthread_mutex_t			mLock;
+#endif
+
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+};
+
+// Locks a mutex for the lifetime of the object
+class ScopedLock
+{
+public:
+	explicit ScopedLock(Mutex& mutex) : mMutex(mutex) { mMutex.Lock(); }
+	~ScopedLock() { mMutex.Unlock(); }
+
+private:
+	Mutex&					mMutex;
+
+	ScopedLock(const ScopedLock&);
+	ScopedLock& operator=(const ScopedLock&);
+};
+
+class ConditionVariable
+{
+public:
+#ifdef _WIN32
+	ConditionVariable()				{ InitializeConditionVariable(&mCondition); }
+	~ConditionVariable()			{}
+	void Wait(Mutex& mutex)			{ SleepConditionVariableCS(&mCondition, &mutex.mLock, INFINITE); }
+	void NotifyOne()				{ WakeConditionVariable(&mCondition); }
+	void NotifyAll()				{ WakeAllConditionVariable(&mCondition); }
+#else
+	ConditionVariable()				{ pthread_cond_init(&mCondition, NULL); }
+	~ConditionVariable()			{ pthread_cond_destroy(&mCondition); }
+	void Wait(Mutex& mutex)			{ pthread_cond_wait(&mCondition, &mutex.mLock); }
+	void NotifyOne()				{ pthread_cond_signal(&mCondition); }
+	void NotifyAll()				{ pthread_cond_broadcast(&mCondition); }
+#endif
+
+private:
+#ifdef _WIN32
+	CONDITION_VARIABLE		mCondition;
+#else
+	pthread_cond_t			mCondition;
+#endif
+
+	ConditionVariable(const ConditionVariable&);
+	ConditionVariable& operator=(const ConditionVariable&);
+};
+
+typedef void (*ThreadFunction)(void* argument);
+
+class Thread
+{
+public:
+	Thread() : mFunction(NULL), mArgument(NULL), mStarted(false) {}
+	~Thread() { Join(); }
+
+	void Start(ThreadFunction function, void* argument)
+	{
+		mFunction = function;
+		mArgument = argument;
+#ifdef _WIN32
+		mHandle = CreateThread(NULL, 0, ThreadEntry, this, 0, NULL);
+		mStarted = mHandle != NULL;
+#else
+		mStarted = pthread_create(&mHandle, NULL, ThreadEntry, this) == 0;
+#endif
+	}
+
+	void Join()
+	{
+		if(!mStarted)
+			return;
+#ifdef _WIN32
+		WaitForSingleObject(mHandle, INFINITE);
+		CloseHandle(mHandle);
+#else
+		pthread_join(mHandle, NULL);
+#endif
+		mStarted = false;
+	}
+
+	static int GetHardwareThreadCount()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return (int)info.dwNumberOfProcessors;
+#else
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		return count > 0 ? (int)count : 1;
+#endif
+	}
+
+	static void YieldThread()
+	{
+#ifdef _WIN32
+		SwitchToThread();
+#else
+		sched_yield();
+#endif
+	}
+
+private:
+	ThreadFunction			mFunction;
+	void*					mArgument;
+	bool					mStarted;
+
+#ifdef _WIN32
+	HANDLE					mHandle;
+
+	static DWORD WINAPI ThreadEntry(LPVOID thread)
+	{
+		Thread* self = static_cast<Thread*>(thread);
+		self->mFunction(self->mArgument);
+		return 0;
+	}
+#else
+	pthread_t				mHandle;
+
+	static void* ThreadEntry(void* thread)
+	{
+		Thread* self = static_cast<Thread*>(thread);
+		self->mFunction(self->mArgument);
+		return NULL;
+	}
+#endif
+
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+};
+#endif
@@ -0,0 +1,44 @@
+#ifndef TRAVERSAL_STACK_H
+#define TRAVERSAL_STACK_H
+
+#include <vector>
+
+// Traversal stack for trees that lives on the program stack for all reasonable tree heights and
+// spills over to the heap for the rest
+template<typename T, int FixedSize = 64>
+class TraversalStack
+{
+public:
+	TraversalStack() : mCount(0) {}
+
+	void Push(const T& value)
+	{
+		if(mCount < FixedSize)
+			mFixed[mCount] = value;
+		else
+			mOverflow.push_back(value);
+		++mCount;
+	}
+
+	T Pop()
+	{
+		--mCount;
+		if(mCount < FixedSize)
+			return mFixed[mCount];
+
+		T value = mOverflow.back();
+		mOverflow.pop_back();
+		return value;
+	}
+
+	bool IsEmpty() const
+	{
+		return mCount == 0;
+	}
+
+private:
+	T					mFixed[FixedSize];
+	std::vector<T>		mOverflow;
+	int					mCount;
+};
+#endif
@@ -0,0 +1,831 @@
+#include "TriangleBVH.h"
+#include "GameTime.h"
+#include "TraversalStack.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef TRIANGLE_BVH_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const int C_LEAF_SIZE = 4;					// Triangles per pack
+	const int C_MAX_SAH_DEPTH = 64;				// Below this depth ranges are split at the median
+	const int C_SUBTREE_SIZE = 16384;			// Ranges up to this size are built by one job
+	const int C_BIN_CHUNK_SIZE = 65536;			// Triangles per job when binning a large range
+	const int C_PREPARE_GRAIN_SIZE = 16384;
+	const int C_NODE_ALIGNMENT = 64;
+	const int C_EMPTY_CHILD = 0x7FFFFFFF;
+	const float C_DETERMINANT_EPSILON = 1e-12f;
+
+	// Orders build entries by their centroid along one axis
+	template<typename T>
+	struct CentroidLess
+	{
+		int					Axis;
+
+		explicit CentroidLess(int axis) : Axis(axis) {}
+
+		bool operator()(const T& a, const T& b) const
+		{
+			return a.Centroid[Axis] < b.Centroid[Axis];
+		}
+	};
+}
+
+TriangleBVH::TriangleBVH()
+	: mNodes(NULL), mNumNodes(0), mPacks(NULL), mNumPacks(0), mNumTriangles(0), mBuildMilliseconds(0.0),
+	  mVertices(NULL), mRangeFirst(0), mRangeCount(0), mBinAxis(0), mBinMin(0.0f), mBinScale(0.0f)
+{
+}
+
+TriangleBVH::~TriangleBVH()
+{
+	Clear();
+}
+
+// Build the tree over a triangle list, three vertices per triangle. The vertices are only read during
+// the build, the tree keeps its own copy of the triangles.
+void TriangleBVH::Build(const D3DXVECTOR3* vertices, int numTriangles, JobSystem* jobSystem)
+{
+	Stopwatch timer;
+	timer.Start();
+
+	Clear();
+	if(numTriangles <= 0)
+		return;
+
+	mVertices = vertices;
+	mNumTriangles = numTriangles;
+	mBuildTriangles.resize(numTriangles);
+	RunJobs(jobSystem, PrepareTrianglesJob, numTriangles, C_PREPARE_GRAIN_SIZE);
+
+	// The top of the tree is split here, the subtrees below it by one job each
+	mBuildNodes.reserve(2 * numTriangles / C_LEAF_SIZE + 1);
+	BuildTop(0, numTriangles, 0, jobSystem);
+	RunJobs(jobSystem, BuildSubtreesJob, (int)mSubtrees.size(), 1);
+	MergeSubtrees();
+
+	int numLeaves = 0;
+	for(size_t i = 0; i < mBuildNodes.size(); ++i)
+	{
+		if(mBuildNodes[i].Left < 0)
+			++numLeaves;
+	}
+
+	// Every binary node either becomes a node or is opened into its parent, so this is an upper bound
+	int maxNodes = std::max((int)mBuildNodes.size() - numLeaves, 1);
+	mNodes = static_cast<Node*>(_aligned_malloc(sizeof(Node) * maxNodes, C_NODE_ALIGNMENT));
+	mPacks = static_cast<TrianglePack*>(_aligned_malloc(sizeof(TrianglePack) * numLeaves, C_NODE_ALIGNMENT));
+
+	const BuildNode& root = mBuildNodes[0];
+	mBounds = root.Bounds;
+	if(root.Left < 0)
+	{
+		// A single leaf still gets a node above it, so traversal always starts at a node
+		Node& node = mNodes[mNumNodes++];
+		memset(&node, 0, sizeof(Node));
+		for(int c = 1; c < 4; ++c)
+			node.Child[c] = C_EMPTY_CHILD;
+
+		node.MinX[0] = root.Bounds.Min.x;
+		node.MinY[0] = root.Bounds.Min.y;
+		node.MinZ[0] = root.Bounds.Min.z;
+		node.MaxX[0] = root.Bounds.Max.x;
+		node.MaxY[0] = root.Bounds.Max.y;
+		node.MaxZ[0] = root.Bounds.Max.z;
+		node.Child[0] = ~CreatePack(root.First, root.Count);
+	}
+	else
+		Collapse(0);
+
+	// Release the build data rather than keeping it around for the next build
+	std::vector<BuildTriangle>().swap(mBuildTriangles);
+	std::vector<BuildNode>().swap(mBuildNodes);
+	std::vector<Subtree>().swap(mSubtrees);
+	std::vector<RangeBins>().swap(mChunkBins);
+	mVertices = NULL;
+
+	mBuildMilliseconds = timer.Stop().Milliseconds;
+}
+
+void TriangleBVH::Clear()
+{
+	if(mNodes != NULL)
+		_aligned_free(mNodes);
+	if(mPacks != NULL)
+		_aligned_free(mPacks);
+
+	mNodes = NULL;
+	mPacks = NULL;
+	mNumNodes = 0;
+	mNumPacks = 0;
+	mNumTriangles = 0;
+	mBounds = AABB();
+}
+
+// Find the closest triangle hit by the ray within maxDistance. The direction does not have to be
+// normalized, distances are then measured in lengths of it. Triangles are hit from both sides.
+bool TriangleBVH::RayCast(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance,
+						  RayHit& hit) const
+{
+	hit.Distance = maxDistance;
+	hit.Triangle = -1;
+	hit.U = 0.0f;
+	hit.V = 0.0f;
+
+	if(mNumNodes == 0)
+		return false;
+
+	// Divisions by zero give infinities, which the slab test handles
+	D3DXVECTOR3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	TraversalStack<StackEntry> stack;
+	StackEntry rootEntry = { 0, 0.0f };
+	stack.Push(rootEntry);
+
+	while(!stack.IsEmpty())
+	{
+		StackEntry entry = stack.Pop();
+
+		// A closer hit may have been found since the entry was pushed
+		if(entry.Distance > hit.Distance)
+			continue;
+
+		if(entry.Child < 0)
+		{
+			IntersectPack(mPacks[~entry.Child], origin, direction, hit);
+			continue;
+		}
+
+		float distances[4];
+		int mask = IntersectChildren(mNodes[entry.Child], origin, invDirection, hit.Distance, distances);
+		if(mask == 0)
+			continue;
+
+		// Sort the children that were hit by distance, farthest first, so the nearest is popped first
+		StackEntry children[4];
+		int numChildren = 0;
+		for(int c = 0; c < 4; ++c)
+		{
+			if((mask & (1 << c)) == 0)
+				continue;
+
+			int position = numChildren++;
+			while(position > 0 && children[position - 1].Distance < distances[c])
+			{
+				children[position] = children[position - 1];
+				--position;
+			}
+
+			children[position].Child = mNodes[entry.Child].Child[c];
+			children[position].Distance = distances[c];
+		}
+
+		for(int c = 0; c < numChildren; ++c)
+			stack.Push(children[c]);
+	}
+
+	return hit.Triangle >= 0;
+}
+
+// Whether any triangle is hit within maxDistance, which stops at the first one found
+bool TriangleBVH::IsOccluded(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance) const
+{
+	if(mNumNodes == 0)
+		return false;
+
+	D3DXVECTOR3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	RayHit hit;
+	hit.Distance = maxDistance;
+	hit.Triangle = -1;
+
+	TraversalStack<int> stack;
+	stack.Push(0);
+
+	while(!stack.IsEmpty())
+	{
+		int child = stack.Pop();
+		if(child < 0)
+		{
+			IntersectPack(mPacks[~child], origin, direction, hit);
+			if(hit.Triangle >= 0)
+				return true;
+
+			continue;
+		}
+
+		const Node& node = mNodes[child];
+		float distances[4];
+		int mask = IntersectChildren(node, origin, invDirection, maxDistance, distances);
+		for(int c = 0; c < 4; ++c)
+		{
+			if(mask & (1 << c))
+				stack.Push(node.Child[c]);
+		}
+	}
+
+	return false;
+}
+
+int TriangleBVH::GetTriangleCount() const
+{
+	return mNumTriangles;
+}
+
+int TriangleBVH::GetNodeCount() const
+{
+	return mNumNodes;
+}
+
+const AABB& TriangleBVH::GetBounds() const
+{
+	return mBounds;
+}
+
+double TriangleBVH::GetBuildMilliseconds() const
+{
+	return mBuildMilliseconds;
+}
+
+void TriangleBVH::PrepareTrianglesJob(void* data, int first, int count)
+{
+	TriangleBVH* bvh = static_cast<TriangleBVH*>(data);
+	for(int i = first; i < first + count; ++i)
+	{
+		const D3DXVECTOR3* v = bvh->mVertices + 3 * i;
+		BuildTriangle& triangle = bvh->mBuildTriangles[i];
+
+		triangle.Bounds = AABB(v[0], v[0]);
+		triangle.Bounds.Expand(v[1]);
+		triangle.Bounds.Expand(v[2]);
+		triangle.Centroid = triangle.Bounds.GetCenter();
+		triangle.Index = i;
+	}
+}
+
+void TriangleBVH::RangeBoundsJob(void* data, int first, int count)
+{
+	TriangleBVH* bvh = static_cast<TriangleBVH*>(data);
+	for(int chunk = first; chunk < first + count; ++chunk)
+	{
+		RangeBins& bins = bvh->mChunkBins[chunk];
+		bins.Bounds = AABB();
+		bins.CentroidBounds = AABB();
+
+		int begin = bvh->mRangeFirst + chunk * C_BIN_CHUNK_SIZE;
+		int end = std::min(begin + C_BIN_CHUNK_SIZE, bvh->mRangeFirst + bvh->mRangeCount);
+		for(int i = begin; i < end; ++i)
+		{
+			bins.Bounds.Expand(bvh->mBuildTriangles[i].Bounds);
+			bins.CentroidBounds.Expand(bvh->mBuildTriangles[i].Centroid);
+		}
+	}
+}
+
+void TriangleBVH::RangeBinsJob(void* data, int first, int count)
+{
+	TriangleBVH* bvh = static_cast<TriangleBVH*>(data);
+	for(int chunk = first; chunk < first + count; ++chunk)
+	{
+		int begin = bvh->mRangeFirst + chunk * C_BIN_CHUNK_SIZE;
+		int end = std::min(begin + C_BIN_CHUNK_SIZE, bvh->mRangeFirst + bvh->mRangeCount);
+		bvh->FillBins(begin, end - begin, bvh->mBinAxis, bvh->mBinMin, bvh->mBinScale, bvh->mChunkBins[chunk]);
+	}
+}
+
+void TriangleBVH::BuildSubtreesJob(void* data, int first, int count)
+{
+	TriangleBVH* bvh = static_cast<TriangleBVH*>(data);
+	for(int i = first; i < first + count; ++i)
+	{
+		Subtree& subtree = bvh->mSubtrees[i];
+		subtree.Nodes.reserve(2 * subtree.Count / C_LEAF_SIZE + 1);
+		bvh->BuildRange(subtree.Nodes, subtree.First, subtree.Count, 0);
+	}
+}
+
+// Run the jobs and wait for them, or run them here without a job system
+void TriangleBVH::RunJobs(JobSystem* jobSystem, JobFunction function, int count, int grainSize)
+{
+	if(count == 0)
+		return;
+
+	if(jobSystem == NULL)
+	{
+		function(this, 0, count);
+		return;
+	}
+
+	JobCounter done;
+	jobSystem->ParallelFor(function, this, count, grainSize, &done);
+	jobSystem->Wait(&done);
+}
+
+// Split the range with the bins filled in parallel until it is small enough for one job, and hand it
+// to a subtree. The node is reserved here and filled in with the subtree's root when they are merged.
+int TriangleBVH::BuildTop(int first, int count, int depth, JobSystem* jobSystem)
+{
+	int index = (int)mBuildNodes.size();
+	mBuildNodes.push_back(BuildNode());
+
+	if(count <= C_SUBTREE_SIZE || jobSystem == NULL)
+	{
+		Subtree subtree;
+		subtree.Node = index;
+		subtree.First = first;
+		subtree.Count = count;
+		mSubtrees.push_back(subtree);
+		return index;
+	}
+
+	int numChunks = (count + C_BIN_CHUNK_SIZE - 1) / C_BIN_CHUNK_SIZE;
+	mChunkBins.resize(numChunks);
+	mRangeFirst = first;
+	mRangeCount = count;
+	RunJobs(jobSystem, RangeBoundsJob, numChunks, 1);
+
+	RangeBins bins;
+	for(int chunk = 0; chunk < numChunks; ++chunk)
+	{
+		bins.Bounds.Expand(mChunkBins[chunk].Bounds);
+		bins.CentroidBounds.Expand(mChunkBins[chunk].CentroidBounds);
+	}
+
+	D3DXVECTOR3 size = bins.CentroidBounds.Max - bins.CentroidBounds.Min;
+	int axis = 0;
+	if(size.y > size[axis])
+		axis = 1;
+	if(size.z > size[axis])
+		axis = 2;
+
+	int middle;
+	if(size[axis] > 0.0f && depth < C_MAX_SAH_DEPTH)
+	{
+		mBinAxis = axis;
+		mBinMin = bins.CentroidBounds.Min[axis];
+		mBinScale = BinCount * 0.9999f / size[axis];
+		RunJobs(jobSystem, RangeBinsJob, numChunks, 1);
+
+		// Chunks are merged in order, so the bins do not depend on the worker count
+		for(int b = 0; b < BinCount; ++b)
+		{
+			bins.Counts[b] = 0;
+			bins.BinBounds[b] = AABB();
+			for(int chunk = 0; chunk < numChunks; ++chunk)
+			{
+				bins.Counts[b] += mChunkBins[chunk].Counts[b];
+				bins.BinBounds[b].Expand(mChunkBins[chunk].BinBounds[b]);
+			}
+		}
+
+		middle = SplitRange(first, count, axis, bins.CentroidBounds, &bins);
+	}
+	else
+		middle = SplitRange(first, count, axis, bins.CentroidBounds, NULL);
+
+	int left = BuildTop(first, middle - first, depth + 1, jobSystem);
+	int right = BuildTop(middle, first + count - middle, depth + 1, jobSystem);
+
+	mBuildNodes[index].Bounds = bins.Bounds;
+	mBuildNodes[index].Left = left;
+	mBuildNodes[index].Right = right;
+	mBuildNodes[index].First = first;
+	mBuildNodes[index].Count = count;
+
+	return index;
+}
+
+// Build the subtree for triangles [first, first + count) into nodes and return its root. The node is
+// allocated before its children, which gives the depth first layout.
+int TriangleBVH::BuildRange(std::vector<BuildNode>& nodes, int first, int count, int depth)
+{
+	int index = (int)nodes.size();
+	nodes.push_back(BuildNode());
+
+	AABB bounds;
+	AABB centroidBounds;
+	for(int i = first; i < first + count; ++i)
+	{
+		bounds.Expand(mBuildTriangles[i].Bounds);
+		centroidBounds.Expand(mBuildTriangles[i].Centroid);
+	}
+
+	nodes[index].Bounds = bounds;
+	nodes[index].First = first;
+	nodes[index].Count = count;
+	nodes[index].Left = -1;
+	nodes[index].Right = -1;
+
+	if(count <= C_LEAF_SIZE)
+		return index;
+
+	D3DXVECTOR3 size = centroidBounds.Max - centroidBounds.Min;
+	int axis = 0;
+	if(size.y > size[axis])
+		axis = 1;
+	if(size.z > size[axis])
+		axis = 2;
+
+	int middle;
+	if(size[axis] > 0.0f && depth < C_MAX_SAH_DEPTH)
+	{
+		RangeBins bins;
+		FillBins(first, count, axis, centroidBounds.Min[axis], BinCount * 0.9999f / size[axis], bins);
+		middle = SplitRange(first, count, axis, centroidBounds, &bins);
+	}
+	else
+		middle = SplitRange(first, count, axis, centroidBounds, NULL);
+
+	int left = BuildRange(nodes, first, middle - first, depth + 1);
+	int right = BuildRange(nodes, middle, first + count - middle, depth + 1);
+
+	nodes[index].Left = left;
+	nodes[index].Right = right;
+
+	return index;
+}
+
+// Partition the range at the bin boundary with the lowest surface area cost and return where the
+// right half starts. Without bins, or when every triangle falls in one bin, the range is split at the
+// median instead.
+int TriangleBVH::SplitRange(int first, int count, int axis, const AABB& centroidBounds, const RangeBins* bins)
+{
+	if(bins != NULL)
+	{
+		float rightArea[BinCount];
+		int rightCount[BinCount];
+		AABB accumulated;
+		int accumulatedCount = 0;
+		for(int i = BinCount - 1; i > 0; --i)
+		{
+			accumulated.Expand(bins->BinBounds[i]);
+			accumulatedCount += bins->Counts[i];
+			rightArea[i] = accumulatedCount > 0 ? accumulated.GetSurfaceArea() : 0.0f;
+			rightCount[i] = accumulatedCount;
+		}
+
+		int bestSplit = -1;
+		float bestCost = FLT_MAX;
+		accumulated = AABB();
+		accumulatedCount = 0;
+		for(int i = 1; i < BinCount; ++i)
+		{
+			accumulated.Expand(bins->BinBounds[i - 1]);
+			accumulatedCount += bins->Counts[i - 1];
+			if(accumulatedCount == 0 || rightCount[i] == 0)
+				continue;
+
+			float cost = accumulated.GetSurfaceArea() * accumulatedCount + rightArea[i] * rightCount[i];
+			if(cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if(bestSplit > 0)
+		{
+			float binMin = centroidBounds.Min[axis];
+			float scale = BinCount * 0.9999f / (centroidBounds.Max[axis] - binMin);
+
+			int left = first;
+			int right = first + count - 1;
+			while(left <= right)
+			{
+				int bin = (int)((mBuildTriangles[left].Centroid[axis] - binMin) * scale);
+				if(bin < bestSplit)
+					++left;
+				else
+					std::swap(mBuildTriangles[left], mBuildTriangles[right--]);
+			}
+
+			return left;
+		}
+	}
+
+	int middle = first + count / 2;
+	std::nth_element(mBuildTriangles.begin() + first, mBuildTriangles.begin() + middle,
+					 mBuildTriangles.begin() + first + count, CentroidLess<BuildTriangle>(axis));
+	return middle;
+}
+
+void TriangleBVH::FillBins(int first, int count, int axis, float binMin, float scale, RangeBins& bins) const
+{
+	for(int b = 0; b < BinCount; ++b)
+	{
+		bins.Counts[b] = 0;
+		bins.BinBounds[b] = AABB();
+	}
+
+	for(int i = first; i < first + count; ++i)
+	{
+		const BuildTriangle& triangle = mBuildTriangles[i];
+		int bin = (int)((triangle.Centroid[axis] - binMin) * scale);
+		++bins.Counts[bin];
+		bins.BinBounds[bin].Expand(triangle.Bounds);
+	}
+}
+
+// Copy the nodes of the subtrees into the top of the tree. A subtree's root replaces the node that
+// was reserved for it, the rest are appended with their child indices moved along.
+void TriangleBVH::MergeSubtrees()
+{
+	for(size_t s = 0; s < mSubtrees.size(); ++s)
+	{
+		Subtree& subtree = mSubtrees[s];
+		int offset = (int)mBuildNodes.size() - 1;
+
+		for(size_t i = 0; i < subtree.Nodes.size(); ++i)
+		{
+			BuildNode node = subtree.Nodes[i];
+			if(node.Left >= 0)
+			{
+				node.Left += offset;
+				node.Right += offset;
+			}
+
+			if(i == 0)
+				mBuildNodes[subtree.Node] = node;
+			else
+				mBuildNodes.push_back(node);
+		}
+
+		std::vector<BuildNode>().swap(subtree.Nodes);
+	}
+}
+
+// Turn the binary node into a node with four children by opening the interior child with the largest
+// surface area until there are four, then do the same for the children. Returns the node's index.
+int TriangleBVH::Collapse(int index)
+{
+	int children[4];
+	int numChildren = 2;
+	children[0] = mBuildNodes[index].Left;
+	children[1] = mBuildNodes[index].Right;
+
+	while(numChildren < 4)
+	{
+		int largest = -1;
+		float largestArea = -1.0f;
+		for(int c = 0; c < numChildren; ++c)
+		{
+			const BuildNode& child = mBuildNodes[children[c]];
+			if(child.Left >= 0 && child.Bounds.GetSurfaceArea() > largestArea)
+			{
+				largest = c;
+				largestArea = child.Bounds.GetSurfaceArea();
+			}
+		}
+
+		if(largest < 0)
+			break;
+
+		int opened = children[largest];
+		children[largest] = mBuildNodes[opened].Left;
+		children[numChildren++] = mBuildNodes[opened].Right;
+	}
+
+	int nodeIndex = mNumNodes++;
+	Node& node = mNodes[nodeIndex];
+	node.Padding[0] = node.Padding[1] = node.Padding[2] = node.Padding[3] = 0;
+
+	for(int c = 0; c < 4; ++c)
+	{
+		// Empty slots get an empty box at the origin, the traversal skips them by their child index
+		if(c >= numChildren)
+		{
+			node.MinX[c] = node.MinY[c] = node.MinZ[c] = 0.0f;
+			node.MaxX[c] = node.MaxY[c] = node.MaxZ[c] = 0.0f;
+			node.Child[c] = C_EMPTY_CHILD;
+			continue;
+		}
+
+		const BuildNode& child = mBuildNodes[children[c]];
+		node.MinX[c] = child.Bounds.Min.x;
+		node.MinY[c] = child.Bounds.Min.y;
+		node.MinZ[c] = child.Bounds.Min.z;
+		node.MaxX[c] = child.Bounds.Max.x;
+		node.MaxY[c] = child.Bounds.Max.y;
+		node.MaxZ[c] = child.Bounds.Max.z;
+
+		// mNodes does not move, so the reference stays valid through the recursion
+		node.Child[c] = child.Left < 0 ? ~CreatePack(child.First, child.Count) : Collapse(children[c]);
+	}
+
+	return nodeIndex;
+}
+
+int TriangleBVH::CreatePack(int first, int count)
+{
+	int index = mNumPacks++;
+	TrianglePack& pack = mPacks[index];
+
+	for(int lane = 0; lane < 4; ++lane)
+	{
+		if(lane >= count)
+		{
+			pack.V0X[lane] = pack.V0Y[lane] = pack.V0Z[lane] = 0.0f;
+			pack.E1X[lane] = pack.E1Y[lane] = pack.E1Z[lane] = 0.0f;
+			pack.E2X[lane] = pack.E2Y[lane] = pack.E2Z[lane] = 0.0f;
+			pack.Index[lane] = -1;
+			continue;
+		}
+
+		int triangle = mBuildTriangles[first + lane].Index;
+		const D3DXVECTOR3* v = mVertices + 3 * triangle;
+		D3DXVECTOR3 e1 = v[1] - v[0];
+		D3DXVECTOR3 e2 = v[2] - v[0];
+
+		pack.V0X[lane] = v[0].x;
+		pack.V0Y[lane] = v[0].y;
+		pack.V0Z[lane] = v[0].z;
+		pack.E1X[lane] = e1.x;
+		pack.E1Y[lane] = e1.y;
+		pack.E1Z[lane] = e1.z;
+		pack.E2X[lane] = e2.x;
+		pack.E2Y[lane] = e2.y;
+		pack.E2Z[lane] = e2.z;
+		pack.Index[lane] = triangle;
+	}
+
+	return index;
+}
+
+// Möller-Trumbore against the four triangles of the pack, keeping the closest hit closer than the
+// current one. Unused lanes have zero edges and so a zero determinant, which never hits.
+void TriangleBVH::IntersectPack(const TrianglePack& pack, const D3DXVECTOR3& origin, const D3DXVECTOR3& direction,
+								RayHit& hit) const
+{
+#ifdef TRIANGLE_BVH_SSE
+	__m128 dirX = _mm_set1_ps(direction.x);
+	__m128 dirY = _mm_set1_ps(direction.y);
+	__m128 dirZ = _mm_set1_ps(direction.z);
+
+	__m128 e1X = _mm_load_ps(pack.E1X);
+	__m128 e1Y = _mm_load_ps(pack.E1Y);
+	__m128 e1Z = _mm_load_ps(pack.E1Z);
+	__m128 e2X = _mm_load_ps(pack.E2X);
+	__m128 e2Y = _mm_load_ps(pack.E2Y);
+	__m128 e2Z = _mm_load_ps(pack.E2Z);
+
+	// p = direction x e2, determinant = e1 . p
+	__m128 pX = _mm_sub_ps(_mm_mul_ps(dirY, e2Z), _mm_mul_ps(dirZ, e2Y));
+	__m128 pY = _mm_sub_ps(_mm_mul_ps(dirZ, e2X), _mm_mul_ps(dirX, e2Z));
+	__m128 pZ = _mm_sub_ps(_mm_mul_ps(dirX, e2Y), _mm_mul_ps(dirY, e2X));
+	__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1X, pX), _mm_mul_ps(e1Y, pY)), _mm_mul_ps(e1Z, pZ));
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 absDeterminant = _mm_max_ps(determinant, _mm_sub_ps(zero, determinant));
+	__m128 valid = _mm_cmpgt_ps(absDeterminant, _mm_set1_ps(C_DETERMINANT_EPSILON));
+	if(_mm_movemask_ps(valid) == 0)
+		return;
+
+	__m128 invDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+	// s = origin - v0, u = (s . p) / determinant
+	__m128 sX = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(pack.V0X));
+	__m128 sY = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(pack.V0Y));
+	__m128 sZ = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(pack.V0Z));
+	__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sX, pX), _mm_mul_ps(sY, pY)), _mm_mul_ps(sZ, pZ)),
+						  invDeterminant);
+
+	// q = s x e1, v = (direction . q) / determinant, t = (e2 . q) / determinant
+	__m128 qX = _mm_sub_ps(_mm_mul_ps(sY, e1Z), _mm_mul_ps(sZ, e1Y));
+	__m128 qY = _mm_sub_ps(_mm_mul_ps(sZ, e1X), _mm_mul_ps(sX, e1Z));
+	__m128 qZ = _mm_sub_ps(_mm_mul_ps(sX, e1Y), _mm_mul_ps(sY, e1X));
+	__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, qX), _mm_mul_ps(dirY, qY)), _mm_mul_ps(dirZ, qZ)),
+						  invDeterminant);
+	__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2X, qX), _mm_mul_ps(e2Y, qY)), _mm_mul_ps(e2Z, qZ)),
+						  invDeterminant);
+
+	valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+	valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+	valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+	valid = _mm_and_ps(valid, _mm_cmpge_ps(t, zero));
+	valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(hit.Distance)));
+
+	int mask = _mm_movemask_ps(valid);
+	if(mask == 0)
+		return;
+
+	float distances[4];
+	float us[4];
+	float vs[4];
+	_mm_storeu_ps(distances, t);
+	_mm_storeu_ps(us, u);
+	_mm_storeu_ps(vs, v);
+
+	for(int lane = 0; lane < 4; ++lane)
+	{
+		if((mask & (1 << lane)) && distances[lane] < hit.Distance)
+		{
+			hit.Distance = distances[lane];
+			hit.Triangle = pack.Index[lane];
+			hit.U = us[lane];
+			hit.V = vs[lane];
+		}
+	}
+#else
+	for(int lane = 0; lane < 4; ++lane)
+	{
+		D3DXVECTOR3 e1(pack.E1X[lane], pack.E1Y[lane], pack.E1Z[lane]);
+		D3DXVECTOR3 e2(pack.E2X[lane], pack.E2Y[lane], pack.E2Z[lane]);
+
+		D3DXVECTOR3 p;
+		D3DXVec3Cross(&p, &direction, &e2);
+		float determinant = D3DXVec3Dot(&e1, &p);
+		if(fabs(determinant) <= C_DETERMINANT_EPSILON)
+			continue;
+
+		float invDeterminant = 1.0f / determinant;
+		D3DXVECTOR3 s = origin - D3DXVECTOR3(pack.V0X[lane], pack.V0Y[lane], pack.V0Z[lane]);
+		float u = D3DXVec3Dot(&s, &p) * invDeterminant;
+		if(u < 0.0f || u > 1.0f)
+			continue;
+
+		D3DXVECTOR3 q;
+		D3DXVec3Cross(&q, &s, &e1);
+		float v = D3DXVec3Dot(&direction, &q) * invDeterminant;
+		if(v < 0.0f || u + v > 1.0f)
+			continue;
+
+		float t = D3DXVec3Dot(&e2, &q) * invDeterminant;
+		if(t >= 0.0f && t < hit.Distance)
+		{
+			hit.Distance = t;
+			hit.Triangle = pack.Index[lane];
+			hit.U = u;
+			hit.V = v;
+		}
+	}
+#endif
+}
+
+// Slab test against the four child boxes. Returns a bit per child that is hit within maxDistance and
+// writes where the ray enters each box.
+int TriangleBVH::IntersectChildren(const Node& node, const D3DXVECTOR3& origin, const D3DXVECTOR3& invDirection,
+								   float maxDistance, float* distances) const
+{
+	int mask = 0;
+
+#ifdef TRIANGLE_BVH_SSE
+	__m128 originX = _mm_set1_ps(origin.x);
+	__m128 originY = _mm_set1_ps(origin.y);
+	__m128 originZ = _mm_set1_ps(origin.z);
+	__m128 invX = _mm_set1_ps(invDirection.x);
+	__m128 invY = _mm_set1_ps(invDirection.y);
+	__m128 invZ = _mm_set1_ps(invDirection.z);
+
+	__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinX), originX), invX);
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxX), originX), invX);
+	__m128 tMin = _mm_max_ps(_mm_min_ps(t0, t1), _mm_setzero_ps());
+	__m128 tMax = _mm_min_ps(_mm_max_ps(t0, t1), _mm_set1_ps(maxDistance));
+
+	t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinY), originY), invY);
+	t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxY), originY), invY);
+	tMin = _mm_max_ps(_mm_min_ps(t0, t1), tMin);
+	tMax = _mm_min_ps(_mm_max_ps(t0, t1), tMax);
+
+	t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinZ), originZ), invZ);
+	t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxZ), originZ), invZ);
+	tMin = _mm_max_ps(_mm_min_ps(t0, t1), tMin);
+	tMax = _mm_min_ps(_mm_max_ps(t0, t1), tMax);
+
+	mask = _mm_movemask_ps(_mm_cmple_ps(tMin, tMax));
+	_mm_storeu_ps(distances, tMin);
+#else
+	for(int c = 0; c < 4; ++c)
+	{
+		const float* min[3] = { node.MinX, node.MinY, node.MinZ };
+		const float* max[3] = { node.MaxX, node.MaxY, node.MaxZ };
+
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			float t0 = (min[axis][c] - origin[axis]) * invDirection[axis];
+			float t1 = (max[axis][c] - origin[axis]) * invDirection[axis];
+			if(t0 > t1)
+				std::swap(t0, t1);
+
+			tMin = t0 > tMin ? t0 : tMin;
+			tMax = t1 < tMax ? t1 : tMax;
+		}
+
+		distances[c] = tMin;
+		if(tMin <= tMax)
+			mask |= 1 << c;
+	}
+#endif
+
+	for(int c = 0; c < 4; ++c)
+	{
+		if(node.Child[c] == C_EMPTY_CHILD)
+			mask &= ~(1 << c);
+	}
+
+	return mask;
+}
@@ -0,0 +1,156 @@
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include <vector>
+#include <D3DX10.h>
+
+#include "BoundingVolumes.h"
+#include "JobSystem.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define TRIANGLE_BVH_SSE
+#endif
+
+struct RayHit
+{
+	float				Distance;			// Along the ray, in multiples of the direction's length
+	int					Triangle;
+	float				U;					// Barycentric coordinates of the hit point
+	float				V;
+};
+
+// Bounding volume hierarchy over the triangles of a mesh, for ray casts.
+//
+// The tree is built as a binary tree with the binned surface area heuristic. Ranges above a size are
+// split with the bins filled in parallel, the subtrees below it are built in parallel. The binary
+// tree is then collapsed into a tree with four children per node, where the boxes of the children are
+// stored per axis so that a ray is tested against all four at once with SSE. Leaves hold up to four
+// triangles, stored the same way and also tested at once. Nodes are 128 bytes and start on a cache
+// line, the triangle packs follow each other in the order the tree is laid out.
+class TriangleBVH
+{
+public:
+	TriangleBVH();
+	~TriangleBVH();
+
+	void Build(const D3DXVECTOR3* vertices, int numTriangles, JobSystem* jobSystem);
+	void Clear();
+
+	bool RayCast(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance, RayHit& hit) const;
+	bool IsOccluded(const D3DXVECTOR3& origin, const D3DXVECTOR3& direction, float maxDistance) const;
+
+	int GetTriangleCount() const;
+	int GetNodeCount() const;
+	const AABB& GetBounds() const;
+	double GetBuildMilliseconds() const;
+
+private:
+	enum { BinCount = 16 };
+
+	struct Node
+	{
+		float				MinX[4];
+		float				MinY[4];
+		float				MinZ[4];
+		float				MaxX[4];
+		float				MaxY[4];
+		float				MaxZ[4];
+		int					Child[4];			// Node index, ~pack index for a leaf, or C_EMPTY_CHILD
+		int					Padding[4];
+	};
+
+	// Four triangles as the first vertex and the two edges from it, unused lanes have index -1
+	struct TrianglePack
+	{
+		float				V0X[4];
+		float				V0Y[4];
+		float				V0Z[4];
+		float				E1X[4];
+		float				E1Y[4];
+		float				E1Z[4];
+		float				E2X[4];
+		float				E2Y[4];
+		float				E2Z[4];
+		int					Index[4];
+	};
+
+	struct BuildTriangle
+	{
+		AABB				Bounds;
+		D3DXVECTOR3			Centroid;
+		int					Index;
+	};
+
+	struct BuildNode
+	{
+		AABB				Bounds;
+		int					Left;				// -1 for a leaf
+		int					Right;
+		int					First;
+		int					Count;
+	};
+
+	struct Subtree
+	{
+		int					Node;				// Node in the top of the tree that the subtree replaces
+		int					First;
+		int					Count;
+		std::vector<BuildNode>	Nodes;
+	};
+
+	struct RangeBins
+	{
+		AABB				Bounds;
+		AABB				CentroidBounds;
+		int					Counts[BinCount];
+		AABB				BinBounds[BinCount];
+	};
+
+	struct StackEntry
+	{
+		int					Child;
+		float				Distance;			// Where the ray enters the child's box
+	};
+
+	Node*									mNodes;
+	int										mNumNodes;
+	TrianglePack*							mPacks;
+	int										mNumPacks;
+	int										mNumTriangles;
+	AABB									mBounds;
+	double									mBuildMilliseconds;
+
+	// Everything the build jobs read and write
+	const D3DXVECTOR3*						mVertices;
+	std::vector<BuildTriangle>				mBuildTriangles;
+	std::vector<BuildNode>					mBuildNodes;
+	std::vector<Subtree>					mSubtrees;
+	std::vector<RangeBins>					mChunkBins;
+	int										mRangeFirst;
+	int										mRangeCount;
+	int										mBinAxis;
+	float									mBinMin;
+	float									mBinScale;
+
+	TriangleBVH(const TriangleBVH&);
+	TriangleBVH& operator=(const TriangleBVH&);
+
+	static void PrepareTrianglesJob(void* data, int first, int count);
+	static void RangeBoundsJob(void* data, int first, int count);
+	static void RangeBinsJob(void* data, int first, int count);
+	static void BuildSubtreesJob(void* data, int first, int count);
+
+	void RunJobs(JobSystem* jobSystem, JobFunction function, int count, int grainSize);
+	int BuildTop(int first, int count, int depth, JobSystem* jobSystem);
+	int BuildRange(std::vector<BuildNode>& nodes, int first, int count, int depth);
+	int SplitRange(int first, int count, int axis, const AABB& centroidBounds, const RangeBins* bins);
+	void FillBins(int first, int count, int axis, float binMin, float scale, RangeBins& bins) const;
+	void MergeSubtrees();
+	int Collapse(int index);
+	int CreatePack(int first, int count);
+	void IntersectPack(const TrianglePack& pack, const D3DXVECTOR3& origin, const D3DXVECTOR3& direction,
+					   RayHit& hit) const;
+	int IntersectChildren(const Node& node, const D3DXVECTOR3& origin, const D3DXVECTOR3& invDirection,
+						  float maxDistance, float* distances) const;
+};
+#endif
@@ -0,0 +1,39 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// The benchmarks of the parts of the project that build without Direct3D, each prints a table of
+// its results. The inputs are made from fixed seeds, so every run measures the same work. A quick
+// run uses the smallest sizes only, to check that the benchmarks still work.
+struct BenchOptions
+{
+	bool					Quick;
+	int						MaxWorkers;			// The worker counts go from 1 up to this
+};
+
+typedef void (*BenchFunction)(const BenchOptions& options);
+
+class TriangleBVH;
+
+namespace Bench
+{
+	void Register(const char* name, BenchFunction function);
+	int Run(const char* name, const BenchOptions& options);		// Every benchmark when NULL
+	double GetMilliseconds(long long startTicks);				// Since a tick count of Clock
+	unsigned int Hash(unsigned int value);
+	float HashUnit(unsigned int value);							// In [0, 1)
+	const TriangleBVH* GetObjectBVH();							// Of bth.obj, NULL when it is not found
+}
+
+struct BenchRegistrar
+{
+	BenchRegistrar(const char* name, BenchFunction function)
+	{
+		Bench::Register(name, function);
+	}
+};
+
+#define BENCH(name) \
+	static void name##_Bench(const BenchOptions& options); \
+	static BenchRegistrar name##_Registrar(#name, name##_Bench); \
+	static void name##_Bench(const BenchOptions& options)
+#endif
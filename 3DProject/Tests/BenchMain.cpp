@@ -0,0 +1,127 @@
+#include "Bench.h"
+#include "GameTime.h"
+#include "Threading.h"
+#include "HeadlessRenderDevice.h"
+#include "Object3D.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const int C_MIN_MAX_WORKERS = 4;			// Worker counts are measured up to at least this
+	const char* C_OBJECT_FILENAME = "bth.obj";
+
+	struct BenchEntry
+	{
+		const char*			Name;
+		BenchFunction		Function;
+	};
+
+	std::vector<BenchEntry>& GetBenchmarks()
+	{
+		static std::vector<BenchEntry> benchmarks;
+		return benchmarks;
+	}
+}
+
+void Bench::Register(const char* name, BenchFunction function)
+{
+	BenchEntry entry = { name, function };
+	GetBenchmarks().push_back(entry);
+}
+
+int Bench::Run(const char* name, const BenchOptions& options)
+{
+	const std::vector<BenchEntry>& benchmarks = GetBenchmarks();
+	int numRun = 0;
+
+	for(size_t i = 0; i < benchmarks.size(); ++i)
+	{
+		if(name != NULL && std::strcmp(name, benchmarks[i].Name) != 0)
+			continue;
+
+		std::printf("== %s\n", benchmarks[i].Name);
+		std::fflush(stdout);
+		benchmarks[i].Function(options);
+		std::printf("\n");
+		++numRun;
+	}
+
+	return numRun;
+}
+
+double Bench::GetMilliseconds(long long startTicks)
+{
+	return (Clock::GetTicks() - startTicks) * 1000.0 / Clock::GetTicksPerSecond();
+}
+
+unsigned int Bench::Hash(unsigned int value)
+{
+	value ^= value >> 16;
+	value *= 0x85EBCA6Bu;
+	value ^= value >> 13;
+	value *= 0xC2B2AE35u;
+	value ^= value >> 16;
+	return value;
+}
+
+float Bench::HashUnit(unsigned int value)
+{
+	return (Hash(value) >> 8) * (1.0f / 16777216.0f);
+}
+
+// The object is loaded the way the scene loads it, on a device that draws nothing, the first time a
+// benchmark asks for it. The device is made first so that it is destroyed after the object.
+const TriangleBVH* Bench::GetObjectBVH()
+{
+	static HeadlessRenderDevice device;
+	static Object3D* object = NULL;
+	if(object == NULL)
+	{
+		device.Initialize(NULL);
+		static Object3D loaded(&device, C_OBJECT_FILENAME, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(0.0f, 0.0f, 0.0f));
+		loaded.BuildBVH(NULL);
+		object = &loaded;
+	}
+
+	if(object->GetBVH().GetTriangleCount() == 0)
+	{
+		std::printf("%s was not found, run from the directory it is in\n", C_OBJECT_FILENAME);
+		return NULL;
+	}
+	return &object->GetBVH();
+}
+
+// Bench [--quick] [--workers count] [name]
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	options.Quick = false;
+	options.MaxWorkers = Thread::GetHardwareThreadCount();
+	if(options.MaxWorkers < C_MIN_MAX_WORKERS)
+		options.MaxWorkers = C_MIN_MAX_WORKERS;
+
+	const char* name = NULL;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(std::strcmp(argv[i], "--quick") == 0)
+			options.Quick = true;
+		else if(std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+			options.MaxWorkers = std::atoi(argv[++i]);
+		else
+			name = argv[i];
+	}
+
+	if(options.Quick)
+		options.MaxWorkers = 2;
+
+	if(Bench::Run(name, options) == 0)
+	{
+		std::printf("No benchmark called %s\n", name);
+		return 1;
+	}
+
+	return 0;
+}
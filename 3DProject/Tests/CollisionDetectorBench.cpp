@@ -0,0 +1,89 @@
+#include "Bench.h"
+#include "CollisionDetector.h"
+#include "JobSystem.h"
+#include "GameTime.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const int C_RUNS = 5;							// The best of these is reported
+	const int C_OBJECTS[] = { 20000, 100000 };
+	const int C_NUM_SIZES = 2;
+	const int C_QUICK_OBJECTS = 5000;
+	const float C_VOLUME_PER_OBJECT = 2.0f;		// About two contacts per object
+	const float C_MIN_RADIUS = 0.4f;
+	const float C_MAX_RADIUS = 0.6f;
+	const int C_LARGE_OBJECT_INTERVAL = 10000;	// One in this many is too large for the grid
+	const float C_LARGE_RADIUS = 3.0f;
+
+	struct Spheres
+	{
+		std::vector<float>		X, Y, Z, Radius;
+	};
+
+	// Spheres spread evenly through a cube, the same for every run
+	void MakeSpheres(int count, Spheres& spheres)
+	{
+		float size = std::pow(count * C_VOLUME_PER_OBJECT, 1.0f / 3.0f);
+		for(int i = 0; i < count; ++i)
+		{
+			spheres.X.push_back(Bench::HashUnit(i * 4) * size);
+			spheres.Y.push_back(Bench::HashUnit(i * 4 + 1) * size);
+			spheres.Z.push_back(Bench::HashUnit(i * 4 + 2) * size);
+			spheres.Radius.push_back(i % C_LARGE_OBJECT_INTERVAL == 0 ? C_LARGE_RADIUS :
+				C_MIN_RADIUS + Bench::HashUnit(i * 4 + 3) * (C_MAX_RADIUS - C_MIN_RADIUS));
+		}
+	}
+}
+
+// Contact pairs found per second by the broad and narrow phase for every worker count. The contact
+// list must not depend on the worker count, every row shows whether its checksum is the one worker's.
+BENCH(CollisionDetector)
+{
+	int numSizes = options.Quick ? 1 : C_NUM_SIZES;
+
+	std::printf("%8s %8s %10s %10s %10s %14s %12s %10s %10s %6s\n", "objects", "workers", "total ms", "broad ms",
+				"narrow ms", "candidates/ms", "pairs/ms", "pairs", "speedup", "same");
+
+	for(int size = 0; size < numSizes; ++size)
+	{
+		int count = options.Quick ? C_QUICK_OBJECTS : C_OBJECTS[size];
+		Spheres spheres;
+		MakeSpheres(count, spheres);
+
+		CollisionDetector detector;
+		double singleWorker = 0.0;
+		unsigned int singleWorkerChecksum = 0;
+
+		for(int workers = 1; workers <= options.MaxWorkers; ++workers)
+		{
+			JobSystem system(workers);
+
+			CollisionStatistics best;
+			ZeroMemory(&best, sizeof(best));
+			best.BroadPhaseMilliseconds = 1e30;
+			for(int run = 0; run < C_RUNS; ++run)
+			{
+				detector.Detect(&spheres.X[0], &spheres.Y[0], &spheres.Z[0], &spheres.Radius[0], count, &system);
+				const CollisionStatistics& statistics = detector.GetStatistics();
+				if(statistics.BroadPhaseMilliseconds + statistics.NarrowPhaseMilliseconds <
+				   best.BroadPhaseMilliseconds + best.NarrowPhaseMilliseconds)
+					best = statistics;
+			}
+
+			double total = best.BroadPhaseMilliseconds + best.NarrowPhaseMilliseconds;
+			if(workers == 1)
+			{
+				singleWorker = total;
+				singleWorkerChecksum = best.Checksum;
+			}
+
+			std::printf("%8d %8d %10.2f %10.2f %10.2f %14.0f %12.0f %10d %9.2fx %6s\n", count, workers, total,
+						best.BroadPhaseMilliseconds, best.NarrowPhaseMilliseconds, best.CandidatePairs / total,
+						best.Pairs / total, best.Pairs, singleWorker / total,
+						best.Checksum == singleWorkerChecksum ? "yes" : "NO");
+		}
+	}
+}
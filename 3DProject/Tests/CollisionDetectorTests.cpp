@@ -0,0 +1,301 @@
+#include "Test.h"
+#include "CollisionDetector.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	const int C_WORKERS = 3;
+	const int C_OBJECTS = 20000;					// Several chunks
+	const float C_MIN_RADIUS = 0.4f;
+	const float C_MAX_RADIUS = 0.5f;				// Cells are one unit, so 1024 cells are 1024 units
+	const float C_WIDE_WORLD = 1300.0f;				// Half the width along x, more than 1024 cells either way
+	const float C_SLAB_SIZE = 3.0f;					// Half the height and depth
+	const int C_LARGE_OBJECTS = 6;
+	const float C_LARGE_RADIUS = 6.0f;
+	const float C_TOLERANCE = 1e-4f;
+
+	float Random(unsigned int& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	float RandomRange(unsigned int& state, float min, float max)
+	{
+		return min + Random(state) * (max - min);
+	}
+
+	struct Spheres
+	{
+		std::vector<float>		X, Y, Z, Radius;
+
+		void Add(float x, float y, float z, float radius)
+		{
+			X.push_back(x);
+			Y.push_back(y);
+			Z.push_back(z);
+			Radius.push_back(radius);
+		}
+
+		int GetCount() const
+		{
+			return (int)X.size();
+		}
+	};
+
+	// A thin slab wider than 1024 cells around the origin, so cells have negative coordinates and rows
+	// wrap around. Pairs of spheres are placed across every cell edge where a row wraps or goes negative.
+	void MakeWideWorld(Spheres& spheres, unsigned int seed)
+	{
+		unsigned int state = seed;
+		for(int i = 0; i < C_OBJECTS; ++i)
+		{
+			spheres.Add(RandomRange(state, -C_WIDE_WORLD, C_WIDE_WORLD), RandomRange(state, -C_SLAB_SIZE, C_SLAB_SIZE),
+						RandomRange(state, -C_SLAB_SIZE, C_SLAB_SIZE), RandomRange(state, C_MIN_RADIUS, C_MAX_RADIUS));
+		}
+
+		const float edges[] = { -1025.0f, -1024.0f, -1.0f, 0.0f, 1023.0f, 1024.0f, 1025.0f };
+		for(int e = 0; e < (int)(sizeof(edges) / sizeof(edges[0])); ++e)
+		{
+			for(int i = 0; i < 4; ++i)
+			{
+				float y = RandomRange(state, -C_SLAB_SIZE, C_SLAB_SIZE);
+				float z = RandomRange(state, -C_SLAB_SIZE, C_SLAB_SIZE);
+				spheres.Add(edges[e] - 0.3f, y, z, C_MAX_RADIUS);
+				spheres.Add(edges[e] + 0.3f, y + (i - 1.5f) * 0.3f, z + 0.2f, C_MAX_RADIUS);
+			}
+		}
+	}
+
+	bool PairLess(const ContactPair& a, const ContactPair& b)
+	{
+		return a.A != b.A ? a.A < b.A : a.B < b.B;
+	}
+
+	bool StaticLess(const StaticContact& a, const StaticContact& b)
+	{
+		return a.Object != b.Object ? a.Object < b.Object : a.Box < b.Box;
+	}
+
+	bool IsClose(const D3DXVECTOR3& a, const D3DXVECTOR3& b)
+	{
+		D3DXVECTOR3 delta = a - b;
+		return D3DXVec3Length(&delta) < C_TOLERANCE;
+	}
+
+	// Every pair of spheres tested against each other, in (A, B) order
+	std::vector<ContactPair> FindAllPairs(const Spheres& spheres)
+	{
+		std::vector<ContactPair> pairs;
+		for(int a = 0; a < spheres.GetCount(); ++a)
+		{
+			for(int b = a + 1; b < spheres.GetCount(); ++b)
+			{
+				D3DXVECTOR3 delta(spheres.X[b] - spheres.X[a], spheres.Y[b] - spheres.Y[a], spheres.Z[b] - spheres.Z[a]);
+				float radiusSum = spheres.Radius[a] + spheres.Radius[b];
+				float distanceSq = D3DXVec3LengthSq(&delta);
+				if(distanceSq >= radiusSum * radiusSum)
+					continue;
+
+				float distance = sqrtf(distanceSq);
+				ContactPair pair;
+				pair.A = a;
+				pair.B = b;
+				pair.Normal = delta / distance;
+				pair.Depth = radiusSum - distance;
+				pairs.push_back(pair);
+			}
+		}
+		return pairs;
+	}
+
+	// Every sphere tested against every box. A center inside a box leaves through the nearest face.
+	std::vector<StaticContact> FindAllStaticContacts(const Spheres& spheres, const std::vector<AABB>& boxes)
+	{
+		std::vector<StaticContact> contacts;
+		for(int i = 0; i < spheres.GetCount(); ++i)
+		{
+			D3DXVECTOR3 center(spheres.X[i], spheres.Y[i], spheres.Z[i]);
+			for(int b = 0; b < (int)boxes.size(); ++b)
+			{
+				StaticContact contact;
+				contact.Object = i;
+				contact.Box = b;
+				contact.Depth = -1.0f;
+
+				const AABB& box = boxes[b];
+				if(center.x >= box.Min.x && center.x <= box.Max.x && center.y >= box.Min.y && center.y <= box.Max.y &&
+				   center.z >= box.Min.z && center.z <= box.Max.z)
+				{
+					for(int axis = 0; axis < 3; ++axis)
+					{
+						float toMin = center[axis] - box.Min[axis];
+						float toMax = box.Max[axis] - center[axis];
+						float depth = std::min(toMin, toMax) + spheres.Radius[i];
+						if(contact.Depth < 0.0f || depth < contact.Depth)
+						{
+							contact.Depth = depth;
+							contact.Normal = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+							contact.Normal[axis] = toMin < toMax ? -1.0f : 1.0f;
+						}
+					}
+				}
+				else
+				{
+					D3DXVECTOR3 closest;
+					for(int axis = 0; axis < 3; ++axis)
+						closest[axis] = std::min(std::max(center[axis], box.Min[axis]), box.Max[axis]);
+
+					D3DXVECTOR3 delta = center - closest;
+					float distance = D3DXVec3Length(&delta);
+					if(distance >= spheres.Radius[i])
+						continue;
+
+					contact.Normal = delta / distance;
+					contact.Depth = spheres.Radius[i] - distance;
+				}
+
+				contacts.push_back(contact);
+			}
+		}
+		return contacts;
+	}
+
+	// Returns the number of contacts that are missing, extra or different
+	int CompareContacts(std::vector<ContactPair> found, const std::vector<ContactPair>& expected)
+	{
+		std::sort(found.begin(), found.end(), PairLess);
+		int numErrors = std::abs((int)found.size() - (int)expected.size());
+		for(size_t i = 0; i < std::min(found.size(), expected.size()); ++i)
+		{
+			bool same = found[i].A == expected[i].A && found[i].B == expected[i].B &&
+						IsClose(found[i].Normal, expected[i].Normal) &&
+						std::fabs(found[i].Depth - expected[i].Depth) < C_TOLERANCE;
+			numErrors += same ? 0 : 1;
+		}
+		return numErrors;
+	}
+
+	int CompareStaticContacts(std::vector<StaticContact> found, const std::vector<StaticContact>& expected)
+	{
+		std::sort(found.begin(), found.end(), StaticLess);
+		int numErrors = std::abs((int)found.size() - (int)expected.size());
+		for(size_t i = 0; i < std::min(found.size(), expected.size()); ++i)
+		{
+			bool same = found[i].Object == expected[i].Object && found[i].Box == expected[i].Box &&
+						IsClose(found[i].Normal, expected[i].Normal) &&
+						std::fabs(found[i].Depth - expected[i].Depth) < C_TOLERANCE;
+			numErrors += same ? 0 : 1;
+		}
+		return numErrors;
+	}
+
+	void Detect(CollisionDetector& detector, const Spheres& spheres, JobSystem* jobSystem)
+	{
+		detector.Detect(&spheres.X[0], &spheres.Y[0], &spheres.Z[0], &spheres.Radius[0], spheres.GetCount(),
+						jobSystem);
+	}
+}
+
+// A world wider than 1024 cells on both sides of the origin, so the keys wrap around and neighbours
+// across a wrapped or negative row are looked up in the table
+TEST(CollisionDetector, WideWorldMatchesEveryPair)
+{
+	Spheres spheres;
+	MakeWideWorld(spheres, 1u);
+	std::vector<ContactPair> expected = FindAllPairs(spheres);
+	REQUIRE(expected.size() > 1000);
+
+	CollisionDetector detector;
+	Detect(detector, spheres, NULL);
+	CHECK_EQUAL(0, detector.GetStatistics().LargeObjects);
+	CHECK_EQUAL((int)expected.size(), detector.GetStatistics().Pairs);
+	CHECK_EQUAL(0, CompareContacts(detector.GetContacts(), expected));
+
+	JobSystem system(C_WORKERS);
+	unsigned int checksum = detector.GetStatistics().Checksum;
+	Detect(detector, spheres, &system);
+	CHECK_EQUAL(checksum, detector.GetStatistics().Checksum);
+	CHECK_EQUAL(0, CompareContacts(detector.GetContacts(), expected));
+}
+
+// Spheres far above the mean radius stay out of the grid and are tested against everything, each other
+// included
+TEST(CollisionDetector, LargeObjectsMatchEveryPair)
+{
+	Spheres spheres;
+	MakeWideWorld(spheres, 2u);
+	for(int i = 0; i < C_LARGE_OBJECTS; ++i)
+		spheres.Add(-1024.0f + i * 4.0f, 0.0f, 0.0f, C_LARGE_RADIUS);
+	spheres.Add(0.0f, 0.0f, 0.0f, C_LARGE_RADIUS);
+
+	std::vector<ContactPair> expected = FindAllPairs(spheres);
+
+	JobSystem system(C_WORKERS);
+	CollisionDetector detector;
+	Detect(detector, spheres, &system);
+	CHECK_EQUAL(C_LARGE_OBJECTS + 1, detector.GetStatistics().LargeObjects);
+	CHECK_EQUAL(0, CompareContacts(detector.GetContacts(), expected));
+
+	// The large spheres touch each other as well as the small ones
+	int numLargePairs = 0;
+	for(size_t i = 0; i < expected.size(); ++i)
+	{
+		if(spheres.Radius[expected[i].A] == C_LARGE_RADIUS && spheres.Radius[expected[i].B] == C_LARGE_RADIUS)
+			++numLargePairs;
+	}
+	CHECK(numLargePairs > 0);
+}
+
+// Spheres against static boxes, with some centers inside a box and some boxes in negative space
+TEST(CollisionDetector, StaticBoxesMatchEveryContact)
+{
+	Spheres spheres;
+	MakeWideWorld(spheres, 3u);
+	spheres.Add(2.0f, 0.5f, 0.25f, C_MAX_RADIUS);			// Inside the first box, nearest the bottom face
+	spheres.Add(-1020.1f, 1.0f, 1.0f, C_MIN_RADIUS);		// Inside the second box, nearest the left face
+
+	CollisionDetector detector;
+	std::vector<AABB> boxes;
+	boxes.push_back(AABB(D3DXVECTOR3(0.0f, 0.0f, -2.0f), D3DXVECTOR3(8.0f, 4.0f, 2.0f)));
+	boxes.push_back(AABB(D3DXVECTOR3(-1020.5f, -2.0f, -2.0f), D3DXVECTOR3(-1000.0f, 2.0f, 2.0f)));
+	boxes.push_back(AABB(D3DXVECTOR3(500.0f, -10.0f, -10.0f), D3DXVECTOR3(501.0f, 10.0f, 10.0f)));
+	for(size_t b = 0; b < boxes.size(); ++b)
+		CHECK_EQUAL((int)b, detector.AddStaticBox(boxes[b]));
+
+	std::vector<StaticContact> expected = FindAllStaticContacts(spheres, boxes);
+	REQUIRE(expected.size() > 100);
+
+	JobSystem system(C_WORKERS);
+	Detect(detector, spheres, &system);
+	CHECK_EQUAL(0, CompareStaticContacts(detector.GetStaticContacts(), expected));
+	CHECK_EQUAL(0, CompareContacts(detector.GetContacts(), FindAllPairs(spheres)));
+
+	// The spheres inside the boxes are pushed out through the nearest face
+	int inside = spheres.GetCount() - 2;
+	const std::vector<StaticContact>& contacts = detector.GetStaticContacts();
+	int numInside = 0;
+	for(size_t i = 0; i < contacts.size(); ++i)
+	{
+		if(contacts[i].Object == inside && contacts[i].Box == 0)
+		{
+			CHECK(IsClose(D3DXVECTOR3(0.0f, -1.0f, 0.0f), contacts[i].Normal));
+			CHECK(std::fabs(contacts[i].Depth - (0.5f + C_MAX_RADIUS)) < C_TOLERANCE);
+			++numInside;
+		}
+		if(contacts[i].Object == inside + 1 && contacts[i].Box == 1)
+		{
+			CHECK(IsClose(D3DXVECTOR3(-1.0f, 0.0f, 0.0f), contacts[i].Normal));
+			CHECK(std::fabs(contacts[i].Depth - (0.4f + C_MIN_RADIUS)) < 1e-3f);
+			++numInside;
+		}
+	}
+	CHECK_EQUAL(2, numInside);
+
+	detector.ClearStaticBoxes();
+	Detect(detector, spheres, NULL);
+	CHECK(detector.GetStaticContacts().empty());
+}
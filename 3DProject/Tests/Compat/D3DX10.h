@@ -0,0 +1,384 @@
+#ifndef COMPAT_D3DX10_H
+#define COMPAT_D3DX10_H
+
+// The part of the D3DX10 math library the portable sources use, with the same types, layouts and
+// results, for building the tests and benchmarks where there is no DirectX SDK. Only on the include
+// path when not building for Windows.
+
+#include <cmath>
+#include "Windows.h"
+
+#define D3DX_PI		3.141592654f
+
+struct D3DXVECTOR2
+{
+	float x, y;
+
+	D3DXVECTOR2() {}
+	D3DXVECTOR2(const float* v) : x(v[0]), y(v[1]) {}
+	D3DXVECTOR2(float fx, float fy) : x(fx), y(fy) {}
+
+	operator float*()				{ return &x; }
+	operator const float*() const	{ return &x; }
+
+	D3DXVECTOR2& operator+=(const D3DXVECTOR2& v)	{ x += v.x; y += v.y; return *this; }
+	D3DXVECTOR2& operator-=(const D3DXVECTOR2& v)	{ x -= v.x; y -= v.y; return *this; }
+	D3DXVECTOR2& operator*=(float f)				{ x *= f; y *= f; return *this; }
+
+	D3DXVECTOR2 operator-() const	{ return D3DXVECTOR2(-x, -y); }
+
+	D3DXVECTOR2 operator+(const D3DXVECTOR2& v) const	{ return D3DXVECTOR2(x + v.x, y + v.y); }
+	D3DXVECTOR2 operator-(const D3DXVECTOR2& v) const	{ return D3DXVECTOR2(x - v.x, y - v.y); }
+	D3DXVECTOR2 operator*(float f) const				{ return D3DXVECTOR2(x * f, y * f); }
+	D3DXVECTOR2 operator/(float f) const				{ float inv = 1.0f / f; return D3DXVECTOR2(x * inv, y * inv); }
+
+	friend D3DXVECTOR2 operator*(float f, const D3DXVECTOR2& v)	{ return D3DXVECTOR2(f * v.x, f * v.y); }
+
+	bool operator==(const D3DXVECTOR2& v) const	{ return x == v.x && y == v.y; }
+	bool operator!=(const D3DXVECTOR2& v) const	{ return x != v.x || y != v.y; }
+};
+
+struct D3DXVECTOR3
+{
+	float x, y, z;
+
+	D3DXVECTOR3() {}
+	D3DXVECTOR3(const float* v) : x(v[0]), y(v[1]), z(v[2]) {}
+	D3DXVECTOR3(float fx, float fy, float fz) : x(fx), y(fy), z(fz) {}
+
+	operator float*()				{ return &x; }
+	operator const float*() const	{ return &x; }
+
+	D3DXVECTOR3& operator+=(const D3DXVECTOR3& v)	{ x += v.x; y += v.y; z += v.z; return *this; }
+	D3DXVECTOR3& operator-=(const D3DXVECTOR3& v)	{ x -= v.x; y -= v.y; z -= v.z; return *this; }
+	D3DXVECTOR3& operator*=(float f)				{ x *= f; y *= f; z *= f; return *this; }
+	D3DXVECTOR3& operator/=(float f)				{ float inv = 1.0f / f; x *= inv; y *= inv; z *= inv; return *this; }
+
+	D3DXVECTOR3 operator+() const	{ return *this; }
+	D3DXVECTOR3 operator-() const	{ return D3DXVECTOR3(-x, -y, -z); }
+
+	D3DXVECTOR3 operator+(const D3DXVECTOR3& v) const	{ return D3DXVECTOR3(x + v.x, y + v.y, z + v.z); }
+	D3DXVECTOR3 operator-(const D3DXVECTOR3& v) const	{ return D3DXVECTOR3(x - v.x, y - v.y, z - v.z); }
+	D3DXVECTOR3 operator*(float f) const				{ return D3DXVECTOR3(x * f, y * f, z * f); }
+	D3DXVECTOR3 operator/(float f) const				{ float inv = 1.0f / f; return D3DXVECTOR3(x * inv, y * inv, z * inv); }
+
+	friend D3DXVECTOR3 operator*(float f, const D3DXVECTOR3& v)	{ return D3DXVECTOR3(f * v.x, f * v.y, f * v.z); }
+
+	bool operator==(const D3DXVECTOR3& v) const	{ return x == v.x && y == v.y && z == v.z; }
+	bool operator!=(const D3DXVECTOR3& v) const	{ return x != v.x || y != v.y || z != v.z; }
+};
+
+struct D3DXVECTOR4
+{
+	float x, y, z, w;
+
+	D3DXVECTOR4() {}
+	D3DXVECTOR4(const float* v) : x(v[0]), y(v[1]), z(v[2]), w(v[3]) {}
+	D3DXVECTOR4(const D3DXVECTOR3& v, float fw) : x(v.x), y(v.y), z(v.z), w(fw) {}
+	D3DXVECTOR4(float fx, float fy, float fz, float fw) : x(fx), y(fy), z(fz), w(fw) {}
+
+	operator float*()				{ return &x; }
+	operator const float*() const	{ return &x; }
+
+	D3DXVECTOR4 operator+(const D3DXVECTOR4& v) const	{ return D3DXVECTOR4(x + v.x, y + v.y, z + v.z, w + v.w); }
+	D3DXVECTOR4 operator-(const D3DXVECTOR4& v) const	{ return D3DXVECTOR4(x - v.x, y - v.y, z - v.z, w - v.w); }
+	D3DXVECTOR4 operator*(float f) const				{ return D3DXVECTOR4(x * f, y * f, z * f, w * f); }
+};
+
+struct D3DXPLANE
+{
+	float a, b, c, d;
+
+	D3DXPLANE() {}
+	D3DXPLANE(float fa, float fb, float fc, float fd) : a(fa), b(fb), c(fc), d(fd) {}
+
+	operator float*()				{ return &a; }
+	operator const float*() const	{ return &a; }
+};
+
+struct D3DXMATRIX
+{
+	union
+	{
+		struct
+		{
+			float _11, _12, _13, _14;
+			float _21, _22, _23, _24;
+			float _31, _32, _33, _34;
+			float _41, _42, _43, _44;
+		};
+		float m[4][4];
+	};
+
+	D3DXMATRIX() {}
+	D3DXMATRIX(float f11, float f12, float f13, float f14,
+			   float f21, float f22, float f23, float f24,
+			   float f31, float f32, float f33, float f34,
+			   float f41, float f42, float f43, float f44)
+	{
+		_11 = f11; _12 = f12; _13 = f13; _14 = f14;
+		_21 = f21; _22 = f22; _23 = f23; _24 = f24;
+		_31 = f31; _32 = f32; _33 = f33; _34 = f34;
+		_41 = f41; _42 = f42; _43 = f43; _44 = f44;
+	}
+
+	operator float*()				{ return &_11; }
+	operator const float*() const	{ return &_11; }
+
+	float& operator()(UINT row, UINT col)		{ return m[row][col]; }
+	float operator()(UINT row, UINT col) const	{ return m[row][col]; }
+
+	D3DXMATRIX operator*(const D3DXMATRIX& other) const
+	{
+		D3DXMATRIX result;
+		for(int row = 0; row < 4; ++row)
+		{
+			for(int col = 0; col < 4; ++col)
+			{
+				result.m[row][col] = m[row][0] * other.m[0][col] + m[row][1] * other.m[1][col] +
+									 m[row][2] * other.m[2][col] + m[row][3] * other.m[3][col];
+			}
+		}
+		return result;
+	}
+
+	D3DXMATRIX& operator*=(const D3DXMATRIX& other)	{ return *this = *this * other; }
+
+	bool operator==(const D3DXMATRIX& other) const	{ return memcmp(m, other.m, sizeof(m)) == 0; }
+	bool operator!=(const D3DXMATRIX& other) const	{ return memcmp(m, other.m, sizeof(m)) != 0; }
+};
+
+inline float D3DXVec3Dot(const D3DXVECTOR3* a, const D3DXVECTOR3* b)
+{
+	return a->x * b->x + a->y * b->y + a->z * b->z;
+}
+
+inline float D3DXVec3LengthSq(const D3DXVECTOR3* v)
+{
+	return D3DXVec3Dot(v, v);
+}
+
+inline float D3DXVec3Length(const D3DXVECTOR3* v)
+{
+	return sqrtf(D3DXVec3Dot(v, v));
+}
+
+inline D3DXVECTOR3* D3DXVec3Cross(D3DXVECTOR3* out, const D3DXVECTOR3* a, const D3DXVECTOR3* b)
+{
+	*out = D3DXVECTOR3(a->y * b->z - a->z * b->y, a->z * b->x - a->x * b->z, a->x * b->y - a->y * b->x);
+	return out;
+}
+
+inline D3DXVECTOR3* D3DXVec3Minimize(D3DXVECTOR3* out, const D3DXVECTOR3* a, const D3DXVECTOR3* b)
+{
+	*out = D3DXVECTOR3(a->x < b->x ? a->x : b->x, a->y < b->y ? a->y : b->y, a->z < b->z ? a->z : b->z);
+	return out;
+}
+
+inline D3DXVECTOR3* D3DXVec3Maximize(D3DXVECTOR3* out, const D3DXVECTOR3* a, const D3DXVECTOR3* b)
+{
+	*out = D3DXVECTOR3(a->x > b->x ? a->x : b->x, a->y > b->y ? a->y : b->y, a->z > b->z ? a->z : b->z);
+	return out;
+}
+
+// Like D3DX a zero vector stays zero
+inline D3DXVECTOR3* D3DXVec3Normalize(D3DXVECTOR3* out, const D3DXVECTOR3* v)
+{
+	float length = D3DXVec3Length(v);
+	*out = length > 0.0f ? *v / length : D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	return out;
+}
+
+inline D3DXVECTOR4* D3DXVec3Transform(D3DXVECTOR4* out, const D3DXVECTOR3* v, const D3DXMATRIX* m)
+{
+	*out = D3DXVECTOR4(v->x * m->_11 + v->y * m->_21 + v->z * m->_31 + m->_41,
+					   v->x * m->_12 + v->y * m->_22 + v->z * m->_32 + m->_42,
+					   v->x * m->_13 + v->y * m->_23 + v->z * m->_33 + m->_43,
+					   v->x * m->_14 + v->y * m->_24 + v->z * m->_34 + m->_44);
+	return out;
+}
+
+// The point with w = 1, divided back by its w
+inline D3DXVECTOR3* D3DXVec3TransformCoord(D3DXVECTOR3* out, const D3DXVECTOR3* v, const D3DXMATRIX* m)
+{
+	D3DXVECTOR4 transformed;
+	D3DXVec3Transform(&transformed, v, m);
+	*out = D3DXVECTOR3(transformed.x, transformed.y, transformed.z) / transformed.w;
+	return out;
+}
+
+// The direction with w = 0, the translation is left out
+inline D3DXVECTOR3* D3DXVec3TransformNormal(D3DXVECTOR3* out, const D3DXVECTOR3* v, const D3DXMATRIX* m)
+{
+	*out = D3DXVECTOR3(v->x * m->_11 + v->y * m->_21 + v->z * m->_31,
+					   v->x * m->_12 + v->y * m->_22 + v->z * m->_32,
+					   v->x * m->_13 + v->y * m->_23 + v->z * m->_33);
+	return out;
+}
+
+inline D3DXVECTOR4* D3DXVec4Transform(D3DXVECTOR4* out, const D3DXVECTOR4* v, const D3DXMATRIX* m)
+{
+	*out = D3DXVECTOR4(v->x * m->_11 + v->y * m->_21 + v->z * m->_31 + v->w * m->_41,
+					   v->x * m->_12 + v->y * m->_22 + v->z * m->_32 + v->w * m->_42,
+					   v->x * m->_13 + v->y * m->_23 + v->z * m->_33 + v->w * m->_43,
+					   v->x * m->_14 + v->y * m->_24 + v->z * m->_34 + v->w * m->_44);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixIdentity(D3DXMATRIX* out)
+{
+	*out = D3DXMATRIX(1.0f, 0.0f, 0.0f, 0.0f,
+					  0.0f, 1.0f, 0.0f, 0.0f,
+					  0.0f, 0.0f, 1.0f, 0.0f,
+					  0.0f, 0.0f, 0.0f, 1.0f);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixTranslation(D3DXMATRIX* out, float x, float y, float z)
+{
+	*out = D3DXMATRIX(1.0f, 0.0f, 0.0f, 0.0f,
+					  0.0f, 1.0f, 0.0f, 0.0f,
+					  0.0f, 0.0f, 1.0f, 0.0f,
+					  x,    y,    z,    1.0f);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixScaling(D3DXMATRIX* out, float x, float y, float z)
+{
+	*out = D3DXMATRIX(x,    0.0f, 0.0f, 0.0f,
+					  0.0f, y,    0.0f, 0.0f,
+					  0.0f, 0.0f, z,    0.0f,
+					  0.0f, 0.0f, 0.0f, 1.0f);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixRotationY(D3DXMATRIX* out, float angle)
+{
+	float c = cosf(angle);
+	float s = sinf(angle);
+	*out = D3DXMATRIX(c,    0.0f, -s,   0.0f,
+					  0.0f, 1.0f, 0.0f, 0.0f,
+					  s,    0.0f, c,    0.0f,
+					  0.0f, 0.0f, 0.0f, 1.0f);
+	return out;
+}
+
+// Clockwise looking down the axis towards the origin, like the other left-handed rotations
+inline D3DXMATRIX* D3DXMatrixRotationAxis(D3DXMATRIX* out, const D3DXVECTOR3* axis, float angle)
+{
+	D3DXVECTOR3 v;
+	D3DXVec3Normalize(&v, axis);
+	float c = cosf(angle);
+	float s = sinf(angle);
+	float t = 1.0f - c;
+	*out = D3DXMATRIX(t * v.x * v.x + c,       t * v.x * v.y + s * v.z, t * v.x * v.z - s * v.y, 0.0f,
+					  t * v.x * v.y - s * v.z, t * v.y * v.y + c,       t * v.y * v.z + s * v.x, 0.0f,
+					  t * v.x * v.z + s * v.y, t * v.y * v.z - s * v.x, t * v.z * v.z + c,       0.0f,
+					  0.0f,                    0.0f,                    0.0f,                    1.0f);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixLookAtLH(D3DXMATRIX* out, const D3DXVECTOR3* eye, const D3DXVECTOR3* at, const D3DXVECTOR3* up)
+{
+	D3DXVECTOR3 zAxis = *at - *eye;
+	D3DXVec3Normalize(&zAxis, &zAxis);
+	D3DXVECTOR3 xAxis;
+	D3DXVec3Cross(&xAxis, up, &zAxis);
+	D3DXVec3Normalize(&xAxis, &xAxis);
+	D3DXVECTOR3 yAxis;
+	D3DXVec3Cross(&yAxis, &zAxis, &xAxis);
+
+	*out = D3DXMATRIX(xAxis.x, yAxis.x, zAxis.x, 0.0f,
+					  xAxis.y, yAxis.y, zAxis.y, 0.0f,
+					  xAxis.z, yAxis.z, zAxis.z, 0.0f,
+					  -D3DXVec3Dot(&xAxis, eye), -D3DXVec3Dot(&yAxis, eye), -D3DXVec3Dot(&zAxis, eye), 1.0f);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixPerspectiveFovLH(D3DXMATRIX* out, float fovY, float aspect, float zNear, float zFar)
+{
+	float yScale = 1.0f / tanf(fovY * 0.5f);
+	float xScale = yScale / aspect;
+	float depth = zFar / (zFar - zNear);
+	*out = D3DXMATRIX(xScale, 0.0f,   0.0f,           0.0f,
+					  0.0f,   yScale, 0.0f,           0.0f,
+					  0.0f,   0.0f,   depth,          1.0f,
+					  0.0f,   0.0f,   -zNear * depth, 0.0f);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixOrthoOffCenterLH(D3DXMATRIX* out, float left, float right, float bottom, float top,
+											  float zNear, float zFar)
+{
+	*out = D3DXMATRIX(2.0f / (right - left),            0.0f,                             0.0f,                    0.0f,
+					  0.0f,                             2.0f / (top - bottom),            0.0f,                    0.0f,
+					  0.0f,                             0.0f,                             1.0f / (zFar - zNear),   0.0f,
+					  (left + right) / (left - right),  (top + bottom) / (bottom - top),  zNear / (zNear - zFar),  1.0f);
+	return out;
+}
+
+inline D3DXMATRIX* D3DXMatrixOrthoLH(D3DXMATRIX* out, float width, float height, float zNear, float zFar)
+{
+	return D3DXMatrixOrthoOffCenterLH(out, -width * 0.5f, width * 0.5f, -height * 0.5f, height * 0.5f, zNear, zFar);
+}
+
+// By the 2x2 minors of the top two and bottom two rows. Like D3DX the output is left alone and NULL
+// returned when the matrix has no inverse.
+inline D3DXMATRIX* D3DXMatrixInverse(D3DXMATRIX* out, float* determinant, const D3DXMATRIX* matrix)
+{
+	const float (*a)[4] = matrix->m;
+	float s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+	float s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+	float s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+	float s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+	float s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+	float s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+	float c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+	float c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+	float c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+	float c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+	float c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+	float c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+	float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	if(determinant != NULL)
+		*determinant = det;
+	if(det == 0.0f)
+		return NULL;
+
+	float inv = 1.0f / det;
+	D3DXMATRIX result;
+	result.m[0][0] = ( a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv;
+	result.m[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * inv;
+	result.m[0][2] = ( a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv;
+	result.m[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * inv;
+	result.m[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * inv;
+	result.m[1][1] = ( a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv;
+	result.m[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * inv;
+	result.m[1][3] = ( a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv;
+	result.m[2][0] = ( a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * inv;
+	result.m[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * inv;
+	result.m[2][2] = ( a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv;
+	result.m[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * inv;
+	result.m[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * inv;
+	result.m[3][1] = ( a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * inv;
+	result.m[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * inv;
+	result.m[3][3] = ( a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv;
+	*out = result;
+	return out;
+}
+
+inline float D3DXPlaneDotCoord(const D3DXPLANE* p, const D3DXVECTOR3* v)
+{
+	return p->a * v->x + p->b * v->y + p->c * v->z + p->d;
+}
+
+inline D3DXPLANE* D3DXPlaneNormalize(D3DXPLANE* out, const D3DXPLANE* p)
+{
+	float length = sqrtf(p->a * p->a + p->b * p->b + p->c * p->c);
+	float scale = length > 0.0f ? 1.0f / length : 0.0f;
+	*out = D3DXPLANE(p->a * scale, p->b * scale, p->c * scale, p->d * scale);
+	return out;
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef COMPAT_WINDOWS_H
+#define COMPAT_WINDOWS_H
+
+// The few Windows definitions the portable sources use, for building the tests and benchmarks where
+// there is no Windows SDK. Only on the include path when not building for Windows.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef int					INT;
+typedef unsigned int		UINT;
+typedef unsigned char		BYTE;
+typedef unsigned long		DWORD;
+typedef int					BOOL;
+typedef float				FLOAT;
+typedef long				LONG;
+typedef short				SHORT;
+typedef long				HRESULT;
+typedef long long			__int64;
+typedef unsigned long long	UINT64;
+typedef void*				HWND;
+
+#ifndef TRUE
+#define TRUE	1
+#define FALSE	0
+#endif
+
+#define S_OK			((HRESULT)0)
+#define E_FAIL			((HRESULT)0x80004005L)
+#define SUCCEEDED(hr)	((HRESULT)(hr) >= 0)
+#define FAILED(hr)		((HRESULT)(hr) < 0)
+
+#define VK_LBUTTON		0x01
+#define VK_RBUTTON		0x02
+#define VK_F1			0x70
+#define VK_F2			0x71
+
+#define ZeroMemory(destination, length)	memset((destination), 0, (length))
+
+struct POINT
+{
+	LONG x;
+	LONG y;
+};
+
+// There is no window or keyboard, the cursor stays in the corner and no key is ever down
+inline BOOL GetCursorPos(POINT* point)
+{
+	point->x = 0;
+	point->y = 0;
+	return TRUE;
+}
+
+inline SHORT GetAsyncKeyState(int)
+{
+	return 0;
+}
+
+// Nothing can be shown, so the message goes to the error output for the test log
+inline int MessageBox(HWND, const char* text, const char* caption, UINT)
+{
+	fprintf(stderr, "%s: %s\n", caption, text);
+	return 0;
+}
+
+// Alignment is a power of two and a multiple of the pointer size everywhere it is used
+inline void* _aligned_malloc(size_t size, size_t alignment)
+{
+	void* memory = NULL;
+	if(posix_memalign(&memory, alignment, size) != 0)
+		return NULL;
+	return memory;
+}
+
+inline void _aligned_free(void* memory)
+{
+	free(memory);
+}
+
+#endif
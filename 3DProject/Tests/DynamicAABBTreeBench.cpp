@@ -0,0 +1,267 @@
+#include "Bench.h"
+#include "DynamicAABBTree.h"
+#include "FrustumPlanes.h"
+#include "GameTime.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const int C_SIZES[] = { 1000, 10000, 100000, 1000000 };
+	const int C_NUM_SIZES = 4;
+	const int C_QUICK_SIZES = 1;
+	const int C_QUERIES = 200;
+	const int C_UPDATES = 10;
+	const float C_VOLUME_PER_OBJECT = 64.0f;		// The world grows with the objects, like a larger level
+	const float C_MIN_RADIUS = 0.5f;
+	const float C_MAX_RADIUS = 1.5f;
+	const float C_MOVE_DISTANCE = 0.1f;
+	const float C_QUERY_SIZE = 10.0f;				// Sphere radius and box half size
+	const float C_RAY_LENGTH = 100.0f;
+	const float C_FRUSTUM_FAR = 50.0f;
+	const float C_FRUSTUM_NEAR = 0.1f;
+
+	enum QueryType
+	{
+		FrustumQuery, SphereQuery, BoxQuery, RayQuery, QueryTypeCount
+	};
+
+	const char* const C_QUERY_NAMES[QueryTypeCount] = { "frustum", "sphere", "box", "ray" };
+
+	// Objects kept as separate center and extent arrays, the layout the brute force culling reads
+	struct Objects
+	{
+		std::vector<AABB>		Bounds;
+		std::vector<float>		CenterX, CenterY, CenterZ;
+		std::vector<float>		ExtentX, ExtentY, ExtentZ;
+
+		void Set(int index, const AABB& bounds)
+		{
+			Bounds[index] = bounds;
+			D3DXVECTOR3 center = bounds.GetCenter();
+			D3DXVECTOR3 extents = bounds.GetExtents();
+			CenterX[index] = center.x;
+			CenterY[index] = center.y;
+			CenterZ[index] = center.z;
+			ExtentX[index] = extents.x;
+			ExtentY[index] = extents.y;
+			ExtentZ[index] = extents.z;
+		}
+
+		void Resize(int count)
+		{
+			Bounds.resize(count);
+			CenterX.resize(count);
+			CenterY.resize(count);
+			CenterZ.resize(count);
+			ExtentX.resize(count);
+			ExtentY.resize(count);
+			ExtentZ.resize(count);
+		}
+	};
+
+	D3DXVECTOR3 RandomPoint(unsigned int seed, float halfSize)
+	{
+		return D3DXVECTOR3((Bench::HashUnit(seed) * 2.0f - 1.0f) * halfSize,
+						   (Bench::HashUnit(seed + 1) * 2.0f - 1.0f) * halfSize,
+						   (Bench::HashUnit(seed + 2) * 2.0f - 1.0f) * halfSize);
+	}
+
+	AABB MakeBox(const D3DXVECTOR3& center, float radius)
+	{
+		D3DXVECTOR3 extents(radius, radius, radius);
+		return AABB(center - extents, center + extents);
+	}
+
+	// A 90 degree view along +z from the origin
+	FrustumPlanes MakeFrustum(const D3DXVECTOR3& origin)
+	{
+		const float s = 0.70710678f;
+		FrustumPlanes frustum;
+		frustum.Planes[FrustumPlanes::Left] = D3DXPLANE(s, 0.0f, s, -s * (origin.x + origin.z));
+		frustum.Planes[FrustumPlanes::Right] = D3DXPLANE(-s, 0.0f, s, s * (origin.x - origin.z));
+		frustum.Planes[FrustumPlanes::Bottom] = D3DXPLANE(0.0f, s, s, -s * (origin.y + origin.z));
+		frustum.Planes[FrustumPlanes::Top] = D3DXPLANE(0.0f, -s, s, s * (origin.y - origin.z));
+		frustum.Planes[FrustumPlanes::Near] = D3DXPLANE(0.0f, 0.0f, 1.0f, -(origin.z + C_FRUSTUM_NEAR));
+		frustum.Planes[FrustumPlanes::Far] = D3DXPLANE(0.0f, 0.0f, -1.0f, origin.z + C_FRUSTUM_FAR);
+		return frustum;
+	}
+
+	bool Overlaps(const AABB& a, const AABB& b)
+	{
+		return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x && a.Min.y <= b.Max.y && a.Max.y >= b.Min.y &&
+			   a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+	}
+
+	bool OverlapsSphere(const AABB& box, const BoundingSphere& sphere)
+	{
+		float distanceSquared = 0.0f;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			float value = sphere.Center[axis];
+			if(value < box.Min[axis])
+				distanceSquared += (box.Min[axis] - value) * (box.Min[axis] - value);
+			else if(value > box.Max[axis])
+				distanceSquared += (value - box.Max[axis]) * (value - box.Max[axis]);
+		}
+		return distanceSquared <= sphere.Radius * sphere.Radius;
+	}
+
+	bool HitsRay(const AABB& box, const D3DXVECTOR3& origin, const D3DXVECTOR3& inverse, float maxDistance)
+	{
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			float t0 = (box.Min[axis] - origin[axis]) * inverse[axis];
+			float t1 = (box.Max[axis] - origin[axis]) * inverse[axis];
+			tMin = std::max(tMin, std::min(t0, t1));
+			tMax = std::min(tMax, std::max(t0, t1));
+		}
+		return tMin <= tMax;
+	}
+
+	// One query of the given type over every object, the way it is done without a tree. Frustums are
+	// tested with the batch culling the scene uses for its movers.
+	int BruteForce(const Objects& objects, QueryType type, const D3DXVECTOR3& point, const D3DXVECTOR3& direction,
+				   std::vector<unsigned char>& visible)
+	{
+		int count = (int)objects.Bounds.size();
+		int numFound = 0;
+
+		switch(type)
+		{
+		case FrustumQuery:
+			numFound = MakeFrustum(point).CullBoxes(&objects.CenterX[0], &objects.CenterY[0], &objects.CenterZ[0],
+				&objects.ExtentX[0], &objects.ExtentY[0], &objects.ExtentZ[0], count, &visible[0]);
+			break;
+		case SphereQuery:
+			{
+				BoundingSphere sphere(point, C_QUERY_SIZE);
+				for(int i = 0; i < count; ++i)
+					numFound += OverlapsSphere(objects.Bounds[i], sphere) ? 1 : 0;
+			}
+			break;
+		case BoxQuery:
+			{
+				AABB box = MakeBox(point, C_QUERY_SIZE);
+				for(int i = 0; i < count; ++i)
+					numFound += Overlaps(objects.Bounds[i], box) ? 1 : 0;
+			}
+			break;
+		case RayQuery:
+			{
+				D3DXVECTOR3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+				for(int i = 0; i < count; ++i)
+					numFound += HitsRay(objects.Bounds[i], point, inverse, C_RAY_LENGTH) ? 1 : 0;
+			}
+			break;
+		default:
+			break;
+		}
+
+		return numFound;
+	}
+
+	int QueryTree(const DynamicAABBTree& tree, QueryType type, const D3DXVECTOR3& point, const D3DXVECTOR3& direction,
+				  std::vector<int>& results)
+	{
+		results.clear();
+		switch(type)
+		{
+		case FrustumQuery:
+			return tree.QueryFrustum(MakeFrustum(point), results);
+		case SphereQuery:
+			return tree.QuerySphere(BoundingSphere(point, C_QUERY_SIZE), results);
+		case BoxQuery:
+			return tree.QueryBox(MakeBox(point, C_QUERY_SIZE), results);
+		case RayQuery:
+			return tree.QueryRay(point, direction, C_RAY_LENGTH, results);
+		default:
+			return 0;
+		}
+	}
+}
+
+// Build, update and query times of the tree, and the queries against brute force, for 1k to 1M
+// objects at the same density. The hits of both must be the same.
+BENCH(DynamicAABBTree)
+{
+	int numSizes = options.Quick ? C_QUICK_SIZES : C_NUM_SIZES;
+
+	std::printf("%10s %10s %10s %8s | %8s %12s %12s %10s %12s\n", "objects", "build ms", "update ms", "height",
+				"query", "tree us", "brute us", "speedup", "hits");
+
+	for(int size = 0; size < numSizes; ++size)
+	{
+		int count = C_SIZES[size];
+		float halfSize = 0.5f * std::pow(count * C_VOLUME_PER_OBJECT, 1.0f / 3.0f);
+
+		Objects objects;
+		objects.Resize(count);
+		std::vector<int> userData(count);
+		for(int i = 0; i < count; ++i)
+		{
+			float radius = C_MIN_RADIUS + Bench::HashUnit(i * 4 + 3) * (C_MAX_RADIUS - C_MIN_RADIUS);
+			objects.Set(i, MakeBox(RandomPoint(i * 4, halfSize), radius));
+			userData[i] = i;
+		}
+
+		DynamicAABBTree tree;
+		std::vector<int> proxies(count);
+		long long start = Clock::GetTicks();
+		tree.CreateProxies(&objects.Bounds[0], &userData[0], count, &proxies[0]);
+		double buildMilliseconds = Bench::GetMilliseconds(start);
+
+		// Everything moves a little every update, like the movers of the scene
+		start = Clock::GetTicks();
+		for(int update = 0; update < C_UPDATES; ++update)
+		{
+			D3DXVECTOR3 offset = RandomPoint(update * 3 + 0x1000, C_MOVE_DISTANCE);
+			for(int i = 0; i < count; ++i)
+			{
+				AABB bounds(objects.Bounds[i].Min + offset, objects.Bounds[i].Max + offset);
+				objects.Set(i, bounds);
+				tree.MoveProxy(proxies[i], bounds);
+			}
+			tree.Refit();
+			tree.Optimize();
+		}
+		double updateMilliseconds = Bench::GetMilliseconds(start) / C_UPDATES;
+
+		std::vector<int> results;
+		std::vector<unsigned char> visible(count);
+		for(int type = 0; type < QueryTypeCount; ++type)
+		{
+			QueryType queryType = (QueryType)type;
+			long long treeHits = 0;
+			long long bruteHits = 0;
+
+			start = Clock::GetTicks();
+			for(int query = 0; query < C_QUERIES; ++query)
+			{
+				D3DXVECTOR3 direction = RandomPoint(query * 7 + 0x2003, 1.0f);
+				treeHits += QueryTree(tree, queryType, RandomPoint(query * 7 + 0x2000, halfSize), direction, results);
+			}
+			double treeMicroseconds = Bench::GetMilliseconds(start) * 1000.0 / C_QUERIES;
+
+			start = Clock::GetTicks();
+			for(int query = 0; query < C_QUERIES; ++query)
+			{
+				D3DXVECTOR3 direction = RandomPoint(query * 7 + 0x2003, 1.0f);
+				bruteHits += BruteForce(objects, queryType, RandomPoint(query * 7 + 0x2000, halfSize), direction, visible);
+			}
+			double bruteMicroseconds = Bench::GetMilliseconds(start) * 1000.0 / C_QUERIES;
+
+			if(type == 0)
+				std::printf("%10d %10.2f %10.2f %8d | ", count, buildMilliseconds, updateMilliseconds, tree.GetHeight());
+			else
+				std::printf("%10s %10s %10s %8s | ", "", "", "", "");
+
+			std::printf("%8s %12.2f %12.2f %9.1fx %12lld%s\n", C_QUERY_NAMES[type], treeMicroseconds, bruteMicroseconds,
+						bruteMicroseconds / treeMicroseconds, treeHits, treeHits == bruteHits ? "" : " MISMATCH");
+		}
+	}
+}
@@ -0,0 +1,174 @@
+#include "Test.h"
+#include "DynamicAABBTree.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	const int C_OBJECTS = 2000;
+	const int C_QUERIES = 50;
+	const float C_WORLD_SIZE = 100.0f;
+	const float C_QUERY_SIZE = 12.0f;
+
+	float Random(unsigned int& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	D3DXVECTOR3 RandomPoint(unsigned int& state, float halfSize)
+	{
+		float x = (Random(state) * 2.0f - 1.0f) * halfSize;
+		float y = (Random(state) * 2.0f - 1.0f) * halfSize;
+		float z = (Random(state) * 2.0f - 1.0f) * halfSize;
+		return D3DXVECTOR3(x, y, z);
+	}
+
+	AABB MakeBox(const D3DXVECTOR3& center, float radius)
+	{
+		D3DXVECTOR3 extents(radius, radius, radius);
+		return AABB(center - extents, center + extents);
+	}
+
+	// The objects of the tree and their boxes, the user data of a proxy is its index
+	struct World
+	{
+		DynamicAABBTree			Tree;
+		std::vector<AABB>		Bounds;
+		std::vector<int>		Proxies;
+		std::vector<bool>		Alive;
+
+		void Add(const AABB& bounds)
+		{
+			Proxies.push_back(Tree.CreateProxy(bounds, (int)Bounds.size()));
+			Bounds.push_back(bounds);
+			Alive.push_back(true);
+		}
+	};
+
+	bool Overlaps(const AABB& a, const AABB& b)
+	{
+		return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x && a.Min.y <= b.Max.y && a.Max.y >= b.Min.y &&
+			   a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+	}
+
+	bool OverlapsSphere(const AABB& box, const BoundingSphere& sphere)
+	{
+		float distanceSquared = 0.0f;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			float value = sphere.Center[axis];
+			float closest = std::max(box.Min[axis], std::min(value, box.Max[axis]));
+			distanceSquared += (closest - value) * (closest - value);
+		}
+		return distanceSquared <= sphere.Radius * sphere.Radius;
+	}
+
+	// A tree query gives the same objects as testing every box, in any order
+	bool SameObjects(std::vector<int> found, const World& world, const std::vector<bool>& expected)
+	{
+		std::sort(found.begin(), found.end());
+		std::vector<int> wanted;
+		for(size_t i = 0; i < expected.size(); ++i)
+		{
+			if(world.Alive[i] && expected[i])
+				wanted.push_back((int)i);
+		}
+		return found == wanted;
+	}
+
+	int CountMismatches(const World& world, unsigned int seed)
+	{
+		int numMismatches = 0;
+		std::vector<bool> expected(world.Bounds.size());
+		std::vector<int> found;
+
+		for(int query = 0; query < C_QUERIES; ++query)
+		{
+			D3DXVECTOR3 center = RandomPoint(seed, C_WORLD_SIZE);
+
+			AABB box = MakeBox(center, C_QUERY_SIZE);
+			for(size_t i = 0; i < expected.size(); ++i)
+				expected[i] = Overlaps(world.Bounds[i], box);
+			found.clear();
+			world.Tree.QueryBox(box, found);
+			numMismatches += SameObjects(found, world, expected) ? 0 : 1;
+
+			BoundingSphere sphere(center, C_QUERY_SIZE);
+			for(size_t i = 0; i < expected.size(); ++i)
+				expected[i] = OverlapsSphere(world.Bounds[i], sphere);
+			found.clear();
+			world.Tree.QuerySphere(sphere, found);
+			numMismatches += SameObjects(found, world, expected) ? 0 : 1;
+
+			// A 90 degree view along +z from the center
+			const float s = 0.70710678f;
+			FrustumPlanes frustum;
+			frustum.Planes[FrustumPlanes::Left] = D3DXPLANE(s, 0.0f, s, -s * (center.x + center.z));
+			frustum.Planes[FrustumPlanes::Right] = D3DXPLANE(-s, 0.0f, s, s * (center.x - center.z));
+			frustum.Planes[FrustumPlanes::Bottom] = D3DXPLANE(0.0f, s, s, -s * (center.y + center.z));
+			frustum.Planes[FrustumPlanes::Top] = D3DXPLANE(0.0f, -s, s, s * (center.y - center.z));
+			frustum.Planes[FrustumPlanes::Near] = D3DXPLANE(0.0f, 0.0f, 1.0f, -(center.z + 0.1f));
+			frustum.Planes[FrustumPlanes::Far] = D3DXPLANE(0.0f, 0.0f, -1.0f, center.z + 40.0f);
+			for(size_t i = 0; i < expected.size(); ++i)
+				expected[i] = frustum.TestBox(world.Bounds[i]);
+			found.clear();
+			world.Tree.QueryFrustum(frustum, found);
+			numMismatches += SameObjects(found, world, expected) ? 0 : 1;
+		}
+
+		return numMismatches;
+	}
+}
+
+TEST(DynamicAABBTree, QueriesMatchBruteForceAfterBuild)
+{
+	unsigned int seed = 1;
+	std::vector<AABB> bounds;
+	std::vector<int> userData;
+	for(int i = 0; i < C_OBJECTS; ++i)
+	{
+		bounds.push_back(MakeBox(RandomPoint(seed, C_WORLD_SIZE), 0.5f + Random(seed) * 2.0f));
+		userData.push_back(i);
+	}
+
+	World world;
+	world.Bounds = bounds;
+	world.Alive.resize(C_OBJECTS, true);
+	world.Proxies.resize(C_OBJECTS);
+	world.Tree.CreateProxies(&bounds[0], &userData[0], C_OBJECTS, &world.Proxies[0]);
+
+	CHECK_EQUAL(C_OBJECTS, world.Tree.GetProxyCount());
+	CHECK_EQUAL(0, CountMismatches(world, 2));
+}
+
+TEST(DynamicAABBTree, QueriesMatchBruteForceAfterInsertsMovesAndRemoves)
+{
+	unsigned int seed = 3;
+	World world;
+	for(int i = 0; i < C_OBJECTS; ++i)
+		world.Add(MakeBox(RandomPoint(seed, C_WORLD_SIZE), 0.5f + Random(seed) * 2.0f));
+	CHECK_EQUAL(0, CountMismatches(world, 4));
+
+	// Move everything, far enough to need several rebuilds
+	for(int update = 0; update < 20; ++update)
+	{
+		for(int i = 0; i < C_OBJECTS; ++i)
+		{
+			D3DXVECTOR3 offset = RandomPoint(seed, 2.0f);
+			world.Bounds[i] = AABB(world.Bounds[i].Min + offset, world.Bounds[i].Max + offset);
+			world.Tree.MoveProxy(world.Proxies[i], world.Bounds[i]);
+		}
+		world.Tree.Refit();
+		world.Tree.Optimize();
+	}
+	CHECK_EQUAL(0, CountMismatches(world, 5));
+
+	for(int i = 0; i < C_OBJECTS; i += 3)
+	{
+		world.Tree.DestroyProxy(world.Proxies[i]);
+		world.Alive[i] = false;
+	}
+	CHECK_EQUAL(C_OBJECTS - (C_OBJECTS + 2) / 3, world.Tree.GetProxyCount());
+	CHECK_EQUAL(0, CountMismatches(world, 6));
+}
@@ -0,0 +1,80 @@
+#include "Bench.h"
+#include "JobSystem.h"
+#include "GameTime.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const int C_RUNS = 5;							// The best of these is reported
+	const int C_ELEMENTS = 1 << 22;
+	const int C_QUICK_ELEMENTS = 1 << 16;
+	const int C_GRAIN_SIZE = 16384;
+	const int C_EMPTY_JOBS = 200000;
+	const int C_QUICK_EMPTY_JOBS = 2000;
+
+	struct KernelData
+	{
+		const float*			Input;
+		float*					Output;
+	};
+
+	// About as much work per element as the moving object update
+	void KernelJob(void* data, int first, int count)
+	{
+		KernelData* kernel = static_cast<KernelData*>(data);
+		for(int i = first; i < first + count; ++i)
+			kernel->Output[i] = std::sqrt(kernel->Input[i] * kernel->Input[i] + 1.0f) * 0.5f;
+	}
+
+	void EmptyJob(void* data, int first, int count)
+	{
+	}
+}
+
+// Elements per second of a ParallelFor over a simple kernel, and the cost of a job that does nothing
+BENCH(JobSystem)
+{
+	int numElements = options.Quick ? C_QUICK_ELEMENTS : C_ELEMENTS;
+	int numEmptyJobs = options.Quick ? C_QUICK_EMPTY_JOBS : C_EMPTY_JOBS;
+
+	std::vector<float> input(numElements);
+	std::vector<float> output(numElements);
+	for(int i = 0; i < numElements; ++i)
+		input[i] = Bench::HashUnit(i);
+
+	KernelData kernel = { &input[0], &output[0] };
+
+	std::printf("%8s %14s %10s %14s %10s\n", "workers", "elements/ms", "speedup", "empty job ns", "steals");
+	double singleWorker = 0.0;
+	for(int workers = 1; workers <= options.MaxWorkers; ++workers)
+	{
+		JobSystem system(workers);
+
+		double best = 1e30;
+		for(int run = 0; run < C_RUNS; ++run)
+		{
+			long long start = Clock::GetTicks();
+			JobCounter counter;
+			system.ParallelFor(KernelJob, &kernel, numElements, C_GRAIN_SIZE, &counter);
+			system.Wait(&counter);
+			double milliseconds = Bench::GetMilliseconds(start);
+			if(milliseconds < best)
+				best = milliseconds;
+		}
+
+		system.ResetStatistics();
+		long long start = Clock::GetTicks();
+		JobCounter counter;
+		system.ParallelFor(EmptyJob, NULL, numEmptyJobs, 1, &counter);
+		system.Wait(&counter);
+		double emptyMilliseconds = Bench::GetMilliseconds(start);
+
+		if(workers == 1)
+			singleWorker = best;
+
+		std::printf("%8d %14.0f %9.2fx %14.1f %10ld\n", workers, numElements / best, singleWorker / best,
+					emptyMilliseconds * 1e6 / numEmptyJobs, system.GetStatistics().Steals);
+	}
+}
@@ -0,0 +1,249 @@
+#include "Test.h"
+#include "JobSystem.h"
+#include "GameTime.h"
+#include <vector>
+
+namespace
+{
+	const int C_MAX_WORKERS = 8;
+	const double C_STEAL_TIMEOUT_SECONDS = 5.0;
+
+	// Counts how often every element was visited
+	struct CoverageData
+	{
+		std::vector<long>		Visits;
+	};
+
+	void CoverJob(void* data, int first, int count)
+	{
+		CoverageData* coverage = static_cast<CoverageData*>(data);
+		for(int i = first; i < first + count; ++i)
+			Atomic::Increment(&coverage->Visits[i]);
+	}
+
+	// The second stage checks that the first had finished every element before it started
+	struct StageData
+	{
+		std::vector<long>		FirstStage;
+		volatile long			IncompleteSeen;
+		volatile long			SecondStageJobs;
+	};
+
+	void FirstStageJob(void* data, int first, int count)
+	{
+		StageData* stages = static_cast<StageData*>(data);
+		for(int i = first; i < first + count; ++i)
+			Atomic::Store(&stages->FirstStage[i], 1);
+	}
+
+	void SecondStageJob(void* data, int first, int count)
+	{
+		StageData* stages = static_cast<StageData*>(data);
+		for(size_t i = 0; i < stages->FirstStage.size(); ++i)
+		{
+			if(Atomic::Load(&stages->FirstStage[i]) == 0)
+				Atomic::Increment(&stages->IncompleteSeen);
+		}
+		Atomic::Increment(&stages->SecondStageJobs);
+	}
+
+	// Every job spawns two halves into the same counter until the ranges are one element long
+	struct SplitData
+	{
+		JobSystem*				System;
+		JobCounter*				Counter;
+		CoverageData			Coverage;
+	};
+
+	void SplitJob(void* data, int first, int count)
+	{
+		SplitData* split = static_cast<SplitData*>(data);
+		if(count == 1)
+		{
+			CoverJob(&split->Coverage, first, 1);
+			return;
+		}
+
+		int half = count / 2;
+		split->System->Run(SplitJob, data, first, half, split->Counter);
+		split->System->Run(SplitJob, data, first + half, count - half, split->Counter);
+	}
+
+	// Every job holds its thread until a second job has started or the timeout passes, so the
+	// jobs queued on the thread that waits can only be run by workers that steal them
+	struct HoldData
+	{
+		volatile long			Started;
+		long long				StartTicks;
+	};
+
+	void HoldJob(void* data, int first, int count)
+	{
+		HoldData* hold = static_cast<HoldData*>(data);
+		Atomic::Increment(&hold->Started);
+
+		long long timeout = (long long)(C_STEAL_TIMEOUT_SECONDS * Clock::GetTicksPerSecond());
+		while(Atomic::Load(&hold->Started) < 2 && Clock::GetTicks() - hold->StartTicks < timeout)
+			Thread::YieldThread();
+	}
+
+	int CountNotVisitedOnce(const CoverageData& coverage)
+	{
+		int numWrong = 0;
+		for(size_t i = 0; i < coverage.Visits.size(); ++i)
+		{
+			if(coverage.Visits[i] != 1)
+				++numWrong;
+		}
+		return numWrong;
+	}
+}
+
+TEST(JobSystem, ParallelForVisitsEveryElementOnce)
+{
+	const int counts[] = { 0, 1, 3, 64, 1000, 65537 };
+	const int grainSizes[] = { 0, 1, 7, 64, 100000 };
+	const int numCounts = sizeof(counts) / sizeof(counts[0]);
+	const int numGrainSizes = sizeof(grainSizes) / sizeof(grainSizes[0]);
+
+	for(int workers = 1; workers <= C_MAX_WORKERS; ++workers)
+	{
+		JobSystem system(workers);
+		CHECK_EQUAL(workers, system.GetWorkerCount());
+
+		for(int c = 0; c < numCounts; ++c)
+		{
+			for(int g = 0; g < numGrainSizes; ++g)
+			{
+				CoverageData coverage;
+				coverage.Visits.assign(counts[c], 0);
+
+				JobCounter counter;
+				system.ParallelFor(CoverJob, &coverage, counts[c], grainSizes[g], &counter);
+				system.Wait(&counter);
+
+				CHECK(counter.IsDone());
+				CHECK_EQUAL(0, CountNotVisitedOnce(coverage));
+			}
+		}
+	}
+}
+
+TEST(JobSystem, StatisticsCountEveryJob)
+{
+	for(int workers = 1; workers <= C_MAX_WORKERS; ++workers)
+	{
+		JobSystem system(workers);
+		system.ResetStatistics();
+
+		CoverageData coverage;
+		coverage.Visits.assign(1000, 0);
+
+		JobCounter counter;
+		system.ParallelFor(CoverJob, &coverage, 1000, 10, &counter);
+		system.Wait(&counter);
+
+		JobStatistics statistics = system.GetStatistics();
+		CHECK_EQUAL(100L, statistics.JobsExecuted);
+		CHECK_EQUAL(workers, statistics.Workers);
+		CHECK(statistics.Steals <= statistics.StealAttempts);
+	}
+}
+
+TEST(JobSystem, DependentJobsWaitForTheirCounter)
+{
+	for(int workers = 1; workers <= C_MAX_WORKERS; ++workers)
+	{
+		JobSystem system(workers);
+
+		StageData stages;
+		stages.FirstStage.assign(4096, 0);
+		stages.IncompleteSeen = 0;
+		stages.SecondStageJobs = 0;
+
+		JobCounter firstDone;
+		JobCounter secondDone;
+		system.ParallelFor(FirstStageJob, &stages, 4096, 16, &firstDone);
+		system.ParallelFor(SecondStageJob, &stages, 32, 1, &secondDone, &firstDone);
+		system.Wait(&secondDone);
+
+		CHECK(firstDone.IsDone());
+		CHECK_EQUAL(32L, stages.SecondStageJobs);
+		CHECK_EQUAL(0L, stages.IncompleteSeen);
+	}
+}
+
+TEST(JobSystem, DependencyThatIsDoneRunsAtOnce)
+{
+	JobSystem system(2);
+
+	JobCounter done;
+	CHECK(done.IsDone());
+
+	CoverageData coverage;
+	coverage.Visits.assign(10, 0);
+
+	JobCounter counter;
+	system.ParallelFor(CoverJob, &coverage, 10, 1, &counter, &done);
+	system.Wait(&counter);
+
+	CHECK_EQUAL(0, CountNotVisitedOnce(coverage));
+}
+
+TEST(JobSystem, JobsSpawnedByJobsAreWaitedFor)
+{
+	for(int workers = 1; workers <= C_MAX_WORKERS; ++workers)
+	{
+		JobSystem system(workers);
+
+		JobCounter counter;
+		SplitData split;
+		split.System = &system;
+		split.Counter = &counter;
+		split.Coverage.Visits.assign(5000, 0);
+
+		system.Run(SplitJob, &split, 0, 5000, &counter);
+		system.Wait(&counter);
+
+		CHECK(counter.IsDone());
+		CHECK_EQUAL(0, CountNotVisitedOnce(split.Coverage));
+	}
+}
+
+TEST(JobSystem, IdleWorkersStealQueuedJobs)
+{
+	for(int workers = 2; workers <= C_MAX_WORKERS; ++workers)
+	{
+		JobSystem system(workers);
+		system.ResetStatistics();
+
+		HoldData hold;
+		hold.Started = 0;
+		hold.StartTicks = Clock::GetTicks();
+
+		JobCounter counter;
+		system.ParallelFor(HoldJob, &hold, workers * 4, 1, &counter);
+		system.Wait(&counter);
+
+		JobStatistics statistics = system.GetStatistics();
+		CHECK_EQUAL((long)workers * 4, statistics.JobsExecuted);
+		CHECK(statistics.Steals > 0);
+		CHECK(Atomic::Load(&hold.Started) >= 2);
+	}
+}
+
+TEST(JobSystem, OneWorkerNeverSteals)
+{
+	JobSystem system(1);
+	system.ResetStatistics();
+
+	CoverageData coverage;
+	coverage.Visits.assign(256, 0);
+
+	JobCounter counter;
+	system.ParallelFor(CoverJob, &coverage, 256, 1, &counter);
+	system.Wait(&counter);
+
+	CHECK_EQUAL(0L, system.GetStatistics().Steals);
+	CHECK_EQUAL(0, CountNotVisitedOnce(coverage));
+}
@@ -0,0 +1,90 @@
+#include "Bench.h"
+#include "LightBaker.h"
+#include "JobSystem.h"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	// The scene's floor lightmap: the floor, the light and the props standing on it
+	const int C_LIGHTMAP_SIZE = 256;
+	const int C_QUICK_LIGHTMAP_SIZE = 64;
+	const int C_PASSES = 8;
+	const int C_QUICK_PASSES = 1;
+	const float C_AO_DISTANCE = 20.0f;
+	const float C_FLOOR_Y = -50.0f;
+	const float C_FLOOR_SIZE = 512.0f;
+	const int C_PROPS = 12;
+	const float C_PROP_AREA = 200.0f;
+
+	LightmapRect MakeFloorRect(int size)
+	{
+		LightmapRect rect;
+		rect.Origin = D3DXVECTOR3(-C_FLOOR_SIZE * 0.5f, C_FLOOR_Y, C_FLOOR_SIZE * 0.5f);
+		rect.AxisU = D3DXVECTOR3(C_FLOOR_SIZE, 0.0f, 0.0f);
+		rect.AxisV = D3DXVECTOR3(0.0f, 0.0f, -C_FLOOR_SIZE);
+		rect.Normal = D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+		rect.Width = size;
+		rect.Height = size;
+		return rect;
+	}
+
+	// Like Scene::CreateStaticProps, the object turned and moved to stand on the floor
+	void AddProps(LightBaker& baker, const TriangleBVH* bvh)
+	{
+		float floorY = C_FLOOR_Y - bvh->GetBounds().Min.y;
+		for(int i = 0; i < C_PROPS; ++i)
+		{
+			unsigned int seed = 1000003u + i * 3;
+			D3DXMATRIX rotation;
+			D3DXMATRIX translation;
+			D3DXMatrixRotationY(&rotation, Bench::HashUnit(seed) * 6.28f);
+			D3DXMatrixTranslation(&translation, (Bench::HashUnit(seed + 1) * 2.0f - 1.0f) * C_PROP_AREA, floorY,
+								  (Bench::HashUnit(seed + 2) * 2.0f - 1.0f) * C_PROP_AREA);
+			D3DXMATRIX world = rotation * translation;
+			baker.AddOccluder(bvh, world);
+		}
+	}
+}
+
+// Rays per second of the floor lightmap bake against the props for every worker count. The texels
+// must not depend on the worker count, every row shows whether they are the one worker's.
+BENCH(LightBaker)
+{
+	const TriangleBVH* bvh = Bench::GetObjectBVH();
+	if(bvh == NULL)
+		return;
+
+	int size = options.Quick ? C_QUICK_LIGHTMAP_SIZE : C_LIGHTMAP_SIZE;
+	int numPasses = options.Quick ? C_QUICK_PASSES : C_PASSES;
+
+	LightBaker baker;
+	baker.SetLight(D3DXVECTOR3(-300.0f, 50.0f, -300.0f));
+	AddProps(baker, bvh);
+
+	std::vector<unsigned char> singleWorkerTexels(size * size * 2);
+	std::vector<unsigned char> texels(size * size * 2);
+
+	std::printf("%8s %8s %8s %12s %10s %10s %10s %6s\n", "texels", "workers", "passes", "rays", "ms", "Mrays/s",
+				"speedup", "same");
+
+	double singleWorker = 0.0;
+	for(int workers = 1; workers <= options.MaxWorkers; ++workers)
+	{
+		JobSystem system(workers);
+		baker.BakeLightmap(MakeFloorRect(size), C_AO_DISTANCE, numPasses, &system);
+		baker.GetLightmapTexels(&texels[0]);
+
+		const BakeStatistics& statistics = baker.GetLightmapStatistics();
+		if(workers == 1)
+		{
+			singleWorker = statistics.Milliseconds;
+			singleWorkerTexels = texels;
+		}
+
+		std::printf("%8d %8d %8d %12lld %10.1f %10.2f %9.2fx %6s\n", size * size, workers, statistics.Passes,
+					(long long)statistics.Rays, statistics.Milliseconds,
+					statistics.Rays / (statistics.Milliseconds * 1000.0), singleWorker / statistics.Milliseconds,
+					texels == singleWorkerTexels ? "yes" : "NO");
+	}
+}
@@ -0,0 +1,139 @@
+#include "Test.h"
+#include "LightBaker.h"
+#include "JobSystem.h"
+#include <vector>
+
+namespace
+{
+	const int C_WORKERS = 3;
+	const int C_PASSES = 4;
+	const int C_WIDTH = 56;						// Not a whole number of tiles
+	const int C_HEIGHT = 40;
+	const float C_AO_DISTANCE = 4.0f;
+
+	// The twelve triangles of a unit cube around the origin
+	void MakeCube(std::vector<D3DXVECTOR3>& vertices)
+	{
+		static const int faces[6][4] =
+		{
+			{ 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }
+		};
+
+		D3DXVECTOR3 corners[8];
+		for(int i = 0; i < 8; ++i)
+			corners[i] = D3DXVECTOR3(i & 4 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 1 ? 0.5f : -0.5f);
+
+		for(int f = 0; f < 6; ++f)
+		{
+			vertices.push_back(corners[faces[f][0]]);
+			vertices.push_back(corners[faces[f][1]]);
+			vertices.push_back(corners[faces[f][2]]);
+			vertices.push_back(corners[faces[f][0]]);
+			vertices.push_back(corners[faces[f][2]]);
+			vertices.push_back(corners[faces[f][3]]);
+		}
+	}
+
+	// A floor of 20 by 20 with a few boxes standing on it, lit from above one side
+	struct LitFloor
+	{
+		std::vector<D3DXVECTOR3>	Vertices;
+		TriangleBVH					Cube;
+		LightmapRect				Rect;
+
+		LitFloor()
+		{
+			MakeCube(Vertices);
+			Cube.Build(&Vertices[0], (int)Vertices.size() / 3, NULL);
+
+			Rect.Origin = D3DXVECTOR3(-10.0f, 0.0f, 10.0f);
+			Rect.AxisU = D3DXVECTOR3(20.0f, 0.0f, 0.0f);
+			Rect.AxisV = D3DXVECTOR3(0.0f, 0.0f, -20.0f);
+			Rect.Normal = D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+			Rect.Width = C_WIDTH;
+			Rect.Height = C_HEIGHT;
+		}
+
+		void AddOccluders(LightBaker& baker) const
+		{
+			for(int i = 0; i < 4; ++i)
+			{
+				D3DXMATRIX scaling;
+				D3DXMATRIX translation;
+				D3DXMatrixScaling(&scaling, 2.0f + i, 3.0f, 2.0f);
+				D3DXMatrixTranslation(&translation, -6.0f + i * 4.0f, 1.5f, (i % 2) * 5.0f - 2.5f);
+				D3DXMATRIX world = scaling * translation;
+				baker.AddOccluder(&Cube, world);
+			}
+			baker.SetLight(D3DXVECTOR3(-15.0f, 12.0f, 5.0f));
+		}
+	};
+}
+
+// Refining pass by pass on several workers and reading the texels in between, as the scene does, ends
+// with the texels of baking every pass at once on one thread
+TEST(LightBaker, ProgressiveRefinementMatchesFullBake)
+{
+	LitFloor floor;
+	std::vector<unsigned char> progressive(C_WIDTH * C_HEIGHT * 2);
+	std::vector<unsigned char> full(C_WIDTH * C_HEIGHT * 2);
+
+	LightBaker refined;
+	floor.AddOccluders(refined);
+	JobSystem system(C_WORKERS);
+	refined.BeginLightmap(floor.Rect, C_AO_DISTANCE, C_PASSES);
+	int numRefines = 0;
+	while(!refined.IsLightmapDone())
+	{
+		refined.RefineLightmap(&system);
+		refined.GetLightmapTexels(&progressive[0]);
+		++numRefines;
+	}
+	CHECK_EQUAL(C_PASSES, numRefines);
+
+	LightBaker baked;
+	floor.AddOccluders(baked);
+	baked.BakeLightmap(floor.Rect, C_AO_DISTANCE, C_PASSES, NULL);
+	baked.GetLightmapTexels(&full[0]);
+
+	CHECK(progressive == full);
+	CHECK_EQUAL(baked.GetLightmapStatistics().Passes, refined.GetLightmapStatistics().Passes);
+	CHECK_EQUAL(baked.GetLightmapStatistics().Rays, refined.GetLightmapStatistics().Rays);
+
+	// The boxes both shadow and occlude some texels and leave others open, so the texels say something
+	int numShadowed = 0;
+	int numLit = 0;
+	int numOccluded = 0;
+	for(int i = 0; i < C_WIDTH * C_HEIGHT; ++i)
+	{
+		numShadowed += full[2 * i] == 0 ? 1 : 0;
+		numLit += full[2 * i] > 0 ? 1 : 0;
+		numOccluded += full[2 * i + 1] < 255 ? 1 : 0;
+	}
+	CHECK(numShadowed > 0);
+	CHECK(numLit > 0);
+	CHECK(numOccluded > 0);
+}
+
+// A refinement that has not finished is the average of the passes traced so far
+TEST(LightBaker, UnfinishedRefinementAveragesItsPasses)
+{
+	LitFloor floor;
+	std::vector<unsigned char> progressive(C_WIDTH * C_HEIGHT * 2);
+	std::vector<unsigned char> full(C_WIDTH * C_HEIGHT * 2);
+
+	LightBaker refined;
+	floor.AddOccluders(refined);
+	refined.BeginLightmap(floor.Rect, C_AO_DISTANCE, C_PASSES);
+	refined.RefineLightmap(NULL);
+	refined.RefineLightmap(NULL);
+	CHECK(!refined.IsLightmapDone());
+	refined.GetLightmapTexels(&progressive[0]);
+
+	LightBaker baked;
+	floor.AddOccluders(baked);
+	baked.BakeLightmap(floor.Rect, C_AO_DISTANCE, 2, NULL);
+	baked.GetLightmapTexels(&full[0]);
+
+	CHECK(progressive == full);
+}
@@ -0,0 +1,98 @@
+#include "Bench.h"
+#include "MovingObjectStore.h"
+#include "JobSystem.h"
+#include "GameTime.h"
+#include <cstdio>
+
+namespace
+{
+	const int C_RUNS = 5;							// The best of these is reported
+	const int C_MOVERS = 1000000;
+	const int C_QUICK_MOVERS = 20000;
+	const int C_STEPS = 10;							// Updates per run
+	const int C_GRAIN_SIZE = 16384;					// As the scene updates its movers
+	const float C_DT = 1.0f / 60.0f;
+	const float C_MOVER_RADIUS = 0.5f;
+
+	struct UpdateData
+	{
+		MovingObjectStore*		Store;
+		float					DeltaTime;
+	};
+
+	void UpdateJob(void* data, int first, int count)
+	{
+		UpdateData* update = static_cast<UpdateData*>(data);
+		update->Store->Update(update->DeltaTime, first, count);
+	}
+
+	// The benchmark movers of the scene, hashed from the index so every run starts from the same state
+	void AddMovers(MovingObjectStore& store, int count)
+	{
+		store.Clear();
+		store.SetBounds(D3DXVECTOR3(-256.0f, 0.0f, -256.0f), D3DXVECTOR3(256.0f, 30.0f, 256.0f));
+		for(int i = 0; i < count; ++i)
+		{
+			unsigned int seed = i * 7;
+			D3DXVECTOR3 position(Bench::HashUnit(seed) * 512.0f - 256.0f, Bench::HashUnit(seed + 1) * 30.0f,
+								 Bench::HashUnit(seed + 2) * 512.0f - 256.0f);
+			D3DXVECTOR3 velocity(Bench::HashUnit(seed + 3) * 60.0f - 30.0f, Bench::HashUnit(seed + 4) * 60.0f - 30.0f,
+								 Bench::HashUnit(seed + 5) * 60.0f - 30.0f);
+			store.Add(position, velocity, Bench::HashUnit(seed + 6) * 6.28f, C_MOVER_RADIUS);
+		}
+	}
+}
+
+// Movers updated per second, scalar and SSE, for every worker count. Every row starts from the same
+// movers and takes the same steps, so the state must end up the same: the checksum is compared to the
+// one worker scalar run.
+BENCH(MovingObjectStore)
+{
+	int count = options.Quick ? C_QUICK_MOVERS : C_MOVERS;
+	MovingObjectStore store;
+
+	std::printf("%8s %8s %8s %10s %12s %10s %6s\n", "movers", "path", "workers", "ms/update", "Mmovers/s", "speedup",
+				"same");
+
+	double singleWorker = 0.0;
+	unsigned int singleWorkerChecksum = 0;
+	for(int path = 0; path < 2; ++path)
+	{
+		store.SetSIMD(path == 1);
+		if(path == 1 && !store.GetSIMD())
+			break;
+
+		for(int workers = 1; workers <= options.MaxWorkers; ++workers)
+		{
+			JobSystem system(workers);
+			UpdateData update = { &store, C_DT };
+
+			double best = 1e30;
+			for(int run = 0; run < C_RUNS; ++run)
+			{
+				AddMovers(store, count);
+
+				long long start = Clock::GetTicks();
+				for(int step = 0; step < C_STEPS; ++step)
+				{
+					JobCounter moversDone;
+					system.ParallelFor(UpdateJob, &update, count, C_GRAIN_SIZE, &moversDone);
+					system.Wait(&moversDone);
+				}
+				double milliseconds = Bench::GetMilliseconds(start) / C_STEPS;
+				if(milliseconds < best)
+					best = milliseconds;
+			}
+
+			unsigned int checksum = store.GetChecksum();
+			if(path == 0 && workers == 1)
+			{
+				singleWorker = best;
+				singleWorkerChecksum = checksum;
+			}
+
+			std::printf("%8d %8s %8d %10.3f %12.1f %9.2fx %6s\n", count, path == 1 ? "SSE" : "scalar", workers, best,
+						count / (best * 1000.0), singleWorker / best, checksum == singleWorkerChecksum ? "yes" : "NO");
+		}
+	}
+}
@@ -0,0 +1,171 @@
+#include "Test.h"
+#include "MovingObjectStore.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const int C_OBJECTS = 1001;						// Not a whole number of SIMD blocks
+	const int C_STEPS = 300;
+	const float C_DT = 1.0f / 60.0f;
+	const float C_MAX_SPEED = 40.0f;				// Crosses the box in about a second, so everything bounces
+	const D3DXVECTOR3 C_BOUNDS_MIN(-10.0f, 0.0f, -20.0f);
+	const D3DXVECTOR3 C_BOUNDS_MAX(10.0f, 5.0f, 20.0f);
+
+	float Random(unsigned int& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	float RandomRange(unsigned int& state, float min, float max)
+	{
+		return min + Random(state) * (max - min);
+	}
+
+	// Objects spread through the box grown by outside on every side
+	void Fill(MovingObjectStore& store, unsigned int seed, float outside)
+	{
+		unsigned int state = seed;
+		D3DXVECTOR3 min = C_BOUNDS_MIN - D3DXVECTOR3(outside, outside, outside);
+		D3DXVECTOR3 max = C_BOUNDS_MAX + D3DXVECTOR3(outside, outside, outside);
+
+		store.SetBounds(C_BOUNDS_MIN, C_BOUNDS_MAX);
+		for(int i = 0; i < C_OBJECTS; ++i)
+		{
+			D3DXVECTOR3 position(RandomRange(state, min.x, max.x), RandomRange(state, min.y, max.y),
+								 RandomRange(state, min.z, max.z));
+			D3DXVECTOR3 velocity(RandomRange(state, -C_MAX_SPEED, C_MAX_SPEED),
+								 RandomRange(state, -C_MAX_SPEED, C_MAX_SPEED),
+								 RandomRange(state, -C_MAX_SPEED, C_MAX_SPEED));
+			store.Add(position, velocity, RandomRange(state, 0.0f, 6.28f), 0.5f);
+		}
+	}
+
+	// Returns the number of objects outside the bounds by more than one step, or outside and not on
+	// their way back in
+	int CountEscaped(MovingObjectStore& store)
+	{
+		int numEscaped = 0;
+		for(int i = 0; i < store.GetCount(); ++i)
+		{
+			D3DXVECTOR3 position = store.GetPosition(i);
+			float velocity[3] = { store.GetVelocitiesX()[i], store.GetVelocitiesY()[i], store.GetVelocitiesZ()[i] };
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				float min = C_BOUNDS_MIN[axis];
+				float max = C_BOUNDS_MAX[axis];
+				float step = std::fabs(velocity[axis]) * C_DT;
+				if(position[axis] < min && (position[axis] < min - step || velocity[axis] < 0.0f))
+					++numEscaped;
+				if(position[axis] > max && (position[axis] > max + step || velocity[axis] > 0.0f))
+					++numEscaped;
+			}
+		}
+		return numEscaped;
+	}
+
+	float GetSpeedSq(MovingObjectStore& store, int index)
+	{
+		D3DXVECTOR3 velocity(store.GetVelocitiesX()[index], store.GetVelocitiesY()[index],
+							 store.GetVelocitiesZ()[index]);
+		return D3DXVec3LengthSq(&velocity);
+	}
+}
+
+// The SSE update gives the bits of the scalar one, also for ranges that do not start or end on a block
+TEST(MovingObjectStore, SIMDMatchesScalar)
+{
+	MovingObjectStore scalar;
+	MovingObjectStore simd;
+	Fill(scalar, 1u, 2.0f);
+	Fill(simd, 1u, 2.0f);
+	scalar.SetSIMD(false);
+	simd.SetSIMD(true);
+	CHECK(!scalar.GetSIMD());
+#ifdef MOVING_OBJECT_STORE_SSE
+	CHECK(simd.GetSIMD());
+#endif
+
+	for(int step = 0; step < C_STEPS; ++step)
+	{
+		scalar.Update(C_DT);
+
+		int split = (step * 7) % C_OBJECTS;
+		simd.Update(C_DT, 0, split);
+		simd.Update(C_DT, split, C_OBJECTS - split);
+	}
+
+	CHECK_EQUAL(scalar.GetChecksum(), simd.GetChecksum());
+	CHECK(std::memcmp(scalar.GetWorldMatrices(), simd.GetWorldMatrices(), sizeof(D3DXMATRIX) * C_OBJECTS) == 0);
+
+	int numDifferent = 0;
+	for(int i = 0; i < C_OBJECTS; ++i)
+	{
+		D3DXMATRIX a = scalar.GetInterpolatedWorldMatrix(i, 0.25f);
+		D3DXMATRIX b = simd.GetInterpolatedWorldMatrix(i, 0.25f);
+		numDifferent += std::memcmp(&a, &b, sizeof(a)) == 0 ? 0 : 1;
+	}
+	CHECK_EQUAL(0, numDifferent);
+}
+
+// Objects never get further out of the box than one step, turn back on the step that takes them out,
+// and keep their speed when they bounce
+TEST(MovingObjectStore, BouncesKeepObjectsInside)
+{
+	for(int path = 0; path < 2; ++path)
+	{
+		MovingObjectStore store;
+		Fill(store, 2u, 0.0f);
+		store.SetSIMD(path == 1);
+
+		std::vector<float> speedsSq(C_OBJECTS);
+		for(int i = 0; i < C_OBJECTS; ++i)
+			speedsSq[i] = GetSpeedSq(store, i);
+
+		int numEscaped = 0;
+		for(int step = 0; step < C_STEPS; ++step)
+		{
+			store.Update(C_DT);
+			numEscaped += CountEscaped(store);
+		}
+		CHECK_EQUAL(0, numEscaped);
+
+		int numSpeedChanged = 0;
+		for(int i = 0; i < C_OBJECTS; ++i)
+			numSpeedChanged += GetSpeedSq(store, i) == speedsSq[i] ? 0 : 1;
+		CHECK_EQUAL(0, numSpeedChanged);
+	}
+}
+
+// A corner object moving out on all three axes turns back on all three in the same update
+TEST(MovingObjectStore, BouncesOnEveryAxisAtOnce)
+{
+	for(int path = 0; path < 2; ++path)
+	{
+		MovingObjectStore store;
+		store.SetBounds(C_BOUNDS_MIN, C_BOUNDS_MAX);
+		store.SetSIMD(path == 1);
+		for(int i = 0; i < 4; ++i)
+		{
+			store.Add(C_BOUNDS_MIN, D3DXVECTOR3(-1.0f, -2.0f, -3.0f), 0.0f, 0.5f);
+			store.Add(C_BOUNDS_MAX, D3DXVECTOR3(1.0f, 2.0f, 3.0f), 0.0f, 0.5f);
+		}
+
+		store.Update(C_DT);
+		for(int i = 0; i < store.GetCount(); i += 2)
+		{
+			CHECK(store.GetVelocitiesX()[i] == 1.0f && store.GetVelocitiesY()[i] == 2.0f &&
+				  store.GetVelocitiesZ()[i] == 3.0f);
+			CHECK(store.GetVelocitiesX()[i + 1] == -1.0f && store.GetVelocitiesY()[i + 1] == -2.0f &&
+				  store.GetVelocitiesZ()[i + 1] == -3.0f);
+		}
+
+		// The next update moves them back towards the box
+		D3DXVECTOR3 outside = store.GetPosition(0);
+		store.Update(C_DT);
+		D3DXVECTOR3 back = store.GetPosition(0);
+		CHECK(back.x > outside.x && back.y > outside.y && back.z > outside.z);
+	}
+}
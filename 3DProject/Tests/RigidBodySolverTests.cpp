@@ -0,0 +1,116 @@
+#include "Test.h"
+#include "RigidBodySolver.h"
+#include "CollisionDetector.h"
+#include "JobSystem.h"
+#include <vector>
+
+namespace
+{
+	const int C_MAX_WORKERS = 8;
+	const int C_ROW_SIZE = 12;
+	const int C_LAYERS = 4;
+	const int C_STEPS = 240;
+	const float C_SPACING = 1.05f;
+	const float C_STEP_TIME = 1.0f / 60.0f;
+
+	// Columns of spheres dropped on a floor box, like Scene::StartPhysics but smaller. Every third
+	// body is larger so that the mass cap is hit as well.
+	struct Stack
+	{
+		std::vector<float>		X, Y, Z;
+		std::vector<float>		VelX, VelY, VelZ;
+		std::vector<float>		Radius;
+
+		Stack()
+		{
+			float offset = (C_ROW_SIZE - 1) * C_SPACING * 0.5f;
+			for(int i = 0; i < C_ROW_SIZE * C_ROW_SIZE * C_LAYERS; ++i)
+			{
+				int x = i % C_ROW_SIZE;
+				int z = (i / C_ROW_SIZE) % C_ROW_SIZE;
+				int y = i / (C_ROW_SIZE * C_ROW_SIZE);
+
+				unsigned int hash = (x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u);
+				X.push_back(x * C_SPACING - offset + ((hash & 255) / 255.0f - 0.5f) * 0.1f);
+				Y.push_back(0.6f + y * C_SPACING * 1.5f);
+				Z.push_back(z * C_SPACING - offset + (((hash >> 8) & 255) / 255.0f - 0.5f) * 0.1f);
+				Radius.push_back(i % 3 == 0 ? 0.7f : 0.5f);
+			}
+
+			VelX.resize(X.size(), 0.0f);
+			VelY.resize(X.size(), 0.0f);
+			VelZ.resize(X.size(), 0.0f);
+		}
+
+		int GetCount() const
+		{
+			return (int)X.size();
+		}
+	};
+
+	// Steps the stack and returns the solver's checksum of every step
+	std::vector<unsigned int> Simulate(Stack& stack, JobSystem* jobSystem)
+	{
+		CollisionDetector detector;
+		detector.AddStaticBox(AABB(D3DXVECTOR3(-50.0f, -1.0f, -50.0f), D3DXVECTOR3(50.0f, 0.0f, 50.0f)));
+		RigidBodySolver solver;
+		std::vector<unsigned int> checksums;
+
+		for(int step = 0; step < C_STEPS; ++step)
+		{
+			int count = stack.GetCount();
+			detector.Detect(&stack.X[0], &stack.Y[0], &stack.Z[0], &stack.Radius[0], count, jobSystem);
+			solver.Step(&stack.VelX[0], &stack.VelY[0], &stack.VelZ[0], &stack.Radius[0], count,
+						detector, C_STEP_TIME, jobSystem);
+			checksums.push_back(solver.GetStatistics().Checksum);
+
+			for(int i = 0; i < count; ++i)
+			{
+				stack.X[i] += stack.VelX[i] * C_STEP_TIME;
+				stack.Y[i] += stack.VelY[i] * C_STEP_TIME;
+				stack.Z[i] += stack.VelZ[i] * C_STEP_TIME;
+			}
+		}
+
+		return checksums;
+	}
+}
+
+TEST(RigidBodySolver, SameStepsWithAnyWorkerCount)
+{
+	Stack reference;
+	JobSystem oneWorker(1);
+	std::vector<unsigned int> expected = Simulate(reference, &oneWorker);
+
+	for(int workers = 2; workers <= C_MAX_WORKERS; workers *= 2)
+	{
+		Stack stack;
+		JobSystem system(workers);
+		std::vector<unsigned int> checksums = Simulate(stack, &system);
+
+		REQUIRE(checksums.size() == expected.size());
+		int firstDifference = -1;
+		for(size_t step = 0; step < checksums.size() && firstDifference < 0; ++step)
+		{
+			if(checksums[step] != expected[step])
+				firstDifference = (int)step;
+		}
+		CHECK_EQUAL(-1, firstDifference);
+		CHECK(stack.Y == reference.Y);
+	}
+}
+
+TEST(RigidBodySolver, StackComesToRestOnTheFloor)
+{
+	Stack stack;
+	JobSystem system(2);
+	Simulate(stack, &system);
+
+	int belowFloor = 0;
+	for(int i = 0; i < stack.GetCount(); ++i)
+	{
+		if(stack.Y[i] < stack.Radius[i] * 0.5f)
+			++belowFloor;
+	}
+	CHECK_EQUAL(0, belowFloor);
+}
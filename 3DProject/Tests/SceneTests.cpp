@@ -0,0 +1,198 @@
+#include "Test.h"
+#include "Scene.h"
+#include "HeadlessRenderDevice.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const int C_SCREEN_WIDTH = 800;
+	const int C_SCREEN_HEIGHT = 600;
+	const int C_WARMUP_FRAMES = 3;					// Until every cache and pool has what it needs
+	const int C_FRAMES = 4;
+
+	Frustrum MakeFrustrum()
+	{
+		Frustrum frustrum;
+		frustrum.aspectRatio = (float)C_SCREEN_WIDTH / C_SCREEN_HEIGHT;
+		frustrum.farDistance = 1000.0f;
+		frustrum.nearDistance = 1.0f;
+		frustrum.fovY = (float)D3DX_PI * 0.3f;
+		return frustrum;
+	}
+
+	// The scene on a headless device with nothing behind it, drawn the way Game draws it without the text
+	struct HeadlessGame
+	{
+		HeadlessRenderDevice	Device;
+		Scene*					World;
+		FrameGraph				Graph;
+		Camera					View;
+		GameTime				Time;
+
+		HeadlessGame()
+			: World(NULL), View(D3DXVECTOR3(-100.0f, 50.0f, -100.0f), D3DXVECTOR3(3.0f, -1.0f, 3.0f),
+								D3DXVECTOR3(0.0f, 1.0f, 0.0f), MakeFrustrum())
+		{
+			Device.Initialize(NULL);
+			World = new Scene(&Device, C_SCREEN_WIDTH);
+			Graph.Initialize(&Device, &World->GetRenderTargetPool());
+		}
+
+		~HeadlessGame()
+		{
+			delete World;
+		}
+
+		// The statistics of a frame are there once the next one has begun
+		void RunFrame()
+		{
+			Device.BeginFrame();
+
+			Time.Update();
+			View.Update(Time);
+			World->Update(Time);
+			World->Cull(View);
+
+			Graph.Reset();
+			int backBuffer = Graph.ImportTexture("Back buffer", ImportedViews(Device.GetBackBuffer(), NULL,
+																			  C_SCREEN_WIDTH, C_SCREEN_HEIGHT));
+			int depthStencil = Graph.ImportTexture("Depth stencil", ImportedViews(NULL, Device.GetBackBufferDepth(),
+																				  C_SCREEN_WIDTH, C_SCREEN_HEIGHT));
+			Graph.SetOutput(backBuffer);
+			World->AddPasses(Graph, View, backBuffer, depthStencil);
+			Graph.Compile();
+			Graph.Execute();
+			World->EndFrame();
+
+			Device.BeginFrame();
+		}
+
+		void RunFrames(int count)
+		{
+			for(int i = 0; i < count; ++i)
+				RunFrame();
+		}
+
+	private:
+		HeadlessGame(const HeadlessGame&);
+		HeadlessGame& operator=(const HeadlessGame&);
+	};
+
+	// The device's own messages say what was wrong, the check alone only says that something was
+	int CountErrors(const HeadlessRenderDevice& device)
+	{
+		const std::vector<std::string>& errors = device.GetErrors();
+		for(size_t i = 0; i < errors.size(); ++i)
+			std::printf("    %s\n", errors[i].c_str());
+		return (int)errors.size();
+	}
+}
+
+TEST(Scene, DrawsFramesWithoutErrors)
+{
+	HeadlessGame game;
+	game.RunFrames(C_WARMUP_FRAMES);
+	CHECK_EQUAL(0, CountErrors(game.Device));
+
+	RenderDeviceStatistics first = game.Device.GetStatistics();
+	CHECK(first.Draws > 0);
+	CHECK(first.Triangles > 0);
+	CHECK(first.Buffers > 0);
+	CHECK(first.Textures > 0);
+	CHECK(!game.World->GetInfoString().empty());
+
+	// Nothing is made or released per frame once the scene has settled
+	game.RunFrames(C_FRAMES);
+	const RenderDeviceStatistics& last = game.Device.GetStatistics();
+	CHECK_EQUAL(0, last.Errors);
+	CHECK_EQUAL(first.Buffers, last.Buffers);
+	CHECK_EQUAL(first.BufferBytes, last.BufferBytes);
+	CHECK_EQUAL(first.Textures, last.Textures);
+	CHECK_EQUAL(first.TextureBytes, last.TextureBytes);
+}
+
+TEST(Scene, DrawsEverySettingWithoutErrors)
+{
+	HeadlessGame game;
+	game.RunFrames(C_WARMUP_FRAMES);
+
+	for(int filter = 0; filter < ShadowFilterCount; ++filter)
+	{
+		game.World->SetShadowFilter((ShadowFilter)filter);
+		game.RunFrame();
+	}
+
+	game.World->SetScreenShadows(Scene::ScreenShadowsHalf);
+	game.RunFrames(C_FRAMES);
+	game.World->SetScreenShadows(Scene::ScreenShadowsOff);
+	game.RunFrames(C_FRAMES);
+
+	game.World->SetPointShadows(Scene::PointShadowsSinglePass);
+	game.RunFrames(C_FRAMES);
+	game.World->SetPointShadows(Scene::PointShadowsSixPasses);
+	game.RunFrames(C_FRAMES);
+	game.World->SetPointShadows(Scene::PointShadowsOff);
+
+	game.World->SetCascadeCount(1);
+	game.World->ChangeDepthMap(0);
+	game.RunFrames(C_FRAMES);
+	game.World->SetCpuShadows(true);
+	game.RunFrames(C_FRAMES);
+	game.World->SetCpuShadows(false);
+
+	game.World->CreateSpotLights();
+	game.World->SetBakedLighting(true);
+	game.World->AddBenchmarkMovers(200);
+	game.World->SetTreeCulling(true);
+	game.World->SetOcclusionCulling(true);
+	game.World->SetInstanceMode(Scene::InstancesMeshes);
+	game.RunFrames(C_FRAMES);
+	game.World->SetInstanceMode(Scene::InstancesImpostors);
+	game.World->SetPositionStreams(true);
+	game.RunFrames(C_FRAMES);
+
+	CHECK_EQUAL(0, CountErrors(game.Device));
+	CHECK(game.Device.GetStatistics().Draws > 0);
+}
+
+TEST(Scene, ReleasesEverythingItMade)
+{
+	HeadlessRenderDevice device;
+	device.Initialize(NULL);
+	{
+		Scene scene(&device, C_SCREEN_WIDTH);
+		device.BeginFrame();
+		CHECK(device.GetStatistics().Buffers > 0);
+	}
+	device.BeginFrame();
+
+	const RenderDeviceStatistics& statistics = device.GetStatistics();
+	CHECK_EQUAL(0, CountErrors(device));
+	CHECK_EQUAL(0, statistics.Buffers);
+	CHECK_EQUAL(0, statistics.BufferBytes);
+	CHECK_EQUAL(0, statistics.Textures);
+	CHECK_EQUAL(0, statistics.TextureBytes);
+}
+
+// The CPU rasterizer counts the casters it rasterized itself, instead of keeping the last GPU frame's
+TEST(Scene, CpuShadowsReportTheirCasters)
+{
+	HeadlessGame game;
+	game.World->SetCascadeCount(1);
+	game.World->SetCpuShadows(true);
+	game.RunFrames(C_WARMUP_FRAMES);
+
+	const char* label = "Shadow casters (CPU, objects): ";
+	std::string info = game.World->GetInfoString();
+	size_t position = info.find(label);
+	REQUIRE(position != std::string::npos);
+
+	int drawn = 0;
+	int total = 0;
+	CHECK_EQUAL(2, std::sscanf(info.c_str() + position + std::strlen(label), "%d/%d", &drawn, &total));
+	CHECK(drawn > 0);
+	CHECK(drawn <= total);
+	CHECK(info.find("Shadow cache: not used by the CPU rasterizer") != std::string::npos);
+}
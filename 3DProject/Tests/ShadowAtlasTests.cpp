@@ -0,0 +1,265 @@
+#include "Test.h"
+#include "ShadowAtlasAllocator.h"
+#include <vector>
+
+namespace
+{
+	bool Overlap(const ShadowTile& a, const ShadowTile& b)
+	{
+		return a.X < b.X + b.Size && b.X < a.X + a.Size && a.Y < b.Y + b.Size && b.Y < a.Y + a.Size;
+	}
+
+	// Tiles that lie inside the atlas and do not overlap each other
+	bool TilesAreDisjoint(const ShadowAtlasAllocator& allocator, const std::vector<int>& nodes)
+	{
+		for(size_t i = 0; i < nodes.size(); ++i)
+		{
+			ShadowTile tile = allocator.GetTile(nodes[i]);
+			if(tile.X < 0 || tile.Y < 0 || tile.X + tile.Size > allocator.GetAtlasSize() ||
+			   tile.Y + tile.Size > allocator.GetAtlasSize())
+				return false;
+
+			for(size_t j = 0; j < i; ++j)
+			{
+				if(Overlap(tile, allocator.GetTile(nodes[j])))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	ShadowAtlasRequest MakeRequest(float coverage, float priority = 1.0f, bool moved = false)
+	{
+		ShadowAtlasRequest request = { coverage, priority, moved };
+		return request;
+	}
+}
+
+TEST(ShadowAtlas, SplitsIntoFourAndMergesBack)
+{
+	ShadowAtlasAllocator allocator;
+	allocator.Reset(1024, 64);
+
+	std::vector<int> nodes;
+	for(int i = 0; i < 4; ++i)
+	{
+		nodes.push_back(allocator.Allocate(512));
+		REQUIRE(nodes.back() >= 0);
+		CHECK_EQUAL(512, allocator.GetTile(nodes.back()).Size);
+	}
+
+	CHECK(TilesAreDisjoint(allocator, nodes));
+	CHECK_EQUAL(1024 * 1024, allocator.GetUsedTexels());
+
+	for(size_t i = 0; i < nodes.size(); ++i)
+		allocator.Free(nodes[i]);
+	CHECK_EQUAL(0, allocator.GetUsedTexels());
+
+	int whole = allocator.Allocate(1024);
+	REQUIRE(whole >= 0);
+	CHECK_EQUAL(1024, allocator.GetTile(whole).Size);
+}
+
+TEST(ShadowAtlas, SmallestTileMergesBackToTheWholeAtlas)
+{
+	ShadowAtlasAllocator allocator;
+	allocator.Reset(1024, 64);
+
+	int smallest = allocator.Allocate(64);
+	REQUIRE(smallest >= 0);
+	CHECK_EQUAL(64, allocator.GetTile(smallest).Size);
+	CHECK(allocator.Allocate(1024) < 0);
+
+	allocator.Free(smallest);
+	CHECK(allocator.Allocate(1024) >= 0);
+}
+
+TEST(ShadowAtlas, SizesRoundUpToAPowerOfTwo)
+{
+	ShadowAtlasAllocator allocator;
+	allocator.Reset(1024, 64);
+
+	CHECK_EQUAL(64, allocator.GetTile(allocator.Allocate(1)).Size);
+	CHECK_EQUAL(256, allocator.GetTile(allocator.Allocate(200)).Size);
+	CHECK_EQUAL(256, allocator.GetTile(allocator.Allocate(256)).Size);
+}
+
+TEST(ShadowAtlas, AllocationFailsWhenFull)
+{
+	ShadowAtlasAllocator allocator;
+	allocator.Reset(512, 64);
+
+	std::vector<int> nodes;
+	for(int i = 0; i < 64; ++i)
+	{
+		nodes.push_back(allocator.Allocate(64));
+		REQUIRE(nodes.back() >= 0);
+	}
+
+	CHECK(TilesAreDisjoint(allocator, nodes));
+	CHECK(allocator.Allocate(64) < 0);
+	CHECK(allocator.Allocate(128) < 0);
+	CHECK(allocator.Allocate(1024) < 0);
+	CHECK(allocator.Allocate(0) < 0);
+
+	// One free tile is not enough for a larger one, its three siblings are still in use
+	allocator.Free(nodes[0]);
+	CHECK(allocator.Allocate(128) < 0);
+	CHECK(allocator.Allocate(64) >= 0);
+}
+
+TEST(ShadowAtlas, MixedSizesStayDisjoint)
+{
+	ShadowAtlasAllocator allocator;
+	allocator.Reset(2048, 64);
+
+	const int sizes[] = { 512, 64, 128, 64, 256, 1024, 64, 128 };
+	std::vector<int> nodes;
+	int usedTexels = 0;
+	for(int round = 0; round < 50; ++round)
+	{
+		int size = sizes[round % 8];
+		int node = allocator.Allocate(size);
+		if(node >= 0)
+		{
+			nodes.push_back(node);
+			usedTexels += size * size;
+		}
+
+		// Free every third tile, oldest first, so the free lists see merges and splits mixed
+		if(round % 3 == 2 && !nodes.empty())
+		{
+			int size = allocator.GetTile(nodes.front()).Size;
+			usedTexels -= size * size;
+			allocator.Free(nodes.front());
+			nodes.erase(nodes.begin());
+		}
+
+		CHECK(TilesAreDisjoint(allocator, nodes));
+		CHECK_EQUAL(usedTexels, allocator.GetUsedTexels());
+	}
+}
+
+TEST(ShadowAtlas, NeverDrawsMoreThanTheBudget)
+{
+	ShadowAtlasScheduler scheduler;
+	scheduler.Initialize(512, 64, 256, 3);
+
+	std::vector<ShadowAtlasRequest> requests(20, MakeRequest(0.25f));
+	std::vector<int> updates;
+	for(int frame = 0; frame < 20; ++frame)
+	{
+		requests[frame % 20].Moved = true;
+		scheduler.Schedule(requests, updates);
+		requests[frame % 20].Moved = false;
+
+		CHECK(updates.size() <= 3);
+		CHECK_EQUAL((int)updates.size(), scheduler.GetStatistics().Updated);
+		CHECK_EQUAL(20, scheduler.GetStatistics().Tiles);
+	}
+
+	// Seven frames of three are enough to draw every tile once
+	for(int i = 0; i < 20; ++i)
+		CHECK(scheduler.HasTile(i));
+
+	scheduler.SetUpdatesPerFrame(100);
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(20, (int)updates.size());
+}
+
+TEST(ShadowAtlas, NewTilesAreDrawnFirst)
+{
+	ShadowAtlasScheduler scheduler;
+	scheduler.Initialize(512, 64, 256, 1);
+
+	std::vector<ShadowAtlasRequest> requests(1, MakeRequest(1.0f));
+	std::vector<int> updates;
+	scheduler.Schedule(requests, updates);
+	REQUIRE(updates.size() == 1);
+	CHECK_EQUAL(0, updates[0]);
+
+	// The old light moved and has a far higher priority, the new tile still goes first
+	requests[0] = MakeRequest(1.0f, 10.0f, true);
+	requests.push_back(MakeRequest(0.5f));
+	scheduler.Schedule(requests, updates);
+	REQUIRE(updates.size() == 1);
+	CHECK_EQUAL(1, updates[0]);
+	CHECK(!scheduler.HasTile(0) || scheduler.HasTile(1));
+
+	scheduler.Schedule(requests, updates);
+	REQUIRE(updates.size() == 1);
+	CHECK_EQUAL(0, updates[0]);
+}
+
+TEST(ShadowAtlas, TilesShrinkOnlyAtAQuarter)
+{
+	ShadowAtlasScheduler scheduler;
+	scheduler.Initialize(512, 64, 256, 4);
+
+	std::vector<ShadowAtlasRequest> requests(1, MakeRequest(1.0f));
+	std::vector<int> updates;
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(256, scheduler.GetTile(0).Size);
+
+	// Half the size is not enough to give the tile back
+	requests[0] = MakeRequest(0.5f);
+	CHECK_EQUAL(128, scheduler.GetDesiredSize(requests[0]));
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(256, scheduler.GetTile(0).Size);
+	CHECK_EQUAL(0, scheduler.GetStatistics().Reallocated);
+
+	requests[0] = MakeRequest(0.25f);
+	CHECK_EQUAL(64, scheduler.GetDesiredSize(requests[0]));
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(64, scheduler.GetTile(0).Size);
+	CHECK_EQUAL(1, scheduler.GetStatistics().Reallocated);
+
+	// Growing happens at once
+	requests[0] = MakeRequest(0.5f);
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(128, scheduler.GetTile(0).Size);
+	CHECK_EQUAL(1, scheduler.GetStatistics().Reallocated);
+}
+
+TEST(ShadowAtlas, UndersizedTileGrowsWhenThereIsRoom)
+{
+	ShadowAtlasScheduler scheduler;
+	scheduler.Initialize(512, 64, 256, 64);
+
+	// Sixteen tiles of 128 fill the atlas
+	std::vector<ShadowAtlasRequest> requests(16, MakeRequest(0.5f));
+	std::vector<int> updates;
+	scheduler.Schedule(requests, updates);
+	for(int i = 0; i < 16; ++i)
+		REQUIRE(scheduler.GetTile(i).Size == 128);
+
+	// Keep one light in every quadrant, so no quadrant is free for a new light that wants 256
+	int quadrantLight[4] = { -1, -1, -1, -1 };
+	for(int i = 0; i < 16; ++i)
+	{
+		ShadowTile tile = scheduler.GetTile(i);
+		int quadrant = tile.X / 256 + tile.Y / 256 * 2;
+		if(quadrantLight[quadrant] < 0)
+			quadrantLight[quadrant] = i;
+		else
+			requests[i] = MakeRequest(0.0f);
+	}
+
+	requests.push_back(MakeRequest(1.0f));
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(0, scheduler.GetStatistics().Unallocated);
+	CHECK_EQUAL(128, scheduler.GetTile(16).Size);
+
+	// Still no room, the light keeps its tile rather than taking a new one every frame
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(128, scheduler.GetTile(16).Size);
+	CHECK_EQUAL(0, scheduler.GetStatistics().Reallocated);
+
+	// A quadrant other than the light's is emptied, the light moves to the size it wants
+	ShadowTile tile = scheduler.GetTile(16);
+	int lightQuadrant = tile.X / 256 + tile.Y / 256 * 2;
+	requests[quadrantLight[(lightQuadrant + 1) % 4]] = MakeRequest(0.0f);
+	scheduler.Schedule(requests, updates);
+	CHECK_EQUAL(256, scheduler.GetTile(16).Size);
+	CHECK_EQUAL(1, scheduler.GetStatistics().Reallocated);
+}
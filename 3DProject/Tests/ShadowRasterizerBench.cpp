@@ -0,0 +1,103 @@
+#include "Bench.h"
+#include "ShadowRasterizer.h"
+#include "JobSystem.h"
+#include "GameTime.h"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const int C_RUNS = 8;							// Of each size, the best is reported
+	const int C_SIZES[] = { 256, 512, 1024, 2048 };
+	const int C_NUM_SIZES = 4;
+	const int C_QUICK_SIZES = 1;
+	const int C_BOXES = 4000;
+	const int C_QUICK_BOXES = 200;
+	const float C_HALF_VIEW = 50.0f;				// The light's view is 100 units across
+	const float C_MIN_BOX_SIZE = 0.5f;
+	const float C_MAX_BOX_SIZE = 3.0f;
+
+	const int C_BOX_CORNERS[36] =
+	{
+		0, 1, 2, 2, 1, 3,	4, 6, 5, 5, 6, 7,	0, 2, 4, 4, 2, 6,
+		1, 5, 3, 3, 5, 7,	0, 4, 1, 1, 4, 5,	2, 3, 6, 6, 3, 7
+	};
+
+	// A triangle list of boxes spread over the light's view, in world space
+	void MakeCasters(int numBoxes, std::vector<D3DXVECTOR3>& vertices)
+	{
+		for(int box = 0; box < numBoxes; ++box)
+		{
+			D3DXVECTOR3 center((Bench::HashUnit(box * 4) * 2.0f - 1.0f) * C_HALF_VIEW,
+							   (Bench::HashUnit(box * 4 + 1) * 2.0f - 1.0f) * C_HALF_VIEW,
+							   (Bench::HashUnit(box * 4 + 2) * 2.0f - 1.0f) * C_HALF_VIEW);
+			float halfSize = 0.5f * (C_MIN_BOX_SIZE + Bench::HashUnit(box * 4 + 3) * (C_MAX_BOX_SIZE - C_MIN_BOX_SIZE));
+
+			for(int i = 0; i < 36; ++i)
+			{
+				int corner = C_BOX_CORNERS[i];
+				vertices.push_back(center + D3DXVECTOR3(corner & 1 ? halfSize : -halfSize,
+														corner & 2 ? halfSize : -halfSize,
+														corner & 4 ? halfSize : -halfSize));
+			}
+		}
+	}
+}
+
+// Triangles per second of the CPU shadow map rasterizer at 256 to 2048 pixels square, with one worker
+// and with all of them. Setup is the transform and binning on the calling thread.
+BENCH(ShadowRasterizer)
+{
+	int numSizes = options.Quick ? C_QUICK_SIZES : C_NUM_SIZES;
+
+	std::vector<D3DXVECTOR3> vertices;
+	MakeCasters(options.Quick ? C_QUICK_BOXES : C_BOXES, vertices);
+	int numTriangles = (int)vertices.size() / 3;
+
+	// An orthographic light looking along +z that sees every box
+	D3DXMATRIX world;
+	D3DXMatrixIdentity(&world);
+	D3DXMATRIX viewProj(1.0f / C_HALF_VIEW, 0.0f, 0.0f, 0.0f,
+						0.0f, 1.0f / C_HALF_VIEW, 0.0f, 0.0f,
+						0.0f, 0.0f, 0.5f / C_HALF_VIEW, 0.0f,
+						0.0f, 0.0f, 0.5f, 1.0f);
+
+	std::printf("%8s %8s %10s %10s %10s %10s %14s\n", "size", "workers", "triangles", "drawn", "setup ms",
+				"raster ms", "triangles/ms");
+
+	int workerCounts[2] = { 1, options.MaxWorkers };
+	for(int size = 0; size < numSizes; ++size)
+	{
+		ShadowRasterizer rasterizer(C_SIZES[size]);
+
+		for(int w = 0; w < 2; ++w)
+		{
+			JobSystem system(workerCounts[w]);
+			double bestSetup = 1e30;
+			double bestRaster = 1e30;
+			double bestTotal = 1e30;
+
+			for(int run = 0; run < C_RUNS; ++run)
+			{
+				long long start = Clock::GetTicks();
+				rasterizer.BeginFrame(viewProj);
+				rasterizer.AddCaster(&vertices[0], (int)vertices.size(), world);
+				double setup = Bench::GetMilliseconds(start);
+
+				start = Clock::GetTicks();
+				rasterizer.Rasterize(&system);
+				double raster = Bench::GetMilliseconds(start);
+
+				if(setup + raster < bestTotal)
+				{
+					bestSetup = setup;
+					bestRaster = raster;
+					bestTotal = setup + raster;
+				}
+			}
+
+			std::printf("%8d %8d %10d %10d %10.2f %10.2f %14.0f\n", rasterizer.GetSize(), workerCounts[w],
+						numTriangles, rasterizer.GetTriangleCount(), bestSetup, bestRaster, numTriangles / bestTotal);
+		}
+	}
+}
@@ -0,0 +1,257 @@
+#include "Test.h"
+#include "ShadowRasterizer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	const int C_SIZE = 64;
+	const int C_RANDOM_TRIANGLES = 300;
+	const double C_DEPTH_TOLERANCE = 1e-5;
+
+	// The rasterizer state CullFrontBiased of EffectShadows.fx
+	const double C_DEPTH_BIAS = 8.0;
+	const double C_SLOPE_SCALED_DEPTH_BIAS = 2.0;
+	const double C_DEPTH_BIAS_CLAMP = 0.01;
+
+	// A vertex in pixels, y down, and its depth
+	struct ScreenVertex
+	{
+		double					X;
+		double					Y;
+		double					Z;
+	};
+
+	float Random(unsigned int& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// On the half pixel grid, so many edges go exactly through pixel centers
+	ScreenVertex RandomVertex(unsigned int& state)
+	{
+		ScreenVertex vertex;
+		vertex.X = std::floor(Random(state) * (C_SIZE * 2 + 1)) * 0.5;
+		vertex.Y = std::floor(Random(state) * (C_SIZE * 2 + 1)) * 0.5;
+		vertex.Z = 0.1 + Random(state) * 0.8;
+		return vertex;
+	}
+
+	// Signed area, positive for clockwise on the screen since y points down
+	double Orient(const ScreenVertex& a, const ScreenVertex& b, double x, double y)
+	{
+		return (b.X - a.X) * (y - a.Y) - (b.Y - a.Y) * (x - a.X);
+	}
+
+	// Draws one triangle with the rasterizer, the vertices are given in pixels and turned into clip
+	// space for an identity view projection
+	std::vector<float> Rasterize(const ScreenVertex* vertices, int count, JobSystem* jobSystem = NULL)
+	{
+		std::vector<D3DXVECTOR3> clip;
+		for(int i = 0; i < count; ++i)
+		{
+			clip.push_back(D3DXVECTOR3((float)(vertices[i].X / C_SIZE * 2.0 - 1.0),
+									   (float)(1.0 - vertices[i].Y / C_SIZE * 2.0), (float)vertices[i].Z));
+		}
+
+		D3DXMATRIX identity;
+		D3DXMatrixIdentity(&identity);
+
+		ShadowRasterizer rasterizer(C_SIZE);
+		rasterizer.BeginFrame(identity);
+		rasterizer.AddCaster(&clip[0], count, identity);
+		rasterizer.Rasterize(jobSystem);
+
+		const float* depth = rasterizer.GetDepthBuffer();
+		return std::vector<float>(depth, depth + C_SIZE * C_SIZE);
+	}
+
+	// The D3D10 rules written out plainly in doubles: a pixel is drawn if its center is inside the
+	// triangle, or on a top or left edge of it. Front faces, clockwise on the screen, are not drawn.
+	// The depth is interpolated at the center and biased by DepthBias units of the largest depth's
+	// exponent plus the slope scaled part, clamped.
+	std::vector<float> RasterizeReference(const ScreenVertex* v)
+	{
+		std::vector<float> depth(C_SIZE * C_SIZE, 1.0f);
+
+		double area = Orient(v[0], v[1], v[2].X, v[2].Y);
+		if(area >= 0.0)
+			return depth;
+
+		bool ownsEdge[3];
+		for(int i = 0; i < 3; ++i)
+		{
+			const ScreenVertex& a = v[(i + 1) % 3];
+			const ScreenVertex& b = v[(i + 2) % 3];
+			const ScreenVertex& opposite = v[i];
+
+			if(a.Y == b.Y)
+				ownsEdge[i] = opposite.Y > a.Y;			// Top edge
+			else
+			{
+				double edgeX = a.X + (b.X - a.X) * (opposite.Y - a.Y) / (b.Y - a.Y);
+				ownsEdge[i] = opposite.X > edgeX;		// Left edge
+			}
+		}
+
+		// z = dzdx * x + dzdy * y + z0
+		double dzdx = ((v[1].Z - v[0].Z) * (v[2].Y - v[0].Y) - (v[2].Z - v[0].Z) * (v[1].Y - v[0].Y)) / area;
+		double dzdy = ((v[2].Z - v[0].Z) * (v[1].X - v[0].X) - (v[1].Z - v[0].Z) * (v[2].X - v[0].X)) / area;
+
+		double maxZ = std::max(v[0].Z, std::max(v[1].Z, v[2].Z));
+		int exponent = 0;
+		std::frexp(maxZ, &exponent);
+		double bias = C_DEPTH_BIAS * std::ldexp(1.0, exponent - 1 - 23) +
+					  C_SLOPE_SCALED_DEPTH_BIAS * std::max(std::fabs(dzdx), std::fabs(dzdy));
+		bias = std::min(bias, C_DEPTH_BIAS_CLAMP);
+
+		for(int y = 0; y < C_SIZE; ++y)
+		{
+			for(int x = 0; x < C_SIZE; ++x)
+			{
+				double centerX = x + 0.5;
+				double centerY = y + 0.5;
+
+				bool inside = true;
+				for(int i = 0; i < 3 && inside; ++i)
+				{
+					// Negative inside, like the whole triangle's area
+					double side = Orient(v[(i + 1) % 3], v[(i + 2) % 3], centerX, centerY);
+					inside = side < 0.0 || (side == 0.0 && ownsEdge[i]);
+				}
+
+				double z = v[0].Z + dzdx * (centerX - v[0].X) + dzdy * (centerY - v[0].Y) + bias;
+				if(inside && z <= 1.0)
+					depth[y * C_SIZE + x] = (float)z;
+			}
+		}
+
+		return depth;
+	}
+
+	struct Comparison
+	{
+		int						CoverageDifferences;
+		double					LargestDepthError;
+	};
+
+	Comparison Compare(const std::vector<float>& depth, const std::vector<float>& reference)
+	{
+		Comparison comparison = { 0, 0.0 };
+		for(size_t i = 0; i < depth.size(); ++i)
+		{
+			bool drawn = depth[i] < 1.0f;
+			bool drawnByReference = reference[i] < 1.0f;
+			if(drawn != drawnByReference)
+				++comparison.CoverageDifferences;
+			else if(drawn)
+				comparison.LargestDepthError = std::max(comparison.LargestDepthError, std::fabs((double)depth[i] - reference[i]));
+		}
+		return comparison;
+	}
+}
+
+TEST(ShadowRasterizer, MatchesTheReferenceRules)
+{
+	unsigned int seed = 7;
+	JobSystem system(2);
+	int numDrawn = 0;
+
+	for(int i = 0; i < C_RANDOM_TRIANGLES; ++i)
+	{
+		ScreenVertex triangle[3] = { RandomVertex(seed), RandomVertex(seed), RandomVertex(seed) };
+
+		// Every other one is turned into a back face, the others are culled half of the time
+		if(i % 2 == 0 && Orient(triangle[0], triangle[1], triangle[2].X, triangle[2].Y) > 0.0)
+			std::swap(triangle[1], triangle[2]);
+
+		std::vector<float> reference = RasterizeReference(triangle);
+		Comparison comparison = Compare(Rasterize(triangle, 3, i % 3 == 0 ? &system : NULL), reference);
+		CHECK_EQUAL(0, comparison.CoverageDifferences);
+		CHECK(comparison.LargestDepthError < C_DEPTH_TOLERANCE);
+
+		if(Compare(std::vector<float>(reference.size(), 1.0f), reference).CoverageDifferences > 0)
+			++numDrawn;
+	}
+
+	// Enough of them were drawn for the comparison to mean something
+	CHECK(numDrawn > C_RANDOM_TRIANGLES / 3);
+}
+
+// The triangles of a grid whose vertices are all on pixel centers. With the top-left rule every
+// pixel center on a shared edge belongs to exactly one of them.
+TEST(ShadowRasterizer, SharedEdgesDrawEveryPixelOnce)
+{
+	const int cells = 6;
+	const double cellSize = 8.0;
+	const double origin = 4.5;
+
+	std::vector<int> drawCount(C_SIZE * C_SIZE, 0);
+	for(int cy = 0; cy < cells; ++cy)
+	{
+		for(int cx = 0; cx < cells; ++cx)
+		{
+			ScreenVertex topLeft = { origin + cx * cellSize, origin + cy * cellSize, 0.5 };
+			ScreenVertex topRight = { topLeft.X + cellSize, topLeft.Y, 0.5 };
+			ScreenVertex bottomLeft = { topLeft.X, topLeft.Y + cellSize, 0.5 };
+			ScreenVertex bottomRight = { topRight.X, bottomLeft.Y, 0.5 };
+
+			// Counter-clockwise on the screen, so neither is culled. The diagonals alternate.
+			ScreenVertex triangles[6] = { topLeft, bottomLeft, bottomRight, topLeft, bottomRight, topRight };
+			if((cx + cy) % 2 == 1)
+			{
+				ScreenVertex other[6] = { topLeft, bottomLeft, topRight, topRight, bottomLeft, bottomRight };
+				std::copy(other, other + 6, triangles);
+			}
+
+			for(int t = 0; t < 2; ++t)
+			{
+				std::vector<float> depth = Rasterize(&triangles[t * 3], 3);
+				for(size_t i = 0; i < depth.size(); ++i)
+					drawCount[i] += depth[i] < 1.0f ? 1 : 0;
+			}
+		}
+	}
+
+	// The grid's own top and left edges are drawn, its bottom and right edges are not
+	int first = (int)origin;
+	int last = first + (int)(cells * cellSize) - 1;
+	int wrongCount = 0;
+	for(int y = 0; y < C_SIZE; ++y)
+	{
+		for(int x = 0; x < C_SIZE; ++x)
+		{
+			int expected = x >= first && x <= last && y >= first && y <= last ? 1 : 0;
+			wrongCount += drawCount[y * C_SIZE + x] != expected ? 1 : 0;
+		}
+	}
+	CHECK_EQUAL(0, wrongCount);
+}
+
+TEST(ShadowRasterizer, FrontFacesAreCulled)
+{
+	ScreenVertex triangle[3] = { { 10.0, 10.0, 0.5 }, { 50.0, 10.0, 0.5 }, { 10.0, 50.0, 0.5 } };
+	std::vector<float> depth = Rasterize(triangle, 3);
+	CHECK(Compare(depth, std::vector<float>(depth.size(), 1.0f)).CoverageDifferences == 0);
+
+	std::swap(triangle[1], triangle[2]);
+	depth = Rasterize(triangle, 3);
+	CHECK(depth[20 * C_SIZE + 20] < 1.0f);
+}
+
+TEST(ShadowRasterizer, DepthBiasFollowsTheRasterizerState)
+{
+	// A flat triangle only gets the constant bias, 8 units of 2^-24 at a depth in [0.5, 1)
+	ScreenVertex flat[3] = { { 10.0, 10.0, 0.5 }, { 10.0, 50.0, 0.5 }, { 50.0, 10.0, 0.5 } };
+	std::vector<float> depth = Rasterize(flat, 3);
+	CHECK_EQUAL(0.5f + 8.0f / 16777216.0f, depth[20 * C_SIZE + 20]);
+
+	// A steep one is clamped
+	ScreenVertex steep[3] = { { 10.0, 10.0, 0.2 }, { 10.0, 50.0, 0.2 }, { 50.0, 10.0, 0.9 } };
+	depth = Rasterize(steep, 3);
+	double expected = 0.2 + 0.7 * (20.5 - 10.0) / 40.0 + C_DEPTH_BIAS_CLAMP;
+	CHECK(std::fabs(depth[20 * C_SIZE + 20] - expected) < C_DEPTH_TOLERANCE);
+}
@@ -0,0 +1,48 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <sstream>
+#include <string>
+
+// A small test runner for the parts of the project that build without Direct3D. A test is a
+// function registered under a group and a name, the checks in it record failures and go on,
+// REQUIRE returns from the test instead.
+typedef void (*TestFunction)();
+
+namespace Test
+{
+	void Register(const char* group, const char* name, TestFunction function);
+	void Fail(const char* file, int line, const std::string& message);
+	int Run(const char* group);			// Every group when NULL, returns the number of failed tests
+}
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* group, const char* name, TestFunction function)
+	{
+		Test::Register(group, name, function);
+	}
+};
+
+#define TEST(group, name) \
+	static void group##_##name(); \
+	static TestRegistrar group##_##name##_Registrar(#group, #name, group##_##name); \
+	static void group##_##name()
+
+#define CHECK(condition) \
+	do { if(!(condition)) Test::Fail(__FILE__, __LINE__, #condition); } while(0)
+
+#define REQUIRE(condition) \
+	do { if(!(condition)) { Test::Fail(__FILE__, __LINE__, #condition); return; } } while(0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do \
+	{ \
+		if(!((expected) == (actual))) \
+		{ \
+			std::ostringstream checkStream; \
+			checkStream << #actual << " is " << (actual) << ", expected " << (expected); \
+			Test::Fail(__FILE__, __LINE__, checkStream.str()); \
+		} \
+	} while(0)
+#endif
@@ -0,0 +1,74 @@
+#include "Test.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	struct TestEntry
+	{
+		const char*			Group;
+		const char*			Name;
+		TestFunction		Function;
+	};
+
+	// Function statics, so registering from other files' static objects does not depend on the
+	// order they are constructed in
+	std::vector<TestEntry>& GetTests()
+	{
+		static std::vector<TestEntry> tests;
+		return tests;
+	}
+
+	int& GetFailures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+}
+
+void Test::Register(const char* group, const char* name, TestFunction function)
+{
+	TestEntry entry = { group, name, function };
+	GetTests().push_back(entry);
+}
+
+void Test::Fail(const char* file, int line, const std::string& message)
+{
+	std::printf("    %s(%d): %s\n", file, line, message.c_str());
+	++GetFailures();
+}
+
+int Test::Run(const char* group)
+{
+	const std::vector<TestEntry>& tests = GetTests();
+	int numRun = 0;
+	int numFailed = 0;
+
+	for(size_t i = 0; i < tests.size(); ++i)
+	{
+		if(group != NULL && std::strcmp(group, tests[i].Group) != 0)
+			continue;
+
+		std::printf("%s.%s\n", tests[i].Group, tests[i].Name);
+		std::fflush(stdout);
+
+		int failuresBefore = GetFailures();
+		tests[i].Function();
+		++numRun;
+		if(GetFailures() != failuresBefore)
+		{
+			std::printf("  FAILED\n");
+			++numFailed;
+		}
+	}
+
+	std::printf("%d of %d tests passed\n", numRun - numFailed, numRun);
+	return numRun > 0 ? numFailed : 1;
+}
+
+// Tests [group], runs every test without a group
+int main(int argc, char* argv[])
+{
+	return Test::Run(argc > 1 ? argv[1] : NULL) == 0 ? 0 : 1;
+}
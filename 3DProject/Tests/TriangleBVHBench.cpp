@@ -0,0 +1,172 @@
+#include "Bench.h"
+#include "TriangleBVH.h"
+#include "JobSystem.h"
+#include "GameTime.h"
+#include "Threading.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const int C_RUNS = 3;							// The best of these is reported
+#if defined(_M_X64) || defined(__x86_64__)
+	const int C_BUILD_TRIANGLES[] = { 10000, 100000, 1000000, 10000000 };
+#else
+	const int C_BUILD_TRIANGLES[] = { 10000, 100000, 1000000 };		// 10M does not fit in 32 bits
+#endif
+	const int C_NUM_BUILD_SIZES = sizeof(C_BUILD_TRIANGLES) / sizeof(C_BUILD_TRIANGLES[0]);
+	const float C_HEIGHT_FIELD_SPACING = 0.5f;
+	const int C_RAYS = 1000000;
+	const int C_QUICK_RAYS = 10000;
+	const int C_RAY_GRAIN_SIZE = 4096;
+	const float C_RAY_ORIGIN_SCALE = 1.5f;			// Ray origins lie on a sphere this much larger than the object
+
+	// Two triangles per cell of a rolling height field with some noise
+	void MakeHeightField(int numTriangles, std::vector<D3DXVECTOR3>& vertices)
+	{
+		int side = (int)std::sqrt(numTriangles * 0.5);
+		std::vector<D3DXVECTOR3> heights((side + 1) * (side + 1));
+		for(int z = 0; z <= side; ++z)
+		{
+			for(int x = 0; x <= side; ++x)
+			{
+				float height = std::sin(x * 0.05f) * std::cos(z * 0.05f) * 8.0f + Bench::HashUnit(z * (side + 1) + x);
+				heights[z * (side + 1) + x] = D3DXVECTOR3(x * C_HEIGHT_FIELD_SPACING, height, z * C_HEIGHT_FIELD_SPACING);
+			}
+		}
+
+		vertices.clear();
+		vertices.reserve(side * side * 6);
+		for(int z = 0; z < side; ++z)
+		{
+			for(int x = 0; x < side; ++x)
+			{
+				int corner = z * (side + 1) + x;
+				vertices.push_back(heights[corner]);
+				vertices.push_back(heights[corner + side + 1]);
+				vertices.push_back(heights[corner + 1]);
+				vertices.push_back(heights[corner + 1]);
+				vertices.push_back(heights[corner + side + 1]);
+				vertices.push_back(heights[corner + side + 2]);
+			}
+		}
+	}
+
+	struct RayData
+	{
+		const TriangleBVH*		BVH;
+		volatile long			NumHits;
+	};
+
+	// From a point on a sphere around the object towards a point inside its box
+	void RaysJob(void* data, int first, int count)
+	{
+		RayData* rays = static_cast<RayData*>(data);
+		D3DXVECTOR3 center = rays->BVH->GetBounds().GetCenter();
+		D3DXVECTOR3 extents = rays->BVH->GetBounds().GetExtents();
+		float radius = D3DXVec3Length(&extents) * C_RAY_ORIGIN_SCALE;
+
+		int numHits = 0;
+		for(int i = first; i < first + count; ++i)
+		{
+			unsigned int seed = (unsigned int)i * 6;
+			D3DXVECTOR3 onSphere(Bench::HashUnit(seed) - 0.5f, Bench::HashUnit(seed + 1) - 0.5f,
+								 Bench::HashUnit(seed + 2) - 0.5f);
+			if(D3DXVec3LengthSq(&onSphere) < 1e-6f)
+				onSphere = D3DXVECTOR3(1.0f, 0.0f, 0.0f);
+			D3DXVec3Normalize(&onSphere, &onSphere);
+
+			D3DXVECTOR3 origin = center + onSphere * radius;
+			D3DXVECTOR3 target(center.x + (Bench::HashUnit(seed + 3) * 2.0f - 1.0f) * extents.x,
+							   center.y + (Bench::HashUnit(seed + 4) * 2.0f - 1.0f) * extents.y,
+							   center.z + (Bench::HashUnit(seed + 5) * 2.0f - 1.0f) * extents.z);
+
+			RayHit hit;
+			if(rays->BVH->RayCast(origin, target - origin, FLT_MAX, hit))
+				++numHits;
+		}
+
+		Atomic::Add(&rays->NumHits, numHits);
+	}
+}
+
+// Build time of trees over height fields from 10k triangles up for every worker count
+BENCH(TriangleBVHBuild)
+{
+	int numSizes = options.Quick ? 1 : C_NUM_BUILD_SIZES;
+
+	std::printf("%10s %8s %8s %10s %14s %10s\n", "triangles", "workers", "nodes", "ms", "triangles/ms", "speedup");
+
+	std::vector<D3DXVECTOR3> vertices;
+	for(int size = 0; size < numSizes; ++size)
+	{
+		MakeHeightField(C_BUILD_TRIANGLES[size], vertices);
+		int numTriangles = (int)vertices.size() / 3;
+
+		double singleWorker = 0.0;
+		for(int workers = 1; workers <= options.MaxWorkers; ++workers)
+		{
+			JobSystem system(workers);
+			TriangleBVH bvh;
+
+			double best = 1e30;
+			for(int run = 0; run < C_RUNS; ++run)
+			{
+				bvh.Build(&vertices[0], numTriangles, &system);
+				if(bvh.GetBuildMilliseconds() < best)
+					best = bvh.GetBuildMilliseconds();
+			}
+
+			if(workers == 1)
+				singleWorker = best;
+
+			std::printf("%10d %8d %8d %10.2f %14.0f %9.2fx\n", numTriangles, workers, bvh.GetNodeCount(), best,
+						numTriangles / best, singleWorker / best);
+		}
+	}
+}
+
+// Closest hits per second against the tree of bth.obj for every worker count. Every worker count casts
+// the same rays, every row shows whether it found the one worker's number of hits.
+BENCH(TriangleBVHRays)
+{
+	const TriangleBVH* bvh = Bench::GetObjectBVH();
+	if(bvh == NULL)
+		return;
+
+	int numRays = options.Quick ? C_QUICK_RAYS : C_RAYS;
+	std::printf("%d triangles, %d nodes\n", bvh->GetTriangleCount(), bvh->GetNodeCount());
+	std::printf("%8s %8s %10s %10s %10s %10s %6s\n", "rays", "workers", "hits", "ms", "Mrays/s", "speedup", "same");
+
+	double singleWorker = 0.0;
+	long singleWorkerHits = 0;
+	for(int workers = 1; workers <= options.MaxWorkers; ++workers)
+	{
+		JobSystem system(workers);
+		RayData rays = { bvh, 0 };
+
+		double best = 1e30;
+		for(int run = 0; run < C_RUNS; ++run)
+		{
+			rays.NumHits = 0;
+			long long start = Clock::GetTicks();
+			JobCounter raysDone;
+			system.ParallelFor(RaysJob, &rays, numRays, C_RAY_GRAIN_SIZE, &raysDone);
+			system.Wait(&raysDone);
+			double milliseconds = Bench::GetMilliseconds(start);
+			if(milliseconds < best)
+				best = milliseconds;
+		}
+
+		if(workers == 1)
+		{
+			singleWorker = best;
+			singleWorkerHits = rays.NumHits;
+		}
+
+		std::printf("%8d %8d %10ld %10.2f %10.2f %9.2fx %6s\n", numRays, workers, (long)rays.NumHits, best,
+					numRays / (best * 1000.0), singleWorker / best, rays.NumHits == singleWorkerHits ? "yes" : "NO");
+	}
+}
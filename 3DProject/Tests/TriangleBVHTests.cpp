@@ -0,0 +1,206 @@
+#include "Test.h"
+#include "TriangleBVH.h"
+#include "JobSystem.h"
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	const int C_SOUP_TRIANGLES = 3000;
+	const int C_LARGE_SOUP_TRIANGLES = 20000;		// Above the size that is split and built in parallel
+	const int C_SAME_CENTROID_TRIANGLES = 500;
+	const int C_WORKERS = 3;
+	const int C_CENTROID_RAYS = 500;
+	const int C_RANDOM_RAYS = 1000;
+	const float C_WORLD_SIZE = 50.0f;
+	const float C_EDGE_MARGIN = 1e-4f;				// Rays this close to an edge may go either way
+	const float C_DISTANCE_TOLERANCE = 1e-3f;
+
+	float Random(unsigned int& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	D3DXVECTOR3 RandomPoint(unsigned int& state, float halfSize)
+	{
+		float x = (Random(state) * 2.0f - 1.0f) * halfSize;
+		float y = (Random(state) * 2.0f - 1.0f) * halfSize;
+		float z = (Random(state) * 2.0f - 1.0f) * halfSize;
+		return D3DXVECTOR3(x, y, z);
+	}
+
+	// A triangle with its centroid at center, turned at random and of a random size
+	void AddTriangle(std::vector<D3DXVECTOR3>& vertices, const D3DXVECTOR3& center, float size, unsigned int& state)
+	{
+		D3DXVECTOR3 a = RandomPoint(state, size);
+		D3DXVECTOR3 b = RandomPoint(state, size);
+		D3DXVECTOR3 c = -a - b;
+		vertices.push_back(center + a);
+		vertices.push_back(center + b);
+		vertices.push_back(center + c);
+	}
+
+	void MakeSoup(std::vector<D3DXVECTOR3>& vertices, int numTriangles, unsigned int seed)
+	{
+		unsigned int state = seed;
+		for(int i = 0; i < numTriangles; ++i)
+			AddTriangle(vertices, RandomPoint(state, C_WORLD_SIZE), 0.5f + Random(state) * 2.0f, state);
+	}
+
+	// Moller-Trumbore against every triangle, with the triangles grown by margin along their edges. A
+	// negative margin shrinks them. Returns the closest distance below maxDistance, or FLT_MAX.
+	float BruteForceRayCast(const std::vector<D3DXVECTOR3>& vertices, const D3DXVECTOR3& origin,
+							const D3DXVECTOR3& direction, float maxDistance, float margin)
+	{
+		float closest = FLT_MAX;
+		for(size_t i = 0; i < vertices.size(); i += 3)
+		{
+			D3DXVECTOR3 edge1 = vertices[i + 1] - vertices[i];
+			D3DXVECTOR3 edge2 = vertices[i + 2] - vertices[i];
+			D3DXVECTOR3 p;
+			D3DXVec3Cross(&p, &direction, &edge2);
+			float determinant = D3DXVec3Dot(&edge1, &p);
+			if(std::fabs(determinant) <= 1e-12f)
+				continue;
+
+			float inverse = 1.0f / determinant;
+			D3DXVECTOR3 t = origin - vertices[i];
+			float u = D3DXVec3Dot(&t, &p) * inverse;
+			D3DXVECTOR3 q;
+			D3DXVec3Cross(&q, &t, &edge1);
+			float v = D3DXVec3Dot(&direction, &q) * inverse;
+			float distance = D3DXVec3Dot(&edge2, &q) * inverse;
+			if(u < -margin || v < -margin || u + v > 1.0f + margin || distance < 0.0f || distance >= maxDistance)
+				continue;
+
+			if(distance < closest)
+				closest = distance;
+		}
+		return closest;
+	}
+
+	// The tree agrees with the brute force loop on a ray unless the ray passes within the margin of an
+	// edge, in which case either answer is right
+	int CheckRay(const TriangleBVH& bvh, const std::vector<D3DXVECTOR3>& vertices, const D3DXVECTOR3& origin,
+				 const D3DXVECTOR3& direction, float maxDistance)
+	{
+		float inside = BruteForceRayCast(vertices, origin, direction, maxDistance, -C_EDGE_MARGIN);
+		float onEdge = BruteForceRayCast(vertices, origin, direction, maxDistance, C_EDGE_MARGIN);
+
+		RayHit hit;
+		bool hasHit = bvh.RayCast(origin, direction, maxDistance, hit);
+		bool occluded = bvh.IsOccluded(origin, direction, maxDistance);
+
+		int numErrors = 0;
+		if(inside < FLT_MAX)
+		{
+			numErrors += hasHit && hit.Distance <= inside + C_DISTANCE_TOLERANCE ? 0 : 1;
+			numErrors += occluded ? 0 : 1;
+		}
+		if(onEdge == FLT_MAX)
+		{
+			numErrors += hasHit ? 1 : 0;
+			numErrors += occluded ? 1 : 0;
+		}
+		if(hasHit)
+		{
+			numErrors += hit.Distance >= onEdge - C_DISTANCE_TOLERANCE ? 0 : 1;
+			numErrors += hit.Triangle >= 0 && hit.Triangle < (int)vertices.size() / 3 ? 0 : 1;
+			numErrors += hit.U >= -C_EDGE_MARGIN && hit.V >= -C_EDGE_MARGIN && hit.U + hit.V <= 1.0f + C_EDGE_MARGIN
+						 ? 0 : 1;
+			numErrors += hit.Distance < maxDistance ? 0 : 1;
+		}
+		return numErrors;
+	}
+
+	// Rays from outside at the centroids of spread out triangles, which always hit something, and random
+	// rays through the box with random lengths, which often do not
+	int CheckRays(const TriangleBVH& bvh, const std::vector<D3DXVECTOR3>& vertices, unsigned int seed)
+	{
+		unsigned int state = seed;
+		int numErrors = 0;
+		size_t step = 3 * (vertices.size() / 3 / C_CENTROID_RAYS + 1);
+		for(size_t i = 0; i < vertices.size(); i += step)
+		{
+			D3DXVECTOR3 centroid = (vertices[i] + vertices[i + 1] + vertices[i + 2]) / 3.0f;
+			D3DXVECTOR3 origin = RandomPoint(state, C_WORLD_SIZE * 2.0f);
+			numErrors += CheckRay(bvh, vertices, origin, (centroid - origin) * 1.5f, FLT_MAX);
+		}
+
+		for(int i = 0; i < C_RANDOM_RAYS; ++i)
+		{
+			D3DXVECTOR3 origin = RandomPoint(state, C_WORLD_SIZE * 1.5f);
+			D3DXVECTOR3 target = RandomPoint(state, C_WORLD_SIZE);
+			numErrors += CheckRay(bvh, vertices, origin, target - origin, Random(state) * 2.0f);
+		}
+		return numErrors;
+	}
+}
+
+TEST(TriangleBVH, MatchesBruteForce)
+{
+	std::vector<D3DXVECTOR3> vertices;
+	MakeSoup(vertices, C_SOUP_TRIANGLES, 1u);
+
+	TriangleBVH bvh;
+	bvh.Build(&vertices[0], C_SOUP_TRIANGLES, NULL);
+	CHECK_EQUAL(C_SOUP_TRIANGLES, bvh.GetTriangleCount());
+	CHECK(bvh.GetNodeCount() > 1);
+	CHECK_EQUAL(0, CheckRays(bvh, vertices, 2u));
+}
+
+TEST(TriangleBVH, ParallelBuildMatchesBruteForce)
+{
+	std::vector<D3DXVECTOR3> vertices;
+	MakeSoup(vertices, C_LARGE_SOUP_TRIANGLES, 3u);
+
+	JobSystem system(C_WORKERS);
+	TriangleBVH bvh;
+	bvh.Build(&vertices[0], C_LARGE_SOUP_TRIANGLES, &system);
+	CHECK_EQUAL(C_LARGE_SOUP_TRIANGLES, bvh.GetTriangleCount());
+	CHECK_EQUAL(0, CheckRays(bvh, vertices, 4u));
+}
+
+// Triangles that all share one centroid can not be told apart by the bins, so every split of them is
+// a median split
+TEST(TriangleBVH, IdenticalCentroidsMatchBruteForce)
+{
+	unsigned int state = 5u;
+	std::vector<D3DXVECTOR3> vertices;
+	for(int i = 0; i < C_SAME_CENTROID_TRIANGLES; ++i)
+		AddTriangle(vertices, D3DXVECTOR3(1.0f, 2.0f, 3.0f), 1.0f + Random(state) * C_WORLD_SIZE, state);
+
+	TriangleBVH bvh;
+	bvh.Build(&vertices[0], C_SAME_CENTROID_TRIANGLES, NULL);
+	CHECK_EQUAL(0, CheckRays(bvh, vertices, 6u));
+}
+
+// Clusters of triangles on one centroid mixed with spread out ones and exact copies, large enough to
+// take the parallel build
+TEST(TriangleBVH, ClusteredCentroidsMatchBruteForce)
+{
+	unsigned int state = 7u;
+	std::vector<D3DXVECTOR3> vertices;
+	MakeSoup(vertices, C_LARGE_SOUP_TRIANGLES / 2, 8u);
+	for(int cluster = 0; cluster < 20; ++cluster)
+	{
+		D3DXVECTOR3 center = RandomPoint(state, C_WORLD_SIZE);
+		for(int i = 0; i < C_LARGE_SOUP_TRIANGLES / 40; ++i)
+			AddTriangle(vertices, center, 0.5f + Random(state) * 5.0f, state);
+	}
+	for(int i = 0; i < 200; ++i)
+	{
+		vertices.push_back(vertices[0]);
+		vertices.push_back(vertices[1]);
+		vertices.push_back(vertices[2]);
+	}
+	int numTriangles = (int)vertices.size() / 3;
+
+	JobSystem system(C_WORKERS);
+	TriangleBVH bvh;
+	bvh.Build(&vertices[0], numTriangles, &system);
+	CHECK_EQUAL(numTriangles, bvh.GetTriangleCount());
+	CHECK_EQUAL(0, CheckRays(bvh, vertices, 9u));
+}